@@ -24,6 +24,7 @@ DEFINES -= UNICODE
 DEFINES += __STDC_LIMIT_MACROS
 DEFINES += BUILT_IN_PLUGINS=1
 DEFINES += INCLUDESCRIPTING
+DEFINES += PERFSTATS_ENABLED=1
 
 QMAKE_CXXFLAGS += -Wall
 QMAKE_CFLAGS += -Wall
@@ -77,6 +78,7 @@ SOURCES += ../src/UI/QT/main.cpp\
     ../src/App/StdPlugins/IODrivers/TCPServer/src/TCPServer_Main.cpp \
     ../src/App/StdPlugins/IODrivers/UDPClient/src/UDPClient_Main.cpp \
     ../src/App/StdPlugins/IODrivers/UDPServer/src/UDPServer_Main.cpp \
+    ../src/App/StdPlugins/IODrivers/CaptureReplay/src/CaptureReplay_Main.cpp \
     ../src/UI/QT/ContextMenuHelper.cpp \
     ../src/UI/QT/Form_CRCFinder.cpp \
     ../src/UI/QT/Form_CRCFinderAccess.cpp \
@@ -118,6 +120,8 @@ SOURCES += ../src/UI/QT/main.cpp\
     ../src/UI/QT/Widget_MainTextArea_LineInput.cpp \
     ../src/UI/QT/Widget_MovableTabWidget.cpp \
     ../src/App/MainApp.cpp \
+    ../src/App/PerfStats.cpp \
+    ../src/App/TimerWheel.cpp \
     ../src/UI/QT/Form_MainWindowAccess.cpp \
     ../src/App/MainWindow.cpp \
     ../src/UI/QT/AskMessageBox.cpp \
@@ -152,6 +156,8 @@ SOURCES += ../src/UI/QT/main.cpp\
     ../src/App/StdPlugins/DataProcessors/TermEmulation/BasicCtrlCharsDecoder.cpp \
     ../src/App/StdPlugins/DataProcessors/CharEncoding/CodePage437Decoder.cpp \
     ../src/App/StdPlugins/DataProcessors/CharEncoding/UnicodeDecoder.cpp \
+    ../src/App/StdPlugins/DataProcessors/Highlighter/HighlightDFA.cpp \
+    ../src/App/StdPlugins/DataProcessors/Highlighter/RuleHighlighter.cpp \
     ../src/UI/QT/FileRequesters.cpp \
     ../src/UI/QT/Form_DebugStats.cpp \
     ../src/UI/QT/ColorRequesters.cpp \
@@ -181,6 +187,8 @@ SOURCES += ../src/UI/QT/main.cpp\
     ../src/App/FileTransferProtocolSystem.cpp \
     ../src/App/MWPanels/MW_Upload.cpp \
     ../src/App/StdPlugins/FileTransfersProtocols/XModem/XModem.cpp \
+    ../src/App/StdPlugins/FileTransfersProtocols/YModem/YModem.cpp \
+    ../src/App/StdPlugins/FileTransfersProtocols/ZModem/ZModem.cpp \
     ../src/App/MWPanels/MW_Download.cpp \
     ../src/App/Display/HexDisplayBuffers.cpp \
     ../src/App/MWPanels/MW_HexDisplay.cpp \
@@ -238,6 +246,12 @@ SOURCES += ../src/UI/QT/main.cpp\
     ../src/UI/QT/Widget_TextCanvas.cpp \
     ../src/UI/QT/Frame_MainTextAreaAccess.cpp \
     ../src/App/Util/TextStyleHelpers.cpp \
+    ../src/App/Util/PieceTable.cpp \
+    ../src/App/Util/UnicodeWidth.cpp \
+    ../src/App/Util/CaptureFile.cpp \
+    ../src/App/Util/ComTestFrames.cpp \
+    ../src/App/Util/TxPacer.cpp \
+    ../src/App/Util/ByteSearch.cpp \
 
 win32 {
 # Windows
@@ -252,6 +266,7 @@ win32 {
     ../src/OS/Windows/OSTime.cpp \
     ../src/OS/Windows/System.cpp \
     ../src/OS/Windows/Thread.cpp \
+    ../src/OS/Windows/MappedFile.cpp \
     ../src/OS/Windows/Sockets.cpp \
     ../src/App/StdPlugins/IODrivers/Comport/OS/Win/Comport_OS_Serial.cpp \
     ../src/App/StdPlugins/IODrivers/TCPClient/src/OS/Win/TCPClient_OS_Socket.cpp \
@@ -302,6 +317,7 @@ linux {
     }
 
     SOURCES += \
+        ../src/OS/Linux/MappedFile.cpp \
         ../src/App/StdPlugins/IODrivers/Comport/OS/Linux/Comport_OS_Serial.cpp \
         ../src/App/StdPlugins/IODrivers/TCPClient/src/OS/Linux/TCPClient_OS_Socket.cpp \
         ../src/App/StdPlugins/IODrivers/TCPServer/src/OS/Linux/TCPServer_OS_Socket.cpp \
@@ -0,0 +1,374 @@
+/*******************************************************************************
+ * FILENAME: ByteSearchBench_Main.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This times the hex display byte search (App/Util/ByteSearch.cpp) on a
+ *    big circular buffer and checks it finds the same thing as a simple
+ *    byte at a time search.  The data starts in the middle of the memory
+ *    so every search has to go over the wrap, and the match is planted
+ *    across the wrap for one of the runs.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/Util/ByteSearch.h"
+#include "OS/OSTime.h"
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define DEFAULT_BYTES                   (8*1024*1024)
+#define DEFAULT_FUZZ_RUNS               200000
+#define TIMED_RUNS                      10
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+static int64_t SlowFindInRing(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Ring,size_t RingSize,size_t DataStart,size_t DataBytes,
+        size_t From);
+static bool TimeSearch(const char *UserPattern,vector<uint8_t> &Ring,
+        bool PlantOnWrap);
+static bool Fuzz(unsigned int Runs);
+static void Usage(void);
+
+/*** VARIABLE DEFINITIONS     ***/
+static const char *m_DefaultPatterns[]=
+{
+    "DE AD BE EF",
+    "DE ?? BE EF",
+    "FE",
+    "AA ?? 55",
+    "\"Hello World\"",
+    "u\"Hello World\"",
+    "ube\"Hello\"",
+    "01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F 10",
+};
+
+int main(int argc,char *argv[])
+{
+    vector<uint8_t> Ring;
+    size_t Bytes;
+    unsigned int FuzzRuns;
+    bool RanOne;
+    int arg;
+    unsigned int r;
+
+    Bytes=DEFAULT_BYTES;
+    FuzzRuns=DEFAULT_FUZZ_RUNS;
+    RanOne=false;
+
+    for(arg=1;arg<argc;arg++)
+    {
+        if(strcmp(argv[arg],"-s")==0 && arg+1<argc)
+        {
+            Bytes=strtoul(argv[++arg],NULL,0);
+            if(Bytes<1024)
+                Bytes=1024;
+        }
+        else if(strcmp(argv[arg],"-z")==0 && arg+1<argc)
+        {
+            FuzzRuns=strtoul(argv[++arg],NULL,0);
+        }
+        else if(strcmp(argv[arg],"-h")==0 || strcmp(argv[arg],"--help")==0)
+        {
+            Usage();
+            return 0;
+        }
+        else
+        {
+            if(Ring.size()!=Bytes)
+                Ring.resize(Bytes);
+            if(!TimeSearch(argv[arg],Ring,false))
+                return 1;
+            RanOne=true;
+        }
+    }
+
+    if(!Fuzz(FuzzRuns))
+        return 1;
+
+    if(!RanOne)
+    {
+        Ring.resize(Bytes);
+        for(r=0;r<sizeof(m_DefaultPatterns)/sizeof(m_DefaultPatterns[0]);r++)
+        {
+            if(!TimeSearch(m_DefaultPatterns[r],Ring,false))
+                return 1;
+            if(!TimeSearch(m_DefaultPatterns[r],Ring,true))
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void Usage(void)
+{
+    printf("USAGE:\n");
+    printf("    ByteSearchBench [-s bytes] [-z fuzz runs] [pattern...]\n");
+    printf("\n");
+    printf("    -s -- The size of the buffer to search (default %d)\n",
+            DEFAULT_BYTES);
+    printf("    -z -- How many small random rings to check against a simple "
+            "search (default %d)\n",DEFAULT_FUZZ_RUNS);
+    printf("\n");
+    printf("Patterns are hex (AA ?? 55), \"text\", u\"UTF-16LE\" or "
+            "ube\"UTF-16BE\"\n");
+}
+
+/*******************************************************************************
+ * NAME:
+ *    SlowFindInRing
+ *
+ * SYNOPSIS:
+ *    static int64_t SlowFindInRing(const struct ByteSearchPattern *Pattern,
+ *              const uint8_t *Ring,size_t RingSize,size_t DataStart,
+ *              size_t DataBytes,size_t From);
+ *
+ * PARAMETERS:
+ *    Same as ByteSearch_FindNextInRing()
+ *
+ * FUNCTION:
+ *    This function is a byte at a time version of
+ *    ByteSearch_FindNextInRing() to check it against.
+ *
+ * RETURNS:
+ *    The offset of the match or -1 if there wasn't one.
+ *
+ * SEE ALSO:
+ *    ByteSearch_FindNextInRing()
+ ******************************************************************************/
+static int64_t SlowFindInRing(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Ring,size_t RingSize,size_t DataStart,size_t DataBytes,
+        size_t From)
+{
+    size_t Start;
+    size_t Tries;
+    size_t p;
+    int r;
+
+    if(From>=DataBytes)
+        From=0;
+
+    for(Tries=0;Tries<DataBytes;Tries++)
+    {
+        Start=(From+Tries)%DataBytes;
+        if(Start+Pattern->Len>DataBytes)
+            continue;
+        for(r=0;r<Pattern->Len;r++)
+        {
+            p=(DataStart+Start+r)%RingSize;
+            if(((Ring[p]^Pattern->Bytes[r])&Pattern->Mask[r])!=0)
+                break;
+        }
+        if(r==Pattern->Len)
+            return Start;
+    }
+    return -1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimeSearch
+ *
+ * SYNOPSIS:
+ *    static bool TimeSearch(const char *UserPattern,vector<uint8_t> &Ring,
+ *              bool PlantOnWrap);
+ *
+ * PARAMETERS:
+ *    UserPattern [I] -- The pattern (as the user would type it)
+ *    Ring [I/O] -- The buffer to search.  This is filled with random bytes
+ *                  and the pattern is planted in it.
+ *    PlantOnWrap [I] -- Put the match across the end of the memory (true)
+ *                       or near the end of the data (false)
+ *
+ * FUNCTION:
+ *    This function times a find next from the start of the data to the
+ *    planted match (so nearly the whole buffer is searched) and checks it
+ *    against SlowFindInRing().
+ *
+ * RETURNS:
+ *    true -- The search found the right place
+ *    false -- The pattern was bad or the search got it wrong
+ *
+ * SEE ALSO:
+ *    SlowFindInRing()
+ ******************************************************************************/
+static bool TimeSearch(const char *UserPattern,vector<uint8_t> &Ring,
+        bool PlantOnWrap)
+{
+    struct ByteSearchPattern Pattern;
+    size_t DataStart;
+    size_t DataBytes;
+    size_t Plant;
+    size_t r;
+    int64_t Match;
+    int64_t SlowMatch;
+    uint64_t StartTime;
+    uint64_t Best_ns;
+    uint64_t ns;
+    int Run;
+
+    if(!ByteSearch_ParseUserPattern(UserPattern,&Pattern))
+    {
+        fprintf(stderr,"Bad pattern %s\n",UserPattern);
+        return false;
+    }
+
+    /* Random data but with only 0x00-0x7F so the pattern doesn't show up
+       by chance (most of the patterns have a byte >=0x80 or are text) */
+    srand(1234);
+    for(r=0;r<Ring.size();r++)
+        Ring[r]=rand()&0x7F;
+
+    /* The data starts in the middle of the memory and wraps */
+    DataStart=Ring.size()/2+3;
+    DataBytes=Ring.size();
+
+    if(PlantOnWrap)
+        Plant=(Ring.size()-DataStart)-Pattern.Len/2;
+    else
+        Plant=DataBytes-Pattern.Len-17;
+    for(r=0;r<(size_t)Pattern.Len;r++)
+    {
+        Ring[(DataStart+Plant+r)%Ring.size()]=(Pattern.Bytes[r]&
+                Pattern.Mask[r])|(0x5A&~Pattern.Mask[r]);
+    }
+
+    Best_ns=~0ULL;
+    Match=-1;
+    for(Run=0;Run<TIMED_RUNS;Run++)
+    {
+        StartTime=GetElapsedTime_ns();
+        Match=ByteSearch_FindNextInRing(&Pattern,Ring.data(),Ring.size(),
+                DataStart,DataBytes,0);
+        ns=GetElapsedTime_ns()-StartTime;
+        if(ns<Best_ns)
+            Best_ns=ns;
+    }
+
+    SlowMatch=SlowFindInRing(&Pattern,Ring.data(),Ring.size(),DataStart,
+            DataBytes,0);
+
+    printf("%-52s %-5s %-4s %8.3f ms %9.1f MB/s  found %lld%s\n",UserPattern,
+            PlantOnWrap?"wrap":"end",Pattern.UseBMH?"BMH":"mchr",
+            Best_ns/1000000.0,(Match+Pattern.Len)/(1024.0*1024.0)/
+            (Best_ns/1e9),(long long)Match,
+            Match==SlowMatch?"":"  WRONG");
+
+    if(Match!=SlowMatch)
+    {
+        fprintf(stderr,"Expected %lld\n",(long long)SlowMatch);
+        return false;
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Fuzz
+ *
+ * SYNOPSIS:
+ *    static bool Fuzz(unsigned int Runs);
+ *
+ * PARAMETERS:
+ *    Runs [I] -- How many random rings to try
+ *
+ * FUNCTION:
+ *    This function makes lots of small random rings (random size, data
+ *    start, fill, pattern and wild cards) with only a few different byte
+ *    values so there are lots of near matches, and checks
+ *    ByteSearch_FindNextInRing() against SlowFindInRing().
+ *
+ * RETURNS:
+ *    true -- Everything matched
+ *    false -- A search got it wrong (the details are printed)
+ *
+ * SEE ALSO:
+ *    SlowFindInRing()
+ ******************************************************************************/
+static bool Fuzz(unsigned int Runs)
+{
+    struct ByteSearchPattern Pattern;
+    uint8_t Ring[64];
+    char Str[BYTESEARCH_MAX_PATTERN*3+1];
+    size_t RingSize;
+    size_t DataStart;
+    size_t DataBytes;
+    size_t From;
+    int64_t Match;
+    int64_t SlowMatch;
+    unsigned int Run;
+    int Len;
+    int r;
+
+    srand(4321);
+    for(Run=0;Run<Runs;Run++)
+    {
+        RingSize=1+rand()%sizeof(Ring);
+        DataStart=rand()%RingSize;
+        DataBytes=rand()%(RingSize+1);
+        From=DataBytes>0?rand()%DataBytes:0;
+        for(r=0;r<(int)RingSize;r++)
+            Ring[r]=rand()%3;
+
+        Len=1+rand()%8;
+        Str[0]=0;
+        for(r=0;r<Len;r++)
+        {
+            if(rand()%4==0)
+                strcat(Str,"?? ");
+            else
+                sprintf(&Str[strlen(Str)],"%02X ",rand()%3);
+        }
+        if(!ByteSearch_ParsePattern(Str,e_ByteSearchPattern_Hex,&Pattern))
+        {
+            fprintf(stderr,"Bad fuzz pattern %s\n",Str);
+            return false;
+        }
+
+        Match=ByteSearch_FindNextInRing(&Pattern,Ring,RingSize,DataStart,
+                DataBytes,From);
+        SlowMatch=SlowFindInRing(&Pattern,Ring,RingSize,DataStart,DataBytes,
+                From);
+        if(Match!=SlowMatch)
+        {
+            fprintf(stderr,"Fuzz run %u: pattern %s ring %zu start %zu "
+                    "bytes %zu from %zu: got %lld expected %lld\n",Run,Str,
+                    RingSize,DataStart,DataBytes,From,(long long)Match,
+                    (long long)SlowMatch);
+            return false;
+        }
+    }
+    printf("Fuzz: %u random rings matched the simple search\n",Runs);
+    return true;
+}
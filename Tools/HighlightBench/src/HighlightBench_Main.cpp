@@ -0,0 +1,703 @@
+/*******************************************************************************
+ * FILENAME: HighlightBench_Main.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This checks the compiled highlighter DFA (the one the Rule Highlighter
+ *    data processor uses) against std::regex and times them both.
+ *
+ *    A set of rules (keywords, regex's, and the same presets the Rule
+ *    Highlighter has) are compiled into one DFA.  The same rules are also
+ *    built as std::regex's using the POSIX extended grammar, which gives the
+ *    leftmost longest match like the DFA.  Random text made from bits that
+ *    look like the rules is scanned both ways and every match (where, how
+ *    long, and which rule) has to be the same.
+ *
+ *    The scan is done the same way RuleHighlighter_Scan() does it: at each
+ *    char take the longest match of any rule (the lowest rule wins a tie),
+ *    skip past it, or move on 1 char if nothing matched.  Control chars end
+ *    the run of text (a match never spans one).  The text is all AscII so
+ *    chars and bytes are the same.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/StdPlugins/DataProcessors/Highlighter/HighlightDFA.h"
+#include <regex>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define DEFAULT_CHECK_BYTES             (256*1024)
+#define DEFAULT_TIME_BYTES              (16*1024*1024)
+#define REGEX_TIME_BYTES                (64*1024)
+#define MAX_PENDING_CHARS               256     // Same as RULEHIGHLIGHTER_MAX_PENDING_CHARS
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct BenchRule
+{
+    bool IsKeywords;
+    const char *Pattern;        // DFA syntax
+    const char *ERE;            // The same thing for std::regex (NULL=make from keywords)
+    bool IgnoreCase;
+};
+
+struct BenchMatch
+{
+    uint32_t Offset;
+    uint32_t Len;
+    int Rule;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+static uint64_t Bench_ns(void);
+static uint32_t Bench_Rand(void);
+static void BuildText(string &Text,unsigned int Bytes);
+static bool BuildDFA(class HighlightDFA &DFA);
+static bool BuildRegexs(vector<regex> &Regexs);
+static void ScanDFA(class HighlightDFA &DFA,const string &Text,
+        vector<struct BenchMatch> &Matches);
+static void ScanRegex(vector<regex> &Regexs,const string &Text,
+        vector<struct BenchMatch> &Matches);
+static bool Check(class HighlightDFA &DFA,vector<regex> &Regexs,
+        unsigned int Bytes);
+static void Time(class HighlightDFA &DFA,vector<regex> &Regexs,
+        unsigned int Bytes);
+static void Usage(void);
+
+/*** VARIABLE DEFINITIONS     ***/
+static uint32_t m_RandState=1234;
+
+static const struct BenchRule m_Rules[]=
+{
+    {true,"error warning fail",NULL,true},
+    {false,"[0-9]+ms","[0-9]+ms",false},
+    {false,"(ab|a)(bc|c)*","(ab|a)(bc|c)*",false},
+    {false,"x{2,4}y?","x{2,4}y?",false},
+    /* The Rule Highlighter presets */
+    {false,"(https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|!:,.;]*"
+                "[-A-Za-z0-9+&@#/%=~_|]",
+            "(https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|!:,.;]*"
+                "[-A-Za-z0-9+&@#/%=~_|]",false},
+    {false,"[0-9]{1,3}\\.[0-9]{1,3}\\.[0-9]{1,3}\\.[0-9]{1,3}(:[0-9]{1,5})?",
+            "[0-9]{1,3}\\.[0-9]{1,3}\\.[0-9]{1,3}\\.[0-9]{1,3}(:[0-9]{1,5})?",
+            false},
+    {false,"0[xX][0-9A-Fa-f]+","0[xX][0-9A-Fa-f]+",false},
+    /* These overlap the ones above so the longest / lowest rule is tested */
+    {false,"[0-9a-f]+","[0-9a-f]+",false},
+    {false,"[a-z]+","[a-z]+",true},
+};
+#define NUMBER_OF_RULES     (sizeof(m_Rules)/sizeof(m_Rules[0]))
+
+/* Bits of text that look like the rules (and some that almost do) */
+static const char *m_Tokens[]=
+{
+    "error","ERROR","Warning","fail","failed","errors","err",
+    "10ms","250ms","ms","5m",
+    "ab","abc","abcbc","acc","a","bc",
+    "xx","xxxy","xxxxxy","xy",
+    "http://example.com/a?b=1","https://x.org/","ftp://host:21/path.",
+    "file:///tmp/x","http:/","htt",
+    "192.168.1.1","10.0.0.1:8080","1.2.3","256.1.1.1.","1.2.3.4:123456",
+    "0x1F","0XdeadBEEF","0x","0xg","deadbeef",
+    " "," "," ","  ",".",":","/","-","=","_",
+    "\n","\r\n","\t","\x1b[0m",
+};
+#define NUMBER_OF_TOKENS    (sizeof(m_Tokens)/sizeof(m_Tokens[0]))
+
+int main(int argc,char *argv[])
+{
+    class HighlightDFA DFA;
+    vector<regex> Regexs;
+    unsigned int CheckBytes;
+    unsigned int TimeBytes;
+    int arg;
+
+    CheckBytes=DEFAULT_CHECK_BYTES;
+    TimeBytes=DEFAULT_TIME_BYTES;
+
+    for(arg=1;arg<argc;arg++)
+    {
+        if(strcmp(argv[arg],"-c")==0 && arg+1<argc)
+        {
+            CheckBytes=strtoul(argv[++arg],NULL,0);
+        }
+        else if(strcmp(argv[arg],"-t")==0 && arg+1<argc)
+        {
+            TimeBytes=strtoul(argv[++arg],NULL,0);
+        }
+        else if(strcmp(argv[arg],"-r")==0 && arg+1<argc)
+        {
+            m_RandState=strtoul(argv[++arg],NULL,0);
+            if(m_RandState==0)
+                m_RandState=1;
+        }
+        else
+        {
+            Usage();
+            return 0;
+        }
+    }
+
+    if(!BuildDFA(DFA) || !BuildRegexs(Regexs))
+        return 1;
+
+    if(!Check(DFA,Regexs,CheckBytes))
+        return 1;
+
+    Time(DFA,Regexs,TimeBytes);
+
+    return 0;
+}
+
+static void Usage(void)
+{
+    printf("USAGE:\n");
+    printf("    HighlightBench [-c bytes] [-t bytes] [-r seed]\n");
+    printf("\n");
+    printf("    -c -- How many bytes of random text to check the DFA against "
+            "std::regex with (default %d)\n",DEFAULT_CHECK_BYTES);
+    printf("    -t -- How many bytes to time the DFA with (default %d).  "
+            "std::regex is timed\n",DEFAULT_TIME_BYTES);
+    printf("          with %d bytes because it's so much slower\n",
+            REGEX_TIME_BYTES);
+    printf("    -r -- The seed for the random text\n");
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_ns
+ *
+ * SYNOPSIS:
+ *    static uint64_t Bench_ns(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the time for timing things.
+ *
+ * RETURNS:
+ *    The monotonic clock in ns
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static uint64_t Bench_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+static uint32_t Bench_Rand(void)
+{
+    /* xorshift32 so the text is the same on every system for a seed */
+    m_RandState^=m_RandState<<13;
+    m_RandState^=m_RandState>>17;
+    m_RandState^=m_RandState<<5;
+    return m_RandState;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    BuildText
+ *
+ * SYNOPSIS:
+ *    static void BuildText(string &Text,unsigned int Bytes);
+ *
+ * PARAMETERS:
+ *    Text [O] -- The text we made
+ *    Bytes [I] -- About how many bytes to make
+ *
+ * FUNCTION:
+ *    This function makes random text out of 'm_Tokens' and random printable
+ *    chars.  Tokens are put right next to each other a lot of the time so
+ *    matches run into each other.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void BuildText(string &Text,unsigned int Bytes)
+{
+    uint32_t r;
+
+    Text.clear();
+    Text.reserve(Bytes+64);
+    while(Text.length()<Bytes)
+    {
+        r=Bench_Rand();
+        if(r%8==0)
+            Text+=(char)(' '+(r>>8)%95);
+        else
+            Text+=m_Tokens[(r>>8)%NUMBER_OF_TOKENS];
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    BuildDFA
+ *
+ * SYNOPSIS:
+ *    static bool BuildDFA(class HighlightDFA &DFA);
+ *
+ * PARAMETERS:
+ *    DFA [O] -- The DFA to add 'm_Rules' to
+ *
+ * FUNCTION:
+ *    This function compiles 'm_Rules' into a DFA (rule 'x' is ID 'x').
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error (it has been printed)
+ *
+ * SEE ALSO:
+ *    BuildRegexs()
+ ******************************************************************************/
+static bool BuildDFA(class HighlightDFA &DFA)
+{
+    string ErrorMsg;
+    unsigned int ErrorOffset;
+    unsigned int r;
+    bool Worked;
+
+    for(r=0;r<NUMBER_OF_RULES;r++)
+    {
+        if(m_Rules[r].IsKeywords)
+        {
+            Worked=DFA.AddKeywords(m_Rules[r].Pattern,m_Rules[r].IgnoreCase,r,
+                    ErrorMsg);
+        }
+        else
+        {
+            Worked=DFA.AddRegex(m_Rules[r].Pattern,m_Rules[r].IgnoreCase,r,
+                    ErrorMsg,ErrorOffset);
+        }
+        if(!Worked)
+        {
+            fprintf(stderr,"Rule %d \"%s\": %s\n",r,m_Rules[r].Pattern,
+                    ErrorMsg.c_str());
+            return false;
+        }
+    }
+
+    if(!DFA.Compile(ErrorMsg))
+    {
+        fprintf(stderr,"Compile failed: %s\n",ErrorMsg.c_str());
+        return false;
+    }
+
+    printf("%d rules, %d DFA states\n",(int)NUMBER_OF_RULES,
+            DFA.GetStateCount());
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    BuildRegexs
+ *
+ * SYNOPSIS:
+ *    static bool BuildRegexs(vector<regex> &Regexs);
+ *
+ * PARAMETERS:
+ *    Regexs [O] -- One std::regex for each of 'm_Rules'
+ *
+ * FUNCTION:
+ *    This function builds a std::regex for each rule.  Keyword lists are
+ *    turned into an alternation with the regex chars escaped.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error (it has been printed)
+ *
+ * SEE ALSO:
+ *    BuildDFA()
+ ******************************************************************************/
+static bool BuildRegexs(vector<regex> &Regexs)
+{
+    regex_constants::syntax_option_type Flags;
+    string ERE;
+    const char *p;
+    unsigned int r;
+
+    for(r=0;r<NUMBER_OF_RULES;r++)
+    {
+        if(m_Rules[r].ERE!=NULL)
+        {
+            ERE=m_Rules[r].ERE;
+        }
+        else
+        {
+            ERE="";
+            for(p=m_Rules[r].Pattern;*p!=0;p++)
+            {
+                if(*p==' ')
+                {
+                    if(!ERE.empty() && ERE.back()!='|')
+                        ERE+='|';
+                    continue;
+                }
+                if(strchr(".[]()*+?{}|^$\\",*p)!=NULL)
+                    ERE+='\\';
+                ERE+=*p;
+            }
+        }
+
+        Flags=regex_constants::extended;
+        if(m_Rules[r].IgnoreCase)
+            Flags|=regex_constants::icase;
+        try
+        {
+            Regexs.push_back(regex(ERE,Flags));
+        }
+        catch(const regex_error &e)
+        {
+            fprintf(stderr,"std::regex rule %d \"%s\": %s\n",r,ERE.c_str(),
+                    e.what());
+            return false;
+        }
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ScanDFA
+ *
+ * SYNOPSIS:
+ *    static void ScanDFA(class HighlightDFA &DFA,const string &Text,
+ *              vector<struct BenchMatch> &Matches);
+ *
+ * PARAMETERS:
+ *    DFA [I] -- The compiled rules
+ *    Text [I] -- The text to scan
+ *    Matches [O] -- All the matches we found
+ *
+ * FUNCTION:
+ *    This function finds all the matches with the DFA the same way
+ *    RuleHighlighter_Scan() does.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ScanRegex()
+ ******************************************************************************/
+static void ScanDFA(class HighlightDFA &DFA,const string &Text,
+        vector<struct BenchMatch> &Matches)
+{
+    const uint8_t *Bytes=(const uint8_t *)Text.data();
+    struct BenchMatch NewMatch;
+    uint32_t Len=Text.length();
+    uint32_t Pos;
+    uint32_t End;
+    uint32_t p;
+    int State;
+    int Rule;
+
+    Matches.clear();
+    Pos=0;
+    while(Pos<Len)
+    {
+        NewMatch.Len=0;
+        NewMatch.Rule=HIGHLIGHTDFA_NO_RULE;
+        State=HIGHLIGHTDFA_START_STATE;
+        End=Pos+MAX_PENDING_CHARS;
+        if(End>Len)
+            End=Len;
+        for(p=Pos;p<End;p++)
+        {
+            if(Bytes[p]<0x20 || Bytes[p]==0x7F)
+                break;
+            State=DFA.Step(State,Bytes[p]);
+            if(State==HIGHLIGHTDFA_DEAD_STATE)
+                break;
+            Rule=DFA.GetAccept(State);
+            if(Rule!=HIGHLIGHTDFA_NO_RULE)
+            {
+                NewMatch.Len=p-Pos+1;
+                NewMatch.Rule=Rule;
+            }
+            if(DFA.IsFinal(State))
+                break;
+        }
+
+        if(NewMatch.Len>0)
+        {
+            NewMatch.Offset=Pos;
+            Matches.push_back(NewMatch);
+            Pos+=NewMatch.Len;
+        }
+        else
+        {
+            Pos++;
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ScanRegex
+ *
+ * SYNOPSIS:
+ *    static void ScanRegex(vector<regex> &Regexs,const string &Text,
+ *              vector<struct BenchMatch> &Matches);
+ *
+ * PARAMETERS:
+ *    Regexs [I] -- The rules
+ *    Text [I] -- The text to scan
+ *    Matches [O] -- All the matches we found
+ *
+ * FUNCTION:
+ *    This function finds all the matches with std::regex.  Each run of text
+ *    between control chars is matched on it's own.  At each char every
+ *    rule is tried (anchored at that char) and the longest wins.  Like the
+ *    highlighter a match can't be longer than MAX_PENDING_CHARS.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ScanDFA()
+ ******************************************************************************/
+static void ScanRegex(vector<regex> &Regexs,const string &Text,
+        vector<struct BenchMatch> &Matches)
+{
+    string::const_iterator RunEnd;
+    string::const_iterator Pos;
+    string::const_iterator End;
+    struct BenchMatch NewMatch;
+    smatch Found;
+    uint32_t RunStart;
+    uint32_t RunLen;
+    uint32_t r;
+
+    Matches.clear();
+    RunStart=0;
+    while(RunStart<Text.length())
+    {
+        for(RunLen=0;RunStart+RunLen<Text.length();RunLen++)
+        {
+            if((uint8_t)Text[RunStart+RunLen]<0x20 ||
+                    Text[RunStart+RunLen]==0x7F)
+            {
+                break;
+            }
+        }
+        Pos=Text.begin()+RunStart;
+        RunEnd=Pos+RunLen;
+
+        while(Pos<RunEnd)
+        {
+            NewMatch.Len=0;
+            NewMatch.Rule=HIGHLIGHTDFA_NO_RULE;
+            End=RunEnd;
+            if(End-Pos>MAX_PENDING_CHARS)
+                End=Pos+MAX_PENDING_CHARS;
+            for(r=0;r<Regexs.size();r++)
+            {
+                if(regex_search(Pos,End,Found,Regexs[r],
+                        regex_constants::match_continuous) &&
+                        Found.length(0)>(int)NewMatch.Len)
+                {
+                    NewMatch.Len=Found.length(0);
+                    NewMatch.Rule=r;
+                }
+            }
+            if(NewMatch.Len>0)
+            {
+                NewMatch.Offset=Pos-Text.begin();
+                Matches.push_back(NewMatch);
+                Pos+=NewMatch.Len;
+            }
+            else
+            {
+                Pos++;
+            }
+        }
+
+        RunStart+=RunLen+1;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Check
+ *
+ * SYNOPSIS:
+ *    static bool Check(class HighlightDFA &DFA,vector<regex> &Regexs,
+ *              unsigned int Bytes);
+ *
+ * PARAMETERS:
+ *    DFA [I] -- The compiled rules
+ *    Regexs [I] -- The same rules as std::regex's
+ *    Bytes [I] -- How much random text to check with
+ *
+ * FUNCTION:
+ *    This function scans random text with the DFA and with std::regex and
+ *    makes sure they found the same matches.  The first difference is
+ *    printed.
+ *
+ * RETURNS:
+ *    true -- They are the same
+ *    false -- They found different things
+ *
+ * SEE ALSO:
+ *    ScanDFA(), ScanRegex()
+ ******************************************************************************/
+static bool Check(class HighlightDFA &DFA,vector<regex> &Regexs,
+        unsigned int Bytes)
+{
+    vector<struct BenchMatch> DFAMatches;
+    vector<struct BenchMatch> RegexMatches;
+    vector<unsigned int> PerRule;
+    string Text;
+    unsigned int Count;
+    unsigned int m;
+    unsigned int Start;
+    unsigned int r;
+
+    BuildText(Text,Bytes);
+    ScanDFA(DFA,Text,DFAMatches);
+    ScanRegex(Regexs,Text,RegexMatches);
+
+    Count=DFAMatches.size();
+    if(RegexMatches.size()<Count)
+        Count=RegexMatches.size();
+    for(m=0;m<Count;m++)
+    {
+        if(DFAMatches[m].Offset!=RegexMatches[m].Offset ||
+                DFAMatches[m].Len!=RegexMatches[m].Len ||
+                DFAMatches[m].Rule!=RegexMatches[m].Rule)
+        {
+            break;
+        }
+    }
+
+    if(m<DFAMatches.size() || m<RegexMatches.size())
+    {
+        printf("FAILED: match %d is different\n",m);
+        if(m<DFAMatches.size())
+        {
+            printf("    DFA:   offset %d len %d rule %d\n",
+                    DFAMatches[m].Offset,DFAMatches[m].Len,
+                    DFAMatches[m].Rule);
+            Start=DFAMatches[m].Offset;
+        }
+        if(m<RegexMatches.size())
+        {
+            printf("    regex: offset %d len %d rule %d\n",
+                    RegexMatches[m].Offset,RegexMatches[m].Len,
+                    RegexMatches[m].Rule);
+            Start=RegexMatches[m].Offset;
+        }
+        printf("    text:  \"");
+        for(r=Start;r<Start+40 && r<Text.length();r++)
+        {
+            if((uint8_t)Text[r]<0x20)
+                printf("\\x%02X",(uint8_t)Text[r]);
+            else
+                printf("%c",Text[r]);
+        }
+        printf("\"\n");
+        return false;
+    }
+
+    PerRule.assign(NUMBER_OF_RULES,0);
+    for(m=0;m<DFAMatches.size();m++)
+        PerRule[DFAMatches[m].Rule]++;
+
+    printf("Check: %d bytes, %d matches the same (",(int)Text.length(),
+            (int)DFAMatches.size());
+    for(r=0;r<NUMBER_OF_RULES;r++)
+        printf("%s%d",r==0?"":" ",PerRule[r]);
+    printf(" per rule)\n");
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Time
+ *
+ * SYNOPSIS:
+ *    static void Time(class HighlightDFA &DFA,vector<regex> &Regexs,
+ *              unsigned int Bytes);
+ *
+ * PARAMETERS:
+ *    DFA [I] -- The compiled rules
+ *    Regexs [I] -- The same rules as std::regex's
+ *    Bytes [I] -- How much text to time the DFA with
+ *
+ * FUNCTION:
+ *    This function times scanning random text with the DFA and with
+ *    std::regex and prints the MB/s for each.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Time(class HighlightDFA &DFA,vector<regex> &Regexs,
+        unsigned int Bytes)
+{
+    vector<struct BenchMatch> Matches;
+    string Text;
+    uint64_t Start;
+    uint64_t Took;
+
+    printf("%-10s %10s %10s %10s\n","scanner","bytes","MB/s","ns/byte");
+
+    BuildText(Text,Bytes);
+    Start=Bench_ns();
+    ScanDFA(DFA,Text,Matches);
+    Took=Bench_ns()-Start;
+    if(Took==0)
+        Took=1;
+    printf("%-10s %10d %10.2f %10.2f\n","DFA",(int)Text.length(),
+            Text.length()*1000.0/Took,(double)Took/Text.length());
+
+    BuildText(Text,REGEX_TIME_BYTES);
+    Start=Bench_ns();
+    ScanRegex(Regexs,Text,Matches);
+    Took=Bench_ns()-Start;
+    if(Took==0)
+        Took=1;
+    printf("%-10s %10d %10.2f %10.2f\n","std::regex",(int)Text.length(),
+            Text.length()*1000.0/Took,(double)Took/Text.length());
+}
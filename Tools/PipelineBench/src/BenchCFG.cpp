@@ -0,0 +1,206 @@
+/*******************************************************************************
+ * FILENAME: BenchCFG.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file times saving and loading a big bookmark file though TinyCFG.
+ *    It uses the real bookmark load / save code so every bookmark has the
+ *    full set of custom connection settings in it (like a real file).
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "PipelineBench.h"
+#include "App/Bookmarks.h"
+#include "App/Settings.h"
+#include "OS/OSTime.h"
+#include <stdio.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define BENCH_CFG_FILENAME                  "/tmp/PipelineBench_Bookmarks.cfg"
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+static void Bench_CFGReport(const char *Stage,uint64_t ns,uint64_t Allocs,
+        long FileSize,unsigned int Count);
+
+/*** VARIABLE DEFINITIONS     ***/
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_BookmarkFile
+ *
+ * SYNOPSIS:
+ *    bool Bench_BookmarkFile(unsigned int Count);
+ *
+ * PARAMETERS:
+ *    Count [I] -- How many bookmarks to put in the file
+ *
+ * FUNCTION:
+ *    This function makes a list of 'Count' bookmarks, saves it with
+ *    SaveBookmarks2File() and loads it back with LoadBookmarksFromFile()
+ *    timing both.  It then checks that what was loaded matches what was
+ *    saved.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- The save or load failed (or the data did not match)
+ *
+ * SEE ALSO:
+ *    SaveBookmarks2File(), LoadBookmarksFromFile()
+ ******************************************************************************/
+bool Bench_BookmarkFile(unsigned int Count)
+{
+    t_BookmarkList Bookmarks;
+    t_BookmarkList Loaded;
+    struct Bookmark NewBookmark;
+    i_BookmarkList b;
+    i_BookmarkList l;
+    struct stat FileInfo;
+    uint64_t StartTime;
+    uint64_t StartAllocs;
+    uint64_t ns;
+    uint64_t Allocs;
+    unsigned int r;
+    char buff[100];
+
+    for(r=0;r<Count;r++)
+    {
+        sprintf(buff,"Group %u",r/100);
+        NewBookmark.MenuName=buff;
+        sprintf(buff,"Device <%u> & friends",r);
+        NewBookmark.Name=buff;
+        sprintf(buff,"TCP://192.168.%u.%u:%u",(r/256)%256,r%256,2000+r%1000);
+        NewBookmark.URI=buff;
+        NewBookmark.Options.clear();
+        sprintf(buff,"192.168.%u.%u",(r/256)%256,r%256);
+        NewBookmark.Options["Address"]=buff;
+        sprintf(buff,"%u",2000+r%1000);
+        NewBookmark.Options["Port"]=buff;
+        NewBookmark.UseCustomSettings=(r%4==0);
+        NewBookmark.CustomSettings=g_Settings.DefaultConSettings;
+        NewBookmark.CustomSettings.ScrollBufferLines=1000+r;
+        Bookmarks.push_back(NewBookmark);
+    }
+
+    remove(BENCH_CFG_FILENAME);
+
+    StartAllocs=g_BenchAllocCount;
+    StartTime=GetElapsedTime_ns();
+    if(!SaveBookmarks2File(Bookmarks,BENCH_CFG_FILENAME))
+    {
+        fprintf(stderr,"Failed to save \"%s\"\n",BENCH_CFG_FILENAME);
+        return false;
+    }
+    ns=GetElapsedTime_ns()-StartTime;
+    Allocs=g_BenchAllocCount-StartAllocs;
+
+    if(stat(BENCH_CFG_FILENAME,&FileInfo)!=0)
+    {
+        fprintf(stderr,"Failed to save \"%s\"\n",BENCH_CFG_FILENAME);
+        return false;
+    }
+    Bench_CFGReport("save",ns,Allocs,FileInfo.st_size,Count);
+
+    StartAllocs=g_BenchAllocCount;
+    StartTime=GetElapsedTime_ns();
+    if(!LoadBookmarksFromFile(Loaded,BENCH_CFG_FILENAME))
+    {
+        fprintf(stderr,"Failed to load \"%s\"\n",BENCH_CFG_FILENAME);
+        return false;
+    }
+    ns=GetElapsedTime_ns()-StartTime;
+    Allocs=g_BenchAllocCount-StartAllocs;
+    Bench_CFGReport("load",ns,Allocs,FileInfo.st_size,Count);
+
+    /* Make sure we got back what we saved */
+    if(Loaded.size()!=Bookmarks.size())
+    {
+        fprintf(stderr,"Loaded %zu bookmarks, expected %zu\n",Loaded.size(),
+                Bookmarks.size());
+        return false;
+    }
+    for(b=Bookmarks.begin(),l=Loaded.begin();b!=Bookmarks.end();b++,l++)
+    {
+        if(b->MenuName!=l->MenuName || b->Name!=l->Name || b->URI!=l->URI ||
+                b->Options!=l->Options ||
+                b->UseCustomSettings!=l->UseCustomSettings ||
+                b->CustomSettings.ScrollBufferLines!=
+                l->CustomSettings.ScrollBufferLines)
+        {
+            fprintf(stderr,"Bookmark \"%s\" did not load back the same\n",
+                    b->Name.c_str());
+            return false;
+        }
+    }
+
+    remove(BENCH_CFG_FILENAME);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_CFGReport
+ *
+ * SYNOPSIS:
+ *    static void Bench_CFGReport(const char *Stage,uint64_t ns,
+ *              uint64_t Allocs,long FileSize,unsigned int Count);
+ *
+ * PARAMETERS:
+ *    Stage [I] -- The name of what was timed
+ *    ns [I] -- How long it took
+ *    Allocs [I] -- How many allocations where made
+ *    FileSize [I] -- The size of the bookmark file
+ *    Count [I] -- The number of bookmarks in the file
+ *
+ * FUNCTION:
+ *    This function prints a line of the report for the bookmark file bench.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Bench_BookmarkFile()
+ ******************************************************************************/
+static void Bench_CFGReport(const char *Stage,uint64_t ns,uint64_t Allocs,
+        long FileSize,unsigned int Count)
+{
+    double Secs;
+
+    Secs=ns/1000000000.0;
+    if(Secs<=0)
+        Secs=0.000000001;
+
+    printf("%-12s %-11s %10.2f %10.1f %10.1f  (%u bookmarks, %.1f MB, "
+            "%.1f ms)\n","bookmarks",Stage,FileSize/Secs/(1024*1024),
+            (double)ns/FileSize,Allocs*1024.0/FileSize,Count,
+            FileSize/(1024.0*1024.0),ns/1000000.0);
+}
@@ -0,0 +1,393 @@
+/*******************************************************************************
+ * FILENAME: BenchConnection.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file stands in for ConnectionsGlobal.cpp / Connections.cpp in the
+ *    pipeline bench.  The data processors system talks to the "active
+ *    connection" through the Con_xxx() functions, here they just forward to
+ *    the one display the bench is feeding (the same thing Connection does
+ *    minus the frozen stream queue, tx and the main window).
+ *
+ *    If no display is set everything is thrown away, which is used to time
+ *    the data processors on their own.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "PipelineBench.h"
+#include "App/ConnectionsGlobal.h"
+#include "App/Display/DisplayBase.h"
+#include "App/Settings.h"
+#include "ThirdParty/utf8.h"
+#include <string.h>
+
+/*** DEFINES                  ***/
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+
+/*** VARIABLE DEFINITIONS     ***/
+static class DisplayBase *m_BenchDisplay;
+static class ConSettings *m_BenchSettings=&g_Settings.DefaultConSettings;
+
+/*******************************************************************************
+ * NAME:
+ *    BenchCon_SetDisplay
+ *
+ * SYNOPSIS:
+ *    void BenchCon_SetDisplay(class DisplayBase *Display,
+ *              class ConSettings *Settings);
+ *
+ * PARAMETERS:
+ *    Display [I] -- The display to send the processed data to.  NULL to
+ *                   throw it away.
+ *    Settings [I] -- The connection settings to use for system colors.
+ *
+ * FUNCTION:
+ *    This function sets what the "active connection" is for the Con_xxx()
+ *    functions.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Con_SetActiveConnection()
+ ******************************************************************************/
+void BenchCon_SetDisplay(class DisplayBase *Display,class ConSettings *Settings)
+{
+    m_BenchDisplay=Display;
+    m_BenchSettings=Settings;
+}
+
+void Con_WriteChar2Display(uint8_t *Chr)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->WriteChar(Chr);
+}
+
+void Con_WriteChars2Display(const uint8_t *Chrs,int Count)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->WriteChars(Chrs,Count);
+}
+
+void Con_WriteData(const uint8_t *Data,int Bytes)
+{
+}
+
+void Con_InsertString(const uint8_t *Str,uint32_t Len)
+{
+    uint_fast32_t r;
+    uint8_t CharBuff[10];
+    const uint8_t *StartOfChar;
+    const uint8_t *EndOfChar;
+
+    StartOfChar=Str;
+    for(r=0;r<Len;r++)
+    {
+        EndOfChar=StartOfChar;
+        utf8::unchecked::advance(EndOfChar,1);
+        if(EndOfChar-StartOfChar>(unsigned)sizeof(CharBuff)-1)
+            return;
+        memcpy(CharBuff,StartOfChar,EndOfChar-StartOfChar);
+        CharBuff[EndOfChar-StartOfChar]=0;
+        Con_WriteChar2Display(CharBuff);
+        StartOfChar=EndOfChar;
+    }
+}
+
+void Con_SetFGColor(uint32_t FGColor)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->CurrentStyle.FGColor=FGColor;
+}
+
+uint32_t Con_GetFGColor(void)
+{
+    if(m_BenchDisplay!=NULL)
+        return m_BenchDisplay->CurrentStyle.FGColor;
+    return m_BenchSettings->DefaultColors[e_DefaultColors_FG];
+}
+
+void Con_SetBGColor(uint32_t BGColor)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->CurrentStyle.BGColor=BGColor;
+}
+
+uint32_t Con_GetBGColor(void)
+{
+    if(m_BenchDisplay!=NULL)
+        return m_BenchDisplay->CurrentStyle.BGColor;
+    return m_BenchSettings->DefaultColors[e_DefaultColors_BG];
+}
+
+void Con_SetULineColor(uint32_t ULineColor)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->CurrentStyle.ULineColor=ULineColor;
+}
+
+uint32_t Con_GetULineColor(void)
+{
+    if(m_BenchDisplay!=NULL)
+        return m_BenchDisplay->CurrentStyle.ULineColor;
+    return m_BenchSettings->DefaultColors[e_DefaultColors_FG];
+}
+
+void Con_SetAttribs(uint16_t Attribs)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->CurrentStyle.Attribs=Attribs;
+}
+
+uint16_t Con_GetAttribs(void)
+{
+    if(m_BenchDisplay!=NULL)
+        return m_BenchDisplay->CurrentStyle.Attribs;
+    return 0;
+}
+
+void Con_SetStyle(const struct CharStyling *Style)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->CurrentStyle=*Style;
+}
+
+void Con_GetStyle(struct CharStyling *RetStyle)
+{
+    if(m_BenchDisplay!=NULL)
+    {
+        *RetStyle=m_BenchDisplay->CurrentStyle;
+        return;
+    }
+    RetStyle->FGColor=m_BenchSettings->DefaultColors[e_DefaultColors_FG];
+    RetStyle->BGColor=m_BenchSettings->DefaultColors[e_DefaultColors_BG];
+    RetStyle->ULineColor=m_BenchSettings->DefaultColors[e_DefaultColors_FG];
+    RetStyle->Attribs=0;
+}
+
+void Con_DoFunction(e_ConFuncType Fn,uintptr_t Arg1,uintptr_t Arg2,
+        uintptr_t Arg3,uintptr_t Arg4,uintptr_t Arg5,uintptr_t Arg6)
+{
+    if(m_BenchDisplay==NULL)
+        return;
+
+    switch(Fn)
+    {
+        case e_ConFunc_NewLine:
+            m_BenchDisplay->DoLineFeed();
+        break;
+        case e_ConFunc_Return:
+            m_BenchDisplay->DoReturn();
+        break;
+        case e_ConFunc_Backspace:
+            m_BenchDisplay->DoBackspace();
+        break;
+        case e_ConFunc_MoveCursor:
+            m_BenchDisplay->SetCursorXY(Arg1,Arg2);
+        break;
+        case e_ConFunc_ClearScreen:
+            m_BenchDisplay->ClearScreen(g_Settings.ScreenClear);
+        break;
+        case e_ConFunc_ClearScreenAndBackBuffer:
+            m_BenchDisplay->ClearScreen(g_Settings.ScreenClear);
+            m_BenchDisplay->ClearScrollBackBuffer();
+        break;
+        case e_ConFunc_ClearArea:
+            m_BenchDisplay->ClearArea(Arg1,Arg2,Arg3,Arg4);
+        break;
+        case e_ConFunc_Tab:
+            m_BenchDisplay->AddTab();
+        break;
+        case e_ConFunc_PrevTab:
+            m_BenchDisplay->AddReverseTab();
+        break;
+        case e_ConFunc_NoteNonPrintable:
+            m_BenchDisplay->NoteNonPrintable((const char *)Arg1);
+        break;
+        case e_ConFunc_ScrollArea:
+            m_BenchDisplay->ScrollArea(Arg1,Arg2,Arg3,Arg4,(intptr_t)Arg5,
+                    (intptr_t)Arg6);
+        break;
+        case e_ConFunc_SetScrollRegion:
+            m_BenchDisplay->SetScrollRegion(Arg1,Arg2);
+        break;
+        case e_ConFunc_SetAltScreen:
+            m_BenchDisplay->SetAltScreen(Arg1!=0);
+        break;
+        case e_ConFunc_SendBackspace:
+        case e_ConFunc_SendEnter:
+        case e_ConFuncMAX:
+        default:
+        break;
+    }
+}
+
+void Con_GetCursorXY(int32_t *RetCursorX,int32_t *RetCursorY)
+{
+    *RetCursorX=0;
+    *RetCursorY=0;
+    if(m_BenchDisplay!=NULL)
+    {
+        m_BenchDisplay->GetCursorXY((unsigned int *)RetCursorX,
+                (unsigned int *)RetCursorY);
+    }
+}
+
+void Con_GetScreenSize(int32_t *RetRows,int32_t *RetColumns)
+{
+    *RetRows=24;
+    *RetColumns=80;
+    if(m_BenchDisplay!=NULL)
+    {
+        m_BenchDisplay->GetScreenSize((uint32_t *)RetColumns,
+                (uint32_t *)RetRows);
+    }
+}
+
+uint32_t Con_GetSysColor(e_SysColShadeType SysColShade,e_SysColType SysColor)
+{
+    if(SysColShade>=e_SysColShadeMAX || SysColor>=e_SysColMAX)
+        return 0;
+    return m_BenchSettings->SysColors[SysColShade][SysColor];
+}
+
+uint32_t Con_GetSysDefaultColor(e_DefaultColorsType DefaultColor)
+{
+    if(DefaultColor>=e_DefaultColorsMAX)
+        return 0;
+    return m_BenchSettings->DefaultColors[DefaultColor];
+}
+
+void Con_DoBell(bool VisualOnly)
+{
+}
+
+void Con_SetTitle(const char *Title)
+{
+}
+
+t_DataProMark *Con_AllocateMark(void)
+{
+    if(m_BenchDisplay!=NULL)
+        return m_BenchDisplay->AllocateMark();
+    return NULL;
+}
+
+void Con_FreeMark(t_DataProMark *Mark)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->FreeMark(Mark);
+}
+
+bool Con_IsMarkValid(t_DataProMark *Mark)
+{
+    if(m_BenchDisplay!=NULL)
+        return m_BenchDisplay->IsMarkValid(Mark);
+    return false;
+}
+
+void Con_SetMark2CursorPos(t_DataProMark *Mark)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->SetMark2CursorPos(Mark);
+}
+
+void Con_ApplyAttrib2Mark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Offset,
+        uint32_t Len)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->ApplyAttrib2Mark(Mark,Attrib,Offset,Len);
+}
+
+void Con_RemoveAttribFromMark(t_DataProMark *Mark,uint32_t Attrib,
+        uint32_t Offset,uint32_t Len)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->RemoveAttribFromMark(Mark,Attrib,Offset,Len);
+}
+
+void Con_ApplyFGColor2Mark(t_DataProMark *Mark,uint32_t FGColor,
+        uint32_t Offset,uint32_t Len)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->ApplyFGColor2Mark(Mark,FGColor,Offset,Len);
+}
+
+void Con_ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,
+        uint32_t Offset,uint32_t Len)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->ApplyBGColor2Mark(Mark,BGColor,Offset,Len);
+}
+
+void Con_ApplyStyleSpans2Mark(t_DataProMark *Mark,
+        const struct DPS_StyleSpan *Spans,uint32_t Count)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->ApplyStyleSpans2Mark(Mark,Spans,Count);
+}
+
+void Con_MoveMark(t_DataProMark *Mark,int Amount)
+{
+    if(m_BenchDisplay!=NULL)
+        m_BenchDisplay->MoveMark(Mark,Amount);
+}
+
+const uint8_t *Con_GetMarkString(t_DataProMark *Mark,uint32_t *Size,
+        uint32_t Offset,uint32_t Len)
+{
+    if(m_BenchDisplay!=NULL)
+        return m_BenchDisplay->GetMarkString(Mark,Size,Offset,Len);
+    *Size=0;
+    return NULL;
+}
+
+/* The bench doesn't queue a frozen stream, it just passes it though */
+void Con_FreezeStream(void)
+{
+}
+
+void Con_ReleaseFrozenStream(void)
+{
+}
+
+void Con_ClearFrozenStream(void)
+{
+}
+
+const uint8_t *Con_GetFrozenString(uint32_t *Size)
+{
+    *Size=0;
+    return NULL;
+}
+
+void Con_ApplySettings2AllConnections(void)
+{
+}
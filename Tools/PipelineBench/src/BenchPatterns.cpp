@@ -0,0 +1,440 @@
+/*******************************************************************************
+ * FILENAME: BenchPatterns.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file builds the synthetic input for the pipeline bench.  The
+ *    patterns are bigger versions of the ones in the TestPatterns IO driver
+ *    (plain text, colored text, unicode blocks) plus random binary, a
+ *    full screen app redrawing (like htop and vim do) and a pager scrolling
+ *    in a scroll region.  It can also load a recorded capture to replay.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "PipelineBench.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define BENCH_LINE_WIDTH                    78
+#define BENCH_TUI_ROWS                      24
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+static void Bench_AddStr(std::vector<uint8_t> &Data,const char *Str);
+static void Bench_AddUTF8(std::vector<uint8_t> &Data,uint32_t CodePoint);
+static void Bench_AddTUIFrame(std::vector<uint8_t> &Data,unsigned int Frame);
+
+/*** VARIABLE DEFINITIONS     ***/
+static const char *m_PatternNames[e_BenchPatternMAX]=
+{
+    "plain",
+    "sgr",
+    "utf8",
+    "binary",
+    "tui",
+    "region",
+    "rgb",
+};
+
+/* Text for the editor half of the tui pattern */
+static const char *m_TUICodeLines[]=
+{
+    "void DisplayText::WriteChar(uint8_t *Chr)",
+    "{",
+    "    LastSeenLF=false;",
+    "    LastSeenCR=false;",
+    "",
+    "    WriteCharWithOptions(Chr,true,true);",
+    "}",
+    "    for(r=0;r<Count;r++)",
+    "        if(Run[r]<0x20 || Run[r]>0x7E)",
+    "            break;",
+};
+
+/* Same ranges TestPattern7 uses (arrows, tech, box drawing, blocks,
+   misc symbols, full width) */
+static const uint32_t m_UTF8Ranges[]=
+{
+    0x2190,0x2300,0x2500,0x2580,0x2600,0x2650,0xFF20
+};
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_GetPatternName
+ *
+ * SYNOPSIS:
+ *    const char *Bench_GetPatternName(e_BenchPatternType Pattern);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The pattern to get the name of
+ *
+ * FUNCTION:
+ *    This function gets the name used on the command line and in the
+ *    report for a pattern.
+ *
+ * RETURNS:
+ *    A static string with the name in it.
+ *
+ * SEE ALSO:
+ *    Bench_BuildPattern()
+ ******************************************************************************/
+const char *Bench_GetPatternName(e_BenchPatternType Pattern)
+{
+    if(Pattern>=e_BenchPatternMAX)
+        return "???";
+    return m_PatternNames[Pattern];
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_IsPatternBinary
+ *
+ * SYNOPSIS:
+ *    bool Bench_IsPatternBinary(e_BenchPatternType Pattern);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The pattern to check
+ *
+ * FUNCTION:
+ *    This function checks if a pattern should be fed to a binary connection
+ *    (hex dump) instead of a text one.
+ *
+ * RETURNS:
+ *    true -- Binary pattern
+ *    false -- Text pattern
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+bool Bench_IsPatternBinary(e_BenchPatternType Pattern)
+{
+    return Pattern==e_BenchPattern_Binary;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_BuildPattern
+ *
+ * SYNOPSIS:
+ *    void Bench_BuildPattern(e_BenchPatternType Pattern,unsigned int Bytes,
+ *              std::vector<uint8_t> &RetData);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The pattern to build
+ *    Bytes [I] -- About how many bytes to make.  The pattern is always made
+ *                 of whole lines so it may go over by a line.
+ *    RetData [O] -- The generated data.
+ *
+ * FUNCTION:
+ *    This function generates a synthetic receive stream.
+ *
+ *    plain -- 78 column lines of lower case text ending in \r\n
+ *    sgr -- A SGR color change before every char (like TestPattern4)
+ *    utf8 -- Lines of 3 byte UTF-8 chars (like TestPattern7)
+ *    binary -- Pseudo random bytes
+ *    tui -- Full screen redraws like htop and vim make (cursor moves, 256
+ *           color SGR, erase to end of line, title strings, private modes)
+ *    region -- A pager on the alternate screen.  Lines scroll in a region
+ *              above a status line that is redrawn every 8 lines.
+ *    rgb -- A 24 bit forground and 256 color background SGR before every
+ *           char (like lolcat and syntax highlighters make).  Every 4th
+ *           line uses the ':' sub arg form.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Bench_LoadCapture()
+ ******************************************************************************/
+void Bench_BuildPattern(e_BenchPatternType Pattern,unsigned int Bytes,
+        std::vector<uint8_t> &RetData)
+{
+    unsigned int c;
+    unsigned int Line;
+    uint32_t Seed;
+    char buff[40];
+
+    RetData.clear();
+    RetData.reserve(Bytes+1024);
+
+    Line=0;
+    Seed=0x12345678;
+    while(RetData.size()<Bytes)
+    {
+        switch(Pattern)
+        {
+            case e_BenchPattern_PlainText:
+                for(c=0;c<BENCH_LINE_WIDTH;c++)
+                    RetData.push_back('a'+(c+Line)%26);
+                Bench_AddStr(RetData,"\r\n");
+            break;
+            case e_BenchPattern_DenseSGR:
+                for(c=0;c<BENCH_LINE_WIDTH;c++)
+                {
+                    sprintf(buff,"\33[%dm",31+(c+Line)%7);
+                    Bench_AddStr(RetData,buff);
+                    RetData.push_back('1'+(c%7));
+                }
+                Bench_AddStr(RetData,"\33[m\r\n");
+            break;
+            case e_BenchPattern_UTF8Heavy:
+                for(c=0;c<BENCH_LINE_WIDTH;c++)
+                {
+                    Bench_AddUTF8(RetData,m_UTF8Ranges[Line%
+                            (sizeof(m_UTF8Ranges)/sizeof(m_UTF8Ranges[0]))]+c);
+                }
+                Bench_AddStr(RetData,"\r\n");
+            break;
+            case e_BenchPattern_Binary:
+                for(c=0;c<256;c++)
+                {
+                    /* xorshift32 so the runs are the same every time */
+                    Seed^=Seed<<13;
+                    Seed^=Seed>>17;
+                    Seed^=Seed<<5;
+                    RetData.push_back(Seed&0xFF);
+                }
+            break;
+            case e_BenchPattern_TUI:
+                Bench_AddTUIFrame(RetData,Line);
+            break;
+            case e_BenchPattern_ScrollRegion:
+                if(Line==0)
+                {
+                    sprintf(buff,"\33[?1049h\33[1;%dr\33[%d;1H",
+                            BENCH_TUI_ROWS-1,BENCH_TUI_ROWS-1);
+                    Bench_AddStr(RetData,buff);
+                }
+                for(c=0;c<BENCH_LINE_WIDTH;c++)
+                    RetData.push_back('a'+(c+Line)%26);
+                Bench_AddStr(RetData,"\r\n");
+                if(Line%8==0)
+                {
+                    sprintf(buff,"\0337\33[%d;1H\33[7m%6d\33[m\33[K\0338",
+                            BENCH_TUI_ROWS,Line);
+                    Bench_AddStr(RetData,buff);
+                }
+            break;
+            case e_BenchPattern_TrueColor:
+                for(c=0;c<BENCH_LINE_WIDTH;c++)
+                {
+                    if(Line%4==3)
+                    {
+                        sprintf(buff,"\33[38:2::%d:%d:%d;48:5:%dm",
+                                (c*3)&0xFF,(Line*5)&0xFF,(c+Line)&0xFF,
+                                16+(c+Line)%216);
+                    }
+                    else
+                    {
+                        sprintf(buff,"\33[38;2;%d;%d;%d;48;5;%dm",
+                                (c*3)&0xFF,(Line*5)&0xFF,(c+Line)&0xFF,
+                                16+(c+Line)%216);
+                    }
+                    Bench_AddStr(RetData,buff);
+                    RetData.push_back('a'+(c+Line)%26);
+                }
+                Bench_AddStr(RetData,"\33[m\r\n");
+            break;
+            case e_BenchPatternMAX:
+            default:
+                return;
+        }
+        Line++;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_LoadCapture
+ *
+ * SYNOPSIS:
+ *    bool Bench_LoadCapture(const char *Filename,std::vector<uint8_t> &RetData);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to load.  This is the raw bytes that where
+ *                    received (for example a capture made with strip ctrl
+ *                    and hex dump off, or a 'script' log).
+ *    RetData [O] -- The bytes from the file
+ *
+ * FUNCTION:
+ *    This function loads a recorded capture to replay through the pipeline.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *    Bench_BuildPattern()
+ ******************************************************************************/
+bool Bench_LoadCapture(const char *Filename,std::vector<uint8_t> &RetData)
+{
+    FILE *in;
+    long Size;
+
+    in=fopen(Filename,"rb");
+    if(in==NULL)
+        return false;
+
+    fseek(in,0,SEEK_END);
+    Size=ftell(in);
+    fseek(in,0,SEEK_SET);
+    if(Size<=0)
+    {
+        fclose(in);
+        return false;
+    }
+
+    RetData.resize(Size);
+    if(fread(RetData.data(),Size,1,in)!=1)
+    {
+        fclose(in);
+        return false;
+    }
+    fclose(in);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_AddTUIFrame
+ *
+ * SYNOPSIS:
+ *    static void Bench_AddTUIFrame(std::vector<uint8_t> &Data,
+ *              unsigned int Frame);
+ *
+ * PARAMETERS:
+ *    Data [I/O] -- The data to add the frame to
+ *    Frame [I] -- The frame number
+ *
+ * FUNCTION:
+ *    This function adds one full screen redraw.  Even frames look like htop
+ *    (meters, then a table of processes with colored columns), odd frames
+ *    look like vim (line numbers, syntax colors, status line).  The escape
+ *    sequences are the ones the xterm-256color terminfo has these apps send.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Bench_BuildPattern()
+ ******************************************************************************/
+static void Bench_AddTUIFrame(std::vector<uint8_t> &Data,unsigned int Frame)
+{
+    char buff[200];
+    unsigned int Row;
+    unsigned int r;
+    unsigned int Bar;
+    const char *Code;
+
+    Bench_AddStr(Data,"\33[?25l");
+    if(Frame%2==0)
+    {
+        /* htop */
+        Bench_AddStr(Data,"\33]0;htop\7\33[H");
+        for(Row=0;Row<4;Row++)
+        {
+            Bar=(Frame*7+Row*13)%40;
+            sprintf(buff,"\33[%d;3H\33[1m\33[36m%d\33(B\33[m\33[1m[",Row+1,
+                    Row);
+            Bench_AddStr(Data,buff);
+            Bench_AddStr(Data,"\33[32m");
+            for(r=0;r<40;r++)
+                Data.push_back(r<Bar?'|':' ');
+            sprintf(buff,"\33[38;5;%dm%3d.%d%%\33(B\33[m\33[1m]\33(B\33[m",
+                    245,Bar*2,Row);
+            Bench_AddStr(Data,buff);
+        }
+        Bench_AddStr(Data,"\33[6;1H\33[30m\33[42m    PID USER      PRI  NI  "
+                "VIRT   RES   SHR S CPU% MEM%   TIME+  Command\33[K");
+        for(Row=6;Row<BENCH_TUI_ROWS;Row++)
+        {
+            sprintf(buff,"\33[%d;1H\33(B\33[m\33[38;5;%dm%7d \33(B\33[m"
+                    "root      \33[36m 20 \33[39m  0 ",Row+1,
+                    (Frame+Row)%2?245:255,1000+Row*37+Frame);
+            Bench_AddStr(Data,buff);
+            sprintf(buff,"\33[36m%4dM\33[39m %5d %5d S %4.1f  0.%d  "
+                    "0:%02d.%02d \33[1m/usr/bin/app\33(B\33[m "
+                    "--option=%d\33[K",Row*11,Row*300,Row*100,
+                    ((Frame+Row)%100)/10.0,Row%10,Row,Frame%60,Row);
+            Bench_AddStr(Data,buff);
+        }
+    }
+    else
+    {
+        /* vim */
+        Bench_AddStr(Data,"\33]0;main.cpp - VIM\7\33[?2004h\33[H");
+        for(Row=0;Row<BENCH_TUI_ROWS-1;Row++)
+        {
+            Code=m_TUICodeLines[(Row+Frame)%(sizeof(m_TUICodeLines)/
+                    sizeof(m_TUICodeLines[0]))];
+            sprintf(buff,"\33[%d;1H\33[33m%4d \33(B\33[m",Row+1,
+                    Row+Frame);
+            Bench_AddStr(Data,buff);
+            if(strncmp(Code,"    ",4)==0)
+            {
+                Bench_AddStr(Data,"    \33[38;5;130m");
+                Code+=4;
+            }
+            Bench_AddStr(Data,Code);
+            Bench_AddStr(Data,"\33(B\33[m\33[K");
+        }
+        sprintf(buff,"\33[%d;1H\33[1m-- INSERT --\33(B\33[m\33[%d;63H"
+                "%d,5-9%10s\33[%d;10H",BENCH_TUI_ROWS,BENCH_TUI_ROWS,Frame,
+                "All",Frame%BENCH_TUI_ROWS+1);
+        Bench_AddStr(Data,buff);
+    }
+    Bench_AddStr(Data,"\33[?12l\33[?25h");
+}
+
+static void Bench_AddStr(std::vector<uint8_t> &Data,const char *Str)
+{
+    Data.insert(Data.end(),(const uint8_t *)Str,(const uint8_t *)Str+strlen(Str));
+}
+
+static void Bench_AddUTF8(std::vector<uint8_t> &Data,uint32_t CodePoint)
+{
+    if(CodePoint<0x80)
+    {
+        Data.push_back(CodePoint);
+    }
+    else if(CodePoint<0x800)
+    {
+        Data.push_back(0xC0|(CodePoint>>6));
+        Data.push_back(0x80|(CodePoint&0x3F));
+    }
+    else
+    {
+        Data.push_back(0xE0|(CodePoint>>12));
+        Data.push_back(0x80|((CodePoint>>6)&0x3F));
+        Data.push_back(0x80|(CodePoint&0x3F));
+    }
+}
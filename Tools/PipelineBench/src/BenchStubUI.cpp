@@ -0,0 +1,277 @@
+/*******************************************************************************
+ * FILENAME: BenchStubUI.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file is a do nothing UI layer for the pipeline bench.  It has the
+ *    parts of the UI/ API that the displays, data processors and settings
+ *    use.  Everything is a no-op except the text canvas measuring functions
+ *    (a fixed 8x16 cell) and a few counters so the bench can report how
+ *    much drawing work the display did.
+ *
+ *    It also has the App side functions (main window, plugin system, etc)
+ *    that the linked files call but the bench doesn't have.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "PipelineBench.h"
+#include "App/Dialogs/Dialog_AddBookmark.h"
+#include "App/Dialogs/Dialog_EditSendBuffer.h"
+#include "App/Dialogs/Dialog_ManBookmark.h"
+#include "App/Connections.h"
+#include "App/PluginSupport/PluginSystem.h"
+#include "App/PluginSupport/PluginUISupport.h"
+#include "App/CursorKeyMode.h"
+#include "App/IOSystem.h"
+#include "App/Portable.h"
+#include "App/VersionCheckSystem.h"
+#include "UI/UIAsk.h"
+#include "UI/UIClipboard.h"
+#include "UI/UIControl.h"
+#include "UI/UICustomTextWidget.h"
+#include "UI/UIDebug.h"
+#include "UI/UIFontReq.h"
+#include "UI/UISystem.h"
+#include "UI/UITextMainArea.h"
+#include "UI/UITimers.h"
+#include "ThirdParty/utf8.h"
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <vector>
+
+/*** DEFINES                  ***/
+#define BENCH_CHAR_WIDTH                8
+#define BENCH_CHAR_HEIGHT               16
+#define BENCH_SCREEN_COLUMNS            80
+#define BENCH_SCREEN_ROWS               24
+
+/*** MACROS                   ***/
+/* Every UI handle is opaque to the App so they can all point at the same
+   dummy object */
+#define BENCH_HANDLE(Type)              ((Type *)&m_BenchDummyHandle)
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+void MW_ApplySettings(void);
+
+/*** VARIABLE DEFINITIONS     ***/
+struct BenchUIStats g_BenchUIStats;
+static uint64_t m_BenchDummyHandle[16];
+static std::vector<uint32_t> m_BenchRowGenerations;  // Like the canvas keeps per line
+
+/* Text canvas */
+t_UITextDisplayCtrl *UITC_AllocTextDisplay(void *ParentWidget,
+        bool (*EventHandler)(const struct TextDisplayEvent *Event),uintptr_t ID)
+{
+    return BENCH_HANDLE(t_UITextDisplayCtrl);
+}
+
+void UITC_FreeTextDisplay(t_UITextDisplayCtrl *ctrl) {}
+void UITC_Reparent(t_UITextDisplayCtrl *ctrl,void *NewParentWidget) {}
+void UITC_ShowBlockSendPanel(t_UITextDisplayCtrl *ctrl,bool Visible) {}
+void UITC_ShowTextLineSendPanel(t_UITextDisplayCtrl *ctrl,bool Visible) {}
+void UITC_SendPanelShowHexOrTextInput(t_UITextDisplayCtrl *ctrl,bool ShowText) {}
+void UITC_SetCursorBlinking(t_UITextDisplayCtrl *ctrl,bool Blinking) {}
+void UITC_SetCursorPos(t_UITextDisplayCtrl *ctrl,unsigned int x,unsigned int y) {}
+void UITC_SetFocus(t_UITextDisplayCtrl *ctrl,e_UITCSetFocusType What) {}
+t_UIScrollBarCtrl *UITC_GetHorzSlider(t_UITextDisplayColumn *Handle) {return BENCH_HANDLE(t_UIScrollBarCtrl);}
+t_UIScrollBarCtrl *UITC_GetVertSlider(t_UITextDisplayCtrl *ctrl) {return BENCH_HANDLE(t_UIScrollBarCtrl);}
+t_UIContextMenuCtrl *UITC_GetContextMenuHandle(t_UITextDisplayCtrl *ctrl,e_UITD_ContextMenuType UIObj) {return BENCH_HANDLE(t_UIContextMenuCtrl);}
+t_UIContextSubMenuCtrl *UITC_GetContextSubMenuHandle(t_UITextDisplayCtrl *ctrl,e_UITD_ContextSubMenuType UIObj) {return BENCH_HANDLE(t_UIContextSubMenuCtrl);}
+t_UIFrameContainerCtrl *UITC_GetSendHexDisplayContainerFrameCtrlHandle(t_UITextDisplayCtrl *ctrl) {return BENCH_HANDLE(t_UIFrameContainerCtrl);}
+t_UITextInputCtrl *UITC_GetTextInputHandle(t_UITextDisplayCtrl *ctrl,e_UITC_TxtType Txt) {return BENCH_HANDLE(t_UITextInputCtrl);}
+t_UIRadioBttnCtrl *UITC_GetRadioButton(t_UITextDisplayCtrl *ctrl,e_UITC_RadioButtonType bttn) {return BENCH_HANDLE(t_UIRadioBttnCtrl);}
+t_UIComboBoxCtrl *UITC_GetComboBoxHandle(t_UITextDisplayCtrl *ctrl,e_UITC_ComboxType UIObj) {return BENCH_HANDLE(t_UIComboBoxCtrl);}
+t_UIMuliLineTextInputCtrl *UITC_GetMuliLineTextInputHandle(t_UITextDisplayCtrl *ctrl,e_UITC_MuliTxtType Txt) {return BENCH_HANDLE(t_UIMuliLineTextInputCtrl);}
+t_UITextDisplayColumn *UITC_GetTextDisplayPrimaryColumn(t_UITextDisplayCtrl *ctrl) {return BENCH_HANDLE(t_UITextDisplayColumn);}
+
+int UITC_GetFragWidth(t_UITextDisplayColumn *Handle,const struct TextCanvasFrag *Frag)
+{
+    switch(Frag->FragType)
+    {
+        case e_TextCanvasFrag_String:
+        case e_TextCanvasFrag_NonPrintableChar:
+        case e_TextCanvasFrag_RetText:
+            return utf8::unchecked::distance(Frag->Text,
+                    Frag->Text+strlen(Frag->Text))*BENCH_CHAR_WIDTH;
+        case e_TextCanvasFrag_SoftRet:
+        case e_TextCanvasFrag_HardRet:
+            return BENCH_CHAR_WIDTH;
+        case e_TextCanvasFrag_HR:
+        case e_TextCanvasFragMAX:
+        default:
+        break;
+    }
+    return 0;
+}
+
+int UITC_GetWidgetWidth(t_UITextDisplayColumn *Handle) {return BENCH_SCREEN_COLUMNS*BENCH_CHAR_WIDTH;}
+int UITC_GetCharPxHeight(t_UITextDisplayColumn *Handle) {return BENCH_CHAR_HEIGHT;}
+int UITC_GetCharPxWidth(t_UITextDisplayColumn *Handle) {return BENCH_CHAR_WIDTH;}
+int UITC_GetWidgetHeight(t_UITextDisplayCtrl *ctrl) {return BENCH_SCREEN_ROWS*BENCH_CHAR_HEIGHT;}
+void UITC_SetFont(t_UITextDisplayColumn *Handle,const char *FontName,int Size,bool Bold,bool Italic) {}
+void UITC_SetCursorColor(t_UITextDisplayCtrl *ctrl,uint32_t Color) {}
+void UITC_SetCursorStyle(t_UITextDisplayCtrl *ctrl,e_TextCursorStyleType Style) {}
+void UITC_SetClippingWindow(t_UITextDisplayColumn *Handle,int LeftEdge,int TopEdge,int Width,int Height) {}
+void UITC_SetTextAreaBackgroundColor(t_UITextDisplayColumn *Handle,uint32_t BgColor) {}
+void UITC_SetTextDefaultColor(t_UITextDisplayColumn *Handle,uint32_t FgColor) {}
+void UITC_SetOverrideMsg(t_UITextDisplayCtrl *ctrl,const char *Msg,bool OnOff) {}
+void UITC_SetInfoMsg(t_UITextDisplayCtrl *ctrl,const char *Msg,uint32_t BG,uint32_t FG,e_UITCIM_PosType Pos,bool OnOff) {}
+void UITC_ClearAllLines(t_UITextDisplayColumn *Handle) {}
+void UITC_Begin(t_UITextDisplayColumn *Handle,int Line) {g_BenchUIStats.LinesDrawn++;}
+void UITC_End(t_UITextDisplayColumn *Handle) {}
+void UITC_ClearLine(t_UITextDisplayColumn *Handle,uint32_t BGColor) {}
+void UITC_AddFragment(t_UITextDisplayColumn *Handle,const struct TextCanvasFrag *Frag) {g_BenchUIStats.FragsAdded++;}
+void UITC_SetXOffset(t_UITextDisplayColumn *Handle,int XOffsetPx) {}
+void UITC_SetMaxLines(t_UITextDisplayColumn *Handle,int MaxLines,uint32_t BGColor) {}
+void UITC_ScrollLines(t_UITextDisplayColumn *Handle,int Lines)
+{
+    g_BenchUIStats.CanvasScrolls++;
+    if(Lines>0 && (unsigned int)Lines<m_BenchRowGenerations.size())
+    {
+        std::rotate(m_BenchRowGenerations.begin(),
+                m_BenchRowGenerations.begin()+Lines,
+                m_BenchRowGenerations.end());
+    }
+}
+void UITC_SetLine(t_UITextDisplayColumn *Handle,int Line,t_TextCanvasLineRef Snapshot)
+{
+    if((unsigned int)Line>=m_BenchRowGenerations.size())
+        m_BenchRowGenerations.resize(Line+1,0);
+
+    /* The canvas only converts lines it doesn't already have */
+    if(m_BenchRowGenerations[Line]==Snapshot->Generation)
+    {
+        g_BenchUIStats.LinesReused++;
+        return;
+    }
+    m_BenchRowGenerations[Line]=Snapshot->Generation;
+    g_BenchUIStats.LinesDrawn++;
+    g_BenchUIStats.FragsAdded+=Snapshot->Runs.size();
+}
+void UITC_RedrawScreen(t_UITextDisplayColumn *Handle) {g_BenchUIStats.FullRedraws++;}
+void UITC_SetDrawMask(t_UITextDisplayColumn *Handle,uint16_t Mask) {}
+void UITC_ClearGraphics(t_UITextDisplayColumn *Handle) {}
+void UITC_AddGraphicLine(t_UITextDisplayColumn *Handle,int x,int y,int x2,int y2,uint32_t Color) {}
+void UITC_SetLineWidth(t_UITextDisplayColumn *Handle,unsigned int LineWidth) {}
+void UITC_ShowBellIcon(t_UITextDisplayCtrl *ctrl) {}
+void UITC_SetMouseCursor(t_UITextDisplayColumn *Handle,e_UIMouse_CursorType Cursor) {}
+
+/* Custom text widget (hex displays) */
+t_UICustomTextWidgetCtrl *UICTW_AllocCustomTextWidget(
+        t_UIFrameContainerCtrl *ParentWidget,
+        bool (*EventHandler)(const struct UICTWEvent *Event),uintptr_t ID)
+{
+    return BENCH_HANDLE(t_UICustomTextWidgetCtrl);
+}
+
+void UICTW_FreeCustomTextWidget(t_UICustomTextWidgetCtrl *ctrl) {}
+void UICTW_SetCursorPos(t_UICustomTextWidgetCtrl *ctrl,unsigned int x,unsigned int y) {}
+void UICTW_SetFocus(t_UICustomTextWidgetCtrl *ctrl) {}
+t_UIScrollBarCtrl *UICTW_GetHorzSlider(t_UICustomTextWidgetCtrl *ctrl) {return BENCH_HANDLE(t_UIScrollBarCtrl);}
+t_UIScrollBarCtrl *UICTW_GetVertSlider(t_UICustomTextWidgetCtrl *ctrl) {return BENCH_HANDLE(t_UIScrollBarCtrl);}
+t_UIContextMenuCtrl *UICTW_GetContextMenuHandle(t_UICustomTextWidgetCtrl *ctrl,e_UICTW_ContextMenuType UIObj) {return BENCH_HANDLE(t_UIContextMenuCtrl);}
+int UICTW_GetCharPxHeight(t_UICustomTextWidgetCtrl *ctrl) {return BENCH_CHAR_HEIGHT;}
+int UICTW_GetCharPxWidth(t_UICustomTextWidgetCtrl *ctrl) {return BENCH_CHAR_WIDTH;}
+void UICTW_SetFont(t_UICustomTextWidgetCtrl *ctrl,const char *FontName,int Size,bool Bold,bool Italic) {}
+void UICTW_SetCursorColor(t_UICustomTextWidgetCtrl *ctrl,uint32_t Color) {}
+void UICTW_SetCursorStyle(t_UICustomTextWidgetCtrl *ctrl,e_TextCursorStyleType Style) {}
+void UICTW_SetClippingWindow(t_UICustomTextWidgetCtrl *ctrl,int LeftEdge,int TopEdge,int Width,int Height) {}
+void UICTW_SetTextAreaBackgroundColor(t_UICustomTextWidgetCtrl *ctrl,uint32_t BgColor) {}
+void UICTW_SetTextDefaultColor(t_UICustomTextWidgetCtrl *ctrl,uint32_t FgColor) {}
+void UICTW_ClearAllLines(t_UICustomTextWidgetCtrl *ctrl) {}
+void UICTW_Begin(t_UICustomTextWidgetCtrl *ctrl,int Line) {g_BenchUIStats.LinesDrawn++;}
+void UICTW_End(t_UICustomTextWidgetCtrl *ctrl) {}
+void UICTW_ClearLine(t_UICustomTextWidgetCtrl *ctrl,uint32_t BGColor) {}
+void UICTW_AddFragment(t_UICustomTextWidgetCtrl *ctrl,const struct TextCanvasFrag *Frag) {g_BenchUIStats.FragsAdded++;}
+void UICTW_SetXOffset(t_UICustomTextWidgetCtrl *ctrl,int XOffsetPx) {}
+void UICTW_RedrawScreen(t_UICustomTextWidgetCtrl *ctrl) {g_BenchUIStats.FullRedraws++;}
+void UICTW_ClearGraphics(t_UICustomTextWidgetCtrl *ctrl) {}
+void UICTW_AddGraphicLine(t_UICustomTextWidgetCtrl *ctrl,int x,int y,int x2,int y2,uint32_t Color) {}
+void UICTW_SetLineWidth(t_UICustomTextWidgetCtrl *ctrl,unsigned int LineWidth) {}
+
+/* Controls */
+void UISetContextMenuVisible(t_UIContextMenuCtrl *Menu,bool Show) {}
+void UIEnableComboBox(t_UIComboBoxCtrl *ComboBox,bool Enable) {}
+void UIClearComboBox(t_UIComboBoxCtrl *ComboBox) {}
+void UIAddItem2ComboBox(t_UIComboBoxCtrl *ComboBox,const std::string &Label,uintptr_t ID) {}
+void UIGetComboBoxList(t_UIComboBoxCtrl *ComboBox,t_ComboBoxItemListType &List) {List.clear();}
+void UISetComboBoxSelectedIndex(t_UIComboBoxCtrl *ComboBox,int Index) {}
+int UIGetComboBoxSelectedIndex(t_UIComboBoxCtrl *ComboBox) {return -1;}
+int UIGetComboBoxEntryCount(t_UIComboBoxCtrl *ComboBox) {return 0;}
+void UIGetComboBoxItemLabel(t_UIComboBoxCtrl *ComboBox,int Index,std::string &Label) {Label="";}
+void UIGetComboBoxText(t_UIComboBoxCtrl *ComboBox,std::string &Text) {Text="";}
+void UISetComboBoxText(t_UIComboBoxCtrl *ComboBox,const char *Text) {}
+int UIGetScrollBarPos(t_UIScrollBarCtrl *ScrollBarCtrl) {return 0;}
+void UISetScrollBarPos(t_UIScrollBarCtrl *ScrollBarCtrl,int NewPos) {}
+void UISetScrollBarPageSizeAndMax(t_UIScrollBarCtrl *ScrollBarCtrl,int PageSize,int Max) {}
+int UIGetScrollBarTotalSize(t_UIScrollBarCtrl *ScrollBarCtrl) {return 0;}
+void UISetScrollBarStepSize(t_UIScrollBarCtrl *ScrollBarCtrl,int StepSize) {}
+void UISelectRadioBttn(t_UIRadioBttnCtrl *RadioBttn) {}
+bool UIIsRadioBttnSelected(t_UIRadioBttnCtrl *RadioBttn) {return false;}
+void UIUnselectRadioBttn(t_UIRadioBttnCtrl *RadioBttn) {}
+void UISetTextCtrlText(t_UITextInputCtrl *TextInput,const char *Text) {}
+void UIGetMuliLineTextCtrlText(t_UIMuliLineTextInputCtrl *TextInput,std::string &Text) {Text="";}
+
+/* Timers (the bench never runs an event loop so they never fire) */
+struct UITimer *AllocUITimer(void) {return BENCH_HANDLE(struct UITimer);}
+void FreeUITimer(struct UITimer *Timer) {}
+void SetupUITimer(struct UITimer *Timer,void (*Timeout)(uintptr_t UserData),uintptr_t UserData,bool Repeats) {}
+void UITimerSetTimeout(struct UITimer *Timer,uint32_t ms) {}
+void UITimerStart(struct UITimer *Timer) {}
+void UITimerStop(struct UITimer *Timer) {}
+bool UITimerRunning(struct UITimer *Timer) {return false;}
+
+/* System */
+e_AskRetType UIAsk(const char *Title,const char *Msg,e_AskBoxType BoxType,e_AskBttnsType Buttons) {return e_AskRet_Ok;}
+e_AskRetType UIAsk(const char *Title,const std::string &Msg,e_AskBoxType BoxType,e_AskBttnsType Buttons) {return e_AskRet_Ok;}
+void UI_SetClipboardTextCStr(const char *Text,e_ClipboardType Clip) {}
+void UI_GetClipboardText(std::string &Text,e_ClipboardType Clip) {Text="";}
+void UI_GetDefaultFixedWidthFont(std::string &FontName) {FontName="Monospace";}
+void UI_ProcessAllPendingUIEvents(void) {}
+int caseinsensitivestrcmp(const char *a,const char *b) {return strcasecmp(a,b);}
+void DB_StartTimer(e_DBTType Timer) {}
+void DB_StopTimer(e_DBTType Timer) {}
+
+/* App functions the linked files call */
+bool RunEditSendBufferDialog(int BufferNumber,uint8_t **CustomBuffer,int *CustomBufferSize) {return false;}
+bool RunAddBookmarkDialog(struct Bookmark &BookmarkInfo) {return false;}
+bool RunManBookmarkDialog(t_BookmarkList &EditList) {return false;}
+void Connection::Connect2Bookmark(int BookmarkUID) {}
+bool Connection::GetConnectionOptions(t_KVList &Options) {return false;}
+void Connection::GetDisplayName(std::string &Name) {Name="";}
+bool Connection::GetURI(std::string &URI) {return false;}
+void RegisterPluginWithSystem(const char *IDStr) {}
+void UnRegisterPluginWithSystem(const char *IDStr) {}
+void NotePluginInUse(const char *IDStr) {}
+void UnNotePluginInUse(const char *IDStr) {}
+const struct PI_UIAPI *PIUSDefault_GetDefaultAPI(void) {return NULL;}
+bool GetAppDataPath(std::string &AppPath) {AppPath="/tmp/";return true;}
+void CursorKeyMode_ApplySettings(void) {}
+void IOS_ApplySettings(void) {}
+void MW_ApplySettings(void) {}
+void NewVersionCheck_ApplySettings(void) {}
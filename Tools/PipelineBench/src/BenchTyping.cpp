@@ -0,0 +1,221 @@
+/*******************************************************************************
+ * FILENAME: BenchTyping.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file times typing into the active line of a text display that
+ *    has a big scroll back buffer behind it.  Every char typed changes the
+ *    width of the active line so this shows what keeping the longest line
+ *    up to date costs.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "PipelineBench.h"
+#include "App/DataProcessorsSystem.h"
+#include "App/Display/DisplayText.h"
+#include "App/Settings.h"
+#include "OS/OSTime.h"
+#include <stdio.h>
+#include <string.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define BENCH_TYPE_CHARS                    20000
+#define BENCH_TYPE_LINE_LEN                 60      // Type this many chars and then hit enter
+#define BENCH_FILL_CHUNK                    (64*1024)
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+static bool Bench_TypingDisplayEvent(const struct DBEvent *Event);
+static void Bench_TypingReport(const char *Stage,uint64_t ns,uint64_t Allocs,
+        unsigned int Count,const char *Units);
+
+/*** VARIABLE DEFINITIONS     ***/
+static uint8_t m_BenchTypingParentWidget[16];
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_TypeIntoScrollBack
+ *
+ * SYNOPSIS:
+ *    bool Bench_TypeIntoScrollBack(unsigned int ScrollBackLines);
+ *
+ * PARAMETERS:
+ *    ScrollBackLines [I] -- How many lines of scroll back to fill before
+ *                           typing
+ *
+ * FUNCTION:
+ *    This function makes a text display with a 'ScrollBackLines' scroll back
+ *    buffer, fills it (with one extra long line at the top so the line being
+ *    typed into is never the longest), and then times typing one char at a
+ *    time into the active line.  Every so often it hits enter so the
+ *    typing also pushes lines out of the full scroll back buffer.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error setting up
+ *
+ * SEE ALSO:
+ *    Bench_BookmarkFile()
+ ******************************************************************************/
+bool Bench_TypeIntoScrollBack(unsigned int ScrollBackLines)
+{
+    class ConSettings Settings;
+    struct ProcessorConData FData;
+    class DisplayText *Display;
+    std::vector<uint8_t> Fill;
+    uint64_t StartTime;
+    uint64_t StartAllocs;
+    uint64_t ns;
+    uint64_t Allocs;
+    unsigned int r;
+    size_t Pos;
+    size_t Len;
+    uint8_t Chr;
+    char buff[100];
+    bool RetValue;
+
+    Settings=g_Settings.DefaultConSettings;
+    Settings.ScrollBufferLines=ScrollBackLines;
+
+    /* One long line so the typed line is never the longest */
+    memset(buff,'#',sizeof(buff)-3);
+    buff[sizeof(buff)-3]='\r';
+    buff[sizeof(buff)-2]='\n';
+    Fill.insert(Fill.end(),buff,buff+sizeof(buff)-1);
+    for(r=0;r<ScrollBackLines;r++)
+    {
+        Len=sprintf(buff,"Scroll back line %u\r\n",r);
+        Fill.insert(Fill.end(),buff,buff+Len);
+    }
+
+    Display=NULL;
+    RetValue=false;
+    FData.Settings=NULL;
+    try
+    {
+        if(!DPS_AllocProcessorConData(&FData,&Settings))
+            throw(0);
+
+        Display=new DisplayText();
+        if(!Display->Init(m_BenchTypingParentWidget,&Settings,
+                Bench_TypingDisplayEvent,0))
+        {
+            throw(0);
+        }
+
+        BenchCon_SetDisplay(Display,&Settings);
+
+        StartAllocs=g_BenchAllocCount;
+        StartTime=GetElapsedTime_ns();
+        for(Pos=0;Pos<Fill.size();Pos+=Len)
+        {
+            Len=Fill.size()-Pos;
+            if(Len>BENCH_FILL_CHUNK)
+                Len=BENCH_FILL_CHUNK;
+            DPS_ProcessorIncomingBytes(&FData,&Fill[Pos],Len,false,false);
+        }
+        ns=GetElapsedTime_ns()-StartTime;
+        Allocs=g_BenchAllocCount-StartAllocs;
+        Bench_TypingReport("fill",ns,Allocs,ScrollBackLines,"line");
+
+        StartAllocs=g_BenchAllocCount;
+        StartTime=GetElapsedTime_ns();
+        for(r=0;r<BENCH_TYPE_CHARS;r++)
+        {
+            if(r%BENCH_TYPE_LINE_LEN==BENCH_TYPE_LINE_LEN-1)
+            {
+                DPS_ProcessorIncomingBytes(&FData,(uint8_t *)"\r\n",2,false,
+                        false);
+            }
+            else
+            {
+                Chr='a'+r%26;
+                DPS_ProcessorIncomingBytes(&FData,&Chr,1,false,false);
+            }
+        }
+        ns=GetElapsedTime_ns()-StartTime;
+        Allocs=g_BenchAllocCount-StartAllocs;
+        Bench_TypingReport("type",ns,Allocs,BENCH_TYPE_CHARS,"char");
+
+        RetValue=true;
+    }
+    catch(...)
+    {
+        fprintf(stderr,"Failed to setup the typing bench\n");
+    }
+
+    BenchCon_SetDisplay(NULL,&g_Settings.DefaultConSettings);
+    if(Display!=NULL)
+        delete Display;
+    if(FData.Settings!=NULL)
+        DPS_FreeProcessorConData(&FData);
+
+    return RetValue;
+}
+
+static bool Bench_TypingDisplayEvent(const struct DBEvent *Event)
+{
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_TypingReport
+ *
+ * SYNOPSIS:
+ *    static void Bench_TypingReport(const char *Stage,uint64_t ns,
+ *              uint64_t Allocs,unsigned int Count,const char *Units);
+ *
+ * PARAMETERS:
+ *    Stage [I] -- The name of what was timed
+ *    ns [I] -- How long it took
+ *    Allocs [I] -- How many allocations where made
+ *    Count [I] -- How many lines / chars where added
+ *    Units [I] -- What 'Count' is counting (singular)
+ *
+ * FUNCTION:
+ *    This function prints a line of the report for the typing bench.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Bench_TypeIntoScrollBack()
+ ******************************************************************************/
+static void Bench_TypingReport(const char *Stage,uint64_t ns,uint64_t Allocs,
+        unsigned int Count,const char *Units)
+{
+    if(Count<1)
+        Count=1;
+
+    printf("%-12s %-11s %10s %10.1f %10.2f  (ns and allocs per %s, %u %ss, "
+            "%.1f ms)\n","typing",Stage,"",(double)ns/Count,
+            (double)Allocs/Count,Units,Count,Units,ns/1000000.0);
+}
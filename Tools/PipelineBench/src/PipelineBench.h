@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * FILENAME: PipelineBench.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This has the shared defines for the headless pipeline benchmark.  The
+ *    bench links the real App data processors and displays against a stub
+ *    UI layer so the receive path can be timed without Qt.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __PIPELINEBENCH_H_
+#define __PIPELINEBENCH_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/***  DEFINES                          ***/
+
+/***  MACROS                           ***/
+
+/***  TYPE DEFINITIONS                 ***/
+typedef enum
+{
+    e_BenchPattern_PlainText,
+    e_BenchPattern_DenseSGR,
+    e_BenchPattern_UTF8Heavy,
+    e_BenchPattern_Binary,
+    e_BenchPattern_TUI,
+    e_BenchPattern_ScrollRegion,
+    e_BenchPattern_TrueColor,
+    e_BenchPatternMAX
+} e_BenchPatternType;
+
+struct BenchUIStats
+{
+    uint64_t FragsAdded;
+    uint64_t LinesDrawn;
+    uint64_t FullRedraws;
+    uint64_t CanvasScrolls;
+    uint64_t LinesReused;
+};
+
+/***  CLASS DEFINITIONS                ***/
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+extern struct BenchUIStats g_BenchUIStats;
+extern uint64_t g_BenchAllocCount;
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+/* BenchPatterns.cpp */
+const char *Bench_GetPatternName(e_BenchPatternType Pattern);
+bool Bench_IsPatternBinary(e_BenchPatternType Pattern);
+void Bench_BuildPattern(e_BenchPatternType Pattern,unsigned int Bytes,
+        std::vector<uint8_t> &RetData);
+bool Bench_LoadCapture(const char *Filename,std::vector<uint8_t> &RetData);
+
+/* BenchCFG.cpp */
+bool Bench_BookmarkFile(unsigned int Count);
+
+/* BenchTyping.cpp */
+bool Bench_TypeIntoScrollBack(unsigned int ScrollBackLines);
+
+/* BenchConnection.cpp */
+void BenchCon_SetDisplay(class DisplayBase *Display,
+        class ConSettings *Settings);
+
+#endif
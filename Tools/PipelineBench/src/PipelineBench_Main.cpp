@@ -0,0 +1,574 @@
+/*******************************************************************************
+ * FILENAME: PipelineBench_Main.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This is a headless benchmark of the receive pipeline.  It registers the
+ *    built in data processors, makes a text (or binary) display on top of
+ *    a stub UI and then feeds a synthetic pattern (or a recorded capture)
+ *    though it in driver sized chunks.
+ *
+ *    Each stage is timed on it's own:
+ *       read -- Copying the data out in chunks (what a driver Read() does)
+ *       processors -- The data processors with the display output thrown
+ *                     away
+ *       pipeline -- The data processors and the display
+ *       display -- pipeline minus processors
+ *
+ *    For each stage it reports MB/s, ns/byte and allocations per KB.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "PipelineBench.h"
+#include "App/DataProcessorsSystem.h"
+#include "App/Display/DisplayBinary.h"
+#include "App/Display/DisplayText.h"
+#include "App/PluginSupport/KeyValueSupport.h"
+#include "App/Settings.h"
+#include "PluginSDK/PluginSystem.h"
+#include "Version.h"
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define BENCH_DEFAULT_BYTES                 (1024*1024)
+#define BENCH_DEFAULT_CHUNK                 4096
+#define BENCH_DEFAULT_BOOKMARKS             10000
+#define BENCH_DEFAULT_SCROLLBACK            1000000
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+typedef enum
+{
+    e_BenchStage_Read,
+    e_BenchStage_Processors,
+    e_BenchStage_Pipeline,
+    e_BenchStageMAX
+} e_BenchStageType;
+
+struct BenchResult
+{
+    uint64_t ns;
+    uint64_t Allocs;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+extern "C"
+{
+    unsigned int UnicodeDecoder_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
+    unsigned int CodePage437Decode_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
+    unsigned int ANSIX3_64_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
+    unsigned int BasicCtrlCharsDecoder_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
+    unsigned int HexDumpDecoder_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
+
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t nmemb,size_t size);
+    void *__real_realloc(void *ptr,size_t size);
+    void *__wrap_malloc(size_t size);
+    void *__wrap_calloc(size_t nmemb,size_t size);
+    void *__wrap_realloc(void *ptr,size_t size);
+}
+static const struct DPS_API *Bench_GetAPI_DataProcessors(void);
+static uint32_t Bench_GetExperimentalID(void);
+static bool Bench_DisplayEvent(const struct DBEvent *Event);
+static void Bench_RegisterProcessors(void);
+static uint64_t Bench_GetNS(void);
+static bool Bench_RunStage(e_BenchStageType Stage,const std::vector<uint8_t> &Data,
+        unsigned int ChunkSize,bool Binary,struct BenchResult *Result);
+static void Bench_Run(const char *Name,const std::vector<uint8_t> &Data,
+        unsigned int ChunkSize,bool Binary);
+static void Bench_PrintStage(const char *Name,const struct BenchResult *Result,
+        uint64_t Bytes);
+static void Bench_Usage(void);
+
+/*** VARIABLE DEFINITIONS     ***/
+uint64_t g_BenchAllocCount;
+static uint8_t m_BenchParentWidget[16];
+
+static const struct PI_SystemAPI m_BenchSystemAPI=
+{
+    NULL,
+    Bench_GetAPI_DataProcessors,
+    NULL,
+    PI_KVClear,
+    PI_KVAddItem,
+    PI_KVGetItem,
+    Bench_GetExperimentalID,
+    NULL,
+};
+
+static const char *m_StageNames[e_BenchStageMAX]=
+{
+    "read",
+    "processors",
+    "pipeline",
+};
+
+/* Count every allocation the pipeline does.  operator new goes to
+   __real_malloc() so it isn't counted twice. */
+void *operator new(size_t size)
+{
+    void *Mem;
+
+    g_BenchAllocCount++;
+    Mem=__real_malloc(size!=0?size:1);
+    if(Mem==NULL)
+        throw std::bad_alloc();
+    return Mem;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void *ptr,size_t size) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void *ptr,size_t size) noexcept
+{
+    free(ptr);
+}
+
+void *__wrap_malloc(size_t size)
+{
+    g_BenchAllocCount++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb,size_t size)
+{
+    g_BenchAllocCount++;
+    return __real_calloc(nmemb,size);
+}
+
+void *__wrap_realloc(void *ptr,size_t size)
+{
+    g_BenchAllocCount++;
+    return __real_realloc(ptr,size);
+}
+
+int main(int argc,char *argv[])
+{
+    std::vector<uint8_t> Data;
+    unsigned int Bytes;
+    unsigned int ChunkSize;
+    unsigned int Bookmarks;
+    unsigned int ScrollBack;
+    bool RanOne;
+    bool CaptureIsBinary;
+    int arg;
+    int p;
+
+    Bytes=BENCH_DEFAULT_BYTES;
+    ChunkSize=BENCH_DEFAULT_CHUNK;
+    CaptureIsBinary=false;
+    RanOne=false;
+
+    /* Check for help before we print anything (the table header included) */
+    for(arg=1;arg<argc;arg++)
+    {
+        if(strcmp(argv[arg],"-h")==0 || strcmp(argv[arg],"--help")==0)
+        {
+            Bench_Usage();
+            return 0;
+        }
+    }
+
+    Bench_RegisterProcessors();
+
+    printf("%-12s %-11s %10s %10s %10s\n","input","stage","MB/s","ns/byte",
+            "allocs/KB");
+
+    for(arg=1;arg<argc;arg++)
+    {
+        if(strcmp(argv[arg],"-s")==0 && arg+1<argc)
+        {
+            Bytes=strtoul(argv[++arg],NULL,0);
+        }
+        else if(strcmp(argv[arg],"-c")==0 && arg+1<argc)
+        {
+            ChunkSize=strtoul(argv[++arg],NULL,0);
+            if(ChunkSize<1)
+                ChunkSize=1;
+        }
+        else if(strcmp(argv[arg],"-k")==0)
+        {
+            if(arg+1<argc && argv[arg+1][0]>='0' && argv[arg+1][0]<='9')
+                Bookmarks=strtoul(argv[++arg],NULL,0);
+            else
+                Bookmarks=BENCH_DEFAULT_BOOKMARKS;
+            if(!Bench_BookmarkFile(Bookmarks))
+                return 1;
+            RanOne=true;
+        }
+        else if(strcmp(argv[arg],"-t")==0)
+        {
+            if(arg+1<argc && argv[arg+1][0]>='0' && argv[arg+1][0]<='9')
+                ScrollBack=strtoul(argv[++arg],NULL,0);
+            else
+                ScrollBack=BENCH_DEFAULT_SCROLLBACK;
+            if(!Bench_TypeIntoScrollBack(ScrollBack))
+                return 1;
+            RanOne=true;
+        }
+        else if(strcmp(argv[arg],"-b")==0)
+        {
+            CaptureIsBinary=true;
+        }
+        else if(strcmp(argv[arg],"-f")==0 && arg+1<argc)
+        {
+            arg++;
+            if(!Bench_LoadCapture(argv[arg],Data))
+            {
+                fprintf(stderr,"Failed to load capture \"%s\"\n",argv[arg]);
+                return 1;
+            }
+            Bench_Run(argv[arg],Data,ChunkSize,CaptureIsBinary);
+            RanOne=true;
+        }
+        else
+        {
+            for(p=0;p<e_BenchPatternMAX;p++)
+                if(strcmp(argv[arg],Bench_GetPatternName((e_BenchPatternType)p))==0)
+                    break;
+            if(p==e_BenchPatternMAX)
+            {
+                fprintf(stderr,"Unknown pattern \"%s\"\n",argv[arg]);
+                Bench_Usage();
+                return 1;
+            }
+            Bench_BuildPattern((e_BenchPatternType)p,Bytes,Data);
+            Bench_Run(argv[arg],Data,ChunkSize,
+                    Bench_IsPatternBinary((e_BenchPatternType)p));
+            RanOne=true;
+        }
+    }
+
+    if(!RanOne)
+    {
+        /* Do all the patterns */
+        for(p=0;p<e_BenchPatternMAX;p++)
+        {
+            Bench_BuildPattern((e_BenchPatternType)p,Bytes,Data);
+            Bench_Run(Bench_GetPatternName((e_BenchPatternType)p),Data,
+                    ChunkSize,Bench_IsPatternBinary((e_BenchPatternType)p));
+        }
+    }
+
+    return 0;
+}
+
+static void Bench_Usage(void)
+{
+    int p;
+
+    printf("USAGE:\n");
+    printf("    PipelineBench [-s bytes] [-c chunk] [pattern...] [-b] [-f capture...]\n");
+    printf("                  [-k [bookmarks]] [-t [lines]]\n");
+    printf("\n");
+    printf("    -s -- How many bytes of pattern to generate (default %d)\n",
+            BENCH_DEFAULT_BYTES);
+    printf("    -c -- How many bytes to pass in each block (default %d)\n",
+            BENCH_DEFAULT_CHUNK);
+    printf("    -b -- Replay the following captures though a binary "
+            "(hex dump) connection\n");
+    printf("    -f -- Replay a raw capture file\n");
+    printf("    -k -- Save and load a bookmark file with this many bookmarks "
+            "(default %d)\n",BENCH_DEFAULT_BOOKMARKS);
+    printf("    -t -- Type into the active line with this many lines of scroll "
+            "back (default %d)\n",BENCH_DEFAULT_SCROLLBACK);
+    printf("\n");
+    printf("Patterns:");
+    for(p=0;p<e_BenchPatternMAX;p++)
+        printf(" %s",Bench_GetPatternName((e_BenchPatternType)p));
+    printf("\n");
+}
+
+static const struct DPS_API *Bench_GetAPI_DataProcessors(void)
+{
+    return &g_DPSAPI;
+}
+
+static uint32_t Bench_GetExperimentalID(void)
+{
+    return 0;
+}
+
+static bool Bench_DisplayEvent(const struct DBEvent *Event)
+{
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_RegisterProcessors
+ *
+ * SYNOPSIS:
+ *    static void Bench_RegisterProcessors(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function registers the std data processors (the same way
+ *    RegisterStdPlugins() does).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RegisterStdPlugins()
+ ******************************************************************************/
+static void Bench_RegisterProcessors(void)
+{
+    DPS_Init();
+
+    UnicodeDecoder_RegisterPlugin(&m_BenchSystemAPI,WHIPPYTERM_VERSION);
+    CodePage437Decode_RegisterPlugin(&m_BenchSystemAPI,WHIPPYTERM_VERSION);
+    ANSIX3_64_RegisterPlugin(&m_BenchSystemAPI,WHIPPYTERM_VERSION);
+    BasicCtrlCharsDecoder_RegisterPlugin(&m_BenchSystemAPI,WHIPPYTERM_VERSION);
+    HexDumpDecoder_RegisterPlugin(&m_BenchSystemAPI,WHIPPYTERM_VERSION);
+}
+
+static uint64_t Bench_GetNS(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_RunStage
+ *
+ * SYNOPSIS:
+ *    static bool Bench_RunStage(e_BenchStageType Stage,
+ *              const std::vector<uint8_t> &Data,unsigned int ChunkSize,
+ *              bool Binary,struct BenchResult *Result);
+ *
+ * PARAMETERS:
+ *    Stage [I] -- What part of the pipeline to time
+ *    Data [I] -- The bytes to feed in
+ *    ChunkSize [I] -- How many bytes to feed in at a time
+ *    Binary [I] -- Use a binary (hex dump) connection instead of a text one
+ *    Result [O] -- How long it took and how many allocations where made
+ *
+ * FUNCTION:
+ *    This function sets up a fresh connection (data processors and
+ *    display) and times feeding 'Data' though it.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error setting up
+ *
+ * SEE ALSO:
+ *    Bench_Run()
+ ******************************************************************************/
+static bool Bench_RunStage(e_BenchStageType Stage,const std::vector<uint8_t> &Data,
+        unsigned int ChunkSize,bool Binary,struct BenchResult *Result)
+{
+    class ConSettings Settings;
+    struct ProcessorConData FData;
+    class DisplayBase *Display;
+    std::vector<uint8_t> ReadBuff;
+    uint64_t StartTime;
+    uint64_t StartAllocs;
+    size_t Pos;
+    size_t Len;
+    bool RetValue;
+
+    Settings=g_Settings.DefaultConSettings;
+    if(Binary)
+    {
+        Settings.DataProcessorType=e_DataProcessorType_Binary;
+        Settings.EnabledBinaryDataProcessors.clear();
+        Settings.EnabledBinaryDataProcessors.push_back("BasicHexDecoder");
+    }
+
+    Display=NULL;
+    RetValue=false;
+    FData.Settings=NULL;
+    ReadBuff.resize(ChunkSize);
+    try
+    {
+        if(!DPS_AllocProcessorConData(&FData,&Settings))
+            throw(0);
+
+        if(Stage==e_BenchStage_Pipeline)
+        {
+            if(Binary)
+                Display=new DisplayBinary();
+            else
+                Display=new DisplayText();
+
+            if(!Display->Init(m_BenchParentWidget,&Settings,Bench_DisplayEvent,
+                    0))
+            {
+                throw(0);
+            }
+        }
+
+        BenchCon_SetDisplay(Display,&Settings);
+
+        memset(&g_BenchUIStats,0x00,sizeof(g_BenchUIStats));
+        StartAllocs=g_BenchAllocCount;
+        StartTime=Bench_GetNS();
+
+        for(Pos=0;Pos<Data.size();Pos+=Len)
+        {
+            Len=Data.size()-Pos;
+            if(Len>ChunkSize)
+                Len=ChunkSize;
+
+            /* The driver copies the data into the IO system's buffer */
+            memcpy(ReadBuff.data(),&Data[Pos],Len);
+
+            if(Stage==e_BenchStage_Read)
+                continue;
+
+            DPS_ProcessorIncomingBytes(&FData,ReadBuff.data(),Len,false,false);
+        }
+
+        Result->ns=Bench_GetNS()-StartTime;
+        Result->Allocs=g_BenchAllocCount-StartAllocs;
+
+        RetValue=true;
+    }
+    catch(...)
+    {
+        fprintf(stderr,"Failed to setup the %s stage\n",m_StageNames[Stage]);
+    }
+
+    BenchCon_SetDisplay(NULL,&g_Settings.DefaultConSettings);
+    if(Display!=NULL)
+        delete Display;
+    if(FData.Settings!=NULL)
+        DPS_FreeProcessorConData(&FData);
+
+    return RetValue;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Run
+ *
+ * SYNOPSIS:
+ *    static void Bench_Run(const char *Name,const std::vector<uint8_t> &Data,
+ *              unsigned int ChunkSize,bool Binary);
+ *
+ * PARAMETERS:
+ *    Name [I] -- The name to print for this input
+ *    Data [I] -- The bytes to feed in
+ *    ChunkSize [I] -- How many bytes to feed in at a time
+ *    Binary [I] -- Use a binary (hex dump) connection instead of a text one
+ *
+ * FUNCTION:
+ *    This function runs all the stages on one input and prints the results.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Bench_RunStage()
+ ******************************************************************************/
+static void Bench_Run(const char *Name,const std::vector<uint8_t> &Data,
+        unsigned int ChunkSize,bool Binary)
+{
+    struct BenchResult Results[e_BenchStageMAX];
+    struct BenchResult Display;
+    int s;
+
+    if(Data.empty())
+        return;
+
+    for(s=0;s<e_BenchStageMAX;s++)
+    {
+        if(!Bench_RunStage((e_BenchStageType)s,Data,ChunkSize,Binary,
+                &Results[s]))
+        {
+            return;
+        }
+        printf("%-12s ",s==0?Name:"");
+        Bench_PrintStage(m_StageNames[s],&Results[s],Data.size());
+    }
+
+    /* What the display added on top of the processors */
+    Display.ns=0;
+    if(Results[e_BenchStage_Pipeline].ns>Results[e_BenchStage_Processors].ns)
+    {
+        Display.ns=Results[e_BenchStage_Pipeline].ns-
+                Results[e_BenchStage_Processors].ns;
+    }
+    Display.Allocs=0;
+    if(Results[e_BenchStage_Pipeline].Allocs>
+            Results[e_BenchStage_Processors].Allocs)
+    {
+        Display.Allocs=Results[e_BenchStage_Pipeline].Allocs-
+                Results[e_BenchStage_Processors].Allocs;
+    }
+    printf("%-12s ","");
+    Bench_PrintStage("display",&Display,Data.size());
+
+    printf("%-12s %-11s %llu frags, %llu lines drawn, %llu reused, "
+            "%llu redraws, %llu scrolls\n","","",
+            (unsigned long long)g_BenchUIStats.FragsAdded,
+            (unsigned long long)g_BenchUIStats.LinesDrawn,
+            (unsigned long long)g_BenchUIStats.LinesReused,
+            (unsigned long long)g_BenchUIStats.FullRedraws,
+            (unsigned long long)g_BenchUIStats.CanvasScrolls);
+}
+
+static void Bench_PrintStage(const char *Name,const struct BenchResult *Result,
+        uint64_t Bytes)
+{
+    double MBs;
+
+    MBs=0;
+    if(Result->ns>0)
+        MBs=((double)Bytes/(1024.0*1024.0))/((double)Result->ns/1e9);
+
+    printf("%-11s %10.2f %10.2f %10.3f\n",Name,MBs,(double)Result->ns/Bytes,
+            (double)Result->Allocs/((double)Bytes/1024.0));
+}
@@ -0,0 +1,614 @@
+/*******************************************************************************
+ * FILENAME: TimerWheelBench_Main.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This times the app timer wheel (App/TimerWheel.cpp) with a restart
+ *    heavy load (like the file transfers restarting their timeout on every
+ *    byte) and checks the timers go off when they should against a simple
+ *    model.
+ *
+ *    The clock (GetElapsedTime_ns()) and the UI timer that drives the wheel
+ *    are faked here, so the bench runs the time and counts how often the
+ *    wheel had to touch the UI timer.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/TimerWheel.h"
+#include "OS/OSTime.h"
+#include "UI/UITimers.h"
+#include <map>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define DEFAULT_RESTARTS                10000000
+#define DEFAULT_FUZZ_OPS                2000000
+#define FUZZ_TIMERS                     64
+#define RESTARTS_PER_MS                 256     // ~256k restarts a second
+#define FTP_TIMEOUT_MS                  1000
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct UITimer
+{
+    void (*Timeout)(uintptr_t UserData);
+    uintptr_t UserData;
+    uint32_t ms;
+    bool Running;
+    uint64_t Due;
+};
+
+struct FuzzModel
+{
+    struct TimerWheelTimer *Timer;
+    bool Running;
+    bool Repeats;
+    uint32_t Timeout;
+    uint64_t Expires;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+static uint64_t Bench_ns(void);
+static uint32_t Bench_Rand(void);
+static void RunClockTo(uint64_t Target,bool Stall);
+static void Fuzz_Timeout(uintptr_t UserData);
+static void Fuzz_Start(unsigned int Index);
+static void Fuzz_Stop(unsigned int Index);
+static bool Fuzz(unsigned int Ops);
+static void Bench_NullTimeout(uintptr_t UserData);
+static bool RestartBench(unsigned int Timers,unsigned int Restarts);
+static void MapRestartBench(unsigned int Timers,unsigned int Restarts);
+static void Usage(void);
+
+/*** VARIABLE DEFINITIONS     ***/
+static uint64_t m_Now_ms;                   // The fake clock
+static struct UITimer m_Driver;             // The only UI timer (the wheel's)
+static unsigned int m_DriverStarts;
+static uint32_t m_RandState=1234;
+static struct FuzzModel m_Fuzz[FUZZ_TIMERS];
+static bool m_FuzzExact;                    // Timers should go off on the exact ms
+static bool m_FuzzFailed;
+static uint64_t m_FuzzFires;
+static uint64_t m_Fires;
+
+int main(int argc,char *argv[])
+{
+    unsigned int Restarts;
+    unsigned int FuzzOps;
+    int arg;
+
+    Restarts=DEFAULT_RESTARTS;
+    FuzzOps=DEFAULT_FUZZ_OPS;
+
+    for(arg=1;arg<argc;arg++)
+    {
+        if(strcmp(argv[arg],"-r")==0 && arg+1<argc)
+        {
+            Restarts=strtoul(argv[++arg],NULL,0);
+        }
+        else if(strcmp(argv[arg],"-z")==0 && arg+1<argc)
+        {
+            FuzzOps=strtoul(argv[++arg],NULL,0);
+        }
+        else
+        {
+            Usage();
+            return 0;
+        }
+    }
+
+    if(!Fuzz(FuzzOps))
+        return 1;
+
+    if(!RestartBench(1,Restarts))
+        return 1;
+    if(!RestartBench(64,Restarts))
+        return 1;
+    if(!RestartBench(4096,Restarts))
+        return 1;
+
+    MapRestartBench(64,Restarts);
+    MapRestartBench(4096,Restarts);
+
+    return 0;
+}
+
+static void Usage(void)
+{
+    printf("USAGE:\n");
+    printf("    TimerWheelBench [-r restarts] [-z fuzz ops]\n");
+    printf("\n");
+    printf("    -r -- How many timer restarts to time (default %d)\n",
+            DEFAULT_RESTARTS);
+    printf("    -z -- How many random start/stop/run ops to check against "
+            "a model (default %d)\n",DEFAULT_FUZZ_OPS);
+}
+
+/* The fake OS / UI parts the wheel uses */
+uint64_t GetElapsedTime_ns(void)
+{
+    return m_Now_ms*1000000ULL;
+}
+
+struct UITimer *AllocUITimer(void)
+{
+    memset(&m_Driver,0x00,sizeof(m_Driver));
+    return &m_Driver;
+}
+
+void FreeUITimer(struct UITimer *Timer)
+{
+    Timer->Running=false;
+}
+
+void SetupUITimer(struct UITimer *Timer,void (*Timeout)(uintptr_t UserData),
+        uintptr_t UserData,bool Repeats)
+{
+    Timer->Timeout=Timeout;
+    Timer->UserData=UserData;
+}
+
+void UITimerSetTimeout(struct UITimer *Timer,uint32_t ms)
+{
+    Timer->ms=ms;
+}
+
+void UITimerStart(struct UITimer *Timer)
+{
+    Timer->Running=true;
+    Timer->Due=m_Now_ms+Timer->ms;
+    m_DriverStarts++;
+}
+
+void UITimerStop(struct UITimer *Timer)
+{
+    Timer->Running=false;
+}
+
+bool UITimerRunning(struct UITimer *Timer)
+{
+    return Timer->Running;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_ns
+ *
+ * SYNOPSIS:
+ *    static uint64_t Bench_ns(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the real time (GetElapsedTime_ns() is the fake
+ *    clock in this bench).
+ *
+ * RETURNS:
+ *    The monotonic clock in ns
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static uint64_t Bench_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+static uint32_t Bench_Rand(void)
+{
+    /* xorshift32, rand() is slower than what we are timing */
+    m_RandState^=m_RandState<<13;
+    m_RandState^=m_RandState>>17;
+    m_RandState^=m_RandState<<5;
+    return m_RandState;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RunClockTo
+ *
+ * SYNOPSIS:
+ *    static void RunClockTo(uint64_t Target,bool Stall);
+ *
+ * PARAMETERS:
+ *    Target [I] -- The time to run the fake clock up to
+ *    Stall [I] -- true = act like the event loop was busy and the UI timer
+ *                 goes off late (at 'Target').  false = the UI timer goes
+ *                 off on time.
+ *
+ * FUNCTION:
+ *    This function is the fake event loop.  It moves the clock forward,
+ *    calling the wheel's UI timer when it's due.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void RunClockTo(uint64_t Target,bool Stall)
+{
+    if(Stall && m_Driver.Running && m_Driver.Due<Target)
+    {
+        m_Now_ms=Target;
+        m_Driver.Running=false;
+        m_Driver.Timeout(m_Driver.UserData);
+    }
+
+    while(m_Driver.Running && m_Driver.Due<=Target)
+    {
+        if(m_Driver.Due>m_Now_ms)
+            m_Now_ms=m_Driver.Due;
+        m_Driver.Running=false;
+        m_Driver.Timeout(m_Driver.UserData);
+    }
+    m_Now_ms=Target;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Fuzz_Timeout
+ *
+ * SYNOPSIS:
+ *    static void Fuzz_Timeout(uintptr_t UserData);
+ *
+ * PARAMETERS:
+ *    UserData [I] -- The index into 'm_Fuzz' of the timer
+ *
+ * FUNCTION:
+ *    This is the call back for the fuzz timers.  It checks the timer was
+ *    running and due, updates the model, and then sometimes starts or stops
+ *    other timers (to check the wheel handles that from inside a call
+ *    back).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Fuzz()
+ ******************************************************************************/
+static void Fuzz_Timeout(uintptr_t UserData)
+{
+    struct FuzzModel *Model=&m_Fuzz[UserData];
+
+    m_FuzzFires++;
+
+    if(!Model->Running || Model->Expires>m_Now_ms ||
+            (m_FuzzExact && Model->Expires!=m_Now_ms))
+    {
+        printf("Timer %d went off at %llu but should go off at %llu%s\n",
+                (int)UserData,(unsigned long long)m_Now_ms,
+                (unsigned long long)Model->Expires,
+                Model->Running?"":" (and is stopped)");
+        m_FuzzFailed=true;
+    }
+
+    if(Model->Repeats)
+        Model->Expires=m_Now_ms+(Model->Timeout>0?Model->Timeout:1);
+    else
+        Model->Running=false;
+
+    switch(Bench_Rand()%8)
+    {
+        case 0:
+            Fuzz_Start(Bench_Rand()%FUZZ_TIMERS);
+        break;
+        case 1:
+            Fuzz_Stop(Bench_Rand()%FUZZ_TIMERS);
+        break;
+        case 2:
+            /* Restart or stop ourself */
+            if(Bench_Rand()&1)
+                Fuzz_Start(UserData);
+            else
+                Fuzz_Stop(UserData);
+        break;
+        default:
+        break;
+    }
+}
+
+static void Fuzz_Start(unsigned int Index)
+{
+    static const uint32_t Timeouts[]={0,1,2,3,10,50,100,511,1000,1023,1024,
+            1025,2047,3000,10000};
+    struct FuzzModel *Model=&m_Fuzz[Index];
+
+    Model->Timeout=Timeouts[Bench_Rand()%(sizeof(Timeouts)/sizeof(Timeouts[0]))];
+    Model->Repeats=(Bench_Rand()&3)==0;
+    Model->Running=true;
+    Model->Expires=m_Now_ms+(Model->Timeout>0?Model->Timeout:1);
+
+    TimerWheel_SetupTimer(Model->Timer,Fuzz_Timeout,Index,Model->Repeats);
+    TimerWheel_SetTimeout(Model->Timer,Model->Timeout);
+    TimerWheel_Start(Model->Timer);
+}
+
+static void Fuzz_Stop(unsigned int Index)
+{
+    m_Fuzz[Index].Running=false;
+    TimerWheel_Stop(m_Fuzz[Index].Timer);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Fuzz
+ *
+ * SYNOPSIS:
+ *    static bool Fuzz(unsigned int Ops);
+ *
+ * PARAMETERS:
+ *    Ops [I] -- How many random things to do
+ *
+ * FUNCTION:
+ *    This function does random starts, restarts, stops and clock runs on a
+ *    set of timers and checks the wheel against a simple model of when
+ *    each timer should go off.  After each run of the clock every timer
+ *    that was due must have gone off (on the exact ms unless the event loop
+ *    was stalled) and the UI timer must be set for before the next timer
+ *    is due.
+ *
+ * RETURNS:
+ *    true -- The wheel matched the model
+ *    false -- It didn't (the details are printed)
+ *
+ * SEE ALSO:
+ *    Fuzz_Timeout()
+ ******************************************************************************/
+static bool Fuzz(unsigned int Ops)
+{
+    unsigned int Op;
+    unsigned int r;
+    uint64_t NextDue;
+    bool Stall;
+
+    m_Now_ms=1000000;
+    m_DriverStarts=0;
+    m_FuzzFailed=false;
+    m_FuzzFires=0;
+    if(!TimerWheel_Init())
+    {
+        printf("Failed to init the wheel\n");
+        return false;
+    }
+
+    for(r=0;r<FUZZ_TIMERS;r++)
+    {
+        m_Fuzz[r].Timer=TimerWheel_AllocTimer();
+        m_Fuzz[r].Running=false;
+        if(m_Fuzz[r].Timer==NULL)
+            return false;
+    }
+
+    for(Op=0;Op<Ops && !m_FuzzFailed;Op++)
+    {
+        switch(Bench_Rand()%4)
+        {
+            case 0:
+            case 1:
+                Fuzz_Start(Bench_Rand()%FUZZ_TIMERS);
+            break;
+            case 2:
+                Fuzz_Stop(Bench_Rand()%FUZZ_TIMERS);
+            break;
+            case 3:
+                Stall=(Bench_Rand()%16)==0;
+                m_FuzzExact=!Stall;
+                if(Bench_Rand()%32==0)
+                    RunClockTo(m_Now_ms+Bench_Rand()%20000,Stall);
+                else
+                    RunClockTo(m_Now_ms+Bench_Rand()%300,Stall);
+            break;
+        }
+
+        /* Check nothing was missed and the wheel will wake up in time */
+        NextDue=~0ULL;
+        for(r=0;r<FUZZ_TIMERS;r++)
+        {
+            if(m_Fuzz[r].Running != TimerWheel_Running(m_Fuzz[r].Timer))
+            {
+                printf("Timer %d running is %d should be %d\n",r,
+                        TimerWheel_Running(m_Fuzz[r].Timer),m_Fuzz[r].Running);
+                m_FuzzFailed=true;
+            }
+            if(!m_Fuzz[r].Running)
+                continue;
+            if(m_Fuzz[r].Expires<=m_Now_ms)
+            {
+                printf("Timer %d was missed (due %llu now %llu)\n",r,
+                        (unsigned long long)m_Fuzz[r].Expires,
+                        (unsigned long long)m_Now_ms);
+                m_FuzzFailed=true;
+            }
+            if(m_Fuzz[r].Expires<NextDue)
+                NextDue=m_Fuzz[r].Expires;
+        }
+        if(NextDue!=~0ULL && (!m_Driver.Running || m_Driver.Due>NextDue))
+        {
+            printf("The UI timer isn't set in time for %llu\n",
+                    (unsigned long long)NextDue);
+            m_FuzzFailed=true;
+        }
+    }
+
+    for(r=0;r<FUZZ_TIMERS;r++)
+        TimerWheel_FreeTimer(m_Fuzz[r].Timer);
+    TimerWheel_Shutdown();
+
+    printf("Fuzz: %u ops, %llu timeouts, %u UI timer starts: %s\n",Op,
+            (unsigned long long)m_FuzzFires,m_DriverStarts,
+            m_FuzzFailed?"FAILED":"OK");
+
+    return !m_FuzzFailed;
+}
+
+static void Bench_NullTimeout(uintptr_t UserData)
+{
+    m_Fires++;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RestartBench
+ *
+ * SYNOPSIS:
+ *    static bool RestartBench(unsigned int Timers,unsigned int Restarts);
+ *
+ * PARAMETERS:
+ *    Timers [I] -- How many timers (connections) are running
+ *    Restarts [I] -- How many restarts to do
+ *
+ * FUNCTION:
+ *    This function times restarting random timers (a file transfer
+ *    timeout restarted on every byte) with the clock moving 1ms every
+ *    RESTARTS_PER_MS restarts.  It prints the time per restart and how
+ *    many times the UI timer had to be touched (with a UI timer per
+ *    timer that would be once per restart).
+ *
+ * RETURNS:
+ *    true -- Worked
+ *    false -- Out of memory or a timer went off when it shouldn't have.
+ *
+ * SEE ALSO:
+ *    MapRestartBench()
+ ******************************************************************************/
+static bool RestartBench(unsigned int Timers,unsigned int Restarts)
+{
+    vector<struct TimerWheelTimer *> List;
+    unsigned int r;
+    uint64_t StartTime;
+    uint64_t ns;
+
+    m_Now_ms=1000000;
+    m_DriverStarts=0;
+    m_Fires=0;
+    if(!TimerWheel_Init())
+        return false;
+
+    List.resize(Timers);
+    for(r=0;r<Timers;r++)
+    {
+        List[r]=TimerWheel_AllocTimer();
+        if(List[r]==NULL)
+            return false;
+        TimerWheel_SetupTimer(List[r],Bench_NullTimeout,r,true);
+        TimerWheel_SetTimeout(List[r],FTP_TIMEOUT_MS);
+        TimerWheel_Start(List[r]);
+    }
+
+    StartTime=Bench_ns();
+    for(r=0;r<Restarts;r++)
+    {
+        if(Timers>1)
+            TimerWheel_Start(List[Bench_Rand()%Timers]);
+        else
+            TimerWheel_Start(List[0]);
+
+        if((r%RESTARTS_PER_MS)==RESTARTS_PER_MS-1)
+            RunClockTo(m_Now_ms+1,false);
+    }
+    ns=Bench_ns()-StartTime;
+
+    printf("Wheel %5u timers: %10u restarts %7.1f ns/restart, %u UI timer "
+            "starts (%.2f per 1M restarts), %llu timeouts\n",Timers,Restarts,
+            (double)ns/Restarts,m_DriverStarts,
+            (double)m_DriverStarts*1000000.0/Restarts,
+            (unsigned long long)m_Fires);
+
+    for(r=0;r<Timers;r++)
+        TimerWheel_FreeTimer(List[r]);
+    TimerWheel_Shutdown();
+
+    /* With 1 timer restarted every ms it should never go off.  With more
+       the odd one can go a second without a restart */
+    if(Timers==1 && m_Fires!=0)
+    {
+        printf("The timer went off while it was being restarted\n");
+        return false;
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    MapRestartBench
+ *
+ * SYNOPSIS:
+ *    static void MapRestartBench(unsigned int Timers,unsigned int Restarts);
+ *
+ * PARAMETERS:
+ *    Timers [I] -- How many timers are running
+ *    Restarts [I] -- How many restarts to do
+ *
+ * FUNCTION:
+ *    This function does the same restarts as RestartBench() but on a sorted
+ *    timer queue (std::multimap, O(log n) restarts) to compare against.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RestartBench()
+ ******************************************************************************/
+static void MapRestartBench(unsigned int Timers,unsigned int Restarts)
+{
+    multimap<uint64_t,unsigned int> Queue;
+    vector<multimap<uint64_t,unsigned int>::iterator> Pos;
+    unsigned int r;
+    unsigned int t;
+    uint64_t StartTime;
+    uint64_t ns;
+
+    m_Now_ms=1000000;
+    Pos.resize(Timers);
+    for(r=0;r<Timers;r++)
+        Pos[r]=Queue.insert(make_pair(m_Now_ms+FTP_TIMEOUT_MS,r));
+
+    StartTime=Bench_ns();
+    for(r=0;r<Restarts;r++)
+    {
+        t=Timers>1?Bench_Rand()%Timers:0;
+        Queue.erase(Pos[t]);
+        Pos[t]=Queue.insert(make_pair(m_Now_ms+FTP_TIMEOUT_MS,t));
+
+        if((r%RESTARTS_PER_MS)==RESTARTS_PER_MS-1)
+            m_Now_ms++;
+    }
+    ns=Bench_ns()-StartTime;
+
+    printf("Map   %5u timers: %10u restarts %7.1f ns/restart\n",Timers,
+            Restarts,(double)ns/Restarts);
+}
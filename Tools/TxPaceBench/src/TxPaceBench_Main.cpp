@@ -0,0 +1,449 @@
+/*******************************************************************************
+ * FILENAME: TxPaceBench_Main.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This measures how evenly the transmit pacer spaces bytes out.  It
+ *    opens a pty pair, sends a block of bytes into the master side with a
+ *    delay between each byte and timestamps every byte as it comes out of
+ *    the slave side on another thread.
+ *
+ *    It reports the gap between bytes (mean, standard deviation, min, max
+ *    and the 99th percentile of how far off each gap was) and how far the
+ *    whole block drifted from where it should have ended.
+ *
+ *    With -t it sends with a 1ms resolution sleep after each byte instead
+ *    (like a GUI timer does) so the two can be compared.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/Util/TxPacer.h"
+#include "OS/OSTime.h"
+#include "OS/Thread.h"
+#include <algorithm>
+#include <vector>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define DEFAULT_BYTES                   2000
+#define DEFAULT_BYTE_DELAY_US           1000
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct BenchRx
+{
+    int fd;
+    unsigned int Bytes;
+    vector<uint64_t> Times;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+static void Bench_Usage(void);
+static bool Bench_OpenPTY(int *RetMaster,int *RetSlave);
+static void Bench_RxThread(void *Arg);
+static e_TxPacerWriteType Bench_Write(uintptr_t UserData,const uint8_t *Data,
+        uint32_t Bytes,uint32_t *Written);
+static void Bench_Report(const vector<uint64_t> &Times,uint32_t Delay_us);
+
+/*** VARIABLE DEFINITIONS     ***/
+
+/*******************************************************************************
+ * NAME:
+ *    main
+ *
+ * SYNOPSIS:
+ *    int main(int argc,char *argv[]);
+ *
+ * PARAMETERS:
+ *    argc [I] -- The number of args
+ *    argv [I] -- The args
+ *
+ * FUNCTION:
+ *    Main entry point.
+ *
+ * RETURNS:
+ *    0 -- Ok
+ *    1 -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+int main(int argc,char *argv[])
+{
+    struct ThreadHandle *RxThread;
+    struct BenchRx Rx;
+    class TxPacer Pacer;
+    unsigned int Bytes;
+    uint32_t Delay_us;
+    uint32_t Written;
+    bool UseTimer;
+    uint8_t *Data;
+    unsigned int r;
+    int Master;
+    int Slave;
+    int arg;
+
+    Bytes=DEFAULT_BYTES;
+    Delay_us=DEFAULT_BYTE_DELAY_US;
+    UseTimer=false;
+    for(arg=1;arg<argc;arg++)
+    {
+        if(strcmp(argv[arg],"-n")==0 && arg+1<argc)
+        {
+            Bytes=strtoul(argv[++arg],NULL,0);
+        }
+        else if(strcmp(argv[arg],"-d")==0 && arg+1<argc)
+        {
+            Delay_us=strtoul(argv[++arg],NULL,0);
+        }
+        else if(strcmp(argv[arg],"-t")==0)
+        {
+            UseTimer=true;
+        }
+        else
+        {
+            Bench_Usage();
+            return 1;
+        }
+    }
+    if(Bytes<2)
+        Bytes=2;
+
+    if(!Bench_OpenPTY(&Master,&Slave))
+    {
+        fprintf(stderr,"Failed to open a pty pair\n");
+        return 1;
+    }
+
+    Data=(uint8_t *)malloc(Bytes);
+    if(Data==NULL)
+        return 1;
+    for(r=0;r<Bytes;r++)
+        Data[r]='A'+r%26;
+
+    Rx.fd=Slave;
+    Rx.Bytes=Bytes;
+    Rx.Times.reserve(Bytes);
+    RxThread=StartThread(false,Bench_RxThread,&Rx);
+    if(RxThread==NULL)
+    {
+        fprintf(stderr,"Failed to start the rx thread\n");
+        return 1;
+    }
+
+    if(UseTimer)
+    {
+        /* Send like a GUI timer would, a relative ms sleep after each byte */
+        for(r=0;r<Bytes;r++)
+        {
+            if(Bench_Write(Master,&Data[r],1,&Written)!=e_TxPacerWrite_Sent)
+                break;
+            OS_Sleep((Delay_us+999)/1000);
+        }
+    }
+    else
+    {
+        if(!Pacer.Init(Bench_Write,Master))
+        {
+            fprintf(stderr,"Failed to setup the pacer\n");
+            return 1;
+        }
+        Pacer.SetDelays(Delay_us,0);
+        if(!Pacer.Queue(Data,Bytes))
+        {
+            fprintf(stderr,"Failed to queue the data\n");
+            return 1;
+        }
+    }
+
+    Wait4ThreadToExit(RxThread);
+    Pacer.Stop();
+
+    printf("%s, %u bytes, %u us between bytes\n",
+            UseTimer?"ms timer":"pacer",Bytes,Delay_us);
+    Bench_Report(Rx.Times,Delay_us);
+
+    free(Data);
+    close(Slave);
+    close(Master);
+
+    return 0;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Usage
+ *
+ * SYNOPSIS:
+ *    static void Bench_Usage(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function prints the usage.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Usage(void)
+{
+    printf("USAGE:\n");
+    printf("    TxPaceBench [-n bytes] [-d us] [-t]\n");
+    printf("\n");
+    printf("    -n -- How many bytes to send (default %d)\n",DEFAULT_BYTES);
+    printf("    -d -- The delay between bytes in us (default %d)\n",
+            DEFAULT_BYTE_DELAY_US);
+    printf("    -t -- Send with a ms sleep after each byte instead of the "
+            "pacer\n");
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_OpenPTY
+ *
+ * SYNOPSIS:
+ *    static bool Bench_OpenPTY(int *RetMaster,int *RetSlave);
+ *
+ * PARAMETERS:
+ *    RetMaster [O] -- The master side of the pty
+ *    RetSlave [O] -- The slave side of the pty
+ *
+ * FUNCTION:
+ *    This function opens a pty pair and puts the slave in raw mode so the
+ *    bytes come out one at a time as they are written.
+ *
+ * RETURNS:
+ *    true -- Things worked
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool Bench_OpenPTY(int *RetMaster,int *RetSlave)
+{
+    struct termios tio;
+    char *SlaveName;
+    int Master;
+    int Slave;
+
+    Master=posix_openpt(O_RDWR|O_NOCTTY);
+    if(Master<0)
+        return false;
+
+    if(grantpt(Master)!=0 || unlockpt(Master)!=0)
+    {
+        close(Master);
+        return false;
+    }
+
+    SlaveName=ptsname(Master);
+    if(SlaveName==NULL)
+    {
+        close(Master);
+        return false;
+    }
+
+    Slave=open(SlaveName,O_RDWR|O_NOCTTY);
+    if(Slave<0)
+    {
+        close(Master);
+        return false;
+    }
+
+    tcgetattr(Slave,&tio);
+    cfmakeraw(&tio);
+    tio.c_cc[VMIN]=1;
+    tio.c_cc[VTIME]=0;
+    tcsetattr(Slave,TCSANOW,&tio);
+
+    *RetMaster=Master;
+    *RetSlave=Slave;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_RxThread
+ *
+ * SYNOPSIS:
+ *    static void Bench_RxThread(void *Arg);
+ *
+ * PARAMETERS:
+ *    Arg [I] -- The rx info (struct BenchRx *)
+ *
+ * FUNCTION:
+ *    This function reads the slave side of the pty and notes the time
+ *    every byte comes in.  If more than one byte comes in with a read they
+ *    all get the same time.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_RxThread(void *Arg)
+{
+    struct BenchRx *Rx=(struct BenchRx *)Arg;
+    uint8_t Buff[256];
+    uint64_t Now;
+    ssize_t Got;
+    ssize_t r;
+
+    while(Rx->Times.size()<Rx->Bytes)
+    {
+        Got=read(Rx->fd,Buff,sizeof(Buff));
+        if(Got<=0)
+            break;
+        Now=GetElapsedTime_ns();
+        for(r=0;r<Got;r++)
+            Rx->Times.push_back(Now);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Write
+ *
+ * SYNOPSIS:
+ *    static e_TxPacerWriteType Bench_Write(uintptr_t UserData,
+ *          const uint8_t *Data,uint32_t Bytes,uint32_t *Written);
+ *
+ * PARAMETERS:
+ *    UserData [I] -- The master fd
+ *    Data [I] -- The bytes to send
+ *    Bytes [I] -- The number of bytes to send
+ *    Written [O] -- The number of bytes the pty took
+ *
+ * FUNCTION:
+ *    This is the pacer's write function.  It writes to the pty master.
+ *
+ * RETURNS:
+ *    See TxPacer::Init()
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static e_TxPacerWriteType Bench_Write(uintptr_t UserData,const uint8_t *Data,
+        uint32_t Bytes,uint32_t *Written)
+{
+    ssize_t Wrote;
+
+    *Written=0;
+    Wrote=write((int)UserData,Data,Bytes);
+    if(Wrote<0)
+        return e_TxPacerWrite_Error;
+    *Written=Wrote;
+    if(Wrote==(ssize_t)Bytes)
+        return e_TxPacerWrite_Sent;
+    return e_TxPacerWrite_Busy;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Report
+ *
+ * SYNOPSIS:
+ *    static void Bench_Report(const vector<uint64_t> &Times,
+ *          uint32_t Delay_us);
+ *
+ * PARAMETERS:
+ *    Times [I] -- The time every byte came in
+ *    Delay_us [I] -- What the gap between bytes should have been
+ *
+ * FUNCTION:
+ *    This function prints the stats for the gaps between bytes.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Report(const vector<uint64_t> &Times,uint32_t Delay_us)
+{
+    vector<double> Errors;
+    double Target;
+    double Gap;
+    double Sum;
+    double SumSq;
+    double Mean;
+    double Min;
+    double Max;
+    double Expected;
+    double Took;
+    size_t r;
+
+    if(Times.size()<2)
+    {
+        printf("Not enough bytes came in\n");
+        return;
+    }
+
+    Target=Delay_us;
+    Sum=0;
+    SumSq=0;
+    Min=1e30;
+    Max=0;
+    Errors.reserve(Times.size()-1);
+    for(r=1;r<Times.size();r++)
+    {
+        Gap=(Times[r]-Times[r-1])/1000.0;
+        Sum+=Gap;
+        SumSq+=Gap*Gap;
+        if(Gap<Min)
+            Min=Gap;
+        if(Gap>Max)
+            Max=Gap;
+        Errors.push_back(fabs(Gap-Target));
+    }
+    Mean=Sum/(Times.size()-1);
+    sort(Errors.begin(),Errors.end());
+
+    Expected=Target*(Times.size()-1);
+    Took=(Times.back()-Times.front())/1000.0;
+
+    printf("  gap us:   mean %9.1f  stddev %9.1f  min %9.1f  max %9.1f\n",
+            Mean,sqrt(SumSq/(Times.size()-1)-Mean*Mean),Min,Max);
+    printf("  error us: p50 %9.1f  p99 %9.1f  max %9.1f\n",
+            Errors[Errors.size()/2],Errors[Errors.size()*99/100],
+            Errors.back());
+    printf("  drift:    took %.1f ms, should have been %.1f ms (%+.2f%%)\n",
+            Took/1000,Expected/1000,(Took-Expected)*100/Expected);
+}
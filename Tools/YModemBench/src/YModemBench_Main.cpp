@@ -0,0 +1,898 @@
+/*******************************************************************************
+ * FILENAME: YModemBench_Main.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This measures how close the YModem plugin gets to line rate.  It runs
+ *    the YModem upload and download against each other over a pty pair
+ *    with an emulated serial line in each direction (a UART queue that
+ *    drains at the baud rate and a fixed delay on top) and reports the
+ *    throughput as a percent of the line rate.
+ *
+ *    The plugin timers are run the same way the connection runs them so
+ *    the streaming tick is what the app would really give it.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "PluginSDK/Plugin.h"
+#include "OS/OSTime.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define DEFAULT_BAUD                    921600
+#define DEFAULT_BYTES                   (1024*1024)
+#define DEFAULT_DELAY_MS                10      // One way (20ms round trip)
+#define UART_QUEUE_SIZE                 4096    // Driver takes no more than this
+#define APP_TICK_MS                     100     // Like the connection's tick
+#define MAX_RUN_TIME_NS                 (120ULL*1000000000ULL)
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct WireChunk
+{
+    uint64_t Arrive_ns;         // When the last byte gets to the other end
+    vector<uint8_t> Bytes;
+};
+
+/* One direction of the emulated serial line */
+struct Wire
+{
+    int fd;                     // Where it comes out
+    uint64_t Byte_ns;           // How long one byte takes at the baud rate
+    uint64_t Delay_ns;
+    uint64_t TxDone_ns;         // When the UART will be empty
+    deque<struct WireChunk> Chunks;
+    vector<uint8_t> Held;       // What the UART didn't take (the pacer's)
+};
+
+/* One side of the transfer (the plugin and it's timer) */
+struct BenchSide
+{
+    const struct FTPHandlerInfo *Info;
+    t_FTPHandlerDataType *Data;
+    struct Wire *Out;
+    int InFD;
+    uint32_t TimeoutMS;
+    uint64_t NextTimeout_ns;
+    bool Done;
+    bool Aborted;
+    uint64_t Progress;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+static void Bench_Usage(void);
+static bool Bench_OpenPTY(int *RetMaster,int *RetSlave);
+static bool Bench_MakeFile(const char *Filename,uint32_t Bytes);
+static bool Bench_CompareFiles(const char *File1,const char *File2);
+static uint32_t Bench_WireSend(struct Wire *W,const void *Data,
+        uint32_t Bytes);
+static int Bench_ConSend(struct Wire *W,const void *Data,uint32_t Bytes);
+static void Bench_WirePump(struct Wire *W,uint64_t Now_ns);
+static void Bench_Finish(struct BenchSide *Side,PG_BOOL Aborted);
+static void Bench_Timer(struct BenchSide *Side,uint64_t Now_ns);
+static void Bench_Read(struct BenchSide *Side);
+
+static const struct FTPS_API *Bench_GetAPI_FTPS(void);
+static void Bench_KVClear(t_PIKVList *Handle);
+static PG_BOOL Bench_KVAddItem(t_PIKVList *Handle,const char *Key,
+        const char *Value);
+static const char *Bench_KVGetItem(const t_PIKVList *Handle,const char *Key);
+static uint32_t Bench_GetExperimentalID(void);
+static PG_BOOL Bench_RegisterFileTransferProtocol(
+        const struct FTPHandlerInfo *Info);
+static const struct PI_UIAPI *Bench_GetAPI_UI(void);
+static void Bench_SetTimeout(t_FTPSystemData *SysHandle,uint32_t MSec);
+static void Bench_RestartTimeout(t_FTPSystemData *SysHandle);
+static void Bench_ULProgress(t_FTPSystemData *SysHandle,uint64_t Bytes);
+static void Bench_ULFinish(t_FTPSystemData *SysHandle,PG_BOOL Aborted);
+static int Bench_ULSendData(t_FTPSystemData *SysHandle,void *Data,
+        uint32_t Bytes);
+static void Bench_DLProgress(t_FTPSystemData *SysHandle,uint64_t Bytes);
+static void Bench_DLFinish(t_FTPSystemData *SysHandle,PG_BOOL Aborted);
+static int Bench_DLSendData(t_FTPSystemData *SysHandle,void *Data,
+        uint32_t Bytes);
+static const char *Bench_GetDownloadFilename(t_FTPSystemData *SysHandle,
+        const char *FileNameHint);
+
+extern "C"
+{
+    unsigned int YModem_RegisterPlugin(const struct PI_SystemAPI *SysAPI,
+            unsigned int Version);
+}
+
+/*** VARIABLE DEFINITIONS     ***/
+static struct FTPS_API m_BenchFTPS=
+{
+    Bench_RegisterFileTransferProtocol,
+    Bench_GetAPI_UI,
+    Bench_SetTimeout,
+    Bench_RestartTimeout,
+    Bench_ULProgress,
+    Bench_ULFinish,
+    Bench_ULSendData,
+    Bench_DLProgress,
+    Bench_DLFinish,
+    Bench_DLSendData,
+    Bench_GetDownloadFilename,
+};
+
+static struct PI_SystemAPI m_BenchSystem=
+{
+    NULL,
+    NULL,
+    Bench_GetAPI_FTPS,
+    Bench_KVClear,
+    Bench_KVAddItem,
+    Bench_KVGetItem,
+    Bench_GetExperimentalID,
+    NULL,
+};
+
+static const struct FTPHandlerInfo *m_UploadInfo;
+static const struct FTPHandlerInfo *m_DownloadInfo;
+static struct BenchSide m_Sender;
+static struct BenchSide m_Receiver;
+static string m_DownloadFilename;
+
+/*******************************************************************************
+ * NAME:
+ *    main
+ *
+ * SYNOPSIS:
+ *    int main(int argc,char *argv[]);
+ *
+ * PARAMETERS:
+ *    argc [I] -- The number of args
+ *    argv [I] -- The args
+ *
+ * FUNCTION:
+ *    Main entry point.
+ *
+ * RETURNS:
+ *    0 -- Ok
+ *    1 -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+int main(int argc,char *argv[])
+{
+    map<string,string> ULOptions;
+    map<string,string> DLOptions;
+    struct Wire ToReceiver;
+    struct Wire ToSender;
+    struct pollfd fds[2];
+    const char *SendFile;
+    uint64_t Start_ns;
+    uint64_t Now_ns;
+    double Seconds;
+    double LineRate;
+    double Rate;
+    uint32_t Baud;
+    uint32_t Bytes;
+    uint32_t Delay_ms;
+    bool Streaming;
+    bool Match;
+    int Master;
+    int Slave;
+    int arg;
+
+    Baud=DEFAULT_BAUD;
+    Bytes=DEFAULT_BYTES;
+    Delay_ms=DEFAULT_DELAY_MS;
+    Streaming=true;
+    for(arg=1;arg<argc;arg++)
+    {
+        if(strcmp(argv[arg],"-b")==0 && arg+1<argc)
+            Baud=strtoul(argv[++arg],NULL,0);
+        else if(strcmp(argv[arg],"-s")==0 && arg+1<argc)
+            Bytes=strtoul(argv[++arg],NULL,0);
+        else if(strcmp(argv[arg],"-d")==0 && arg+1<argc)
+            Delay_ms=strtoul(argv[++arg],NULL,0);
+        else if(strcmp(argv[arg],"-y")==0)
+            Streaming=false;
+        else
+        {
+            Bench_Usage();
+            return 1;
+        }
+    }
+    if(Baud<300)
+        Baud=300;
+
+    if(YModem_RegisterPlugin(&m_BenchSystem,0xFFFFFFFF)!=0 ||
+            m_UploadInfo==NULL || m_DownloadInfo==NULL)
+    {
+        fprintf(stderr,"Failed to register the YModem plugin\n");
+        return 1;
+    }
+
+    SendFile="YModemBench_Send.bin";
+    m_DownloadFilename="YModemBench_Rx.bin";
+    if(!Bench_MakeFile(SendFile,Bytes))
+    {
+        fprintf(stderr,"Failed to make the file to send\n");
+        return 1;
+    }
+
+    if(!Bench_OpenPTY(&Master,&Slave))
+    {
+        fprintf(stderr,"Failed to open a pty pair\n");
+        return 1;
+    }
+    fcntl(Master,F_SETFL,fcntl(Master,F_GETFL)|O_NONBLOCK);
+    fcntl(Slave,F_SETFL,fcntl(Slave,F_GETFL)|O_NONBLOCK);
+
+    /* 8N1 is 10 bits a byte */
+    ToReceiver.fd=Master;
+    ToReceiver.Byte_ns=10000000000ULL/Baud;
+    ToReceiver.Delay_ns=(uint64_t)Delay_ms*1000000;
+    ToReceiver.TxDone_ns=0;
+    ToSender=ToReceiver;
+    ToSender.fd=Slave;
+
+    memset(&m_Sender,0x00,sizeof(m_Sender));
+    m_Sender.Info=m_UploadInfo;
+    m_Sender.Out=&ToReceiver;
+    m_Sender.InFD=Master;
+    memset(&m_Receiver,0x00,sizeof(m_Receiver));
+    m_Receiver.Info=m_DownloadInfo;
+    m_Receiver.Out=&ToSender;
+    m_Receiver.InFD=Slave;
+
+    DLOptions["Mode"]=Streaming?"1":"0";
+
+    m_Sender.Data=m_UploadInfo->API->AllocateData();
+    m_Receiver.Data=m_DownloadInfo->API->AllocateData();
+    if(m_Sender.Data==NULL || m_Receiver.Data==NULL)
+        return 1;
+
+    Start_ns=GetElapsedTime_ns();
+    if(!m_UploadInfo->API->StartUpload((t_FTPSystemData *)&m_Sender,
+            m_Sender.Data,SendFile,SendFile,Bytes,(t_PIKVList *)&ULOptions))
+    {
+        fprintf(stderr,"Failed to start the upload\n");
+        return 1;
+    }
+    if(!m_DownloadInfo->API->StartDownload((t_FTPSystemData *)&m_Receiver,
+            m_Receiver.Data,(t_PIKVList *)&DLOptions))
+    {
+        fprintf(stderr,"Failed to start the download\n");
+        return 1;
+    }
+
+    while(!m_Sender.Done || !m_Receiver.Done)
+    {
+        Now_ns=GetElapsedTime_ns();
+        if(Now_ns-Start_ns>MAX_RUN_TIME_NS)
+        {
+            fprintf(stderr,"Gave up (the transfer is stuck)\n");
+            return 1;
+        }
+
+        Bench_WirePump(&ToReceiver,Now_ns);
+        Bench_WirePump(&ToSender,Now_ns);
+        Bench_Read(&m_Receiver);
+        Bench_Read(&m_Sender);
+        Bench_Timer(&m_Sender,Now_ns);
+        Bench_Timer(&m_Receiver,Now_ns);
+
+        fds[0].fd=Master;
+        fds[0].events=POLLIN;
+        fds[1].fd=Slave;
+        fds[1].events=POLLIN;
+        poll(fds,2,1);
+    }
+    Seconds=(GetElapsedTime_ns()-Start_ns)/1e9;
+
+    Match=!m_Sender.Aborted && !m_Receiver.Aborted &&
+            Bench_CompareFiles(SendFile,m_DownloadFilename.c_str());
+
+    LineRate=Baud/10.0;
+    Rate=Bytes/Seconds;
+    printf("%s, %u bytes at %u baud, %u ms each way\n",
+            Streaming?"YModem-G":"YModem",Bytes,Baud,Delay_ms);
+    printf("    Time: %.3f s\n",Seconds);
+    printf("    Throughput: %.0f bytes/s (%.1f%% of line rate)\n",Rate,
+            Rate*100.0/LineRate);
+    printf("    File: %s\n",Match?"matches":"DOES NOT MATCH");
+
+    close(Slave);
+    close(Master);
+    unlink(SendFile);
+    unlink(m_DownloadFilename.c_str());
+
+    return Match?0:1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Usage
+ *
+ * SYNOPSIS:
+ *    static void Bench_Usage(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function prints the usage.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Usage(void)
+{
+    printf("USAGE:\n");
+    printf("    YModemBench [-b baud] [-s bytes] [-d ms] [-y]\n");
+    printf("\n");
+    printf("    -b -- The baud rate of the emulated line (default %d)\n",
+            DEFAULT_BAUD);
+    printf("    -s -- How many bytes to send (default %d)\n",DEFAULT_BYTES);
+    printf("    -d -- The delay each way in ms (default %d)\n",
+            DEFAULT_DELAY_MS);
+    printf("    -y -- Use YModem (ACK each block) instead of YModem-G\n");
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_OpenPTY
+ *
+ * SYNOPSIS:
+ *    static bool Bench_OpenPTY(int *RetMaster,int *RetSlave);
+ *
+ * PARAMETERS:
+ *    RetMaster [O] -- The master side of the pty
+ *    RetSlave [O] -- The slave side of the pty
+ *
+ * FUNCTION:
+ *    This function opens a pty pair and puts the slave in raw mode so
+ *    binary data goes through untouched.
+ *
+ * RETURNS:
+ *    true -- Things worked
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool Bench_OpenPTY(int *RetMaster,int *RetSlave)
+{
+    struct termios tio;
+    char *SlaveName;
+    int Master;
+    int Slave;
+
+    Master=posix_openpt(O_RDWR|O_NOCTTY);
+    if(Master<0)
+        return false;
+
+    if(grantpt(Master)!=0 || unlockpt(Master)!=0)
+    {
+        close(Master);
+        return false;
+    }
+
+    SlaveName=ptsname(Master);
+    if(SlaveName==NULL)
+    {
+        close(Master);
+        return false;
+    }
+
+    Slave=open(SlaveName,O_RDWR|O_NOCTTY);
+    if(Slave<0)
+    {
+        close(Master);
+        return false;
+    }
+
+    tcgetattr(Slave,&tio);
+    cfmakeraw(&tio);
+    tio.c_cc[VMIN]=1;
+    tio.c_cc[VTIME]=0;
+    tcsetattr(Slave,TCSANOW,&tio);
+
+    *RetMaster=Master;
+    *RetSlave=Slave;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_MakeFile
+ *
+ * SYNOPSIS:
+ *    static bool Bench_MakeFile(const char *Filename,uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to make
+ *    Bytes [I] -- How big to make it
+ *
+ * FUNCTION:
+ *    This function makes a file of random bytes to send.  The size isn't a
+ *    multiple of the block size so the padding gets tested too.
+ *
+ * RETURNS:
+ *    true -- Things worked
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool Bench_MakeFile(const char *Filename,uint32_t Bytes)
+{
+    FILE *out;
+    uint32_t r;
+    bool RetValue;
+
+    out=fopen(Filename,"wb");
+    if(out==NULL)
+        return false;
+
+    srand(1234);
+    RetValue=true;
+    for(r=0;r<Bytes;r++)
+    {
+        if(fputc(rand()&0xFF,out)==EOF)
+        {
+            RetValue=false;
+            break;
+        }
+    }
+    fclose(out);
+
+    return RetValue;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_CompareFiles
+ *
+ * SYNOPSIS:
+ *    static bool Bench_CompareFiles(const char *File1,const char *File2);
+ *
+ * PARAMETERS:
+ *    File1 [I] -- The first file
+ *    File2 [I] -- The second file
+ *
+ * FUNCTION:
+ *    This function checks that the file we got is the same as the one we
+ *    sent (same size, same bytes).
+ *
+ * RETURNS:
+ *    true -- They match
+ *    false -- They are different (or one couldn't be opened)
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool Bench_CompareFiles(const char *File1,const char *File2)
+{
+    FILE *in1;
+    FILE *in2;
+    int c1;
+    int c2;
+
+    in1=fopen(File1,"rb");
+    in2=fopen(File2,"rb");
+    if(in1==NULL || in2==NULL)
+    {
+        if(in1!=NULL)
+            fclose(in1);
+        if(in2!=NULL)
+            fclose(in2);
+        return false;
+    }
+
+    do
+    {
+        c1=fgetc(in1);
+        c2=fgetc(in2);
+    } while(c1==c2 && c1!=EOF);
+
+    fclose(in1);
+    fclose(in2);
+
+    return c1==c2;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_WireSend
+ *
+ * SYNOPSIS:
+ *    static uint32_t Bench_WireSend(struct Wire *W,const void *Data,
+ *          uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    W [I] -- The direction to send on
+ *    Data [I] -- The bytes to send
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function queues bytes in the emulated UART.  Like a non-blocking
+ *    serial port it takes as many bytes as it has room for (which may be
+ *    none).  The bytes come out the other end after they have been clocked
+ *    out at the baud rate plus the line delay.
+ *
+ * RETURNS:
+ *    The number of bytes the UART took
+ *
+ * SEE ALSO:
+ *    Bench_WirePump(), Bench_ConSend()
+ ******************************************************************************/
+static uint32_t Bench_WireSend(struct Wire *W,const void *Data,uint32_t Bytes)
+{
+    struct WireChunk Chunk;
+    uint64_t Now_ns;
+    uint64_t Queued;
+
+    Now_ns=GetElapsedTime_ns();
+    if(W->TxDone_ns<Now_ns)
+        W->TxDone_ns=Now_ns;
+
+    Queued=(W->TxDone_ns-Now_ns)/W->Byte_ns;
+    if(Queued>=UART_QUEUE_SIZE)
+        return 0;
+    if(Queued+Bytes>UART_QUEUE_SIZE)
+        Bytes=UART_QUEUE_SIZE-Queued;
+
+    W->TxDone_ns+=Bytes*W->Byte_ns;
+    Chunk.Arrive_ns=W->TxDone_ns+W->Delay_ns;
+    Chunk.Bytes.assign((const uint8_t *)Data,(const uint8_t *)Data+Bytes);
+    W->Chunks.push_back(Chunk);
+
+    return Bytes;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_ConSend
+ *
+ * SYNOPSIS:
+ *    static int Bench_ConSend(struct Wire *W,const void *Data,
+ *          uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    W [I] -- The direction to send on
+ *    Data [I] -- The bytes to send
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function sends bytes the way the connection does for a file
+ *    transfer.  If the UART only takes some of them the rest are held
+ *    (the connection puts them on the transmit pacer) and we say the
+ *    send worked.  Anything sent while bytes are still held is busy.
+ *
+ * RETURNS:
+ *    e_FTPS_SendDataRet_Success or e_FTPS_SendDataRet_Busy
+ *
+ * SEE ALSO:
+ *    Bench_WireSend()
+ ******************************************************************************/
+static int Bench_ConSend(struct Wire *W,const void *Data,uint32_t Bytes)
+{
+    uint32_t Taken;
+
+    if(!W->Held.empty())
+    {
+        Taken=Bench_WireSend(W,W->Held.data(),W->Held.size());
+        W->Held.erase(W->Held.begin(),W->Held.begin()+Taken);
+        if(!W->Held.empty())
+            return e_FTPS_SendDataRet_Busy;
+    }
+
+    Taken=Bench_WireSend(W,Data,Bytes);
+    if(Taken==0)
+        return e_FTPS_SendDataRet_Busy;
+
+    W->Held.assign((const uint8_t *)Data+Taken,(const uint8_t *)Data+Bytes);
+
+    return e_FTPS_SendDataRet_Success;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_WirePump
+ *
+ * SYNOPSIS:
+ *    static void Bench_WirePump(struct Wire *W,uint64_t Now_ns);
+ *
+ * PARAMETERS:
+ *    W [I] -- The direction to move bytes on
+ *    Now_ns [I] -- The current time
+ *
+ * FUNCTION:
+ *    This function moves any held bytes into the UART and writes the bytes
+ *    that have made it across the emulated line into the pty.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Bench_WireSend()
+ ******************************************************************************/
+static void Bench_WirePump(struct Wire *W,uint64_t Now_ns)
+{
+    struct WireChunk *Chunk;
+    ssize_t Wrote;
+    uint32_t Taken;
+
+    /* The pacer's thread keeps the UART full with what it's holding */
+    if(!W->Held.empty())
+    {
+        Taken=Bench_WireSend(W,W->Held.data(),W->Held.size());
+        W->Held.erase(W->Held.begin(),W->Held.begin()+Taken);
+    }
+
+    while(!W->Chunks.empty())
+    {
+        Chunk=&W->Chunks.front();
+        if(Chunk->Arrive_ns>Now_ns)
+            break;
+
+        Wrote=write(W->fd,Chunk->Bytes.data(),Chunk->Bytes.size());
+        if(Wrote<=0)
+            break;
+        if((size_t)Wrote<Chunk->Bytes.size())
+        {
+            /* The pty is full, do the rest next time */
+            Chunk->Bytes.erase(Chunk->Bytes.begin(),
+                    Chunk->Bytes.begin()+Wrote);
+            break;
+        }
+        W->Chunks.pop_front();
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Read
+ *
+ * SYNOPSIS:
+ *    static void Bench_Read(struct BenchSide *Side);
+ *
+ * PARAMETERS:
+ *    Side [I] -- The side to read for
+ *
+ * FUNCTION:
+ *    This function reads what has come in on the pty and gives it to the
+ *    plugin (like the connection does).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Read(struct BenchSide *Side)
+{
+    uint8_t Buff[4096];
+    ssize_t Got;
+
+    while(!Side->Done)
+    {
+        Got=read(Side->InFD,Buff,sizeof(Buff));
+        if(Got<=0)
+            break;
+        Side->Info->API->RxData((t_FTPSystemData *)Side,Side->Data,Buff,Got);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Timer
+ *
+ * SYNOPSIS:
+ *    static void Bench_Timer(struct BenchSide *Side,uint64_t Now_ns);
+ *
+ * PARAMETERS:
+ *    Side [I] -- The side to run the timer for
+ *    Now_ns [I] -- The current time
+ *
+ * FUNCTION:
+ *    This function calls the plugin's timeout when it's timer goes off.
+ *    Like the connection, timeouts under the app tick run on their own
+ *    timer and the rest are rounded up to the app tick.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Timer(struct BenchSide *Side,uint64_t Now_ns)
+{
+    uint32_t MS;
+
+    if(Side->Done || Side->TimeoutMS==0 || Now_ns<Side->NextTimeout_ns)
+        return;
+
+    MS=Side->TimeoutMS;
+    if(MS>=APP_TICK_MS)
+        MS=(MS+APP_TICK_MS-1)/APP_TICK_MS*APP_TICK_MS;
+    Side->NextTimeout_ns=Now_ns+(uint64_t)MS*1000000;
+
+    Side->Info->API->Timeout((t_FTPSystemData *)Side,Side->Data);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Finish
+ *
+ * SYNOPSIS:
+ *    static void Bench_Finish(struct BenchSide *Side,PG_BOOL Aborted);
+ *
+ * PARAMETERS:
+ *    Side [I] -- The side that finished
+ *    Aborted [I] -- Did the transfer fail
+ *
+ * FUNCTION:
+ *    This function handles a side finishing.  Like the real system it frees
+ *    the plugin's data.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Finish(struct BenchSide *Side,PG_BOOL Aborted)
+{
+    const char *Msg;
+
+    if(Aborted)
+    {
+        Msg=Side->Info->API->GetLastErrorMsg((t_FTPSystemData *)Side,
+                Side->Data);
+        fprintf(stderr,"%s aborted: %s\n",Side->Info->IDStr,
+                Msg==NULL?"":Msg);
+    }
+
+    Side->Info->API->FreeData(Side->Data);
+    Side->Data=NULL;
+    Side->Done=true;
+    Side->Aborted=Aborted;
+}
+
+static const struct FTPS_API *Bench_GetAPI_FTPS(void)
+{
+    return &m_BenchFTPS;
+}
+
+static void Bench_KVClear(t_PIKVList *Handle)
+{
+    ((map<string,string> *)Handle)->clear();
+}
+
+static PG_BOOL Bench_KVAddItem(t_PIKVList *Handle,const char *Key,
+        const char *Value)
+{
+    (*(map<string,string> *)Handle)[Key]=Value;
+    return true;
+}
+
+static const char *Bench_KVGetItem(const t_PIKVList *Handle,const char *Key)
+{
+    const map<string,string> *KV=(const map<string,string> *)Handle;
+    map<string,string>::const_iterator i;
+
+    i=KV->find(Key);
+    if(i==KV->end())
+        return NULL;
+    return i->second.c_str();
+}
+
+static uint32_t Bench_GetExperimentalID(void)
+{
+    return 0;
+}
+
+static PG_BOOL Bench_RegisterFileTransferProtocol(
+        const struct FTPHandlerInfo *Info)
+{
+    if(Info->Mode==e_FileTransferProtocolMode_Upload)
+        m_UploadInfo=Info;
+    else
+        m_DownloadInfo=Info;
+    return true;
+}
+
+static const struct PI_UIAPI *Bench_GetAPI_UI(void)
+{
+    return NULL;
+}
+
+static void Bench_SetTimeout(t_FTPSystemData *SysHandle,uint32_t MSec)
+{
+    struct BenchSide *Side=(struct BenchSide *)SysHandle;
+
+    Side->TimeoutMS=MSec;
+    Side->NextTimeout_ns=GetElapsedTime_ns()+(uint64_t)MSec*1000000;
+}
+
+static void Bench_RestartTimeout(t_FTPSystemData *SysHandle)
+{
+    struct BenchSide *Side=(struct BenchSide *)SysHandle;
+
+    Side->NextTimeout_ns=GetElapsedTime_ns()+
+            (uint64_t)Side->TimeoutMS*1000000;
+}
+
+static void Bench_ULProgress(t_FTPSystemData *SysHandle,uint64_t Bytes)
+{
+    ((struct BenchSide *)SysHandle)->Progress=Bytes;
+}
+
+static void Bench_ULFinish(t_FTPSystemData *SysHandle,PG_BOOL Aborted)
+{
+    Bench_Finish((struct BenchSide *)SysHandle,Aborted);
+}
+
+static int Bench_ULSendData(t_FTPSystemData *SysHandle,void *Data,
+        uint32_t Bytes)
+{
+    return Bench_ConSend(((struct BenchSide *)SysHandle)->Out,Data,Bytes);
+}
+
+static void Bench_DLProgress(t_FTPSystemData *SysHandle,uint64_t Bytes)
+{
+    ((struct BenchSide *)SysHandle)->Progress=Bytes;
+}
+
+static void Bench_DLFinish(t_FTPSystemData *SysHandle,PG_BOOL Aborted)
+{
+    Bench_Finish((struct BenchSide *)SysHandle,Aborted);
+}
+
+static int Bench_DLSendData(t_FTPSystemData *SysHandle,void *Data,
+        uint32_t Bytes)
+{
+    return Bench_ConSend(((struct BenchSide *)SysHandle)->Out,Data,Bytes);
+}
+
+static const char *Bench_GetDownloadFilename(t_FTPSystemData *SysHandle,
+        const char *FileNameHint)
+{
+    return m_DownloadFilename.c_str();
+}
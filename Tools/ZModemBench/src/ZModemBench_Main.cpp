@@ -0,0 +1,1327 @@
+/*******************************************************************************
+ * FILENAME: ZModemBench_Main.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This runs the ZModem plugin over a pty pair and checks the file gets
+ *    across.  By default it runs our upload against our download with an
+ *    emulated serial line in each direction (like YModemBench).  With -b 0
+ *    the line runs as fast as the pty will go so multi-GB files (past the
+ *    32 bit ZModem positions) can be tested.
+ *
+ *    With -k the line is dropped after that many bytes (both sides are
+ *    aborted and nothing they send gets through) and then the transfer is
+ *    started again with resume on.  The receiver should carry on from the
+ *    end of what it has.
+ *
+ *    With -x sz or -x rz one side is lrzsz running on the slave side of the
+ *    pty instead of our plugin.  lrzsz has to be in the PATH (as rz / sz or
+ *    lrz / lsz).
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "PluginSDK/Plugin.h"
+#include "OS/OSTime.h"
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define DEFAULT_BAUD                    921600
+#define DEFAULT_BYTES                   (1024*1024)
+#define DEFAULT_DELAY_MS                10      // One way (20ms round trip)
+#define UART_QUEUE_SIZE                 4096    // Driver says busy past this
+#define FAST_QUEUE_SIZE                 (1024*1024) // Same for -b 0
+#define APP_TICK_MS                     100     // Like the connection's tick
+#define STUCK_TIME_NS                   (60ULL*1000000000ULL)
+#define FILE_BLOCK_SIZE                 (64*1024)
+#define EXT_DIR                         "ZModemBench_Ext"
+#define SEND_FILENAME                   "ZModemBench_Send.bin"
+#define RX_FILENAME                     "ZModemBench_Rx.bin"
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct WireChunk
+{
+    uint64_t Arrive_ns;         // When the last byte gets to the other end
+    vector<uint8_t> Bytes;
+};
+
+/* One direction of the emulated serial line */
+struct Wire
+{
+    int fd;                     // Where it comes out
+    uint64_t Byte_ns;           // How long one byte takes (0 = no limit)
+    uint64_t Delay_ns;
+    uint64_t TxDone_ns;         // When the UART will be empty
+    uint64_t Pending;           // Bytes in 'Chunks'
+    uint64_t Delivered;         // Bytes that made it across
+    deque<struct WireChunk> Chunks;
+};
+
+/* One side of the transfer (the plugin and it's timer) */
+struct BenchSide
+{
+    const struct FTPHandlerInfo *Info;
+    t_FTPHandlerDataType *Data;
+    struct Wire *Out;
+    int InFD;
+    uint32_t TimeoutMS;
+    uint64_t NextTimeout_ns;
+    bool Done;
+    bool Aborted;
+    uint64_t Progress;
+};
+
+typedef enum
+{
+    e_BenchExt_None,            // Our upload to our download
+    e_BenchExt_RZ,              // Our upload to lrzsz's rz
+    e_BenchExt_SZ,              // lrzsz's sz to our download
+    e_BenchExtMAX
+} e_BenchExtType;
+
+/*** FUNCTION PROTOTYPES      ***/
+static void Bench_Usage(void);
+static bool Bench_OpenPTY(int *RetMaster,int *RetSlave);
+static bool Bench_MakeFile(const char *Filename,uint64_t Bytes);
+static bool Bench_CompareFiles(const char *File1,const char *File2);
+static uint64_t Bench_FileSize(const char *Filename);
+static int Bench_WireSend(struct Wire *W,const void *Data,uint32_t Bytes);
+static void Bench_WirePump(struct Wire *W,uint64_t Now_ns);
+static void Bench_WireDrop(struct Wire *W);
+static void Bench_Finish(struct BenchSide *Side,PG_BOOL Aborted);
+static void Bench_Timer(struct BenchSide *Side,uint64_t Now_ns);
+static void Bench_Read(struct BenchSide *Side);
+static bool Bench_StartSide(struct BenchSide *Side,uint64_t Bytes,
+        bool Resume);
+static void Bench_DropSide(struct BenchSide *Side);
+static const char *Bench_FindExternal(e_BenchExtType Ext);
+static pid_t Bench_StartExternal(e_BenchExtType Ext,const char *Prog,
+        int Slave,bool Resume);
+static void Bench_Flush(int fd);
+
+static const struct FTPS_API *Bench_GetAPI_FTPS(void);
+static void Bench_KVClear(t_PIKVList *Handle);
+static PG_BOOL Bench_KVAddItem(t_PIKVList *Handle,const char *Key,
+        const char *Value);
+static const char *Bench_KVGetItem(const t_PIKVList *Handle,const char *Key);
+static uint32_t Bench_GetExperimentalID(void);
+static PG_BOOL Bench_RegisterFileTransferProtocol(
+        const struct FTPHandlerInfo *Info);
+static const struct PI_UIAPI *Bench_GetAPI_UI(void);
+static void Bench_SetTimeout(t_FTPSystemData *SysHandle,uint32_t MSec);
+static void Bench_RestartTimeout(t_FTPSystemData *SysHandle);
+static void Bench_ULProgress(t_FTPSystemData *SysHandle,uint64_t Bytes);
+static void Bench_ULFinish(t_FTPSystemData *SysHandle,PG_BOOL Aborted);
+static int Bench_ULSendData(t_FTPSystemData *SysHandle,void *Data,
+        uint32_t Bytes);
+static void Bench_DLProgress(t_FTPSystemData *SysHandle,uint64_t Bytes);
+static void Bench_DLFinish(t_FTPSystemData *SysHandle,PG_BOOL Aborted);
+static int Bench_DLSendData(t_FTPSystemData *SysHandle,void *Data,
+        uint32_t Bytes);
+static const char *Bench_GetDownloadFilename(t_FTPSystemData *SysHandle,
+        const char *FileNameHint);
+
+extern "C"
+{
+    unsigned int ZModem_RegisterPlugin(const struct PI_SystemAPI *SysAPI,
+            unsigned int Version);
+}
+
+/*** VARIABLE DEFINITIONS     ***/
+static struct FTPS_API m_BenchFTPS=
+{
+    Bench_RegisterFileTransferProtocol,
+    Bench_GetAPI_UI,
+    Bench_SetTimeout,
+    Bench_RestartTimeout,
+    Bench_ULProgress,
+    Bench_ULFinish,
+    Bench_ULSendData,
+    Bench_DLProgress,
+    Bench_DLFinish,
+    Bench_DLSendData,
+    Bench_GetDownloadFilename,
+};
+
+static struct PI_SystemAPI m_BenchSystem=
+{
+    NULL,
+    NULL,
+    Bench_GetAPI_FTPS,
+    Bench_KVClear,
+    Bench_KVAddItem,
+    Bench_KVGetItem,
+    Bench_GetExperimentalID,
+    NULL,
+};
+
+static const struct FTPHandlerInfo *m_UploadInfo;
+static const struct FTPHandlerInfo *m_DownloadInfo;
+static struct BenchSide m_Sender;
+static struct BenchSide m_Receiver;
+static string m_DownloadFilename;
+
+/*******************************************************************************
+ * NAME:
+ *    main
+ *
+ * SYNOPSIS:
+ *    int main(int argc,char *argv[]);
+ *
+ * PARAMETERS:
+ *    argc [I] -- The number of args
+ *    argv [I] -- The args
+ *
+ * FUNCTION:
+ *    Main entry point.
+ *
+ * RETURNS:
+ *    0 -- Ok
+ *    1 -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+int main(int argc,char *argv[])
+{
+    struct Wire ToSlave;
+    struct Wire ToMaster;
+    struct pollfd fds[2];
+    struct BenchSide *Ours;
+    e_BenchExtType Ext;
+    const char *SendFile;
+    string RxFile;
+    uint64_t Start_ns;
+    uint64_t Now_ns;
+    uint64_t LastMove_ns;
+    uint64_t LastDelivered;
+    uint64_t Bytes;
+    uint64_t KillAt;
+    uint64_t ResumedFrom;
+    double Seconds;
+    double LineRate;
+    double Rate;
+    uint32_t Baud;
+    uint32_t Delay_ms;
+    pid_t Child;
+    const char *ExtProg;
+    int Status;
+    bool Resume;
+    bool Match;
+    int Master;
+    int Slave;
+    int arg;
+
+    Baud=DEFAULT_BAUD;
+    Bytes=DEFAULT_BYTES;
+    Delay_ms=DEFAULT_DELAY_MS;
+    KillAt=0;
+    Ext=e_BenchExt_None;
+    for(arg=1;arg<argc;arg++)
+    {
+        if(strcmp(argv[arg],"-b")==0 && arg+1<argc)
+            Baud=strtoul(argv[++arg],NULL,0);
+        else if(strcmp(argv[arg],"-s")==0 && arg+1<argc)
+            Bytes=strtoull(argv[++arg],NULL,0);
+        else if(strcmp(argv[arg],"-d")==0 && arg+1<argc)
+            Delay_ms=strtoul(argv[++arg],NULL,0);
+        else if(strcmp(argv[arg],"-k")==0 && arg+1<argc)
+            KillAt=strtoull(argv[++arg],NULL,0);
+        else if(strcmp(argv[arg],"-x")==0 && arg+1<argc &&
+                strcmp(argv[arg+1],"rz")==0)
+        {
+            Ext=e_BenchExt_RZ;
+            arg++;
+        }
+        else if(strcmp(argv[arg],"-x")==0 && arg+1<argc &&
+                strcmp(argv[arg+1],"sz")==0)
+        {
+            Ext=e_BenchExt_SZ;
+            arg++;
+        }
+        else
+        {
+            Bench_Usage();
+            return 1;
+        }
+    }
+    ExtProg=NULL;
+    if(Ext!=e_BenchExt_None)
+    {
+        ExtProg=Bench_FindExternal(Ext);
+        if(ExtProg==NULL)
+        {
+            fprintf(stderr,"Couldn't find %s in the PATH (is lrzsz "
+                    "installed?)\n",Ext==e_BenchExt_RZ?"rz":"sz");
+            return 1;
+        }
+    }
+
+    if(Baud!=0 && Baud<300)
+        Baud=300;
+    if(Baud==0)
+        Delay_ms=0;
+
+    if(ZModem_RegisterPlugin(&m_BenchSystem,0xFFFFFFFF)!=0 ||
+            m_UploadInfo==NULL || m_DownloadInfo==NULL)
+    {
+        fprintf(stderr,"Failed to register the ZModem plugin\n");
+        return 1;
+    }
+
+    SendFile=SEND_FILENAME;
+    m_DownloadFilename=RX_FILENAME;
+    RxFile=m_DownloadFilename;
+    if(Ext==e_BenchExt_RZ)
+        RxFile=EXT_DIR "/" SEND_FILENAME;
+    unlink(RxFile.c_str());
+    if(Ext!=e_BenchExt_None)
+        mkdir(EXT_DIR,0777);
+
+    if(!Bench_MakeFile(SendFile,Bytes))
+    {
+        fprintf(stderr,"Failed to make the file to send\n");
+        return 1;
+    }
+
+    if(!Bench_OpenPTY(&Master,&Slave))
+    {
+        fprintf(stderr,"Failed to open a pty pair\n");
+        return 1;
+    }
+    fcntl(Master,F_SETFL,fcntl(Master,F_GETFL)|O_NONBLOCK);
+    fcntl(Slave,F_SETFL,fcntl(Slave,F_GETFL)|O_NONBLOCK);
+
+    /* 8N1 is 10 bits a byte */
+    ToSlave.fd=Master;
+    ToSlave.Byte_ns=Baud==0?0:10000000000ULL/Baud;
+    ToSlave.Delay_ns=(uint64_t)Delay_ms*1000000;
+    ToSlave.TxDone_ns=0;
+    ToSlave.Pending=0;
+    ToSlave.Delivered=0;
+    ToMaster=ToSlave;
+    ToMaster.fd=Slave;
+
+    /* Our sender is on the master side, our receiver on the slave side.
+       When one side is lrzsz it gets the slave and our side moves to the
+       master. */
+    memset(&m_Sender,0x00,sizeof(m_Sender));
+    m_Sender.Info=m_UploadInfo;
+    m_Sender.Out=&ToSlave;
+    m_Sender.InFD=Master;
+    memset(&m_Receiver,0x00,sizeof(m_Receiver));
+    m_Receiver.Info=m_DownloadInfo;
+    m_Receiver.Out=&ToMaster;
+    m_Receiver.InFD=Slave;
+    Ours=NULL;
+    if(Ext==e_BenchExt_SZ)
+    {
+        m_Receiver.Out=&ToSlave;
+        m_Receiver.InFD=Master;
+        m_Sender.Done=true;
+        Ours=&m_Receiver;
+    }
+    else if(Ext==e_BenchExt_RZ)
+    {
+        m_Receiver.Done=true;
+        Ours=&m_Sender;
+    }
+
+    Resume=false;
+    ResumedFrom=0;
+    Child=-1;
+    Start_ns=GetElapsedTime_ns();
+    for(;;)
+    {
+        if(Ext==e_BenchExt_None)
+        {
+            if(!Bench_StartSide(&m_Sender,Bytes,Resume) ||
+                    !Bench_StartSide(&m_Receiver,Bytes,Resume))
+            {
+                fprintf(stderr,"Failed to start the transfer\n");
+                return 1;
+            }
+        }
+        else
+        {
+            Child=Bench_StartExternal(Ext,ExtProg,Slave,Resume);
+            if(Child<0 || !Bench_StartSide(Ours,Bytes,Resume))
+            {
+                fprintf(stderr,"Failed to start the transfer\n");
+                return 1;
+            }
+        }
+
+        LastMove_ns=GetElapsedTime_ns();
+        LastDelivered=0;
+        while(!m_Sender.Done || !m_Receiver.Done || Child>0)
+        {
+            Now_ns=GetElapsedTime_ns();
+
+            Bench_WirePump(&ToSlave,Now_ns);
+            if(Ext==e_BenchExt_None)
+                Bench_WirePump(&ToMaster,Now_ns);
+            Bench_Read(&m_Receiver);
+            Bench_Read(&m_Sender);
+            Bench_Timer(&m_Sender,Now_ns);
+            Bench_Timer(&m_Receiver,Now_ns);
+
+            if(Child>0 && waitpid(Child,&Status,WNOHANG)==Child)
+            {
+                if(WIFEXITED(Status) && WEXITSTATUS(Status)==127)
+                {
+                    fprintf(stderr,"Failed to run %s\n",ExtProg);
+                    return 1;
+                }
+                if(!WIFEXITED(Status) || WEXITSTATUS(Status)!=0)
+                    fprintf(stderr,"lrzsz failed\n");
+                Child=-1;
+            }
+
+            if(ToSlave.Delivered+ToMaster.Delivered!=LastDelivered)
+            {
+                LastDelivered=ToSlave.Delivered+ToMaster.Delivered;
+                LastMove_ns=Now_ns;
+            }
+            else if(Now_ns-LastMove_ns>STUCK_TIME_NS)
+            {
+                fprintf(stderr,"Gave up (the transfer is stuck)\n");
+                if(Child>0)
+                    kill(Child,SIGKILL);
+                return 1;
+            }
+
+            if(KillAt!=0 && ToSlave.Delivered+ToMaster.Delivered>=KillAt)
+                break;
+
+            fds[0].fd=Master;
+            fds[0].events=POLLIN;
+            fds[1].fd=Slave;
+            fds[1].events=POLLIN;
+            poll(fds,Ext==e_BenchExt_None?2:1,1);
+        }
+
+        if(KillAt==0 || ToSlave.Delivered+ToMaster.Delivered<KillAt)
+            break;
+
+        /* Pull the plug.  Nothing either side sends from here gets through
+           and both sides give up. */
+        printf("Dropped the line after %" PRIu64 " bytes\n",
+                ToSlave.Delivered+ToMaster.Delivered);
+        KillAt=0;
+        Bench_DropSide(&m_Sender);
+        Bench_DropSide(&m_Receiver);
+        if(Child>0)
+        {
+            kill(Child,SIGKILL);
+            waitpid(Child,&Status,0);
+            Child=-1;
+        }
+        Bench_WireDrop(&ToSlave);
+        Bench_WireDrop(&ToMaster);
+        Bench_Flush(Master);
+        Bench_Flush(Slave);
+
+        ResumedFrom=Bench_FileSize(RxFile.c_str());
+        printf("Resuming from %" PRIu64 " bytes\n",ResumedFrom);
+        Resume=true;
+        if(Ext==e_BenchExt_SZ)
+            m_Sender.Done=true;
+        else if(Ext==e_BenchExt_RZ)
+            m_Receiver.Done=true;
+        ToSlave.Delivered=0;
+        ToMaster.Delivered=0;
+    }
+    Seconds=(GetElapsedTime_ns()-Start_ns)/1e9;
+
+    Match=!m_Sender.Aborted && !m_Receiver.Aborted &&
+            Bench_CompareFiles(SendFile,RxFile.c_str());
+
+    LineRate=Baud/10.0;
+    Rate=Bytes/Seconds;
+    printf("ZModem%s, %" PRIu64 " bytes at ",
+            Ext==e_BenchExt_RZ?" to rz":Ext==e_BenchExt_SZ?" from sz":"",
+            Bytes);
+    if(Baud==0)
+        printf("pty speed\n");
+    else
+        printf("%u baud, %u ms each way\n",Baud,Delay_ms);
+    printf("    Time: %.3f s\n",Seconds);
+    if(Baud==0)
+        printf("    Throughput: %.0f bytes/s\n",Rate);
+    else
+        printf("    Throughput: %.0f bytes/s (%.1f%% of line rate)\n",Rate,
+                Rate*100.0/LineRate);
+    if(Resume)
+    {
+        printf("    Resent after the drop: %" PRIu64 " bytes\n",
+                ToSlave.Delivered+ToMaster.Delivered);
+    }
+    printf("    File: %s\n",Match?"matches":"DOES NOT MATCH");
+
+    close(Slave);
+    close(Master);
+    unlink(SendFile);
+    unlink(RxFile.c_str());
+    if(Ext!=e_BenchExt_None)
+        rmdir(EXT_DIR);
+
+    return Match?0:1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Usage
+ *
+ * SYNOPSIS:
+ *    static void Bench_Usage(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function prints the usage.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Usage(void)
+{
+    printf("USAGE:\n");
+    printf("    ZModemBench [-b baud] [-s bytes] [-d ms] [-k bytes] "
+            "[-x rz|sz]\n");
+    printf("\n");
+    printf("    -b -- The baud rate of the emulated line (default %d).  0 "
+            "runs at pty speed\n",DEFAULT_BAUD);
+    printf("    -s -- How many bytes to send (default %d)\n",DEFAULT_BYTES);
+    printf("    -d -- The delay each way in ms (default %d)\n",
+            DEFAULT_DELAY_MS);
+    printf("    -k -- Drop the line after this many bytes and resume\n");
+    printf("    -x -- Run against lrzsz.  rz = we send, sz = we receive\n");
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_OpenPTY
+ *
+ * SYNOPSIS:
+ *    static bool Bench_OpenPTY(int *RetMaster,int *RetSlave);
+ *
+ * PARAMETERS:
+ *    RetMaster [O] -- The master side of the pty
+ *    RetSlave [O] -- The slave side of the pty
+ *
+ * FUNCTION:
+ *    This function opens a pty pair and puts the slave in raw mode so
+ *    binary data goes through untouched.
+ *
+ * RETURNS:
+ *    true -- Things worked
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool Bench_OpenPTY(int *RetMaster,int *RetSlave)
+{
+    struct termios tio;
+    char *SlaveName;
+    int Master;
+    int Slave;
+
+    Master=posix_openpt(O_RDWR|O_NOCTTY);
+    if(Master<0)
+        return false;
+
+    if(grantpt(Master)!=0 || unlockpt(Master)!=0)
+    {
+        close(Master);
+        return false;
+    }
+
+    SlaveName=ptsname(Master);
+    if(SlaveName==NULL)
+    {
+        close(Master);
+        return false;
+    }
+
+    Slave=open(SlaveName,O_RDWR|O_NOCTTY);
+    if(Slave<0)
+    {
+        close(Master);
+        return false;
+    }
+
+    tcgetattr(Slave,&tio);
+    cfmakeraw(&tio);
+    tio.c_cc[VMIN]=1;
+    tio.c_cc[VTIME]=0;
+    tcsetattr(Slave,TCSANOW,&tio);
+
+    *RetMaster=Master;
+    *RetSlave=Slave;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_MakeFile
+ *
+ * SYNOPSIS:
+ *    static bool Bench_MakeFile(const char *Filename,uint64_t Bytes);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to make
+ *    Bytes [I] -- How big to make it
+ *
+ * FUNCTION:
+ *    This function makes a file of random bytes to send.  It's done a block
+ *    at a time with a xorshift so multi-GB files don't take forever.
+ *
+ * RETURNS:
+ *    true -- Things worked
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool Bench_MakeFile(const char *Filename,uint64_t Bytes)
+{
+    static uint64_t Block[FILE_BLOCK_SIZE/8];
+    FILE *out;
+    uint64_t Seed;
+    uint64_t Left;
+    size_t Chunk;
+    unsigned int r;
+    bool RetValue;
+
+    out=fopen(Filename,"wb");
+    if(out==NULL)
+        return false;
+
+    Seed=0x123456789ABCDEFULL;
+    RetValue=true;
+    for(Left=Bytes;Left>0;Left-=Chunk)
+    {
+        for(r=0;r<FILE_BLOCK_SIZE/8;r++)
+        {
+            Seed^=Seed<<13;
+            Seed^=Seed>>7;
+            Seed^=Seed<<17;
+            Block[r]=Seed;
+        }
+        Chunk=Left>FILE_BLOCK_SIZE?FILE_BLOCK_SIZE:Left;
+        if(fwrite(Block,1,Chunk,out)!=Chunk)
+        {
+            RetValue=false;
+            break;
+        }
+    }
+    fclose(out);
+
+    return RetValue;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_CompareFiles
+ *
+ * SYNOPSIS:
+ *    static bool Bench_CompareFiles(const char *File1,const char *File2);
+ *
+ * PARAMETERS:
+ *    File1 [I] -- The first file
+ *    File2 [I] -- The second file
+ *
+ * FUNCTION:
+ *    This function checks that the file we got is the same as the one we
+ *    sent (same size, same bytes).
+ *
+ * RETURNS:
+ *    true -- They match
+ *    false -- They are different (or one couldn't be opened)
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool Bench_CompareFiles(const char *File1,const char *File2)
+{
+    static uint8_t Buff1[FILE_BLOCK_SIZE];
+    static uint8_t Buff2[FILE_BLOCK_SIZE];
+    FILE *in1;
+    FILE *in2;
+    size_t Got1;
+    size_t Got2;
+    bool RetValue;
+
+    in1=fopen(File1,"rb");
+    in2=fopen(File2,"rb");
+    if(in1==NULL || in2==NULL)
+    {
+        if(in1!=NULL)
+            fclose(in1);
+        if(in2!=NULL)
+            fclose(in2);
+        return false;
+    }
+
+    do
+    {
+        Got1=fread(Buff1,1,sizeof(Buff1),in1);
+        Got2=fread(Buff2,1,sizeof(Buff2),in2);
+        RetValue=(Got1==Got2 && memcmp(Buff1,Buff2,Got1)==0);
+    } while(RetValue && Got1==sizeof(Buff1));
+
+    fclose(in1);
+    fclose(in2);
+
+    return RetValue;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_FileSize
+ *
+ * SYNOPSIS:
+ *    static uint64_t Bench_FileSize(const char *Filename);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to get the size of
+ *
+ * FUNCTION:
+ *    This function gets the size of a file.
+ *
+ * RETURNS:
+ *    The size of the file or 0 if it isn't there.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static uint64_t Bench_FileSize(const char *Filename)
+{
+    struct stat st;
+
+    if(stat(Filename,&st)!=0)
+        return 0;
+    return st.st_size;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_WireSend
+ *
+ * SYNOPSIS:
+ *    static int Bench_WireSend(struct Wire *W,const void *Data,
+ *          uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    W [I] -- The direction to send on
+ *    Data [I] -- The bytes to send
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function queues bytes in the emulated UART.  If the UART doesn't
+ *    have room for all of them we say busy (like the IO drivers do).  The
+ *    bytes come out the other end after they have been clocked out at the
+ *    baud rate plus the line delay.
+ *
+ * RETURNS:
+ *    e_FTPS_SendDataRet_Success or e_FTPS_SendDataRet_Busy
+ *
+ * SEE ALSO:
+ *    Bench_WirePump()
+ ******************************************************************************/
+static int Bench_WireSend(struct Wire *W,const void *Data,uint32_t Bytes)
+{
+    struct WireChunk Chunk;
+    uint64_t Now_ns;
+    uint64_t Queued;
+
+    Now_ns=GetElapsedTime_ns();
+    if(W->Byte_ns==0)
+    {
+        /* No line, just don't let it queue up forever */
+        if(W->Pending+Bytes>FAST_QUEUE_SIZE)
+            return e_FTPS_SendDataRet_Busy;
+        Chunk.Arrive_ns=Now_ns;
+    }
+    else
+    {
+        if(W->TxDone_ns<Now_ns)
+            W->TxDone_ns=Now_ns;
+
+        Queued=(W->TxDone_ns-Now_ns)/W->Byte_ns;
+        if(Queued+Bytes>UART_QUEUE_SIZE)
+            return e_FTPS_SendDataRet_Busy;
+
+        W->TxDone_ns+=Bytes*W->Byte_ns;
+        Chunk.Arrive_ns=W->TxDone_ns+W->Delay_ns;
+    }
+    Chunk.Bytes.assign((const uint8_t *)Data,(const uint8_t *)Data+Bytes);
+    W->Chunks.push_back(Chunk);
+    W->Pending+=Bytes;
+
+    return e_FTPS_SendDataRet_Success;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_WirePump
+ *
+ * SYNOPSIS:
+ *    static void Bench_WirePump(struct Wire *W,uint64_t Now_ns);
+ *
+ * PARAMETERS:
+ *    W [I] -- The direction to move bytes on
+ *    Now_ns [I] -- The current time
+ *
+ * FUNCTION:
+ *    This function writes the bytes that have made it across the emulated
+ *    line into the pty.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Bench_WireSend()
+ ******************************************************************************/
+static void Bench_WirePump(struct Wire *W,uint64_t Now_ns)
+{
+    struct WireChunk *Chunk;
+    ssize_t Wrote;
+
+    while(!W->Chunks.empty())
+    {
+        Chunk=&W->Chunks.front();
+        if(Chunk->Arrive_ns>Now_ns)
+            break;
+
+        Wrote=write(W->fd,Chunk->Bytes.data(),Chunk->Bytes.size());
+        if(Wrote<=0)
+            break;
+        W->Pending-=Wrote;
+        W->Delivered+=Wrote;
+        if((size_t)Wrote<Chunk->Bytes.size())
+        {
+            /* The pty is full, do the rest next time */
+            Chunk->Bytes.erase(Chunk->Bytes.begin(),
+                    Chunk->Bytes.begin()+Wrote);
+            break;
+        }
+        W->Chunks.pop_front();
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_WireDrop
+ *
+ * SYNOPSIS:
+ *    static void Bench_WireDrop(struct Wire *W);
+ *
+ * PARAMETERS:
+ *    W [I] -- The direction to empty
+ *
+ * FUNCTION:
+ *    This function throws away everything that is on the line (the line
+ *    went down).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_WireDrop(struct Wire *W)
+{
+    W->Chunks.clear();
+    W->Pending=0;
+    W->TxDone_ns=0;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Flush
+ *
+ * SYNOPSIS:
+ *    static void Bench_Flush(int fd);
+ *
+ * PARAMETERS:
+ *    fd [I] -- The side of the pty to empty
+ *
+ * FUNCTION:
+ *    This function reads and throws away anything waiting in the pty.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Flush(int fd)
+{
+    uint8_t Buff[4096];
+
+    while(read(fd,Buff,sizeof(Buff))>0)
+        ;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_StartSide
+ *
+ * SYNOPSIS:
+ *    static bool Bench_StartSide(struct BenchSide *Side,uint64_t Bytes,
+ *          bool Resume);
+ *
+ * PARAMETERS:
+ *    Side [I] -- The side to start (m_Sender or m_Receiver)
+ *    Bytes [I] -- The size of the file being sent
+ *    Resume [I] -- Turn on resume
+ *
+ * FUNCTION:
+ *    This function allocates the plugin's data and starts the upload or
+ *    download.
+ *
+ * RETURNS:
+ *    true -- Things worked
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool Bench_StartSide(struct BenchSide *Side,uint64_t Bytes,
+        bool Resume)
+{
+    static map<string,string> Options;
+
+    Options.clear();
+    Options["Resume"]=Resume?"1":"0";
+
+    Side->Done=false;
+    Side->Aborted=false;
+    Side->TimeoutMS=0;
+    Side->Progress=0;
+    Side->Data=Side->Info->API->AllocateData();
+    if(Side->Data==NULL)
+        return false;
+
+    if(Side==&m_Sender)
+    {
+        return m_UploadInfo->API->StartUpload((t_FTPSystemData *)Side,
+                Side->Data,SEND_FILENAME,SEND_FILENAME,Bytes,
+                (t_PIKVList *)&Options);
+    }
+
+    return m_DownloadInfo->API->StartDownload((t_FTPSystemData *)Side,
+            Side->Data,(t_PIKVList *)&Options);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_DropSide
+ *
+ * SYNOPSIS:
+ *    static void Bench_DropSide(struct BenchSide *Side);
+ *
+ * PARAMETERS:
+ *    Side [I] -- The side to drop
+ *
+ * FUNCTION:
+ *    This function aborts a side (like the user would after the line went
+ *    down) and frees it's data.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_DropSide(struct BenchSide *Side)
+{
+    if(Side->Done)
+        return;
+
+    Side->Info->API->AbortTransfer((t_FTPSystemData *)Side,Side->Data);
+    Side->Info->API->FreeData(Side->Data);
+    Side->Data=NULL;
+    Side->Done=true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_FindExternal
+ *
+ * SYNOPSIS:
+ *    static const char *Bench_FindExternal(e_BenchExtType Ext);
+ *
+ * PARAMETERS:
+ *    Ext [I] -- What we want to run (rz or sz)
+ *
+ * FUNCTION:
+ *    This function looks in the PATH for the lrzsz program.  Most distros
+ *    install it as rz / sz but some use lrz / lsz.
+ *
+ * RETURNS:
+ *    The name to run or NULL if it isn't installed.
+ *
+ * SEE ALSO:
+ *    Bench_StartExternal()
+ ******************************************************************************/
+static const char *Bench_FindExternal(e_BenchExtType Ext)
+{
+    static const char *RZNames[]={"rz","lrz",NULL};
+    static const char *SZNames[]={"sz","lsz",NULL};
+    const char **Names;
+    const char *Path;
+    const char *Start;
+    const char *End;
+    string Dir;
+    string Prog;
+    int r;
+
+    Names=Ext==e_BenchExt_RZ?RZNames:SZNames;
+    Path=getenv("PATH");
+    if(Path==NULL)
+        return NULL;
+
+    for(r=0;Names[r]!=NULL;r++)
+    {
+        Start=Path;
+        for(;;)
+        {
+            End=strchr(Start,':');
+            if(End==NULL)
+                End=Start+strlen(Start);
+            Dir.assign(Start,End-Start);
+            if(Dir.empty())
+                Dir=".";
+            Prog=Dir+"/"+Names[r];
+            if(access(Prog.c_str(),X_OK)==0)
+                return Names[r];
+            if(*End==0)
+                break;
+            Start=End+1;
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_StartExternal
+ *
+ * SYNOPSIS:
+ *    static pid_t Bench_StartExternal(e_BenchExtType Ext,const char *Prog,
+ *          int Slave,bool Resume);
+ *
+ * PARAMETERS:
+ *    Ext [I] -- What to run (rz or sz)
+ *    Prog [I] -- The name to run it as (from Bench_FindExternal())
+ *    Slave [I] -- The slave side of the pty
+ *    Resume [I] -- Ask lrzsz to resume (-r)
+ *
+ * FUNCTION:
+ *    This function runs lrzsz in EXT_DIR with it's stdin / stdout on the
+ *    slave side of the pty.
+ *
+ * RETURNS:
+ *    The pid of the child or -1 if it couldn't be started.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static pid_t Bench_StartExternal(e_BenchExtType Ext,const char *Prog,
+        int Slave,bool Resume)
+{
+    pid_t Child;
+    int fd;
+
+    Child=fork();
+    if(Child!=0)
+        return Child;
+
+    fd=dup(Slave);
+    fcntl(fd,F_SETFL,fcntl(fd,F_GETFL)&~O_NONBLOCK);
+    dup2(fd,0);
+    dup2(fd,1);
+    if(chdir(EXT_DIR)!=0)
+        _exit(1);
+
+    if(Ext==e_BenchExt_RZ)
+    {
+        if(Resume)
+            execlp(Prog,Prog,"-b","-q","-r",(char *)NULL);
+        else
+            execlp(Prog,Prog,"-b","-q","-y",(char *)NULL);
+    }
+    else
+    {
+        if(Resume)
+        {
+            execlp(Prog,Prog,"-b","-q","-r","../" SEND_FILENAME,
+                    (char *)NULL);
+        }
+        else
+        {
+            execlp(Prog,Prog,"-b","-q","../" SEND_FILENAME,(char *)NULL);
+        }
+    }
+    _exit(127);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Read
+ *
+ * SYNOPSIS:
+ *    static void Bench_Read(struct BenchSide *Side);
+ *
+ * PARAMETERS:
+ *    Side [I] -- The side to read for
+ *
+ * FUNCTION:
+ *    This function reads what has come in on the pty and gives it to the
+ *    plugin (like the connection does).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Read(struct BenchSide *Side)
+{
+    uint8_t Buff[4096];
+    ssize_t Got;
+
+    while(!Side->Done)
+    {
+        Got=read(Side->InFD,Buff,sizeof(Buff));
+        if(Got<=0)
+            break;
+        Side->Info->API->RxData((t_FTPSystemData *)Side,Side->Data,Buff,Got);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Timer
+ *
+ * SYNOPSIS:
+ *    static void Bench_Timer(struct BenchSide *Side,uint64_t Now_ns);
+ *
+ * PARAMETERS:
+ *    Side [I] -- The side to run the timer for
+ *    Now_ns [I] -- The current time
+ *
+ * FUNCTION:
+ *    This function calls the plugin's timeout when it's timer goes off.
+ *    Like the connection, timeouts under the app tick run on their own
+ *    timer and the rest are rounded up to the app tick.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Timer(struct BenchSide *Side,uint64_t Now_ns)
+{
+    uint32_t MS;
+
+    if(Side->Done || Side->TimeoutMS==0 || Now_ns<Side->NextTimeout_ns)
+        return;
+
+    MS=Side->TimeoutMS;
+    if(MS>=APP_TICK_MS)
+        MS=(MS+APP_TICK_MS-1)/APP_TICK_MS*APP_TICK_MS;
+    Side->NextTimeout_ns=Now_ns+(uint64_t)MS*1000000;
+
+    Side->Info->API->Timeout((t_FTPSystemData *)Side,Side->Data);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Bench_Finish
+ *
+ * SYNOPSIS:
+ *    static void Bench_Finish(struct BenchSide *Side,PG_BOOL Aborted);
+ *
+ * PARAMETERS:
+ *    Side [I] -- The side that finished
+ *    Aborted [I] -- Did the transfer fail
+ *
+ * FUNCTION:
+ *    This function handles a side finishing.  Like the real system it frees
+ *    the plugin's data.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void Bench_Finish(struct BenchSide *Side,PG_BOOL Aborted)
+{
+    const char *Msg;
+
+    if(Aborted)
+    {
+        Msg=Side->Info->API->GetLastErrorMsg((t_FTPSystemData *)Side,
+                Side->Data);
+        fprintf(stderr,"%s aborted: %s\n",Side->Info->IDStr,
+                Msg==NULL?"":Msg);
+    }
+
+    Side->Info->API->FreeData(Side->Data);
+    Side->Data=NULL;
+    Side->Done=true;
+    Side->Aborted=Aborted;
+}
+
+static const struct FTPS_API *Bench_GetAPI_FTPS(void)
+{
+    return &m_BenchFTPS;
+}
+
+static void Bench_KVClear(t_PIKVList *Handle)
+{
+    ((map<string,string> *)Handle)->clear();
+}
+
+static PG_BOOL Bench_KVAddItem(t_PIKVList *Handle,const char *Key,
+        const char *Value)
+{
+    (*(map<string,string> *)Handle)[Key]=Value;
+    return true;
+}
+
+static const char *Bench_KVGetItem(const t_PIKVList *Handle,const char *Key)
+{
+    const map<string,string> *KV=(const map<string,string> *)Handle;
+    map<string,string>::const_iterator i;
+
+    i=KV->find(Key);
+    if(i==KV->end())
+        return NULL;
+    return i->second.c_str();
+}
+
+static uint32_t Bench_GetExperimentalID(void)
+{
+    return 0;
+}
+
+static PG_BOOL Bench_RegisterFileTransferProtocol(
+        const struct FTPHandlerInfo *Info)
+{
+    if(Info->Mode==e_FileTransferProtocolMode_Upload)
+        m_UploadInfo=Info;
+    else
+        m_DownloadInfo=Info;
+    return true;
+}
+
+static const struct PI_UIAPI *Bench_GetAPI_UI(void)
+{
+    return NULL;
+}
+
+static void Bench_SetTimeout(t_FTPSystemData *SysHandle,uint32_t MSec)
+{
+    struct BenchSide *Side=(struct BenchSide *)SysHandle;
+
+    Side->TimeoutMS=MSec;
+    Side->NextTimeout_ns=GetElapsedTime_ns()+(uint64_t)MSec*1000000;
+}
+
+static void Bench_RestartTimeout(t_FTPSystemData *SysHandle)
+{
+    struct BenchSide *Side=(struct BenchSide *)SysHandle;
+
+    Side->NextTimeout_ns=GetElapsedTime_ns()+
+            (uint64_t)Side->TimeoutMS*1000000;
+}
+
+static void Bench_ULProgress(t_FTPSystemData *SysHandle,uint64_t Bytes)
+{
+    ((struct BenchSide *)SysHandle)->Progress=Bytes;
+}
+
+static void Bench_ULFinish(t_FTPSystemData *SysHandle,PG_BOOL Aborted)
+{
+    Bench_Finish((struct BenchSide *)SysHandle,Aborted);
+}
+
+static int Bench_ULSendData(t_FTPSystemData *SysHandle,void *Data,
+        uint32_t Bytes)
+{
+    return Bench_WireSend(((struct BenchSide *)SysHandle)->Out,Data,Bytes);
+}
+
+static void Bench_DLProgress(t_FTPSystemData *SysHandle,uint64_t Bytes)
+{
+    ((struct BenchSide *)SysHandle)->Progress=Bytes;
+}
+
+static void Bench_DLFinish(t_FTPSystemData *SysHandle,PG_BOOL Aborted)
+{
+    Bench_Finish((struct BenchSide *)SysHandle,Aborted);
+}
+
+static int Bench_DLSendData(t_FTPSystemData *SysHandle,void *Data,
+        uint32_t Bytes)
+{
+    return Bench_WireSend(((struct BenchSide *)SysHandle)->Out,Data,Bytes);
+}
+
+static const char *Bench_GetDownloadFilename(t_FTPSystemData *SysHandle,
+        const char *FileNameHint)
+{
+    return m_DownloadFilename.c_str();
+}
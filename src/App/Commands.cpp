@@ -219,6 +219,9 @@ const char *m_CmdNames[]=
     "TermEmuSettings",                      // e_Cmd_TermEmuSettings
     "NewVersionCheck",                      // e_Cmd_NewVersionCheck
     "GotoWebSite",                          // e_Cmd_GotoWebSite
+    "SaveSelection",                        // e_Cmd_SaveSelection
+    "FindBytes",                            // e_Cmd_FindBytes
+    "FindBytesNext",                        // e_Cmd_FindBytesNext
 };
 
 e_CmdType m_Cmd2MenuMapping[]=
@@ -878,12 +881,13 @@ void DefaultCmdKeyMapping(struct CommandKeySeq *KeyMapping)
     // e_Cmd_TermEmuSettings
     // e_Cmd_NewVersionCheck
     // e_Cmd_GotoWebSite
+    // e_Cmd_SaveSelection
+    SetKeySeq(&KeyMapping[e_Cmd_FindBytes],KEYMOD_SHIFT|KEYMOD_CONTROL,e_UIKeysMAX,'F');
+    SetKeySeq(&KeyMapping[e_Cmd_FindBytesNext],KEYMOD_SHIFT|KEYMOD_CONTROL,e_UIKeysMAX,'H');
 
 /* Other commands / key seq do to:
  * Select All???    Shift+Ctrl+A
  * New Window       Shift+Ctrl+N
- * Find             Shift+Ctrl+F
- * Find Next        Shift+Ctrl+H (F3?)
  * Find Prev        Shift+Ctrl+G
  * Next Tab         Ctrl+Page Down
  * Prev Tab         Ctrl+Page Up
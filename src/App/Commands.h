@@ -210,6 +210,9 @@ typedef enum
     e_Cmd_TermEmuSettings,
     e_Cmd_NewVersionCheck,
     e_Cmd_GotoWebSite,
+    e_Cmd_SaveSelection,
+    e_Cmd_FindBytes,
+    e_Cmd_FindBytesNext,
     e_CmdMAX
 } e_CmdType;
 
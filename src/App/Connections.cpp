@@ -41,12 +41,14 @@
 #include "App/MainWindow.h"
 #include "App/DataProcessorsSystem.h"
 #include "App/FileTransferProtocolSystem.h"
+#include "App/PerfStats.h"
 #include "App/Display/DisplayText.h"
 #include "App/Display/DisplayBinary.h"
 #include "App/Settings.h"
 #include "App/Session.h"
 #include "App/SendBuffer.h"
 #include "OS/OSTime.h"
+#include "OS/Thread.h"
 #include "UI/UIAsk.h"
 #include "UI/UIClipboard.h"
 #include "UI/UIDebug.h"
@@ -72,8 +74,19 @@ using namespace std;
 //#define MAX_TIME_2_PROCESS_BYTES        1000  // 1000mS to process as many bytes as we can before we handle UI events again
 
 #define AUTOLAP_TIMEOUT                 500     // in ms
-#define TRANSMIT_DELAY_BUFFER_SIZE      4000    // A little under a page size
+#define TRANSMIT_DELAY_POLL_MS          10      // How often we pick up what the transmit pacer sent
+#define TRANSMIT_DELAY_DRAIN_CHUNK      1024    // How much we pick up from the pacer at a time
 #define SMART_CLIPBOARD_PASTE_TIME      250     // 250ms
+#define COMTEST_SEND_POLL_MS            10      // Longest the com test sender sleeps before checking for quit
+#define COMTEST_RATE_WINDOW_NS          1000000000ULL   // How often the com test rx rate is worked out
+#define SELEXTRACT_SYNC_LINES           10000   // Selections with more lines than this are extracted in the background
+#define SELEXTRACT_CHUNK_BYTES          65536   // How much of the selection we get from the display at a time
+#define SELEXTRACT_TICK_MS              20      // How long we extract for before letting the UI run again
+#define PASTE_SYNC_BYTES                4096    // Pastes bigger than this are sent in the background
+#define PASTE_CHUNK_BYTES               4096    // How much of the paste we hand to WriteData() at a time
+#define PASTE_TICK_MS                   20      // How long we send for before letting the UI run again
+#define PASTE_BUSY_RETRY_MS             10      // How long we wait when the driver is full
+#define ZMODEM_AUTO_DOWNLOAD_ID         "ZModemDownload"
 
 #define MAX_BELL_RATE                   100     // We have to have at least this many ms between bell sounds
 
@@ -84,13 +97,20 @@ typedef list<class Connection *> t_ConnectionListType;
 typedef t_ConnectionListType::iterator i_ConnectionListType;
 
 /*** FUNCTION PROTOTYPES      ***/
-void Con_ComTestTimeout(uintptr_t UserData);
+void Con_ComTestSendThread(void *Arg);
+e_TxPacerWriteType Con_TxPaceWrite(uintptr_t UserData,const uint8_t *Data,
+        uint32_t Bytes,uint32_t *Written);
 void Con_DelayTransmitTimeout(uintptr_t UserData);
 void Con_SmartClipTimeout(uintptr_t UserData);
 void Con_AutoReopenTimeout(uintptr_t UserData);
+void Con_SelectionExtractTimeout(uintptr_t UserData);
+void Con_PasteTimeout(uintptr_t UserData);
+void Con_FileTransTimeout(uintptr_t UserData);
+void Con_ZModemAutoStartTimeout(uintptr_t UserData);
 
 /*** VARIABLE DEFINITIONS     ***/
 t_ConnectionListType m_Connections;
+static uint32_t m_ConNextSessionGeneration=1;   // Shared so a generation is never reused (even by a new connection)
 
 void Connection::Debug1(void)
 {
@@ -222,60 +242,59 @@ bool Con_DisplayBufferEvent(const struct DBEvent *Event)
 
 /*******************************************************************************
  * NAME:
- *    Con_FileTransTick
+ *    Con_ComTestSendThread
  *
  * SYNOPSIS:
- *    void Con_FileTransTick(void);
+ *    void Con_ComTestSendThread(void *Arg);
  *
  * PARAMETERS:
- *    NONE
+ *    Arg [I] -- The connection that this thread is sending for
  *
  * FUNCTION:
- *    This function sends a file transfer tick to all the connections.
+ *    This function is the thread entry for sending com test packets.  It
+ *    just calls the ComTestSendThread() function.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    Connection::ComTestSendThread()
  ******************************************************************************/
-void Con_FileTransTick(void)
+void Con_ComTestSendThread(void *Arg)
 {
-    i_ConnectionListType Con;
-    class Connection *ConPtr;
-
-    for(Con=m_Connections.begin();Con!=m_Connections.end();Con++)
-    {
-        ConPtr=*Con;
-        ConPtr->FileTransTick();
-    }
+    class Connection *Con=(class Connection *)Arg;
+    Con->ComTestSendThread();
 }
 
 /*******************************************************************************
  * NAME:
- *    Con_ComTestTimeout
+ *    Con_TxPaceWrite
  *
  * SYNOPSIS:
- *    void Con_ComTestTimeout(uintptr_t UserData);
+ *    e_TxPacerWriteType Con_TxPaceWrite(uintptr_t UserData,
+ *          const uint8_t *Data,uint32_t Bytes,uint32_t *Written);
  *
  * PARAMETERS:
- *    UsedData [I] -- The connection that this timer is for
+ *    UserData [I] -- The connection (class Connection *)
+ *    Data [I] -- The bytes to send
+ *    Bytes [I] -- The number of bytes to send
+ *    Written [O] -- The number of bytes the driver took
  *
  * FUNCTION:
- *    This function is a call back from the UI that is called when the
- *    send timer goes off for the com test.  It just calls the
- *    InformOfComTestTimeout() function.
+ *    This function is called from the transmit pacer's thread to send
+ *    bytes.  It just calls the TxPaceWrite() function.
  *
  * RETURNS:
- *    NONE
+ *    See TxPacer::Init()
  *
  * SEE ALSO:
- *    Connection::InformOfComTestTimeout()
+ *    Connection::TxPaceWrite()
  ******************************************************************************/
-void Con_ComTestTimeout(uintptr_t UserData)
+e_TxPacerWriteType Con_TxPaceWrite(uintptr_t UserData,const uint8_t *Data,
+        uint32_t Bytes,uint32_t *Written)
 {
     class Connection *Con=(class Connection *)UserData;
-    Con->InformOfComTestTimeout();
+    return Con->TxPaceWrite(Data,Bytes,Written);
 }
 
 /*******************************************************************************
@@ -332,6 +351,114 @@ void Con_SmartClipTimeout(uintptr_t UserData)
     Con->InformOfSmartClipTimeout();
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Con_SelectionExtractTimeout
+ *
+ * SYNOPSIS:
+ *    void Con_SelectionExtractTimeout(uintptr_t UserData);
+ *
+ * PARAMETERS:
+ *    UsedData [I] -- The connection that this timer is for
+ *
+ * FUNCTION:
+ *    This function is a call back from the UI that is called when the
+ *    selection extract timer goes off.  It just calls the
+ *    InformOfSelectionExtractTimeout() function.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    
+ ******************************************************************************/
+void Con_SelectionExtractTimeout(uintptr_t UserData)
+{
+    class Connection *Con=(class Connection *)UserData;
+    Con->InformOfSelectionExtractTimeout();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Con_PasteTimeout
+ *
+ * SYNOPSIS:
+ *    void Con_PasteTimeout(uintptr_t UserData);
+ *
+ * PARAMETERS:
+ *    UsedData [I] -- The connection that this timer is for
+ *
+ * FUNCTION:
+ *    This function is a call back from the UI that is called when the
+ *    paste timer goes off.  It just calls the InformOfPasteTimeout()
+ *    function.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    
+ ******************************************************************************/
+void Con_PasteTimeout(uintptr_t UserData)
+{
+    class Connection *Con=(class Connection *)UserData;
+    Con->InformOfPasteTimeout();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Con_FileTransTimeout
+ *
+ * SYNOPSIS:
+ *    void Con_FileTransTimeout(uintptr_t UserData);
+ *
+ * PARAMETERS:
+ *    UsedData [I] -- The connection that this timer is for
+ *
+ * FUNCTION:
+ *    This function is a call back from the timer wheel that is called when
+ *    the file transfer timeout goes off.  It just calls the FileTransTick()
+ *    function.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::FileTransSetTimeout()
+ ******************************************************************************/
+void Con_FileTransTimeout(uintptr_t UserData)
+{
+    class Connection *Con=(class Connection *)UserData;
+    Con->FileTransTick();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Con_ZModemAutoStartTimeout
+ *
+ * SYNOPSIS:
+ *    void Con_ZModemAutoStartTimeout(uintptr_t UserData);
+ *
+ * PARAMETERS:
+ *    UsedData [I] -- The connection that this timer is for
+ *
+ * FUNCTION:
+ *    This function is a call back from the UI that is called after we
+ *    have seen a ZModem sender start.  It just calls the
+ *    InformOfZModemAutoStartTimeout() function.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::ZModemAutoDetect()
+ ******************************************************************************/
+void Con_ZModemAutoStartTimeout(uintptr_t UserData)
+{
+    class Connection *Con=(class Connection *)UserData;
+    Con->InformOfZModemAutoStartTimeout();
+}
+
 /*******************************************************************************
  * NAME:
  *    Con_AutoReopenTimeout
@@ -460,6 +587,8 @@ Connection::Connection(const char *URI)
         IOHandle=NULL;
         Display=NULL;
         MW=NULL;
+        PerfStats=NULL;
+        ProcessorData.PerfStats=NULL;
         BridgedTo=NULL;
         BridgedFrom=NULL;
         FrozenQueue=NULL;
@@ -472,8 +601,24 @@ Connection::Connection(const char *URI)
         LastBellPlayed=0;
         FontSize=8;
 
+        SelExtract.InProgress=false;
+        SelExtract.Dest=e_SelExtractDestMAX;
+        SelExtract.Out=NULL;
+        SelExtract.LastPercent=0;
+        SelExtract.Timer=NULL;
+
+        Paste.InProgress=false;
+        Paste.Sent=0;
+        Paste.LastPercent=0;
+        Paste.Timer=NULL;
+
+        FileTransTimer=NULL;
+        ZModemAutoStartTimer=NULL;
+        ZModemAutoMatch=0;
+
         Bookmark=0;
         ZoomLevel=0;
+        SessionGeneration=m_ConNextSessionGeneration++;
 
         for(r=0;r<(unsigned int)e_SysScriptMAX;r++)
             RunningScripts[r]=NULL;
@@ -486,26 +631,60 @@ Connection::Connection(const char *URI)
         if(FTPConData==NULL)
             throw("Failed to allocate file transfer protocol data");
 
-        TransmitDelayTimer=AllocUITimer();
+        /* This will be NULL if the stats are compiled out */
+        PerfStats=PerfStats_AllocCon("");
+
+        TransmitDelayTimer=TimerWheel_AllocTimer();
         if(TransmitDelayTimer==NULL)
             throw("Failed to allocate delay timer");
 
-        SmartClipTimer=AllocUITimer();
+        if(!TxPace.Init(Con_TxPaceWrite,(uintptr_t)this))
+            throw("Failed to setup the transmit pacer");
+
+        SmartClipTimer=TimerWheel_AllocTimer();
         if(SmartClipTimer==NULL)
             throw("Failed to allocate smart clipboard timer");
 
-        AutoReopenTimer=AllocUITimer();
+        AutoReopenTimer=TimerWheel_AllocTimer();
         if(AutoReopenTimer==NULL)
             throw("Failed to allocate auto reopen timer");
 
+        SelExtract.Timer=AllocUITimer();
+        if(SelExtract.Timer==NULL)
+            throw("Failed to allocate selection extract timer");
+
+        Paste.Timer=AllocUITimer();
+        if(Paste.Timer==NULL)
+            throw("Failed to allocate paste timer");
+
+        FileTransTimer=TimerWheel_AllocTimer();
+        if(FileTransTimer==NULL)
+            throw("Failed to allocate file transfer timer");
+
+        ZModemAutoStartTimer=AllocUITimer();
+        if(ZModemAutoStartTimer==NULL)
+            throw("Failed to allocate ZModem auto start timer");
+
         if(!SetConnectionBasedOnURI(URI))
             throw("Failed to setup the connection");
 
-        SetupUITimer(TransmitDelayTimer,Con_DelayTransmitTimeout,(uintptr_t)this,
-                false);
-        SetupUITimer(SmartClipTimer,Con_SmartClipTimeout,(uintptr_t)this,false);
-        SetupUITimer(AutoReopenTimer,Con_AutoReopenTimeout,(uintptr_t)this,
-                false);
+        TimerWheel_SetupTimer(TransmitDelayTimer,Con_DelayTransmitTimeout,
+                (uintptr_t)this,true);
+        TimerWheel_SetTimeout(TransmitDelayTimer,TRANSMIT_DELAY_POLL_MS);
+        TimerWheel_SetupTimer(SmartClipTimer,Con_SmartClipTimeout,
+                (uintptr_t)this,false);
+        TimerWheel_SetupTimer(AutoReopenTimer,Con_AutoReopenTimeout,
+                (uintptr_t)this,false);
+        SetupUITimer(SelExtract.Timer,Con_SelectionExtractTimeout,
+                (uintptr_t)this,true);
+        UITimerSetTimeout(SelExtract.Timer,1);
+        SetupUITimer(Paste.Timer,Con_PasteTimeout,(uintptr_t)this,true);
+        UITimerSetTimeout(Paste.Timer,1);
+        TimerWheel_SetupTimer(FileTransTimer,Con_FileTransTimeout,
+                (uintptr_t)this,true);
+        SetupUITimer(ZModemAutoStartTimer,Con_ZModemAutoStartTimeout,
+                (uintptr_t)this,false);
+        UITimerSetTimeout(ZModemAutoStartTimer,1);
 
         IsConnected=false;
         BlockSendDevice=false;
@@ -522,12 +701,9 @@ Connection::Connection(const char *URI)
         TransmitDelayLine=0;
         LastSettingsTransmitDelayByte=0;
         LastSettingsTransmitDelayLine=0;
-        TransmitDelayBuffer=NULL;
-        TransmitDelayBufferSize=0;
-        TransmitDelayBufferWritePos=0;
-        TransmitDelayBufferReadPos=0;
 
         CaptureToFile.WriteHandle=NULL;
+        CaptureToFile.Binary=NULL;
         CaptureToFile.Filename=g_Settings.CaptureDefaultFilename;
         CaptureToFile.Options.Timestamp=g_Settings.CaptureTimestamp;
         CaptureToFile.Options.Append=g_Settings.CaptureAppend;
@@ -544,7 +720,6 @@ Connection::Connection(const char *URI)
 
         Upload.Filename="";
         Upload.ProtocolID="";
-        Upload.LastTimeoutTick=0;
         Upload.Timeout=0;
         Upload.Stats.InProgress=false;
         Upload.Stats.BytesSent=0;
@@ -553,7 +728,6 @@ Connection::Connection(const char *URI)
         Download.Filename="";
         Download.FilenameSet=false;
         Download.ProtocolID="";
-        Download.LastTimeoutTick=0;
         Download.Timeout=0;
         Download.Stats.InProgress=false;
         Download.Stats.BytesRx=0;
@@ -573,23 +747,16 @@ Connection::Connection(const char *URI)
 
         ComTest.Sender=false;
         ComTest.SendingPackets=false;
+        ComTest.RequestThreadQuit=false;
         ComTest.PacketLen=1;
         ComTest.PacketsCount=1;
         ComTest.DelayBetweenPackets_mS=0;
-        ComTest.Timer=NULL;
         ComTest.Packet=NULL;
-        ComTest.RxPatternIndex=0;
+        ComTest.SendThread=NULL;
+        ComTest.StatsMutex=NULL;
         ComTest.UpdateFn=NULL;
-        ComTest.Syncing=false;
         ComTest.Stats.InProgress=false;
-        ComTest.Stats.PacketsSent=0;
-        ComTest.Stats.BytesSent=0;
-        ComTest.Stats.PacketsRx=0;
-        ComTest.Stats.ErrorsDetected=0;
-        ComTest.Stats.BytesPerSec=0;
-        ComTest.Stats.SendErrors=0;
-        ComTest.Stats.SendBusyErrors=0;
-        ComTest.Stats.LastRxTimeStamp=0;
+        ResetComTestStats();
 
         LeftPanelInfo=e_LeftPanelTabMAX;
         RightPanelInfo=e_RightPanelTabMAX;
@@ -665,6 +832,9 @@ void Connection::ConstructorFree(void)
     DPS_FreeProcessorConData(&ProcessorData);
     FTPS_FreeFTPData(FTPConData);
 
+    PerfStats_FreeCon(PerfStats);
+    PerfStats=NULL;
+
     FreeFrozenQueue();
     free(FrozenRetStr);
     FrozenRetStr=NULL;
@@ -712,30 +882,65 @@ void Connection::FreeConnectionResources(bool FreeDB)
         }
     }
 
+    /* Drop any paste that is still going out */
+    CancelPaste();
+    if(Paste.Timer!=NULL)
+    {
+        FreeUITimer(Paste.Timer);
+        Paste.Timer=NULL;
+    }
+
+    if(FileTransTimer!=NULL)
+    {
+        TimerWheel_FreeTimer(FileTransTimer);
+        FileTransTimer=NULL;
+    }
+
+    if(ZModemAutoStartTimer!=NULL)
+    {
+        FreeUITimer(ZModemAutoStartTimer);
+        ZModemAutoStartTimer=NULL;
+    }
+
+    /* Stop the transmit pacer and com test senders before the IO handle
+       goes away */
+    StopTxPace();
     if(TransmitDelayTimer!=NULL)
     {
-        FreeUITimer(TransmitDelayTimer);
+        TimerWheel_FreeTimer(TransmitDelayTimer);
         TransmitDelayTimer=NULL;
     }
 
-    if(ComTest.Timer!=NULL)
+    StopComTest();
+    if(ComTest.StatsMutex!=NULL)
     {
-        FreeUITimer(ComTest.Timer);
-        ComTest.Timer=NULL;
+        FreeMutex(ComTest.StatsMutex);
+        ComTest.StatsMutex=NULL;
     }
 
     if(SmartClipTimer!=NULL)
     {
-        FreeUITimer(SmartClipTimer);
+        TimerWheel_FreeTimer(SmartClipTimer);
         SmartClipTimer=NULL;
     }
 
     if(AutoReopenTimer!=NULL)
     {
-        FreeUITimer(AutoReopenTimer);
+        TimerWheel_FreeTimer(AutoReopenTimer);
         AutoReopenTimer=NULL;
     }
 
+    /* Drop any copy / save of the selection that is still running */
+    CancelSelectionExtract();
+    if(SelExtract.Timer!=NULL)
+    {
+        FreeUITimer(SelExtract.Timer);
+        SelExtract.Timer=NULL;
+    }
+
+    /* Close any capture (this writes the index on binary captures) */
+    StopCapture();
+
     /* Free the hex buffer */
     if(HexDisplay.Buffer!=NULL)
         free(HexDisplay.Buffer);
@@ -839,6 +1044,7 @@ bool Connection::Init(class TheMainWindow *MainWindow,void *ParentWidget,
             /* Allocate the data processors based on the settings */
             if(!DPS_AllocProcessorConData(&ProcessorData,&CustomSettings))
                 throw(0);
+            ProcessorData.PerfStats=PerfStats;
 
             NewIsBinary=!IsProcessorATextProcessor(ProcessorData);
             BinaryConnection=NewIsBinary;
@@ -858,6 +1064,7 @@ bool Connection::Init(class TheMainWindow *MainWindow,void *ParentWidget,
             {
                 throw(0);
             }
+            Display->SetPerfStats(PerfStats);
         }
 
         /* IOHandle was allocated in the constructor */
@@ -927,10 +1134,10 @@ void Connection::FinalizeNewConnection(bool IgnoreAutoConnect)
     /* We auto open this when we open the tab */
     if(!IgnoreAutoConnect && g_Settings.AutoConnectOnNewConnection)
     {
-        if(UITimerRunning(AutoReopenTimer))
+        if(TimerWheel_Running(AutoReopenTimer))
         {
             /* The auto reopen timer was running.  Kill it */
-            UITimerStop(AutoReopenTimer);
+            TimerWheel_Stop(AutoReopenTimer);
         }
 
         if(!IOS_Open(IOHandle))
@@ -976,6 +1183,7 @@ bool Connection::SetConnection(const std::string &UniqueID)
     IOHandle=IOS_AllocIOSystemHandle(UniqueID.c_str(),(uintptr_t)this);
     if(IOHandle==NULL)
         return false;
+    IOS_SetPerfStats(IOHandle,PerfStats);
     return true;
 }
 
@@ -1005,9 +1213,10 @@ bool Connection::SetConnectionBasedOnURI(const char *URI)
     IOHandle=IOS_AllocIOSystemHandleFromURI(URI,(uintptr_t)this);
     if(IOHandle==NULL)
         return false;
+    IOS_SetPerfStats(IOHandle,PerfStats);
 
     /* We also need to update the session open conneciton list */
-    NoteSessionChanged();
+    NoteSessionStateChanged();
 
     return true;
 }
@@ -1245,6 +1454,7 @@ void Connection::ApplyCustomSettings(void)
         /* We are changing from binary to text or vice versa */
         BinaryConnection=NewIsBinary;
 
+        CancelSelectionExtract();
         if(Display!=NULL)
             delete Display;
         Display=NULL;
@@ -1267,6 +1477,7 @@ void Connection::ApplyCustomSettings(void)
         }
 
         Display->SetBlockDeviceMode(BlockSendDevice);
+        Display->SetPerfStats(PerfStats);
     }
 
     /* Apply the zoom */
@@ -1310,7 +1521,7 @@ void Connection::ApplyCustomSettings(void)
     AutoReopenEnabled=CustomSettings.AutoReopen;
 
     /* We also need to update the session open conneciton list */
-    NoteSessionChanged();
+    NoteSessionStateChanged();
 }
 
 /*******************************************************************************
@@ -1342,7 +1553,7 @@ bool Connection::SetConnectionOptions(const t_KVList &Options)
     SendMWEvent(ConMWEvent_ConOptionsChange);
 
     /* We also need to update the session open conneciton list */
-    NoteSessionChanged();
+    NoteSessionStateChanged();
 
     return RetValue;
 }
@@ -1507,6 +1718,7 @@ void Connection::SetDisplayName(const char *Name)
 
         strncpy(DisplayName,UseName,MAX_CONNECTION_NAME_LEN);
         DisplayName[MAX_CONNECTION_NAME_LEN]=0;
+        PerfStats_SetConName(PerfStats,DisplayName);
 
         if(MW!=NULL)
         {
@@ -1515,7 +1727,7 @@ void Connection::SetDisplayName(const char *Name)
         }
 
         /* We also need to update the session open conneciton list */
-        NoteSessionChanged();
+        NoteSessionStateChanged();
     }
     catch(...)
     {
@@ -1788,7 +2000,7 @@ bool Connection::KeyPress(uint8_t Mods,e_UIKeys Key,const uint8_t *TextPtr,
  *
  * SYNOPSIS:
  *    e_ConWriteType Connection::WriteData(const uint8_t *Data,int Bytes,
- *              e_ConWriteSourceType Source);
+ *              e_ConWriteSourceType Source,int *BytesSent=NULL);
  *
  * PARAMETERS:
  *    Data [I] -- The data to send
@@ -1807,6 +2019,12 @@ bool Connection::KeyPress(uint8_t Mods,e_UIKeys Key,const uint8_t *TextPtr,
  *                      e_ConWriteSource_Bridge -- Sent from a bridged
  *                              connection.
  *                      e_ConWriteSource_Script -- Send from a running script.
+ *    BytesSent [O] -- If this isn't NULL then the driver is allowed to only
+ *                     take some of the bytes.  When it does we return
+ *                     e_ConWrite_Busy and this is set to how many were sent
+ *                     (you send the rest later).  If this is NULL then
+ *                     anything the driver didn't take is queued on the
+ *                     transmit pacer and we return e_ConWrite_Success.
  *
  * FUNCTION:
  *    This function writes to the connection.  It send this data to the
@@ -1816,17 +2034,21 @@ bool Connection::KeyPress(uint8_t Mods,e_UIKeys Key,const uint8_t *TextPtr,
  *    e_ConWrite_Success -- Things worked.  The bytes have been sent
  *              (or at least queued)
  *    e_ConWrite_Failed -- There was an error sending.  It has been noted.
- *    e_ConWrite_Busy -- We could not sent this, but we can try again later.
+ *    e_ConWrite_Busy -- We could not sent this (or only sent 'BytesSent' of
+ *              it), but we can try again later.
  *    e_ConWrite_Ignored -- Because of the mode we are in we didn't send it.
  *
  * SEE ALSO:
  *    Con_WriteData()
  ******************************************************************************/
 e_ConWriteType Connection::WriteData(const uint8_t *Data,int Bytes,
-        e_ConWriteSourceType Source)
+        e_ConWriteSourceType Source,int *BytesSent)
 {
     e_ConWriteType RetValue;
 
+    if(BytesSent!=NULL)
+        *BytesSent=0;
+
     if(!IsConnected)
         return e_ConWrite_Failed;
 
@@ -1875,10 +2097,12 @@ e_ConWriteType Connection::WriteData(const uint8_t *Data,int Bytes,
     if(!TxKeyboardEnabled && Source==e_ConWriteSource_Keyboard)
         return e_ConWrite_Ignored;
 
-    if(TransmitDelayByte!=0 || TransmitDelayLine!=0)
+    if(TransmitDelayByte!=0 || TransmitDelayLine!=0 || TxPace.IsBusy())
     {
-        /* Ok, we need to queue this because we can't block the GUI */
-        if(TransmitDelayBufferWritePos>0 &&
+        /* Ok, we need to queue this because we can't block the GUI (we
+           also queue if the pacer is still sending so things stay in
+           order after the delays are turned off) */
+        if(TxPace.GetQueuedBytes()>0 &&
                 (Source!=e_ConWriteSource_Keyboard &&
                 Source!=e_ConWriteSource_BlockSend))
         {
@@ -1889,14 +2113,17 @@ e_ConWriteType Connection::WriteData(const uint8_t *Data,int Bytes,
         }
         else
         {
-            /* Queue the data for sending later. */
-            if(QueueTransmitDelayData(Data,Bytes))
+            /* Queue the data, the pacer's thread sends it */
+            if(TxPace.Queue(Data,Bytes))
             {
-                /* Send the first byte / block if we haven't already sent
-                   something (or we are finished the last timeout) */
-                if(!UITimerRunning(TransmitDelayTimer))
-                    InformOfDelayTransmitTimeout();
+                PERFSTATS_TXQUEUE(PerfStats,TxPace.GetQueuedBytes());
 
+                /* Start picking up what was sent */
+                if(!TimerWheel_Running(TransmitDelayTimer))
+                    TimerWheel_Start(TransmitDelayTimer);
+
+                if(BytesSent!=NULL)
+                    *BytesSent=Bytes;
                 RetValue=e_ConWrite_Success;
             }
             else
@@ -1907,7 +2134,7 @@ e_ConWriteType Connection::WriteData(const uint8_t *Data,int Bytes,
     }
     else
     {
-        RetValue=InternalWriteBytes(Data,Bytes);
+        RetValue=InternalWriteBytes(Data,Bytes,BytesSent);
     }
     return RetValue;
 }
@@ -1918,16 +2145,19 @@ e_ConWriteType Connection::WriteData(const uint8_t *Data,int Bytes,
  *
  * SYNOPSIS:
  *    e_ConWriteType Connection::InternalWriteBytes(const uint8_t *Data,
- *          int Bytes);
+ *          int Bytes,int *BytesSent);
  *
  * PARAMETERS:
  *    Data [I] -- The data to send
  *    Bytes [I] -- The number of bytes to send
+ *    BytesSent [O] -- See Connection::WriteData()
  *
  * FUNCTION:
  *    This is an internal helper function that writes bytes out to the device.
  *    This handles converting device errors into ... DEBUG PAUL: Do what???
  *
+ *    Only the bytes the driver took are passed on to the data processors.
+ *
  * RETURNS:
  *    e_ConWrite_Success -- Things worked.  The bytes have been sent
  *              (or at least queued)
@@ -1943,21 +2173,31 @@ e_ConWriteType Connection::WriteData(const uint8_t *Data,int Bytes,
  * SEE ALSO:
  *    Connection::WriteData()
  ******************************************************************************/
-e_ConWriteType Connection::InternalWriteBytes(const uint8_t *Data,int Bytes)
+e_ConWriteType Connection::InternalWriteBytes(const uint8_t *Data,int Bytes,
+        int *BytesSent)
 {
     e_ConWriteType RetValue;
+    e_IOSysIOErrorType WriteRet;
+    int Wrote;
 
-    /* We need to call the Data Processor System so it can pass on writes to
-       the plugins */
-    Con_SetActiveConnection(this);
-    DPS_ProcessorOutGoingBytes(&ProcessorData,Data,Bytes);
-    Con_SetActiveConnection(NULL);
+    WriteRet=IOS_WriteData(IOHandle,Data,Bytes,&Wrote);
+    if(Wrote>0)
+    {
+        /* We need to call the Data Processor System so it can pass on
+           writes to the plugins */
+        Con_SetActiveConnection(this);
+        DPS_ProcessorOutGoingBytes(&ProcessorData,Data,Wrote);
+        Con_SetActiveConnection(NULL);
+
+        NoteBytesWritten(Data,Wrote);
+    }
+    if(BytesSent!=NULL)
+        *BytesSent=Wrote;
 
     RetValue=e_ConWrite_Failed;
-    switch(IOS_WriteData(IOHandle,Data,Bytes))
+    switch(WriteRet)
     {
         case e_IOSysIOError_Success:
-            HandleHexDisplayOutGoingData(Data,Bytes);
             RetValue=e_ConWrite_Success;
         break;
         case e_IOSysIOError_GenericIO:
@@ -1972,14 +2212,60 @@ e_ConWriteType Connection::InternalWriteBytes(const uint8_t *Data,int Bytes)
         break;
         case e_IOSysIOError_Busy:
             RetValue=e_ConWrite_Busy;
+            if(Wrote>0 && BytesSent==NULL)
+            {
+                /* The caller can't send part of this, so the pacer sends
+                   the rest (WriteData() keeps new data behind it) */
+                if(TxPace.Queue(Data+Wrote,Bytes-Wrote))
+                {
+                    PERFSTATS_TXQUEUE(PerfStats,TxPace.GetQueuedBytes());
+                    if(!TimerWheel_Running(TransmitDelayTimer))
+                        TimerWheel_Start(TransmitDelayTimer);
+                    RetValue=e_ConWrite_Success;
+                }
+                else
+                {
+                    RetValue=e_ConWrite_Failed;
+                }
+            }
         break;
         case e_IOSysIOErrorMAX:
         default:
         break;
     }
 
-    /* Do local echo (only on success) */
-    if(RetValue==e_ConWrite_Success && CustomSettings.LocalEcho)
+    return RetValue;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::NoteBytesWritten
+ *
+ * SYNOPSIS:
+ *    void Connection::NoteBytesWritten(const uint8_t *Data,int Bytes);
+ *
+ * PARAMETERS:
+ *    Data [I] -- The bytes that where sent
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function does everything that happens after bytes have been sent
+ *    to the driver (outgoing hex display, capture, stats, and local echo).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::InternalWriteBytes()
+ ******************************************************************************/
+void Connection::NoteBytesWritten(const uint8_t *Data,int Bytes)
+{
+    HandleHexDisplayOutGoingData(Data,Bytes);
+    HandleCaptureOutGoingData(Data,Bytes);
+    PERFSTATS_COUNT(PerfStats,e_PerfCounter_TxBytes,Bytes);
+
+    /* Do local echo */
+    if(CustomSettings.LocalEcho)
     {
         Con_SetActiveConnection(this);
         DoingIncomingByteProcessing=true;
@@ -1988,8 +2274,6 @@ e_ConWriteType Connection::InternalWriteBytes(const uint8_t *Data,int Bytes)
         DoingIncomingByteProcessing=false;
         Con_SetActiveConnection(NULL);
     }
-
-    return RetValue;
 }
 
 /*******************************************************************************
@@ -2052,7 +2336,7 @@ void Connection::InformOfConnected(void)
     RethinkCursor();
 
     /* We also need to update the session open conneciton list */
-    NoteSessionChanged();
+    NoteSessionStateChanged();
 }
 
 /*******************************************************************************
@@ -2081,17 +2365,19 @@ void Connection::InformOfDisconnected(void)
         return;
 
     IsConnected=false;
+    StopTxPace();
+    CancelPaste();
     SendMWEvent(ConMWEvent_StatusChange);
     RethinkCursor();
 
     if(AutoReopenEnabled)
     {
         /* Start the auto reopen timer */
-        UITimerStart(AutoReopenTimer);
+        TimerWheel_Start(AutoReopenTimer);
     }
 
     /* We also need to update the session open conneciton list */
-    NoteSessionChanged();
+    NoteSessionStateChanged();
 }
 
 /*******************************************************************************
@@ -2164,7 +2450,9 @@ bool Connection::InformOfDataAvaiable(void)
 //    TotalBytes=0;
     do
     {
+        PERFSTATS_TIMESTAMP(ReadStart);
         bytes=IOS_ReadData(IOHandle,inbuff,sizeof(inbuff));
+        PERFSTATS_STAGE_DONE(PerfStats,e_PerfStage_DriverRead,ReadStart);
 
         /* We need to send this incoming data to all the active scripts */
         if(bytes>0)
@@ -2193,6 +2481,9 @@ bool Connection::InformOfDataAvaiable(void)
 
         if(bytes>0)
         {
+            PERFSTATS_COUNT(PerfStats,e_PerfCounter_RxBytes,bytes);
+            PERFSTATS_COUNT(PerfStats,e_PerfCounter_Blocks,1);
+
             if(ComTest.Stats.InProgress)
             {
                 /* We are doing the com test */
@@ -2207,6 +2498,10 @@ bool Connection::InformOfDataAvaiable(void)
                     if(FTPS_ProcessIncomingBytes(FTPConData,inbuff,bytes))
                         ProcessBlock=false;
                 }
+                else if(g_Settings.ZModemAutoDownload)
+                {
+                    ZModemAutoDetect(inbuff,bytes);
+                }
 
                 HandleHexDisplayIncomingData(inbuff,bytes);
                 HandleCaptureIncomingData(inbuff,bytes);
@@ -2267,7 +2562,7 @@ bool Connection::InformOfDataAvaiable(void)
 void Connection::InformOfCursorKeyModeChange(void)
 {
     RethinkCursor();
-    RethinkCursorKeyModeInfoBox();
+    RethinkInfoBox();
 }
 
 /*******************************************************************************
@@ -2295,7 +2590,7 @@ void Connection::HandleMiddleMousePress(int x,int y)
 {
     string ClipText;
 
-    if(IOHandle==NULL)
+    if(IOHandle==NULL || Paste.InProgress)
         return;
 
     UI_GetClipboardText(ClipText,e_Clipboard_Selection);
@@ -2305,8 +2600,7 @@ void Connection::HandleMiddleMousePress(int x,int y)
         return;
 
     /* Send the text out the connection */
-    WriteData((const uint8_t *)ClipText.c_str(),ClipText.length(),
-            e_ConWriteSource_Paste);
+    StartPaste(ClipText);
 }
 
 /*******************************************************************************
@@ -2339,6 +2633,51 @@ void Connection::WriteChar2Display(uint8_t *Chr)
     Display->WriteChar(Chr);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Connection::WriteChars2Display
+ *
+ * SYNOPSIS:
+ *    void Connection::WriteChars2Display(const uint8_t *Chrs,int Count);
+ *
+ * PARAMETERS:
+ *    Chrs [I] -- The chars to write.  Each byte is one char (not 0 term'ed)
+ *    Count [I] -- The number of chars in 'Chrs'
+ *
+ * FUNCTION:
+ *    This function adds a run of single byte chars to the display buffer for
+ *    this connection.  It's the same as calling WriteChar2Display() for each
+ *    one but the display only has to redraw once.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::WriteChar2Display()
+ ******************************************************************************/
+void Connection::WriteChars2Display(const uint8_t *Chrs,int Count)
+{
+    uint8_t Chr[2];
+    int r;
+
+    if(Display==NULL)
+        return;
+
+    if(InputFrozen && DoingIncomingByteProcessing && !SupressFrozen)
+    {
+        /* The frozen queue stores chars one at a time */
+        Chr[1]=0;
+        for(r=0;r<Count;r++)
+        {
+            Chr[0]=Chrs[r];
+            WriteChar2Display(Chr);
+        }
+        return;
+    }
+
+    Display->WriteChars(Chrs,Count);
+}
+
 /*******************************************************************************
  * NAME:
  *    Connection::InsertString
@@ -2603,6 +2942,70 @@ uint32_t Connection::GetAttribs(void)
     return 0;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Connection::SetStyle
+ *
+ * SYNOPSIS:
+ *    void Connection::SetStyle(const struct CharStyling *Style);
+ *
+ * PARAMETERS:
+ *    Style [I] -- The new colors and attribs to use
+ *
+ * FUNCTION:
+ *    This function sets the forground, background and underline colors and
+ *    the attribs all in one go.  This is the same as calling SetFGColor(),
+ *    SetBGColor(), SetULineColor() and SetAttribs() but it only has to
+ *    come through once.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::GetStyle()
+ ******************************************************************************/
+void Connection::SetStyle(const struct CharStyling *Style)
+{
+    if(FrozenQueueIfNeeded_SetStyle(Style))
+        return;
+
+    if(Display!=NULL)
+        Display->CurrentStyle=*Style;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::GetStyle
+ *
+ * SYNOPSIS:
+ *    void Connection::GetStyle(struct CharStyling *RetStyle);
+ *
+ * PARAMETERS:
+ *    RetStyle [O] -- The current colors and attribs
+ *
+ * FUNCTION:
+ *    This function gets the current forground, background and underline
+ *    colors and the attribs all in one go.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::SetStyle()
+ ******************************************************************************/
+void Connection::GetStyle(struct CharStyling *RetStyle)
+{
+    if(Display!=NULL)
+    {
+        *RetStyle=Display->CurrentStyle;
+        return;
+    }
+    RetStyle->FGColor=0;
+    RetStyle->BGColor=0;
+    RetStyle->ULineColor=0;
+    RetStyle->Attribs=0;
+}
+
 /*******************************************************************************
  * NAME:
  *    Connection::DoFunction
@@ -2716,6 +3119,12 @@ void Connection::DoFunction(e_ConFuncType Fn,uintptr_t Arg1,uintptr_t Arg2,
             Display->ScrollArea(Arg1,Arg2,Arg3,Arg4,(intptr_t)Arg5,
                     (intptr_t)Arg6);
         break;
+        case e_ConFunc_SetScrollRegion:
+            Display->SetScrollRegion(Arg1,Arg2);
+        break;
+        case e_ConFunc_SetAltScreen:
+            Display->SetAltScreen(Arg1!=0);
+        break;
 
         case e_ConFuncMAX:
         default:
@@ -2847,6 +3256,12 @@ void Connection::SetConnectedState(bool Connect)
     }
     else
     {
+        /* The com test sender and transmit pacer write from their own
+           threads */
+        StopComTest();
+        StopTxPace();
+        CancelPaste();
+
         if(IsConnected)
             IOS_Close(IOHandle);
     }
@@ -3009,11 +3424,15 @@ void Connection::GiveFocus(void)
  *    This function copies the current selection to the clipboard (if there
  *    is one).
  *
+ *    Big selections are copied in the background (see
+ *    StartSelectionExtract()) so the UI doesn't lock up while we build the
+ *    string.
+ *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    SaveSelectionToFile()
  ******************************************************************************/
 void Connection::CopySelectionToClipboard(void)
 {
@@ -3022,28 +3441,264 @@ void Connection::CopySelectionToClipboard(void)
     if(Display==NULL)
         return;
 
+    /* Copying again replaces a copy / save that is still running */
+    CancelSelectionExtract();
+
+    if(Display->GetSelectionLineCount()>SELEXTRACT_SYNC_LINES)
+    {
+        StartSelectionExtract(e_SelExtractDest_Clipboard);
+        return;
+    }
+
     if(Display->GetSelectionString(SelectContents))
     {
         UI_SetClipboardText(SelectContents,e_Clipboard_Selection);
         UI_SetClipboardText(SelectContents,e_Clipboard_Clipboard);
 
         /* We also clear the selection on success (if we are using smart) */
-        switch(CustomSettings.ClipboardMode)
-        {
-            case e_ClipboardMode_None:
-            case e_ClipboardMode_Normal:
-            case e_ClipboardMode_ShiftCtrl:
-            case e_ClipboardMode_Alt:
-            break;
-            case e_ClipboardMode_Smart:
-            case e_ClipboardModeMAX:
-            default:
-                Display->ClearSelection();
-            break;
-        }
+        ClearSelectionIfSmartClipboard();
     }
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Connection::ClearSelectionIfSmartClipboard
+ *
+ * SYNOPSIS:
+ *    void Connection::ClearSelectionIfSmartClipboard(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function clears the selection if we are using the smart clipboard
+ *    mode.  It is called after the selection has been copied.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CopySelectionToClipboard()
+ ******************************************************************************/
+void Connection::ClearSelectionIfSmartClipboard(void)
+{
+    if(Display==NULL)
+        return;
+
+    switch(CustomSettings.ClipboardMode)
+    {
+        case e_ClipboardMode_None:
+        case e_ClipboardMode_Normal:
+        case e_ClipboardMode_ShiftCtrl:
+        case e_ClipboardMode_Alt:
+        break;
+        case e_ClipboardMode_Smart:
+        case e_ClipboardModeMAX:
+        default:
+            Display->ClearSelection();
+        break;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::SaveSelectionToFile
+ *
+ * SYNOPSIS:
+ *    bool Connection::SaveSelectionToFile(const char *Filename);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to write the selection to.  This will be
+ *                    replaced if it already exists.
+ *
+ * FUNCTION:
+ *    This function writes the selected text to a file.  The selection is
+ *    written a piece at a time in the background so it can be as big as the
+ *    scroll back buffer without locking up the UI.
+ *
+ * RETURNS:
+ *    true -- The save has started
+ *    false -- There was an error (the user has been told)
+ *
+ * SEE ALSO:
+ *    CopySelectionToClipboard(), CancelSelectionExtract()
+ ******************************************************************************/
+bool Connection::SaveSelectionToFile(const char *Filename)
+{
+    string Msg;
+
+    if(Display==NULL)
+        return false;
+
+    CancelSelectionExtract();
+
+    SelExtract.Out=fopen(Filename,"wb");
+    if(SelExtract.Out==NULL)
+    {
+        Msg="Failed to open ";
+        Msg+=Filename;
+        Msg+=" for writing";
+        UIAsk("Error",Msg,e_AskBox_Error,e_AskBttns_Ok);
+        return false;
+    }
+    SelExtract.Filename=Filename;
+
+    return StartSelectionExtract(e_SelExtractDest_File);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::StartSelectionExtract
+ *
+ * SYNOPSIS:
+ *    bool Connection::StartSelectionExtract(e_SelExtractDestType Dest);
+ *
+ * PARAMETERS:
+ *    Dest [I] -- Where the selection text should go.  For
+ *                e_SelExtractDest_File 'SelExtract.Out' must already be open.
+ *                Any extract that was running must have been canceled first.
+ *
+ * FUNCTION:
+ *    This function starts copying the selection in the background.  The
+ *    display remembers the range of the selection and we pull it out a chunk
+ *    at a time from the selection extract timer, only spending
+ *    SELEXTRACT_TICK_MS at a time on it.  How far along we are is shown in
+ *    the info box.
+ *
+ *    The display buffer and the clipboard both belong to the UI thread, so
+ *    the work is cut into pieces on the UI thread instead of being handed to
+ *    a worker thread.
+ *
+ * RETURNS:
+ *    true -- The extract has started
+ *    false -- There was nothing to extract
+ *
+ * SEE ALSO:
+ *    InformOfSelectionExtractTimeout(), FinishSelectionExtract()
+ ******************************************************************************/
+bool Connection::StartSelectionExtract(e_SelExtractDestType Dest)
+{
+    SelExtract.Dest=Dest;
+    SelExtract.ClipText.clear();
+    SelExtract.LastPercent=0;
+
+    if(!Display->StartSelectionExtract())
+    {
+        CancelSelectionExtract();
+        return false;
+    }
+
+    SelExtract.InProgress=true;
+    UITimerStart(SelExtract.Timer);
+    RethinkInfoBox();
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::CancelSelectionExtract
+ *
+ * SYNOPSIS:
+ *    void Connection::CancelSelectionExtract(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function stops a background copy / save of the selection.  A
+ *    partly written file is left as is.  It is safe to call this if nothing
+ *    is running.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+void Connection::CancelSelectionExtract(void)
+{
+    bool WasRunning;
+
+    WasRunning=SelExtract.InProgress;
+
+    if(SelExtract.Timer!=NULL)
+        UITimerStop(SelExtract.Timer);
+
+    if(SelExtract.Out!=NULL)
+        fclose(SelExtract.Out);
+    SelExtract.Out=NULL;
+
+    if(Display!=NULL)
+        Display->StopSelectionExtract();
+
+    SelExtract.InProgress=false;
+    SelExtract.Dest=e_SelExtractDestMAX;
+
+    /* Let go of the memory (this can be a big string) */
+    string().swap(SelExtract.ClipText);
+    string().swap(SelExtract.Chunk);
+
+    if(WasRunning)
+        RethinkInfoBox();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::FinishSelectionExtract
+ *
+ * SYNOPSIS:
+ *    void Connection::FinishSelectionExtract(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is called when the last piece of the selection has been
+ *    extracted.  It hands the text to the clipboard (or closes the file) and
+ *    cleans up.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    InformOfSelectionExtractTimeout()
+ ******************************************************************************/
+void Connection::FinishSelectionExtract(void)
+{
+    string Msg;
+    FILE *Out;
+
+    switch(SelExtract.Dest)
+    {
+        case e_SelExtractDest_Clipboard:
+            UI_SetClipboardTextCStr(SelExtract.ClipText.c_str(),
+                    e_Clipboard_Selection);
+            UI_SetClipboardTextCStr(SelExtract.ClipText.c_str(),
+                    e_Clipboard_Clipboard);
+
+            ClearSelectionIfSmartClipboard();
+        break;
+        case e_SelExtractDest_File:
+            Out=SelExtract.Out;
+            SelExtract.Out=NULL;
+            if(Out!=NULL && fclose(Out)!=0)
+            {
+                Msg="Failed to write to ";
+                Msg+=SelExtract.Filename;
+                CancelSelectionExtract();
+                UIAsk("Error",Msg,e_AskBox_Error,e_AskBttns_Ok);
+                return;
+            }
+        break;
+        case e_SelExtractDestMAX:
+        default:
+        break;
+    }
+
+    CancelSelectionExtract();
+}
+
 /*******************************************************************************
  * NAME:
  *    Connection::PasteFromClipboard
@@ -3056,18 +3711,19 @@ void Connection::CopySelectionToClipboard(void)
  *
  * FUNCTION:
  *    This function inserts the text from the clipboard into the input system.
+ *    Pasting while another paste is still going out does nothing.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    StartPaste(), CancelPaste()
  ******************************************************************************/
 void Connection::PasteFromClipboard(void)
 {
     string ClipText;
 
-    if(IOHandle==NULL)
+    if(IOHandle==NULL || Paste.InProgress)
         return;
 
     UI_GetClipboardText(ClipText,e_Clipboard_Clipboard);
@@ -3082,8 +3738,123 @@ void Connection::PasteFromClipboard(void)
         return;
 
     /* Send the text out the connection */
-    WriteData((const uint8_t *)ClipText.c_str(),ClipText.length(),
-            e_ConWriteSource_Paste);
+    StartPaste(ClipText);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::StartPaste
+ *
+ * SYNOPSIS:
+ *    void Connection::StartPaste(std::string &Text);
+ *
+ * PARAMETERS:
+ *    Text [I/O] -- The text to paste.  For big pastes this is swapped into
+ *                  the paste job so it will be empty when we return.
+ *
+ * FUNCTION:
+ *    This function sends pasted text out the connection.  Small pastes go
+ *    right out.  Bigger ones are sent PASTE_CHUNK_BYTES at a time from the
+ *    paste timer, only spending PASTE_TICK_MS at a time on it and backing
+ *    off when the driver is full, so the UI keeps running.  How far along
+ *    we are is shown in the info box.
+ *
+ *    Local echo for each chunk happens as it's written, the same as it
+ *    would for typed data.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    InformOfPasteTimeout(), CancelPaste()
+ ******************************************************************************/
+void Connection::StartPaste(std::string &Text)
+{
+    if(Text.length()<=PASTE_SYNC_BYTES)
+    {
+        WriteData((const uint8_t *)Text.c_str(),Text.length(),
+                e_ConWriteSource_Paste);
+        return;
+    }
+
+    Paste.Text.swap(Text);
+    Paste.Sent=0;
+    Paste.LastPercent=0;
+    Paste.InProgress=true;
+    UITimerSetTimeout(Paste.Timer,1);
+    UITimerStart(Paste.Timer);
+
+    RethinkInfoBox();
+    SendMWEvent(ConMWEvent_PasteStateChanged);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::CancelPaste
+ *
+ * SYNOPSIS:
+ *    void Connection::CancelPaste(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function stops a paste that is being sent in the background.
+ *    Whatever has already been handed to the driver is not taken back.  It
+ *    is safe to call this if nothing is running.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartPaste()
+ ******************************************************************************/
+void Connection::CancelPaste(void)
+{
+    bool WasRunning;
+
+    WasRunning=Paste.InProgress;
+
+    if(Paste.Timer!=NULL)
+        UITimerStop(Paste.Timer);
+
+    Paste.InProgress=false;
+    Paste.Sent=0;
+    Paste.LastPercent=0;
+
+    /* Let go of the memory (this can be a big string) */
+    string().swap(Paste.Text);
+
+    if(WasRunning)
+    {
+        RethinkInfoBox();
+        SendMWEvent(ConMWEvent_PasteStateChanged);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::IsPasteInProgress
+ *
+ * SYNOPSIS:
+ *    bool Connection::IsPasteInProgress(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function checks if a paste is being sent in the background.
+ *
+ * RETURNS:
+ *    true -- A paste is going out
+ *    false -- No paste is running
+ *
+ * SEE ALSO:
+ *    StartPaste(), CancelPaste()
+ ******************************************************************************/
+bool Connection::IsPasteInProgress(void)
+{
+    return Paste.InProgress;
 }
 
 /*******************************************************************************
@@ -3117,6 +3888,35 @@ void Connection::GotoColumn(int Column)
     Display->SetCursorXY(Column,CurRow);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Connection::FindBytes
+ *
+ * SYNOPSIS:
+ *    bool Connection::FindBytes(const struct ByteSearchPattern *Pattern);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The bytes to look for
+ *
+ * FUNCTION:
+ *    This function finds the next match of a byte pattern in the display
+ *    and selects it.  Only the binary display supports this.
+ *
+ * RETURNS:
+ *    true -- The pattern was found
+ *    false -- The pattern was not found (or the display can't search)
+ *
+ * SEE ALSO:
+ *    DisplayBase::FindBytes()
+ ******************************************************************************/
+bool Connection::FindBytes(const struct ByteSearchPattern *Pattern)
+{
+    if(Display==NULL)
+        return false;
+
+    return Display->FindBytes(Pattern);
+}
+
 /*******************************************************************************
  * NAME:
  *    Connection::GotoRow
@@ -3246,8 +4046,14 @@ bool Connection::ProcessDisplayEvent(const struct DBEvent *Event)
             {
                 string SelectContents;
 
-                if(Display->GetSelectionString(SelectContents))
+                /* Building the string for a huge selection would lock up
+                   the UI every time the mouse moved, so big ones only go to
+                   the clipboard when they are copied */
+                if(Display->GetSelectionLineCount()<=SELEXTRACT_SYNC_LINES &&
+                        Display->GetSelectionString(SelectContents))
+                {
                     UI_SetClipboardText(SelectContents,e_Clipboard_Selection);
+                }
 
                 /* Update the HEX UI */
                 SendMWEvent(ConMWEvent_SelectionChanged,NULL);
@@ -3268,10 +4074,13 @@ bool Connection::ProcessDisplayEvent(const struct DBEvent *Event)
             }
             /* Send the data we just queued */
             TransmitQueuedData();
+
+            /* The line history (and the panel options) are in the session */
+            NoteSessionStateChanged();
         break;
         case e_DBEvent_FocusChange:
             RethinkCursor();
-            RethinkCursorKeyModeInfoBox();
+            RethinkInfoBox();
         break;
         case e_DBEvent_ContextMenu:
             if(MW==NULL)
@@ -3294,9 +4103,15 @@ bool Connection::ProcessDisplayEvent(const struct DBEvent *Event)
                 case e_UITD_ContextMenu_Copy:
                     MW->ExeCmd(e_Cmd_Copy);
                 break;
+                case e_UITD_ContextMenu_SaveSelection:
+                    MW->ExeCmd(e_Cmd_SaveSelection);
+                break;
                 case e_UITD_ContextMenu_Paste:
                     MW->ExeCmd(e_Cmd_Paste);
                 break;
+                case e_UITD_ContextMenu_StopPaste:
+                    CancelPaste();
+                break;
                 case e_UITD_ContextMenu_ClearScreen:
                     MW->ExeCmd(e_Cmd_ClearScreen);
                 break;
@@ -3396,6 +4211,11 @@ bool Connection::ProcessDisplayEvent(const struct DBEvent *Event)
                     PanelOpen=Display->GetTextPanelAvailable();
                 MW->InformOf_SendPanelOpenClose(PanelOpen);
             }
+            NoteSessionStateChanged();
+        break;
+        case e_DBEvent_DirectPanelSettingsChanged:
+            /* The line end / hex mode is saved in the session */
+            NoteSessionStateChanged();
         break;
         case e_DBEventMAX:
         default:
@@ -3449,7 +4269,7 @@ void Connection::GetCaptureOptions(struct CaptureToFileOptions &Options)
  ******************************************************************************/
 void Connection::SetCaptureOption_Timestamp(bool On)
 {
-    if(CaptureToFile.WriteHandle==NULL)
+    if(!GetCaptureSaving())
         CaptureToFile.Options.Timestamp=On;
 }
 
@@ -3474,7 +4294,7 @@ void Connection::SetCaptureOption_Timestamp(bool On)
  ******************************************************************************/
 void Connection::SetCaptureOption_Append(bool On)
 {
-    if(CaptureToFile.WriteHandle==NULL)
+    if(!GetCaptureSaving())
         CaptureToFile.Options.Append=On;
 }
 
@@ -3500,7 +4320,7 @@ void Connection::SetCaptureOption_Append(bool On)
  ******************************************************************************/
 void Connection::SetCaptureOption_StripCtrl(bool On)
 {
-    if(CaptureToFile.WriteHandle==NULL)
+    if(!GetCaptureSaving())
         CaptureToFile.Options.StripCtrl=On;
 }
 
@@ -3526,7 +4346,7 @@ void Connection::SetCaptureOption_StripCtrl(bool On)
  ******************************************************************************/
 void Connection::SetCaptureOption_StripEsc(bool On)
 {
-    if(CaptureToFile.WriteHandle==NULL)
+    if(!GetCaptureSaving())
         CaptureToFile.Options.StripEsc=On;
 }
 
@@ -3552,7 +4372,7 @@ void Connection::SetCaptureOption_StripEsc(bool On)
  ******************************************************************************/
 void Connection::SetCaptureOption_HexDump(bool On)
 {
-    if(CaptureToFile.WriteHandle==NULL)
+    if(!GetCaptureSaving())
         CaptureToFile.Options.SaveAsHexDump=On;
 }
 
@@ -3579,7 +4399,7 @@ void Connection::SetCaptureOption_HexDump(bool On)
  ******************************************************************************/
 bool Connection::GetCaptureSaving(void)
 {
-    return CaptureToFile.WriteHandle!=NULL;
+    return CaptureToFile.WriteHandle!=NULL || CaptureToFile.Binary!=NULL;
 }
 
 /*******************************************************************************
@@ -3607,18 +4427,36 @@ bool Connection::StartCapture(void)
 {
     const char *OpenMode;
     time_t curtime;
-    char buff[100];
-    const char *TimeStr;
 
-    if(CaptureToFile.WriteHandle!=NULL)
-    {
-        fclose(CaptureToFile.WriteHandle);
-        CaptureToFile.WriteHandle=NULL;
-    }
+    StopCapture();
 
     if(CaptureToFile.Filename=="")
         return false;
 
+    if(CaptureFile_IsBinaryFilename(CaptureToFile.Filename.c_str()))
+    {
+        /* Binary capture.  The text options don't apply, the text formats
+           can be made from it later with CaptureFile_ExportText() */
+        try
+        {
+            CaptureToFile.Binary=new CaptureFileWriter;
+        }
+        catch(...)
+        {
+            CaptureToFile.Binary=NULL;
+            return false;
+        }
+
+        if(!CaptureToFile.Binary->Open(CaptureToFile.Filename.c_str(),
+                CaptureToFile.Options.Append))
+        {
+            delete CaptureToFile.Binary;
+            CaptureToFile.Binary=NULL;
+            return false;
+        }
+        return true;
+    }
+
     if(CaptureToFile.Options.Append)
         OpenMode="ab";
     else
@@ -3628,30 +4466,9 @@ bool Connection::StartCapture(void)
     if(CaptureToFile.WriteHandle==NULL)
         return false;
 
-    if(CaptureToFile.Options.SaveAsHexDump)
-    {
-        sprintf(buff,"%08X:",0);
-        fwrite(buff,8+1,1,CaptureToFile.WriteHandle);   // 8 hex + ':'
-    }
-    else
-    {
-        if(CaptureToFile.Options.Timestamp)
-        {
-            /* Now output a timestamp */
-            time(&curtime);
-            TimeStr=ctime(&curtime);
-            if(TimeStr!=NULL)
-            {
-                strcpy(buff,TimeStr);
-                buff[24]=':';
-                fwrite(buff,strlen(buff),1,CaptureToFile.WriteHandle);
-            }
-        }
-    }
-
-    CaptureToFile.EscSeqSkiping=false;
-    CaptureToFile.HexDumpInsertPos=0;
-    CaptureToFile.HexDumpOffset=0;
+    time(&curtime);
+    CaptureToFile.TextFormatter.Start(CaptureToFile.WriteHandle,
+            CaptureToFile.Options,curtime);
 
     return true;
 }
@@ -3678,30 +4495,16 @@ bool Connection::StartCapture(void)
  ******************************************************************************/
 void Connection::StopCapture(void)
 {
-    char buff[100];
-    int r;
+    if(CaptureToFile.Binary!=NULL)
+    {
+        CaptureToFile.Binary->Close();
+        delete CaptureToFile.Binary;
+    }
+    CaptureToFile.Binary=NULL;
 
     if(CaptureToFile.WriteHandle!=NULL)
     {
-        if(CaptureToFile.Options.SaveAsHexDump)
-        {
-            /* Finish off the hex dump */
-
-            /* Fill in the hex part with spaces */
-            strcpy(buff,"   ");
-            for(r=CaptureToFile.HexDumpInsertPos;
-                    r<CAPTURE_HEXDUMP_VALUES_PER_LINE;r++)
-            {
-                fwrite(buff,3,1,CaptureToFile.WriteHandle);
-            }
-
-            /* Write the AscII preview */
-            fwrite("   ",3,1,CaptureToFile.WriteHandle);
-            fwrite(CaptureToFile.HexDumpBuff,CaptureToFile.HexDumpInsertPos,
-                    1,CaptureToFile.WriteHandle);
-            fwrite("\n",1,1,CaptureToFile.WriteHandle);
-        }
-
+        CaptureToFile.TextFormatter.Finish(CaptureToFile.WriteHandle);
         fclose(CaptureToFile.WriteHandle);
     }
     CaptureToFile.WriteHandle=NULL;
@@ -3792,128 +4595,58 @@ void Connection::GetCaptureFilename(std::string &Filename)
  ******************************************************************************/
 void Connection::HandleCaptureIncomingData(const uint8_t *Inbuff,int bytes)
 {
-    const uint8_t *Pos;
-    const uint8_t *EndPos;
-    const uint8_t *LastStart;
-    char buff[100];
     time_t curtime;
-    const char *TimeStr;
 
     /* Check if we are actively saving */
-    if(CaptureToFile.WriteHandle==NULL)
+    if(CaptureToFile.WriteHandle==NULL && CaptureToFile.Binary==NULL)
         return;
 
-    Pos=Inbuff;
-    EndPos=Pos+bytes;
+    PERFSTATS_TIMESTAMP(CaptureStart);
+    PERFSTATS_COUNT(PerfStats,e_PerfCounter_CaptureBytes,bytes);
 
-    if(CaptureToFile.Options.SaveAsHexDump)
+    if(CaptureToFile.Binary!=NULL)
     {
-        for(;Pos<EndPos;Pos++)
-        {
-            CaptureToFile.HexDumpOffset++;
-
-            sprintf(buff,"%02X ",*Pos);
-            fwrite(buff,3,1,CaptureToFile.WriteHandle);
-            CaptureToFile.HexDumpBuff[CaptureToFile.HexDumpInsertPos++]=
-                    (*Pos<32 || *Pos>126)?'.':*Pos;
-            if(CaptureToFile.HexDumpInsertPos>=CAPTURE_HEXDUMP_VALUES_PER_LINE)
-            {
-                /* Write out the AscII preview */
-                fwrite("   ",3,1,CaptureToFile.WriteHandle);
-                fwrite(CaptureToFile.HexDumpBuff,
-                        CAPTURE_HEXDUMP_VALUES_PER_LINE,1,
-                        CaptureToFile.WriteHandle);
-
-                sprintf(buff,"\n%08X:",CaptureToFile.HexDumpOffset);
-                fwrite(buff,8+1+1,1,CaptureToFile.WriteHandle); // 8 hex + \n + ':'
-
-                CaptureToFile.HexDumpInsertPos=0;
-            }
-        }
+        CaptureToFile.Binary->WriteRecord(e_CaptureRec_RX,Inbuff,bytes);
     }
     else
     {
-        /* Handle options in blocks */
-        LastStart=Pos;
-        for(;Pos<EndPos;Pos++)
-        {
-            if(CaptureToFile.Options.Timestamp)
-            {
-                if(*Pos=='\n')
-                {
-                    /* Output the block and then a timestamp */
-                    fwrite(LastStart,Pos-LastStart+1,1,
-                            CaptureToFile.WriteHandle);
-                    /* Now output a timestamp */
-                    time(&curtime);
-                    TimeStr=ctime(&curtime);
-                    if(TimeStr!=NULL)
-                    {
-                        strcpy(buff,TimeStr);
-                        buff[24]=':';
-                        fwrite(buff,strlen(buff),1,CaptureToFile.WriteHandle);
-                    }
-                    LastStart=Pos+1;
-                    continue;
-                }
-            }
+        time(&curtime);
+        CaptureToFile.TextFormatter.Format(CaptureToFile.WriteHandle,Inbuff,
+                bytes,curtime);
+    }
 
-            if(CaptureToFile.Options.StripEsc)
-            {
-                if(!CaptureToFile.EscSeqSkiping)
-                {
-                    /* We are looking for esc char */
-                    if(*Pos==27)    // 27 esc
-                    {
-                        /* Output the block and skip this char */
-                        fwrite(LastStart,Pos-LastStart,1,
-                                CaptureToFile.WriteHandle);
-                        CaptureToFile.EscSeqSkiping=true;
-                        LastStart=Pos+1;
-                        continue;
-                    }
-                }
-                else
-                {
-                    /* We strip everything until we see a letter (upper or
-                       lower) or another ESC */
-                    if(*Pos==27 ||
-                            (*Pos>='a' && *Pos<='z') ||
-                            (*Pos>='A' && *Pos<='Z'))
-                    {
-                        /* Ok, exit this mode */
-                        CaptureToFile.EscSeqSkiping=false;
-
-                        /* If we hit an ESC ESC we want to output both */
-                        if(*Pos==27)
-                        {
-                            buff[0]=27;
-                            buff[1]=27;
-                            fwrite(buff,2,1,CaptureToFile.WriteHandle);
-                        }
-                    }
-                    /* Skip this char */
-                    LastStart=Pos+1;
-                    continue;
-                }
-            }
+    PERFSTATS_STAGE_DONE(PerfStats,e_PerfStage_CaptureWrite,CaptureStart);
+}
 
-            if(CaptureToFile.Options.StripCtrl)
-            {
-                if(*Pos<32 && *Pos!='\n' && *Pos!='\r')
-                {
-                    /* Output the block and skip this char */
-                    fwrite(LastStart,Pos-LastStart,1,CaptureToFile.WriteHandle);
-                    LastStart=Pos+1;
-                    continue;
-                }
-            }
-        }
-        if(LastStart!=Pos)
-        {
-            fwrite(LastStart,Pos-LastStart,1,CaptureToFile.WriteHandle);
-        }
-    }
+/*******************************************************************************
+ * NAME:
+ *    Connection::HandleCaptureOutGoingData
+ *
+ * SYNOPSIS:
+ *    void Connection::HandleCaptureOutGoingData(const uint8_t *Outbuff,
+ *              int bytes);
+ *
+ * PARAMETERS:
+ *    Outbuff [I] -- The bytes we just sent
+ *    bytes [I] -- The number of bytes we just sent
+ *
+ * FUNCTION:
+ *    This function handles saving outgoing data to the capture system.
+ *    Only the binary capture format keeps sent bytes (the text formats
+ *    only have the bytes we got).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::HandleCaptureIncomingData()
+ ******************************************************************************/
+void Connection::HandleCaptureOutGoingData(const uint8_t *Outbuff,int bytes)
+{
+    if(CaptureToFile.Binary==NULL)
+        return;
+
+    CaptureToFile.Binary->WriteRecord(e_CaptureRec_TX,Outbuff,bytes);
 }
 
 /*******************************************************************************
@@ -4624,6 +5357,8 @@ void Connection::FinishedUpload(bool Aborted)
 {
     Upload.Stats.InProgress=false;
     Upload.Timeout=0;
+    if(!Download.Stats.InProgress)
+        TimerWheel_Stop(FileTransTimer);
 
     if(Aborted)
     {
@@ -5030,6 +5765,8 @@ void Connection::DownloadSetNumberOfBytesRecv(uint64_t BytesTransfered)
 void Connection::FinishedDownload(bool Aborted)
 {
     Download.Stats.InProgress=false;
+    if(!Upload.Stats.InProgress)
+        TimerWheel_Stop(FileTransTimer);
 
     if(Aborted)
     {
@@ -5057,40 +5794,27 @@ void Connection::FinishedDownload(bool Aborted)
  *    NONE
  *
  * FUNCTION:
- *    This function runs the file transfer timeouts for a upload / download.
+ *    This function is called when the file transfer timer goes off.  It
+ *    sends the timeout to the upload / download.  The timer repeats so the
+ *    next timeout is already queued.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    Connection::FileTransSetTimeout()
  ******************************************************************************/
 void Connection::FileTransTick(void)
 {
-    uint64_t Time;
-
-    if(Upload.Stats.InProgress && Upload.Timeout!=0)
+    if((Upload.Stats.InProgress && Upload.Timeout!=0) ||
+            (Download.Stats.InProgress && Download.Timeout!=0))
     {
-        Time=GetMSCounter();
-
-        if(Time-Upload.LastTimeoutTick>=Upload.Timeout)
-        {
-            /* Send timeout */
-            FTPS_TimeoutTransfer(FTPConData);
-            FileTransRestartTimeout();
-        }
+        /* Send timeout */
+        FTPS_TimeoutTransfer(FTPConData);
     }
-
-    if(Download.Stats.InProgress && Download.Timeout!=0)
+    else
     {
-        Time=GetMSCounter();
-
-        if(Time-Download.LastTimeoutTick>=Download.Timeout)
-        {
-            /* Send timeout */
-            FTPS_TimeoutTransfer(FTPConData);
-            FileTransRestartTimeout();
-        }
+        TimerWheel_Stop(FileTransTimer);
     }
 }
 
@@ -5106,7 +5830,7 @@ void Connection::FileTransTick(void)
  *
  * FUNCTION:
  *    This function sets how many ms have to go pass before we send a timeout
- *    to the FTP.
+ *    to the FTP.  0 turns the timeout off.
  *
  * RETURNS:
  *    NONE
@@ -5118,7 +5842,12 @@ void Connection::FileTransSetTimeout(uint32_t MSec)
 {
     Upload.Timeout=MSec;
     Download.Timeout=MSec;
-    FileTransRestartTimeout();
+
+    TimerWheel_SetTimeout(FileTransTimer,MSec);
+    if(MSec==0)
+        TimerWheel_Stop(FileTransTimer);
+    else
+        TimerWheel_Start(FileTransTimer);
 }
 
 /*******************************************************************************
@@ -5132,7 +5861,9 @@ void Connection::FileTransSetTimeout(uint32_t MSec)
  *    NONE
  *
  * FUNCTION:
- *    This function restarts the FTP timeout counter.
+ *    This function restarts the FTP timeout counter.  The protocols call
+ *    this for every block they get so it only moves the timer in the
+ *    timer wheel.
  *
  * RETURNS:
  *    NONE
@@ -5142,12 +5873,8 @@ void Connection::FileTransSetTimeout(uint32_t MSec)
  ******************************************************************************/
 void Connection::FileTransRestartTimeout(void)
 {
-    uint64_t Time;
-
-    Time=GetMSCounter();
-
-    Upload.LastTimeoutTick=Time;
-    Download.LastTimeoutTick=Time;
+    if(Upload.Timeout!=0 || Download.Timeout!=0)
+        TimerWheel_Start(FileTransTimer);
 }
 
 /*******************************************************************************
@@ -5230,6 +5957,101 @@ void Connection::HandleHexDisplayIncomingData(const uint8_t *inbuff,int Bytes)
     SendMWEvent(ConMWEvent_HexDisplayUpdate,&EventData);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Connection::ZModemAutoDetect
+ *
+ * SYNOPSIS:
+ *    void Connection::ZModemAutoDetect(const uint8_t *inbuff,int Bytes);
+ *
+ * PARAMETERS:
+ *    inbuff [I] -- The bytes that just came in
+ *    Bytes [I] -- The number of bytes in 'inbuff'
+ *
+ * FUNCTION:
+ *    This function looks for the start of the hex ZRQINIT header that a
+ *    ZModem sender (sz) sends when it starts.  When we see it we start a
+ *    ZModem download.
+ *
+ *    We don't start the download from here because that asks for the
+ *    filename (which runs a dialog) and we are in the middle of processing
+ *    the incoming bytes.  Instead we start a timer and do it from there.
+ *    The sender will resend the ZRQINIT until we answer.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::InformOfZModemAutoStartTimeout()
+ ******************************************************************************/
+void Connection::ZModemAutoDetect(const uint8_t *inbuff,int Bytes)
+{
+    static const uint8_t ZRQInit[]={'*','*',0x18,'B','0','0'};
+    int r;
+
+    for(r=0;r<Bytes;r++)
+    {
+        if(inbuff[r]==ZRQInit[ZModemAutoMatch])
+        {
+            ZModemAutoMatch++;
+            if(ZModemAutoMatch==sizeof(ZRQInit))
+            {
+                ZModemAutoMatch=0;
+                if(!UITimerRunning(ZModemAutoStartTimer))
+                    UITimerStart(ZModemAutoStartTimer);
+            }
+        }
+        else if(inbuff[r]=='*')
+        {
+            /* "***" is still the start of a header */
+            if(ZModemAutoMatch!=2)
+                ZModemAutoMatch=1;
+        }
+        else
+        {
+            ZModemAutoMatch=0;
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::InformOfZModemAutoStartTimeout
+ *
+ * SYNOPSIS:
+ *    void Connection::InformOfZModemAutoStartTimeout(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is called after ZModemAutoDetect() has seen a ZModem
+ *    sender start.  It switches the download protocol to ZModem and starts
+ *    the download.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::ZModemAutoDetect()
+ ******************************************************************************/
+void Connection::InformOfZModemAutoStartTimeout(void)
+{
+    if(Upload.Stats.InProgress || Download.Stats.InProgress)
+        return;
+
+    if(Download.ProtocolID!=ZMODEM_AUTO_DOWNLOAD_ID)
+    {
+        /* The options belong to the old protocol */
+        Download.DownloadOptions.clear();
+        SetDownloadProtocol(ZMODEM_AUTO_DOWNLOAD_ID);
+    }
+
+    /* If this fails (the user canceled the filename) the sender will time
+       out on it's own */
+    StartDownload();
+}
+
 /*******************************************************************************
  * NAME:
  *    Connection::HandleHexDisplayOutGoingData
@@ -5718,7 +6540,7 @@ e_BottomPanelTabType Connection::GetBottomPanelInfo(void)
  *
  * PARAMETERS:
  *    Sender [I] -- Is this connection to send packs?
- *    PacketLen [I] -- The number of bytes in a packet.
+ *    PacketLen [I] -- The number of bytes in the pattern sent in every packet.
  *    PacketsCount [I] -- The number of packets to send before we stop
  *    Delay [I] -- The delay between packets in mS.
  *    PacketData [I] -- The data pattern to send.  This must have 'PacketLen'
@@ -5730,6 +6552,9 @@ e_BottomPanelTabType Connection::GetBottomPanelInfo(void)
  *    This function sets up for a com test.  It stops any test in progress
  *    and reset the stats and the test state machine.
  *
+ *    Every packet is sent with a small header in front of the pattern
+ *    (see ComTestFrames.cpp) so the receiver can resync and measure latency.
+ *
  *    You need to start the test before the connection will tx / rx any data.
  *
  * RETURNS:
@@ -5740,29 +6565,58 @@ e_BottomPanelTabType Connection::GetBottomPanelInfo(void)
  *    but it must remain valid until the test is finished.
  *
  * SEE ALSO:
- *    
+ *    Connection::StartComTest()
  ******************************************************************************/
 void Connection::SetupComTest(bool Sender,uint32_t PacketLen,
         uint32_t PacketsCount,uint32_t Delay,uint8_t *PacketData)
 {
+    StopComTest();
+
     ComTest.Sender=Sender;
     ComTest.SendingPackets=false;
     ComTest.PacketLen=PacketLen;
     ComTest.PacketsCount=PacketsCount;
     ComTest.DelayBetweenPackets_mS=Delay;
     ComTest.Packet=PacketData;
-    ComTest.RxPatternIndex=0;
-    ComTest.Syncing=false;
 
     ComTest.Stats.InProgress=false;
+    ResetComTestStats();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::ResetComTestStats
+ *
+ * SYNOPSIS:
+ *    void Connection::ResetComTestStats(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function clears the com test stats (not including 'InProgress').
+ *    The send thread must not be running.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::SetupComTest()
+ ******************************************************************************/
+void Connection::ResetComTestStats(void)
+{
+    ComTest.Checker.Reset();
+    ComTest.RateStart_ns=GetElapsedTime_ns();
+    ComTest.RateBytes=0;
+
     ComTest.Stats.PacketsSent=0;
     ComTest.Stats.BytesSent=0;
-    ComTest.Stats.PacketsRx=0;
     ComTest.Stats.ErrorsDetected=0;
     ComTest.Stats.BytesPerSec=0;
     ComTest.Stats.SendErrors=0;
     ComTest.Stats.SendBusyErrors=0;
     ComTest.Stats.LastRxTimeStamp=0;
+    ComTest.Stats.Rx=ComTest.Checker.GetCounters();
 }
 
 /*******************************************************************************
@@ -5777,54 +6631,55 @@ void Connection::SetupComTest(bool Sender,uint32_t PacketLen,
  *
  * FUNCTION:
  *    This function starts a com test on this connection.  If it's a sender
- *    it will start sending packets.  It will also send an rx packets to
- *    the com test system.
+ *    it will start a thread that sends the packets as fast as the
+ *    connection will take them (or with the delay between packets).
+ *    Any rx bytes are sent to the com test checker.
  *
  * RETURNS:
  *    true -- This connection has started the test
  *    false -- There was an error
  *
  * SEE ALSO:
- *    
+ *    Connection::StopComTest()
  ******************************************************************************/
 bool Connection::StartComTest(void)
 {
     if(ComTest.Packet==NULL || ComTest.PacketLen<1 || ComTest.PacketsCount<1)
         return false;
 
-    ComTest.RxPatternIndex=0;
-    ComTest.Syncing=false;
-
-    ComTest.Stats.PacketsSent=0;
-    ComTest.Stats.BytesSent=0;
-    ComTest.Stats.PacketsRx=0;
-    ComTest.Stats.ErrorsDetected=0;
-    ComTest.Stats.BytesPerSec=0;
-    ComTest.Stats.SendErrors=0;
-    ComTest.Stats.SendBusyErrors=0;
-    time(&ComTest.Stats.LastRxTimeStamp);
+    StopComTest();
 
-    if(ComTest.Sender && ComTest.DelayBetweenPackets_mS>0)
+    if(ComTest.StatsMutex==NULL)
     {
-        /* If we are the sender then we need to setup a timer to send packets */
-        ComTest.Timer=AllocUITimer();
-        if(ComTest.Timer==NULL)
+        ComTest.StatsMutex=AllocMutex();
+        if(ComTest.StatsMutex==NULL)
             return false;
+    }
 
-        SetupUITimer(ComTest.Timer,Con_ComTestTimeout,(uintptr_t)this,true);
-
-        UITimerSetTimeout(ComTest.Timer,ComTest.DelayBetweenPackets_mS);
-        UITimerStart(ComTest.Timer);
+    if(!ComTest.Framer.Setup(ComTest.Packet,ComTest.PacketLen) ||
+            !ComTest.Checker.Setup(ComTest.Packet,ComTest.PacketLen))
+    {
+        return false;
     }
 
-    ComTest.SendingPackets=false;
-    if(ComTest.Sender)
-        ComTest.SendingPackets=true;
+    ResetComTestStats();
+    time(&ComTest.Stats.LastRxTimeStamp);
 
     ComTest.Stats.InProgress=true;
 
-    /* Send the first packet */
-    InformOfComTestTimeout();
+    ComTest.SendingPackets=false;
+    if(ComTest.Sender)
+    {
+        ComTest.SendingPackets=true;
+        ComTest.RequestThreadQuit=false;
+        ComTest.SendThread=StartThread(false,Con_ComTestSendThread,this);
+        if(ComTest.SendThread==NULL)
+        {
+            ComTest.SendingPackets=false;
+            ComTest.Stats.InProgress=false;
+            return false;
+        }
+    }
 
     if(ComTest.UpdateFn!=NULL)
         ComTest.UpdateFn(this);
@@ -5843,22 +6698,27 @@ bool Connection::StartComTest(void)
  *    NONE
  *
  * FUNCTION:
- *    This function stops a com test.
+ *    This function stops a com test.  This waits for the send thread to
+ *    exit.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    Connection::StartComTest()
  ******************************************************************************/
 void Connection::StopComTest(void)
 {
-    if(ComTest.Timer!=NULL)
+    if(!ComTest.Stats.InProgress && ComTest.SendThread==NULL)
+        return;
+
+    if(ComTest.SendThread!=NULL)
     {
-        UITimerStop(ComTest.Timer);
-        FreeUITimer(ComTest.Timer);
-        ComTest.Timer=NULL;
+        ComTest.RequestThreadQuit=true;
+        Wait4ThreadToExit(ComTest.SendThread);
+        ComTest.SendThread=NULL;
     }
+    ComTest.SendingPackets=false;
     ComTest.Stats.InProgress=false;
     if(ComTest.UpdateFn!=NULL)
         ComTest.UpdateFn(this);
@@ -5866,70 +6726,96 @@ void Connection::StopComTest(void)
 
 /*******************************************************************************
  * NAME:
- *    Connection::InformOfComTestTimeout
+ *    Connection::ComTestSendThread
  *
  * SYNOPSIS:
- *    void Connection::InformOfComTestTimeout(void);
+ *    void Connection::ComTestSendThread(void);
  *
  * PARAMETERS:
  *    NONE
  *
  * FUNCTION:
- *    This function is called when the timer goes off to send com test data.
+ *    This function is the com test send thread.  It sends packets back to
+ *    back (or with the delay between them) until all the packets are sent,
+ *    there is an error, or we are asked to quit.
+ *
+ *    This thread only touches the tx side of the stats (under 'StatsMutex')
+ *    and never calls into the UI.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    Connection::StartComTest()
  ******************************************************************************/
-void Connection::InformOfComTestTimeout(void)
+void Connection::ComTestSendThread(void)
 {
-    /* Send the next test packet */
-    if(ComTest.Packet==NULL || ComTest.PacketLen<1 || ComTest.PacketsCount<1 ||
-            !ComTest.Stats.InProgress || IOHandle==NULL ||
-            !ComTest.SendingPackets)
-    {
-        return;
-    }
+    const uint8_t *Frame;
+    uint32_t FrameLen;
+    uint32_t FrameSent;
+    uint32_t Seq;
+    uint32_t Waited;
+    uint32_t Sleep;
+    int Wrote;
+    bool Abort;
 
-    /* We bypass WriteData() so we can send a little faster (this also
-       skips all the other sub systems) */
-    switch(IOS_WriteData(IOHandle,ComTest.Packet,ComTest.PacketLen))
+    FrameLen=ComTest.Framer.GetFrameLen();
+    Frame=NULL;
+    FrameSent=0;
+    Seq=0;
+    Abort=false;
+    while(!ComTest.RequestThreadQuit && !Abort && Seq<ComTest.PacketsCount)
     {
-        case e_IOSysIOError_Success:
-            ComTest.Stats.PacketsSent++;
-            ComTest.Stats.BytesSent+=ComTest.PacketLen;
-            if(ComTest.Stats.PacketsSent>=ComTest.PacketsCount)
-            {
-                /* We are done sending */
-                ComTest.SendingPackets=false;
-                if(ComTest.Timer!=NULL)
+        /* We bypass WriteData() so we can send a little faster (this also
+           skips all the other sub systems) */
+        if(FrameSent==0)
+            Frame=ComTest.Framer.BuildFrame(Seq,GetElapsedTime_ns());
+        switch(IOS_WriteData(IOHandle,Frame+FrameSent,FrameLen-FrameSent,
+                &Wrote))
+        {
+            case e_IOSysIOError_Success:
+                FrameSent=0;
+                LockMutex(ComTest.StatsMutex);
+                ComTest.Stats.PacketsSent++;
+                ComTest.Stats.BytesSent+=FrameLen;
+                UnLockMutex(ComTest.StatsMutex);
+                Seq++;
+
+                /* Wait between packets (checking for quit) */
+                Waited=0;
+                while(Waited<ComTest.DelayBetweenPackets_mS &&
+                        !ComTest.RequestThreadQuit)
                 {
-                    UITimerStop(ComTest.Timer);
-                    FreeUITimer(ComTest.Timer);
-                    ComTest.Timer=NULL;
+                    Sleep=ComTest.DelayBetweenPackets_mS-Waited;
+                    if(Sleep>COMTEST_SEND_POLL_MS)
+                        Sleep=COMTEST_SEND_POLL_MS;
+                    OS_Sleep(Sleep);
+                    Waited+=Sleep;
                 }
-            }
-            if(ComTest.UpdateFn!=NULL)
-                ComTest.UpdateFn(this);
-        break;
-        case e_IOSysIOError_GenericIO:
-        case e_IOSysIOError_Disconnect:
-        case e_IOSysIOErrorMAX:
-        default:
-            /* Abort */
-            StopComTest();
-            ComTest.Stats.SendErrors++;
-            if(ComTest.UpdateFn!=NULL)
-                ComTest.UpdateFn(this);
-        break;
-        case e_IOSysIOError_Busy:
-            ComTest.Stats.SendBusyErrors++;
-            if(ComTest.UpdateFn!=NULL)
-                ComTest.UpdateFn(this);
-        break;
+            break;
+            case e_IOSysIOError_Busy:
+                /* The driver is full (it may have taken the start of the
+                   frame), give it a moment and send the rest */
+                FrameSent+=Wrote;
+                LockMutex(ComTest.StatsMutex);
+                ComTest.Stats.SendBusyErrors++;
+                UnLockMutex(ComTest.StatsMutex);
+                OS_Sleep(1);
+            break;
+            case e_IOSysIOError_GenericIO:
+            case e_IOSysIOError_Disconnect:
+            case e_IOSysIOErrorMAX:
+            default:
+                /* Abort */
+                LockMutex(ComTest.StatsMutex);
+                ComTest.Stats.SendErrors++;
+                UnLockMutex(ComTest.StatsMutex);
+                Abort=true;
+            break;
+        }
     }
+
+    ComTest.SendingPackets=false;
 }
 
 /*******************************************************************************
@@ -5957,34 +6843,6 @@ bool Connection::IsComTestRunning(void)
     return ComTest.Stats.InProgress;
 }
 
-/*******************************************************************************
- * NAME:
- *    Connection::ComTestFastTick
- *
- * SYNOPSIS:
- *    void Connection::ComTestFastTick(void);
- *
- * PARAMETERS:
- *    NONE
- *
- * FUNCTION:
- *    This function is called when doing a com test with 0mS delay between
- *    packets.
- *
- *    You should process events and then call this is in a loop.  It will
- *    send the next packet in the test.
- *
- * RETURNS:
- *    NONE
- *
- * SEE ALSO:
- *    
- ******************************************************************************/
-void Connection::ComTestFastTick(void)
-{
-    InformOfComTestTimeout();
-}
-
 /*******************************************************************************
  * NAME:
  *    Connection::HandleComTestRx
@@ -5997,78 +6855,37 @@ void Connection::ComTestFastTick(void)
  *    bytes [I] -- The number of bytes in 'inbuff'
  *
  * FUNCTION:
- *    This function handles incoming bytes when in com test mode.  It checks
- *    the pattern and flags errors.
+ *    This function handles incoming bytes when in com test mode.  The bytes
+ *    are checked by the com test checker and the rx throughput is updated.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    ComTestChecker::Process()
  ******************************************************************************/
 void Connection::HandleComTestRx(uint8_t *inbuff,int bytes)
 {
-    uint8_t *EndPtr;
-    uint8_t *p;
-    EndPtr=&inbuff[bytes];
-    p=inbuff;
-    unsigned int s;
+    uint64_t Now;
+    const struct ComTestRxCounters *Rx;
 
     time(&ComTest.Stats.LastRxTimeStamp);
+    Now=GetElapsedTime_ns();
 
-    while(p<EndPtr)
-    {
-        if(!ComTest.Syncing)
-        {
-            /* Is it the expected byte */
-            if(*p!=ComTest.Packet[ComTest.RxPatternIndex])
-            {
-                /* Messed up byte */
-                ComTest.Stats.ErrorsDetected++;
-                if(ComTest.UpdateFn!=NULL)
-                    ComTest.UpdateFn(this);
-                /* Ok, try to resync */
-                ComTest.Syncing=true;
-            }
-            else
-            {
-                ComTest.RxPatternIndex++;
-                if(ComTest.RxPatternIndex>=ComTest.PacketLen)
-                {
-                    ComTest.Stats.PacketsRx++;
-                    if(ComTest.UpdateFn!=NULL)
-                        ComTest.UpdateFn(this);
-                    ComTest.RxPatternIndex=0;
-                }
-            }
-        }
-        if(ComTest.Syncing)
-        {
-            /* Search the whole pattern to see if we find the byte */
-            s=ComTest.RxPatternIndex;
-            for(;;)
-            {
-                if(*p==ComTest.Packet[s])
-                {
-                    /* Found it, move to the next byte and exit sync */
-                    ComTest.RxPatternIndex=s+1;
-                    if(ComTest.RxPatternIndex>=ComTest.PacketLen)
-                        ComTest.RxPatternIndex=0;
-                    ComTest.Syncing=false;
-                    break;
-                }
+    ComTest.Checker.Process(inbuff,bytes,Now);
 
-                s++;
-                if(s>=ComTest.PacketLen)
-                    s=0;
-                if(s==ComTest.RxPatternIndex)
-                {
-                    /* Looked at every byte, didn't find it */
-                    break;
-                }
-            }
-        }
-        p++;
+    Rx=&ComTest.Checker.GetCounters();
+    ComTest.Stats.Rx=*Rx;
+    ComTest.Stats.ErrorsDetected=Rx->ByteErrors+Rx->PacketsLost+
+            Rx->BadFrames;
+
+    ComTest.RateBytes+=bytes;
+    if(Now-ComTest.RateStart_ns>=COMTEST_RATE_WINDOW_NS)
+    {
+        ComTest.Stats.BytesPerSec=ComTest.RateBytes*1000000000ULL/
+                (Now-ComTest.RateStart_ns);
+        ComTest.RateBytes=0;
+        ComTest.RateStart_ns=Now;
     }
 }
 
@@ -6077,23 +6894,28 @@ void Connection::HandleComTestRx(uint8_t *inbuff,int bytes)
  *    Connection::GetComTestStats
  *
  * SYNOPSIS:
- *    const struct ComTestStats *Connection::GetComTestStats(void);
+ *    void Connection::GetComTestStats(struct ComTestStats *RetStats);
  *
  * PARAMETERS:
- *    NONE
+ *    RetStats [O] -- Where to copy the stats to
  *
  * FUNCTION:
- *    This function gets access to the com test stats.
+ *    This function gets a copy of the com test stats.  The tx stats are
+ *    updated by the send thread so we take a copy under lock.
  *
  * RETURNS:
- *    A pointer to the com test stats.  This is valid as long as the class is.
+ *    NONE
  *
  * SEE ALSO:
  *    
  ******************************************************************************/
-const struct ComTestStats *Connection::GetComTestStats(void)
+void Connection::GetComTestStats(struct ComTestStats *RetStats)
 {
-    return &ComTest.Stats;
+    if(ComTest.StatsMutex!=NULL)
+        LockMutex(ComTest.StatsMutex);
+    *RetStats=ComTest.Stats;
+    if(ComTest.StatsMutex!=NULL)
+        UnLockMutex(ComTest.StatsMutex);
 }
 
 /*******************************************************************************
@@ -6231,130 +7053,108 @@ void Connection::SetTransmitDelayPerLine(unsigned int ms)
  *    NONE
  *
  * FUNCTION:
- *    This function takes the transmit delay change and updates the buffers
- *    and timers.
+ *    This function passes the transmit delays on to the transmit pacer.
+ *    If the delays have been turned off anything still queued is sent
+ *    as fast as the driver will take it.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
- ******************************************************************************/
-void Connection::ApplyTransmitDelayChange(void)
-{
-    if(TransmitDelayByte==0 && TransmitDelayLine==0)
-    {
-        if(UITimerRunning(TransmitDelayTimer))
-        {
-            /* We are waiting to send the next block, abort the timer and
-               just send whatever's left */
-            UITimerStop(TransmitDelayTimer);
-            InternalWriteBytes(&TransmitDelayBuffer[TransmitDelayBufferReadPos],
-                    TransmitDelayBufferWritePos-TransmitDelayBufferReadPos);
-        }
-
-        /* We don't need the queue, free it */
-        if(TransmitDelayBuffer!=NULL)
-            FreeTransmitDelayBuffer();
-    }
-    else
-    {
-        if(TransmitDelayLine!=0 && TransmitDelayByte==0)
-            UITimerSetTimeout(TransmitDelayTimer,TransmitDelayLine);
-        if(TransmitDelayByte!=0)
-            UITimerSetTimeout(TransmitDelayTimer,TransmitDelayByte);
-    }
-
+ *    
+ ******************************************************************************/
+void Connection::ApplyTransmitDelayChange(void)
+{
+    TxPace.SetDelays(TransmitDelayByte*1000,TransmitDelayLine*1000);
 }
 
 /*******************************************************************************
  * NAME:
- *    Connection::FreeTransmitDelayBuffer
+ *    Connection::TxPaceWrite
  *
  * SYNOPSIS:
- *    void Connection::FreeTransmitDelayBuffer(void);
+ *    e_TxPacerWriteType Connection::TxPaceWrite(const uint8_t *Data,
+ *          uint32_t Bytes,uint32_t *Written);
  *
  * PARAMETERS:
- *    NONE
+ *    Data [I] -- The bytes to send
+ *    Bytes [I] -- The number of bytes to send
+ *    Written [O] -- The number of bytes the driver took
  *
  * FUNCTION:
- *    This function frees the transmit delay buffers.
+ *    This function sends bytes for the transmit pacer.  This is called from
+ *    the pacer's thread so it only talks to the driver.  Everything else
+ *    (echo, capture, etc) is done when InformOfDelayTransmitTimeout() picks
+ *    up the sent bytes.
  *
  * RETURNS:
- *    NONE
+ *    e_TxPacerWrite_Sent -- The bytes have been sent
+ *    e_TxPacerWrite_Busy -- The driver is full (it may have taken some of
+ *                           the bytes), try the rest again
+ *    e_TxPacerWrite_Error -- The driver had an error
+ *    e_TxPacerWrite_Disconnect -- The driver has been disconnected
  *
  * SEE ALSO:
- *    
- *****************************************************************************/
-void Connection::FreeTransmitDelayBuffer(void)
+ *    Connection::InternalWriteBytes()
+ ******************************************************************************/
+e_TxPacerWriteType Connection::TxPaceWrite(const uint8_t *Data,uint32_t Bytes,
+        uint32_t *Written)
 {
-    UITimerStop(TransmitDelayTimer);
+    e_IOSysIOErrorType Ret;
+    int Wrote;
 
-    free(TransmitDelayBuffer);
-    TransmitDelayBuffer=NULL;
-    TransmitDelayBufferSize=0;
-    TransmitDelayBufferWritePos=0;
+    Ret=IOS_WriteData(IOHandle,Data,Bytes,&Wrote);
+    *Written=Wrote;
+    switch(Ret)
+    {
+        case e_IOSysIOError_Success:
+            return e_TxPacerWrite_Sent;
+        case e_IOSysIOError_Busy:
+            return e_TxPacerWrite_Busy;
+        case e_IOSysIOError_Disconnect:
+            return e_TxPacerWrite_Disconnect;
+        case e_IOSysIOError_GenericIO:
+        case e_IOSysIOErrorMAX:
+        default:
+        break;
+    }
+    return e_TxPacerWrite_Error;
 }
 
 /*******************************************************************************
  * NAME:
- *    Connection::QueueTransmitDelayData
+ *    Connection::StopTxPace
  *
  * SYNOPSIS:
- *    bool Connection::QueueTransmitDelayData(const uint8_t *Data,
- *              int Bytes);
+ *    void Connection::StopTxPace(void);
  *
  * PARAMETERS:
- *    Data [I] -- The data to send
- *    Bytes [I] -- The number of bytes to send
+ *    NONE
  *
  * FUNCTION:
- *    This function adds data to the transmit delay buffer.
+ *    This function stops the transmit pacer's thread and throws away
+ *    anything it hasn't sent yet.  This must be called before the IO handle
+ *    is closed.
  *
  * RETURNS:
- *    true -- Data was queued
- *    false -- There was an error
+ *    NONE
  *
  * SEE ALSO:
  *    
  ******************************************************************************/
-bool Connection::QueueTransmitDelayData(const uint8_t *Data,int Bytes)
+void Connection::StopTxPace(void)
 {
-    uint8_t *NewMemory;
-    unsigned int AllocSize;
+    uint8_t Buff[TRANSMIT_DELAY_DRAIN_CHUNK];
 
-    if(TransmitDelayBuffer==NULL)
-    {
-        /* Ok, we need to allocate a starting buffer */
-        AllocSize=Bytes;
-        if(AllocSize<TRANSMIT_DELAY_BUFFER_SIZE)
-            AllocSize=TRANSMIT_DELAY_BUFFER_SIZE;
-        TransmitDelayBuffer=(uint8_t *)malloc(AllocSize);
-        if(TransmitDelayBuffer==NULL)
-            return false;
-        TransmitDelayBufferSize=AllocSize;
-        TransmitDelayBufferWritePos=0;
-        TransmitDelayBufferReadPos=0;
-    }
-
-    if(TransmitDelayBufferWritePos+Bytes>TransmitDelayBufferSize)
-    {
-        AllocSize=Bytes;
-        if(AllocSize<TRANSMIT_DELAY_BUFFER_SIZE)
-            AllocSize=TRANSMIT_DELAY_BUFFER_SIZE;
-        AllocSize+=TransmitDelayBufferWritePos;
-        NewMemory=(uint8_t *)realloc(TransmitDelayBuffer,AllocSize);
-        if(NewMemory==NULL)
-            return false;
-
-        TransmitDelayBuffer=NewMemory;
-        TransmitDelayBufferSize=AllocSize;
-    }
+    TxPace.Stop();
+    TxPace.TakeError();
 
-    memcpy(&TransmitDelayBuffer[TransmitDelayBufferWritePos],Data,Bytes);
-    TransmitDelayBufferWritePos+=Bytes;
+    /* Throw away anything that was sent but not picked up yet */
+    while(TxPace.TakeSentBytes(Buff,sizeof(Buff))>0)
+        ;
 
-    return true;
+    if(TransmitDelayTimer!=NULL)
+        TimerWheel_Stop(TransmitDelayTimer);
 }
 
 /*******************************************************************************
@@ -6368,91 +7168,48 @@ bool Connection::QueueTransmitDelayData(const uint8_t *Data,int Bytes)
  *    NONE
  *
  * FUNCTION:
- *    This function is called to send the next byte / block from the delayed
- *    transmit system.
+ *    This function is called every TRANSMIT_DELAY_POLL_MS while the
+ *    transmit pacer is busy.  The pacer does the sending (and the timing)
+ *    from its own thread, this picks up what it sent and does the local
+ *    echo, hex display, capture, and data processor out going bytes for it.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    Connection::WriteData()
  ******************************************************************************/
 void Connection::InformOfDelayTransmitTimeout(void)
 {
-    const uint8_t *Send;
-    uint32_t Delay;
-    unsigned int r;
-
-    if(TransmitDelayBuffer==NULL)
-        return;
+    uint8_t Buff[TRANSMIT_DELAY_DRAIN_CHUNK];
+    uint32_t Bytes;
 
-    if(!IsConnected)
+    while((Bytes=TxPace.TakeSentBytes(Buff,sizeof(Buff)))>0)
     {
-        FreeTransmitDelayBuffer();
-        return;
-    }
+        Con_SetActiveConnection(this);
+        DPS_ProcessorOutGoingBytes(&ProcessorData,Buff,Bytes);
+        Con_SetActiveConnection(NULL);
 
-    if(TransmitDelayBufferWritePos<=TransmitDelayBufferReadPos)
-    {
-        /* Nothing to send, reset to the start of buffer and wait for more
-           data */
-        TransmitDelayBufferWritePos=0;
-        TransmitDelayBufferReadPos=0;
-        return;
+        NoteBytesWritten(Buff,Bytes);
     }
 
-    Send=&TransmitDelayBuffer[TransmitDelayBufferReadPos];
-
-    if(TransmitDelayByte>0)
-    {
-        /* Delay between bytes, so we only send 1 byte at a time */
-        TransmitDelayBufferReadPos++;
-        InternalWriteBytes(Send,1);
-
-        /* Setup for the next byte delay */
-        Delay=TransmitDelayByte;
-
-        if(*Send=='\n' && TransmitDelayLine>0)
-        {
-            /* It was a new line char so we delay for the line */
-            Delay=TransmitDelayLine;
-        }
-
-        if(Delay<TransmitDelayByte)
-            Delay=TransmitDelayByte;
-    }
-    else if(TransmitDelayLine>0)
+    switch(TxPace.TakeError())
     {
-        /* Ok, send at full speed until we see a newline char */
-        for(r=TransmitDelayBufferReadPos;r<TransmitDelayBufferWritePos;r++)
-            if(TransmitDelayBuffer[r]=='\n')
-                break;
-        if(r==TransmitDelayBufferWritePos)
-        {
-            /* No new line char, send the whole thing */
-            InternalWriteBytes(Send,
-                    TransmitDelayBufferWritePos-TransmitDelayBufferReadPos);
-            TransmitDelayBufferWritePos=0;
-            TransmitDelayBufferReadPos=0;
-            Delay=0;
-        }
-        else
-        {
-            /* Send out up to (and including) the '\n' */
-            InternalWriteBytes(Send,r-TransmitDelayBufferReadPos+1);
-            TransmitDelayBufferReadPos+=(r-TransmitDelayBufferReadPos+1);
-            Delay=TransmitDelayLine;
-        }
+        case e_TxPacerWrite_Disconnect:
+            /* Tell the system that we have been disconnected */
+            InformOfDisconnected();
+        break;
+        case e_TxPacerWrite_Error:
+            /* Like InternalWriteBytes() we don't pop up anything here */
+        case e_TxPacerWrite_Sent:
+        case e_TxPacerWrite_Busy:
+        case e_TxPacerWriteMAX:
+        default:
+        break;
     }
 
-    if(TransmitDelayLine==0 && TransmitDelayByte==0)
-        Delay=0;
-
-    if(Delay>0)
-    {
-        UITimerSetTimeout(TransmitDelayTimer,Delay);
-        UITimerStart(TransmitDelayTimer);
-    }
+    if(!TxPace.IsBusy())
+        TimerWheel_Stop(TransmitDelayTimer);
 }
 
 /*******************************************************************************
@@ -7064,17 +7821,18 @@ void Connection::RethinkCursor(void)
 
 /*******************************************************************************
  * NAME:
- *    Connection::RethinkCursorKeyModeInfoBox
+ *    Connection::RethinkInfoBox
  *
  * SYNOPSIS:
- *    void Connection::RethinkCursorKeyModeInfoBox(void);
+ *    void Connection::RethinkInfoBox(void);
  *
  * PARAMETERS:
  *    NONE
  *
  * FUNCTION:
- *    This function rethinks what should be displayed in the cursor key mode
- *    info box (or hide it).
+ *    This function rethinks what should be displayed in the info box (or
+ *    hide it).  A background copy / save of the selection or a big paste
+ *    shows its progress here, otherwise it shows the cursor key mode.
  *
  * RETURNS:
  *    NONE
@@ -7082,12 +7840,27 @@ void Connection::RethinkCursor(void)
  * SEE ALSO:
  *    
  ******************************************************************************/
-void Connection::RethinkCursorKeyModeInfoBox(void)
+void Connection::RethinkInfoBox(void)
 {
+    char buff[100];
+
     if(Display==NULL)
         return;
 
-    if(GetCurrentCursorKeyModeIsLocal())
+    if(SelExtract.InProgress)
+    {
+        sprintf(buff,"%s %u%%",SelExtract.Dest==e_SelExtractDest_File?
+                "SAVING":"COPYING",SelExtract.LastPercent);
+        Display->SetInfoMessage(buff,0x4080FF,0x000000,
+                e_UITCIM_Pos_BottomRight);
+    }
+    else if(Paste.InProgress)
+    {
+        sprintf(buff,"PASTING %u%%",Paste.LastPercent);
+        Display->SetInfoMessage(buff,0x4080FF,0x000000,
+                e_UITCIM_Pos_BottomRight);
+    }
+    else if(GetCurrentCursorKeyModeIsLocal())
     {
         Display->SetInfoMessage("SCROLL",0xFFA500,0x000000,
                 e_UITCIM_Pos_TopRight);
@@ -7302,11 +8075,11 @@ e_CmdType Connection::HandleSmartClipboard(char key)
         break;
         case 'V':
         case 'v':
-            if(UITimerRunning(SmartClipTimer))
+            if(TimerWheel_Running(SmartClipTimer))
             {
                 /* Timer already running, this means the user pressed ^V
                    2 times and we should send ^V */
-                UITimerStop(SmartClipTimer);
+                TimerWheel_Stop(SmartClipTimer);
 
                 /* We are just sending the control code */
                 return e_CmdMAX;
@@ -7314,8 +8087,9 @@ e_CmdType Connection::HandleSmartClipboard(char key)
             else
             {
                 /* No timer means we need to start one */
-                UITimerSetTimeout(SmartClipTimer,SMART_CLIPBOARD_PASTE_TIME);
-                UITimerStart(SmartClipTimer);
+                TimerWheel_SetTimeout(SmartClipTimer,
+                        SMART_CLIPBOARD_PASTE_TIME);
+                TimerWheel_Start(SmartClipTimer);
 
                 /* Do nothing */
                 return e_Cmd_NOP;
@@ -7349,12 +8123,187 @@ e_CmdType Connection::HandleSmartClipboard(char key)
  ******************************************************************************/
 void Connection::InformOfSmartClipTimeout(void)
 {
-    UITimerStop(SmartClipTimer);
+    TimerWheel_Stop(SmartClipTimer);
 
     /* User didn't press the ^V again so we do a paste */
     MW->ExeCmd(e_Cmd_Paste);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Connection::InformOfSelectionExtractTimeout
+ *
+ * SYNOPSIS:
+ *    void Connection::InformOfSelectionExtractTimeout(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is called using the selection extract timer.  It gets as
+ *    many pieces of the selection as it can in SELEXTRACT_TICK_MS and sends
+ *    them to where they are going, then updates the progress in the info
+ *    box.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+void Connection::InformOfSelectionExtractTimeout(void)
+{
+    uint32_t StartTime;
+    bool Done;
+    uint64_t DoneCount;
+    uint64_t TotalCount;
+    unsigned int Percent;
+    string Msg;
+
+    if(!SelExtract.InProgress || Display==NULL)
+    {
+        CancelSelectionExtract();
+        return;
+    }
+
+    StartTime=GetElapsedTime_ms();
+    Done=false;
+    do
+    {
+        if(!Display->GetSelectionChunk(SelExtract.Chunk,
+                SELEXTRACT_CHUNK_BYTES,Done))
+        {
+            CancelSelectionExtract();
+            UIAsk("Error","The selection scrolled out of the buffer before "
+                    "it could be copied.",e_AskBox_Error,e_AskBttns_Ok);
+            return;
+        }
+
+        if(SelExtract.Dest==e_SelExtractDest_File)
+        {
+            if(!SelExtract.Chunk.empty() &&
+                    fwrite(SelExtract.Chunk.c_str(),SelExtract.Chunk.length(),
+                    1,SelExtract.Out)!=1)
+            {
+                Msg="Failed to write to ";
+                Msg+=SelExtract.Filename;
+                CancelSelectionExtract();
+                UIAsk("Error",Msg,e_AskBox_Error,e_AskBttns_Ok);
+                return;
+            }
+        }
+        else
+        {
+            SelExtract.ClipText.append(SelExtract.Chunk);
+        }
+    } while(!Done && GetElapsedTime_ms()-StartTime<SELEXTRACT_TICK_MS);
+
+    if(Done)
+    {
+        FinishSelectionExtract();
+        return;
+    }
+
+    Display->GetSelectionExtractProgress(&DoneCount,&TotalCount);
+    Percent=0;
+    if(TotalCount>0)
+        Percent=DoneCount*100/TotalCount;
+    if(Percent!=SelExtract.LastPercent)
+    {
+        SelExtract.LastPercent=Percent;
+        RethinkInfoBox();
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::InformOfPasteTimeout
+ *
+ * SYNOPSIS:
+ *    void Connection::InformOfPasteTimeout(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is called using the paste timer.  It sends as many
+ *    chunks of the paste as it can in PASTE_TICK_MS and then updates the
+ *    progress in the info box.
+ *
+ *    If the driver (or the transmit pacer) is full we stop for this tick
+ *    and wait PASTE_BUSY_RETRY_MS before trying again.  If the driver only
+ *    took some of a chunk we count just those and send the rest when we
+ *    try again.  If the write fails
+ *    or is ignored (disconnected, an upload started, etc) the rest of the
+ *    paste is dropped.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartPaste()
+ ******************************************************************************/
+void Connection::InformOfPasteTimeout(void)
+{
+    uint32_t StartTime;
+    std::string::size_type Bytes;
+    unsigned int Percent;
+    int BytesSent;
+    bool Busy;
+
+    if(!Paste.InProgress)
+    {
+        CancelPaste();
+        return;
+    }
+
+    StartTime=GetElapsedTime_ms();
+    Busy=false;
+    do
+    {
+        Bytes=Paste.Text.length()-Paste.Sent;
+        if(Bytes>PASTE_CHUNK_BYTES)
+            Bytes=PASTE_CHUNK_BYTES;
+
+        switch(WriteData((const uint8_t *)Paste.Text.c_str()+Paste.Sent,
+                Bytes,e_ConWriteSource_Paste,&BytesSent))
+        {
+            case e_ConWrite_Success:
+                Paste.Sent+=BytesSent;
+            break;
+            case e_ConWrite_Busy:
+                Paste.Sent+=BytesSent;
+                Busy=true;
+            break;
+            case e_ConWrite_Failed:
+            case e_ConWrite_Ignored:
+            case e_ConWriteMAX:
+            default:
+                CancelPaste();
+            return;
+        }
+    } while(!Busy && Paste.Sent<Paste.Text.length() &&
+            GetElapsedTime_ms()-StartTime<PASTE_TICK_MS);
+
+    if(Paste.Sent>=Paste.Text.length())
+    {
+        CancelPaste();
+        return;
+    }
+
+    /* Back off while the driver is full, otherwise come right back */
+    UITimerStop(Paste.Timer);
+    UITimerSetTimeout(Paste.Timer,Busy?PASTE_BUSY_RETRY_MS:1);
+    UITimerStart(Paste.Timer);
+
+    Percent=(uint64_t)Paste.Sent*100/Paste.Text.length();
+    if(Percent!=Paste.LastPercent)
+    {
+        Paste.LastPercent=Percent;
+        RethinkInfoBox();
+    }
+}
+
 /*******************************************************************************
  * NAME:
  *    Connection::InformOfAutoReopenTimeout
@@ -7414,6 +8363,61 @@ bool Connection::IsConnectionBinary(void)
     return BinaryConnection;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Connection::GetSessionGeneration
+ *
+ * SYNOPSIS:
+ *    uint32_t Connection::GetSessionGeneration(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets a number that changes every time something that
+ *    is stored in the session for this connection changes.  The session
+ *    system uses this to only copy the connections that changed since the
+ *    last time it saved.
+ *
+ * RETURNS:
+ *    The current generation.  No 2 connections will ever have the same
+ *    generation.
+ *
+ * SEE ALSO:
+ *    Connection::NoteSessionStateChanged()
+ ******************************************************************************/
+uint32_t Connection::GetSessionGeneration(void)
+{
+    return SessionGeneration;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Connection::NoteSessionStateChanged
+ *
+ * SYNOPSIS:
+ *    void Connection::NoteSessionStateChanged(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is called when something that is stored in the session
+ *    for this connection changes.  It moves the connection to a new
+ *    generation and tells the session system it needs saving.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Connection::GetSessionGeneration(), NoteSessionChanged()
+ ******************************************************************************/
+void Connection::NoteSessionStateChanged(void)
+{
+    SessionGeneration=m_ConNextSessionGeneration++;
+    NoteSessionChanged();
+}
+
 /*******************************************************************************
  * NAME:
  *    Connection::IsProcessorATextProcessor
@@ -7685,6 +8689,7 @@ void Connection::ToggleAutoReopen(void)
     /* Update the settings */
     UsingCustomSettings=true;
     CustomSettings.AutoReopen=AutoReopenEnabled;
+    NoteSessionStateChanged();
 
     SendReopenChangeEvent();
 }
@@ -8163,6 +9168,36 @@ void Connection::ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,
         Display->ApplyBGColor2Mark(Mark,BGColor,Offset,Len);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Connection::ApplyStyleSpans2Mark
+ *
+ * SYNOPSIS:
+ *    void Connection::ApplyStyleSpans2Mark(t_DataProMark *Mark,
+ *              const struct DPS_StyleSpan *Spans,uint32_t Count);
+ *
+ * PARAMETERS:
+ *    Mark [I] -- The mark to work on
+ *    Spans [I] -- The spans to apply
+ *    Count [I] -- The number of entries in 'Spans'
+ *
+ * FUNCTION:
+ *    This function does the DPS_ApplyStyleSpans2Mark() function to the
+ *    connection.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_ApplyStyleSpans2Mark()
+ ******************************************************************************/
+void Connection::ApplyStyleSpans2Mark(t_DataProMark *Mark,
+        const struct DPS_StyleSpan *Spans,uint32_t Count)
+{
+    if(Display!=NULL)
+        Display->ApplyStyleSpans2Mark(Mark,Spans,Count);
+}
+
 /*******************************************************************************
  * NAME:
  *    Connection::MoveMark
@@ -8384,6 +9419,7 @@ const uint8_t *Connection::GetFrozenString(uint32_t *Size)
             case e_ConFrozenQueueEntry_SetBGColor:
             case e_ConFrozenQueueEntry_SetULineColor:
             case e_ConFrozenQueueEntry_SetAttribs:
+            case e_ConFrozenQueueEntry_SetStyle:
             case e_ConFrozenQueueEntry_DoFunction:
             case e_ConFrozenQueueEntry_InsertString:
             case e_ConFrozenQueueEntry_DoBell:
@@ -8608,6 +9644,48 @@ bool Connection::FrozenQueueIfNeeded_SetAttrib(uint32_t NewAttrib)
     return true;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Connection::FrozenQueueIfNeeded_SetStyle
+ *
+ * SYNOPSIS:
+ *    bool Connection::FrozenQueueIfNeeded_SetStyle(const struct CharStyling
+ *          *NewStyle);
+ *
+ * PARAMETERS:
+ *    NewStyle [I] -- The new style for this
+ *
+ * FUNCTION:
+ *    This is a helper function.  It handles if the stream is frozen for
+ *    the SetStyle() function.  It the stream is frozen then it
+ *    queues this data for play back later.
+ *
+ * RETURNS:
+ *    true -- The data was queued and the caller should do nothing else.
+ *    false -- The stream isn't frozen and the caller should do it's normal
+ *             function.
+ *
+ * SEE ALSO:
+ *    
+ ******************************************************************************/
+bool Connection::FrozenQueueIfNeeded_SetStyle(const struct CharStyling *NewStyle)
+{
+    struct Connection_FrozenQueueEntry Entry;
+
+    if(SupressFrozen)
+        return false;
+
+    if(!InputFrozen || !DoingIncomingByteProcessing)
+        return false;
+
+    Entry.Type=e_ConFrozenQueueEntry_SetStyle;
+    Entry.Style=*NewStyle;
+
+    Add2FrozenQueue(&Entry);
+
+    return true;
+}
+
 /*******************************************************************************
  * NAME:
  *    Connection::FrozenQueueIfNeeded_Function
@@ -8683,6 +9761,8 @@ bool Connection::FrozenQueueIfNeeded_Function(e_ConFuncType Func,
         case e_ConFunc_SendBackspace:
         case e_ConFunc_SendEnter:
         case e_ConFunc_ScrollArea:
+        case e_ConFunc_SetScrollRegion:
+        case e_ConFunc_SetAltScreen:
         break;
         case e_ConFunc_NoteNonPrintable:
             Len=strlen((char *)Arg1)+1;
@@ -8876,6 +9956,7 @@ void Connection::FreeFrozenQueue(void)
             case e_ConFrozenQueueEntry_SetBGColor:
             case e_ConFrozenQueueEntry_SetULineColor:
             case e_ConFrozenQueueEntry_SetAttribs:
+            case e_ConFrozenQueueEntry_SetStyle:
             case e_ConFrozenQueueEntry_DoBell:
             break;
             case e_ConFrozenQueueEntry_DoFunction:
@@ -8938,6 +10019,9 @@ void Connection::PlayBackFrozenQueue(void)
             case e_ConFrozenQueueEntry_SetAttribs:
                 SetAttribs(Cur->Attribs);
             break;
+            case e_ConFrozenQueueEntry_SetStyle:
+                SetStyle(&Cur->Style);
+            break;
             case e_ConFrozenQueueEntry_DoFunction:
                 switch(Cur->Fn.Func)
                 {
@@ -8953,6 +10037,8 @@ void Connection::PlayBackFrozenQueue(void)
                     case e_ConFunc_SendBackspace:
                     case e_ConFunc_SendEnter:
                     case e_ConFunc_ScrollArea:
+                    case e_ConFunc_SetScrollRegion:
+                    case e_ConFunc_SetAltScreen:
                         DoFunction(Cur->Fn.Func,Cur->Fn.Arg1,Cur->Fn.Arg2,
                                 Cur->Fn.Arg3,Cur->Fn.Arg4,Cur->Fn.Arg5,
                                 Cur->Fn.Arg6);
@@ -9317,6 +10403,7 @@ void Connection::SetDirectSendLineHistory(t_StringList &TextLineHistory)
     {
         Display->SetTextLineHistory(TextLineHistory);
     }
+    NoteSessionStateChanged();
 }
 
 /*******************************************************************************
@@ -9370,6 +10457,7 @@ void Connection::SetDirectPanelLineEnd(e_DirectSendPanel_LineEndType LineEnd)
 {
     if(Display!=NULL)
         Display->SetLineEndings(LineEnd);
+    NoteSessionStateChanged();
 }
 
 /*******************************************************************************
@@ -9424,6 +10512,7 @@ void Connection::SetDirectPanelInHexMode(bool HexMode)
 {
     if(Display!=NULL)
         Display->SetBlockSendInHexMode(HexMode);
+    NoteSessionStateChanged();
 }
 
 /*******************************************************************************
@@ -39,7 +39,11 @@
 #include "App/MaxSizes.h"
 #include "App/ScriptingSystem.h"
 #include "App/Settings.h"
+#include "App/TimerWheel.h"
+#include "App/Util/CaptureFile.h"
+#include "App/Util/ComTestFrames.h"
 #include "App/Util/StandardTypes.h"
+#include "App/Util/TxPacer.h"
 #include "UI/UIClipboard.h"
 #include "UI/UITimers.h"
 #include "UI/UIMainWindow.h"
@@ -50,7 +54,6 @@
 #include <list>
 
 /***  DEFINES                          ***/
-#define CAPTURE_HEXDUMP_VALUES_PER_LINE         16
 
 /***  MACROS                           ***/
 
@@ -70,6 +73,8 @@ typedef enum
     e_ConFunc_SendBackspace,
     e_ConFunc_SendEnter,
     e_ConFunc_ScrollArea,
+    e_ConFunc_SetScrollRegion,
+    e_ConFunc_SetAltScreen,
     e_ConFuncMAX
 } e_ConFuncType;
 
@@ -110,24 +115,13 @@ typedef enum
     e_ConViewChangeMAX
 } e_ConViewChangeType;
 
-struct CaptureToFileOptions
-{
-    bool Timestamp;
-    bool Append;
-    bool StripCtrl;
-    bool StripEsc;
-    bool SaveAsHexDump;
-};
-
 struct CaptureToFileType
 {
     std::string Filename;
-    FILE *WriteHandle;
+    FILE *WriteHandle;                  // Text captures
+    class CaptureFileWriter *Binary;    // Binary (CAPTUREFILE_EXTENSION) captures
     struct CaptureToFileOptions Options;
-    bool EscSeqSkiping;
-    uint8_t HexDumpBuff[CAPTURE_HEXDUMP_VALUES_PER_LINE+1];
-    int HexDumpInsertPos;
-    int HexDumpOffset;
+    class CaptureTextFormatter TextFormatter;
 };
 
 typedef std::list<uint64_t> t_StopWatchLapTimes;
@@ -158,7 +152,6 @@ struct UploadType
     std::string Filename;
     std::string ProtocolID;
     t_KVList UploadOptions;
-    uint64_t LastTimeoutTick;
     uint32_t Timeout;
     bool TimerActive;
     struct UploadStats Stats;
@@ -177,7 +170,6 @@ struct DownloadType
     bool FilenameSet;
     std::string ProtocolID;
     t_KVList DownloadOptions;
-    uint64_t LastTimeoutTick;
     uint32_t Timeout;
     bool TimerActive;
     struct DownloadStats Stats;
@@ -205,29 +197,61 @@ struct ComTestStats
     bool InProgress;
     uint64_t PacketsSent;
     uint64_t BytesSent;
-    uint64_t PacketsRx;
-    uint64_t ErrorsDetected;
-    uint64_t BytesPerSec;               // TBD (and readded to UI)
+    uint64_t ErrorsDetected;            // Any rx error (bytes, lost, bad frames)
+    uint64_t BytesPerSec;               // Rx throughput over the last second
     uint64_t SendErrors;
     uint64_t SendBusyErrors;
     time_t LastRxTimeStamp;
+    struct ComTestRxCounters Rx;
 };
 
 struct ComTestType
 {
     bool Sender;            // Is this a source of packets?
-    bool SendingPackets;
+    volatile bool SendingPackets;
+    volatile bool RequestThreadQuit;
     uint32_t PacketLen;
     uint32_t PacketsCount;
     uint32_t DelayBetweenPackets_mS;
     uint8_t *Packet;
-    uint32_t RxPatternIndex;
-    bool Syncing;
+    class ComTestFramer Framer;
+    class ComTestChecker Checker;
+    struct ThreadHandle *SendThread;
+    struct ThreadMutex *StatsMutex;     // Protects the tx side of 'Stats'
+    uint64_t RateStart_ns;
+    uint64_t RateBytes;
     void (*UpdateFn)(class Connection *);
-    struct UITimer *Timer;
     struct ComTestStats Stats;
 };
 
+typedef enum
+{
+    e_SelExtractDest_Clipboard,
+    e_SelExtractDest_File,
+    e_SelExtractDestMAX
+} e_SelExtractDestType;
+
+struct SelectionExtractType
+{
+    bool InProgress;
+    e_SelExtractDestType Dest;
+    std::string Filename;               // e_SelExtractDest_File
+    FILE *Out;                          // e_SelExtractDest_File
+    std::string ClipText;               // e_SelExtractDest_Clipboard
+    std::string Chunk;                  // The last piece we got (kept to save allocs)
+    unsigned int LastPercent;           // What we last showed in the info box
+    struct UITimer *Timer;
+};
+
+struct PasteType
+{
+    bool InProgress;
+    std::string Text;                   // What we are pasting
+    std::string::size_type Sent;        // How much of 'Text' has gone out
+    unsigned int LastPercent;           // What we last showed in the info box
+    struct UITimer *Timer;
+};
+
 typedef std::list<class Connection *> t_ConnectionList;
 typedef t_ConnectionList::iterator i_ConnectionList;
 
@@ -252,6 +276,7 @@ typedef enum
     ConMWEvent_AutoReopenChanged,
     ConMWEvent_OutGoingHexDisplayUpdate,
     ConMWEvent_OutGoingHexDisplayBufferChange,
+    ConMWEvent_PasteStateChanged,
     ConMWEventMAX
 } ConMWEventType;
 
@@ -307,6 +332,7 @@ typedef enum
     e_ConFrozenQueueEntry_SetBGColor,
     e_ConFrozenQueueEntry_SetULineColor,
     e_ConFrozenQueueEntry_SetAttribs,
+    e_ConFrozenQueueEntry_SetStyle,
     e_ConFrozenQueueEntry_DoFunction,
     e_ConFrozenQueueEntry_InsertString,
     e_ConFrozenQueueEntry_DoBell,
@@ -339,6 +365,7 @@ struct Connection_FrozenQueueEntry
         uint8_t *Str;
         uint32_t Color;
         uint32_t Attribs;
+        struct CharStyling Style;
         bool VisualOnly;
         struct Connection_FrozenQueueFn Fn;
         struct Connection_FrozenQueueInsertStr InsertStr;
@@ -352,8 +379,13 @@ class Connection
     friend void Con_DelayTransmitTimeout(uintptr_t UserData);
     friend void Con_SmartClipTimeout(uintptr_t UserData);
     friend void Con_AutoReopenTimeout(uintptr_t UserData);
-    friend void Con_ComTestTimeout(uintptr_t UserData);
-    friend void Con_FileTransTick(void);
+    friend void Con_SelectionExtractTimeout(uintptr_t UserData);
+    friend void Con_PasteTimeout(uintptr_t UserData);
+    friend void Con_FileTransTimeout(uintptr_t UserData);
+    friend void Con_ZModemAutoStartTimeout(uintptr_t UserData);
+    friend void Con_ComTestSendThread(void *Arg);
+    friend e_TxPacerWriteType Con_TxPaceWrite(uintptr_t UserData,
+            const uint8_t *Data,uint32_t Bytes,uint32_t *Written);
     friend bool Con_DisplayBufferEvent(const struct DBEvent *Event);
 
     public:
@@ -374,9 +406,10 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         void GetDisplayName(std::string &Name);
         void TextCanvasResize(int Width,int Height);
         bool KeyPress(uint8_t Mods,e_UIKeys Key,const uint8_t *TextPtr,unsigned int TextLen);
-        e_ConWriteType WriteData(const uint8_t *Data,int Bytes,e_ConWriteSourceType Source);
+        e_ConWriteType WriteData(const uint8_t *Data,int Bytes,e_ConWriteSourceType Source,int *BytesSent=NULL);
         void TransmitQueuedData(void);
         void WriteChar2Display(uint8_t *Chr);
+        void WriteChars2Display(const uint8_t *Chrs,int Count);
         void HandleMiddleMousePress(int x,int y);
         void GetConnectionUniqueID(std::string &UniqueID);
         void GetCaptureOptions(struct CaptureToFileOptions &Options);
@@ -446,6 +479,8 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         uint32_t GetULineColor(void);
         void SetAttribs(uint32_t Attribs);
         uint32_t GetAttribs(void);
+        void SetStyle(const struct CharStyling *Style);
+        void GetStyle(struct CharStyling *RetStyle);
         void DoFunction(e_ConFuncType Fn,uintptr_t Arg1,uintptr_t Arg2,
                 uintptr_t Arg3,uintptr_t Arg4,uintptr_t Arg5,uintptr_t Arg6);
         void GetCursorXY(int *RetCursorX,int *RetCursorY);
@@ -459,12 +494,17 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
 
         void GiveFocus(void);
         void CopySelectionToClipboard(void);
+        bool SaveSelectionToFile(const char *Filename);
+        void CancelSelectionExtract(void);
         uint8_t *GetRawSelection(unsigned int *Bytes);
         void PasteFromClipboard(void);
+        void CancelPaste(void);
+        bool IsPasteInProgress(void);
         void FindCRCFromSelection(void);
         void CalcCRCFromSelection(void);
         void GotoColumn(int Column);
         void GotoRow(int Row);
+        bool FindBytes(const struct ByteSearchPattern *Pattern);
         bool GetURI(std::string &URI);
         void SetLeftPanelInfo(e_LeftPanelTabType SelectedTab);
         e_LeftPanelTabType GetLeftPanelInfo(void);
@@ -488,6 +528,7 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         void RemoveAttribFromMark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Offset,uint32_t Len);
         void ApplyFGColor2Mark(t_DataProMark *Mark,uint32_t FGColor,uint32_t Offset,uint32_t Len);
         void ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,uint32_t Offset,uint32_t Len);
+        void ApplyStyleSpans2Mark(t_DataProMark *Mark,const struct DPS_StyleSpan *Spans,uint32_t Count);
         void MoveMark(t_DataProMark *Mark,int Amount);
         const uint8_t *GetMarkString(t_DataProMark *Mark,uint32_t *Size,uint32_t Offset,uint32_t Len);
 
@@ -507,8 +548,7 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         bool StartComTest(void);
         void StopComTest(void);
         bool IsComTestRunning(void);
-        void ComTestFastTick(void);
-        const struct ComTestStats *GetComTestStats(void);
+        void GetComTestStats(struct ComTestStats *RetStats);
         void RegisterComTestUpdateFn(void (*Update)(class Connection *));
 
         /* Custom settings */
@@ -529,6 +569,7 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         /* Connection info */
         bool ConnectionBusy(void);
         bool IsConnectionBinary(void);
+        uint32_t GetSessionGeneration(void);
         t_UIContextMenuCtrl *GetContextMenuHandle(e_UITD_ContextMenuType UIObj);
         t_UIContextSubMenuCtrl *GetContextSubMenuHandle(e_UITD_ContextSubMenuType UIObj);
 
@@ -581,6 +622,7 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         class DisplayBase *Display;
         class TheMainWindow *MW;
         struct ProcessorConData ProcessorData;
+        struct PerfStatsCon *PerfStats;
         t_FTPData *FTPConData;
         bool IsConnected;
         char DisplayName[MAX_CONNECTION_NAME_LEN+1];   // The name of this connection
@@ -591,11 +633,16 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         struct HexDisplayType HexDisplay;
         struct HexDisplayType OutGoingHexDisplay;
         struct ComTestType ComTest;
+        struct SelectionExtractType SelExtract;
+        struct PasteType Paste;
         e_LeftPanelTabType LeftPanelInfo;
         e_RightPanelTabType RightPanelInfo;
         e_BottomPanelTabType BottomPanelInfo;
-        struct UITimer *SmartClipTimer;
-        struct UITimer *AutoReopenTimer;
+        struct TimerWheelTimer *SmartClipTimer;
+        struct TimerWheelTimer *AutoReopenTimer;
+        struct TimerWheelTimer *FileTransTimer; // The FTP timeout (restarted on every block)
+        struct UITimer *ZModemAutoStartTimer;
+        unsigned int ZModemAutoMatch;       // How much of the ZRQINIT we have seen
         bool BlockSendDevice;
         bool WhenBridgedLockoutConnection;
         bool ConnectionLockedOut;
@@ -608,6 +655,7 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         int FontSize;
         bool BinaryConnection;
         uint64_t LastBellPlayed;
+        uint32_t SessionGeneration; // Changes every time something the session saves changes
         bool AutoReopenEnabled; // Is the setting for auto reopen enabled (copied from settings so it can be toggled on/off by the user without changing setting)
 
         /* Send delays */
@@ -615,11 +663,8 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         unsigned int TransmitDelayLine;
         unsigned int LastSettingsTransmitDelayByte;
         unsigned int LastSettingsTransmitDelayLine;
-        uint8_t *TransmitDelayBuffer;
-        unsigned int TransmitDelayBufferSize;
-        unsigned int TransmitDelayBufferWritePos;
-        unsigned int TransmitDelayBufferReadPos;
-        struct UITimer *TransmitDelayTimer;
+        class TxPacer TxPace;
+        struct TimerWheelTimer *TransmitDelayTimer; // Picks up what 'TxPace' sent
 
         /* Frozen */
         bool InputFrozen;
@@ -637,23 +682,34 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         void ConstructorFree(void);
         void FreeConnectionResources(bool FreeDB);
         void HandleCaptureIncomingData(const uint8_t *Inbuff,int bytes);
+        void HandleCaptureOutGoingData(const uint8_t *Outbuff,int bytes);
         void SendMWEvent(ConMWEventType Event,union ConMWInfo *ExtraInfo=NULL);
         void StopWatchHandleAutoLap(void);
         void HandleHexDisplayIncomingData(const uint8_t *inbuff,int Bytes);
+        void ZModemAutoDetect(const uint8_t *inbuff,int Bytes);
         void HandleHexDisplayOutGoingData(const uint8_t *inbuff,int Bytes);
         void HandleComTestRx(uint8_t *inbuff,int bytes);
-        bool QueueTransmitDelayData(const uint8_t *Data,int Bytes);
+        void ComTestSendThread(void);
+        void ResetComTestStats(void);
         void ApplyTransmitDelayChange(void);
-        e_ConWriteType InternalWriteBytes(const uint8_t *Data,int Bytes);
-        void FreeTransmitDelayBuffer(void);
+        e_ConWriteType InternalWriteBytes(const uint8_t *Data,int Bytes,int *BytesSent);
+        void NoteBytesWritten(const uint8_t *Data,int Bytes);
+        e_TxPacerWriteType TxPaceWrite(const uint8_t *Data,uint32_t Bytes,
+                uint32_t *Written);
+        void StopTxPace(void);
         void RethinkLockOut(void);
         void RethinkCursor(void);
-        void RethinkCursorKeyModeInfoBox(void);
+        void RethinkInfoBox(void);
+        bool StartSelectionExtract(e_SelExtractDestType Dest);
+        void StartPaste(std::string &Text);
+        void FinishSelectionExtract(void);
+        void ClearSelectionIfSmartClipboard(void);
         void HandleMouseWheelZoom(int Steps);
         e_CmdType HandleSmartClipboard(char key);
         bool IsProcessorATextProcessor(struct ProcessorConData &PData);
         void SendReopenChangeEvent(void);
         void HandleFailed2OpenErrorMessage(void);
+        void NoteSessionStateChanged(void);
 
         /* Frozen */
         bool FrozenQueueIfNeeded_Write(uint8_t *Str);
@@ -661,6 +717,7 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
         bool FrozenQueueIfNeeded_SetBGColor(uint32_t NewColor);
         bool FrozenQueueIfNeeded_SetULineColor(uint32_t NewColor);
         bool FrozenQueueIfNeeded_SetAttrib(uint32_t NewAttrib);
+        bool FrozenQueueIfNeeded_SetStyle(const struct CharStyling *NewStyle);
         bool FrozenQueueIfNeeded_Function(e_ConFuncType Func,uintptr_t Arg1,uintptr_t Arg2,uintptr_t Arg3,uintptr_t Arg4,uintptr_t Arg5,uintptr_t Arg6);
         bool FrozenQueueIfNeeded_InsertStr(const uint8_t *Str,uint32_t Len);
         bool FrozenQueueIfNeeded_Bell(bool VisualOnly);
@@ -674,10 +731,12 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
 
         /* Call backs */
         void InformOfDelayTransmitTimeout(void);
-        void InformOfComTestTimeout(void);
         void InformOfSmartClipTimeout(void);
         void InformOfAutoReopenTimeout(void);
+        void InformOfSelectionExtractTimeout(void);
+        void InformOfPasteTimeout(void);
         void FileTransTick(void);
+        void InformOfZModemAutoStartTimeout(void);
         bool ProcessDisplayEvent(const struct DBEvent *Event);
 };
 
@@ -687,7 +746,6 @@ void Debug1(void);void Debug2(void);void Debug3(void);void Debug4(void);void Deb
 class Connection *Con_AllocateConnection(const char *URI);
 void Con_FreeConnection(class Connection *Con);
 bool Con_TextCavnasEvent(const struct TCEvent *Event);
-void Con_FileTransTick(void);
 void Con_ApplySettings2AllConnections(void);
 void Con_GetListOfConnections(t_ConnectionList &List);
 
@@ -135,6 +135,36 @@ void Con_WriteChar2Display(uint8_t *Chr)
     m_ActiveConnection->WriteChar2Display(Chr);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Con_WriteChars2Display
+ *
+ * SYNOPSIS:
+ *    void Con_WriteChars2Display(const uint8_t *Chrs,int Count);
+ *
+ * PARAMETERS:
+ *    Chrs [I] -- The chars to write.  Each byte is one char.
+ *    Count [I] -- The number of chars in 'Chrs'
+ *
+ * FUNCTION:
+ *    This function writes a run of single byte chars to the display buffer
+ *    for the active connection.  This is the same as calling
+ *    Connection::WriteChars2Display()
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Con_WriteChar2Display()
+ ******************************************************************************/
+void Con_WriteChars2Display(const uint8_t *Chrs,int Count)
+{
+    if(m_ActiveConnection==NULL)
+        return;
+
+    m_ActiveConnection->WriteChars2Display(Chrs,Count);
+}
+
 /*******************************************************************************
  * NAME:
  *    Con_InformOfConnected
@@ -515,6 +545,68 @@ uint16_t Con_GetAttribs(void)
     return m_ActiveConnection->GetAttribs();
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Con_SetStyle
+ *
+ * SYNOPSIS:
+ *    void Con_SetStyle(const struct CharStyling *Style);
+ *
+ * PARAMETERS:
+ *    Style [I] -- The colors and attribs to apply
+ *
+ * FUNCTION:
+ *    This function sets the forground, background and underline colors and
+ *    the attribs on the active connection in one call.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Con_GetStyle(), Con_SetFGColor(), Con_SetAttribs()
+ ******************************************************************************/
+void Con_SetStyle(const struct CharStyling *Style)
+{
+    if(m_ActiveConnection==NULL)
+        return;
+
+    m_ActiveConnection->SetStyle(Style);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Con_GetStyle
+ *
+ * SYNOPSIS:
+ *    void Con_GetStyle(struct CharStyling *RetStyle);
+ *
+ * PARAMETERS:
+ *    RetStyle [O] -- The currently applied colors and attribs
+ *
+ * FUNCTION:
+ *    This function gets the forground, background and underline colors and
+ *    the attribs from the active connection in one call.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Con_SetStyle()
+ ******************************************************************************/
+void Con_GetStyle(struct CharStyling *RetStyle)
+{
+    if(m_ActiveConnection==NULL)
+    {
+        RetStyle->FGColor=0;
+        RetStyle->BGColor=0;
+        RetStyle->ULineColor=0;
+        RetStyle->Attribs=0;
+        return;
+    }
+
+    m_ActiveConnection->GetStyle(RetStyle);
+}
+
 /*******************************************************************************
  * NAME:
  *    Con_DoFunction
@@ -946,6 +1038,38 @@ void Con_ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,uint32_t Offset,
     m_ActiveConnection->ApplyBGColor2Mark(Mark,BGColor,Offset,Len);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Con_ApplyStyleSpans2Mark
+ *
+ * SYNOPSIS:
+ *    void Con_ApplyStyleSpans2Mark(t_DataProMark *Mark,
+ *              const struct DPS_StyleSpan *Spans,uint32_t Count);
+ *
+ * PARAMETERS:
+ *    Mark [I] -- The mark to work on
+ *    Spans [I] -- The spans to apply
+ *    Count [I] -- The number of entries in 'Spans'
+ *
+ * FUNCTION:
+ *    This function does the DPS_ApplyStyleSpans2Mark() function to the active
+ *    connection.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_ApplyStyleSpans2Mark()
+ ******************************************************************************/
+void Con_ApplyStyleSpans2Mark(t_DataProMark *Mark,
+        const struct DPS_StyleSpan *Spans,uint32_t Count)
+{
+    if(m_ActiveConnection==NULL)
+        return;
+
+    m_ActiveConnection->ApplyStyleSpans2Mark(Mark,Spans,Count);
+}
+
 /*******************************************************************************
  * NAME:
  *    Con_MoveMark
@@ -53,6 +53,7 @@ void Con_InformOfConnected(uintptr_t ID);
 void Con_InformOfDisconnected(uintptr_t ID);
 bool Con_InformOfDataAvaiable(uintptr_t ID);
 void Con_WriteChar2Display(uint8_t *Chr);
+void Con_WriteChars2Display(const uint8_t *Chrs,int Count);
 void Con_SetFGColor(uint32_t FGColor);
 uint32_t Con_GetFGColor(void);
 void Con_SetBGColor(uint32_t BGColor);
@@ -61,6 +62,8 @@ void Con_SetULineColor(uint32_t ULineColor);
 uint32_t Con_GetULineColor(void);
 void Con_SetAttribs(uint16_t Attribs);
 uint16_t Con_GetAttribs(void);
+void Con_SetStyle(const struct CharStyling *Style);
+void Con_GetStyle(struct CharStyling *RetStyle);
 void Con_DoFunction(e_ConFuncType Fn,uintptr_t Arg1=0,uintptr_t Arg2=0,
         uintptr_t Arg3=0,uintptr_t Arg4=0,uintptr_t Arg5=0,uintptr_t Arg6=0);
 void Con_GetCursorXY(int32_t *RetCursorX,int32_t *RetCursorY);
@@ -78,6 +81,7 @@ void Con_ApplyAttrib2Mark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Offset,ui
 void Con_RemoveAttribFromMark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Offset,uint32_t Len);
 void Con_ApplyFGColor2Mark(t_DataProMark *Mark,uint32_t FGColor,uint32_t Offset,uint32_t Len);
 void Con_ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,uint32_t Offset,uint32_t Len);
+void Con_ApplyStyleSpans2Mark(t_DataProMark *Mark,const struct DPS_StyleSpan *Spans,uint32_t Count);
 void Con_MoveMark(t_DataProMark *Mark,int Amount);
 const uint8_t *Con_GetMarkString(t_DataProMark *Mark,uint32_t *Size,uint32_t Offset,uint32_t Len);
 void Con_FreezeStream(void);
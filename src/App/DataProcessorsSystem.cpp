@@ -64,6 +64,7 @@ Example plugins:
 #include "App/Connections.h"
 #include "App/ConnectionsGlobal.h"
 #include "App/DataProcessorsSystem.h"
+#include "App/PerfStats.h"
 #include "App/Settings.h"
 #include "App/PluginSupport/PluginUISupport.h"
 #include "App/PluginSupport/KeyValueSupport.h"
@@ -118,9 +119,14 @@ void DPS_BinaryAddHex(uint8_t Byte);
 void DPS_DoSystemBell(int VisualOnly);
 void DPS_DoScrollArea(uint32_t X1,uint32_t Y1,uint32_t X2,uint32_t Y2,
         int32_t DeltaX,int32_t DeltaY);
+static void DPS_DoSetScrollRegion(uint32_t Top,uint32_t Bottom);
+static void DPS_DoSetAltScreen(PG_BOOL On);
+static void DPS_SetStyle(const struct StyleData *SD);
+static void DPS_GetStyle(struct StyleData *SD);
 static struct PluginSettings *DPS_FindPluginSetting(const char *IDStr,
         class ConSettings *Settings);
 void DPS_DoProcessIncomingTextByteCallbacks(struct ProcessorConData *FData,e_TextDataProcessorClassType CallClass,uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,PG_BOOL *Consumed);
+static int DPS_DoIncomingTextRun(struct ProcessorConData *FData,const uint8_t *Run,int Bytes,bool DoAutoLF,bool DoAutoCR);
 
 static t_DataProMark *DPS_AllocateMark(void);
 static void DPS_FreeMark(t_DataProMark *Mark);
@@ -130,6 +136,7 @@ static void DPS_ApplyAttrib2Mark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Of
 static void DPS_RemoveAttribFromMark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Offset,uint32_t Len);
 static void DPS_ApplyFGColor2Mark(t_DataProMark *Mark,uint32_t FGColor,uint32_t Offset,uint32_t Len);
 static void DPS_ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,uint32_t Offset,uint32_t Len);
+static void DPS_ApplyStyleSpans2Mark(t_DataProMark *Mark,const struct DPS_StyleSpan *Spans,uint32_t Count);
 static void DPS_MoveMark(t_DataProMark *Mark,int Amount);
 static const uint8_t *DPS_GetMarkString(t_DataProMark *Mark,uint32_t *Size,uint32_t Offset,uint32_t Len);
 static void DPS_FreezeStream(void);
@@ -140,6 +147,19 @@ static const uint8_t *DPS_GetFrozenString(uint32_t *Size);
 /*** VARIABLE DEFINITIONS     ***/
 static struct DataProcessor *m_ActiveDataProcessor;
 
+/* The order text processors are asked if they can pass a run of bytes.  This
+   is the reverse of the order they are called in, so the term emulator
+   (normally the one that says no) is asked before the char decoder has
+   scanned the whole block */
+static const e_TextDataProcessorClassType m_TextRunScanOrder[]=
+{
+    e_TextDataProcessorClass_Other,
+    e_TextDataProcessorClass_Highlighter,
+    e_TextDataProcessorClass_TermEmulation,
+    e_TextDataProcessorClass_CharEncoding,
+    e_TextDataProcessorClass_Logger,
+};
+
 struct DPS_API g_DPSAPI=
 {
     DPS_RegisterDataProcessor,
@@ -192,6 +212,14 @@ struct DPS_API g_DPSAPI=
     DPS_ClearFrozenStream,
     DPS_ReleaseFrozenStream,
     DPS_GetFrozenString,
+    /* V3 */
+    DPS_ApplyStyleSpans2Mark,
+    /* V4 */
+    DPS_DoSetScrollRegion,
+    DPS_DoSetAltScreen,
+    /* V5 */
+    DPS_SetStyle,
+    DPS_GetStyle,
 };
 t_DPSDataProcessorsType m_DataProcessors;     // All available data processors
 
@@ -552,6 +580,91 @@ void DPS_Init(void)
  * SEE ALSO:
  *    
  *==============================================================================
+ * NAME:
+ *    ProcessIncomingTextBlockDone
+ *
+ * SYNOPSIS:
+ *    void ProcessIncomingTextBlockDone(t_DataProcessorHandleType *DataHandle);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to work on.  This is your internal
+ *                      data.
+ *
+ * FUNCTION:
+ *    This function is called after all the bytes in a block of incoming
+ *    data have been passed though ProcessIncomingTextByte() (and added to
+ *    the screen).  Highlighters can use this to collect what they found
+ *    while the bytes came in and apply it to the screen once per block
+ *    (with ApplyStyleSpans2Mark()) instead of once per byte.
+ *
+ *    This is only called for text processors that also have a
+ *    ProcessIncomingTextByte().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ProcessIncomingTextByte(), ApplyStyleSpans2Mark()
+ *==============================================================================
+ * NAME:
+ *    ScanIncomingTextRun
+ *
+ * SYNOPSIS:
+ *    int ScanIncomingTextRun(t_DataProcessorHandleType *DataHandle,
+ *              const uint8_t *Run,int Bytes);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to work on.  This is your internal
+ *                      data.
+ *    Run [I] -- The incoming bytes that have not been processed yet
+ *    Bytes [I] -- The number of bytes in 'Run'
+ *
+ * FUNCTION:
+ *    This function is asked how many of the bytes at the start of 'Run'
+ *    this processor would pass though untouched in it's current state.
+ *    That is each byte would be it's own char, not consumed, not changed,
+ *    and nothing else would happen (no cursor moves, colors, etc).
+ *
+ *    This must not change anything.  If every text processor on the
+ *    connection says yes to some bytes then the system calls
+ *    ProcessIncomingTextRun() with the shortest run any of them returned
+ *    and adds the whole run to the screen in one go instead of calling
+ *    ProcessIncomingTextByte() for each byte.
+ *
+ *    This is only used if ProcessIncomingTextRun() is also set.
+ *
+ * RETURNS:
+ *    The number of bytes that can be passed though (0 for none).
+ *
+ * SEE ALSO:
+ *    ProcessIncomingTextRun(), ProcessIncomingTextByte()
+ *==============================================================================
+ * NAME:
+ *    ProcessIncomingTextRun
+ *
+ * SYNOPSIS:
+ *    void ProcessIncomingTextRun(t_DataProcessorHandleType *DataHandle,
+ *              const uint8_t *Run,int Bytes);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to work on.  This is your internal
+ *                      data.
+ *    Run [I] -- The bytes being passed though
+ *    Bytes [I] -- The number of bytes in 'Run'.  This will never be more
+ *                 than ScanIncomingTextRun() returned for this data.
+ *
+ * FUNCTION:
+ *    This function is called instead of ProcessIncomingTextByte() for a run
+ *    of bytes that ScanIncomingTextRun() said could be passed though.  It
+ *    should update your internal data as if each byte had gone though
+ *    ProcessIncomingTextByte().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ScanIncomingTextRun()
+ *==============================================================================
  *
  * SEE ALSO:
  *    
@@ -646,8 +759,13 @@ bool DPS_AllocProcessorConData(struct ProcessorConData *FData,
     struct PluginSettings *PlugSettings;
     t_KVList BlankKVList;
     t_KVList *SettingsKVList;
+    struct DPSTextByteCallback NewCallback;
+    i_DPSTextByteCallbacksType CurCallback;
+    unsigned int Index;
 
     FData->Settings=CustomSettings;
+    FData->PerfSampling=false;
+    FData->TextRunsAllowed=false;
 
     /* Copy the data processors list (based on settings) for this connection */
     if(CustomSettings->DataProcessorType==e_DataProcessorType_Text)
@@ -740,6 +858,53 @@ bool DPS_AllocProcessorConData(struct ProcessorConData *FData,
         NotePluginInUse(CurProcessor->ProID.c_str());
     }
 
+    /* Sort the text processors by class so we don't have to walk the
+       whole list for each class for every byte */
+    if(CustomSettings->DataProcessorType==e_DataProcessorType_Text)
+    {
+        for(CurProcessor=FData->DataProcessorsList.begin(),Index=0;
+                CurProcessor!=FData->DataProcessorsList.end();
+                CurProcessor++,Index++)
+        {
+            if(CurProcessor->API.ProcessIncomingTextByte==NULL ||
+                    CurProcessor->Info.TxtClass>=e_TextDataProcessorClassMAX)
+            {
+                continue;
+            }
+
+            NewCallback.Processor=&*CurProcessor;
+            NewCallback.Index=Index;
+            FData->TextByteCallbacks[CurProcessor->Info.TxtClass].
+                    push_back(NewCallback);
+
+            if(CurProcessor->API.ProcessIncomingTextBlockDone!=NULL)
+                FData->TextBlockDoneCallbacks.push_back(NewCallback);
+        }
+
+        /* If every text processor can pass runs of bytes though then we
+           can skip calling them for each byte of plain text */
+        FData->TextRunsAllowed=true;
+        for(Index=0;Index<sizeof(m_TextRunScanOrder)/
+                sizeof(m_TextRunScanOrder[0]);Index++)
+        {
+            t_DPSTextByteCallbacksType &Callbacks=
+                    FData->TextByteCallbacks[m_TextRunScanOrder[Index]];
+            for(CurCallback=Callbacks.begin();CurCallback!=Callbacks.end();
+                    CurCallback++)
+            {
+                if(CurCallback->Processor->API.ScanIncomingTextRun==NULL ||
+                        CurCallback->Processor->API.ProcessIncomingTextRun==
+                        NULL)
+                {
+                    FData->TextRunsAllowed=false;
+                }
+                FData->TextRunCallbacks.push_back(*CurCallback);
+            }
+        }
+        if(!FData->TextRunsAllowed)
+            FData->TextRunCallbacks.clear();
+    }
+
     return true;
 }
 
@@ -782,6 +947,11 @@ void DPS_FreeProcessorConData(struct ProcessorConData *FData)
 
     FData->DataProcessorsList.clear();
     FData->ProcessorsData.clear();
+    for(Index=0;Index<e_TextDataProcessorClassMAX;Index++)
+        FData->TextByteCallbacks[Index].clear();
+    FData->TextBlockDoneCallbacks.clear();
+    FData->TextRunCallbacks.clear();
+    FData->TextRunsAllowed=false;
 }
 
 /*******************************************************************************
@@ -853,14 +1023,41 @@ void DPS_ProcessorIncomingBytes(struct ProcessorConData *FData,
     PG_BOOL Consumed;
     int32_t byte;
     int CharLen;
+    int RunLen;
     i_DPSDataProcessorsType CurProcessor;
+    i_DPSTextByteCallbacksType CurCallback;
     unsigned int Index;
+#if PERFSTATS_ENABLED==1
+    uint64_t DisplayStart;
+#endif
+
+    PERFSTATS_TIMESTAMP(BlockStart);
 
     if(FData->Settings->DataProcessorType==e_DataProcessorType_Text)
     {
+#if PERFSTATS_ENABLED==1
+        /* Every so often we time each of the processors and the display */
+        FData->PerfSampling=PerfStats_SampleThisBlock(FData->PerfStats);
+        if(FData->PerfSampling)
+            FData->PerfPluginTimes.assign(FData->DataProcessorsList.size(),0);
+        FData->PerfDisplayTime=0;
+#endif
+
         /* Text mode data processors */
         for(byte=0;byte<bytes;byte++)
         {
+            if(FData->TextRunsAllowed)
+            {
+                /* See if we can pass a run of plain text though in one go */
+                RunLen=DPS_DoIncomingTextRun(FData,&inbuff[byte],bytes-byte,
+                        DoAutoLF,DoAutoCR);
+                if(RunLen>0)
+                {
+                    byte+=RunLen-1;
+                    continue;
+                }
+            }
+
             Consumed=false;
             CharLen=1;
             ProcessedChar[0]=inbuff[byte];
@@ -887,6 +1084,15 @@ void DPS_ProcessorIncomingBytes(struct ProcessorConData *FData,
             {
                 ProcessedChar[CharLen]=0;   // Make it a string
 DB_StartTimer(e_DBT_AddChar2Display);
+#if PERFSTATS_ENABLED==1
+                if(FData->PerfSampling)
+                {
+                    DisplayStart=GetElapsedTime_ns();
+                    Con_WriteChar2Display(ProcessedChar);
+                    FData->PerfDisplayTime+=GetElapsedTime_ns()-DisplayStart;
+                }
+                else
+#endif
                 Con_WriteChar2Display(ProcessedChar);
 DB_StopTimer(e_DBT_AddChar2Display);
             }
@@ -903,6 +1109,36 @@ DB_StopTimer(e_DBT_AddChar2Display);
                     DPS_DoNewLine();
             }
         }
+
+        /* Let the processors that want it know the block is done */
+        for(CurCallback=FData->TextBlockDoneCallbacks.begin();
+                CurCallback!=FData->TextBlockDoneCallbacks.end();CurCallback++)
+        {
+            m_ActiveDataProcessor=CurCallback->Processor;
+            CurCallback->Processor->API.ProcessIncomingTextBlockDone(FData->
+                    ProcessorsData[CurCallback->Index]);
+        }
+        m_ActiveDataProcessor=NULL;
+
+#if PERFSTATS_ENABLED==1
+        if(FData->PerfSampling)
+        {
+            for(CurProcessor=FData->DataProcessorsList.begin(),Index=0;
+                    CurProcessor!=FData->DataProcessorsList.end();
+                    CurProcessor++,Index++)
+            {
+                if(CurProcessor->API.ProcessIncomingTextByte!=NULL)
+                {
+                    PerfStats_RecordPlugin(FData->PerfStats,
+                            CurProcessor->ProID.c_str(),
+                            FData->PerfPluginTimes[Index]);
+                }
+            }
+            PerfStats_RecordStage(FData->PerfStats,e_PerfStage_DisplayUpdate,
+                    FData->PerfDisplayTime);
+            FData->PerfSampling=false;
+        }
+#endif
     }
     else
     {
@@ -947,6 +1183,105 @@ DB_StopTimer(e_DBT_AddChar2Display);
         }
         m_ActiveDataProcessor=NULL;
     }
+
+    PERFSTATS_STAGE_DONE(FData->PerfStats,e_PerfStage_DataProcessors,
+            BlockStart);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DPS_DoIncomingTextRun
+ *
+ * SYNOPSIS:
+ *    static int DPS_DoIncomingTextRun(struct ProcessorConData *FData,
+ *          const uint8_t *Run,int Bytes,bool DoAutoLF,bool DoAutoCR);
+ *
+ * PARAMETERS:
+ *    FData [I] -- The processor connection data to work with
+ *    Run [I] -- The bytes that have not been processed yet
+ *    Bytes [I] -- The number of bytes in 'Run'
+ *    DoAutoLF [I] -- Are we doing auto LF (the run stops at a \n)
+ *    DoAutoCR [I] -- Are we doing auto CR (the run stops at a \r)
+ *
+ * FUNCTION:
+ *    This is a helper function for DPS_ProcessorIncomingBytes().  It asks
+ *    all the text processors how many bytes at the start of 'Run' they
+ *    would pass though untouched.  If they all agree on some then the
+ *    processors are told about the run and it is added to the display with
+ *    one call instead of one byte at a time.
+ *
+ *    'FData->TextRunsAllowed' must be true to call this.
+ *
+ * RETURNS:
+ *    The number of bytes that where used.  If this is 0 then the caller
+ *    needs to process the next byte the normal way.
+ *
+ * SEE ALSO:
+ *    DPS_ProcessorIncomingBytes(), DPS_DoProcessIncomingTextByteCallbacks()
+ ******************************************************************************/
+static int DPS_DoIncomingTextRun(struct ProcessorConData *FData,
+        const uint8_t *Run,int Bytes,bool DoAutoLF,bool DoAutoCR)
+{
+    i_DPSTextByteCallbacksType CurCallback;
+    int r;
+#if PERFSTATS_ENABLED==1
+    uint64_t DisplayStart;
+#endif
+
+    for(CurCallback=FData->TextRunCallbacks.begin();
+            CurCallback!=FData->TextRunCallbacks.end() && Bytes>0;
+            CurCallback++)
+    {
+        Bytes=CurCallback->Processor->API.ScanIncomingTextRun(FData->
+                ProcessorsData[CurCallback->Index],Run,Bytes);
+    }
+
+    /* The auto CR/LF's have to be seen one at a time */
+    if(DoAutoLF || DoAutoCR)
+    {
+        for(r=0;r<Bytes;r++)
+            if((DoAutoLF && Run[r]=='\n') || (DoAutoCR && Run[r]=='\r'))
+                break;
+        Bytes=r;
+    }
+
+    if(Bytes<=0)
+        return 0;
+
+    for(CurCallback=FData->TextRunCallbacks.begin();
+            CurCallback!=FData->TextRunCallbacks.end();CurCallback++)
+    {
+        m_ActiveDataProcessor=CurCallback->Processor;
+#if PERFSTATS_ENABLED==1
+        if(FData->PerfSampling)
+        {
+            PERFSTATS_TIMESTAMP(PluginStart);
+            CurCallback->Processor->API.ProcessIncomingTextRun(FData->
+                    ProcessorsData[CurCallback->Index],Run,Bytes);
+            FData->PerfPluginTimes[CurCallback->Index]+=GetElapsedTime_ns()-
+                    PluginStart;
+            continue;
+        }
+#endif
+        CurCallback->Processor->API.ProcessIncomingTextRun(FData->
+                ProcessorsData[CurCallback->Index],Run,Bytes);
+    }
+    m_ActiveDataProcessor=NULL;
+
+DB_StartTimer(e_DBT_AddChar2Display);
+#if PERFSTATS_ENABLED==1
+    if(FData->PerfSampling)
+    {
+        DisplayStart=GetElapsedTime_ns();
+        Con_WriteChars2Display(Run,Bytes);
+        FData->PerfDisplayTime+=GetElapsedTime_ns()-DisplayStart;
+    }
+    else
+#endif
+    Con_WriteChars2Display(Run,Bytes);
+DB_StopTimer(e_DBT_AddChar2Display);
+
+    return Bytes;
 }
 
 /*******************************************************************************
@@ -963,8 +1298,9 @@ DB_StopTimer(e_DBT_AddChar2Display);
  *
  * FUNCTION:
  *    This is a helper function for DPS_ProcessorIncomingBytes() it loops
- *    through all the plugins and if it's a text plugin and matches 'CallClass'
- *    then the ProcessIncomingTextByte() function is called.
+ *    through all the text plugins that match 'CallClass' and calls their
+ *    ProcessIncomingTextByte() function.  The list for each class is built
+ *    in DPS_AllocProcessorConData().
  *
  * RETURNS:
  *    NONE
@@ -976,23 +1312,31 @@ void DPS_DoProcessIncomingTextByteCallbacks(struct ProcessorConData *FData,
         e_TextDataProcessorClassType CallClass,uint8_t RawByte,
         uint8_t *ProcessedChar,int *CharLen,PG_BOOL *Consumed)
 {
-    i_DPSDataProcessorsType CurProcessor;
-    unsigned int Index;
+    t_DPSTextByteCallbacksType &Callbacks=FData->TextByteCallbacks[CallClass];
+    i_DPSTextByteCallbacksType CurCallback;
 
-    for(CurProcessor=FData->DataProcessorsList.begin(),Index=0;
-            CurProcessor!=FData->DataProcessorsList.end();
-            CurProcessor++,Index++)
+    if(Callbacks.empty())
+        return;
+
+    for(CurCallback=Callbacks.begin();CurCallback!=Callbacks.end();
+            CurCallback++)
     {
-        m_ActiveDataProcessor=&*CurProcessor;
-        if(CurProcessor->Info.TxtClass==CallClass)
+        m_ActiveDataProcessor=CurCallback->Processor;
+#if PERFSTATS_ENABLED==1
+        if(FData->PerfSampling)
         {
-            if(CurProcessor->API.ProcessIncomingTextByte!=NULL)
-            {
-                CurProcessor->API.ProcessIncomingTextByte(FData->
-                        ProcessorsData[Index],RawByte,ProcessedChar,
-                        CharLen,Consumed);
-            }
+            PERFSTATS_TIMESTAMP(PluginStart);
+            CurCallback->Processor->API.ProcessIncomingTextByte(FData->
+                    ProcessorsData[CurCallback->Index],RawByte,ProcessedChar,
+                    CharLen,Consumed);
+            FData->PerfPluginTimes[CurCallback->Index]+=GetElapsedTime_ns()-
+                    PluginStart;
+            continue;
         }
+#endif
+        CurCallback->Processor->API.ProcessIncomingTextByte(FData->
+                ProcessorsData[CurCallback->Index],RawByte,ProcessedChar,
+                CharLen,Consumed);
     }
     m_ActiveDataProcessor=NULL;
 }
@@ -2738,6 +3082,133 @@ void DPS_DoScrollArea(uint32_t X1,uint32_t Y1,uint32_t X2,uint32_t Y2,
     Con_DoFunction(e_ConFunc_ScrollArea,X1,Y1,X2,Y2,DeltaX,DeltaY);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DPS_DoSetScrollRegion
+ *
+ * SYNOPSIS:
+ *    static void DPS_DoSetScrollRegion(uint32_t Top,uint32_t Bottom);
+ *
+ * PARAMETERS:
+ *    Top [I] -- The first screen line in the scroll region
+ *    Bottom [I] -- The screen line after the last line in the region.  If
+ *                  this is 0 then the region is removed and the whole
+ *                  screen scrolls again.
+ *
+ * FUNCTION:
+ *    This function sets the scroll region (the top and bottom margins).
+ *    When the cursor does a new line on the bottom line of the region only
+ *    the lines in the region scroll and nothing is moved to the scroll
+ *    back buffer.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_DoScrollArea(), DPS_DoSetAltScreen()
+ ******************************************************************************/
+static void DPS_DoSetScrollRegion(uint32_t Top,uint32_t Bottom)
+{
+    Con_DoFunction(e_ConFunc_SetScrollRegion,Top,Bottom);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DPS_DoSetAltScreen
+ *
+ * SYNOPSIS:
+ *    static void DPS_DoSetAltScreen(PG_BOOL On);
+ *
+ * PARAMETERS:
+ *    On [I] -- true = switch to the alternate screen, false = switch back
+ *              to the normal screen.
+ *
+ * FUNCTION:
+ *    This function switches between the normal screen and the alternate
+ *    screen.  The alternate screen starts blank and nothing written to it
+ *    ever goes into the scroll back buffer.  When we switch back the normal
+ *    screen is put back the way it was.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_DoSetScrollRegion()
+ ******************************************************************************/
+static void DPS_DoSetAltScreen(PG_BOOL On)
+{
+    Con_DoFunction(e_ConFunc_SetAltScreen,On);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DPS_SetStyle
+ *
+ * SYNOPSIS:
+ *    static void DPS_SetStyle(const struct StyleData *SD);
+ *
+ * PARAMETERS:
+ *    SD [I] -- The new style.  Only the STYLEDATA_VERSION_1 fields
+ *              (FGColor, BGColor, Attribs, ULineColor) are used.
+ *
+ * FUNCTION:
+ *    This function sets the forground, background and underline colors and
+ *    the attribs in one call.  Decoders that change more than one of these
+ *    at a time (like a SGR with a number of args) should use this instead
+ *    of calling SetFGColor(), SetBGColor(), etc one at a time.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_GetStyle(), DPS_SetFGColor(), DPS_SetAttribs()
+ ******************************************************************************/
+static void DPS_SetStyle(const struct StyleData *SD)
+{
+    struct CharStyling Style;
+
+    Style.FGColor=SD->FGColor;
+    Style.BGColor=SD->BGColor;
+    Style.ULineColor=SD->ULineColor;
+    Style.Attribs=SD->Attribs;
+
+    Con_SetStyle(&Style);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DPS_GetStyle
+ *
+ * SYNOPSIS:
+ *    static void DPS_GetStyle(struct StyleData *SD);
+ *
+ * PARAMETERS:
+ *    SD [O] -- The current style.  Only the STYLEDATA_VERSION_1 fields
+ *              (FGColor, BGColor, Attribs, ULineColor) are filled in, the
+ *              rest of the struct is left alone.
+ *
+ * FUNCTION:
+ *    This function gets the forground, background and underline colors and
+ *    the attribs in one call.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_SetStyle()
+ ******************************************************************************/
+static void DPS_GetStyle(struct StyleData *SD)
+{
+    struct CharStyling Style;
+
+    Con_GetStyle(&Style);
+
+    SD->FGColor=Style.FGColor;
+    SD->BGColor=Style.BGColor;
+    SD->ULineColor=Style.ULineColor;
+    SD->Attribs=Style.Attribs;
+}
+
 /*******************************************************************************
  * NAME:
  *    DPS_SetTitle
@@ -3002,6 +3473,57 @@ void DPS_ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,uint32_t Offset,
     Con_ApplyBGColor2Mark(Mark,BGColor,Offset,Len);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DPS_ApplyStyleSpans2Mark
+ *
+ * SYNOPSIS:
+ *    void DPS_ApplyStyleSpans2Mark(t_DataProMark *Mark,
+ *              const struct DPS_StyleSpan *Spans,uint32_t Count);
+ *
+ * PARAMETERS:
+ *    Mark [I] -- The mark to work on
+ *    Spans [I] -- An array of spans to apply.  Each span has:
+ *                      Offset -- The number of chars from the mark to skip
+ *                                before starting to apply the style.
+ *                      Len -- The number of chars to apply the style to.
+ *                             Pass 0 to apply until the cursor.
+ *                      What -- What parts of the style to apply.  This is
+ *                              made of the following flags or'ed together:
+ *                                  DPS_STYLESPAN_SET_ATTRIBS -- Set 'Attribs'
+ *                                  DPS_STYLESPAN_CLR_ATTRIBS -- Clear 'Attribs'
+ *                                  DPS_STYLESPAN_FGCOLOR -- Set 'FGColor'
+ *                                  DPS_STYLESPAN_BGCOLOR -- Set 'BGColor'
+ *                      Attribs -- The attribs to set or clear
+ *                      FGColor -- The forground color to apply
+ *                      BGColor -- The background color to apply
+ *    Count [I] -- The number of entries in 'Spans'
+ *
+ * FUNCTION:
+ *    This function applies a number of styles to the text after a mark in
+ *    one go.  This is the same as calling DPS_ApplyAttrib2Mark(),
+ *    DPS_RemoveAttribFromMark(), DPS_ApplyFGColor2Mark(), and
+ *    DPS_ApplyBGColor2Mark() for each span, but the display only has to
+ *    walk each line once and redraw once, so it is much faster if you are
+ *    styling more than one thing (like a highlighter coloring a number of
+ *    words on a line).
+ *
+ *    Spans are applied in the order they are in the array, so if they
+ *    overlap the later span wins.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_AllocateMark(), DPS_ApplyAttrib2Mark(), DPS_ApplyFGColor2Mark(),
+ *    DPS_ApplyBGColor2Mark()
+ ******************************************************************************/
+void DPS_ApplyStyleSpans2Mark(t_DataProMark *Mark,
+        const struct DPS_StyleSpan *Spans,uint32_t Count)
+{
+    Con_ApplyStyleSpans2Mark(Mark,Spans,Count);
+}
+
 /*******************************************************************************
  * NAME:
  *    DPS_MoveMark
@@ -67,11 +67,28 @@ typedef t_DPSDataProcessorsType::iterator i_DPSDataProcessorsType;
 typedef std::vector<t_DataProcessorHandleType *> t_ProcessorsDataType;
 typedef t_ProcessorsDataType::iterator i_ProcessorsDataType;
 
+struct DPSTextByteCallback
+{
+    struct DataProcessor *Processor;
+    unsigned int Index;                     // Index into 'ProcessorsData'
+};
+
+typedef std::vector<struct DPSTextByteCallback> t_DPSTextByteCallbacksType;
+typedef t_DPSTextByteCallbacksType::iterator i_DPSTextByteCallbacksType;
+
 struct ProcessorConData
 {
     t_ProcessorsDataType ProcessorsData;
     t_DPSDataProcessorsType DataProcessorsList;
+    t_DPSTextByteCallbacksType TextByteCallbacks[e_TextDataProcessorClassMAX]; // The text processors with a ProcessIncomingTextByte() by class
+    t_DPSTextByteCallbacksType TextBlockDoneCallbacks; // The text processors with a ProcessIncomingTextBlockDone()
+    t_DPSTextByteCallbacksType TextRunCallbacks; // All the text processors, last to be called first (if they can all do runs)
+    bool TextRunsAllowed;                   // Every text processor can pass runs of bytes
     class ConSettings *Settings;
+    struct PerfStatsCon *PerfStats;
+    bool PerfSampling;                      // Time each processor for this block
+    std::vector<uint64_t> PerfPluginTimes;  // ns per processor for this block
+    uint64_t PerfDisplayTime;               // ns spent adding to the display for this block
 };
 
 typedef enum
@@ -34,12 +34,13 @@
 //#include "App/Settings.h"
 #include "App/Connections.h"
 #include "App/IOSystem.h"
+#include "App/TimerWheel.h"
 //#include "App/MaxSizes.h"
 #include "App/Dialogs/Dialog_ComTest.h"
+#include "App/Util/ComTestFrames.h"
 #include "UI/UIAsk.h"
 #include "UI/UIComTest.h"
 #include "UI/UISystem.h"
-#include "UI/UITimers.h"
 #include <string>
 #include <string.h>
 #include <inttypes.h>
@@ -52,6 +53,8 @@ using namespace std;
 /*** DEFINES                  ***/
 #define DCT_TEST_TIMEOUT_POLL_RATE          1000    // When running a test how often do we check for timeout (ms)
 #define DCT_TEST_END_TIMEOUT                10.0    // 10 seconds between rx bytes == end of test (double)
+#define DCT_STATS_REFRESH_RATE              250     // How often the stats are updated while a test runs (ms)
+#define DCT_HISTOGRAM_BAR_LEN               40      // Chars in the longest latency histogram bar
 
 /*** MACROS                   ***/
 
@@ -74,6 +77,8 @@ typedef enum
     e_DCT_Pattern_AscII,
     e_DCT_Pattern_Binary,
     e_DCT_Pattern_Random,
+    e_DCT_Pattern_PRBS7,
+    e_DCT_Pattern_PRBS15,
     e_DCT_PatternMAX
 } e_DCT_PatternType;
 
@@ -99,6 +104,11 @@ static class Connection *DCT_AllocConnection4Test(e_DCTType ConNumber);
 static void DCT_StopTest(void);
 static void DCT_ComTestUpdateCallback(class Connection *Con);
 static void DCT_TestTimeoutCheck(uintptr_t UserData);
+static void DCT_StatsRefresh(uintptr_t UserData);
+static void DCT_GetStats(struct ComTestStats &TxStats,
+        struct ComTestStats &RxStats);
+static void DCT_ShowStats(void);
+static void DCT_ShowLatencyHistogram(const struct ComTestRxCounters &Rx);
 
 /*** VARIABLE DEFINITIONS     ***/
 static struct ConnectionInfoList *m_DCT_Connections;
@@ -108,7 +118,8 @@ static bool m_DCT_DoingTest;
 static class Connection *m_DCT_Connection1;
 static class Connection *m_DCT_Connection2;
 static uint8_t *m_DCT_PatternBuffer;
-static struct UITimer *m_DCT_TestTimeoutCheckTimer;
+static struct TimerWheelTimer *m_DCT_TestTimeoutCheckTimer;
+static struct TimerWheelTimer *m_DCT_StatsRefreshTimer;
 static e_DCT_TestResultType m_DCT_TestResult;
 
 /*******************************************************************************
@@ -147,17 +158,27 @@ void RunComTestDialog(void)
     m_DCT_Connections=NULL;
     m_DCT_PatternBuffer=NULL;
     m_DCT_TestTimeoutCheckTimer=NULL;
+    m_DCT_StatsRefreshTimer=NULL;
     try
     {
         m_DCT_DoingTest=false;
         m_DCT_TestResult=e_DCT_TestResult_NotRun;
 
-        m_DCT_TestTimeoutCheckTimer=AllocUITimer();
+        m_DCT_TestTimeoutCheckTimer=TimerWheel_AllocTimer();
         if(m_DCT_TestTimeoutCheckTimer==NULL)
             throw("Failed to allocate a timer for the test");
 
-        SetupUITimer(m_DCT_TestTimeoutCheckTimer,DCT_TestTimeoutCheck,0,true);
-        UITimerSetTimeout(m_DCT_TestTimeoutCheckTimer,DCT_TEST_TIMEOUT_POLL_RATE);
+        TimerWheel_SetupTimer(m_DCT_TestTimeoutCheckTimer,DCT_TestTimeoutCheck,
+                0,true);
+        TimerWheel_SetTimeout(m_DCT_TestTimeoutCheckTimer,
+                DCT_TEST_TIMEOUT_POLL_RATE);
+
+        m_DCT_StatsRefreshTimer=TimerWheel_AllocTimer();
+        if(m_DCT_StatsRefreshTimer==NULL)
+            throw("Failed to allocate a timer for the test");
+
+        TimerWheel_SetupTimer(m_DCT_StatsRefreshTimer,DCT_StatsRefresh,0,true);
+        TimerWheel_SetTimeout(m_DCT_StatsRefreshTimer,DCT_STATS_REFRESH_RATE);
 
         DCT_GetListOfConnections();
 
@@ -183,6 +204,8 @@ void RunComTestDialog(void)
         UIAddItem2ComboBox(Pattern,"AscII",e_DCT_Pattern_AscII);
         UIAddItem2ComboBox(Pattern,"Binary 0-255",e_DCT_Pattern_Binary);
         UIAddItem2ComboBox(Pattern,"Random",e_DCT_Pattern_Random);
+        UIAddItem2ComboBox(Pattern,"PRBS-7",e_DCT_Pattern_PRBS7);
+        UIAddItem2ComboBox(Pattern,"PRBS-15",e_DCT_Pattern_PRBS15);
 
         DCT_FillInConnectionPullDown(ConPullDown1,e_DCT_Con1,NULL);
         DCT_FillInConnectionPullDown(ConPullDown2,e_DCT_Con2,NULL);
@@ -209,8 +232,24 @@ void RunComTestDialog(void)
                 e_AskBox_Error,e_AskBttns_Ok);
     }
 
+    /* Make sure the send threads are stopped before we go */
+    if(m_DCT_DoingTest)
+        DCT_StopTest();
+    if(m_DCT_Connection1!=NULL)
+    {
+        Con_FreeConnection(m_DCT_Connection1);
+        m_DCT_Connection1=NULL;
+    }
+    if(m_DCT_Connection2!=NULL)
+    {
+        Con_FreeConnection(m_DCT_Connection2);
+        m_DCT_Connection2=NULL;
+    }
+
     if(m_DCT_TestTimeoutCheckTimer!=NULL)
-        FreeUITimer(m_DCT_TestTimeoutCheckTimer);
+        TimerWheel_FreeTimer(m_DCT_TestTimeoutCheckTimer);
+    if(m_DCT_StatsRefreshTimer!=NULL)
+        TimerWheel_FreeTimer(m_DCT_StatsRefreshTimer);
 
     for(r=0;r<e_DCTMAX;r++)
         if(m_DCT_OptionsWidgets[r]!=NULL)
@@ -632,6 +671,8 @@ static void DCT_RethinkUI(void)
             case e_DCT_Pattern_FF:
             case e_DCT_Pattern_00:
             case e_DCT_Pattern_Random:
+            case e_DCT_Pattern_PRBS7:
+            case e_DCT_Pattern_PRBS15:
             break;
             case e_DCT_Pattern_55AA:
             case e_DCT_Pattern_ABC:
@@ -650,6 +691,8 @@ static void DCT_RethinkUI(void)
             case e_DCT_Pattern_FF:
             case e_DCT_Pattern_00:
             case e_DCT_Pattern_Random:
+            case e_DCT_Pattern_PRBS7:
+            case e_DCT_Pattern_PRBS15:
             break;
             case e_DCT_Pattern_55AA:
             break;
@@ -812,9 +855,9 @@ static class Connection *DCT_AllocConnection4Test(e_DCTType ConNumber)
  *    NONE
  *
  * FUNCTION:
- *    This function is called to start the com test.
- *
- *    This will not return until the test is finished.
+ *    This function is called to start the com test.  The packets are sent
+ *    from a thread in each sending connection, the stats are picked up by
+ *    a UI timer.
  *
  * RETURNS:
  *    NONE
@@ -830,13 +873,6 @@ static void DCT_StartTest(void)
     t_UINumberInput *PacketLength;
     t_UINumberInput *Packets;
     t_UIDoubleInput *Delay;
-    t_UITextInputCtrl *PacketsSentCtrl;
-    t_UITextInputCtrl *PacketsRecvCtrl;
-    t_UITextInputCtrl *BytesCtrl;
-    t_UITextInputCtrl *SendErrorsCtrl;
-    t_UITextInputCtrl *SendBusyErrorsCtrl;
-//    t_UITextInputCtrl *BytesPerSecCtrl;
-    t_UITextInputCtrl *RxErrorsCtrl;
     bool DoingLoopback;
     bool DoingFullDuplex;
     long Packets2Send;
@@ -866,14 +902,6 @@ static void DCT_StartTest(void)
         Packets=UICT_GetNumberInputHandle(e_CT_Number_Packets);
         Delay=UICT_GetDoubleNumberInputHandle(e_CT_DoubleNumber_Delay);
 
-        PacketsSentCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_PacketsSent);
-        PacketsRecvCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_PacketsRecv);
-        BytesCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_Bytes);
-        SendErrorsCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_SendErrors);
-        SendBusyErrorsCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_SendBusyErrors);
-//        BytesPerSecCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_BytesPerSec);
-        RxErrorsCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_RxErrors);
-
         DoingLoopback=UIGetCheckboxCheckStatus(Loopback);
         DoingFullDuplex=UIGetCheckboxCheckStatus(FullDuplex);
         Packets2Send=UIGetNumberInputCtrlValue(Packets);
@@ -881,13 +909,9 @@ static void DCT_StartTest(void)
         PacketDelaymS=UIGetDoubleInputCtrlValue(Delay)*1000.0;
         SelectedPattern=(e_DCT_PatternType)UIGetComboBoxSelectedEntry(Pattern);
 
-        UISetTextCtrlText(PacketsSentCtrl,"");
-        UISetTextCtrlText(BytesCtrl,"");
-        UISetTextCtrlText(SendErrorsCtrl,"");
-        UISetTextCtrlText(SendBusyErrorsCtrl,"");
-        UISetTextCtrlText(PacketsRecvCtrl,"");
-        UISetTextCtrlText(RxErrorsCtrl,"");
-//        UISetTextCtrlText(BytesPerSecCtrl,"");
+        for(r=0;r<e_CT_TextInputMAX;r++)
+            UISetTextCtrlText(UICT_GetTextInput((e_CT_TextInput)r),"");
+        UISetLabelText(UICT_GetLabelHandle(e_CT_Label_LatencyHistogram),"");
 
         if(m_DCT_PatternBuffer!=NULL)
             free(m_DCT_PatternBuffer);
@@ -944,6 +968,12 @@ static void DCT_StartTest(void)
                 for(r=0;r<PatLen;r++)
                     m_DCT_PatternBuffer[r]=rand()%256;
             break;
+            case e_DCT_Pattern_PRBS7:
+                ComTest_FillPRBS(m_DCT_PatternBuffer,PatLen,7);
+            break;
+            case e_DCT_Pattern_PRBS15:
+                ComTest_FillPRBS(m_DCT_PatternBuffer,PatLen,15);
+            break;
             case e_DCT_PatternMAX:
             default:
                 throw("Unsupported pattern (program logic error)");
@@ -972,7 +1002,8 @@ static void DCT_StartTest(void)
 
         m_DCT_Connection1->SetConnectedState(true);
 
-        UITimerStart(m_DCT_TestTimeoutCheckTimer);
+        TimerWheel_Start(m_DCT_TestTimeoutCheckTimer);
+        TimerWheel_Start(m_DCT_StatsRefreshTimer);
 
         /* Start the test */
         if(!DoingLoopback)
@@ -986,38 +1017,15 @@ static void DCT_StartTest(void)
         m_DCT_DoingTest=true;
         DCT_RethinkUI();
         DCT_ComTestUpdateCallback(NULL);
-
-        if(PacketDelaymS==0)
-        {
-            /* Run the UI until we are done */
-            if(DoingLoopback && !DoingFullDuplex)
-            {
-                /* Only sending from connection 1 */
-                while(m_DCT_DoingTest && m_DCT_Connection1->IsComTestRunning())
-                {
-                    UI_ProcessAllPendingUIEvents();
-                    m_DCT_Connection1->ComTestFastTick();
-                }
-            }
-            else
-            {
-                /* We are sending from connection 1 and 2 */
-                while(m_DCT_DoingTest && m_DCT_Connection1->IsComTestRunning()
-                        && m_DCT_Connection2->IsComTestRunning())
-                {
-                    UI_ProcessAllPendingUIEvents();
-                    m_DCT_Connection1->ComTestFastTick();
-                    m_DCT_Connection2->ComTestFastTick();
-                }
-            }
-        }
     }
     catch(const char *Msg)
     {
+        DCT_StopTest();
         UIAsk("Error starting com test",Msg,e_AskBox_Error,e_AskBttns_Ok);
     }
     catch(...)
     {
+        DCT_StopTest();
     }
 }
 
@@ -1038,159 +1046,368 @@ static void DCT_StartTest(void)
  *    NONE
  *
  * SEE ALSO:
- *    
+ *
  ******************************************************************************/
 static void DCT_StopTest(void)
 {
+    bool WasDoingTest;
+
+    /* Clear this first so the update call back from StopComTest() doesn't
+       come back in here */
+    WasDoingTest=m_DCT_DoingTest;
+    m_DCT_DoingTest=false;
+
+    TimerWheel_Stop(m_DCT_TestTimeoutCheckTimer);
+    TimerWheel_Stop(m_DCT_StatsRefreshTimer);
+
+    if(m_DCT_Connection1!=NULL)
+        m_DCT_Connection1->StopComTest();
+    if(m_DCT_Connection2!=NULL)
+        m_DCT_Connection2->StopComTest();
+
+    if(WasDoingTest)
+        DCT_ShowStats();
+
     if(m_DCT_Connection1!=NULL)
         m_DCT_Connection1->SetConnectedState(false);
     if(m_DCT_Connection2!=NULL)
         m_DCT_Connection2->SetConnectedState(false);
 
-    UITimerStop(m_DCT_TestTimeoutCheckTimer);
-
-    m_DCT_DoingTest=false;
     DCT_RethinkUI();
 }
 
 /*******************************************************************************
  * NAME:
- *    DCT_ComTestUpdateCallback
+ *    DCT_GetStats
  *
  * SYNOPSIS:
- *    static void DCT_ComTestUpdateCallback(class Connection *Con);
+ *    static void DCT_GetStats(struct ComTestStats &TxStats,
+ *              struct ComTestStats &RxStats);
  *
  * PARAMETERS:
- *    Con [I] -- The connection this update is from.  Ignored.
+ *    TxStats [O] -- The stats from the sending connection (connection 1)
+ *    RxStats [O] -- The stats from the receiving connection (connection 2
+ *                   or connection 1 when doing a loop back)
  *
  * FUNCTION:
- *    This function updates the UI with info from the com test.
+ *    This function gets a copy of the stats from the test connections.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    Connection::GetComTestStats()
  ******************************************************************************/
-static void DCT_ComTestUpdateCallback(class Connection *Con)
+static void DCT_GetStats(struct ComTestStats &TxStats,
+        struct ComTestStats &RxStats)
+{
+    m_DCT_Connection1->GetComTestStats(&TxStats);
+    if(m_DCT_Connection2!=NULL)
+        m_DCT_Connection2->GetComTestStats(&RxStats);
+    else
+        RxStats=TxStats;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DCT_ShowStats
+ *
+ * SYNOPSIS:
+ *    static void DCT_ShowStats(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function updates the UI with the stats from the com test.  For
+ *    full duplex the stats from both connections are added together.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DCT_ComTestUpdateCallback()
+ ******************************************************************************/
+static void DCT_ShowStats(void)
 {
-    t_UITextInputCtrl *PacketsSentCtrl;
-    t_UITextInputCtrl *PacketsRecvCtrl;
-    t_UITextInputCtrl *BytesCtrl;
-    t_UITextInputCtrl *SendErrorsCtrl;
-    t_UITextInputCtrl *SendBusyErrorsCtrl;
-//    t_UITextInputCtrl *BytesPerSecCtrl;
-    t_UITextInputCtrl *RxErrorsCtrl;
     t_UICheckboxCtrl *FullDuplexCtrl;
-    t_UINumberInput *Packets;
-    const struct ComTestStats *ConStatsTx;
-    const struct ComTestStats *ConStatsRx;
+    struct ComTestStats ConStatsTx;
+    struct ComTestStats ConStatsRx;
+    struct ComTestRxCounters Rx;
     char buff[100];
     bool DoingFullDuplex;
-    unsigned long Packets2Send;
     uint64_t ErrorCount;
-    uint64_t PacketsRxed;
     uint64_t BytesSent;
     uint64_t SendBusyErrors;
     uint64_t SendErrors;
     uint64_t PacketsSent;
-
-    if(!m_DCT_DoingTest)
-        return;
+    uint64_t BytesPerSec;
 
     if(m_DCT_Connection1==NULL)
         return;
 
-    PacketsSentCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_PacketsSent);
-    PacketsRecvCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_PacketsRecv);
-    BytesCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_Bytes);
-    SendErrorsCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_SendErrors);
-    SendBusyErrorsCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_SendBusyErrors);
-//    BytesPerSecCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_BytesPerSec);
-    RxErrorsCtrl=UICT_GetTextInput(e_CT_TextInput_Stat_RxErrors);
-    Packets=UICT_GetNumberInputHandle(e_CT_Number_Packets);
     FullDuplexCtrl=UICT_GetCheckboxHandle(e_CT_Checkbox_FullDuplex);
-
-    Packets2Send=UIGetNumberInputCtrlValue(Packets);
     DoingFullDuplex=UIGetCheckboxCheckStatus(FullDuplexCtrl);
 
-    ConStatsTx=m_DCT_Connection1->GetComTestStats();
-    if(m_DCT_Connection2!=NULL)
-        ConStatsRx=m_DCT_Connection2->GetComTestStats();
-    else
-        ConStatsRx=ConStatsTx;
-
-    ErrorCount=ConStatsRx->ErrorsDetected;
-    PacketsRxed=ConStatsRx->PacketsRx;
-    SendBusyErrors=ConStatsTx->SendBusyErrors;
-    SendErrors=ConStatsTx->SendErrors;
-    BytesSent=ConStatsTx->BytesSent;
-    PacketsSent=ConStatsTx->PacketsSent;
+    DCT_GetStats(ConStatsTx,ConStatsRx);
+
+    Rx=ConStatsRx.Rx;
+    ErrorCount=ConStatsRx.ErrorsDetected;
+    SendBusyErrors=ConStatsTx.SendBusyErrors;
+    SendErrors=ConStatsTx.SendErrors;
+    BytesSent=ConStatsTx.BytesSent;
+    PacketsSent=ConStatsTx.PacketsSent;
+    BytesPerSec=ConStatsRx.BytesPerSec;
     if(DoingFullDuplex)
     {
-        /* We need to add any errors on connection 1 */
-        ErrorCount+=ConStatsTx->ErrorsDetected;
-        PacketsRxed+=ConStatsTx->PacketsRx;
-        SendBusyErrors+=ConStatsRx->SendBusyErrors;
-        SendErrors+=ConStatsRx->SendErrors;
-        BytesSent+=ConStatsRx->BytesSent;
-        PacketsSent+=ConStatsRx->PacketsSent;
+        /* We need to add the other direction */
+        ComTest_AddCounters(Rx,ConStatsTx.Rx);
+        ErrorCount+=ConStatsTx.ErrorsDetected;
+        SendBusyErrors+=ConStatsRx.SendBusyErrors;
+        SendErrors+=ConStatsRx.SendErrors;
+        BytesSent+=ConStatsRx.BytesSent;
+        PacketsSent+=ConStatsRx.PacketsSent;
+        BytesPerSec+=ConStatsTx.BytesPerSec;
     }
 
     sprintf(buff,"%" PRIu64,PacketsSent);
-    UISetTextCtrlText(PacketsSentCtrl,buff);
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_PacketsSent),buff);
 
     sprintf(buff,"%" PRIu64,BytesSent);
-    UISetTextCtrlText(BytesCtrl,buff);
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_Bytes),buff);
 
     sprintf(buff,"%" PRIu64,SendErrors);
-    UISetTextCtrlText(SendErrorsCtrl,buff);
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_SendErrors),buff);
 
     sprintf(buff,"%" PRIu64,SendBusyErrors);
-    UISetTextCtrlText(SendBusyErrorsCtrl,buff);
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_SendBusyErrors),
+            buff);
 
-    sprintf(buff,"%" PRIu64,PacketsRxed);
-    UISetTextCtrlText(PacketsRecvCtrl,buff);
+    sprintf(buff,"%" PRIu64,Rx.PacketsRx);
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_PacketsRecv),buff);
 
     sprintf(buff,"%" PRIu64,ErrorCount);
-    UISetTextCtrlText(RxErrorsCtrl,buff);
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_RxErrors),buff);
+
+    sprintf(buff,"%" PRIu64,Rx.PacketsLost);
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_PacketsLost),buff);
+
+    sprintf(buff,"%" PRIu64,BytesPerSec);
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_BytesPerSec),buff);
+
+    buff[0]=0;
+    if(Rx.BytesChecked>0)
+        sprintf(buff,"%.3e",(double)Rx.BitErrors/(Rx.BytesChecked*8.0));
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_BitErrorRate),
+            buff);
 
-    sprintf(buff,"%" PRIu64,ConStatsRx->BytesPerSec);
-//    UISetTextCtrlText(BytesPerSecCtrl,buff);
+    buff[0]=0;
+    if(Rx.BytesChecked>0)
+        sprintf(buff,"%.3e",(double)Rx.ByteErrors/Rx.BytesChecked);
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_ByteErrorRate),
+            buff);
 
-    /* Check if we are done */
+    buff[0]=0;
+    if(Rx.PacketsRx>0)
+    {
+        sprintf(buff,"%.3f/%.3f/%.3f",Rx.LatencyMin_ns/1000000.0,
+                (double)Rx.LatencyTotal_ns/Rx.PacketsRx/1000000.0,
+                Rx.LatencyMax_ns/1000000.0);
+    }
+    UISetTextCtrlText(UICT_GetTextInput(e_CT_TextInput_Stat_Latency),buff);
+
+    DCT_ShowLatencyHistogram(Rx);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DCT_ShowLatencyHistogram
+ *
+ * SYNOPSIS:
+ *    static void DCT_ShowLatencyHistogram(const struct ComTestRxCounters &Rx);
+ *
+ * PARAMETERS:
+ *    Rx [I] -- The rx counters to show the latency histogram for
+ *
+ * FUNCTION:
+ *    This function draws the latency histogram as text bars.  Only the
+ *    buckets between the first and last one with packets are shown.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DCT_ShowStats()
+ ******************************************************************************/
+static void DCT_ShowLatencyHistogram(const struct ComTestRxCounters &Rx)
+{
+    t_UILabelCtrl *HistogramCtrl;
+    string Text;
+    char buff[100];
+    uint64_t MaxCount;
+    uint64_t us;
+    int First;
+    int Last;
+    int BarLen;
+    int r;
+
+    HistogramCtrl=UICT_GetLabelHandle(e_CT_Label_LatencyHistogram);
+
+    First=-1;
+    Last=-1;
+    MaxCount=0;
+    for(r=0;r<COMTEST_LATENCY_BUCKETS;r++)
+    {
+        if(Rx.LatencyHist[r]==0)
+            continue;
+        if(First<0)
+            First=r;
+        Last=r;
+        if(Rx.LatencyHist[r]>MaxCount)
+            MaxCount=Rx.LatencyHist[r];
+    }
+
+    if(First<0)
+    {
+        UISetLabelText(HistogramCtrl,"");
+        return;
+    }
+
+    for(r=First;r<=Last;r++)
+    {
+        /* Bucket r starts at 2^r us (bucket 0 is everything under 2us) */
+        us=1ULL<<r;
+        if(r==0)
+            strcpy(buff,"    <2us ");
+        else if(us<1000)
+            sprintf(buff,">=%4" PRIu64 "us ",us);
+        else if(us<1000000)
+            sprintf(buff,">=%4" PRIu64 "ms ",us/1000);
+        else
+            sprintf(buff,">=%4" PRIu64 "s  ",us/1000000);
+        Text+=buff;
+
+        BarLen=Rx.LatencyHist[r]*DCT_HISTOGRAM_BAR_LEN/MaxCount;
+        if(BarLen==0 && Rx.LatencyHist[r]>0)
+            BarLen=1;
+        Text.append(BarLen,'#');
+        Text.append(DCT_HISTOGRAM_BAR_LEN-BarLen,' ');
+
+        sprintf(buff," %" PRIu64,Rx.LatencyHist[r]);
+        Text+=buff;
+        if(r!=Last)
+            Text+="\n";
+    }
+
+    UISetLabelText(HistogramCtrl,Text.c_str());
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DCT_ComTestUpdateCallback
+ *
+ * SYNOPSIS:
+ *    static void DCT_ComTestUpdateCallback(class Connection *Con);
+ *
+ * PARAMETERS:
+ *    Con [I] -- The connection this update is from.  Ignored.
+ *
+ * FUNCTION:
+ *    This function updates the UI with info from the com test and checks
+ *    if the test is done.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DCT_StatsRefresh()
+ ******************************************************************************/
+static void DCT_ComTestUpdateCallback(class Connection *Con)
+{
+    t_UICheckboxCtrl *FullDuplexCtrl;
+    t_UINumberInput *Packets;
+    struct ComTestStats ConStatsTx;
+    struct ComTestStats ConStatsRx;
+    bool DoingFullDuplex;
+    unsigned long Packets2Send;
+    bool Done;
+
+    if(!m_DCT_DoingTest)
+        return;
+
+    if(m_DCT_Connection1==NULL)
+        return;
+
+    DCT_ShowStats();
+
+    Packets=UICT_GetNumberInputHandle(e_CT_Number_Packets);
+    FullDuplexCtrl=UICT_GetCheckboxHandle(e_CT_Checkbox_FullDuplex);
+
+    Packets2Send=UIGetNumberInputCtrlValue(Packets);
+    DoingFullDuplex=UIGetCheckboxCheckStatus(FullDuplexCtrl);
+
+    DCT_GetStats(ConStatsTx,ConStatsRx);
+
+    /* A send error ends the test */
+    if(ConStatsTx.SendErrors>0 || (DoingFullDuplex &&
+            ConStatsRx.SendErrors>0))
+    {
+        m_DCT_TestResult=e_DCT_TestResult_Fail;
+        DCT_StopTest();
+        return;
+    }
+
+    /* Check if we are done (every packet either arrived or is known lost) */
+    Done=ConStatsRx.Rx.PacketsRx+ConStatsRx.Rx.PacketsLost>=Packets2Send;
     if(DoingFullDuplex)
     {
-        if(ConStatsRx->PacketsRx==Packets2Send &&
-                ConStatsTx->PacketsRx==Packets2Send)
-        {
-            /* Ok, we got to the end */
-            if(ConStatsTx->SendErrors==0 && ConStatsTx->ErrorsDetected==0 &&
-                    ConStatsRx->SendErrors==0 && ConStatsRx->ErrorsDetected==0)
-            {
-                m_DCT_TestResult=e_DCT_TestResult_Pass;
-            }
-            else
-            {
-                m_DCT_TestResult=e_DCT_TestResult_Fail;
-            }
-            DCT_StopTest();
-        }
+        Done=Done && ConStatsTx.Rx.PacketsRx+ConStatsTx.Rx.PacketsLost>=
+                Packets2Send;
     }
-    else
+
+    if(Done)
     {
-        if(ConStatsRx->PacketsRx==Packets2Send)
+        /* Ok, we got to the end */
+        if(ConStatsRx.ErrorsDetected==0 && (!DoingFullDuplex ||
+                ConStatsTx.ErrorsDetected==0))
         {
-            /* Ok, we got to the end */
-            if(ConStatsTx->SendErrors==0 && ConStatsRx->ErrorsDetected==0)
-                m_DCT_TestResult=e_DCT_TestResult_Pass;
-            else
-                m_DCT_TestResult=e_DCT_TestResult_Fail;
-            DCT_StopTest();
+            m_DCT_TestResult=e_DCT_TestResult_Pass;
         }
+        else
+        {
+            m_DCT_TestResult=e_DCT_TestResult_Fail;
+        }
+        DCT_StopTest();
     }
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DCT_StatsRefresh
+ *
+ * SYNOPSIS:
+ *    static void DCT_StatsRefresh(uintptr_t UserData);
+ *
+ * PARAMETERS:
+ *    UserData [I] -- Not used
+ *
+ * FUNCTION:
+ *    This function is called from a UI timer while the test is running to
+ *    update the stats.  The connections don't call the UI for every packet
+ *    (the packets are sent from a thread) so this is how the dialog keeps
+ *    up.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DCT_ComTestUpdateCallback()
+ ******************************************************************************/
+static void DCT_StatsRefresh(uintptr_t UserData)
+{
+    DCT_ComTestUpdateCallback(NULL);
+}
+
 /*******************************************************************************
  * NAME:
  *    DCT_TestTimeoutCheck
@@ -1209,12 +1426,12 @@ static void DCT_ComTestUpdateCallback(class Connection *Con)
  *    NONE
  *
  * SEE ALSO:
- *    
+ *
  ******************************************************************************/
 static void DCT_TestTimeoutCheck(uintptr_t UserData)
 {
-    const struct ComTestStats *ConStatsTx;
-    const struct ComTestStats *ConStatsRx;
+    struct ComTestStats ConStatsTx;
+    struct ComTestStats ConStatsRx;
     time_t CurTime;
     double TimePassed;
     t_UIDoubleInput *Delay;
@@ -1234,19 +1451,15 @@ static void DCT_TestTimeoutCheck(uintptr_t UserData)
     PacketDelay=UIGetDoubleInputCtrlValue(Delay);
     DoingFullDuplex=UIGetCheckboxCheckStatus(FullDuplexCtrl);
 
-    ConStatsTx=m_DCT_Connection1->GetComTestStats();
-    if(m_DCT_Connection2!=NULL)
-        ConStatsRx=m_DCT_Connection2->GetComTestStats();
-    else
-        ConStatsRx=m_DCT_Connection1->GetComTestStats();
+    DCT_GetStats(ConStatsTx,ConStatsRx);
 
     time(&CurTime);
     if(DoingFullDuplex)
     {
-        TimePassed=difftime(CurTime,ConStatsRx->LastRxTimeStamp);
+        TimePassed=difftime(CurTime,ConStatsRx.LastRxTimeStamp);
         if(TimePassed>PacketDelay+DCT_TEST_END_TIMEOUT)
         {
-            TimePassed=difftime(CurTime,ConStatsTx->LastRxTimeStamp);
+            TimePassed=difftime(CurTime,ConStatsTx.LastRxTimeStamp);
             if(TimePassed>PacketDelay+DCT_TEST_END_TIMEOUT)
             {
                 /* Timed out */
@@ -1257,7 +1470,7 @@ static void DCT_TestTimeoutCheck(uintptr_t UserData)
     }
     else
     {
-        TimePassed=difftime(CurTime,ConStatsRx->LastRxTimeStamp);
+        TimePassed=difftime(CurTime,ConStatsRx.LastRxTimeStamp);
         if(TimePassed>PacketDelay+DCT_TEST_END_TIMEOUT)
         {
             /* Timed out */
@@ -1266,4 +1479,3 @@ static void DCT_TestTimeoutCheck(uintptr_t UserData)
         }
     }
 }
-
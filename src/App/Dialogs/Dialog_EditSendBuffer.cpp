@@ -1129,7 +1129,7 @@ static void DESB_RethinkButtons(void)
     bool InsertAsNumberEnabled;
     bool InsertAsTextEnabled;
     bool InsertPropertiesEnabled;
-    const uint8_t *StartPtr,*EndPtr;
+    int StartOffset,EndOffset;
     int SelSize;
 
     Fill=UIESB_GetButton(e_ESB_Button_Fill);
@@ -1148,11 +1148,12 @@ static void DESB_RethinkButtons(void)
     EndianSwapEnabled=false;
     InsertCRCEnabled=true;
 
-    SelectionValid=m_DESB_HexDisplay->GetSelectionBounds(&StartPtr,&EndPtr);
+    SelectionValid=m_DESB_HexDisplay->GetSelectionOffsets(&StartOffset,
+            &EndOffset);
 
     if(SelectionValid)
     {
-        SelSize=EndPtr-StartPtr;
+        SelSize=EndOffset-StartOffset;
 
         FillEnabled=true;
         InsertAsTextEnabled=true;
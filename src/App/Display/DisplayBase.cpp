@@ -114,6 +114,10 @@ DisplayBase::DisplayBase()
     LastBlockDeviceSetToBlock=false;
 
     HexInput=NULL;
+    PerfStats=NULL;
+
+    SelExtractActive=false;
+    SelExtractPos=0;
 }
 
 /*******************************************************************************
@@ -308,6 +312,70 @@ void DisplayBase::SetBlockDeviceMode(bool On)
     /* We do nothing */
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::SetPerfStats
+ *
+ * SYNOPSIS:
+ *    void DisplayBase::SetPerfStats(struct PerfStatsCon *PS);
+ *
+ * PARAMETERS:
+ *    PS [I] -- The performance stats for the connection this display is
+ *              on.  NULL for none.
+ *
+ * FUNCTION:
+ *    This function sets where the display records how long it takes to
+ *    redraw lines.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_AllocCon()
+ ******************************************************************************/
+void DisplayBase::SetPerfStats(struct PerfStatsCon *PS)
+{
+    PerfStats=PS;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::WriteChars
+ *
+ * SYNOPSIS:
+ *    void DisplayBase::WriteChars(const uint8_t *Chrs,int Count);
+ *
+ * PARAMETERS:
+ *    Chrs [I] -- The chars to add.  Each byte is one char (this is not
+ *                0 term'ed)
+ *    Count [I] -- The number of chars in 'Chrs'
+ *
+ * FUNCTION:
+ *    This function adds a run of single byte chars to the display.  It is
+ *    the same as calling WriteChar() for each char, but lets the display
+ *    do the work once for the whole run.
+ *
+ *    This version just calls WriteChar() for each char.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    WriteChar()
+ ******************************************************************************/
+void DisplayBase::WriteChars(const uint8_t *Chrs,int Count)
+{
+    uint8_t Chr[2];
+    int r;
+
+    Chr[1]=0;
+    for(r=0;r<Count;r++)
+    {
+        Chr[0]=Chrs[r];
+        WriteChar(Chr);
+    }
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayBase::NoteNonPrintable
@@ -1198,6 +1266,58 @@ void DisplayBase::ScrollArea(uint32_t X1,uint32_t Y1,uint32_t X2,uint32_t Y2,
     /* Does nothing */
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::SetScrollRegion
+ *
+ * SYNOPSIS:
+ *    void DisplayBase::SetScrollRegion(uint32_t Top,uint32_t Bottom);
+ *
+ * PARAMETERS:
+ *    Top [I] -- The first line of the scroll region
+ *    Bottom [I] -- The line after the last line of the region (0 = no
+ *                  region, the whole screen scrolls)
+ *
+ * FUNCTION:
+ *    This function sets the top and bottom margins that a new line on the
+ *    bottom margin scrolls between.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    SetAltScreen(), ScrollArea()
+ ******************************************************************************/
+void DisplayBase::SetScrollRegion(uint32_t Top,uint32_t Bottom)
+{
+    /* Does nothing */
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::SetAltScreen
+ *
+ * SYNOPSIS:
+ *    void DisplayBase::SetAltScreen(bool On);
+ *
+ * PARAMETERS:
+ *    On [I] -- Switch to the alternate screen (true) or back to the normal
+ *              screen (false)
+ *
+ * FUNCTION:
+ *    This function switches between the normal and alternate screens.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    SetScrollRegion()
+ ******************************************************************************/
+void DisplayBase::SetAltScreen(bool On)
+{
+    /* Does nothing */
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayBase::ShowBell
@@ -1719,7 +1839,8 @@ void DisplayBase::DoBlock_EditHex(void)
  *
  * FUNCTION:
  *    This function is called when the user changes the mode of block area
- *    at the bottom.
+ *    at the bottom.  It tells the connection so the session picks up the
+ *    change.
  *
  * RETURNS:
  *    NONE
@@ -1745,6 +1866,7 @@ void DisplayBase::DoBlock_RadioBttnChange(void)
     {
         Block_SetHexOrTextMode(true);
     }
+    SendEvent(e_DBEvent_DirectPanelSettingsChanged,NULL);
 }
 
 /*******************************************************************************
@@ -2236,6 +2358,209 @@ uint8_t *DisplayBase::GetSelectionRAW(unsigned int *Bytes)
     return NULL;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::FindBytes
+ *
+ * SYNOPSIS:
+ *    bool DisplayBase::FindBytes(const struct ByteSearchPattern *Pattern);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The bytes to look for (from ByteSearch_ParsePattern())
+ *
+ * FUNCTION:
+ *    This function searches the display for the next match of a byte
+ *    pattern after the current selection.  If it's found it is selected
+ *    and scrolled into view.
+ *
+ *    Only displays that keep the raw bytes (binary) support this.
+ *
+ * RETURNS:
+ *    true -- The pattern was found and selected
+ *    false -- Not found (or not supported by this display)
+ *
+ * SEE ALSO:
+ *    GetSelectionRAW()
+ ******************************************************************************/
+bool DisplayBase::FindBytes(const struct ByteSearchPattern *Pattern)
+{
+    return false;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::GetSelectionLineCount
+ *
+ * SYNOPSIS:
+ *    int DisplayBase::GetSelectionLineCount(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets how many lines the selection covers.  This is used
+ *    to decide if getting the selection string is cheap enough to do right
+ *    away or if it should be done a piece at a time with
+ *    StartSelectionExtract().
+ *
+ *    The default version can't tell so it says 1 line if there is a
+ *    selection.
+ *
+ * RETURNS:
+ *    The number of lines in the selection or 0 if there is no selection.
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+int DisplayBase::GetSelectionLineCount(void)
+{
+    if(!IsThereASelection())
+        return 0;
+    return 1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::StartSelectionExtract
+ *
+ * SYNOPSIS:
+ *    bool DisplayBase::StartSelectionExtract(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function starts getting a copy of the selection text a piece at a
+ *    time.  The range of the selection is remembered here so changing the
+ *    selection after this does not change what GetSelectionChunk() returns.
+ *
+ *    The default version just gets the whole selection string and hands it
+ *    out in pieces.  Displays that can hold a lot of text should replace
+ *    this with a version that walks the buffer.
+ *
+ * RETURNS:
+ *    true -- The extract has started
+ *    false -- There is no selection
+ *
+ * SEE ALSO:
+ *    GetSelectionChunk(), GetSelectionExtractProgress(),
+ *    StopSelectionExtract()
+ ******************************************************************************/
+bool DisplayBase::StartSelectionExtract(void)
+{
+    StopSelectionExtract();
+
+    if(!GetSelectionString(SelExtractBuffer))
+        return false;
+
+    SelExtractPos=0;
+    SelExtractActive=true;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::GetSelectionChunk
+ *
+ * SYNOPSIS:
+ *    bool DisplayBase::GetSelectionChunk(std::string &Chunk,
+ *              unsigned int MaxBytes,bool &Done);
+ *
+ * PARAMETERS:
+ *    Chunk [O] -- The next piece of the selection text.  This may go a little
+ *                 over 'MaxBytes' (displays stop at the end of a line).
+ *    MaxBytes [I] -- About how many bytes to get
+ *    Done [O] -- Set to true when this was the last piece
+ *
+ * FUNCTION:
+ *    This function gets the next piece of the selection text that was
+ *    started with StartSelectionExtract().  Adding all the pieces together
+ *    gives the same string as GetSelectionString().
+ *
+ * RETURNS:
+ *    true -- 'Chunk' has been filled in
+ *    false -- There was an error (the text we where extracting is gone or
+ *             StartSelectionExtract() was not called).  The extract has been
+ *             stopped.
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+bool DisplayBase::GetSelectionChunk(std::string &Chunk,unsigned int MaxBytes,
+        bool &Done)
+{
+    Chunk.clear();
+    Done=false;
+
+    if(!SelExtractActive)
+        return false;
+
+    Chunk.assign(SelExtractBuffer,SelExtractPos,MaxBytes);
+    SelExtractPos+=Chunk.length();
+    if(SelExtractPos>=SelExtractBuffer.length())
+        Done=true;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::GetSelectionExtractProgress
+ *
+ * SYNOPSIS:
+ *    void DisplayBase::GetSelectionExtractProgress(uint64_t *Done,
+ *              uint64_t *Total);
+ *
+ * PARAMETERS:
+ *    Done [O] -- How far we have got.
+ *    Total [O] -- What 'Done' will be when the extract is finished.
+ *
+ * FUNCTION:
+ *    This function gets how far along a selection extract is.  The units
+ *    depend on the display (bytes, lines, ...) so only use the ratio.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+void DisplayBase::GetSelectionExtractProgress(uint64_t *Done,uint64_t *Total)
+{
+    *Done=SelExtractPos;
+    *Total=SelExtractBuffer.length();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::StopSelectionExtract
+ *
+ * SYNOPSIS:
+ *    void DisplayBase::StopSelectionExtract(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function ends a selection extract and frees anything it was
+ *    using.  It is safe to call this even if there isn't an extract running.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+void DisplayBase::StopSelectionExtract(void)
+{
+    SelExtractActive=false;
+    SelExtractPos=0;
+
+    /* Let go of the memory (this can be a big string) */
+    std::string().swap(SelExtractBuffer);
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayBase::AllocateMark
@@ -2457,6 +2782,34 @@ void DisplayBase::ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,
 {
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayBase::ApplyStyleSpans2Mark
+ *
+ * SYNOPSIS:
+ *    void DisplayBase::ApplyStyleSpans2Mark(t_DataProMark *Mark,
+ *              const struct DPS_StyleSpan *Spans,uint32_t Count);
+ *
+ * PARAMETERS:
+ *    Mark [I] -- The mark to work on
+ *    Spans [I] -- The spans to apply
+ *    Count [I] -- The number of entries in 'Spans'
+ *
+ * FUNCTION:
+ *    This function does the DPS_ApplyStyleSpans2Mark() function to the
+ *    display.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_ApplyStyleSpans2Mark()
+ ******************************************************************************/
+void DisplayBase::ApplyStyleSpans2Mark(t_DataProMark *Mark,
+        const struct DPS_StyleSpan *Spans,uint32_t Count)
+{
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayBase::MoveMark
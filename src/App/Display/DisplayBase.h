@@ -59,6 +59,7 @@ typedef enum
     e_DBEvent_Jump2SendBuffersClicked,
     e_DBEvent_SendTextLine,
     e_DBEvent_DirectPanelToggled,
+    e_DBEvent_DirectPanelSettingsChanged,
     e_DBEventMAX
 } e_DBEventType;
 
@@ -136,7 +137,9 @@ class DisplayBase
         virtual bool Init(void *ParentWidget,class ConSettings *SettingsPtr,bool (*EventCallback)(const struct DBEvent *Event),uintptr_t UserData)=0;
         virtual void Reparent(void *NewParentWidget)=0;
         virtual void SetBlockDeviceMode(bool On);
+        void SetPerfStats(struct PerfStatsCon *PS);
         virtual void WriteChar(uint8_t *Chr)=0;
+        virtual void WriteChars(const uint8_t *Chrs,int Count);
         virtual void NoteNonPrintable(const char *NoteStr);
         virtual void SetShowNonPrintable(bool Show);
         virtual void SetShowEndOfLines(bool Show);
@@ -159,6 +162,8 @@ class DisplayBase
         virtual void SetOverrideMessage(const char *Msg);
         virtual void SetInfoMessage(const char *Msg,uint32_t BG,uint32_t FG,e_UITCIM_PosType Pos);
         virtual void ScrollArea(uint32_t X1,uint32_t Y1,uint32_t X2,uint32_t Y2,int32_t dx,int32_t dy);
+        virtual void SetScrollRegion(uint32_t Top,uint32_t Bottom);
+        virtual void SetAltScreen(bool On);
         virtual void InsertHorizontalRule(void);
         virtual void ResetTerm(void);
         virtual void SetupCanvas(void);
@@ -170,6 +175,12 @@ class DisplayBase
         virtual void ApplyBGColor2Selection(uint32_t RGB);
         virtual bool IsAttribSetInSelection(uint32_t Attribs);
         virtual uint8_t *GetSelectionRAW(unsigned int *Bytes);
+        virtual bool FindBytes(const struct ByteSearchPattern *Pattern);
+        virtual int GetSelectionLineCount(void);
+        virtual bool StartSelectionExtract(void);
+        virtual bool GetSelectionChunk(std::string &Chunk,unsigned int MaxBytes,bool &Done);
+        virtual void GetSelectionExtractProgress(uint64_t *Done,uint64_t *Total);
+        virtual void StopSelectionExtract(void);
         virtual t_DataProMark *AllocateMark(void);
         virtual void FreeMark(t_DataProMark *Mark);
         virtual bool IsMarkValid(t_DataProMark *Mark);
@@ -178,6 +189,7 @@ class DisplayBase
         virtual void RemoveAttribFromMark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Offset,uint32_t Len);
         virtual void ApplyFGColor2Mark(t_DataProMark *Mark,uint32_t FGColor,uint32_t Offset,uint32_t Len);
         virtual void ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,uint32_t Offset,uint32_t Len);
+        virtual void ApplyStyleSpans2Mark(t_DataProMark *Mark,const struct DPS_StyleSpan *Spans,uint32_t Count);
         virtual void MoveMark(t_DataProMark *Mark,int Amount);
         virtual const uint8_t *GetMarkString(t_DataProMark *Mark,uint32_t *Size,uint32_t Offset,uint32_t Len);
         virtual void GetScreenSize(uint32_t *Width,uint32_t *Height);
@@ -218,6 +230,7 @@ class DisplayBase
         struct CharStyling CurrentStyle;
 
     protected:
+        struct PerfStatsCon *PerfStats;
         bool InitBase(bool (*EventCallback)(const struct DBEvent *Event),uintptr_t UserData);
         bool (*DBEventHandler)(const struct DBEvent *Event);
         uintptr_t EventHandlerUserData;
@@ -259,6 +272,11 @@ class DisplayBase
         bool TextPanelOpen;
         bool BlockPanelOpen;
         bool LastBlockDeviceSetToBlock;
+
+        /* Selection extract (see StartSelectionExtract()) */
+        bool SelExtractActive;
+        std::string SelExtractBuffer;       // Only used by the default version
+        std::string::size_type SelExtractPos;
 };
 
 /***  GLOBAL VARIABLE DEFINITIONS      ***/
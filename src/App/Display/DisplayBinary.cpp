@@ -30,6 +30,8 @@
  ******************************************************************************/
 
 /*** HEADER FILES TO INCLUDE  ***/
+#include "App/PerfStats.h"
+#include "App/Util/ByteSearch.h"
 #include "App/Settings.h"
 #include "DisplayBinary.h"
 #include "UI/UIDebug.h"
@@ -709,8 +711,11 @@ bool DisplayBinary::DoTextDisplayCtrlEvent(const struct TextDisplayEvent *Event)
         case e_TextDisplayEvent_BlockCloseBttn:
             SetBlockPanelAvailable(false);
         break;
-        case e_TextDisplayEvent_HeadersRearranged:
         case e_TextDisplayEvent_ComboxChange:
+            if(Event->Info.Combox.BoxID==e_UITC_Combox_BlockSend_LineEnd)
+                SendEvent(e_DBEvent_DirectPanelSettingsChanged,NULL);
+        break;
+        case e_TextDisplayEvent_HeadersRearranged:
         case e_TextDisplayEventMAX:
         default:
             return true;
@@ -959,7 +964,9 @@ void DisplayBinary::RedrawCurrentLine(void)
     if(y>=DisplayLines)
         return;
 
+    PERFSTATS_TIMESTAMP(PaintStart);
     DrawLine(BottomOfBufferLine,ColorBottomOfBufferLine,y,InsertPoint);
+    PERFSTATS_STAGE_DONE(PerfStats,e_PerfStage_Paint,PaintStart);
 }
 
 /*******************************************************************************
@@ -991,6 +998,8 @@ void DisplayBinary::RedrawScreen(void)
     unsigned int r;
     unsigned int Lines;
 
+    PERFSTATS_TIMESTAMP(PaintStart);
+
     StartOfLine=TopLine;
     ColorStartOfLine=ColorTopLine;
     for(y=0;y<DisplayLines;y++)
@@ -1028,6 +1037,8 @@ void DisplayBinary::RedrawScreen(void)
                     x,0,x,ScreenHeightPx,Settings->BinaryHexDivColor);
         }
     }
+
+    PERFSTATS_STAGE_DONE(PerfStats,e_PerfStage_Paint,PaintStart);
 }
 
 /*******************************************************************************
@@ -3438,6 +3449,168 @@ uint8_t *DisplayBinary::GetSelectionRAW(unsigned int *Bytes)
     return RetBuff;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayBinary::FindBytes
+ *
+ * SYNOPSIS:
+ *    bool DisplayBinary::FindBytes(const struct ByteSearchPattern *Pattern);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The bytes to look for (from ByteSearch_ParsePattern())
+ *
+ * FUNCTION:
+ *    This function searches the buffer for the next match of a pattern.  The
+ *    search starts 1 byte after the start of the selection (or at the top of
+ *    the display if there isn't one) and wraps around to the oldest byte.
+ *    If a match is found it is selected and scrolled into view.
+ *
+ *    The search is done right on 'HexBuffer' so there's no copy of the
+ *    scroll back made (matches that cross the end of the circular buffer are
+ *    still found).
+ *
+ * RETURNS:
+ *    true -- The pattern was found and selected
+ *    false -- The pattern was not found.
+ *
+ * SEE ALSO:
+ *    ByteSearch_FindNextInRing(), MakeOffsetVisable()
+ ******************************************************************************/
+bool DisplayBinary::FindBytes(const struct ByteSearchPattern *Pattern)
+{
+    struct DisBin_PointPair Point;
+    struct DisBin_PointPair Anchor;
+    uint32_t DataBytes;
+    uint32_t SelOffset;
+    uint32_t AnchorOffset;
+    uint32_t From;
+    int64_t Found;
+
+    if(HexBuffer==NULL || TopOfBufferLine==NULL || Pattern->Len<1)
+        return false;
+
+    Point.Line=BottomOfBufferLine;
+    Point.Offset=InsertPoint;
+    DataBytes=ConvertPoint2Offset(&Point);
+    if(DataBytes==0)
+        return false;
+
+    if(SelectionActive && SelectionLine!=NULL && SelectionAnchorLine!=NULL)
+    {
+        Point.Line=SelectionLine;
+        Point.Offset=SelectionLineOffset;
+        Anchor.Line=SelectionAnchorLine;
+        Anchor.Offset=SelectionLineAnchorOffset;
+        SelOffset=ConvertPoint2Offset(&Point);
+        AnchorOffset=ConvertPoint2Offset(&Anchor);
+        if(AnchorOffset<SelOffset)
+            SelOffset=AnchorOffset;
+        From=SelOffset+1;
+    }
+    else
+    {
+        Point.Line=TopLine;
+        Point.Offset=0;
+        From=ConvertPoint2Offset(&Point);
+    }
+    if(From>=DataBytes)
+        From=0;
+
+    Found=ByteSearch_FindNextInRing(Pattern,HexBuffer,HexBufferSize,
+            TopOfBufferLine-HexBuffer,DataBytes,From);
+    if(Found<0)
+        return false;
+
+    ConvertOffset2Point(Found,&Anchor);
+    ConvertOffset2Point(Found+Pattern->Len-1,&Point);
+
+    SelectionInAscII=(Pattern->Type!=e_ByteSearchPattern_Hex);
+    SelectionActive=true;
+    SelectionAnchorLine=Anchor.Line;
+    SelectionLineAnchorOffset=Anchor.Offset;
+    SelectionLine=Point.Line;
+    SelectionLineOffset=Point.Offset;
+
+    MakeOffsetVisable(Found,SelectionInAscII);
+
+    RedrawScreen();
+
+    SendEvent(e_DBEvent_SelectionChanged,NULL);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayBinary::MakeOffsetVisable
+ *
+ * SYNOPSIS:
+ *    void DisplayBinary::MakeOffsetVisable(uint32_t Offset,bool InAscII);
+ *
+ * PARAMETERS:
+ *    Offset [I] -- The offset from 'TopOfBufferLine' to scroll into view
+ *    InAscII [I] -- Show the AscII column for this byte (false = the hex)
+ *
+ * FUNCTION:
+ *    This function moves the scroll bars (if needed) so a byte is on the
+ *    screen.  The scroll bar events move 'TopLine' and redraw.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ScrollScreen(), ConvertPoint2Offset()
+ ******************************************************************************/
+void DisplayBinary::MakeOffsetVisable(uint32_t Offset,bool InAscII)
+{
+    t_UIScrollBarCtrl *HorzScroll;
+    t_UIScrollBarCtrl *VertScroll;
+    struct DisBin_PointPair Point;
+    int OffsetLine;
+    int TopLineNum;
+    int OffsetChar;
+    int ScreenChars;
+    int LeftChar;
+
+    if(TextDisplayCtrl==NULL || DisplayBytesPerLine==0)
+        return;
+
+    HorzScroll=UITC_GetHorzSlider(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl));
+    VertScroll=UITC_GetVertSlider(TextDisplayCtrl);
+
+    /* Vert */
+    Point.Line=TopLine;
+    Point.Offset=0;
+    TopLineNum=ConvertPoint2Offset(&Point)/DisplayBytesPerLine;
+    OffsetLine=Offset/DisplayBytesPerLine;
+    if(OffsetLine<TopLineNum || OffsetLine>=TopLineNum+DisplayLines)
+    {
+        /* Put it 1/3 of the way down so you can see what's around it */
+        TopLineNum=OffsetLine-DisplayLines/3;
+        if(TopLineNum<0)
+            TopLineNum=0;
+        UISetScrollBarPos(VertScroll,TopLineNum);
+    }
+
+    /* Horz */
+    if(CharWidthPx<=0)
+        return;
+    ScreenChars=ScreenWidthPx/CharWidthPx;
+    LeftChar=WindowXOffsetPx/CharWidthPx;
+    if(InAscII)
+        OffsetChar=START_OF_ASCII_CHAR+Offset%DisplayBytesPerLine;
+    else
+        OffsetChar=(Offset%DisplayBytesPerLine)*3;
+    if(OffsetChar<LeftChar || OffsetChar+3>LeftChar+ScreenChars)
+    {
+        LeftChar=OffsetChar-ScreenChars/2;
+        if(LeftChar<0)
+            LeftChar=0;
+        WindowXOffsetPx=LeftChar*CharWidthPx;
+        UISetScrollBarPos(HorzScroll,LeftChar);
+    }
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayBinary::InvalidateAllMarks
@@ -4030,6 +4203,126 @@ void DisplayBinary::ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,
     RedrawScreen();
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayBinary::ApplyStyleSpans2Mark
+ *
+ * SYNOPSIS:
+ *    void DisplayBinary::ApplyStyleSpans2Mark(t_DataProMark *Mark,
+ *              const struct DPS_StyleSpan *Spans,uint32_t Count);
+ *
+ * PARAMETERS:
+ *    Mark [I] -- The mark to work on
+ *    Spans [I] -- The spans to apply
+ *    Count [I] -- The number of entries in 'Spans'
+ *
+ * FUNCTION:
+ *    This function does the DPS_ApplyStyleSpans2Mark() function to the
+ *    display.
+ *
+ *    Each span is filled into the color buffer in one pass (all the parts
+ *    of the style at once) and the screen is only redrawn at the end.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_ApplyStyleSpans2Mark()
+ ******************************************************************************/
+void DisplayBinary::ApplyStyleSpans2Mark(t_DataProMark *Mark,
+        const struct DPS_StyleSpan *Spans,uint32_t Count)
+{
+    struct BinaryPointMarker *Marker=(struct BinaryPointMarker *)Mark;
+    struct DisBin_PointPair P1;
+    struct DisBin_PointPair P2;
+    struct DisBin_Block Blocks[2];
+    struct CharStyling *ColStart;
+    struct CharStyling *ColEnd;
+    struct CharStyling *FillPos;
+    const struct DPS_StyleSpan *Span;
+    uint32_t SetAttribs;
+    uint32_t KeepAttribs;
+    uint32_t Span2Do;
+    int s;
+
+    if(!Marker->Valid || Count==0)
+        return;
+
+    for(Span2Do=0;Span2Do<Count;Span2Do++)
+    {
+        Span=&Spans[Span2Do];
+
+        P1.Line=Marker->Line;
+        P1.Offset=Marker->Offset;
+        AdvancePoint(&P1,Span->Offset);
+
+        if(Span->Len==0)
+        {
+            P2.Line=BottomOfBufferLine;
+            P2.Offset=InsertPoint;
+        }
+        else
+        {
+            P2.Line=P1.Line;
+            P2.Offset=P1.Offset;
+            AdvancePoint(&P2,Span->Len);
+        }
+
+        GetNormalizedPoints(&P1,&P2,Blocks);
+
+        /* Work out the attribs once so the fill is just an and and an or */
+        SetAttribs=0;
+        KeepAttribs=~0;
+        if(Span->What&DPS_STYLESPAN_SET_ATTRIBS)
+            SetAttribs=Span->Attribs;
+        if(Span->What&DPS_STYLESPAN_CLR_ATTRIBS)
+            KeepAttribs=~Span->Attribs;
+
+        for(s=0;s<2;s++)
+        {
+            if(Blocks[s].Start.Line==NULL || Blocks[s].End.Line==NULL)
+                break;
+
+            /* Get the pointers into the color buffers for this selection */
+            ColStart=GetColorPtrFromLinePtr(&Blocks[s].Start.Line[
+                    Blocks[s].Start.Offset]);
+            ColEnd=GetColorPtrFromLinePtr(&Blocks[s].End.Line[
+                    Blocks[s].End.Offset]);
+
+            if((Span->What&(DPS_STYLESPAN_FGCOLOR|DPS_STYLESPAN_BGCOLOR))==
+                    (DPS_STYLESPAN_FGCOLOR|DPS_STYLESPAN_BGCOLOR))
+            {
+                /* The common case (both colors), no tests in the loop */
+                for(FillPos=ColStart;FillPos<=ColEnd;FillPos++)
+                {
+                    FillPos->Attribs=(FillPos->Attribs|SetAttribs)&
+                            KeepAttribs;
+                    FillPos->FGColor=Span->FGColor;
+                    FillPos->ULineColor=Span->FGColor;
+                    FillPos->BGColor=Span->BGColor;
+                }
+            }
+            else
+            {
+                for(FillPos=ColStart;FillPos<=ColEnd;FillPos++)
+                {
+                    FillPos->Attribs=(FillPos->Attribs|SetAttribs)&
+                            KeepAttribs;
+                    if(Span->What&DPS_STYLESPAN_FGCOLOR)
+                    {
+                        FillPos->FGColor=Span->FGColor;
+                        FillPos->ULineColor=Span->FGColor;
+                    }
+                    if(Span->What&DPS_STYLESPAN_BGCOLOR)
+                        FillPos->BGColor=Span->BGColor;
+                }
+            }
+        }
+    }
+
+    RedrawScreen();
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayBinary::MoveMark
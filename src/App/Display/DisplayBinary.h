@@ -100,6 +100,7 @@ class DisplayBinary : public DisplayBase
         void ApplyBGColor2Selection(uint32_t RGB);
         bool IsAttribSetInSelection(uint32_t Attribs);
         uint8_t *GetSelectionRAW(unsigned int *Bytes);
+        bool FindBytes(const struct ByteSearchPattern *Pattern);
         void GetScreenSize(uint32_t *Width,uint32_t *Height);
 
         t_DataProMark *AllocateMark(void);
@@ -110,6 +111,7 @@ class DisplayBinary : public DisplayBase
         void RemoveAttribFromMark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Offset,uint32_t Len);
         void ApplyFGColor2Mark(t_DataProMark *Mark,uint32_t FGColor,uint32_t Offset,uint32_t Len);
         void ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,uint32_t Offset,uint32_t Len);
+        void ApplyStyleSpans2Mark(t_DataProMark *Mark,const struct DPS_StyleSpan *Spans,uint32_t Count);
         void MoveMark(t_DataProMark *Mark,int Amount);
         const uint8_t *GetMarkString(t_DataProMark *Mark,uint32_t *Size,uint32_t Offset,uint32_t Len);
 
@@ -217,6 +219,7 @@ class DisplayBinary : public DisplayBase
         uint32_t ConvertPoint2Offset(struct DisBin_PointPair *Point);
         void ConvertOffset2Point(uint32_t Offset,struct DisBin_PointPair *Point);
         void AdvancePoint(struct DisBin_PointPair *Point,int Amount);
+        void MakeOffsetVisable(uint32_t Offset,bool InAscII);
 };
 
 /***  GLOBAL VARIABLE DEFINITIONS      ***/
@@ -30,8 +30,10 @@
  ******************************************************************************/
 
 /*** HEADER FILES TO INCLUDE  ***/
+#include "App/PerfStats.h"
 #include "App/Settings.h"
 #include "App/Util/TextStyleHelpers.h"
+#include "App/Util/UnicodeWidth.h"
 #include "DisplayText.h"
 #include "UI/UIDebug.h"
 #include "UI/UISystem.h"
@@ -41,6 +43,7 @@
 #include <string>
 #include <limits.h>
 #include <stdio.h>
+#include <algorithm>
 
 using namespace std;
 
@@ -49,6 +52,10 @@ using namespace std;
 
 #define SELECTION_SCROLL_SPEED_TIMER            50 // ms
 
+/* When 'LinesBase' gets this big we move everything back down to 0 so it
+   can't wrap */
+#define LINESBASE_REBASE_AT                     (1<<30)
+
 /*** MACROS                   ***/
 
 /*** TYPE DEFINITIONS         ***/
@@ -58,6 +65,7 @@ bool DisplayText_EventHandlerCB(const struct TextDisplayEvent *Event);
 void DisplayText_ScrollTimer_Timeout(uintptr_t UserData);
 
 /*** VARIABLE DEFINITIONS     ***/
+static uint32_t m_CanvasLineGeneration;
 
 /*******************************************************************************
  * NAME:
@@ -158,6 +166,7 @@ DisplayText::DisplayText()
     CharWidthPx=1;
     CharHeightPx=1;
     LeftMouseDown=false;
+    ResetCharWidthCache();
 
     ShowNonPrintables=false;
     ShowEndOfLines=false;
@@ -174,10 +183,24 @@ DisplayText::DisplayText()
     Selection_AnchorY=0;
     SelectMode=e_DTSelectModeMAX;
 
+    SelExtract_FirstY=0;
+    SelExtract_EndX=0;
+    SelExtract_EndY=0;
+    SelExtract_NextX=0;
+    SelExtract_NextY=0;
+
+    LinesBase=0;
+    CanvasTopLineAbsY=-1;
+    CanvasLinesDrawn=0;
+
     ScrollTimer=NULL;
 
     LastSeenLF=false;
     LastSeenCR=false;
+
+    ScrollRegionTop=0;
+    ScrollRegionBottom=0;
+    AltScreenActive=false;
 }
 
 /*******************************************************************************
@@ -289,7 +312,13 @@ bool DisplayText::Init(void *ParentWidget,class ConSettings *SettingsPtr,
         FontItalic=Settings->FontItalic;
 
         Lines.clear();
+        LineWidthCounts.clear();
+        LongestLinePx=0;
         LinesCount=0;
+        LinesBase=0;
+        CanvasTopLineAbsY=-1;
+        AltSavedScreen.clear();
+        AltScreenActive=false;
         FirstLine.LineWidthPx=0;
         FirstLine.LineBackgroundColor=
                 Settings->DefaultColors[e_DefaultColors_BG];
@@ -576,6 +605,9 @@ break;
             SetBlockPanelAvailable(false);
         break;
         case e_TextDisplayEvent_ComboxChange:
+            if(Event->Info.Combox.BoxID==e_UITC_Combox_TextSend_LineEnd)
+                SendEvent(e_DBEvent_DirectPanelSettingsChanged,NULL);
+        break;
         case e_TextDisplayEventMAX:
         default:
             return true;
@@ -636,8 +668,8 @@ void DisplayText::HandleLeftMousePress(bool Down,int x,int y)
         }
         Selection_X=XChars;
         Selection_AnchorX=XChars;
-        Selection_Y=YChars;
-        Selection_AnchorY=YChars;
+        Selection_Y=LinesBase+YChars;
+        Selection_AnchorY=LinesBase+YChars;
 
 ///* DEBUG PAUL: This is for word select (double click) */
 //SelectionActive=true;
@@ -707,6 +739,8 @@ void DisplayText::HandleLeftMouseDoublePress(int x,int y)
            though instead of having to be all the way through */
         ConvertScreenXY2Chars(x+CharWidthPx/2,y,&XChars,&YChars);
     }
+    YChars+=LinesBase;
+
     Selection_X=XChars;
     Selection_AnchorX=XChars;
     Selection_Y=YChars;
@@ -763,6 +797,7 @@ void DisplayText::HandleLeftMouseTriplePress(int x,int y)
     SelectMode=e_DTSelectMode_Line;
 
     ConvertScreenXY2Chars(x,y,&XChars,&YChars);
+    YChars+=LinesBase;
 
     Selection_StartX1=XChars;
     Selection_StartY1=YChars;
@@ -843,6 +878,7 @@ void DisplayText::HandleMouseMove(int x,int y)
         /* We add 1/2 a char so we select the whole char when we are half way
            though instead of having to be all the way through */
         ConvertScreenXY2Chars(x+CharWidthPx/2,y,&XChars,&YChars);
+        YChars+=LinesBase;
 
         switch(SelectMode)
         {
@@ -1005,6 +1041,9 @@ void DisplayText::SetupCanvas(void)
     if(CharHeightPx<1)
         CharHeightPx=1;
 
+    /* The font may have changed so all the char widths are out of date */
+    ResetCharWidthCache();
+
     RethinkTextAreaSize();
     RethinkWindowSize();
     RethinkLineLengths();
@@ -1033,7 +1072,6 @@ void DisplayText::SetupCanvas(void)
 void DisplayText::RedrawActiveLine(void)
 {
     int LineLenPx;
-    bool LookupLongest;
 
     if(ActiveLine==NULL || TextDisplayCtrl==NULL)
         return;
@@ -1041,26 +1079,16 @@ void DisplayText::RedrawActiveLine(void)
     if(!CursorLineVisible())
         return;
 
+    PERFSTATS_TIMESTAMP(PaintStart);
     LineLenPx=DrawLine(ActiveLineY,CalcCorrectedCursorPos(),ActiveLine);
+    PERFSTATS_STAGE_DONE(PerfStats,e_PerfStage_Paint,PaintStart);
 
     /* Redo the line len for this line if it changed.  We do this because here
        instead of a function that just does this because we have the info
        already ready and we save having to recal the value. */
     if(ActiveLine->LineWidthPx!=LineLenPx)
     {
-        /* If were the longest line and we got longer then just set us as
-           the longest line.  Otherwize we need to refind the longest line */
-        LookupLongest=false;
-        if(LongestLinePx==ActiveLine->LineWidthPx && LineLenPx>=LongestLinePx)
-            LongestLinePx=LineLenPx;
-        else
-            LookupLongest=true;
-
-        ActiveLine->LineWidthPx=LineLenPx;
-
-        if(LookupLongest)
-            ReFindLongestLineLength();
-
+        SetLineWidthPx(ActiveLine,LineLenPx);
         RethinkScrollBars();
     }
 }
@@ -1186,9 +1214,9 @@ int DisplayText::DrawLine(int LineY,int ScreenLine,struct TextLine *Line)
     }
 
     /* Redraw the line */
-    UITC_Begin(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),ScreenLine);
-    UITC_ClearLine(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-            Line->LineBackgroundColor);
+    CanvasLineBuild.BGColor=Line->LineBackgroundColor;
+    CanvasLineBuild.Text.clear();
+    CanvasLineBuild.Runs.clear();
 
     LineLenPx=0;
     for(CurFrag=Line->Frags.begin(),FragIndex=0;CurFrag!=Line->Frags.end();
@@ -1216,7 +1244,7 @@ int DisplayText::DrawLine(int LineY,int ScreenLine,struct TextLine *Line)
             {
                 if(Marker->Valid)
                 {
-                    if(LineY==Marker->Y)
+                    if(LineY==Marker->Y-LinesBase)
                     {
                         if(Marker->X>=DebugX &&
                                 Marker->X<=DebugX+(int)CurFrag->Text.length())
@@ -1258,8 +1286,7 @@ int DisplayText::DrawLine(int LineY,int ScreenLine,struct TextLine *Line)
             }
             TmpStr.erase(StartOfStr,TmpStr.end());
             DisplayFrag.Text=TmpStr.c_str();
-            UITC_AddFragment(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                    &DisplayFrag);
+            AddCanvasRun(&DisplayFrag);
 
             /* Place things so the end of the string is in this fragment */
             DisplayFrag.Text=TmpStr2.c_str();
@@ -1316,8 +1343,7 @@ int DisplayText::DrawLine(int LineY,int ScreenLine,struct TextLine *Line)
             DisplayFrag.Styling.FGColor=Settings->SelectionColors[e_Color_FG];
             DisplayFrag.Styling.BGColor=Settings->SelectionColors[e_Color_BG];
             DisplayFrag.Styling.Attribs=TXT_ATTRIB_FORCE;
-            UITC_AddFragment(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                    &DisplayFrag);
+            AddCanvasRun(&DisplayFrag);
 
             /* Restore the color */
             DisplayFrag.Styling.FGColor=SavedFGColor;
@@ -1336,8 +1362,7 @@ int DisplayText::DrawLine(int LineY,int ScreenLine,struct TextLine *Line)
             DisplayFrag.Styling.Attribs=TXT_ATTRIB_FORCE;
         }
 
-        UITC_AddFragment(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                &DisplayFrag);
+        AddCanvasRun(&DisplayFrag);
 
         LineLenPx+=CurFrag->WidthPx;
     }
@@ -1368,9 +1393,7 @@ int DisplayText::DrawLine(int LineY,int ScreenLine,struct TextLine *Line)
             }
             if(DisplayFrag.FragType!=e_TextCanvasFragMAX)
             {
-                UITC_AddFragment(
-                        UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                        &DisplayFrag);
+                AddCanvasRun(&DisplayFrag);
                 LineLenPx+=UITC_GetFragWidth(
                         UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
                         &DisplayFrag);
@@ -1417,9 +1440,7 @@ int DisplayText::DrawLine(int LineY,int ScreenLine,struct TextLine *Line)
 
             if(DisplayFrag.FragType!=e_TextCanvasFragMAX)
             {
-                UITC_AddFragment(
-                        UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                        &DisplayFrag);
+                AddCanvasRun(&DisplayFrag);
                 LineLenPx+=UITC_GetFragWidth(
                         UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
                         &DisplayFrag);
@@ -1446,9 +1467,7 @@ int DisplayText::DrawLine(int LineY,int ScreenLine,struct TextLine *Line)
 
             if(DisplayFrag.FragType!=e_TextCanvasFragMAX)
             {
-                UITC_AddFragment(
-                        UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                        &DisplayFrag);
+                AddCanvasRun(&DisplayFrag);
                 LineLenPx+=UITC_GetFragWidth(
                         UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
                         &DisplayFrag);
@@ -1457,11 +1476,156 @@ int DisplayText::DrawLine(int LineY,int ScreenLine,struct TextLine *Line)
 
     }
 
-    UITC_End(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl));
+    SendCanvasLine(ScreenLine);
 
     return LineLenPx;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::AddCanvasRun
+ *
+ * SYNOPSIS:
+ *    void DisplayText::AddCanvasRun(const struct TextCanvasFrag *Frag);
+ *
+ * PARAMETERS:
+ *    Frag [I] -- The fragment to add to the line we are building
+ *
+ * FUNCTION:
+ *    This function adds a fragment to the end of 'CanvasLineBuild' as a new
+ *    run.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::DrawLine(), DisplayText::SendCanvasLine()
+ ******************************************************************************/
+void DisplayText::AddCanvasRun(const struct TextCanvasFrag *Frag)
+{
+    struct TextCanvasLineRun NewRun;
+
+    NewRun.FragType=Frag->FragType;
+    NewRun.Offset=CanvasLineBuild.Text.length();
+    NewRun.Len=strlen(Frag->Text);
+    NewRun.Styling=Frag->Styling;
+    NewRun.Value=Frag->Value;
+    NewRun.Data=Frag->Data;
+
+    CanvasLineBuild.Text.append(Frag->Text,NewRun.Len);
+    CanvasLineBuild.Runs.push_back(NewRun);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::CanvasLineMatches
+ *
+ * SYNOPSIS:
+ *    bool DisplayText::CanvasLineMatches(
+ *              const struct TextCanvasLine *Snapshot);
+ *
+ * PARAMETERS:
+ *    Snapshot [I] -- The snapshot to compare with 'CanvasLineBuild'
+ *
+ * FUNCTION:
+ *    This function checks if a line snapshot has the same thing in it
+ *    as the line we just built in 'CanvasLineBuild'.
+ *
+ * RETURNS:
+ *    true -- They are the same
+ *    false -- They are different
+ *
+ * SEE ALSO:
+ *    DisplayText::SendCanvasLine()
+ ******************************************************************************/
+bool DisplayText::CanvasLineMatches(const struct TextCanvasLine *Snapshot)
+{
+    const struct TextCanvasLineRun *A;
+    const struct TextCanvasLineRun *B;
+    unsigned int r;
+
+    if(Snapshot->BGColor!=CanvasLineBuild.BGColor ||
+            Snapshot->Runs.size()!=CanvasLineBuild.Runs.size() ||
+            Snapshot->Text!=CanvasLineBuild.Text)
+    {
+        return false;
+    }
+
+    for(r=0;r<CanvasLineBuild.Runs.size();r++)
+    {
+        A=&Snapshot->Runs[r];
+        B=&CanvasLineBuild.Runs[r];
+        if(A->FragType!=B->FragType || A->Offset!=B->Offset ||
+                A->Len!=B->Len || A->Value!=B->Value || A->Data!=B->Data ||
+                !CmpCharStyle(&A->Styling,&B->Styling))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::SendCanvasLine
+ *
+ * SYNOPSIS:
+ *    void DisplayText::SendCanvasLine(int ScreenLine);
+ *
+ * PARAMETERS:
+ *    ScreenLine [I] -- The screen line 'CanvasLineBuild' goes on
+ *
+ * FUNCTION:
+ *    This function takes the line we built in 'CanvasLineBuild' and sends
+ *    it to the canvas.
+ *
+ *    If it is the same as the last snapshot we sent for this screen line
+ *    then we resend that snapshot (with the same generation) so the canvas
+ *    can skip converting it again.  Otherwise we make a new snapshot with a
+ *    new generation.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::DrawLine(), UITC_SetLine()
+ ******************************************************************************/
+void DisplayText::SendCanvasLine(int ScreenLine)
+{
+    std::shared_ptr<struct TextCanvasLine> NewSnapshot;
+
+    if(ScreenLine<0)
+        return;
+
+    if((unsigned int)ScreenLine>=CanvasRows.size())
+        CanvasRows.resize(ScreenLine+1);
+
+    if(CanvasRows[ScreenLine]==NULL ||
+            !CanvasLineMatches(CanvasRows[ScreenLine].get()))
+    {
+        try
+        {
+            NewSnapshot=std::make_shared<struct TextCanvasLine>(
+                    CanvasLineBuild);
+        }
+        catch(std::bad_alloc const &)
+        {
+            return;
+        }
+
+        /* 0 is used for "no snapshot" */
+        m_CanvasLineGeneration++;
+        if(m_CanvasLineGeneration==0)
+            m_CanvasLineGeneration++;
+        NewSnapshot->Generation=m_CanvasLineGeneration;
+
+        CanvasRows[ScreenLine]=NewSnapshot;
+    }
+
+    UITC_SetLine(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
+            ScreenLine,CanvasRows[ScreenLine]);
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayText::RedrawFullScreen
@@ -1485,7 +1649,6 @@ void DisplayText::RedrawFullScreen(void)
 {
     i_TextLines CurLine;
     i_TextLineFrags CurFrag;
-    bool LineLenChanged;
     int LineLenPx;
     int y;
     uint32_t AreaBGColor;
@@ -1493,16 +1656,13 @@ void DisplayText::RedrawFullScreen(void)
     if(ActiveLine==NULL || TextDisplayCtrl==NULL)
         return;
 
-    LineLenChanged=false;
+    PERFSTATS_TIMESTAMP(PaintStart);
+
     for(y=0,CurLine=TopLine;y<WindowHeightChars && CurLine!=Lines.end();
             CurLine++,y++)
     {
         LineLenPx=DrawLine(TopLineY+y,y,&*CurLine);
-        if(CurLine->LineWidthPx!=LineLenPx)
-        {
-            LineLenChanged=true;
-            CurLine->LineWidthPx=LineLenPx;
-        }
+        SetLineWidthPx(&*CurLine,LineLenPx);
     }
 
     /* Set the bottom color to the last line */
@@ -1523,9 +1683,161 @@ void DisplayText::RedrawFullScreen(void)
     UITC_SetMaxLines(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),y,
             Settings->DefaultColors[e_DefaultColors_BG]);
 
-    if(LineLenChanged)
-        ReFindLongestLineLength();
+    /* Note what is on the canvas so RedrawAfterScroll() can scroll it */
+    CanvasTopLineAbsY=LinesBase+TopLineY;
+    CanvasLinesDrawn=y;
+
+    RethinkScrollBars();
+
+    PERFSTATS_STAGE_DONE(PerfStats,e_PerfStage_Paint,PaintStart);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::RedrawAfterScroll
+ *
+ * SYNOPSIS:
+ *    void DisplayText::RedrawAfterScroll(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function updates the screen after new lines have been scrolled
+ *    on.  If the canvas is full and 'TopLine' has only moved down a little
+ *    since the last full redraw then the canvas is scrolled (blit) and only
+ *    the lines that came into view (and the line above them) are redrawn.
+ *    Otherwise it does a RedrawFullScreen().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::RedrawFullScreen(), DisplayText::ScrollScreenByXLines()
+ ******************************************************************************/
+void DisplayText::RedrawAfterScroll(void)
+{
+    t_UITextDisplayColumn *Column;
+    i_TextLines CurLine;
+    int LineLenPx;
+    int Delta;
+    int FirstRedrawY;
+    int y;
+
+    if(ActiveLine==NULL || TextDisplayCtrl==NULL)
+        return;
+
+    Delta=LinesBase+TopLineY-CanvasTopLineAbsY;
+    if(CanvasTopLineAbsY<0 || Delta<=0 || Delta>=WindowHeightChars ||
+            CanvasLinesDrawn!=WindowHeightChars ||
+            LinesCount-TopLineY<WindowHeightChars)
+    {
+        RedrawFullScreen();
+        return;
+    }
+
+    PERFSTATS_TIMESTAMP(PaintStart);
+
+    Column=UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl);
+    UITC_ScrollLines(Column,Delta);
+
+    /* Our copy of what snapshot is on what screen line moves with it */
+    if((unsigned int)Delta<CanvasRows.size())
+    {
+        std::rotate(CanvasRows.begin(),CanvasRows.begin()+Delta,
+                CanvasRows.end());
+    }
+
+    /* Redraw the new lines (and the one above them, it was the bottom line
+       and may have changed) */
+    FirstRedrawY=WindowHeightChars-Delta-1;
+    CurLine=TopLine;
+    for(y=0;y<FirstRedrawY;y++)
+        CurLine++;
+
+    for(;y<WindowHeightChars && CurLine!=Lines.end();CurLine++,y++)
+    {
+        LineLenPx=DrawLine(TopLineY+y,y,&*CurLine);
+        SetLineWidthPx(&*CurLine,LineLenPx);
+    }
+
+    UITC_SetTextAreaBackgroundColor(Column,Lines.back().LineBackgroundColor);
+
+    CanvasTopLineAbsY=LinesBase+TopLineY;
+
     RethinkScrollBars();
+
+    PERFSTATS_STAGE_DONE(PerfStats,e_PerfStage_Paint,PaintStart);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::RedrawScreenLines
+ *
+ * SYNOPSIS:
+ *    void DisplayText::RedrawScreenLines(int FirstY,int EndY);
+ *
+ * PARAMETERS:
+ *    FirstY [I] -- The first screen line to redraw (0 = 'ScreenFirstLine')
+ *    EndY [I] -- The screen line after the last one to redraw
+ *
+ * FUNCTION:
+ *    This function redraws a range of lines on the screen (the part of the
+ *    buffer the cursor can move around in) that changed without the rest of
+ *    the lines moving, like when a scroll region scrolls.  Lines that are not
+ *    in the window are skipped.  If the canvas isn't showing the same lines
+ *    as the last full redraw it does a RedrawFullScreen() instead.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::RedrawFullScreen(), DisplayText::MoveToNextLine()
+ ******************************************************************************/
+void DisplayText::RedrawScreenLines(int FirstY,int EndY)
+{
+    i_TextLines CurLine;
+    int ScreenFirstLineY;
+    int LinesInWindow;
+    int LineLenPx;
+    int LineY;
+    int y;
+
+    if(ActiveLine==NULL || TextDisplayCtrl==NULL)
+        return;
+
+    LinesInWindow=LinesCount-TopLineY;
+    if(LinesInWindow>WindowHeightChars)
+        LinesInWindow=WindowHeightChars;
+    if(CanvasTopLineAbsY!=LinesBase+TopLineY ||
+            CanvasLinesDrawn!=LinesInWindow)
+    {
+        RedrawFullScreen();
+        return;
+    }
+
+    PERFSTATS_TIMESTAMP(PaintStart);
+
+    if(LinesCount<ScreenHeightChars)
+        ScreenFirstLineY=0;
+    else
+        ScreenFirstLineY=LinesCount-ScreenHeightChars;
+
+    CurLine=ScreenFirstLine;
+    for(y=0;y<FirstY && CurLine!=Lines.end();y++)
+        CurLine++;
+
+    for(;y<EndY && CurLine!=Lines.end();y++,CurLine++)
+    {
+        LineY=ScreenFirstLineY+y;
+        if(LineY<TopLineY || LineY>=TopLineY+WindowHeightChars)
+            continue;
+
+        LineLenPx=DrawLine(LineY,LineY-TopLineY,&*CurLine);
+        SetLineWidthPx(&*CurLine,LineLenPx);
+    }
+
+    PERFSTATS_STAGE_DONE(PerfStats,e_PerfStage_Paint,PaintStart);
 }
 
 /*******************************************************************************
@@ -1673,6 +1985,7 @@ void DisplayText::RethinkLineLengths(void)
     i_TextLineFrags CurFrag;
     int LineLenPx;
 
+    LineWidthCounts.clear();
     LongestLinePx=0;
     for(CurLine=Lines.begin();CurLine!=Lines.end();CurLine++)
     {
@@ -1688,9 +2001,7 @@ void DisplayText::RethinkLineLengths(void)
         LineLenPx+=GetLineEndSize(&*CurLine);
 
         CurLine->LineWidthPx=LineLenPx;
-
-        if(LineLenPx>LongestLinePx)
-            LongestLinePx=LineLenPx;
+        AddLineWidth(LineLenPx);
     }
 }
 
@@ -1705,87 +2016,246 @@ void DisplayText::RethinkLineLengths(void)
  *    NONE
  *
  * FUNCTION:
- *    This function goes though all the lines and recal's the 'LongestLinePx'
+ *    This function recal's the 'LongestLinePx' from the 'LineWidthCounts'
+ *    histogram.  The longest line is just the biggest width that still has
+ *    a line in it so this doesn't have to look at the lines at all.
  *
  * RETURNS:
  *    NONE
  *
  * NOTES:
- *    This is like RethinkLineLengths() but does not figure out the line
- *    lengths but instead uses the precalculated 'LineWidthPx' for each line,
- *    there by making this much quicker.
+ *    This used to walk all the lines, which with a big scroll back buffer
+ *    meant every char typed into the longest line cost a walk of the whole
+ *    buffer.
  *
  * SEE ALSO:
- *    RethinkLineLengths()
+ *    RethinkLineLengths(), SetLineWidthPx()
  ******************************************************************************/
 void DisplayText::ReFindLongestLineLength(void)
 {
-    i_TextLines CurLine;
-    i_TextLineFrags CurFrag;
-
-    LongestLinePx=0;
-    for(CurLine=Lines.begin();CurLine!=Lines.end();CurLine++)
-    {
-        if(CurLine->LineWidthPx>LongestLinePx)
-            LongestLinePx=CurLine->LineWidthPx;
-    }
+    if(LineWidthCounts.empty())
+        LongestLinePx=0;
+    else
+        LongestLinePx=LineWidthCounts.rbegin()->first;
 }
 
 /*******************************************************************************
  * NAME:
- *    DisplayText::AddSpecialFrag
+ *    DisplayText::SetLineWidthPx
  *
  * SYNOPSIS:
- *    i_TextLineFrags DisplayText::AddSpecialFrag(struct TextLineFrag &SpecialFrag);
+ *    void DisplayText::SetLineWidthPx(struct TextLine *Line,int WidthPx);
  *
  * PARAMETERS:
- *    SpecialFrag [I] -- The frag to add.  This will be copied and returned.
+ *    Line [I] -- The line (in 'Lines') to change the width of
+ *    WidthPx [I] -- The new width of the line in pixels
  *
  * FUNCTION:
- *    This function adds frag.  It follows the rules for adding a char but this
- *    char can't be selected.  It also does not setup any extra info about the
- *    frag.
+ *    This function changes the 'LineWidthPx' of a line that is in 'Lines'
+ *    and keeps the line width histogram and 'LongestLinePx' up to date.
+ *    Anything that changes the width of a line in 'Lines' must use this.
  *
  * RETURNS:
- *    The frag that was added.
+ *    NONE
  *
  * SEE ALSO:
- *    NoteNonPrintable()
+ *    AddLineWidth(), RemoveLineWidth()
  ******************************************************************************/
-i_TextLineFrags DisplayText::AddSpecialFrag(struct TextLineFrag &SpecialFrag)
+void DisplayText::SetLineWidthPx(struct TextLine *Line,int WidthPx)
 {
-    i_TextLineFrags AddedFrag;
+    if(Line->LineWidthPx==WidthPx)
+        return;
 
-    if(ActiveLine==NULL)
-        throw(0);
+    RemoveLineWidth(Line->LineWidthPx);
+    Line->LineWidthPx=WidthPx;
+    AddLineWidth(WidthPx);
+}
 
-    if(ActiveLine->Frags.back().FragType==e_TextCanvasFrag_String &&
-            ActiveLine->Frags.back().Text.empty())
-    {
-        /* Ok, we have a blank string, replace it with the special frag */
-        ActiveLine->Frags.pop_back();
-    }
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::AddLineWidth
+ *
+ * SYNOPSIS:
+ *    void DisplayText::AddLineWidth(int WidthPx);
+ *
+ * PARAMETERS:
+ *    WidthPx [I] -- The width of the line being added
+ *
+ * FUNCTION:
+ *    This function counts a line of 'WidthPx' in the line width histogram.
+ *    Blank lines (0 px) are not counted so adding blank lines to 'Lines'
+ *    doesn't need to call this.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RemoveLineWidth(), SetLineWidthPx()
+ ******************************************************************************/
+void DisplayText::AddLineWidth(int WidthPx)
+{
+    if(WidthPx<=0)
+        return;
 
-    if(!ActiveLine->Frags.empty() &&
-        ActiveLine->Frags.front().FragType==e_TextCanvasFrag_HR)
-    {
-        /* Ok, the first frag of this line is a HR, we delete that and
-           setup for a virtual insert */
-        ActiveLine->Frags.clear();
-        InsertFrag=ActiveLine->Frags.end();
-        /* We don't set 'InsertPos' so if the user was in virtual space
-           we will still pad correctly */
-    }
+    LineWidthCounts[WidthPx]++;
+    if(WidthPx>LongestLinePx)
+        LongestLinePx=WidthPx;
+}
 
-    if(InsertFrag==ActiveLine->Frags.end())
-    {
-        if(InsertPos>=0)
-        {
-            /* Cursor in virtual space, we need to pad to get to it before
-               appending */
-            PadOutCurrentLine2Cursor();
-            RethinkFragWidth(InsertFrag);
-        }
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::RemoveLineWidth
+ *
+ * SYNOPSIS:
+ *    void DisplayText::RemoveLineWidth(int WidthPx);
+ *
+ * PARAMETERS:
+ *    WidthPx [I] -- The width of the line being removed
+ *
+ * FUNCTION:
+ *    This function takes a line of 'WidthPx' out of the line width histogram.
+ *    If it was the last line of the longest width then 'LongestLinePx' drops
+ *    to the next biggest width.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    AddLineWidth(), SetLineWidthPx()
+ ******************************************************************************/
+void DisplayText::RemoveLineWidth(int WidthPx)
+{
+    std::map<int,int>::iterator Bucket;
+
+    if(WidthPx<=0)
+        return;
+
+    Bucket=LineWidthCounts.find(WidthPx);
+    if(Bucket==LineWidthCounts.end())
+        return;
+
+    if(--Bucket->second>0)
+        return;
+
+    LineWidthCounts.erase(Bucket);
+    if(WidthPx>=LongestLinePx)
+        ReFindLongestLineLength();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::ForgetLineWidths
+ *
+ * SYNOPSIS:
+ *    void DisplayText::ForgetLineWidths(i_TextLines First,i_TextLines Last);
+ *
+ * PARAMETERS:
+ *    First [I] -- The first line that is leaving 'Lines'
+ *    Last [I] -- The line after the last line that is leaving 'Lines'
+ *
+ * FUNCTION:
+ *    This function takes a range of lines out of the line width histogram.
+ *    It must be called before the lines are erased (or spliced out) of
+ *    'Lines'.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    NoteLineWidths()
+ ******************************************************************************/
+void DisplayText::ForgetLineWidths(i_TextLines First,i_TextLines Last)
+{
+    i_TextLines CurLine;
+
+    for(CurLine=First;CurLine!=Last;CurLine++)
+        RemoveLineWidth(CurLine->LineWidthPx);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::NoteLineWidths
+ *
+ * SYNOPSIS:
+ *    void DisplayText::NoteLineWidths(i_TextLines First,i_TextLines Last);
+ *
+ * PARAMETERS:
+ *    First [I] -- The first line that is being put into 'Lines'
+ *    Last [I] -- The line after the last line being put into 'Lines'
+ *
+ * FUNCTION:
+ *    This function adds a range of lines to the line width histogram.  It
+ *    is used when lines that already have a width are spliced into 'Lines'.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ForgetLineWidths()
+ ******************************************************************************/
+void DisplayText::NoteLineWidths(i_TextLines First,i_TextLines Last)
+{
+    i_TextLines CurLine;
+
+    for(CurLine=First;CurLine!=Last;CurLine++)
+        AddLineWidth(CurLine->LineWidthPx);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::AddSpecialFrag
+ *
+ * SYNOPSIS:
+ *    i_TextLineFrags DisplayText::AddSpecialFrag(struct TextLineFrag &SpecialFrag);
+ *
+ * PARAMETERS:
+ *    SpecialFrag [I] -- The frag to add.  This will be copied and returned.
+ *
+ * FUNCTION:
+ *    This function adds frag.  It follows the rules for adding a char but this
+ *    char can't be selected.  It also does not setup any extra info about the
+ *    frag.
+ *
+ * RETURNS:
+ *    The frag that was added.
+ *
+ * SEE ALSO:
+ *    NoteNonPrintable()
+ ******************************************************************************/
+i_TextLineFrags DisplayText::AddSpecialFrag(struct TextLineFrag &SpecialFrag)
+{
+    i_TextLineFrags AddedFrag;
+
+    if(ActiveLine==NULL)
+        throw(0);
+
+    if(ActiveLine->Frags.back().FragType==e_TextCanvasFrag_String &&
+            ActiveLine->Frags.back().Text.empty())
+    {
+        /* Ok, we have a blank string, replace it with the special frag */
+        ActiveLine->Frags.pop_back();
+    }
+
+    if(!ActiveLine->Frags.empty() &&
+        ActiveLine->Frags.front().FragType==e_TextCanvasFrag_HR)
+    {
+        /* Ok, the first frag of this line is a HR, we delete that and
+           setup for a virtual insert */
+        ActiveLine->Frags.clear();
+        InsertFrag=ActiveLine->Frags.end();
+        /* We don't set 'InsertPos' so if the user was in virtual space
+           we will still pad correctly */
+    }
+
+    if(InsertFrag==ActiveLine->Frags.end())
+    {
+        if(InsertPos>=0)
+        {
+            /* Cursor in virtual space, we need to pad to get to it before
+               appending */
+            PadOutCurrentLine2Cursor();
+            RethinkFragWidth(InsertFrag);
+        }
         else
         {
             /* Cursor in virtual space, 1 place past the end of the last,
@@ -2288,7 +2758,51 @@ void DisplayText::WriteChar(uint8_t *Chr)
     LastSeenLF=false;
     LastSeenCR=false;
 
-    WriteCharWithOptions(Chr,true);
+    WriteCharWithOptions(Chr,true,true);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::WriteChars
+ *
+ * SYNOPSIS:
+ *    void DisplayText::WriteChars(const uint8_t *Chrs,int Count);
+ *
+ * PARAMETERS:
+ *    Chrs [I] -- The chars to add.  Each byte is one char (this is not
+ *                0 term'ed)
+ *    Count [I] -- The number of chars in 'Chrs'
+ *
+ * FUNCTION:
+ *    This function adds a run of single byte chars to the display.  The
+ *    active line is only redrawn once at the end of the run (and when we
+ *    wrap to a new line) instead of after every char.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    WriteChar()
+ ******************************************************************************/
+void DisplayText::WriteChars(const uint8_t *Chrs,int Count)
+{
+    uint8_t Chr[2];
+    int r;
+
+    if(Count<=0)
+        return;
+
+    LastSeenLF=false;
+    LastSeenCR=false;
+
+    Chr[1]=0;
+    for(r=0;r<Count;r++)
+    {
+        Chr[0]=Chrs[r];
+        WriteCharWithOptions(Chr,true,false);
+    }
+
+    RedrawActiveLine();
 }
 
 /*******************************************************************************
@@ -2296,11 +2810,14 @@ void DisplayText::WriteChar(uint8_t *Chr)
  *    DisplayText::WriteCharWithOptions
  *
  * SYNOPSIS:
- *    void DisplayText::WriteCharWithOptions(uint8_t *Chr,bool AdvCursor);
+ *    void DisplayText::WriteCharWithOptions(uint8_t *Chr,bool AdvCursor,
+ *          bool Redraw);
  *
  * PARAMETERS:
  *    Chr [I] -- The char to add.  This is a UTF8 char that is 0 term'ed.
  *    AdvCursor [I] -- If this is true then we move the cursor when we are done.
+ *    Redraw [I] -- Redraw the active line when we are done.  If this is
+ *                  false the caller must call RedrawActiveLine() itself.
  *
  * FUNCTION:
  *    This is the real WriteChar().  It has more options than WriteChar()
@@ -2312,7 +2829,8 @@ void DisplayText::WriteChar(uint8_t *Chr)
  * SEE ALSO:
  *    WriteChar()
  ******************************************************************************/
-void DisplayText::WriteCharWithOptions(uint8_t *Chr,bool AdvCursor)
+void DisplayText::WriteCharWithOptions(uint8_t *Chr,bool AdvCursor,
+        bool Redraw)
 {
     try
     {
@@ -2377,7 +2895,8 @@ void DisplayText::WriteCharWithOptions(uint8_t *Chr,bool AdvCursor)
 
         if(AdvCursor)
             AdjustCursorAfterWriteChar(Chr);
-        RedrawActiveLine();
+        if(Redraw)
+            RedrawActiveLine();
     }
     catch(...)
     {
@@ -2727,7 +3246,7 @@ void DisplayText::AdjustCursorAfterWriteChar(uint8_t *Chr)
 {
     int NewCursorPos;
     int NewCursorY;
-    struct TextCanvasFrag DisplayFrag;
+    const struct CharStyling *Styling;
 
     NewCursorPos=CursorX+1;
     NewCursorY=CursorY;
@@ -2758,24 +3277,13 @@ void DisplayText::AdjustCursorAfterWriteChar(uint8_t *Chr)
         else
         {
             /* Move the Px by the width of the char we just added */
-            DisplayFrag.FragType=e_TextCanvasFrag_String;
-            DisplayFrag.Text=(const char *)Chr;
             if(InsertFrag!=ActiveLine->Frags.end())
-            {
-                DisplayFrag.Styling=InsertFrag->Styling;
-                DisplayFrag.Value=InsertFrag->Value;
-                DisplayFrag.Data=InsertFrag->Data;
-            }
+                Styling=&InsertFrag->Styling;
             else
-            {
-                DisplayFrag.Styling=CurrentStyle;
-                DisplayFrag.Value=0;
-                DisplayFrag.Data=NULL;
-            }
+                Styling=&CurrentStyle;
 
-            CursorXPx+=UITC_GetFragWidth(
-                    UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                    &DisplayFrag);
+            CursorXPx+=GetStringWidthPx((const char *)Chr,
+                    (const char *)Chr+strlen((const char *)Chr),Styling);
         }
     }
 
@@ -2817,6 +3325,14 @@ void DisplayText::RethinkFragWidth(i_TextLineFrags Frag)
     if(!ShowNonPrintables && Frag->FragType==e_TextCanvasFrag_NonPrintableChar)
         return;
 
+    if(Frag->FragType==e_TextCanvasFrag_String)
+    {
+        /* Normal text is looked up in the width cache */
+        Frag->WidthPx=GetStringWidthPx(Frag->Text.c_str(),
+                Frag->Text.c_str()+Frag->Text.length(),&Frag->Styling);
+        return;
+    }
+
     DisplayFrag.FragType=Frag->FragType;
     DisplayFrag.Text=Frag->Text.c_str();
     DisplayFrag.Styling=Frag->Styling;
@@ -2827,6 +3343,175 @@ void DisplayText::RethinkFragWidth(i_TextLineFrags Frag)
             UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),&DisplayFrag);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::ResetCharWidthCache
+ *
+ * SYNOPSIS:
+ *    void DisplayText::ResetCharWidthCache(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function throws away all the cached char widths.  This needs to
+ *    be called any time the font changes.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::GetCharWidthPx()
+ ******************************************************************************/
+void DisplayText::ResetCharWidthCache(void)
+{
+    memset(CharWidthCache,0xFF,sizeof(CharWidthCache));
+    CharWidthMap.clear();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::GetCharWidthPx
+ *
+ * SYNOPSIS:
+ *    int DisplayText::GetCharWidthPx(uint32_t CodePoint,const char *Chr,
+ *              int Bytes,const struct CharStyling *Styling);
+ *
+ * PARAMETERS:
+ *    CodePoint [I] -- The unicode char to get the width of
+ *    Chr [I] -- The UTF-8 bytes for 'CodePoint'
+ *    Bytes [I] -- The number of bytes in 'Chr'
+ *    Styling [I] -- The style the char will be drawn in
+ *
+ * FUNCTION:
+ *    This function gets the width in pixels of a char.  The first time a
+ *    char is seen (for the current font) it is measured by the UI and saved,
+ *    after that it's just looked up.
+ *
+ *    Zero width chars (combining marks) are never measured because the UI
+ *    draws them on top of the char before them.
+ *
+ * RETURNS:
+ *    The width of the char in pixels.
+ *
+ * SEE ALSO:
+ *    DisplayText::GetStringWidthPx(), DisplayText::ResetCharWidthCache()
+ ******************************************************************************/
+int DisplayText::GetCharWidthPx(uint32_t CodePoint,const char *Chr,int Bytes,
+        const struct CharStyling *Styling)
+{
+    struct TextCanvasFrag DisplayFrag;
+    char Buffer[MAX_BYTES_PER_CHAR+1];
+    i_DTCharWidthMapType Found;
+    unsigned int Style;
+    int WidthPx;
+
+    Style=0;
+    if(Styling->Attribs&TXT_ATTRIB_BOLD)
+        Style|=1;
+    if(Styling->Attribs&TXT_ATTRIB_ITALIC)
+        Style|=2;
+    if(Styling->Attribs&TXT_ATTRIB_FORCE)
+        Style|=4;
+
+    if(CodePoint<DTXT_WIDTHCACHE_DIRECT)
+    {
+        if(CharWidthCache[Style][CodePoint]>=0)
+            return CharWidthCache[Style][CodePoint];
+    }
+    else
+    {
+        Found=CharWidthMap.find((CodePoint<<3)|Style);
+        if(Found!=CharWidthMap.end())
+            return Found->second;
+    }
+
+    /* Not seen before, measure it */
+    WidthPx=0;
+    if(Unicode_GetCharColumns(CodePoint)>0 && TextDisplayCtrl!=NULL)
+    {
+        if(Bytes>MAX_BYTES_PER_CHAR)
+            Bytes=MAX_BYTES_PER_CHAR;
+        memcpy(Buffer,Chr,Bytes);
+        Buffer[Bytes]=0;
+
+        DisplayFrag.FragType=e_TextCanvasFrag_String;
+        DisplayFrag.Text=Buffer;
+        DisplayFrag.Styling=*Styling;
+        DisplayFrag.Value=0;
+        DisplayFrag.Data=NULL;
+
+        WidthPx=UITC_GetFragWidth(
+                UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),&DisplayFrag);
+    }
+
+    if(CodePoint<DTXT_WIDTHCACHE_DIRECT)
+        CharWidthCache[Style][CodePoint]=WidthPx;
+    else
+        CharWidthMap[(CodePoint<<3)|Style]=WidthPx;
+
+    return WidthPx;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::GetStringWidthPx
+ *
+ * SYNOPSIS:
+ *    int DisplayText::GetStringWidthPx(const char *Start,const char *End,
+ *              const struct CharStyling *Styling);
+ *
+ * PARAMETERS:
+ *    Start [I] -- The start of the UTF-8 string to get the width of
+ *    End [I] -- One past the last byte of the string
+ *    Styling [I] -- The style the string will be drawn in
+ *
+ * FUNCTION:
+ *    This function adds up the widths of all the chars in a string using
+ *    the char width cache.
+ *
+ * RETURNS:
+ *    The width of the string in pixels.
+ *
+ * SEE ALSO:
+ *    DisplayText::GetCharWidthPx()
+ ******************************************************************************/
+int DisplayText::GetStringWidthPx(const char *Start,const char *End,
+        const struct CharStyling *Styling)
+{
+    const char *Pos;
+    const char *CharStart;
+    uint32_t CodePoint;
+    int WidthPx;
+    int Bytes;
+
+    WidthPx=0;
+    Pos=Start;
+    while(Pos<End)
+    {
+        CharStart=Pos;
+        if((uint8_t)*Pos<0x80)
+        {
+            CodePoint=(uint8_t)*Pos++;
+        }
+        else
+        {
+            /* Don't let a cut off char walk off the end of the string */
+            Bytes=utf8::internal::sequence_length(Pos);
+            if(Bytes<1 || Pos+Bytes>End)
+            {
+                CodePoint=(uint8_t)*Pos++;
+            }
+            else
+            {
+                CodePoint=utf8::unchecked::next(Pos);
+            }
+        }
+        WidthPx+=GetCharWidthPx(CodePoint,CharStart,Pos-CharStart,Styling);
+    }
+    return WidthPx;
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayText::HandleDeletingNPAfterOverwrite
@@ -3060,6 +3745,9 @@ void DisplayText::RethinkWindowSize(void)
     bool Force2Bottom;
     bool RedrawNeeded;
     int CursorGlobalY;
+    int ScreenFirstLineY;
+    struct TextLine BlankLine;
+    i_TextLines FirstKeptLine;
 
     RedrawNeeded=false;
 
@@ -3092,16 +3780,71 @@ void DisplayText::RethinkWindowSize(void)
         /* Rethink all the lines widths */
     }
 
-    if(OldHeight!=ScreenHeightChars)
+    if(OldHeight!=ScreenHeightChars && AltScreenActive)
     {
-        /* Move the cursor (because it's relative to topline) (screen can't be
-           0 because then the cursor is in invalid space) */
-        if(LinesCount<OldHeight || OldHeight==0)
-            CursorGlobalY=CursorY;
-        else
-            CursorGlobalY=LinesCount-OldHeight+CursorY;
-
-        if(LinesCount<ScreenHeightChars || ScreenHeightChars==0)
+        /* The alternate screen is always exactly one screen of lines (it
+           can't take lines from the back buffer), so add blank lines to the
+           bottom or drop lines off the top */
+        if(ScreenHeightChars>OldHeight)
+        {
+            BlankLine.LineBackgroundColor=CurrentStyle.BGColor;
+            BlankLine.LineWidthPx=0;
+            BlankLine.EOL=e_DTEOL_Hard;
+            BlankLine.EOLGuess=e_DTEOLGuess_Unknown;
+            for(r=OldHeight;r<ScreenHeightChars;r++)
+                Lines.push_back(BlankLine);
+        }
+        else
+        {
+            FirstKeptLine=ScreenFirstLine;
+            for(r=ScreenHeightChars;r<OldHeight && FirstKeptLine!=Lines.end();
+                    r++)
+            {
+                FirstKeptLine++;
+            }
+            /* The selection extract may be pointing at one of the lines we
+               are about to free (or one after them, which will move) */
+            if(LinesCount<OldHeight)
+                ScreenFirstLineY=0;
+            else
+                ScreenFirstLineY=LinesCount-OldHeight;
+            if(SelExtractActive &&
+                    SelExtract_NextY-LinesBase>=ScreenFirstLineY)
+            {
+                StopSelectionExtract();
+            }
+
+            ForgetLineWidths(ScreenFirstLine,FirstKeptLine);
+            Lines.erase(ScreenFirstLine,FirstKeptLine);
+            ScreenFirstLine=FirstKeptLine;
+
+            NewY-=OldHeight-ScreenHeightChars;
+            if(NewY<0)
+                NewY=0;
+
+            /* 'ActiveLine' may have been dropped */
+            CursorY=NewY;
+            ActiveLineY=-1;
+            RethinkInsertFrag();
+        }
+        LinesCount=Lines.size();
+
+        TopLine=ScreenFirstLine;
+        TopLineY=LinesCount-ScreenHeightChars;
+        RethinkScrollBars();
+        InvalidateAllMarks();
+        RedrawNeeded=true;
+    }
+    else if(OldHeight!=ScreenHeightChars)
+    {
+        /* Move the cursor (because it's relative to topline) (screen can't be
+           0 because then the cursor is in invalid space) */
+        if(LinesCount<OldHeight || OldHeight==0)
+            CursorGlobalY=CursorY;
+        else
+            CursorGlobalY=LinesCount-OldHeight+CursorY;
+
+        if(LinesCount<ScreenHeightChars || ScreenHeightChars==0)
             NewY=CursorGlobalY;
         else
             NewY=CursorGlobalY+ScreenHeightChars-LinesCount;
@@ -3431,7 +4174,7 @@ void DisplayText::DoBackspace(void)
 
     MoveCursor(NewPos,NewCursorY,false);
     if(Settings->DestructiveBackspace)
-        WriteCharWithOptions((uint8_t *)" ",false);
+        WriteCharWithOptions((uint8_t *)" ",false,true);
 
     /* We invalid the marks if we be less than the mark */
     CursorOffset=NewCursorY*ScreenWidthChars+NewPos;
@@ -3439,7 +4182,7 @@ void DisplayText::DoBackspace(void)
     {
         if(Marker->Valid)
         {
-            MarkOffset=Marker->Y*ScreenWidthChars+Marker->X;
+            MarkOffset=(Marker->Y-LinesBase)*ScreenWidthChars+Marker->X;
 
             /* If we have moved to less than the mark invalid this marker */
             if(CursorOffset<MarkOffset)
@@ -3648,10 +4391,15 @@ void DisplayText::ScrollScreenByXLines(int Lines2Scroll)
 {
     struct TextLine BlankLine;
     i_TextLines CurLine;
+    i_TextLines FirstKeptLine;
     int y;
     int TotalLinesBeforeAdjust;
     int LinesScrolled;
-    struct TextPointMarker *Marker;
+    int ScreenFirstLineMove;
+    int Lines2Remove;
+
+    if(Lines2Scroll<=0)
+        return;
 
     try
     {
@@ -3663,67 +4411,53 @@ void DisplayText::ScrollScreenByXLines(int Lines2Scroll)
         BlankLine.EOLGuess=e_DTEOLGuess_Unknown;
 
         for(LinesScrolled=0;LinesScrolled<Lines2Scroll;LinesScrolled++)
-        {
             Lines.push_back(BlankLine);
-            LinesCount++;
 
-            if(LinesCount>ScreenHeightChars)
+        /* Move the screens top line down by the number of lines past
+           a full screen we just added */
+        if(LinesCount>ScreenHeightChars)
+            ScreenFirstLineMove=Lines2Scroll;
+        else
+            ScreenFirstLineMove=LinesCount+Lines2Scroll-ScreenHeightChars;
+        LinesCount+=Lines2Scroll;
+        if(ScreenFirstLineMove>0)
+            advance(ScreenFirstLine,ScreenFirstLineMove);
+
+        /* Remove any extra lines.  Marks and the selection use absolute line
+           numbers so we only have to move 'LinesBase' */
+        Lines2Remove=LinesCount-(int)(Settings->ScrollBufferLines+
+                ScreenHeightChars);
+        if(Lines2Remove>0)
+        {
+            FirstKeptLine=Lines.begin();
+            advance(FirstKeptLine,Lines2Remove);
+
+            if(TopLineY<Lines2Remove)
             {
-                /* Move the screens top line down 1 */
-                ScreenFirstLine++;
+                /* 'TopLine' is in the lines we are removing, move it to the
+                   first line we keep */
+                TopLine=FirstKeptLine;
+                TopLineY=0;
             }
-
-            /* Remove any extra lines */
-            while(LinesCount>(int)(Settings->ScrollBufferLines+
-                    ScreenHeightChars))
+            else
             {
-                if(TopLine==Lines.begin())
-                {
-                    /* We are about to remove this line so we need to move
-                       top line as well */
-                    TopLine++;
-                    TopLineY++;
-                }
-
-                /* We are removing the oldest line so we need to move TopLineY
-                   up */
-                TopLineY--;
-
-                /* Adjust the selection (if there is one) */
-                if(SelectionActive)
-                {
-                    if(Selection_Y!=Selection_AnchorY ||
-                            Selection_X!=Selection_AnchorX)
-                    {
-                        /* Ok, we have a valid selection, adjust it */
-                        Selection_Y--;
-                        Selection_AnchorY--;
-                        if(Selection_Y<0 && Selection_AnchorY<0)
-                        {
-                            /* Ok, we are killing the selection */
-                            SelectionActive=false;
-                        }
-                        if(Selection_Y<0)
-                            Selection_Y=0;
-                        if(Selection_AnchorY<0)
-                            Selection_AnchorY=0;
-                    }
-                }
+                TopLineY-=Lines2Remove;
+            }
 
-                /* Adjust all the markers */
-                for(Marker=MarkerList;Marker!=NULL;Marker=Marker->Next)
-                {
-                    if(Marker->Valid)
-                    {
-                        Marker->Y--;
-                        if(Marker->Y<0)
-                            Marker->Y=0;
-                    }
-                }
+            ForgetLineWidths(Lines.begin(),FirstKeptLine);
+            Lines.erase(Lines.begin(),FirstKeptLine);
+            LinesCount-=Lines2Remove;
+            LinesBase+=Lines2Remove;
 
-                Lines.pop_front();
-                LinesCount--;
+            /* If the whole selection is gone then kill it */
+            if(SelectionActive && Selection_Y<LinesBase &&
+                    Selection_AnchorY<LinesBase)
+            {
+                SelectionActive=false;
             }
+
+            if(LinesBase>=LINESBASE_REBASE_AT)
+                RebaseAbsLines();
         }
 
         /* We go from the bottom of 'Lines' to the 'CursorY' pos (inverted) */
@@ -3740,7 +4474,7 @@ void DisplayText::ScrollScreenByXLines(int Lines2Scroll)
 
         ActiveLine=&*CurLine;
 
-        RedrawFullScreen();
+        RedrawAfterScroll();
 
         if(TotalLinesBeforeAdjust!=LinesCount)
         {
@@ -3756,6 +4490,50 @@ void DisplayText::ScrollScreenByXLines(int Lines2Scroll)
     }
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::RebaseAbsLines
+ *
+ * SYNOPSIS:
+ *    void DisplayText::RebaseAbsLines(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function moves 'LinesBase' back to 0 and moves everything that
+ *    uses absolute line numbers (marks, the selection) with it.  This is
+ *    only needed once every LINESBASE_REBASE_AT lines so 'LinesBase' can't
+ *    wrap.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::ScrollScreenByXLines()
+ ******************************************************************************/
+void DisplayText::RebaseAbsLines(void)
+{
+    struct TextPointMarker *Marker;
+
+    for(Marker=MarkerList;Marker!=NULL;Marker=Marker->Next)
+        Marker->Y-=LinesBase;
+
+    Selection_Y-=LinesBase;
+    Selection_AnchorY-=LinesBase;
+    Selection_StartY1-=LinesBase;
+    Selection_StartY2-=LinesBase;
+
+    SelExtract_FirstY-=LinesBase;
+    SelExtract_EndY-=LinesBase;
+    SelExtract_NextY-=LinesBase;
+
+    if(CanvasTopLineAbsY>=0)
+        CanvasTopLineAbsY-=LinesBase;
+
+    LinesBase=0;
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayText::CursorLineVisible
@@ -3856,21 +4634,46 @@ void DisplayText::RethinkCursorHidden(void)
  * FUNCTION:
  *    This function moves to the next line and scrolls the screen if needed.
  *
+ *    If there is a scroll region (or the alternate screen is up) then
+ *    moving off the bottom margin only scrolls the lines in the region and
+ *    nothing goes into the scroll back buffer.
+ *
  * RETURNS:
  *    true -- We scrolled the screen
  *    false -- We just moved the cursor
  *
  * SEE ALSO:
- *    
+ *    DisplayText::SetScrollRegion(), DisplayText::SetAltScreen()
  ******************************************************************************/
 bool DisplayText::MoveToNextLine(int &NewCursorY)
 {
     int CursorGlobalY;
     int BottomLineY;
+    int RegionTop;
+    int RegionBottom;
     bool RetValue;
 
     RetValue=false;
 
+    if(AltScreenActive || ScrollRegionBottom!=0)
+    {
+        GetScrollRegion(RegionTop,RegionBottom);
+        if(NewCursorY==RegionBottom-1)
+        {
+            /* On the bottom margin, scroll the region up 1 line.  Only the
+               lines in the region changed so only they are redrawn */
+            PadOutScreenWithBlankLines();
+            ScrollVertAreaUp(0,RegionTop,ScreenWidthChars,RegionBottom,1);
+            RedrawScreenLines(RegionTop,RegionBottom);
+            return true;
+        }
+
+        /* Below the region we just stop at the bottom of the screen */
+        if(NewCursorY<ScreenHeightChars-1)
+            NewCursorY++;
+        return false;
+    }
+
     NewCursorY++;
 
     if(LinesCount<ScreenHeightChars)
@@ -3971,9 +4774,9 @@ void DisplayText::GetNormalizedSelection(int &X1,int &Y1,int &X2,int &Y2)
         return;
 
     X1=Selection_X;
-    Y1=Selection_Y;
+    Y1=Selection_Y-LinesBase;
     X2=Selection_AnchorX;
-    Y2=Selection_AnchorY;
+    Y2=Selection_AnchorY-LinesBase;
 
     if(Y2<Y1)
     {
@@ -3995,6 +4798,12 @@ void DisplayText::GetNormalizedSelection(int &X1,int &Y1,int &X2,int &Y2)
             X1=Tmp;
         }
     }
+
+    /* Clip any part of the selection that has scrolled out of the buffer */
+    if(Y1<0)
+        Y1=0;
+    if(Y2<0)
+        Y2=0;
 }
 
 /*******************************************************************************
@@ -4034,7 +4843,6 @@ bool DisplayText::ConvertScreenXY2Chars(int x,int y,int *CharX,int *CharY)
     bool RetValue;
     i_TextLineFrags CurFrag;
     int StartPx;
-    struct TextCanvasFrag DisplayFrag;
     string::iterator StartPos;
     string::iterator EndPos;
     int FragWidthPx;
@@ -4100,12 +4908,6 @@ bool DisplayText::ConvertScreenXY2Chars(int x,int y,int *CharX,int *CharY)
         if(CurFrag!=Line->Frags.end() &&
                 CurFrag->FragType==e_TextCanvasFrag_String)
         {
-            DisplayFrag.FragType=CurFrag->FragType;
-            DisplayFrag.Text=CurFrag->Text.c_str();
-            DisplayFrag.Styling=CurFrag->Styling;
-            DisplayFrag.Value=CurFrag->Value;
-            DisplayFrag.Data=CurFrag->Data;
-
             StartPos=CurFrag->Text.begin();
             while(StartPos!=CurFrag->Text.end())
             {
@@ -4113,11 +4915,10 @@ bool DisplayText::ConvertScreenXY2Chars(int x,int y,int *CharX,int *CharY)
                 EndPos=StartPos;
                 utf8::unchecked::next(EndPos);
 
-                TmpStr.assign(StartPos,EndPos);
-                DisplayFrag.Text=TmpStr.c_str();
-                FragWidthPx=UITC_GetFragWidth(
-                        UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                        &DisplayFrag);
+                FragWidthPx=GetStringWidthPx(CurFrag->Text.c_str()+
+                        (StartPos-CurFrag->Text.begin()),
+                        CurFrag->Text.c_str()+(EndPos-CurFrag->Text.begin()),
+                        &CurFrag->Styling);
 
                 if(UseX<StartPx+FragWidthPx)
                     break;
@@ -4247,6 +5048,246 @@ bool DisplayText::GetSelectionString(std::string &Clip)
 //    return true;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::GetSelectionLineCount
+ *
+ * SYNOPSIS:
+ *    int DisplayText::GetSelectionLineCount(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets how many lines the selection covers.  This doesn't
+ *    need to walk the buffer so it's cheap to call.
+ *
+ * RETURNS:
+ *    The number of lines in the selection or 0 if there is no selection.
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+int DisplayText::GetSelectionLineCount(void)
+{
+    if(!IsThereASelection())
+        return 0;
+
+    if(Selection_AnchorY<Selection_Y)
+        return Selection_Y-Selection_AnchorY+1;
+    return Selection_AnchorY-Selection_Y+1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::StartSelectionExtract
+ *
+ * SYNOPSIS:
+ *    bool DisplayText::StartSelectionExtract(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function starts getting a copy of the selection text a piece at a
+ *    time.  We remember the selection range in absolute lines and the line
+ *    in 'Lines' we are up to, so each GetSelectionChunk() carries on from
+ *    where the last one stopped instead of walking the buffer from the top
+ *    again.
+ *
+ *    Lines are only ever added to the bottom of 'Lines' and removed from the
+ *    top, so the line we are up to stays valid until it scrolls out of the
+ *    scroll back buffer (which GetSelectionChunk() checks for).
+ *
+ * RETURNS:
+ *    true -- The extract has started
+ *    false -- There is no selection
+ *
+ * SEE ALSO:
+ *    GetSelectionChunk(), GetSelectionExtractProgress(),
+ *    StopSelectionExtract(), GetSelectionString()
+ ******************************************************************************/
+bool DisplayText::StartSelectionExtract(void)
+{
+    int SelX1;
+    int SelY1;
+    int SelX2;
+    int SelY2;
+    struct DTPoint Start;
+
+    StopSelectionExtract();
+
+    if(!IsThereASelection())
+        return false;
+
+    GetNormalizedSelection(SelX1,SelY1,SelX2,SelY2);
+
+    if(SelY2>=LinesCount)
+        return false;
+
+    if(!FindPoint(SelX1,SelY1,Start,Lines.end(),0))
+        return false;
+
+    SelExtract_NextLine=Start.Line;
+    SelExtract_NextX=SelX1;
+    SelExtract_NextY=Start.LineY+LinesBase;
+    SelExtract_FirstY=SelExtract_NextY;
+    SelExtract_EndX=SelX2;
+    SelExtract_EndY=SelY2+LinesBase;
+
+    SelExtractActive=true;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::GetSelectionChunk
+ *
+ * SYNOPSIS:
+ *    bool DisplayText::GetSelectionChunk(std::string &Chunk,
+ *              unsigned int MaxBytes,bool &Done);
+ *
+ * PARAMETERS:
+ *    Chunk [O] -- The next piece of the selection text.  We always stop at
+ *                 the end of a line so this can go over 'MaxBytes' by up to
+ *                 one line.
+ *    MaxBytes [I] -- About how many bytes to get
+ *    Done [O] -- Set to true when this was the last piece
+ *
+ * FUNCTION:
+ *    This function gets the next piece of the selection text that was
+ *    started with StartSelectionExtract().  Adding all the pieces together
+ *    gives the same string as GetSelectionString() would have.
+ *
+ * RETURNS:
+ *    true -- 'Chunk' has been filled in
+ *    false -- The lines we where extracting scrolled out of the buffer (or
+ *             no extract was started).  The extract has been stopped.
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+bool DisplayText::GetSelectionChunk(std::string &Chunk,unsigned int MaxBytes,
+        bool &Done)
+{
+    i_TextLines Line;
+    int AbsY;
+    int_fast32_t StartX;
+
+    Chunk.clear();
+    Done=false;
+
+    if(!SelExtractActive)
+        return false;
+
+    if(SelExtract_NextY>SelExtract_EndY)
+    {
+        /* We already handed out the last piece */
+        Done=true;
+        return true;
+    }
+
+    /* If the line we are up to has been dropped then the iterator is gone
+       with it */
+    if(SelExtract_NextY<LinesBase)
+    {
+        StopSelectionExtract();
+        return false;
+    }
+
+    Line=SelExtract_NextLine;
+    AbsY=SelExtract_NextY;
+    StartX=SelExtract_NextX;
+    while(Chunk.length()<MaxBytes)
+    {
+        if(AbsY>=SelExtract_EndY)
+        {
+            TextLine_AppendText(Line,StartX,SelExtract_EndX,Chunk);
+            Done=true;
+            AbsY++;
+            break;
+        }
+
+        TextLine_AppendText(Line,StartX,-1,Chunk);
+        Chunk.append("\n");
+
+        Line++;
+        AbsY++;
+        StartX=0;
+        if(Line==Lines.end())
+        {
+            /* Unexpected end */
+            StopSelectionExtract();
+            return false;
+        }
+    }
+
+    SelExtract_NextLine=Line;
+    SelExtract_NextY=AbsY;
+    SelExtract_NextX=StartX;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::GetSelectionExtractProgress
+ *
+ * SYNOPSIS:
+ *    void DisplayText::GetSelectionExtractProgress(uint64_t *Done,
+ *              uint64_t *Total);
+ *
+ * PARAMETERS:
+ *    Done [O] -- The number of lines we have extracted so far
+ *    Total [O] -- The number of lines in the extract
+ *
+ * FUNCTION:
+ *    This function gets how far along a selection extract is.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+void DisplayText::GetSelectionExtractProgress(uint64_t *Done,uint64_t *Total)
+{
+    *Done=0;
+    *Total=0;
+
+    if(!SelExtractActive)
+        return;
+
+    *Done=SelExtract_NextY-SelExtract_FirstY;
+    *Total=SelExtract_EndY-SelExtract_FirstY+1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::StopSelectionExtract
+ *
+ * SYNOPSIS:
+ *    void DisplayText::StopSelectionExtract(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function ends a selection extract.  It is safe to call this even
+ *    if there isn't an extract running.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartSelectionExtract()
+ ******************************************************************************/
+void DisplayText::StopSelectionExtract(void)
+{
+    SelExtractActive=false;
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayText::IsThereASelection
@@ -4323,9 +5364,9 @@ void DisplayText::SelectAll(void)
 
         SelectionActive=true;
 
-        Selection_Y=0;
+        Selection_Y=LinesBase;
         Selection_X=0;
-        Selection_AnchorY=LinesCount-1;
+        Selection_AnchorY=LinesBase+LinesCount-1;
     }
 
     RedrawFullScreen();
@@ -4589,7 +5630,6 @@ int DisplayText::CalcCursorXPx(void)
     i_TextLines Line;
     i_TextLineFrags CurFrag;
     int Pixels;
-    struct TextCanvasFrag DisplayFrag;
     string::iterator StartPos;
     string::iterator EndPos;
     int Chars;
@@ -4617,12 +5657,6 @@ int DisplayText::CalcCursorXPx(void)
     if(CurFrag!=ActiveLine->Frags.end() &&
             CurFrag->FragType==e_TextCanvasFrag_String)
     {
-        DisplayFrag.FragType=e_TextCanvasFrag_String;
-        DisplayFrag.Text=CurFrag->Text.c_str();
-        DisplayFrag.Styling=CurFrag->Styling;
-        DisplayFrag.Value=CurFrag->Value;
-        DisplayFrag.Data=CurFrag->Data;
-
         StartPos=CurFrag->Text.begin();
         EndPos=StartPos;
         while(StartPos!=CurFrag->Text.end())
@@ -4630,11 +5664,9 @@ int DisplayText::CalcCursorXPx(void)
             if(CalX>=CursorX)
             {
                 /* Ok, add in the first part of this fragment */
-                TmpStr.assign(StartPos,EndPos);
-                DisplayFrag.Text=TmpStr.c_str();
-                Pixels+=UITC_GetFragWidth(
-                        UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                        &DisplayFrag);
+                Pixels+=GetStringWidthPx(CurFrag->Text.c_str(),
+                        CurFrag->Text.c_str()+(EndPos-CurFrag->Text.begin()),
+                        &CurFrag->Styling);
                 break;
             }
 
@@ -4677,7 +5709,6 @@ int DisplayText::CharUnderCursorWidthPx(void)
 {
     int CalX;
     i_TextLineFrags CurFrag;
-    struct TextCanvasFrag DisplayFrag;
     string::iterator StartPos;
     string::iterator EndPos;
     int Chars;
@@ -4706,12 +5737,6 @@ int DisplayText::CharUnderCursorWidthPx(void)
     if(CurFrag!=ActiveLine->Frags.end() &&
             CurFrag->FragType==e_TextCanvasFrag_String)
     {
-        DisplayFrag.FragType=e_TextCanvasFrag_String;
-        DisplayFrag.Text=CurFrag->Text.c_str();
-        DisplayFrag.Styling=CurFrag->Styling;
-        DisplayFrag.Value=CurFrag->Value;
-        DisplayFrag.Data=CurFrag->Data;
-
         StartPos=CurFrag->Text.begin();
         EndPos=StartPos;
         while(StartPos!=CurFrag->Text.end())
@@ -4722,11 +5747,10 @@ int DisplayText::CharUnderCursorWidthPx(void)
             if(CalX>=CursorX)
             {
                 /* Ok, we found the char */
-                TmpStr.assign(StartPos,EndPos);
-                DisplayFrag.Text=TmpStr.c_str();
-                WidthPx=UITC_GetFragWidth(
-                        UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),
-                        &DisplayFrag);
+                WidthPx=GetStringWidthPx(CurFrag->Text.c_str()+
+                        (StartPos-CurFrag->Text.begin()),
+                        CurFrag->Text.c_str()+(EndPos-CurFrag->Text.begin()),
+                        &CurFrag->Styling);
                 break;
             }
 
@@ -4853,6 +5877,10 @@ void DisplayText::ClearScreen(e_ScreenClearType Type)
 
     try
     {
+        /* Nothing on the alternate screen goes into the back buffer */
+        if(AltScreenActive && Type!=e_ScreenClear_ClearBackBuffer)
+            Type=e_ScreenClear_Clear;
+
         switch(Type)
         {
             case e_ScreenClear_ClearBackBuffer:
@@ -4863,7 +5891,7 @@ void DisplayText::ClearScreen(e_ScreenClearType Type)
                 for(CurLine=ScreenFirstLine;CurLine!=Lines.end();CurLine++)
                 {
                     CurLine->LineBackgroundColor=CurrentStyle.BGColor;
-                    CurLine->LineWidthPx=0;
+                    SetLineWidthPx(&*CurLine,0);
                     CurLine->EOL=e_DTEOL_Hard;
                     CurLine->Frags.clear();
                     CurLine->EOLGuess=e_DTEOLGuess_Unknown;
@@ -5091,14 +6119,17 @@ bool DisplayText::IsCursorAtEnd(void)
 void DisplayText::ClearScrollBackBuffer(void)
 {
     i_TextLines Bottom;
+    int OldLinesCount;
 
     Bottom=ScreenFirstLine;
 
     if(Bottom==Lines.end() || Bottom==Lines.begin())
         return;
 
+    OldLinesCount=LinesCount;
     Lines.erase(Lines.begin(),Bottom);
     LinesCount=Lines.size();
+    LinesBase+=OldLinesCount-LinesCount;
 
     TopLine=Lines.begin();
     TopLineY=0;
@@ -5267,6 +6298,9 @@ void DisplayText::ResetTerm(void)
         CurrentStyle.Attribs=0;
         CurrentStyle.ULineColor=CurrentStyle.FGColor;
 
+        SetAltScreen(false);
+        SetScrollRegion(0,0);
+
         ClearScrollBackBuffer();
         ClearScreen(e_ScreenClear_Clear);
 
@@ -5407,6 +6441,9 @@ void DisplayText::SetDrawMask(uint16_t Mask)
         return;
 
     UITC_SetDrawMask(UITC_GetTextDisplayPrimaryColumn(TextDisplayCtrl),Mask);
+
+    /* Bold / italic may now draw differently */
+    ResetCharWidthCache();
 }
 
 /*******************************************************************************
@@ -5766,6 +6803,7 @@ void DisplayText::ScrollVertAreaDown(uint32_t X1,uint32_t Y1,uint32_t X2,
 {
     i_TextLines TopLineOfArea;
     i_TextLines BottomLineOfArea;
+    i_TextLines AfterArea;
     i_TextLines CurLine;
     i_TextLines CopyFromLine;
     i_TextLines CopyToLine;
@@ -5813,6 +6851,37 @@ void DisplayText::ScrollVertAreaDown(uint32_t X1,uint32_t Y1,uint32_t X2,
             BottomLineOfArea--;
     }
 
+    if(X1==0 && X2>=(uint32_t)ScreenWidthChars)
+    {
+        /* The area is whole lines, so we move the lines instead of copying
+           the frags.  The lines that scroll off the bottom are blanked and
+           moved to the top of the area. */
+        AfterArea=TopLineOfArea;
+        for(r=0;r<AreaHeight && AfterArea!=Lines.end();r++)
+            AfterArea++;
+        if(dy>r)
+            dy=r;
+
+        CurLine=AfterArea;
+        for(r=0;r<dy;r++)
+        {
+            CurLine--;
+            TextLine_Clear(CurLine);
+            CurLine->LineBackgroundColor=CurrentStyle.BGColor;
+            CurLine->EOL=e_DTEOL_Hard;
+            CurLine->EOLGuess=e_DTEOLGuess_Unknown;
+        }
+
+        if(CurLine!=TopLineOfArea)
+        {
+            if(TopLineOfArea==ScreenFirstLine)
+                ScreenFirstLine=CurLine;
+            Lines.splice(TopLineOfArea,Lines,CurLine,AfterArea);
+        }
+        RethinkAfterScreenLinesMoved();
+        return;
+    }
+
     /************************************/
     /*** First delete from the bottom ***/
     /************************************/
@@ -5882,134 +6951,375 @@ void DisplayText::ScrollVertAreaDown(uint32_t X1,uint32_t Y1,uint32_t X2,
 
 /*******************************************************************************
  * NAME:
- *    DisplayText::ScrollVertAreaUp
+ *    DisplayText::ScrollVertAreaUp
+ *
+ * SYNOPSIS:
+ *    void DisplayText::ScrollVertAreaUp(uint32_t X1,uint32_t Y1,uint32_t X2,
+ *          uint32_t Y2,int32_t dy);
+ *
+ * PARAMETERS:
+ *    X1 [I] -- The left edge
+ *    Y1 [I] -- The top edge
+ *    X2 [I] -- The right edge
+ *    Y2 [I] -- The bottom edge
+ *    dy [I] -- The amount to scroll
+ *
+ * FUNCTION:
+ *    This function scrolls an area up (text moves up, like a normal scroll
+ *    of a screen).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::ScrollArea()
+ ******************************************************************************/
+void DisplayText::ScrollVertAreaUp(uint32_t X1,uint32_t Y1,uint32_t X2,
+        uint32_t Y2,int32_t dy)
+{
+    i_TextLines TopLineOfArea;
+    i_TextLines BottomLineOfArea;
+    i_TextLines AfterArea;
+    i_TextLines CurLine;
+    i_TextLines CopyFromLine;
+    i_TextLines CopyToLine;
+    i_TextLineFrags InsertAfterFrag;
+    i_TextLineFrags StartFrag;
+    i_TextLineFrags EndFrag;
+    int_fast32_t y;
+    int_fast32_t r;
+    int_fast32_t AreaHeight;
+    int_fast32_t AreaWidth;
+
+    if(Y2<=Y1)
+    {
+        /* Nothing to do */
+        return;
+    }
+
+    AreaHeight=Y2-Y1;
+    if(AreaHeight>ScreenHeightChars)
+        AreaHeight=ScreenHeightChars-Y1;
+
+    AreaWidth=X2-X1;
+    if(AreaWidth>ScreenWidthChars)
+        AreaWidth=ScreenWidthChars-X1;
+
+    /* Find the top line */
+    TopLineOfArea=ScreenFirstLine;
+    for(y=0;y<Y1 && TopLineOfArea!=Lines.end();y++)
+        TopLineOfArea++;
+    if(TopLineOfArea==Lines.end())
+    {
+        /* We don't have enough lines, we are below the of the lines, so we
+           are done */
+        return;
+    }
+
+    /* Find the bottom line */
+    BottomLineOfArea=TopLineOfArea;
+    if(Y2>0)
+    {
+        for(;y<Y2-1 && BottomLineOfArea!=Lines.end();y++)
+            BottomLineOfArea++;
+
+        if(BottomLineOfArea==Lines.end())
+            BottomLineOfArea--;
+    }
+
+    if(X1==0 && X2>=(uint32_t)ScreenWidthChars)
+    {
+        /* The area is whole lines, so we move the lines instead of copying
+           the frags.  The lines that scroll off the top are blanked and moved
+           to the bottom of the area. */
+        AfterArea=TopLineOfArea;
+        for(r=0;r<AreaHeight && AfterArea!=Lines.end();r++)
+            AfterArea++;
+        if(dy>r)
+            dy=r;
+
+        CurLine=TopLineOfArea;
+        for(r=0;r<dy;r++)
+        {
+            TextLine_Clear(CurLine);
+            CurLine->LineBackgroundColor=CurrentStyle.BGColor;
+            CurLine->EOL=e_DTEOL_Hard;
+            CurLine->EOLGuess=e_DTEOLGuess_Unknown;
+            CurLine++;
+        }
+
+        if(CurLine!=AfterArea)
+        {
+            if(TopLineOfArea==ScreenFirstLine)
+                ScreenFirstLine=CurLine;
+            Lines.splice(AfterArea,Lines,TopLineOfArea,CurLine);
+        }
+        RethinkAfterScreenLinesMoved();
+        return;
+    }
+
+    /*********************************/
+    /*** First delete from the top ***/
+    /*********************************/
+    CurLine=TopLineOfArea;
+    for(r=0;r<dy && CurLine!=Lines.end();r++)
+    {
+        TextLine_ErasePos2Pos(CurLine,X1,X2);
+        CurLine++;
+    }
+
+    /***********************************/
+    /*** Shift the lines up (scroll) ***/
+    /***********************************/
+    /* Move the lines (working from the top) */
+    CopyToLine=TopLineOfArea;
+
+    /* Move the copy from line up by the scroll amount */
+    CopyFromLine=TopLineOfArea;
+    for(r=0;r<dy && CopyFromLine!=Lines.end();r++)
+        CopyFromLine++;
+
+    for(r=0;r<AreaHeight-dy && CopyFromLine!=Lines.end();r++)
+    {
+        TextLine_SplitFrag(CopyFromLine,X2,false,NULL,&EndFrag);
+        TextLine_SplitFrag(CopyFromLine,X1,false,NULL,&StartFrag);
+
+        /* Make sure we have enough room on the line to insert the frag's */
+        PadOutLine(&*CopyToLine,X1);
+
+        TextLine_SplitFrag(CopyToLine,X1,false,NULL,&InsertAfterFrag);
+
+        CopyToLine->Frags.insert(InsertAfterFrag,StartFrag,EndFrag);
+        CopyFromLine->Frags.erase(StartFrag,EndFrag);
+
+        CopyFromLine++;
+        CopyToLine++;
+    }
+
+    /**************************************************************/
+    /*** Fill in blank lines to fill in the holes at the bottom ***/
+    /**************************************************************/
+    CurLine=BottomLineOfArea;
+    for(r=0;r<dy;r++)
+    {
+        TextLine_Fill(CurLine,X1,AreaWidth,&CurrentStyle," ");
+
+        if(CurLine==Lines.begin())
+        {
+            /* We just did the top line, nothing above this, abort */
+            break;
+        }
+        CurLine--;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::GetScrollRegion
+ *
+ * SYNOPSIS:
+ *    void DisplayText::GetScrollRegion(int &Top,int &Bottom);
+ *
+ * PARAMETERS:
+ *    Top [O] -- The first screen line of the scroll region
+ *    Bottom [O] -- The screen line after the last line of the region
+ *
+ * FUNCTION:
+ *    This function gets the lines that scroll when the cursor moves off the
+ *    bottom margin.  If there is no region then this is the whole screen.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::SetScrollRegion()
+ ******************************************************************************/
+void DisplayText::GetScrollRegion(int &Top,int &Bottom)
+{
+    Top=ScrollRegionTop;
+    Bottom=ScrollRegionBottom;
+    if(Bottom==0 || Bottom>ScreenHeightChars)
+        Bottom=ScreenHeightChars;
+    if(Top>=Bottom)
+        Top=0;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::SetScrollRegion
+ *
+ * SYNOPSIS:
+ *    void DisplayText::SetScrollRegion(uint32_t Top,uint32_t Bottom);
+ *
+ * PARAMETERS:
+ *    Top [I] -- The first screen line of the scroll region
+ *    Bottom [I] -- The screen line after the last line of the region.  0
+ *                  removes the region.
+ *
+ * FUNCTION:
+ *    This function sets the top and bottom margins (DECSTBM).  A new line on
+ *    the bottom margin scrolls just the lines in the region and nothing
+ *    is added to the scroll back buffer.  A region that covers the whole
+ *    screen is the same as no region.
+ *
+ *    Bad regions are ignored.  The cursor isn't moved.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::MoveToNextLine(), DisplayText::SetAltScreen()
+ ******************************************************************************/
+void DisplayText::SetScrollRegion(uint32_t Top,uint32_t Bottom)
+{
+    if(Bottom!=0 && (Top>=Bottom || Top>=(uint32_t)ScreenHeightChars))
+        return;
+
+    if(Top==0 && Bottom>=(uint32_t)ScreenHeightChars)
+        Bottom=0;
+    if(Bottom==0)
+        Top=0;
+
+    ScrollRegionTop=Top;
+    ScrollRegionBottom=Bottom;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::SetAltScreen
+ *
+ * SYNOPSIS:
+ *    void DisplayText::SetAltScreen(bool On);
+ *
+ * PARAMETERS:
+ *    On [I] -- true = switch to the alternate screen, false = switch back to
+ *              the normal screen.
+ *
+ * FUNCTION:
+ *    This function switches between the normal and alternate screens.
+ *
+ *    When the alternate screen goes up the normal screen's lines are moved
+ *    to 'AltSavedScreen' and a blank screen takes their place.  The back
+ *    buffer isn't touched and while the alternate screen is up nothing is
+ *    scrolled into it.  When we switch back the alternate screen is thrown
+ *    away and the normal screen's lines are moved back.
+ *
+ *    The cursor stays where it is (the term emulation saves and restores
+ *    it if it wants).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DisplayText::SetScrollRegion()
+ ******************************************************************************/
+void DisplayText::SetAltScreen(bool On)
+{
+    struct TextLine BlankLine;
+    int r;
+
+    if(On==AltScreenActive)
+        return;
+
+    try
+    {
+        /* Make sure we have a full screen of lines to swap */
+        PadOutScreenWithBlankLines();
+
+        if(On)
+        {
+            AltSavedScreen.clear();
+            ForgetLineWidths(ScreenFirstLine,Lines.end());
+            AltSavedScreen.splice(AltSavedScreen.end(),Lines,ScreenFirstLine,
+                    Lines.end());
+
+            BlankLine.LineBackgroundColor=CurrentStyle.BGColor;
+            BlankLine.LineWidthPx=0;
+            BlankLine.EOL=e_DTEOL_Hard;
+            BlankLine.EOLGuess=e_DTEOLGuess_Unknown;
+            for(r=0;r<ScreenHeightChars;r++)
+                Lines.push_back(BlankLine);
+        }
+        else
+        {
+            ForgetLineWidths(ScreenFirstLine,Lines.end());
+            Lines.erase(ScreenFirstLine,Lines.end());
+            NoteLineWidths(AltSavedScreen.begin(),AltSavedScreen.end());
+            Lines.splice(Lines.end(),AltSavedScreen);
+        }
+        AltScreenActive=On;
+
+        LinesCount=Lines.size();
+        ScreenFirstLine=Lines.end();
+        for(r=0;r<ScreenHeightChars && ScreenFirstLine!=Lines.begin();r++)
+            ScreenFirstLine--;
+
+        /* Scroll the window to be at the bottom */
+        TopLine=ScreenFirstLine;
+        if(LinesCount>=ScreenHeightChars)
+            TopLineY=LinesCount-ScreenHeightChars;
+        else
+            TopLineY=0;
+
+        RethinkAfterScreenLinesMoved();
+        InvalidateAllMarks();
+        RethinkScrollBars();
+
+        MoveCursor(CursorX,CursorY,false);
+        RedrawFullScreen();
+    }
+    catch(...)
+    {
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::RethinkAfterScreenLinesMoved
  *
  * SYNOPSIS:
- *    void DisplayText::ScrollVertAreaUp(uint32_t X1,uint32_t Y1,uint32_t X2,
- *          uint32_t Y2,int32_t dy);
+ *    void DisplayText::RethinkAfterScreenLinesMoved(void);
  *
  * PARAMETERS:
- *    X1 [I] -- The left edge
- *    Y1 [I] -- The top edge
- *    X2 [I] -- The right edge
- *    Y2 [I] -- The bottom edge
- *    dy [I] -- The amount to scroll
+ *    NONE
  *
  * FUNCTION:
- *    This function scrolls an area up (text moves up, like a normal scroll
- *    of a screen).
+ *    This function fixes up the things that point at lines in the screen
+ *    area after lines where moved around in 'Lines' (instead of having
+ *    their frags copied).  'ScreenFirstLine' must already be right.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    DisplayText::ScrollArea()
+ *    DisplayText::ScrollVertAreaUp(), DisplayText::SetAltScreen()
  ******************************************************************************/
-void DisplayText::ScrollVertAreaUp(uint32_t X1,uint32_t Y1,uint32_t X2,
-        uint32_t Y2,int32_t dy)
+void DisplayText::RethinkAfterScreenLinesMoved(void)
 {
-    i_TextLines TopLineOfArea;
-    i_TextLines BottomLineOfArea;
-    i_TextLines CurLine;
-    i_TextLines CopyFromLine;
-    i_TextLines CopyToLine;
-    i_TextLineFrags InsertAfterFrag;
-    i_TextLineFrags StartFrag;
-    i_TextLineFrags EndFrag;
-    int_fast32_t y;
-    int_fast32_t r;
-    int_fast32_t AreaHeight;
-    int_fast32_t AreaWidth;
-
-    if(Y2<=Y1)
-    {
-        /* Nothing to do */
-        return;
-    }
-
-    AreaHeight=Y2-Y1;
-    if(AreaHeight>ScreenHeightChars)
-        AreaHeight=ScreenHeightChars-Y1;
-
-    AreaWidth=X2-X1;
-    if(AreaWidth>ScreenWidthChars)
-        AreaWidth=ScreenWidthChars-X1;
-
-    /* Find the top line */
-    TopLineOfArea=ScreenFirstLine;
-    for(y=0;y<Y1 && TopLineOfArea!=Lines.end();y++)
-        TopLineOfArea++;
-    if(TopLineOfArea==Lines.end())
-    {
-        /* We don't have enough lines, we are below the of the lines, so we
-           are done */
-        return;
-    }
-
-    /* Find the bottom line */
-    BottomLineOfArea=TopLineOfArea;
-    if(Y2>0)
-    {
-        for(;y<Y2-1 && BottomLineOfArea!=Lines.end();y++)
-            BottomLineOfArea++;
-
-        if(BottomLineOfArea==Lines.end())
-            BottomLineOfArea--;
-    }
-
-    /*********************************/
-    /*** First delete from the top ***/
-    /*********************************/
-    CurLine=TopLineOfArea;
-    for(r=0;r<dy && CurLine!=Lines.end();r++)
-    {
-        TextLine_ErasePos2Pos(CurLine,X1,X2);
-        CurLine++;
-    }
-
-    /***********************************/
-    /*** Shift the lines up (scroll) ***/
-    /***********************************/
-    /* Move the lines (working from the top) */
-    CopyToLine=TopLineOfArea;
+    int ScreenFirstLineY;
+    int y;
 
-    /* Move the copy from line up by the scroll amount */
-    CopyFromLine=TopLineOfArea;
-    for(r=0;r<dy && CopyFromLine!=Lines.end();r++)
-        CopyFromLine++;
+    if(LinesCount<ScreenHeightChars)
+        ScreenFirstLineY=0;
+    else
+        ScreenFirstLineY=LinesCount-ScreenHeightChars;
 
-    for(r=0;r<AreaHeight-dy && CopyFromLine!=Lines.end();r++)
+    /* 'TopLine' may have been one of the lines that moved */
+    if(TopLineY>=ScreenFirstLineY)
     {
-        TextLine_SplitFrag(CopyFromLine,X2,false,NULL,&EndFrag);
-        TextLine_SplitFrag(CopyFromLine,X1,false,NULL,&StartFrag);
-
-        /* Make sure we have enough room on the line to insert the frag's */
-        PadOutLine(&*CopyToLine,X1);
-
-        TextLine_SplitFrag(CopyToLine,X1,false,NULL,&InsertAfterFrag);
-
-        CopyToLine->Frags.insert(InsertAfterFrag,StartFrag,EndFrag);
-        CopyFromLine->Frags.erase(StartFrag,EndFrag);
-
-        CopyFromLine++;
-        CopyToLine++;
+        TopLine=ScreenFirstLine;
+        for(y=ScreenFirstLineY;y<TopLineY && TopLine!=Lines.end();y++)
+            TopLine++;
     }
 
-    /**************************************************************/
-    /*** Fill in blank lines to fill in the holes at the bottom ***/
-    /**************************************************************/
-    CurLine=BottomLineOfArea;
-    for(r=0;r<dy;r++)
-    {
-        TextLine_Fill(CurLine,X1,AreaWidth,&CurrentStyle," ");
+    /* Same for the selection extract (it will report the copy failed) */
+    if(SelExtractActive && SelExtract_NextY-LinesBase>=ScreenFirstLineY)
+        StopSelectionExtract();
 
-        if(CurLine==Lines.begin())
-        {
-            /* We just did the top line, nothing above this, abort */
-            break;
-        }
-        CurLine--;
-    }
+    /* 'ActiveLine' is still a good line, but it might not be at the cursor
+       any more */
+    ActiveLineY=-1;
+    RethinkInsertFrag();
 }
 
 /*******************************************************************************
@@ -6531,7 +7841,86 @@ void DisplayText::TextLine_Fill(i_TextLines Line,int_fast32_t Offset,
 void DisplayText::TextLine_Clear(i_TextLines Line)
 {
     Line->Frags.clear();
-    Line->LineWidthPx=0;
+    SetLineWidthPx(&*Line,0);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::TextLine_AppendText
+ *
+ * SYNOPSIS:
+ *    void DisplayText::TextLine_AppendText(i_TextLines Line,
+ *              int_fast32_t StartOffset,int_fast32_t EndOffset,
+ *              std::string &Out);
+ *
+ * PARAMETERS:
+ *    Line [I] -- The line to get the text from
+ *    StartOffset [I] -- The first char to get (in chars)
+ *    EndOffset [I] -- Stop before this char (in chars).  -1 for the end of
+ *                     the line.
+ *    Out [I/O] -- The text is appended to this string
+ *
+ * FUNCTION:
+ *    This function appends the text from part of a line to a string.  Only
+ *    string frags are copied.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    GetStringBetweenPoints(), GetSelectionChunk()
+ ******************************************************************************/
+void DisplayText::TextLine_AppendText(i_TextLines Line,int_fast32_t StartOffset,
+        int_fast32_t EndOffset,std::string &Out)
+{
+    i_TextLineFrags StartFrag;
+    i_TextLineFrags EndFrag;
+    i_TextLineFrags CurFrag;
+    int_fast32_t StartPos;
+    int_fast32_t EndPos;
+
+    if(StartOffset==0)
+    {
+        /* Most of the lines we are asked for start at the left edge, so we
+           don't need to search for it */
+        StartFrag=Line->Frags.begin();
+        while(StartFrag!=Line->Frags.end() &&
+                StartFrag->FragType!=e_TextCanvasFrag_String)
+        {
+            StartFrag++;
+        }
+        StartPos=0;
+    }
+    else
+    {
+        TextLine_FindFragAndPos(Line,StartOffset,&StartFrag,&StartPos);
+    }
+    if(StartFrag==Line->Frags.end())
+    {
+        /* Starts past the end of the line */
+        return;
+    }
+
+    EndFrag=Line->Frags.end();
+    EndPos=0;
+    if(EndOffset>=0)
+        TextLine_FindFragAndPos(Line,EndOffset,&EndFrag,&EndPos);
+
+    if(StartFrag==EndFrag)
+    {
+        Out.append(StartFrag->Text,StartPos,EndPos-StartPos);
+        return;
+    }
+
+    Out.append(StartFrag->Text,StartPos,string::npos);
+
+    CurFrag=StartFrag;
+    for(CurFrag++;CurFrag!=EndFrag;CurFrag++)
+        if(CurFrag->FragType==e_TextCanvasFrag_String)
+            Out.append(CurFrag->Text);
+
+    if(EndFrag!=Line->Frags.end())
+        Out.append(EndFrag->Text,0,EndPos);
 }
 
 /*******************************************************************************
@@ -7570,11 +8959,11 @@ void DisplayText::AdvancePoint(int &PX,int &PY,int Amount,int MinX,
  * PARAMETERS:
  *    PX [I/O] -- The X point to move.  This will be changed to the start of
  *                the word.
- *    PY [I/O] -- The Y point.  If X goes before the start of the line or
- *                past the end this will be changed.  This will be changed to
- *                the start of the word.
+ *    PY [I/O] -- The Y point (absolute line, like the selection).  If X goes
+ *                before the start of the line or past the end this will be
+ *                changed.  This will be changed to the start of the word.
  *    PX2 [O] -- The end of the word.
- *    PY2 [O] -- The end of the word.
+ *    PY2 [O] -- The end of the word (absolute line).
  *
  * FUNCTION:
  *    This function finds the start and end of the word under a point.
@@ -7595,6 +8984,12 @@ void DisplayText::FindWordStartEndPoints(int &PX,int &PY,int &PX2,int &PY2)
     struct DTPoint Point;
     int TmpY;
 
+    /* We work with absolute lines (selection) convert to offsets into
+       'Lines' */
+    PY-=LinesBase;
+    if(PY<0)
+        PY=0;
+
     PX2=PX;
     PY2=PY;
 
@@ -7664,6 +9059,9 @@ void DisplayText::FindWordStartEndPoints(int &PX,int &PY,int &PX2,int &PY2)
                 break;
         }
     }
+
+    PY+=LinesBase;
+    PY2+=LinesBase;
 }
 
 /*******************************************************************************
@@ -7799,9 +9197,9 @@ void DisplayText::InvalidateOutOfRangeMarks(void)
     {
         if(Marker->Valid)
         {
-            if(Marker->Y<ScreenFirstLineY)
+            if(Marker->Y-LinesBase<ScreenFirstLineY)
                 Marker->Valid=false;
-            if(Marker->Y>=LinesCount)
+            if(Marker->Y-LinesBase>=LinesCount)
                 Marker->Valid=false;
             if(Marker->X>=ScreenWidthChars)
                 Marker->Valid=false;
@@ -8009,7 +9407,7 @@ void DisplayText::SetMark2CursorPos(t_DataProMark *Mark)
 
     Marker->Valid=true;
     Marker->X=CursorX;
-    Marker->Y=CursorGlobalY;
+    Marker->Y=LinesBase+CursorGlobalY;
 }
 
 /*******************************************************************************
@@ -8134,6 +9532,190 @@ void DisplayText::ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,
     DoApplyToMark(Mark,BGColor,Offset,Len,DTXT_APPLY_BACKGROUND);
 }
 
+/* Used to stable sort the style segments by line */
+static bool DisplayText_StyleSegLineLess(const struct DTStyleSeg &a,
+        const struct DTStyleSeg &b)
+{
+    return a.Y<b.Y;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::ApplyStyleSpans2Mark
+ *
+ * SYNOPSIS:
+ *    void DisplayText::ApplyStyleSpans2Mark(t_DataProMark *Mark,
+ *              const struct DPS_StyleSpan *Spans,uint32_t Count);
+ *
+ * PARAMETERS:
+ *    Mark [I] -- The mark to work on
+ *    Spans [I] -- The spans to apply
+ *    Count [I] -- The number of entries in 'Spans'
+ *
+ * FUNCTION:
+ *    This function does the DPS_ApplyStyleSpans2Mark() function to the
+ *    display.
+ *
+ *    Instead of doing each span with ChangeAttribsBetweenPoints() (which
+ *    finds the line, splits and walks the frags for every span, and then
+ *    redraws the screen) we break all the spans into per line segments,
+ *    sort them by line (keeping the order on the line), and then do each
+ *    line in one pass.  The screen is only redrawn once at the end.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    DPS_ApplyStyleSpans2Mark(), ApplyStyleSegs2Line()
+ ******************************************************************************/
+void DisplayText::ApplyStyleSpans2Mark(t_DataProMark *Mark,
+        const struct DPS_StyleSpan *Spans,uint32_t Count)
+{
+    struct TextPointMarker *Marker=(struct TextPointMarker *)Mark;
+    struct DTStyleSeg NewSeg;
+    struct DTPoint Pos;
+    i_DTStyleSegs Seg;
+    i_DTStyleSegs EndOfLineSegs;
+    i_TextLines HintLine;
+    int HintY;
+    int PX;
+    int PY;
+    int StopX;
+    int StopY;
+    int y;
+    uint32_t s;
+
+    if(!Marker->Valid || Count==0)
+        return;
+
+    try
+    {
+        /* Break the spans into segments that are on 1 line */
+        StyleSegs.clear();
+        for(s=0;s<Count;s++)
+        {
+            GetMarkMinMaxPoints(Marker,PX,PY,StopX,StopY,Spans[s].Offset,
+                    Spans[s].Len);
+
+            for(y=PY;y<=StopY;y++)
+            {
+                NewSeg.Y=y;
+                NewSeg.X1=(y==PY)?PX:0;
+                NewSeg.X2=(y==StopY)?StopX:-1;
+                NewSeg.Span=&Spans[s];
+
+                /* Skip empty segments */
+                if(NewSeg.X2>=0 && NewSeg.X2<=NewSeg.X1)
+                    continue;
+
+                StyleSegs.push_back(NewSeg);
+            }
+        }
+
+        /* Group by line.  This has to be stable so overlapping spans are
+           applied in the order we got them */
+        std::stable_sort(StyleSegs.begin(),StyleSegs.end(),
+                DisplayText_StyleSegLineLess);
+
+        HintLine=Lines.end();
+        HintY=0;
+        for(Seg=StyleSegs.begin();Seg!=StyleSegs.end();Seg=EndOfLineSegs)
+        {
+            for(EndOfLineSegs=Seg;EndOfLineSegs!=StyleSegs.end() &&
+                    EndOfLineSegs->Y==Seg->Y;EndOfLineSegs++)
+            {
+            }
+
+            if(!FindPoint(0,Seg->Y,Pos,HintLine,HintY))
+                continue;
+
+            /* The next line will be close to this one */
+            HintLine=Pos.Line;
+            HintY=Pos.LineY;
+
+            ApplyStyleSegs2Line(Pos.Line,Seg,EndOfLineSegs);
+        }
+    }
+    catch(...)
+    {
+    }
+
+    RedrawFullScreen();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    DisplayText::ApplyStyleSegs2Line
+ *
+ * SYNOPSIS:
+ *    void DisplayText::ApplyStyleSegs2Line(i_TextLines Line,
+ *              i_DTStyleSegs FirstSeg,i_DTStyleSegs EndSeg);
+ *
+ * PARAMETERS:
+ *    Line [I] -- The line to apply the styles to
+ *    FirstSeg [I] -- The first segment on this line
+ *    EndSeg [I] -- One past the last segment on this line
+ *
+ * FUNCTION:
+ *    This is a helper function for ApplyStyleSpans2Mark().  It splits the
+ *    frags on this line at the edges of all the segments, and then walks
+ *    the frags once applying the style of every segment that covers each
+ *    frag.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ApplyStyleSpans2Mark(), ChangeAttribsBetweenPoints()
+ ******************************************************************************/
+void DisplayText::ApplyStyleSegs2Line(i_TextLines Line,i_DTStyleSegs FirstSeg,
+        i_DTStyleSegs EndSeg)
+{
+    i_DTStyleSegs Seg;
+    i_TextLineFrags CurFrag;
+    const struct DPS_StyleSpan *Span;
+    int CalX;
+
+    /* Split at all the edges first so every frag is all in or all out of
+       each segment */
+    for(Seg=FirstSeg;Seg!=EndSeg;Seg++)
+    {
+        TextLine_SplitFrag(Line,Seg->X1,false,NULL,NULL);
+        if(Seg->X2>=0)
+            TextLine_SplitFrag(Line,Seg->X2,false,NULL,NULL);
+    }
+
+    CalX=0;
+    for(CurFrag=Line->Frags.begin();CurFrag!=Line->Frags.end();CurFrag++)
+    {
+        if(CurFrag->FragType!=e_TextCanvasFrag_String)
+            continue;
+
+        for(Seg=FirstSeg;Seg!=EndSeg;Seg++)
+        {
+            if(CalX<Seg->X1 || (Seg->X2>=0 && CalX>=Seg->X2))
+                continue;
+
+            Span=Seg->Span;
+            if(Span->What&DPS_STYLESPAN_SET_ATTRIBS)
+            {
+                CurFrag->Styling.Attribs|=Span->Attribs;
+                /* Make sure to also set the uline color */
+                CurFrag->Styling.ULineColor=CurFrag->Styling.FGColor;
+            }
+            if(Span->What&DPS_STYLESPAN_CLR_ATTRIBS)
+                CurFrag->Styling.Attribs&=~Span->Attribs;
+            if(Span->What&DPS_STYLESPAN_FGCOLOR)
+                CurFrag->Styling.FGColor=Span->FGColor;
+            if(Span->What&DPS_STYLESPAN_BGCOLOR)
+                CurFrag->Styling.BGColor=Span->BGColor;
+        }
+
+        CalX+=utf8::unchecked::distance(CurFrag->Text.begin(),
+                CurFrag->Text.end());
+    }
+}
+
 /*******************************************************************************
  * NAME:
  *    DisplayText::MoveMark
@@ -8168,7 +9750,7 @@ void DisplayText::MoveMark(t_DataProMark *Mark,int Amount)
 
     GetMarkMinMaxPoints(Marker,PX,PY,StopX,StopY,Amount,0);
     Marker->X=PX;
-    Marker->Y=PY;
+    Marker->Y=LinesBase+PY;
 }
 
 /*******************************************************************************
@@ -8263,7 +9845,9 @@ void DisplayText::GetMarkMinMaxPoints(struct TextPointMarker *Marker,
 
     /* Move by offset */
     PX=Marker->X;
-    PY=Marker->Y;
+    PY=Marker->Y-LinesBase;
+    if(PY<0)
+        PY=0;
     AdvancePoint(PX,PY,Offset,0,ScreenFirstLineY,MaxCursorX,MaxCursorY);
 
     /* Figure out where to stop by adding 'Len' to the current point */
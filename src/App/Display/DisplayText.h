@@ -38,6 +38,9 @@
 #include <stdint.h>
 #include <string>
 #include <list>
+#include <map>
+#include <vector>
+#include <unordered_map>
 
 /***  DEFINES                          ***/
 #define DTXT_APPLY_SET_ATTRIB   0x0001
@@ -46,6 +49,11 @@
 #define DTXT_APPLY_BACKGROUND   0x0008
 #define DTXT_APPLY_ULINE_COLOR  0x0010
 
+/* Chars below this have their width cached in a table, the rest in a map */
+#define DTXT_WIDTHCACHE_DIRECT  0x800
+/* Bold, italic, and force can change the width of a char (2^3 styles) */
+#define DTXT_WIDTHCACHE_STYLES  8
+
 /***  MACROS                           ***/
 
 /***  TYPE DEFINITIONS                 ***/
@@ -95,11 +103,23 @@ struct TextPointMarker
 {
     bool Valid;
     int X;      // The marker left pos (in chars)
-    int Y;      // The marker top pos (in lines)
+    int Y;      // The marker top pos (absolute line, see 'LinesBase')
     struct TextPointMarker *Prev;
     struct TextPointMarker *Next;
 };
 
+/* Part of a DPS_StyleSpan that lands on one line */
+struct DTStyleSeg
+{
+    int Y;                              // The line (from top of buffer)
+    int X1;                             // First char to style
+    int X2;                             // Stop before this char (-1=end of line)
+    const struct DPS_StyleSpan *Span;
+};
+
+typedef std::vector<struct DTStyleSeg> t_DTStyleSegs;
+typedef t_DTStyleSegs::iterator i_DTStyleSegs;
+
 struct DTPoint
 {
     i_TextLines Line;               // The line in 'Lines'
@@ -108,6 +128,9 @@ struct DTPoint
     int_fast32_t StrPos;            // The offset into 'Frag' string
 };
 
+typedef std::unordered_map<uint32_t,int> t_DTCharWidthMapType;
+typedef t_DTCharWidthMapType::iterator i_DTCharWidthMapType;
+
 typedef enum
 {
     e_DTSelectMode_Letter,
@@ -156,7 +179,8 @@ class DisplayText : public DisplayBase
         bool Init(void *ParentWidget,class ConSettings *SettingsPtr,bool (*EventCallback)(const struct DBEvent *Event),uintptr_t UserData);
         void Reparent(void *NewParentWidget);
         void WriteChar(uint8_t *Chr);
-        void WriteCharWithOptions(uint8_t *Chr,bool AdvCursor);
+        void WriteChars(const uint8_t *Chrs,int Count);
+        void WriteCharWithOptions(uint8_t *Chr,bool AdvCursor,bool Redraw);
         void NoteNonPrintable(const char *NoteStr);
         void SetShowNonPrintable(bool Show);
         void SetShowEndOfLines(bool Show);
@@ -178,6 +202,8 @@ class DisplayText : public DisplayBase
         void SetOverrideMessage(const char *Msg);
         void SetInfoMessage(const char *Msg,uint32_t BG,uint32_t FG,e_UITCIM_PosType Pos);
         void ScrollArea(uint32_t X1,uint32_t Y1,uint32_t X2,uint32_t Y2,int32_t dx,int32_t dy);
+        void SetScrollRegion(uint32_t Top,uint32_t Bottom);
+        void SetAltScreen(bool On);
         void InsertHorizontalRule(void);
         void ResetTerm(void);
         void SetupCanvas(void);
@@ -189,6 +215,11 @@ class DisplayText : public DisplayBase
         void ApplyBGColor2Selection(uint32_t RGB);
         bool IsAttribSetInSelection(uint32_t Attribs);
         uint8_t *GetSelectionRAW(unsigned int *Bytes);
+        int GetSelectionLineCount(void);
+        bool StartSelectionExtract(void);
+        bool GetSelectionChunk(std::string &Chunk,unsigned int MaxBytes,bool &Done);
+        void GetSelectionExtractProgress(uint64_t *Done,uint64_t *Total);
+        void StopSelectionExtract(void);
         void GetScreenSize(uint32_t *Width,uint32_t *Height);
 
         t_DataProMark *AllocateMark(void);
@@ -199,6 +230,7 @@ class DisplayText : public DisplayBase
         void RemoveAttribFromMark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Offset,uint32_t Len);
         void ApplyFGColor2Mark(t_DataProMark *Mark,uint32_t FGColor,uint32_t Offset,uint32_t Len);
         void ApplyBGColor2Mark(t_DataProMark *Mark,uint32_t BGColor,uint32_t Offset,uint32_t Len);
+        void ApplyStyleSpans2Mark(t_DataProMark *Mark,const struct DPS_StyleSpan *Spans,uint32_t Count);
         void MoveMark(t_DataProMark *Mark,int Amount);
         const uint8_t *GetMarkString(t_DataProMark *Mark,uint32_t *Size,uint32_t Offset,uint32_t Len);
 
@@ -224,6 +256,8 @@ class DisplayText : public DisplayBase
         bool InitCalled;
         std::string TmpStr; // A temp string (so we don't have keep allocating it)
         std::string TmpStr2; // A temp string (so we don't have keep allocating it)
+        struct TextCanvasLine CanvasLineBuild;  // DrawLine() builds the line here before we share it
+        std::vector<t_TextCanvasLineRef> CanvasRows; // The last snapshot we sent for each screen line
         struct UITimer *ScrollTimer;
         bool LastSeenLF;
         bool LastSeenCR;
@@ -237,6 +271,10 @@ class DisplayText : public DisplayBase
         int CharWidthPx;
         int CharHeightPx;
 
+        /* Px width of each char for the current font (-1 = not measured yet) */
+        int16_t CharWidthCache[DTXT_WIDTHCACHE_STYLES][DTXT_WIDTHCACHE_DIRECT];
+        t_DTCharWidthMapType CharWidthMap;  // (CodePoint<<3)|Style for chars past DTXT_WIDTHCACHE_DIRECT
+
         /* Cursor */
         int CursorX;                // In chars
         int CursorY;
@@ -258,6 +296,10 @@ class DisplayText : public DisplayBase
         i_TextLines ScreenFirstLine;    // The line the cursor lives in below
         struct TextLine *ActiveLine;    // The line with the cursor on it
         int ActiveLineY;                // What line count (from 'ScreenFirstLine') is 'ActiveLine'
+        int ScrollRegionTop;            // The first screen line of the scroll region (DECSTBM)
+        int ScrollRegionBottom;         // The screen line after the last line of the region (0 = no region)
+        bool AltScreenActive;           // Is the alternate screen up (nothing goes to the back buffer)
+        t_TextLines AltSavedScreen;     // The normal screen's lines while the alternate screen is up
 
         /* Window (the area the user is looking at) */
         int WindowHeightChars;
@@ -266,27 +308,40 @@ class DisplayText : public DisplayBase
         int TopLineY;                   // The number of lines from the top of 'Lines' that 'TopLine' is on
 
         /* Lines */
-        int LongestLinePx;
+        int LongestLinePx;              // The biggest key in 'LineWidthCounts' (cached)
+        std::map<int,int> LineWidthCounts; // How many lines in 'Lines' are each width in px (0 width lines are not counted)
         t_TextLines Lines;
         int LinesCount;                 // Lines.size(), but tracked (faster)
+        int LinesBase;                  // The absolute line number of the first line in 'Lines'.  Marks and the selection use absolute line numbers so dropping old lines doesn't touch them
+        int CanvasTopLineAbsY;          // The absolute line that was drawn at the top of the canvas (-1 = unknown).  Used to scroll the canvas instead of redrawing it
+        int CanvasLinesDrawn;           // The number of lines drawn on the canvas by the last RedrawFullScreen()
         i_TextLineFrags InsertFrag;
         int InsertPos;                  // The offset into the current string frag's 'Text' (also used as a flag see DisplayText::RethinkInsertFrag())
 
         /* Selection */
         bool SelectionActive;           // Is there an active selection (may not be valid, but we are selecting something)
         int Selection_X;                // The selection left pos (in chars)
-        int Selection_Y;                // The selection top pos (in lines)
+        int Selection_Y;                // The selection top pos (absolute line)
         int Selection_AnchorX;          // The selection end left pos (in chars)
-        int Selection_AnchorY;          // The selection end top pos (in lines)
+        int Selection_AnchorY;          // The selection end top pos (absolute line)
         e_DTSelectModeType SelectMode;  // What are we selecting
         int Selection_StartX1;          // Only used when selection word/line
         int Selection_StartY1;
         int Selection_StartX2;
         int Selection_StartY2;
 
+        /* Selection extract (see StartSelectionExtract()) */
+        int SelExtract_FirstY;          // The first line of the extract (absolute line)
+        int SelExtract_EndX;            // Where the extract stops (in chars)
+        int SelExtract_EndY;            // The last line of the extract (absolute line)
+        int SelExtract_NextX;           // Where the next chunk starts (in chars)
+        int SelExtract_NextY;           // The line the next chunk starts on (absolute line)
+        i_TextLines SelExtract_NextLine;// 'SelExtract_NextY' in 'Lines' (only valid while 'SelExtract_NextY' is still in the buffer)
+
         /* Markers */
         struct TextPointMarker *MarkerList;
         std::string GetMarkTextBuffer;
+        t_DTStyleSegs StyleSegs;        // Only used in ApplyStyleSpans2Mark() (kept to save allocs)
 
         bool DoTextDisplayCtrlEvent(const struct TextDisplayEvent *Event);
         void DoScrollTimerTimeout(void);
@@ -300,10 +355,21 @@ class DisplayText : public DisplayBase
         void RethinkWindowSize(void);
         void RethinkLineLengths(void);
         void ReFindLongestLineLength(void);
+        void SetLineWidthPx(struct TextLine *Line,int WidthPx);
+        void AddLineWidth(int WidthPx);
+        void RemoveLineWidth(int WidthPx);
+        void ForgetLineWidths(i_TextLines First,i_TextLines Last);
+        void NoteLineWidths(i_TextLines First,i_TextLines Last);
+        void RebaseAbsLines(void);
+        void RedrawAfterScroll(void);
+        void RedrawScreenLines(int FirstY,int EndY);
         void MoveCursor(unsigned int x,unsigned y,bool CursorXPxPrecaled);
         void RethinkScrollBars(void);
         int GetLineEndSize(struct TextLine *Line);
         int DrawLine(int LineY,int ScreenLine,struct TextLine *Line);
+        void AddCanvasRun(const struct TextCanvasFrag *Frag);
+        bool CanvasLineMatches(const struct TextCanvasLine *Snapshot);
+        void SendCanvasLine(int ScreenLine);
 
         void HandleDeletingNPAfterOverwrite(void);
 
@@ -317,6 +383,8 @@ class DisplayText : public DisplayBase
         int CharUnderCursorWidthPx(void);
         void ScrollVertAreaDown(uint32_t X1,uint32_t Y1,uint32_t X2,uint32_t Y2,int32_t dy);
         void ScrollVertAreaUp(uint32_t X1,uint32_t Y1,uint32_t X2,uint32_t Y2,int32_t dy);
+        void GetScrollRegion(int &Top,int &Bottom);
+        void RethinkAfterScreenLinesMoved(void);
         void DEBUG_ForceRedrawOfScreen(void);
         int CalcCursorXPx(void);
         bool CheckWordBreak(std::string &Letter);
@@ -356,6 +424,7 @@ class DisplayText : public DisplayBase
         void TextLine_Fill(i_TextLines Line,int_fast32_t Offset,uint_fast32_t Count,const struct CharStyling *Style,const char *Chr);
         void TextLine_Clear(i_TextLines Line);
         int TextLine_FindLineLen(i_TextLines Line);
+        void TextLine_AppendText(i_TextLines Line,int_fast32_t StartOffset,int_fast32_t EndOffset,std::string &Out);
         i_TextLines GetActiveLineIterator(void);
 
         /* Frag handling */
@@ -364,6 +433,11 @@ class DisplayText : public DisplayBase
         i_TextLineFrags AddSpecialFrag(struct TextLineFrag &SpecialFrag);
         i_TextLineFrags InsertSpecialFragInMiddleOfString(struct TextLineFrag &SpecialFrag);
         void RethinkFragWidth(i_TextLineFrags Frag);
+
+        /* Char width cache */
+        void ResetCharWidthCache(void);
+        int GetCharWidthPx(uint32_t CodePoint,const char *Chr,int Bytes,const struct CharStyling *Styling);
+        int GetStringWidthPx(const char *Start,const char *End,const struct CharStyling *Styling);
         bool RethinkInsertFrag(void);
         i_TextLineFrags AddNewEmptyFragToLine(struct TextLine *Line,i_TextLineFrags InsertPoint);
 
@@ -385,6 +459,7 @@ class DisplayText : public DisplayBase
         void InvalidateOutOfRangeMarks(void);
         void DoApplyToMark(t_DataProMark *Mark,uint32_t Attrib,uint32_t Offset,uint32_t Len,uint32_t What);
         void GetMarkMinMaxPoints(struct TextPointMarker *Marker,int &PX,int &PY,int &StopX,int &StopY,uint32_t Offset,uint32_t Len);
+        void ApplyStyleSegs2Line(i_TextLines Line,i_DTStyleSegs FirstSeg,i_DTStyleSegs EndSeg);
 };
 
 /***  GLOBAL VARIABLE DEFINITIONS      ***/
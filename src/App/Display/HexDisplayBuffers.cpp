@@ -33,7 +33,9 @@
 
 /*** HEADER FILES TO INCLUDE  ***/
 #include "App/Display/HexDisplayBuffers.h"
+#include "App/Util/ByteSearch.h"
 #include "App/Util/ClipboardHelpers.h"
+#include "App/Util/PieceTable.h"
 #include "App/Settings.h"
 #include "UI/UIAsk.h"
 #include <string.h>
@@ -141,6 +143,8 @@ HexDisplayBuffer::HexDisplayBuffer()
     DoingDotInputChar=false;
     DoingCycleInputChar=false;
     NibCycleValue=0;
+    EditData=NULL;
+    FlatBufferDirty=false;
 }
 
 /*******************************************************************************
@@ -167,6 +171,9 @@ HexDisplayBuffer::~HexDisplayBuffer()
     if(WeAllocBuffer)
         free(Buffer);
 
+    if(EditData!=NULL)
+        delete EditData;
+
     if(TextDisplayCtrl!=NULL)
         UICTW_FreeCustomTextWidget(TextDisplayCtrl);
 }
@@ -397,6 +404,10 @@ bool HexDisplayBuffer::SetBuffer(uint8_t *Data,int Size)
         memcpy(Buffer,Data,Size);
 
         WeAllocBuffer=true;
+
+        if(!EditData->Load(Buffer,Size))
+            return false;
+        FlatBufferDirty=false;
     }
     else
     {
@@ -453,14 +464,28 @@ void HexDisplayBuffer::SetBufferSize(int Size)
     if(Size<0)
         return;
 
-    SavedBufferSize=BufferSize;
-
-    if(!GrowBufferAsNeeded(Size))
-        return;
-    if(Size>SavedBufferSize)
+    if(EditData!=NULL)
+    {
+        /* The piece table pads with 0's for us */
+        EditData->CheckPoint(Cursor_Pos);
+        if(!EditData->Resize(Size))
+        {
+            EditData->CancelCheckPoint();
+            return;
+        }
+        EditDataChanged();
+    }
+    else
     {
-        /* Ok, fill with 0 */
-        memset(&Buffer[SavedBufferSize],0x00,Size-SavedBufferSize);
+        SavedBufferSize=BufferSize;
+
+        if(!GrowBufferAsNeeded(Size))
+            return;
+        if(Size>SavedBufferSize)
+        {
+            /* Ok, fill with 0 */
+            memset(&Buffer[SavedBufferSize],0x00,Size-SavedBufferSize);
+        }
     }
 
     SetNewBufferSize(Size);
@@ -562,6 +587,7 @@ void HexDisplayBuffer::RebuildDisplay(void)
     bool FirstUseOfStyle;
     struct TextCanvasFrag DisplayFrag;
     struct TextCanvasFrag StyledFrag;
+    uint8_t LineBytes[MAX_BYTESPERLINE];
     int SelectionStart;
     int SelectionEnd;
     uint32_t CursorPosColor;
@@ -653,6 +679,14 @@ void HexDisplayBuffer::RebuildDisplay(void)
 
         StartOfLine=BytesDrawen;
         FirstUseOfStyle=true;
+        if(EditData!=NULL)
+        {
+            /* In edit mode 'Buffer' may be out of date so pull just this
+               line out of the piece table */
+            EditData->Read(StartOfLine,LineBytes,BytesPerLine);
+            CurPos=LineBytes;
+            EndOfBuffPos=LineBytes+sizeof(LineBytes);
+        }
         for(i=0;i<(unsigned int)BytesPerLine && BytesDrawen<BufferBytes2Draw;i++)
         {
             c=*CurPos;
@@ -1894,6 +1928,16 @@ bool HexDisplayBuffer::KeyPress(uint8_t Mods,e_UIKeys Key,
                     DoInsertFromClipboard(e_HDBCFormat_Default);
                     RetValue=true;
                 }
+                if(InEditMode && (TextPtr[0]=='Z' || TextPtr[0]=='z'))
+                {
+                    Undo();
+                    RetValue=true;
+                }
+                if(InEditMode && (TextPtr[0]=='Y' || TextPtr[0]=='y'))
+                {
+                    Redo();
+                    RetValue=true;
+                }
             }
         }
         return RetValue;
@@ -1908,18 +1952,15 @@ bool HexDisplayBuffer::KeyPress(uint8_t Mods,e_UIKeys Key,
                 if(SelectionValid)
                 {
                     /* Erase the selection */
-                    const uint8_t *SelStart;
-                    const uint8_t *SelEnd;
-                    int Bytes2Del;
+                    int SelStart;
+                    int SelEnd;
 
-                    GetSelectionBounds(&SelStart,&SelEnd);
+                    GetSelectionOffsets(&SelStart,&SelEnd);
 
-                    Bytes2Del=SelEnd-SelStart;
-
-                    memmove((void *)SelStart,SelEnd,&Buffer[BufferSize]-SelEnd);
-
-                    SetNewBufferSize(BufferSize-Bytes2Del);
-                    Cursor_Pos=SelStart-Buffer;
+                    EditData->CheckPoint(Cursor_Pos);
+                    EditData->Delete(SelStart,SelEnd-SelStart);
+                    EditDataChanged();
+                    Cursor_Pos=SelStart;
                 }
                 else
                 {
@@ -1930,9 +1971,9 @@ bool HexDisplayBuffer::KeyPress(uint8_t Mods,e_UIKeys Key,
                         AbortDotInput();
 
                         /* Delete the current byte and shorten the buffer */
-                        memmove(&Buffer[Cursor_Pos],&Buffer[Cursor_Pos+1],
-                                BufferSize-Cursor_Pos);
-                        SetNewBufferSize(BufferSize-1);
+                        EditData->CheckPoint(Cursor_Pos);
+                        EditData->Delete(Cursor_Pos,1);
+                        EditDataChanged();
                         LastCursor=-1;  // Force a selection / cursor rethink
                     }
                     else
@@ -1956,9 +1997,9 @@ bool HexDisplayBuffer::KeyPress(uint8_t Mods,e_UIKeys Key,
                     AbortDotInput();
 
                     /* Delete the prev byte and shorten the buffer */
-                    memmove(&Buffer[Cursor_Pos-1],&Buffer[Cursor_Pos],
-                            BufferSize-Cursor_Pos);
-                    SetNewBufferSize(BufferSize-1);
+                    EditData->CheckPoint(Cursor_Pos);
+                    EditData->Delete(Cursor_Pos-1,1);
+                    EditDataChanged();
                     Cursor_Pos--;
                 }
                 else
@@ -2285,7 +2326,8 @@ bool HexDisplayBuffer::KeyPress(uint8_t Mods,e_UIKeys Key,
                         {
                             if(!ReadyForAddingChar())
                                 return true;
-                            StartOfData[Cursor_Pos]=TextPtr[r];
+                            EditData->Replace(Cursor_Pos,&TextPtr[r],1);
+                            EditDataChanged();
                             Cursor_Pos++;
                             ClipCursorPos(false);
                             SendBufferChangeEvent();
@@ -2652,7 +2694,8 @@ void HexDisplayBuffer::EditHandleNibbleInput(int Nib)
             EditMode=e_HDB_EditState_FirstNib;
             EditByteValue&=0xF0;    // Clear the bottom nib
             EditByteValue|=Nib;
-            StartOfData[Cursor_Pos]=EditByteValue;
+            EditData->Replace(Cursor_Pos,&EditByteValue,1);
+            EditDataChanged();
             Cursor_Pos++;
             ClipCursorPos(false);
             SendBufferChangeEvent();
@@ -2744,6 +2787,8 @@ void HexDisplayBuffer::EditHandleNibbleCycle(int Dir)
  *
  *    This also handles the cycle input.
  *
+ *    This is where an undo point is made for the byte being edited.
+ *
  * RETURNS:
  *    true -- Things worked out
  *    false -- We had problems resizing the buffer.  Abort
@@ -2753,25 +2798,18 @@ void HexDisplayBuffer::EditHandleNibbleCycle(int Dir)
  ******************************************************************************/
 bool HexDisplayBuffer::ReadyForAddingChar(void)
 {
-    int BytesAfterCursor;
-
     /* Check if we have anything to do */
     if(DoingCycleInputChar || EditMode!=e_HDB_EditState_FirstNib)
         return true;
 
+    EditData->CheckPoint(Cursor_Pos);
+
     if(InInsertMode)
     {
         /* Ok, we need to insert a blank byte */
-        BytesAfterCursor=BufferSize-Cursor_Pos;
-
-        if(GrowBufferAsNeeded(BufferSize+1))
-        {
-            memmove(&Buffer[Cursor_Pos+1],&Buffer[Cursor_Pos],
-                    BytesAfterCursor);
-            Buffer[Cursor_Pos]=0;
-        }
-        else
+        if(!EditData->InsertFill(Cursor_Pos,0x00,1))
         {
+            EditData->CancelCheckPoint();
             return false;
         }
     }
@@ -2779,10 +2817,15 @@ bool HexDisplayBuffer::ReadyForAddingChar(void)
     {
         if(Cursor_Pos>=BufferSize)
         {
-            if(!GrowBufferAsNeeded(BufferSize+1))
+            if(!EditData->Resize(BufferSize+1))
+            {
+                EditData->CancelCheckPoint();
                 return false;
+            }
         }
     }
+    EditDataChanged();
+
     return true;
 }
 
@@ -2822,7 +2865,8 @@ void HexDisplayBuffer::AcceptCycleInput(void)
         {
             /* We are done entering this byte */
             EditMode=e_HDB_EditState_FirstNib;
-            StartOfData[Cursor_Pos]=EditByteValue;
+            EditData->Replace(Cursor_Pos,&EditByteValue,1);
+            EditDataChanged();
             Cursor_Pos++;
             DoingCycleInputChar=false;
             SendBufferChangeEvent();
@@ -2853,12 +2897,12 @@ void HexDisplayBuffer::AcceptCycleInput(void)
 void HexDisplayBuffer::AbortEdit(void)
 {
     if((EditMode==e_HDB_EditState_SecondNib || DoingCycleInputChar) &&
-            InInsertMode)
+            EditData!=NULL)
     {
-        /* Ok, we have already inserted a byte so we need to undo that */
-        memmove(&Buffer[Cursor_Pos],&Buffer[Cursor_Pos+1],
-                BufferSize-Cursor_Pos-1);
-        SetNewBufferSize(BufferSize-1);
+        /* Ok, we have already started on this byte (and maybe inserted a
+           byte) so go back to the undo point ReadyForAddingChar() made */
+        EditData->CancelCheckPoint();
+        EditDataChanged();
     }
     DoingDotInputChar=false;
     DoingCycleInputChar=false;
@@ -3483,6 +3527,12 @@ bool HexDisplayBuffer::GetSelectionBounds(const uint8_t **StartPtr,
     if(!SelectionValid)
         return false;
 
+    if(StartPtr==NULL && EndPtr==NULL)
+        return true;
+
+    if(!MaterialiseBuffer())
+        return false;
+
     if(Cursor_Pos<Selection_Anchor)
     {
         SelectionStart=Cursor_Pos;
@@ -3523,6 +3573,63 @@ bool HexDisplayBuffer::GetSelectionBounds(const uint8_t **StartPtr,
     return true;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    HexDisplayBuffer::GetSelectionOffsets
+ *
+ * SYNOPSIS:
+ *    bool HexDisplayBuffer::GetSelectionOffsets(int *StartOffset,
+ *              int *EndOffset);
+ *
+ * PARAMETERS:
+ *    StartOffset [O] -- The offset of the first selected byte.  Pass NULL to
+ *                       ignore.
+ *    EndOffset [O] -- The offset of the byte after the last selected byte.
+ *                     Pass NULL to ignore.
+ *
+ * FUNCTION:
+ *    This function is the same as GetSelectionBounds() but gives offsets
+ *    from the start of the data instead of pointers.  This doesn't need the
+ *    flat buffer so it's cheap to call in edit mode.
+ *
+ * RETURNS:
+ *    true -- There is a selection
+ *    false -- There is no selection
+ *
+ * SEE ALSO:
+ *    GetSelectionBounds()
+ ******************************************************************************/
+bool HexDisplayBuffer::GetSelectionOffsets(int *StartOffset,int *EndOffset)
+{
+    int SelectionStart;
+    int SelectionEnd;
+
+    if(!SelectionValid)
+        return false;
+
+    if(Cursor_Pos<Selection_Anchor)
+    {
+        SelectionStart=Cursor_Pos;
+        SelectionEnd=Selection_Anchor;
+    }
+    else
+    {
+        SelectionStart=Selection_Anchor;
+        SelectionEnd=Cursor_Pos+1;
+    }
+
+    /* Keep the selection inside of the valid bytes */
+    if(SelectionEnd>BufferBytes2Draw)
+        SelectionEnd=BufferBytes2Draw;
+
+    if(StartOffset!=NULL)
+        *StartOffset=SelectionStart;
+    if(EndOffset!=NULL)
+        *EndOffset=SelectionEnd;
+
+    return true;
+}
+
 /*******************************************************************************
  * NAME:
  *    HexDisplayBuffer::SetSelectionBounds
@@ -3547,6 +3654,8 @@ bool HexDisplayBuffer::GetSelectionBounds(const uint8_t **StartPtr,
 void HexDisplayBuffer::SetSelectionBounds(const uint8_t *StartPtr,
         const uint8_t *EndPtr)
 {
+    MaterialiseBuffer();
+
     /* Check the pointers */
     if(StartPtr<Buffer || StartPtr>=Buffer+BufferSize)
         return;
@@ -3576,6 +3685,81 @@ void HexDisplayBuffer::SetSelectionBounds(const uint8_t *StartPtr,
     SendSelectionEvent();
 }
 
+/*******************************************************************************
+ * NAME:
+ *    HexDisplayBuffer::FindBytes
+ *
+ * SYNOPSIS:
+ *    bool HexDisplayBuffer::FindBytes(const struct ByteSearchPattern *Pattern);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The bytes to look for (from ByteSearch_ParsePattern())
+ *
+ * FUNCTION:
+ *    This function searches the buffer for the next match of a pattern.  The
+ *    search starts 1 byte after the start of the current selection (or at
+ *    the cursor if there isn't one) and wraps around to the top of the
+ *    buffer.  If a match is found it is selected and scrolled into view.
+ *
+ *    The search is done right on the buffer (which can be circular) so
+ *    there's no copy of the data made.
+ *
+ * RETURNS:
+ *    true -- The pattern was found and selected
+ *    false -- The pattern was not found.
+ *
+ * SEE ALSO:
+ *    SetSelectionBounds(), ByteSearch_FindNextInRing()
+ ******************************************************************************/
+bool HexDisplayBuffer::FindBytes(const struct ByteSearchPattern *Pattern)
+{
+    int DataBytes;
+    int SelStart;
+    size_t From;
+    int64_t Found;
+    bool ShowInAscII;
+
+    if(!MaterialiseBuffer())
+        return false;
+
+    if(Buffer==NULL || StartOfData==NULL)
+        return false;
+
+    DataBytes=GetSizeOfData();
+    if(DataBytes<=0)
+        return false;
+
+    if(GetSelectionOffsets(&SelStart,NULL))
+        From=SelStart+1;
+    else
+        From=Cursor_Pos;
+    if(From>=(size_t)DataBytes)
+        From=0;
+
+    Found=ByteSearch_FindNextInRing(Pattern,Buffer,
+            BufferIsCircular?BufferSize:DataBytes,StartOfData-Buffer,DataBytes,
+            From);
+    if(Found<0)
+        return false;
+
+    ClearSelection();
+
+    Selection_Anchor=Found;
+    Cursor_Pos=Found+Pattern->Len-1;
+    SelectionValid=true;
+
+    /* Show the end and then the start (so the start wins if it doesn't fit) */
+    ShowInAscII=(Pattern->Type!=e_ByteSearchPattern_Hex);
+    MakeOffsetVisable(Cursor_Pos,ShowInAscII,false);
+    MakeOffsetVisable(Selection_Anchor,ShowInAscII,false);
+    RebuildDisplay();
+    RethinkCursorPos();
+
+    SendSelectionEvent();
+
+    return true;
+}
+
 /*******************************************************************************
  * NAME:
  *    HexDisplayBuffer::GetBufferInfo
@@ -3609,7 +3793,11 @@ bool HexDisplayBuffer::GetBufferInfo(const uint8_t **StartOfBuffer,int *Size)
         return false;
 
     if(StartOfBuffer!=NULL)
+    {
+        if(!MaterialiseBuffer())
+            return false;
         *StartOfBuffer=Buffer;
+    }
     if(Size!=NULL)
         *Size=BufferSize;
 
@@ -4163,6 +4351,10 @@ void HexDisplayBuffer::SetLossOfFocusBehavior(bool HideSelection)
  *    If switch to edit mode you must call GetBuffer() to get the buffer as
  *    this class WILL NOT free the buffer.
  *
+ *    While in edit mode the bytes are kept in a piece table (so edits don't
+ *    have to move the rest of the buffer and can be undone).  'Buffer' is
+ *    only brought up to date when someone asks for a pointer into it.
+ *
  * RETURNS:
  *    true -- We have switched to edit mode.
  *    false -- There was a problem switching to edit mode (out of memory,
@@ -4178,8 +4370,6 @@ bool HexDisplayBuffer::SetEditMode(void)
     if(BufferIsCircular)
         return false;
 
-    InEditMode=true;
-
     if(!WeAllocBuffer)
     {
         /* We need to copy the buffer */
@@ -4206,6 +4396,24 @@ bool HexDisplayBuffer::SetEditMode(void)
         WeAllocBuffer=true;
     }
 
+    /* All the edits are done in a piece table */
+    if(EditData==NULL)
+    {
+        try
+        {
+            EditData=new PieceTable;
+        }
+        catch(std::bad_alloc const &)
+        {
+            return false;
+        }
+    }
+    if(!EditData->Load(Buffer,BufferSize))
+        return false;
+    FlatBufferDirty=false;
+
+    InEditMode=true;
+
     RethinkCursorLook();
 
     return true;
@@ -4397,16 +4605,18 @@ void HexDisplayBuffer::SetNewBufferSize(int NewSize)
  ******************************************************************************/
 void HexDisplayBuffer::FillSelectionWithValue(uint8_t Value)
 {
-    const uint8_t *SelStartPtr;
-    const uint8_t *SelEndPtr;
+    int SelStart;
+    int SelEnd;
 
     if(!InEditMode || !SelectionValid)
         return;
 
-    if(GetSelectionBounds(&SelStartPtr,&SelEndPtr))
+    if(GetSelectionOffsets(&SelStart,&SelEnd))
     {
         /* Replace the current selection with the value */
-        memset((void *)SelStartPtr,Value,SelEndPtr-SelStartPtr);
+        EditData->CheckPoint(Cursor_Pos);
+        EditData->Fill(SelStart,Value,SelEnd-SelStart);
+        EditDataChanged();
 
         RebuildDisplay();
         SendBufferChangeEvent();
@@ -4440,8 +4650,7 @@ void HexDisplayBuffer::FillSelectionWithValue(uint8_t Value)
 void HexDisplayBuffer::FillWithValue(int InsertOffset,const uint8_t *Data,
         int Bytes,bool Replace)
 {
-    int BytesAfterInsertPoint;
-    int PreBufferSize;
+    bool Worked;
 
     if(!InEditMode)
         return;
@@ -4449,29 +4658,17 @@ void HexDisplayBuffer::FillWithValue(int InsertOffset,const uint8_t *Data,
     if(InsertOffset>BufferSize)
         return;
 
+    EditData->CheckPoint(Cursor_Pos);
     if(!Replace)
-    {
-        /* Ok, we need to insert space */
-        PreBufferSize=BufferSize;   // Save the size of the buffer before we grow
-
-        if(GrowBufferAsNeeded(BufferSize+Bytes))
-        {
-            BytesAfterInsertPoint=PreBufferSize-InsertOffset;
-
-            memmove(&Buffer[InsertOffset+Bytes],&Buffer[InsertOffset],
-                    BytesAfterInsertPoint);
-        }
-    }
+        Worked=EditData->Insert(InsertOffset,Data,Bytes);
     else
+        Worked=EditData->Replace(InsertOffset,Data,Bytes);
+    if(!Worked)
     {
-        if(InsertOffset+Bytes>=BufferSize)
-        {
-            /* We need to make the buffer bigger */
-            if(!GrowBufferAsNeeded(InsertOffset+Bytes))
-                return;
-        }
+        EditData->CancelCheckPoint();
+        return;
     }
-    memcpy(&Buffer[InsertOffset],Data,Bytes);
+    EditDataChanged();
 
     if(!SelectionValid)
         Cursor_Pos+=Bytes;
@@ -4486,6 +4683,202 @@ void HexDisplayBuffer::FillWithValue(int InsertOffset,const uint8_t *Data,
     SendBufferChangeEvent();
 }
 
+/*******************************************************************************
+ * NAME:
+ *    HexDisplayBuffer::Undo
+ *
+ * SYNOPSIS:
+ *    bool HexDisplayBuffer::Undo(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function undoes the last edit.  Any byte that is half entered is
+ *    thrown away first.  This only works in edit mode.
+ *
+ * RETURNS:
+ *    true -- Something was undone
+ *    false -- There was nothing to undo
+ *
+ * SEE ALSO:
+ *    HexDisplayBuffer::Redo(), HexDisplayBuffer::CanUndo()
+ ******************************************************************************/
+bool HexDisplayBuffer::Undo(void)
+{
+    int NewCursorPos;
+
+    if(!InEditMode)
+        return false;
+
+    AbortDotInput();
+    AbortEdit();
+
+    NewCursorPos=Cursor_Pos;
+    if(!EditData->Undo(NewCursorPos))
+    {
+        RebuildDisplay();
+        RethinkCursorPos();
+        return false;
+    }
+
+    Cursor_Pos=NewCursorPos;
+    EditDataChanged();
+
+    ClipCursorPos(false);
+    ClearSelection();
+    MakeOffsetVisable(Cursor_Pos,InAscIIArea,false);
+    RebuildDisplay();
+    RethinkCursorPos();
+
+    SendBufferChangeEvent();
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HexDisplayBuffer::Redo
+ *
+ * SYNOPSIS:
+ *    bool HexDisplayBuffer::Redo(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function puts back the last edit that was undone.  This only works
+ *    in edit mode.
+ *
+ * RETURNS:
+ *    true -- Something was redone
+ *    false -- There was nothing to redo
+ *
+ * SEE ALSO:
+ *    HexDisplayBuffer::Undo(), HexDisplayBuffer::CanRedo()
+ ******************************************************************************/
+bool HexDisplayBuffer::Redo(void)
+{
+    int NewCursorPos;
+
+    if(!InEditMode)
+        return false;
+
+    AbortDotInput();
+    AbortEdit();
+
+    NewCursorPos=Cursor_Pos;
+    if(!EditData->Redo(NewCursorPos))
+    {
+        RebuildDisplay();
+        RethinkCursorPos();
+        return false;
+    }
+
+    Cursor_Pos=NewCursorPos;
+    EditDataChanged();
+
+    ClipCursorPos(false);
+    ClearSelection();
+    MakeOffsetVisable(Cursor_Pos,InAscIIArea,false);
+    RebuildDisplay();
+    RethinkCursorPos();
+
+    SendBufferChangeEvent();
+
+    return true;
+}
+
+bool HexDisplayBuffer::CanUndo(void)
+{
+    if(!InEditMode)
+        return false;
+    return EditData->CanUndo();
+}
+
+bool HexDisplayBuffer::CanRedo(void)
+{
+    if(!InEditMode)
+        return false;
+    return EditData->CanRedo();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HexDisplayBuffer::EditDataChanged
+ *
+ * SYNOPSIS:
+ *    void HexDisplayBuffer::EditDataChanged(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is called after 'EditData' has been changed.  It marks
+ *    the flat buffer as out of date and updates the buffer size (sending
+ *    events) if it changed.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    HexDisplayBuffer::MaterialiseBuffer()
+ ******************************************************************************/
+void HexDisplayBuffer::EditDataChanged(void)
+{
+    FlatBufferDirty=true;
+    if(EditData->GetSize()!=BufferSize)
+        SetNewBufferSize(EditData->GetSize());
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HexDisplayBuffer::MaterialiseBuffer
+ *
+ * SYNOPSIS:
+ *    bool HexDisplayBuffer::MaterialiseBuffer(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function copies the bytes out of the piece table into 'Buffer' if
+ *    'Buffer' is out of date.  This is only needed when someone wants a
+ *    pointer into the buffer (sending, saving, the CRC dialogs, etc).
+ *
+ * RETURNS:
+ *    true -- 'Buffer' is up to date
+ *    false -- Out of memory.  'Buffer' is still out of date.
+ *
+ * SEE ALSO:
+ *    HexDisplayBuffer::EditDataChanged()
+ ******************************************************************************/
+bool HexDisplayBuffer::MaterialiseBuffer(void)
+{
+    uint8_t *NewBuffer;
+    int Size;
+
+    if(EditData==NULL || !FlatBufferDirty)
+        return true;
+
+    Size=EditData->GetSize();
+    if(Size>BufferAllocatedSize)
+    {
+        NewBuffer=(uint8_t *)realloc(Buffer,Size+100); // 100 extra byte for us to grow into
+        if(NewBuffer==NULL)
+            return false;
+        BufferAllocatedSize=Size+100;
+        Buffer=NewBuffer;
+    }
+    EditData->Read(0,Buffer,Size);
+
+    StartOfData=Buffer;
+    InsertPos=Buffer+Size;
+    FlatBufferDirty=false;
+
+    return true;
+}
+
 /*******************************************************************************
  * NAME:
  *    HexDisplayBuffer::GiveFocus
@@ -4668,6 +5061,9 @@ int HexDisplayBuffer::GetSizeOfData(void)
     uint8_t *BufferEnd;
     int RetValue;
 
+    if(EditData!=NULL)
+        return EditData->GetSize();
+
     if(BufferIsCircular)
     {
         BufferEnd=Buffer+BufferSize;
@@ -4726,6 +5122,12 @@ void HexDisplayBuffer::CopyData2Buffer(uint8_t *OutBuff,int NumOfBytes2Copy)
     if(NumOfBytes2Copy<Bytes)
         Bytes=NumOfBytes2Copy;
 
+    if(EditData!=NULL)
+    {
+        EditData->Read(0,OutBuff,Bytes);
+        return;
+    }
+
     if(BufferIsCircular)
     {
         BufferEnd=Buffer+BufferSize;
@@ -119,6 +119,8 @@ typedef enum
 } e_HDB_EditStateType;
 
 struct HDB_RBD_LineInfo;
+class PieceTable;
+struct ByteSearchPattern;
 
 /***  CLASS DEFINITIONS                ***/
 class HexDisplayBuffer
@@ -149,7 +151,9 @@ class HexDisplayBuffer
         void Enable(bool Enable);
         void ClearSelection(void);
         bool GetSelectionBounds(const uint8_t **StartPtr,const uint8_t **EndPtr);
+        bool GetSelectionOffsets(int *StartOffset,int *EndOffset);
         void SetSelectionBounds(const uint8_t *StartPtr,const uint8_t *EndPtr);
+        bool FindBytes(const struct ByteSearchPattern *Pattern);
         bool GetBufferInfo(const uint8_t **StartOfBuffer,int *Size);
         int GetCursorPos(void);
         void SetCursorPos(int NewPos);
@@ -159,6 +163,10 @@ class HexDisplayBuffer
         void SendSelection2Clipboard(e_ClipboardType Clip,e_HDBCFormatType Format);
         void SetLossOfFocusBehavior(bool HideSelection);
         bool SetEditMode(void);
+        bool Undo(void);
+        bool Redo(void);
+        bool CanUndo(void);
+        bool CanRedo(void);
         void FillSelectionWithValue(uint8_t Value);
         void FillWithValue(int InsertOffset,const uint8_t *Data,int Bytes,bool Replace);
         void DoInsertFromClipboard(e_HDBCFormatType ClipFormat);
@@ -219,6 +227,8 @@ class HexDisplayBuffer
         bool DoingDotInputChar;
         bool DoingCycleInputChar;
         uint8_t NibCycleValue;
+        class PieceTable *EditData; // In edit mode the bytes live here, 'Buffer' is only a flat copy
+        bool FlatBufferDirty;       // 'Buffer' is out of date with 'EditData'
 
         /* View */
         int View_WidthPx;   // The width of the view in pixels
@@ -255,6 +265,8 @@ class HexDisplayBuffer
         void SetNewBufferSize(int NewSize);
         void RebuildDisplay_ClearStyleHelper(struct CharStyling *style);
         void SendBufferChangeEvent(void);
+        bool MaterialiseBuffer(void);
+        void EditDataChanged(void);
 };
 
 /***  GLOBAL VARIABLE DEFINITIONS      ***/
@@ -670,6 +670,9 @@ static void FTPSPIA_ULProgress(t_FTPSystemData *SysHandle,
  *    This function sends a packet out the connection.  This is normally the
  *    next packet for upload.
  *
+ *    This is all or nothing.  If the driver only takes some of the packet
+ *    the connection sends the rest (and says busy until it has).
+ *
  * RETURNS:
  *    e_FTPS_SendDataRet_Success -- Things worked out
  *    e_FTPS_SendDataRet_Fail -- There was an error
@@ -820,6 +823,8 @@ static void FTPSPIA_DLProgress(t_FTPSystemData *SysHandle,
  *    This function sends a packet out the connection.  This is normally the
  *    next packet for upload.
  *
+ *    This is all or nothing, see FTPSPIA_ULSendData().
+ *
  * RETURNS:
  *    e_FTPS_SendDataRet_Success -- Things worked out
  *    e_FTPS_SendDataRet_Fail -- There was an error
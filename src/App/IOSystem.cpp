@@ -33,6 +33,7 @@
 /*** HEADER FILES TO INCLUDE  ***/
 #include "App/IOSystem.h"
 #include "App/MainApp.h"
+#include "App/PerfStats.h"
 #include "App/PluginSupport/PluginUISupport.h"
 #include "App/PluginSupport/SystemSupport.h"
 #include "App/PluginSupport/KeyValueSupport.h"
@@ -103,10 +104,13 @@ struct IOSystemDrvHandle
     bool DrvOpen;
     t_DriverIOHandleType *DriverData;
     t_UIMutex *DataEventMutex;
+    t_UIMutex *DrvCallMutex;        // Only one thread calls the driver at a time
     e_DataEventCodeType *DataEventQueue;
     int DataEventHead;
     int DataEventTail;
     bool DataAvailable;
+    uint64_t DataAvailableTime;     // When the driver flagged DataAvailable (ns)
+    struct PerfStatsCon *PerfStats;
 };
 
 typedef list<t_IOSystemHandle *> t_ActiveHandlesListType;
@@ -401,6 +405,16 @@ static struct ConnectionOptionsData *m_ActiveConSettingsOptionData;
  *    This function is called from a plugin IO driver.  It registers the
  *    plugin with the IO system.
  *
+ *    THREADS:
+ *    The callbacks are called from the main thread, except Write() which
+ *    can also be called from the app's send threads (the transmit pacer
+ *    and the com test).  The IO system never calls Read(), Write(),
+ *    ChangeOptions(), Transmit(), or Close() on the same handle from two
+ *    threads at once, so they don't need to lock against each other.  The
+ *    driver's own threads (and the aux control widgets, which run in the
+ *    main thread) still need their own locking against Write().  Write()
+ *    must not touch the UI.
+ *
  * CALLBACKS:
  *==============================================================================
  * NAME:
@@ -951,7 +965,14 @@ static struct ConnectionOptionsData *m_ActiveConSettingsOptionData;
  *    Bytes [I] -- The number of bytes to write.
  *
  * FUNCTION:
- *    This function writes (sends) data to the device.
+ *    This function writes (sends) data to the device.  It can take less
+ *    than 'Bytes' (return how many it took and the rest will be sent
+ *    later).  If some bytes were taken return the count, not
+ *    RETERROR_BUSY, or they will be sent again.
+ *
+ *    This may be called from a thread other than the main thread.  It is
+ *    never called at the same time as another callback on this handle
+ *    (see THREADS above).
  *
  * RETURNS:
  *    The number of bytes written or:
@@ -1133,6 +1154,31 @@ static struct ConnectionOptionsData *m_ActiveConSettingsOptionData;
  * SEE ALSO:
  *    AllocSettingsWidgets()
  *==============================================================================
+ * NAME:
+ *    Shutdown
+ *
+ * SYNOPSIS:
+ *    void Shutdown(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is optional.
+ *
+ *    This function is called when WhippyTerm is shutting down (only if
+ *    Init() was called).  Any threads the driver started must be stopped
+ *    here, before the plugin's static data is destroyed.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * API VERSION:
+ *    4
+ *
+ * SEE ALSO:
+ *    Init()
+ *==============================================================================
  *
  * RETURNS:
  *    true -- Registration worked
@@ -1289,7 +1335,8 @@ void IOS_Init(void)
  *
  * FUNCTION:
  *    This function is called when the system is shutting down.  It frees
- *    any memory used by this IO system.
+ *    any memory used by this IO system and tells the drivers we are
+ *    shutting down.
  *
  * RETURNS:
  *    NONE
@@ -1299,6 +1346,11 @@ void IOS_Init(void)
  ******************************************************************************/
 void IOS_Shutdown(void)
 {
+    i_IODriverListType drv;
+
+    for(drv=m_IODriverList.begin();drv!=m_IODriverList.end();drv++)
+        if(drv->InitBeenCalled && drv->API.Shutdown!=NULL)
+            drv->API.Shutdown();
 }
 
 /*******************************************************************************
@@ -2376,8 +2428,11 @@ t_IOSystemHandle *IOS_AllocIOSystemHandle(const char *UniqueID,uintptr_t ID)
 
         DrvHandle->DriverData=NULL;
         DrvHandle->DataEventMutex=NULL;
+        DrvHandle->DrvCallMutex=NULL;
         DrvHandle->DataEventQueue=NULL;
         DrvHandle->DeviceUniqueID=UniqueID;
+        DrvHandle->DataAvailableTime=0;
+        DrvHandle->PerfStats=NULL;
 
         DrvHandle->ID=ID;
 
@@ -2414,6 +2469,10 @@ t_IOSystemHandle *IOS_AllocIOSystemHandle(const char *UniqueID,uintptr_t ID)
         if(DrvHandle->DataEventMutex==NULL)
             throw(0);
 
+        DrvHandle->DrvCallMutex=UIAllocMutex();
+        if(DrvHandle->DrvCallMutex==NULL)
+            throw(0);
+
         DrvHandle->DataEventQueue=(e_DataEventCodeType *)
                 malloc(DATAEVENTQUEUE_SIZE*sizeof(e_DataEventCodeType));
         if(DrvHandle->DataEventQueue==NULL)
@@ -2439,6 +2498,8 @@ t_IOSystemHandle *IOS_AllocIOSystemHandle(const char *UniqueID,uintptr_t ID)
                 free(DrvHandle->DataEventQueue);
             if(DrvHandle->DataEventMutex!=NULL)
                 UIFreeMutex(DrvHandle->DataEventMutex);
+            if(DrvHandle->DrvCallMutex!=NULL)
+                UIFreeMutex(DrvHandle->DrvCallMutex);
             if(DrvHandle->DriverData!=NULL)
                 drv->API.FreeHandle(DrvHandle->DriverData);
             delete DrvHandle;
@@ -2488,12 +2549,44 @@ void IOS_FreeIOSystemHandle(t_IOSystemHandle *Handle)
     UIFreeMutex(DrvHandle->DataEventMutex);
     DrvHandle->DataEventMutex=NULL;
 
+    UIFreeMutex(DrvHandle->DrvCallMutex);
+    DrvHandle->DrvCallMutex=NULL;
+
     if(DrvHandle->IOdrv->API.FreeHandle!=NULL)
         DrvHandle->IOdrv->API.FreeHandle(DrvHandle->DriverData);
 
     delete DrvHandle;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    IOS_SetPerfStats
+ *
+ * SYNOPSIS:
+ *    void IOS_SetPerfStats(t_IOSystemHandle *Handle,struct PerfStatsCon *PS);
+ *
+ * PARAMETERS:
+ *    Handle [I] -- The driver handle to set the stats on
+ *    PS [I] -- The performance stats for the connection this handle belongs
+ *              to.  This can be NULL for none.
+ *
+ * FUNCTION:
+ *    This function sets where the IO system records the time it takes for
+ *    a driver's data available event to get to the main thread.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_AllocCon()
+ ******************************************************************************/
+void IOS_SetPerfStats(t_IOSystemHandle *Handle,struct PerfStatsCon *PS)
+{
+    struct IOSystemDrvHandle *DrvHandle=(struct IOSystemDrvHandle *)Handle;
+
+    DrvHandle->PerfStats=PS;
+}
+
 /*******************************************************************************
  * NAME:
  *    IOS_Open
@@ -2538,38 +2631,60 @@ bool IOS_Open(t_IOSystemHandle *Handle)
  *
  * SYNOPSIS:
  *    e_IOSysIOErrorType IOS_WriteData(t_IOSystemHandle *Handle,
- *          const uint8_t *Data,int Bytes);
+ *          const uint8_t *Data,int Bytes,int *BytesWritten);
  *
  * PARAMETERS:
  *    Handle [I] -- The IO system handle to work on
  *    Data [I] -- The data to send to the device
  *    Bytes [I] -- The number of bytes to send.
+ *    BytesWritten [O] -- The number of bytes the driver took.  This is
+ *                        'Bytes' on success and can be anything from 0 to
+ *                        'Bytes'-1 when we return busy.
  *
  * FUNCTION:
- *    This function writes data to a device (well the driver)
+ *    This function writes data to a device (well the driver).
+ *
+ *    Drivers are allowed to take less than all the bytes (a non-blocking
+ *    serial port will take what fits in the kernel buffer), so when that
+ *    happens we return busy and the caller must send the rest
+ *    ('Data'+'BytesWritten') later.
+ *
+ *    This can be called from any thread (the transmit pacer and com test
+ *    send from their own threads).  The driver call is done under the
+ *    handle's 'DrvCallMutex' so it never runs at the same time as a
+ *    Read(), ChangeOptions(), etc from the main thread.
  *
  * RETURNS:
- *    e_IOSysIOError_Success -- Data was written.
+ *    e_IOSysIOError_Success -- All the data was written.
  *    e_IOSysIOError_GenericIO -- There was a IO error of some sort.
  *    e_IOSysIOError_Disconnect -- The connection or file handle has become
  *                                 disconnected.
- *    e_IOSysIOError_Busy -- The data could not be written at this time.
- *                           Wait a bit and try again.
+ *    e_IOSysIOError_Busy -- Some (or none) of the data could not be written
+ *                           at this time.  Wait a bit and try again with
+ *                           what was not written.
  *
  * SEE ALSO:
  *    IOS_Open()
  ******************************************************************************/
 e_IOSysIOErrorType IOS_WriteData(t_IOSystemHandle *Handle,const uint8_t *Data,
-        int Bytes)
+        int Bytes,int *BytesWritten)
 {
     struct IOSystemDrvHandle *DrvHandle=(struct IOSystemDrvHandle *)Handle;
     e_IOSysIOErrorType RetValue;
     int RetCode;
 
+    *BytesWritten=0;
+
+    UILockMutex(DrvHandle->DrvCallMutex);
     if(!DrvHandle->DrvOpen)
+    {
+        UIUnLockMutex(DrvHandle->DrvCallMutex);
         return e_IOSysIOError_Disconnect;
+    }
 
     RetCode=DrvHandle->IOdrv->API.Write(DrvHandle->DriverData,Data,Bytes);
+    UIUnLockMutex(DrvHandle->DrvCallMutex);
+
     if(RetCode<0)
     {
         /* Error */
@@ -2590,7 +2705,15 @@ e_IOSysIOErrorType IOS_WriteData(t_IOSystemHandle *Handle,const uint8_t *Data,
     }
     else
     {
-        RetValue=e_IOSysIOError_Success;
+        if(RetCode>Bytes)
+            RetCode=Bytes;
+        *BytesWritten=RetCode;
+
+        /* A short write means the driver is full */
+        if(RetCode<Bytes)
+            RetValue=e_IOSysIOError_Busy;
+        else
+            RetValue=e_IOSysIOError_Success;
     }
 
     return RetValue;
@@ -2621,11 +2744,16 @@ e_IOSysIOErrorType IOS_WriteData(t_IOSystemHandle *Handle,const uint8_t *Data,
 int IOS_ReadData(t_IOSystemHandle *Handle,uint8_t *Data,int MaxBytes)
 {
     struct IOSystemDrvHandle *DrvHandle=(struct IOSystemDrvHandle *)Handle;
+    int RetCode;
 
     if(!DrvHandle->DrvOpen)
         return 0;
 
-    return DrvHandle->IOdrv->API.Read(DrvHandle->DriverData,Data,MaxBytes);
+    UILockMutex(DrvHandle->DrvCallMutex);
+    RetCode=DrvHandle->IOdrv->API.Read(DrvHandle->DriverData,Data,MaxBytes);
+    UIUnLockMutex(DrvHandle->DrvCallMutex);
+
+    return RetCode;
 }
 
 /*******************************************************************************
@@ -2654,10 +2782,12 @@ void IOS_Close(t_IOSystemHandle *Handle)
     if(!DrvHandle->DrvOpen)
         return;
 
+    UILockMutex(DrvHandle->DrvCallMutex);
     if(DrvHandle->IOdrv->API.Close!=NULL)
         DrvHandle->IOdrv->API.Close(DrvHandle->DriverData);
 
     DrvHandle->DrvOpen=false;
+    UIUnLockMutex(DrvHandle->DrvCallMutex);
 }
 
 /*******************************************************************************
@@ -2692,7 +2822,9 @@ e_IOSysIOErrorType IOS_TransmitQueuedData(t_IOSystemHandle *Handle)
     RetValue=e_IOSysIOError_Success;
     if(DrvHandle->IOdrv->API.Transmit!=NULL)
     {
+        UILockMutex(DrvHandle->DrvCallMutex);
         RetCode=DrvHandle->IOdrv->API.Transmit(DrvHandle->DriverData);
+        UIUnLockMutex(DrvHandle->DrvCallMutex);
         if(RetCode<0)
         {
             /* Error */
@@ -2741,16 +2873,20 @@ e_IOSysIOErrorType IOS_TransmitQueuedData(t_IOSystemHandle *Handle)
 bool IOS_SetConnectionOptions(t_IOSystemHandle *Handle,const t_KVList &Options)
 {
     struct IOSystemDrvHandle *DrvHandle=(struct IOSystemDrvHandle *)Handle;
+    bool RetValue;
 
     DrvHandle->Options=Options;
 
+    RetValue=true;
     if(DrvHandle->DrvOpen && DrvHandle->IOdrv->API.ChangeOptions!=NULL)
     {
-        return DrvHandle->IOdrv->API.ChangeOptions(DrvHandle->DriverData,
+        UILockMutex(DrvHandle->DrvCallMutex);
+        RetValue=DrvHandle->IOdrv->API.ChangeOptions(DrvHandle->DriverData,
                 PIS_ConvertKVList2PIKVList(DrvHandle->Options));
+        UIUnLockMutex(DrvHandle->DrvCallMutex);
     }
 
-    return true;
+    return RetValue;
 }
 
 /*******************************************************************************
@@ -2880,6 +3016,10 @@ void IOS_DrvDataEvent(t_IOSystemHandle *IOHandle,int Code)
     {
         SavedDataAvailable=DrvHandle->DataAvailable;
         DrvHandle->DataAvailable=true;
+#if PERFSTATS_ENABLED==1
+        if(!SavedDataAvailable)
+            DrvHandle->DataAvailableTime=GetElapsedTime_ns();
+#endif
         UIUnLockMutex(DrvHandle->DataEventMutex);
 
         if(SavedDataAvailable==false)
@@ -2941,6 +3081,9 @@ void IOS_InformOfNewDataEvent(t_IOSystemHandle *IOHandle)
     e_DataEventCodeType Code;
     i_ActiveHandlesListType ahl;
     bool ReenterNeeded;
+#if PERFSTATS_ENABLED==1
+    uint64_t DataAvailableTime;
+#endif
 
     /* Ok, first we need to make sure this handle wasn't free'ed.  We do this
        by looking at a list of active handles.
@@ -2976,6 +3119,9 @@ void IOS_InformOfNewDataEvent(t_IOSystemHandle *IOHandle)
 
         DataAvailable=DrvHandle->DataAvailable;
         DrvHandle->DataAvailable=false;
+#if PERFSTATS_ENABLED==1
+        DataAvailableTime=DrvHandle->DataAvailableTime;
+#endif
 
         if(DrvHandle->DataEventTail!=DrvHandle->DataEventHead)
         {
@@ -2990,6 +3136,8 @@ void IOS_InformOfNewDataEvent(t_IOSystemHandle *IOHandle)
         /* Ok, now process what we just pulled off */
         if(DataAvailable)
         {
+            PERFSTATS_STAGE_DONE(DrvHandle->PerfStats,e_PerfStage_SignalLatency,
+                    DataAvailableTime);
             ReenterNeeded=Con_InformOfDataAvaiable(DrvHandle->ID);
         }
         switch(Code)
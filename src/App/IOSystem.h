@@ -131,11 +131,12 @@ bool IOS_DoesURIMatchBaseURI(const char *URI,const char *BaseURI);
 t_IOSystemHandle *IOS_AllocIOSystemHandle(const char *UniqueID,uintptr_t ID);
 t_IOSystemHandle *IOS_AllocIOSystemHandleFromURI(const char *URI,uintptr_t ID);
 void IOS_FreeIOSystemHandle(t_IOSystemHandle *Handle);
+void IOS_SetPerfStats(t_IOSystemHandle *Handle,struct PerfStatsCon *PS);
 
 bool IOS_Open(t_IOSystemHandle *Handle);
 bool IOS_SetConnectionOptions(t_IOSystemHandle *Handle,const t_KVList &Options);
 void IOS_GetConnectionOptions(t_IOSystemHandle *Handle,t_KVList &Options);
-e_IOSysIOErrorType IOS_WriteData(t_IOSystemHandle *Handle,const uint8_t *Data,int Bytes);
+e_IOSysIOErrorType IOS_WriteData(t_IOSystemHandle *Handle,const uint8_t *Data,int Bytes,int *BytesWritten);
 int IOS_ReadData(t_IOSystemHandle *Handle,uint8_t *Data,int MaxBytes);
 void IOS_Close(t_IOSystemHandle *Handle);
 void IOS_GetUniqueID(t_IOSystemHandle *Handle,std::string &UniqueID);
@@ -204,7 +204,8 @@ bool MWCapture::SelectFilename(void)
     if(UI_SaveFileReq("Capture to file",Path,Filename,
             "All Files|*\n"
             "Log Files|*.log\n"
-            "Binary|*.bin\n",0))
+            "Binary|*.bin\n"
+            "Capture (RX/TX with timing)|*" CAPTUREFILE_EXTENSION "\n",0))
     {
         Filename=UI_ConcatFile2Path(Path,Filename);
         UISetTextCtrlText(TxtInputFilename,Filename.c_str());
@@ -361,6 +362,7 @@ void MWCapture::RethinkUI(void)
     bool SelectFileEnabled;
     bool MainCheckboxesEnabled;
     bool HexDumpCheckboxEnabled;
+    bool AppendEnabled;
     string Text;
     bool Active;
     struct CaptureToFileOptions Options;
@@ -392,6 +394,7 @@ void MWCapture::RethinkUI(void)
     SelectFileEnabled=Active;
     MainCheckboxesEnabled=Active;
     HexDumpCheckboxEnabled=Active;
+    AppendEnabled=Active;
     if(Active)
     {
         if(MW->ActiveCon->GetCaptureSaving())
@@ -400,6 +403,7 @@ void MWCapture::RethinkUI(void)
             SelectFileEnabled=false;
             MainCheckboxesEnabled=false;
             HexDumpCheckboxEnabled=false;
+            AppendEnabled=false;
             StopEnabled=true;
         }
         else
@@ -419,6 +423,16 @@ void MWCapture::RethinkUI(void)
             {
                 HexDumpCheckboxEnabled=true;
                 MainCheckboxesEnabled=false;
+                AppendEnabled=false;
+            }
+
+            /* Binary captures keep everything, the text options don't
+               apply */
+            if(CaptureFile_IsBinaryFilename(Text.c_str()))
+            {
+                HexDumpCheckboxEnabled=false;
+                MainCheckboxesEnabled=false;
+                AppendEnabled=true;
             }
         }
     }
@@ -433,7 +447,7 @@ void MWCapture::RethinkUI(void)
     UIEnableButton(BttnSelectFilename,SelectFileEnabled);
 
     UIEnableCheckbox(CheckboxTimestamp,MainCheckboxesEnabled);
-    UIEnableCheckbox(CheckboxAppend,MainCheckboxesEnabled);
+    UIEnableCheckbox(CheckboxAppend,AppendEnabled);
     UIEnableCheckbox(CheckboxStripCtrlChars,MainCheckboxesEnabled);
     UIEnableCheckbox(CheckboxStripEscSeq,MainCheckboxesEnabled);
     UIEnableCheckbox(CheckboxHexDump,HexDumpCheckboxEnabled);
@@ -441,7 +455,7 @@ void MWCapture::RethinkUI(void)
     UIEnableMenu(MenuCaptureToFile,Active);
     UIEnableMenu(MenuStop,StopEnabled);
     UIEnableMenu(MenuTimestampToggle,MainCheckboxesEnabled);
-    UIEnableMenu(MenuAppendToggle,MainCheckboxesEnabled);
+    UIEnableMenu(MenuAppendToggle,AppendEnabled);
     UIEnableMenu(MenuStripCtrlCharsToggle,MainCheckboxesEnabled);
     UIEnableMenu(MenuStripEscSeqToggle,MainCheckboxesEnabled);
     UIEnableMenu(MenuHexDump,HexDumpCheckboxEnabled);
@@ -538,6 +538,35 @@ void MWHexDisplay::Clear(void)
     RethinkUI();
 }
 
+/*******************************************************************************
+ * NAME:
+ *    MWHexDisplay::FindBytes
+ *
+ * SYNOPSIS:
+ *    bool MWHexDisplay::FindBytes(const struct ByteSearchPattern *Pattern);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The bytes to look for
+ *
+ * FUNCTION:
+ *    This function finds the next match of a pattern in the incoming hex
+ *    display and selects it.
+ *
+ * RETURNS:
+ *    true -- The pattern was found
+ *    false -- The pattern was not found
+ *
+ * SEE ALSO:
+ *    HexDisplayBuffer::FindBytes()
+ ******************************************************************************/
+bool MWHexDisplay::FindBytes(const struct ByteSearchPattern *Pattern)
+{
+    if(MW->ActiveCon==NULL || IncomingHistoryHexDisplay==NULL)
+        return false;
+
+    return IncomingHistoryHexDisplay->FindBytes(Pattern);
+}
+
 /*******************************************************************************
  * NAME:
  *    MWHexDisplay::InformOfUpdate
@@ -65,6 +65,7 @@ class MWHexDisplay
         void Copy2Clip(void);
         void CopyAs(void);
         void Save(void);
+        bool FindBytes(const struct ByteSearchPattern *Pattern);
         bool HexDisplayBufferEvent(const struct HDEvent *Event);
 
     private:
@@ -20,11 +20,13 @@
 #include "App/FileTransferProtocolSystem.h"
 #include "App/MainWindow.h"
 #include "App/IOSystem.h"
+#include "App/PerfStats.h"
 #include "App/Portable.h"
 #include "App/Session.h"
 #include "App/Settings.h"
 #include "App/ScriptingSystem.h"
 #include "App/SendBuffer.h"
+#include "App/TimerWheel.h"
 #include "App/VersionCheckSystem.h"
 #include "App/Util/CRCSystem.h"
 #include "App/Dialogs/Dialog_EditSendBuffer.h"
@@ -33,8 +35,11 @@
 #include "UI/UIAsk.h"
 #include "UI/UISystem.h"
 #include "App/PluginSupport/PluginSystem.h"
+#include "App/PluginSupport/ExternPluginsSystem.h"
+#include "OS/Thread.h"
 #include "Version.h"
 #include <stdint.h>
+#include <stdio.h>
 #include <time.h>
 #include <stdlib.h>
 #include <string>
@@ -47,8 +52,20 @@ using namespace std;
 /*** MACROS                   ***/
 
 /*** TYPE DEFINITIONS         ***/
+struct MainAppLoader
+{
+    e_StartupPhaseType Phase;
+    void (*Load)(void);
+    struct ThreadHandle *Thread;
+};
 
 /*** FUNCTION PROTOTYPES      ***/
+static void MainApp_StartLoaders(void);
+static void MainApp_Wait4Loaders(void);
+static void MainApp_LoaderThread(void *Arg);
+static void MainApp_LoadSession(void);
+static void MainApp_LoadBookmarks(void);
+static void MainApp_LoadSendBuffers(void);
 
 /*** VARIABLE DEFINITIONS     ***/
 bool g_CLI_FirstWindowOpen=false;
@@ -58,6 +75,18 @@ bool g_AppShuttingDown=false;
 t_CLIArgList g_CLI_URIList;
 t_CLIArgList g_CLI_BookmarkList;
 bool MainApp_InitAfterMainWindowDone;
+static bool m_MainApp_ShowStartupTrace;
+
+/* These only read their own files into their own globals so they are
+   loaded at the same time as the rest of the startup.  They default con
+   settings as they load, which is safe off the main thread only because
+   InitSettings() already got the default fonts from the UI */
+static struct MainAppLoader m_MainApp_Loaders[]=
+{
+    {e_StartupPhase_LoadSession,MainApp_LoadSession,NULL},
+    {e_StartupPhase_LoadBookmarks,MainApp_LoadBookmarks,NULL},
+    {e_StartupPhase_LoadSendBuffers,MainApp_LoadSendBuffers,NULL},
+};
 
 /*******************************************************************************
  * NAME:
@@ -90,8 +119,11 @@ bool AppMain(int argc,char *argv[])
 {
     int_fast32_t r;
 
+    PerfStats_StartupPhaseStart(e_StartupPhase_Total);
+
     g_AppShuttingDown=false;
     MainApp_InitAfterMainWindowDone=false;
+    m_MainApp_ShowStartupTrace=false;
 
     srand(time(NULL));
 
@@ -118,6 +150,11 @@ bool AppMain(int argc,char *argv[])
                     }
                     g_CLI_BookmarkList.push_back(argv[r]);
                 }
+                else if(caseinsensitivestrcmp(argv[r],"--startup-trace")==0)
+                {
+                    /* Print how long each part of starting up took */
+                    m_MainApp_ShowStartupTrace=true;
+                }
             }
             else
             {
@@ -127,37 +164,244 @@ bool AppMain(int argc,char *argv[])
         }
     }
 
+    PerfStats_StartupPhaseStart(e_StartupPhase_InitOS);
     InitOS();
 
     InitPortableSystem();
+    PerfStats_StartupPhaseDone(e_StartupPhase_InitOS);
+
+    /* The app timers are used by the session and connections */
+    if(!TimerWheel_Init())
+    {
+        UIAsk("Error starting the app timers");
+        return false;
+    }
 
     /* Startup code */
+    InitSettings();
     InitSessionSystem();
     InitBookmarks();
     g_SendBuffers.Init();
 
+    /* Start the things that can load in the background */
+    StartLoadingExternPlugins();
+    MainApp_StartLoaders();
+
+    /* Settings can touch the UI so they load here (on the main thread) */
+    PerfStats_StartupPhaseStart(e_StartupPhase_LoadSettings);
     LoadSettings();
-    LoadSession();
-    LoadBookmarks();
-    g_SendBuffers.LoadBuffers();
+    PerfStats_StartupPhaseDone(e_StartupPhase_LoadSettings);
 
+    PerfStats_StartupPhaseStart(e_StartupPhase_IOSInit);
     IOS_Init();
+    PerfStats_StartupPhaseDone(e_StartupPhase_IOSInit);
+
+    PerfStats_StartupPhaseStart(e_StartupPhase_DPSInit);
     DPS_Init();
+    PerfStats_StartupPhaseDone(e_StartupPhase_DPSInit);
+
+    PerfStats_Init();
+
+    PerfStats_StartupPhaseStart(e_StartupPhase_FTPSInit);
     FTPS_Init();
+    PerfStats_StartupPhaseDone(e_StartupPhase_FTPSInit);
+
+    PerfStats_StartupPhaseStart(e_StartupPhase_ScriptingInit);
     if(!Scripting_Init())
+    {
+        MainApp_Wait4Loaders();
         return false;
+    }
+    PerfStats_StartupPhaseDone(e_StartupPhase_ScriptingInit);
 
+    PerfStats_StartupPhaseStart(e_StartupPhase_RegisterPlugins);
     InitPluginSystem();
+    PerfStats_StartupPhaseDone(e_StartupPhase_RegisterPlugins);
+
+    /* Everything after this can use the session, bookmarks, and buffers */
+    PerfStats_StartupPhaseStart(e_StartupPhase_Wait4Loaders);
+    MainApp_Wait4Loaders();
+    PerfStats_StartupPhaseDone(e_StartupPhase_Wait4Loaders);
 
     /* Currently we only have 1 main window, but here is where we would open
        them all */
+    PerfStats_StartupPhaseStart(e_StartupPhase_MainWindow);
     MW_AllocNewMainWindow();
 
     ApplySettings();
+    PerfStats_StartupPhaseDone(e_StartupPhase_MainWindow);
 
     return true;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    MainApp_StartLoaders
+ *
+ * SYNOPSIS:
+ *    static void MainApp_StartLoaders(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function starts a thread for each of the loaders in
+ *    'm_MainApp_Loaders'.  If a thread can't be started the loader is
+ *    run right away.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    MainApp_Wait4Loaders()
+ ******************************************************************************/
+static void MainApp_StartLoaders(void)
+{
+    unsigned int r;
+
+    for(r=0;r<sizeof(m_MainApp_Loaders)/sizeof(m_MainApp_Loaders[0]);r++)
+    {
+        m_MainApp_Loaders[r].Thread=StartThread(false,MainApp_LoaderThread,
+                &m_MainApp_Loaders[r]);
+        if(m_MainApp_Loaders[r].Thread==NULL)
+            MainApp_LoaderThread(&m_MainApp_Loaders[r]);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    MainApp_Wait4Loaders
+ *
+ * SYNOPSIS:
+ *    static void MainApp_Wait4Loaders(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function waits for all the loader threads to finish.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    MainApp_StartLoaders()
+ ******************************************************************************/
+static void MainApp_Wait4Loaders(void)
+{
+    unsigned int r;
+
+    for(r=0;r<sizeof(m_MainApp_Loaders)/sizeof(m_MainApp_Loaders[0]);r++)
+    {
+        if(m_MainApp_Loaders[r].Thread!=NULL)
+        {
+            Wait4ThreadToExit(m_MainApp_Loaders[r].Thread);
+            m_MainApp_Loaders[r].Thread=NULL;
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    MainApp_LoaderThread
+ *
+ * SYNOPSIS:
+ *    static void MainApp_LoaderThread(void *Arg);
+ *
+ * PARAMETERS:
+ *    Arg [I] -- The 'struct MainAppLoader' to run
+ *
+ * FUNCTION:
+ *    This is the thread that runs a loader and times it.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    MainApp_StartLoaders()
+ ******************************************************************************/
+static void MainApp_LoaderThread(void *Arg)
+{
+    struct MainAppLoader *Loader=(struct MainAppLoader *)Arg;
+
+    PerfStats_StartupPhaseStart(Loader->Phase);
+    Loader->Load();
+    PerfStats_StartupPhaseDone(Loader->Phase);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    MainApp_LoadSession
+ *
+ * SYNOPSIS:
+ *    static void MainApp_LoadSession(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is the loader for the session.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    LoadSession()
+ ******************************************************************************/
+static void MainApp_LoadSession(void)
+{
+    LoadSession();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    MainApp_LoadBookmarks
+ *
+ * SYNOPSIS:
+ *    static void MainApp_LoadBookmarks(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is the loader for the bookmarks.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    LoadBookmarks()
+ ******************************************************************************/
+static void MainApp_LoadBookmarks(void)
+{
+    LoadBookmarks();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    MainApp_LoadSendBuffers
+ *
+ * SYNOPSIS:
+ *    static void MainApp_LoadSendBuffers(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is the loader for the send buffers.  There are no main
+ *    windows yet so the change notices it sends don't go anywhere.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    SendBuffer::LoadBuffers()
+ ******************************************************************************/
+static void MainApp_LoadSendBuffers(void)
+{
+    g_SendBuffers.LoadBuffers();
+}
+
 /*******************************************************************************
  * NAME:
  *    StartAppShutDown
@@ -214,7 +458,9 @@ void FinishAppShutdown(void)
 {
     CRC_ShutDown();
     IOS_Shutdown();
+    PerfStats_Shutdown();
     Scripting_Shutdown();
+    TimerWheel_Shutdown();
 
     FreeLoadedExternPlugins();
 }
@@ -245,33 +491,8 @@ void FinishAppShutdown(void)
  ******************************************************************************/
 void App1SecTick(void)
 {
-    AutoSaveSessionTick();
     NewVersionCheckTick();
-}
-
-/*******************************************************************************
- * NAME:
- *    AppInformOf_FileTransTimerTick
- *
- * SYNOPSIS:
- *    void AppInformOf_FileTransTimerTick(void);
- *
- * PARAMETERS:
- *    NONE
- *
- * FUNCTION:
- *    This function is called from the file trans timer.  It sends a timer
- *    tick out to all the connections to run their download / uploads.
- *
- * RETURNS:
- *    NONE
- *
- * SEE ALSO:
- *    
- ******************************************************************************/
-void AppInformOf_FileTransTimerTick(void)
-{
-    Con_FileTransTick();
+    PerfStats_Tick();
 }
 
 /*******************************************************************************
@@ -298,12 +519,21 @@ void AppInformOf_FileTransTimerTick(void)
 void MainApp_MainWindowFirstShow(void)
 {
     class TheMainWindow *FirstMW;
+    string Trace;
 
     /* DEBUG PAUL: We should check if this is the last main window to open,
        for now there is only one */
     if(MainApp_InitAfterMainWindowDone)
         return;
 
+    /* We are up (before we ask the user anything) */
+    PerfStats_StartupPhaseDone(e_StartupPhase_Total);
+    if(m_MainApp_ShowStartupTrace)
+    {
+        PerfStats_BuildStartupTrace(Trace);
+        fputs(Trace.c_str(),stderr);
+    }
+
 #if OFFICIAL_RELEASE!=1
     UIAsk("This is a developer build.  The version number can not be trusted.\n\n"
             "Look at build date in ABOUT to differentiate between builds.\n\n"
@@ -50,7 +50,6 @@ bool AppMain(int argc,char *argv[]);
 void StartAppShutDown(void);
 void FinishAppShutdown(void);
 void App1SecTick(void);
-void AppInformOf_FileTransTimerTick(void);
 void MainApp_MainWindowFirstShow(void);
 
 #endif
@@ -57,6 +57,7 @@
 #include "App/SendBuffer.h"
 #include "App/Session.h"
 #include "App/Settings.h"
+#include "App/Util/ByteSearch.h"
 #include "UI/UIAsk.h"
 #include "UI/UIMainWindow.h"
 #include "UI/UIFileReq.h"
@@ -1499,6 +1500,7 @@ void TheMainWindow::RethinkActiveConnectionUI(void)
     t_UITabCtrl *MainTabs;
     class Connection *Con;
     bool EnableSelectionBased;
+    bool Pasting;
     bool IsBinaryCon;
     bool Checked;
     bool ScriptRunning;
@@ -1591,7 +1593,9 @@ void TheMainWindow::RethinkActiveConnectionUI(void)
     t_UIContextMenuCtrl *ContextMenu_CalcCRC;
     t_UIContextMenuCtrl *ContextMenu_SendToSendBuffer;
     t_UIContextMenuCtrl *ContextMenu_Copy;
+    t_UIContextMenuCtrl *ContextMenu_SaveSelection;
     t_UIContextMenuCtrl *ContextMenu_Paste;
+    t_UIContextMenuCtrl *ContextMenu_StopPaste;
 //    t_UIContextMenuCtrl *ContextMenu_ClearScreen;
 //    t_UIContextMenuCtrl *ContextMenu_ZoomIn;
 //    t_UIContextMenuCtrl *ContextMenu_ZoomOut;
@@ -1838,7 +1842,9 @@ void TheMainWindow::RethinkActiveConnectionUI(void)
         ContextMenu_CalcCRC=Con->GetContextMenuHandle(e_UITD_ContextMenu_CalcCRC);
         ContextMenu_SendToSendBuffer=Con->GetContextMenuHandle(e_UITD_ContextMenu_SendToSendBuffer);
         ContextMenu_Copy=Con->GetContextMenuHandle(e_UITD_ContextMenu_Copy);
+        ContextMenu_SaveSelection=Con->GetContextMenuHandle(e_UITD_ContextMenu_SaveSelection);
         ContextMenu_Paste=Con->GetContextMenuHandle(e_UITD_ContextMenu_Paste);
+        ContextMenu_StopPaste=Con->GetContextMenuHandle(e_UITD_ContextMenu_StopPaste);
         ContextMenu_Edit=Con->GetContextMenuHandle(e_UITD_ContextMenu_Edit);
         ContextMenu_EndianSwap=Con->GetContextMenuHandle(e_UITD_ContextMenu_EndianSwap);
         ContextMenu_Bold=Con->GetContextMenuHandle(e_UITD_ContextMenu_Bold);
@@ -1890,10 +1896,14 @@ void TheMainWindow::RethinkActiveConnectionUI(void)
         UIEnableMenu(SendBuffer12,Connected);
         UIEnableMenu(SendBufferSendGeneric,Connected);
 
-        UIEnableMenu(Paste,Connected);
+        /* Only one paste can be going out at a time */
+        Pasting=Con->IsPasteInProgress();
+        UIEnableMenu(Paste,Connected && !Pasting);
+        UIEnableToolbar(PasteTool,!Pasting);
 
         UIEnableContextMenu(ContextMenu_SendBuffer,Connected);
-        UIEnableContextMenu(ContextMenu_Paste,Connected);
+        UIEnableContextMenu(ContextMenu_Paste,Connected && !Pasting);
+        UIEnableContextMenu(ContextMenu_StopPaste,Pasting);
 
         if(Con->UsingCustomSettings)
         {
@@ -1915,6 +1925,7 @@ void TheMainWindow::RethinkActiveConnectionUI(void)
         UIEnableMenu(CopySelectionToSendBuffer,EnableSelectionBased);
         UIEnableToolbar(CopyTool,EnableSelectionBased);
         UIEnableContextMenu(ContextMenu_Copy,EnableSelectionBased);
+        UIEnableContextMenu(ContextMenu_SaveSelection,EnableSelectionBased);
         UIEnableToolbar(StyleBoldTool,EnableSelectionBased);
         UIEnableToolbar(StyleItalicsTool,EnableSelectionBased);
         UIEnableToolbar(StyleUnderlineTool,EnableSelectionBased);
@@ -2370,6 +2381,53 @@ void TheMainWindow::CopyActiveTabSelectionToClipboard(void)
         TabCon->CopySelectionToClipboard();
 }
 
+/*******************************************************************************
+ * NAME:
+ *    TheMainWindow::SaveActiveTabSelection
+ *
+ * SYNOPSIS:
+ *    void TheMainWindow::SaveActiveTabSelection(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function asks the user for a file name and then has the current
+ *    tab write its selection to that file.  The write happens a piece at a
+ *    time in the background (see Connection::SaveSelectionToFile()).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CopyActiveTabSelectionToClipboard()
+ ******************************************************************************/
+void TheMainWindow::SaveActiveTabSelection(void)
+{
+    t_UITabCtrl *MainTabs;
+    class Connection *TabCon;
+    string FileName;
+    string FullFilename;
+
+    MainTabs=UIMW_GetTabCtrlHandle(UIWin,e_UIMWTabCtrl_MainTabs);
+    TabCon=(class Connection *)UITabCtrlGetActiveTabID(MainTabs);
+    if(TabCon==NULL || !TabCon->IsThereASelection())
+        return;
+
+    FileName="Selection.txt";
+    if(!UI_SaveFileReq("Save Selection",g_Session.LastSaveSelectionPath,
+            FileName,"All Files|*\nText|*.txt",1))
+    {
+        return;
+    }
+    FullFilename=UI_ConcatFile2Path(g_Session.LastSaveSelectionPath,FileName);
+
+    /* Note that the path changed */
+    NoteSessionChanged();
+
+    TabCon->SaveSelectionToFile(FullFilename.c_str());
+}
+
 /*******************************************************************************
  * NAME:
  *    TheMainWindow::PasteFromClipboard
@@ -2483,6 +2541,71 @@ void TheMainWindow::GotoRow(void)
     }
 }
 
+/*******************************************************************************
+ * NAME:
+ *    TheMainWindow::FindBytes
+ *
+ * SYNOPSIS:
+ *    void TheMainWindow::FindBytes(bool PromptForPattern);
+ *
+ * PARAMETERS:
+ *    PromptForPattern [I] -- Ask the user for the pattern (true) or use
+ *                            the last one (false, find next).
+ *
+ * FUNCTION:
+ *    This function finds the next match of a byte pattern and selects it.
+ *    Binary connections are searched in the main display, other connections
+ *    are searched in the incoming hex display panel.
+ *
+ *    The pattern is hex bytes with ?? for any byte ("DE AD ?? EF"), "text"
+ *    for AscII, or u"text" / ube"text" for UTF-16 little / big endian.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ByteSearch_ParseUserPattern(), Connection::FindBytes()
+ ******************************************************************************/
+void TheMainWindow::FindBytes(bool PromptForPattern)
+{
+    t_UITabCtrl *MainTabs;
+    class Connection *TabCon;
+    struct ByteSearchPattern Pattern;
+    string PatternStr;
+    bool Found;
+
+    MainTabs=UIMW_GetTabCtrlHandle(UIWin,e_UIMWTabCtrl_MainTabs);
+    TabCon=(class Connection *)UITabCtrlGetActiveTabID(MainTabs);
+    if(TabCon==NULL)
+        return;
+
+    PatternStr=LastFindBytesStr;
+    if(PromptForPattern || PatternStr=="")
+    {
+        if(!UITextInputBox("Find Bytes",
+                "Bytes to find (AA ?? 55, \"text\", u\"UTF-16 text\")",
+                PatternStr))
+        {
+            return;
+        }
+    }
+
+    if(!ByteSearch_ParseUserPattern(PatternStr.c_str(),&Pattern))
+    {
+        UIAsk("Error","Bad byte pattern",e_AskBox_Error,e_AskBttns_Ok);
+        return;
+    }
+    LastFindBytesStr=PatternStr;
+
+    if(TabCon->IsConnectionBinary())
+        Found=TabCon->FindBytes(&Pattern);
+    else
+        Found=HexDisplayPanel.FindBytes(&Pattern);
+
+    if(!Found)
+        UIAsk("Find Bytes","Pattern not found",e_AskBox_Info,e_AskBttns_Ok);
+}
+
 /*******************************************************************************
  * NAME:
  *    TheMainWindow::RemoveAllTabPanelControls
@@ -3967,6 +4090,7 @@ void TheMainWindow::ConnectionEvent(const struct ConMWEvent *Event)
         break;
         case ConMWEvent_SelectionChanged:
         case ConMWEvent_AutoReopenChanged:
+        case ConMWEvent_PasteStateChanged:
             RethinkActiveConnectionUI();
         break;
         case ConMWEvent_OutGoingHexDisplayUpdate:
@@ -6080,6 +6204,9 @@ bool MW_Event(const struct MWEvent *Event)
  *                  e_Cmd_TermEmuSettings -- Open the terminal emulation settings dialog
  *                  e_Cmd_NewVersionCheck -- Run the check for new version dialog
  *                  e_Cmd_GotoWebSite -- Goto the WhippyTerm web site
+ *                  e_Cmd_SaveSelection -- Save the selected text to a file
+ *                  e_Cmd_FindBytes -- Prompt for a byte pattern and find it
+ *                  e_Cmd_FindBytesNext -- Find the next match of the last pattern
  *
  * FUNCTION:
  *    This function executes a command.
@@ -6703,6 +6830,15 @@ void TheMainWindow::ExeCmd(e_CmdType Cmd)
         case e_Cmd_GotoWebSite:
             UI_GotoWebPage("https://whippyterm.com");
         break;
+        case e_Cmd_SaveSelection:
+            SaveActiveTabSelection();
+        break;
+        case e_Cmd_FindBytes:
+            FindBytes(true);
+        break;
+        case e_Cmd_FindBytesNext:
+            FindBytes(false);
+        break;
 
         case e_CmdMAX:
         default:
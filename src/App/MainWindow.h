@@ -207,13 +207,16 @@ void Debug6(void);
         e_SysColShadeType CurrentBGStyleShade;
 
         class Connection *NoTabsConnection;
+        std::string LastFindBytesStr;
 
         t_TermEmuMenuList TermEmuMenuContents;
 
         void CopyActiveTabSelectionToClipboard(void);
+        void SaveActiveTabSelection(void);
         void PasteFromClipboard(void);
         void GotoColumn(void);
         void GotoRow(void);
+        void FindBytes(bool PromptForPattern);
         void ToggleConnectStatus(void);
         void ToggleAutoReconnect(void);
         void RemoveAllTabPanelControls(void);
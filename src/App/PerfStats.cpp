@@ -0,0 +1,802 @@
+/*******************************************************************************
+ * FILENAME: PerfStats.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the performance stats system in it.  Each connection
+ *    allocates a set of stats and the hooks in the receive path (driver
+ *    read, data event signal, data processors, display, paint, capture) and
+ *    transmit path add to them.
+ *
+ *    The stats can be exported in the Prometheus text format to a file
+ *    and / or to a local (unix domain) socket.  Both are updated from the
+ *    1 sec app tick.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/PerfStats.h"
+#include "App/Settings.h"
+#include "OS/Sockets.h"
+#include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <list>
+#include <string>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+typedef list<struct PerfStatsCon *> t_PerfStatsConListType;
+typedef t_PerfStatsConListType::iterator i_PerfStatsConListType;
+
+/*** FUNCTION PROTOTYPES      ***/
+static void PerfStats_EscapeLabel(const char *Str,string &Out);
+static bool PerfStats_WriteFile(const char *Filename,const string &Text);
+static void PerfStats_AddHistogram(string &Out,const char *Name,
+        const char *Labels,const struct PerfHistogram *Hist,bool InSeconds);
+
+/*** VARIABLE DEFINITIONS     ***/
+static t_PerfStatsConListType m_PerfStatsCons;
+static struct OSLocalServer *m_PerfStatsServer;
+static string m_PerfStatsServerPath;
+static unsigned int m_PerfStatsTickCount;
+
+static const char *m_PerfStageNames[e_PerfStageMAX]=
+{
+    "driver_read",
+    "signal_latency",
+    "data_processors",
+    "display_update",
+    "paint",
+    "capture_write",
+};
+
+static const char *m_PerfCounterNames[e_PerfCounterMAX]=
+{
+    "whippyterm_rx_bytes_total",
+    "whippyterm_tx_bytes_total",
+    "whippyterm_capture_bytes_total",
+    "whippyterm_rx_blocks_total",
+};
+
+static const char *m_StartupPhaseNames[e_StartupPhaseMAX]=
+{
+    "total",
+    "init_os",
+    "load_settings",
+    "load_session",
+    "load_bookmarks",
+    "load_send_buffers",
+    "load_plugin_dlls",
+    "ios_init",
+    "dps_init",
+    "ftps_init",
+    "scripting_init",
+    "register_plugins",
+    "wait_for_loaders",
+    "main_window",
+};
+
+/* Each phase is only written by the thread that runs it, and read after
+   all the loader threads have been waited for */
+static uint64_t m_StartupPhaseStart[e_StartupPhaseMAX];
+static uint64_t m_StartupPhaseEnd[e_StartupPhaseMAX];
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_Init
+ *
+ * SYNOPSIS:
+ *    void PerfStats_Init(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function init's the performance stats system.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_Shutdown()
+ ******************************************************************************/
+void PerfStats_Init(void)
+{
+    m_PerfStatsServer=NULL;
+    m_PerfStatsServerPath="";
+    m_PerfStatsTickCount=0;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_Shutdown
+ *
+ * SYNOPSIS:
+ *    void PerfStats_Shutdown(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function closes the export socket.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_Init()
+ ******************************************************************************/
+void PerfStats_Shutdown(void)
+{
+    if(m_PerfStatsServer!=NULL)
+        CloseLocalServerSocket(m_PerfStatsServer);
+    m_PerfStatsServer=NULL;
+    m_PerfStatsServerPath="";
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_ApplySettings
+ *
+ * SYNOPSIS:
+ *    void PerfStats_ApplySettings(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function opens / closes the export socket to match the settings.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_Tick()
+ ******************************************************************************/
+void PerfStats_ApplySettings(void)
+{
+    if(m_PerfStatsServerPath==g_Settings.PerfStatsSocketPath)
+        return;
+
+    PerfStats_Shutdown();
+
+    if(PERFSTATS_ENABLED && g_Settings.PerfStatsSocketPath!="")
+    {
+        m_PerfStatsServer=OpenLocalServerSocket(g_Settings.
+                PerfStatsSocketPath.c_str());
+        if(m_PerfStatsServer!=NULL)
+            m_PerfStatsServerPath=g_Settings.PerfStatsSocketPath;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_Tick
+ *
+ * SYNOPSIS:
+ *    void PerfStats_Tick(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is called every second.  It writes out the stats file
+ *    (every 'PerfStatsExportRate' seconds) and answers anyone waiting on the
+ *    export socket.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    App1SecTick()
+ ******************************************************************************/
+void PerfStats_Tick(void)
+{
+    string Text;
+    bool WriteFile;
+
+    if(!PERFSTATS_ENABLED)
+        return;
+
+    WriteFile=false;
+    if(g_Settings.PerfStatsExportFile!="")
+    {
+        m_PerfStatsTickCount++;
+        if(m_PerfStatsTickCount>=g_Settings.PerfStatsExportRate)
+        {
+            m_PerfStatsTickCount=0;
+            WriteFile=true;
+        }
+    }
+
+    if(!WriteFile && m_PerfStatsServer==NULL)
+        return;
+
+    PerfStats_BuildPrometheusText(Text);
+
+    if(WriteFile)
+        PerfStats_WriteFile(g_Settings.PerfStatsExportFile.c_str(),Text);
+
+    if(m_PerfStatsServer!=NULL)
+        ServeLocalServerSocket(m_PerfStatsServer,Text.c_str(),Text.length());
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_AllocCon
+ *
+ * SYNOPSIS:
+ *    struct PerfStatsCon *PerfStats_AllocCon(const char *Name);
+ *
+ * PARAMETERS:
+ *    Name [I] -- The name of the connection (used as the "connection" label)
+ *
+ * FUNCTION:
+ *    This function allocates a set of stats for a connection and adds it to
+ *    the list of stats that are exported.
+ *
+ * RETURNS:
+ *    The new stats or NULL if stats are compiled out (or out of memory).
+ *    All the record functions accept NULL.
+ *
+ * SEE ALSO:
+ *    PerfStats_FreeCon()
+ ******************************************************************************/
+struct PerfStatsCon *PerfStats_AllocCon(const char *Name)
+{
+    struct PerfStatsCon *NewPS;
+
+    if(!PERFSTATS_ENABLED)
+        return NULL;
+
+    NewPS=NULL;
+    try
+    {
+        NewPS=new struct PerfStatsCon;
+        NewPS->Name=Name;
+        memset(NewPS->Stages,0x00,sizeof(NewPS->Stages));
+        memset(&NewPS->TxQueueDepth,0x00,sizeof(NewPS->TxQueueDepth));
+        memset(NewPS->Counters,0x00,sizeof(NewPS->Counters));
+        NewPS->SampleCountDown=0;
+
+        m_PerfStatsCons.push_back(NewPS);
+    }
+    catch(...)
+    {
+        if(NewPS!=NULL)
+            delete NewPS;
+        return NULL;
+    }
+    return NewPS;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_FreeCon
+ *
+ * SYNOPSIS:
+ *    void PerfStats_FreeCon(struct PerfStatsCon *PS);
+ *
+ * PARAMETERS:
+ *    PS [I] -- The stats to free (can be NULL)
+ *
+ * FUNCTION:
+ *    This function frees stats allocated with PerfStats_AllocCon().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_AllocCon()
+ ******************************************************************************/
+void PerfStats_FreeCon(struct PerfStatsCon *PS)
+{
+    if(PS==NULL)
+        return;
+
+    m_PerfStatsCons.remove(PS);
+    delete PS;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_SetConName
+ *
+ * SYNOPSIS:
+ *    void PerfStats_SetConName(struct PerfStatsCon *PS,const char *Name);
+ *
+ * PARAMETERS:
+ *    PS [I] -- The stats to change
+ *    Name [I] -- The new name of the connection
+ *
+ * FUNCTION:
+ *    This function changes the connection label the stats are exported with.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_AllocCon()
+ ******************************************************************************/
+void PerfStats_SetConName(struct PerfStatsCon *PS,const char *Name)
+{
+    if(PS==NULL)
+        return;
+    PS->Name=Name;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_RecordPlugin
+ *
+ * SYNOPSIS:
+ *    void PerfStats_RecordPlugin(struct PerfStatsCon *PS,const char *PluginID,
+ *              uint64_t ns);
+ *
+ * PARAMETERS:
+ *    PS [I] -- The stats to add to
+ *    PluginID [I] -- The ID of the data processor
+ *    ns [I] -- How long the data processor took for this block
+ *
+ * FUNCTION:
+ *    This function adds a per plugin processing time.  This is only called
+ *    on sampled blocks so it isn't in the hot path.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_SampleThisBlock()
+ ******************************************************************************/
+void PerfStats_RecordPlugin(struct PerfStatsCon *PS,const char *PluginID,
+        uint64_t ns)
+{
+    i_PerfPluginHistogramsType Hist;
+
+    if(PS==NULL)
+        return;
+
+    try
+    {
+        Hist=PS->Plugins.find(PluginID);
+        if(Hist==PS->Plugins.end())
+        {
+            Hist=PS->Plugins.insert(make_pair(string(PluginID),
+                    PerfHistogram())).first;
+            memset(&Hist->second,0x00,sizeof(Hist->second));
+        }
+        PerfStats_AddSample(&Hist->second,ns);
+    }
+    catch(...)
+    {
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_BuildPrometheusText
+ *
+ * SYNOPSIS:
+ *    void PerfStats_BuildPrometheusText(std::string &Out);
+ *
+ * PARAMETERS:
+ *    Out [O] -- The text version of all the stats
+ *
+ * FUNCTION:
+ *    This function builds the Prometheus text format version of the stats
+ *    for all the connections.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_Export2File()
+ ******************************************************************************/
+void PerfStats_BuildPrometheusText(std::string &Out)
+{
+    i_PerfStatsConListType PS;
+    i_PerfPluginHistogramsType Plugin;
+    string ConLabel;
+    string PluginLabel;
+    string Labels;
+    char buff[100];
+    int s;
+    int c;
+
+    Out="";
+
+    Out+="# HELP whippyterm_stage_duration_seconds Time spent in each stage "
+            "of the receive path\n";
+    Out+="# TYPE whippyterm_stage_duration_seconds histogram\n";
+    for(PS=m_PerfStatsCons.begin();PS!=m_PerfStatsCons.end();PS++)
+    {
+        PerfStats_EscapeLabel((*PS)->Name.c_str(),ConLabel);
+        for(s=0;s<e_PerfStageMAX;s++)
+        {
+            Labels="connection=\""+ConLabel+"\",stage=\""+
+                    m_PerfStageNames[s]+"\"";
+            PerfStats_AddHistogram(Out,"whippyterm_stage_duration_seconds",
+                    Labels.c_str(),&(*PS)->Stages[s],true);
+        }
+    }
+
+    Out+="# HELP whippyterm_plugin_duration_seconds Time each data processor "
+            "took on a block (sampled)\n";
+    Out+="# TYPE whippyterm_plugin_duration_seconds histogram\n";
+    for(PS=m_PerfStatsCons.begin();PS!=m_PerfStatsCons.end();PS++)
+    {
+        PerfStats_EscapeLabel((*PS)->Name.c_str(),ConLabel);
+        for(Plugin=(*PS)->Plugins.begin();Plugin!=(*PS)->Plugins.end();
+                Plugin++)
+        {
+            PerfStats_EscapeLabel(Plugin->first.c_str(),PluginLabel);
+            Labels="connection=\""+ConLabel+"\",plugin=\""+PluginLabel+"\"";
+            PerfStats_AddHistogram(Out,"whippyterm_plugin_duration_seconds",
+                    Labels.c_str(),&Plugin->second,true);
+        }
+    }
+
+    Out+="# HELP whippyterm_tx_queue_depth_bytes Bytes waiting in the "
+            "transmit delay queue\n";
+    Out+="# TYPE whippyterm_tx_queue_depth_bytes histogram\n";
+    for(PS=m_PerfStatsCons.begin();PS!=m_PerfStatsCons.end();PS++)
+    {
+        PerfStats_EscapeLabel((*PS)->Name.c_str(),ConLabel);
+        Labels="connection=\""+ConLabel+"\"";
+        PerfStats_AddHistogram(Out,"whippyterm_tx_queue_depth_bytes",
+                Labels.c_str(),&(*PS)->TxQueueDepth,false);
+    }
+
+    for(c=0;c<e_PerfCounterMAX;c++)
+    {
+        Out+="# TYPE ";
+        Out+=m_PerfCounterNames[c];
+        Out+=" counter\n";
+        for(PS=m_PerfStatsCons.begin();PS!=m_PerfStatsCons.end();PS++)
+        {
+            PerfStats_EscapeLabel((*PS)->Name.c_str(),ConLabel);
+            sprintf(buff,"%llu",(unsigned long long)(*PS)->Counters[c]);
+            Out+=m_PerfCounterNames[c];
+            Out+="{connection=\""+ConLabel+"\"} ";
+            Out+=buff;
+            Out+="\n";
+        }
+    }
+
+    Out+="# HELP whippyterm_startup_phase_seconds How long each phase of "
+            "starting up took\n";
+    Out+="# TYPE whippyterm_startup_phase_seconds gauge\n";
+    for(s=0;s<e_StartupPhaseMAX;s++)
+    {
+        if(m_StartupPhaseEnd[s]==0)
+            continue;
+        sprintf(buff,"{phase=\"%s\"} %.9g\n",m_StartupPhaseNames[s],
+                (m_StartupPhaseEnd[s]-m_StartupPhaseStart[s])/1e9);
+        Out+="whippyterm_startup_phase_seconds";
+        Out+=buff;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_Export2File
+ *
+ * SYNOPSIS:
+ *    bool PerfStats_Export2File(const char *Filename);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to write the stats to
+ *
+ * FUNCTION:
+ *    This function writes the stats to a file in the Prometheus text format
+ *    (so it can be picked up by the node exporter textfile collector).  The
+ *    file is written to a temp file and then renamed over the old one so
+ *    readers never see 1/2 a file.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error writing the file
+ *
+ * SEE ALSO:
+ *    PerfStats_BuildPrometheusText()
+ ******************************************************************************/
+bool PerfStats_Export2File(const char *Filename)
+{
+    string Text;
+
+    PerfStats_BuildPrometheusText(Text);
+
+    return PerfStats_WriteFile(Filename,Text);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_StartupPhaseStart
+ *
+ * SYNOPSIS:
+ *    void PerfStats_StartupPhaseStart(e_StartupPhaseType Phase);
+ *
+ * PARAMETERS:
+ *    Phase [I] -- The phase of starting up that is starting
+ *
+ * FUNCTION:
+ *    This function notes the time a phase of starting up started.  This can
+ *    be called before PerfStats_Init() and from the loader threads.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_StartupPhaseDone(), PerfStats_BuildStartupTrace()
+ ******************************************************************************/
+void PerfStats_StartupPhaseStart(e_StartupPhaseType Phase)
+{
+    m_StartupPhaseStart[Phase]=GetElapsedTime_ns();
+    m_StartupPhaseEnd[Phase]=0;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_StartupPhaseDone
+ *
+ * SYNOPSIS:
+ *    void PerfStats_StartupPhaseDone(e_StartupPhaseType Phase);
+ *
+ * PARAMETERS:
+ *    Phase [I] -- The phase of starting up that is done
+ *
+ * FUNCTION:
+ *    This function notes the time a phase of starting up finished.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_StartupPhaseStart()
+ ******************************************************************************/
+void PerfStats_StartupPhaseDone(e_StartupPhaseType Phase)
+{
+    m_StartupPhaseEnd[Phase]=GetElapsedTime_ns();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_BuildStartupTrace
+ *
+ * SYNOPSIS:
+ *    void PerfStats_BuildStartupTrace(std::string &Out);
+ *
+ * PARAMETERS:
+ *    Out [O] -- The trace as text
+ *
+ * FUNCTION:
+ *    This function builds a table of when each phase of starting up started
+ *    (from the start of AppMain()) and how long it took.  Background phases
+ *    overlap the phases on the main thread.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_StartupPhaseStart()
+ ******************************************************************************/
+void PerfStats_BuildStartupTrace(std::string &Out)
+{
+    char buff[100];
+    uint64_t Origin;
+    int s;
+
+    Origin=m_StartupPhaseStart[e_StartupPhase_Total];
+
+    Out="Startup trace (ms)\n";
+    Out+="Phase                  Start      Took\n";
+    for(s=0;s<e_StartupPhaseMAX;s++)
+    {
+        if(m_StartupPhaseEnd[s]==0)
+            continue;
+        snprintf(buff,sizeof(buff),"%-18s %9.3f %9.3f\n",
+                m_StartupPhaseNames[s],
+                (m_StartupPhaseStart[s]-Origin)/1e6,
+                (m_StartupPhaseEnd[s]-m_StartupPhaseStart[s])/1e6);
+        Out+=buff;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_WriteFile
+ *
+ * SYNOPSIS:
+ *    static bool PerfStats_WriteFile(const char *Filename,const string &Text);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to write
+ *    Text [I] -- What to write in the file
+ *
+ * FUNCTION:
+ *    This function writes 'Text' to a temp file and then renames it over
+ *    'Filename'.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error writing the file
+ *
+ * SEE ALSO:
+ *    PerfStats_Export2File()
+ ******************************************************************************/
+static bool PerfStats_WriteFile(const char *Filename,const string &Text)
+{
+    string TmpFilename;
+    FILE *out;
+    bool RetValue;
+
+    TmpFilename=Filename;
+    TmpFilename+=".tmp";
+
+    out=fopen(TmpFilename.c_str(),"wb");
+    if(out==NULL)
+        return false;
+
+    RetValue=true;
+    if(fwrite(Text.c_str(),Text.length(),1,out)!=1 && !Text.empty())
+        RetValue=false;
+    if(fclose(out)!=0)
+        RetValue=false;
+
+    if(!RetValue)
+    {
+        remove(TmpFilename.c_str());
+        return false;
+    }
+
+    /* Replace the old file in one step so readers never see it missing
+       (Windows rename() will not replace a file) */
+#ifdef _WIN32
+    if(!MoveFileExA(TmpFilename.c_str(),Filename,MOVEFILE_REPLACE_EXISTING))
+    {
+        remove(TmpFilename.c_str());
+        return false;
+    }
+#else
+    if(rename(TmpFilename.c_str(),Filename)!=0)
+    {
+        remove(TmpFilename.c_str());
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+static void PerfStats_EscapeLabel(const char *Str,string &Out)
+{
+    Out="";
+    for(;*Str!=0;Str++)
+    {
+        switch(*Str)
+        {
+            case '\\':
+                Out+="\\\\";
+            break;
+            case '"':
+                Out+="\\\"";
+            break;
+            case '\n':
+                Out+="\\n";
+            break;
+            default:
+                Out+=*Str;
+            break;
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_AddHistogram
+ *
+ * SYNOPSIS:
+ *    static void PerfStats_AddHistogram(string &Out,const char *Name,
+ *              const char *Labels,const struct PerfHistogram *Hist,
+ *              bool InSeconds);
+ *
+ * PARAMETERS:
+ *    Out [I/O] -- The string to append to
+ *    Name [I] -- The metric name
+ *    Labels [I] -- The labels to add to each line (without the {}'s)
+ *    Hist [I] -- The histogram to output
+ *    InSeconds [I] -- The histogram values are in ns, output them in
+ *                     seconds (Prometheus base units)
+ *
+ * FUNCTION:
+ *    This function appends a histogram as a set of _bucket, _sum and _count
+ *    lines.  Empty buckets at the top are skipped (the +Inf bucket covers
+ *    them).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PerfStats_BuildPrometheusText()
+ ******************************************************************************/
+static void PerfStats_AddHistogram(string &Out,const char *Name,
+        const char *Labels,const struct PerfHistogram *Hist,bool InSeconds)
+{
+    char buff[100];
+    uint64_t Total;
+    uint64_t UpperBound;
+    int LastBucket;
+    int b;
+
+    /* The last bucket is the overflow bucket, it's only covered by +Inf */
+    for(LastBucket=PERFSTATS_BUCKETS-2;LastBucket>0;LastBucket--)
+        if(Hist->Buckets[LastBucket]!=0)
+            break;
+
+    Total=0;
+    for(b=0;b<=LastBucket;b++)
+    {
+        Total+=Hist->Buckets[b];
+        UpperBound=(1ULL<<b)-1;
+        if(InSeconds)
+            sprintf(buff,"%.9g",UpperBound/1e9);
+        else
+            sprintf(buff,"%llu",(unsigned long long)UpperBound);
+        Out+=Name;
+        Out+="_bucket{";
+        Out+=Labels;
+        Out+=",le=\"";
+        Out+=buff;
+        sprintf(buff,"\"} %llu\n",(unsigned long long)Total);
+        Out+=buff;
+    }
+    Out+=Name;
+    Out+="_bucket{";
+    Out+=Labels;
+    sprintf(buff,",le=\"+Inf\"} %llu\n",(unsigned long long)Hist->Count);
+    Out+=buff;
+
+    if(InSeconds)
+        sprintf(buff,"} %.9g\n",Hist->Sum/1e9);
+    else
+        sprintf(buff,"} %llu\n",(unsigned long long)Hist->Sum);
+    Out+=Name;
+    Out+="_sum{";
+    Out+=Labels;
+    Out+=buff;
+
+    sprintf(buff,"} %llu\n",(unsigned long long)Hist->Count);
+    Out+=Name;
+    Out+="_count{";
+    Out+=Labels;
+    Out+=buff;
+}
@@ -0,0 +1,254 @@
+/*******************************************************************************
+ * FILENAME: PerfStats.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This has the performance stats system in it.  This is an always on
+ *    set of counters and latency histograms for each stage of the receive
+ *    (and transmit) path, kept per connection.
+ *
+ *    The hooks in the hot path are macros so they compile to nothing if
+ *    PERFSTATS_ENABLED is 0.
+ *
+ *    It also has the startup trace (how long each phase of starting up
+ *    took).  This is always on as it's only a few time stamps.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __PERFSTATS_H_
+#define __PERFSTATS_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include "OS/OSTime.h"
+#include <stdint.h>
+#include <map>
+#include <string>
+
+/***  DEFINES                          ***/
+#ifndef PERFSTATS_ENABLED
+#define PERFSTATS_ENABLED                   0
+#endif
+
+/* Buckets are powers of 2 (bucket n is <2^n).  40 buckets is ~9 minutes
+   in ns */
+#define PERFSTATS_BUCKETS                   40
+
+/* How often (in blocks) we time each data processor on it's own */
+#define PERFSTATS_PLUGIN_SAMPLE_RATE        64
+
+/***  MACROS                           ***/
+#if PERFSTATS_ENABLED==1
+ #define PERFSTATS_TIMESTAMP(Var)           uint64_t Var=GetElapsedTime_ns()
+ #define PERFSTATS_STAGE_DONE(PS,Stage,Var) PerfStats_RecordStage(PS,Stage,GetElapsedTime_ns()-(Var))
+ #define PERFSTATS_COUNT(PS,Counter,Amount) PerfStats_AddCounter(PS,Counter,Amount)
+ #define PERFSTATS_TXQUEUE(PS,Bytes)        PerfStats_RecordTxQueueDepth(PS,Bytes)
+#else
+ #define PERFSTATS_TIMESTAMP(Var)
+ #define PERFSTATS_STAGE_DONE(PS,Stage,Var)
+ #define PERFSTATS_COUNT(PS,Counter,Amount)
+ #define PERFSTATS_TXQUEUE(PS,Bytes)
+#endif
+
+/***  TYPE DEFINITIONS                 ***/
+typedef enum
+{
+    e_PerfStage_DriverRead,         // IOS_ReadData()
+    e_PerfStage_SignalLatency,      // Driver thread data event -> main thread
+    e_PerfStage_DataProcessors,     // All the data processors (+display) for a block
+    e_PerfStage_DisplayUpdate,      // Writing chars into the display (sampled)
+    e_PerfStage_Paint,              // Rebuilding the lines for the UI
+    e_PerfStage_CaptureWrite,       // Writing to the capture file
+    e_PerfStageMAX
+} e_PerfStageType;
+
+typedef enum
+{
+    e_PerfCounter_RxBytes,
+    e_PerfCounter_TxBytes,
+    e_PerfCounter_CaptureBytes,
+    e_PerfCounter_Blocks,
+    e_PerfCounterMAX
+} e_PerfCounterType;
+
+struct PerfHistogram
+{
+    uint64_t Buckets[PERFSTATS_BUCKETS];
+    uint64_t Count;
+    uint64_t Sum;
+    uint64_t Max;
+};
+
+typedef enum
+{
+    e_StartupPhase_Total,               // AppMain() to the main window being shown
+    e_StartupPhase_InitOS,
+    e_StartupPhase_LoadSettings,
+    e_StartupPhase_LoadSession,         // Background
+    e_StartupPhase_LoadBookmarks,       // Background
+    e_StartupPhase_LoadSendBuffers,     // Background
+    e_StartupPhase_LoadPluginDLLs,      // Background
+    e_StartupPhase_IOSInit,
+    e_StartupPhase_DPSInit,
+    e_StartupPhase_FTPSInit,
+    e_StartupPhase_ScriptingInit,
+    e_StartupPhase_RegisterPlugins,
+    e_StartupPhase_Wait4Loaders,
+    e_StartupPhase_MainWindow,
+    e_StartupPhaseMAX
+} e_StartupPhaseType;
+
+typedef std::map<std::string,struct PerfHistogram> t_PerfPluginHistogramsType;
+typedef t_PerfPluginHistogramsType::iterator i_PerfPluginHistogramsType;
+
+struct PerfStatsCon
+{
+    std::string Name;
+    struct PerfHistogram Stages[e_PerfStageMAX];
+    struct PerfHistogram TxQueueDepth;
+    uint64_t Counters[e_PerfCounterMAX];
+    t_PerfPluginHistogramsType Plugins;
+    unsigned int SampleCountDown;
+};
+
+/***  CLASS DEFINITIONS                ***/
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+void PerfStats_Init(void);
+void PerfStats_Shutdown(void);
+void PerfStats_ApplySettings(void);
+void PerfStats_Tick(void);
+struct PerfStatsCon *PerfStats_AllocCon(const char *Name);
+void PerfStats_FreeCon(struct PerfStatsCon *PS);
+void PerfStats_SetConName(struct PerfStatsCon *PS,const char *Name);
+void PerfStats_RecordPlugin(struct PerfStatsCon *PS,const char *PluginID,
+        uint64_t ns);
+void PerfStats_BuildPrometheusText(std::string &Out);
+bool PerfStats_Export2File(const char *Filename);
+void PerfStats_StartupPhaseStart(e_StartupPhaseType Phase);
+void PerfStats_StartupPhaseDone(e_StartupPhaseType Phase);
+void PerfStats_BuildStartupTrace(std::string &Out);
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_AddSample
+ *
+ * SYNOPSIS:
+ *    static inline void PerfStats_AddSample(struct PerfHistogram *Hist,
+ *              uint64_t Value);
+ *
+ * PARAMETERS:
+ *    Hist [I] -- The histogram to add to
+ *    Value [I] -- The value to add
+ *
+ * FUNCTION:
+ *    This function adds a value to a histogram.  It is inline because it is
+ *    called in the hot path.
+ *
+ * RETURNS:
+ *    NONE
+ ******************************************************************************/
+static inline void PerfStats_AddSample(struct PerfHistogram *Hist,
+        uint64_t Value)
+{
+    unsigned int Bucket;
+
+    Bucket=0;
+#if defined(__GNUC__)
+    if(Value!=0)
+        Bucket=64-__builtin_clzll(Value);
+#else
+    while(Value>>Bucket!=0 && Bucket<PERFSTATS_BUCKETS)
+        Bucket++;
+#endif
+    if(Bucket>=PERFSTATS_BUCKETS)
+        Bucket=PERFSTATS_BUCKETS-1;
+
+    Hist->Buckets[Bucket]++;
+    Hist->Count++;
+    Hist->Sum+=Value;
+    if(Value>Hist->Max)
+        Hist->Max=Value;
+}
+
+static inline void PerfStats_RecordStage(struct PerfStatsCon *PS,
+        e_PerfStageType Stage,uint64_t ns)
+{
+    if(PS!=NULL)
+        PerfStats_AddSample(&PS->Stages[Stage],ns);
+}
+
+static inline void PerfStats_AddCounter(struct PerfStatsCon *PS,
+        e_PerfCounterType Counter,uint64_t Amount)
+{
+    if(PS!=NULL)
+        PS->Counters[Counter]+=Amount;
+}
+
+static inline void PerfStats_RecordTxQueueDepth(struct PerfStatsCon *PS,
+        uint64_t Bytes)
+{
+    if(PS!=NULL)
+        PerfStats_AddSample(&PS->TxQueueDepth,Bytes);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PerfStats_SampleThisBlock
+ *
+ * SYNOPSIS:
+ *    static inline bool PerfStats_SampleThisBlock(struct PerfStatsCon *PS);
+ *
+ * PARAMETERS:
+ *    PS [I] -- The connection stats
+ *
+ * FUNCTION:
+ *    This function is called for each block of incoming bytes to see if we
+ *    should time the data processors and display on their own for this
+ *    block.  Timing them costs a clock read per byte per processor so it is
+ *    only done every PERFSTATS_PLUGIN_SAMPLE_RATE blocks.
+ *
+ * RETURNS:
+ *    true -- Time the parts of this block
+ *    false -- Don't
+ ******************************************************************************/
+static inline bool PerfStats_SampleThisBlock(struct PerfStatsCon *PS)
+{
+#if PERFSTATS_ENABLED==1
+    if(PS==NULL)
+        return false;
+    if(PS->SampleCountDown>0)
+    {
+        PS->SampleCountDown--;
+        return false;
+    }
+    PS->SampleCountDown=PERFSTATS_PLUGIN_SAMPLE_RATE-1;
+    return true;
+#else
+    return false;
+#endif
+}
+
+#endif   /* end of "#ifndef __PERFSTATS_H_" */
@@ -34,6 +34,7 @@
 #include "App/MainApp.h"
 #include "App/MainWindow.h"
 #include "App/IOSystem.h"
+#include "App/PerfStats.h"
 #include "App/Portable.h"
 #include "App/Settings.h"
 #include "App/Dialogs/Dialog_InstallPlugin.h"
@@ -43,6 +44,7 @@
 #include "BuildOptions/BuildOptions.h"
 #include "OS/Directorys.h"
 #include "OS/System.h"
+#include "OS/Thread.h"
 #include "UI/UIFileReq.h"
 #include "UI/UIAsk.h"
 #include "ThirdParty/TinyCFG/TinyCFG.h"
@@ -67,6 +69,16 @@ typedef t_DLLLoadedListType::iterator i_DLLLoadedListType;
 typedef list<struct ExternPluginInfo> t_ExternPluginInfoType;
 typedef t_ExternPluginInfoType::iterator i_ExternPluginInfoType;
 
+struct ExternPluginDLLLoad
+{
+    i_ExternPluginInfoType Plugin;
+    string Filename;
+    struct DLLHandle *Handle;
+    string Error;
+};
+typedef list<struct ExternPluginDLLLoad> t_ExternPluginDLLLoadType;
+typedef t_ExternPluginDLLLoadType::iterator i_ExternPluginDLLLoadType;
+
 typedef unsigned int (*RegisterPluginFnType)(const struct PI_SystemAPI *SysAPI,unsigned int Version);
 
 class ExternPluginInfoList : public TinyCFGBaseData
@@ -93,39 +105,58 @@ static bool CallRegisterExternPluginFn(struct DLLHandle *Plugin,
         const char *Name);
 static bool LoadExternPluginDLL(struct ExternPluginInfo *Info);
 static bool CheckExternPluginForInstall(const char *Filename);
+static void ExternPluginsLoadThread(void *Arg);
 
 /*** VARIABLE DEFINITIONS     ***/
 t_DLLLoadedListType m_DLLLoaded;
 t_ExternPluginInfoType m_ExternPlugins;
 struct DLLHandle *m_ExternPluginHandle;
+static t_ExternPluginDLLLoadType m_ExternPluginDLLLoads;
+static struct ThreadHandle *m_ExternPluginsLoadThread;
+static bool m_ExternPluginsLoadStarted;
 
 /*******************************************************************************
  * NAME:
- *    RegisterExternPlugins
+ *    StartLoadingExternPlugins
  *
  * SYNOPSIS:
- *    void RegisterExternPlugins(void);
+ *    void StartLoadingExternPlugins(void);
  *
  * PARAMETERS:
  *    NONE
  *
  * FUNCTION:
- *    This function scans and loads all the external plugins.
+ *    This function reads the list of external plugins and starts a thread
+ *    that loads the DLL's for the ones that are enabled.  Loading the DLL's
+ *    (reading them in and linking them) is most of the time it takes to
+ *    start a plugin so this lets it happen while the rest of the system
+ *    starts up.  The plugins are registered later (on the main thread) by
+ *    RegisterExternPlugins().
  *
  * RETURNS:
  *    NONE
  *
+ * NOTES:
+ *    The DLL's are loaded one after the other on 1 thread.  The OS loader
+ *    holds a lock while it links so more threads don't help.
+ *
  * SEE ALSO:
- *    
+ *    RegisterExternPlugins()
  ******************************************************************************/
-void RegisterExternPlugins(void)
+void StartLoadingExternPlugins(void)
 {
     i_ExternPluginInfoType Plugin;
     string PluginDir;
     string PluginFilename;
     const char *LoadFilename;
     char buff[200];
-    struct DLLHandle *DLLHandle;
+    struct ExternPluginDLLLoad NewLoad;
+
+    if(m_ExternPluginsLoadStarted)
+        return;
+    m_ExternPluginsLoadStarted=true;
+    m_ExternPluginsLoadThread=NULL;
+    m_ExternPluginDLLLoads.clear();
 
     LoadPluginList();
     if(m_ExternPlugins.size()==0)
@@ -152,39 +183,157 @@ void RegisterExternPlugins(void)
         return;
     }
 
-    for(Plugin=m_ExternPlugins.begin();Plugin!=m_ExternPlugins.end();Plugin++)
+    try
     {
-        Plugin->DLLFound=false;
-        Plugin->DLLHandle=NULL;
+        for(Plugin=m_ExternPlugins.begin();Plugin!=m_ExternPlugins.end();
+                Plugin++)
+        {
+            Plugin->DLLFound=false;
+            Plugin->DLLHandle=NULL;
 
-        if(!Plugin->Enabled)
-            continue;
+            if(!Plugin->Enabled)
+                continue;
+
+            PluginFilename=PluginDir;
+            PluginFilename+="/";
+            PluginFilename+=Plugin->Filename;
+            LoadFilename=ConvertPath2Native(PluginFilename.c_str());
+            if(LoadFilename==NULL)
+            {
+                snprintf(buff,sizeof(buff)-1,"Failed to load plugin.  "
+                        "\"%s\" failed to filename + path too long.",
+                        Plugin->Filename.c_str());
+                UIAsk("Error",buff,e_AskBox_Error);
+                continue;
+            }
+
+            NewLoad.Plugin=Plugin;
+            NewLoad.Filename=LoadFilename;
+            NewLoad.Handle=NULL;
+            NewLoad.Error="";
+            m_ExternPluginDLLLoads.push_back(NewLoad);
+        }
+    }
+    catch(...)
+    {
+        m_ExternPluginDLLLoads.clear();
+        return;
+    }
+
+    if(m_ExternPluginDLLLoads.empty())
+        return;
+
+    m_ExternPluginsLoadThread=StartThread(false,ExternPluginsLoadThread,NULL);
+    if(m_ExternPluginsLoadThread==NULL)
+    {
+        /* Load them when we register them */
+        ExternPluginsLoadThread(NULL);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ExternPluginsLoadThread
+ *
+ * SYNOPSIS:
+ *    static void ExternPluginsLoadThread(void *Arg);
+ *
+ * PARAMETERS:
+ *    Arg [I] -- Not used
+ *
+ * FUNCTION:
+ *    This is the thread that loads the DLL's in 'm_ExternPluginDLLLoads'.
+ *    It only loads them, it doesn't call anything in them.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartLoadingExternPlugins()
+ ******************************************************************************/
+static void ExternPluginsLoadThread(void *Arg)
+{
+    i_ExternPluginDLLLoadType Load;
+    const char *Error;
 
-        PluginFilename=PluginDir;
-        PluginFilename+="/";
-        PluginFilename+=Plugin->Filename;
-        LoadFilename=ConvertPath2Native(PluginFilename.c_str());
-        if(LoadFilename==NULL)
+    PerfStats_StartupPhaseStart(e_StartupPhase_LoadPluginDLLs);
+    for(Load=m_ExternPluginDLLLoads.begin();
+            Load!=m_ExternPluginDLLLoads.end();Load++)
+    {
+        Load->Handle=LoadDLL(Load->Filename.c_str());
+        if(Load->Handle==NULL)
+        {
+            /* The error is per thread so we have to get it here */
+            Error=LastDLLError();
+            if(Error!=NULL)
+                Load->Error=Error;
+        }
+    }
+    PerfStats_StartupPhaseDone(e_StartupPhase_LoadPluginDLLs);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RegisterExternPlugins
+ *
+ * SYNOPSIS:
+ *    void RegisterExternPlugins(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function registers all the external plugins.  It waits for the
+ *    DLL's started by StartLoadingExternPlugins() to finish loading and then
+ *    calls the register function in each one (in the order they are in the
+ *    plugin list).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    StartLoadingExternPlugins()
+ ******************************************************************************/
+void RegisterExternPlugins(void)
+{
+    i_ExternPluginDLLLoadType Load;
+    char buff[200];
+
+    StartLoadingExternPlugins();
+
+    if(m_ExternPluginsLoadThread!=NULL)
+    {
+        Wait4ThreadToExit(m_ExternPluginsLoadThread);
+        m_ExternPluginsLoadThread=NULL;
+    }
+
+    for(Load=m_ExternPluginDLLLoads.begin();
+            Load!=m_ExternPluginDLLLoads.end();Load++)
+    {
+        Load->Plugin->DLLFound=false;
+        Load->Plugin->DLLHandle=NULL;
+
+        if(Load->Handle==NULL)
         {
             snprintf(buff,sizeof(buff)-1,"Failed to load plugin.  "
-                    "\"%s\" failed to filename + path too long.",
-                    Plugin->Filename.c_str());
+                    "\"%s\" failed to load:\n%s",
+                    Load->Plugin->PluginName.c_str(),Load->Error.c_str());
             UIAsk("Error",buff,e_AskBox_Error);
             continue;
         }
 
-        DLLHandle=LoadPlugin(LoadFilename,Plugin->PluginName.c_str());
-        if(DLLHandle!=NULL)
+        if(!CallRegisterExternPluginFn(Load->Handle,
+                Load->Plugin->PluginName.c_str()))
         {
-            Plugin->DLLFound=true;
-            Plugin->DLLHandle=DLLHandle;
-        }
-        else
-        {
-            Plugin->DLLFound=false;
-            Plugin->DLLHandle=NULL;
+            CloseDLL(Load->Handle);
+            continue;
         }
+
+        m_DLLLoaded.push_back(Load->Handle);
+        Load->Plugin->DLLFound=true;
+        Load->Plugin->DLLHandle=Load->Handle;
     }
+    m_ExternPluginDLLLoads.clear();
 }
 
 /*******************************************************************************
@@ -111,6 +111,7 @@ struct ExternPluginInfo
 /***  GLOBAL VARIABLE DEFINITIONS      ***/
 
 /***  EXTERNAL FUNCTION PROTOTYPES     ***/
+void StartLoadingExternPlugins(void);
 void RegisterExternPlugins(void);
 void FreeLoadedExternPlugins(void);
 bool GetExternPluginInfo(int Index,struct ExternPluginInfo &RetInfo);
@@ -33,43 +33,86 @@
 #include "App/MainApp.h"
 #include "App/Portable.h"
 #include "App/Session.h"
+#include "App/TimerWheel.h"
 #include "App/Util/StorageHelpers.h"
 #include "ThirdParty/TinyCFG/TinyCFG.h"
 #include "OS/Directorys.h"
+#include "OS/Thread.h"
+#include <map>
+#include <memory>
 #include <string>
 #include <string.h>
 #include <time.h>
+#include <vector>
 
 using namespace std;
 
 /*** DEFINES                  ***/
 #define SESSION_FILE        "Session.dat"
+#define SESSION_AUTOSAVE_SECS       60
 
 /*** MACROS                   ***/
 
 /*** TYPE DEFINITIONS         ***/
+/* A connections info is never changed once it's been taken so the save
+   thread and the next scan can share it */
+typedef std::shared_ptr<const struct SessionOpenConnection> t_SessionOpenConnectionRef;
+typedef std::vector<t_SessionOpenConnectionRef> t_SessionOpenConnectionRefList;
+
+struct SessionConSnapshot
+{
+    uint32_t Generation;            // The connection's generation when 'Info' was taken
+    t_SessionOpenConnectionRef Info;
+};
+typedef std::map<class Connection *,struct SessionConSnapshot> t_SessionConSnapshotMap;
+typedef t_SessionConSnapshotMap::iterator i_SessionConSnapshotMap;
+
+struct SessionSaveJob
+{
+    struct Session Data;            // Everything but 'OpenConnections'
+    t_SessionOpenConnectionRefList OpenConnections;
+    std::string Filename;
+};
+
 class SessionOpenConnections_TinyCFG : public TinyCFGBaseData
 {
     public:
         t_SessionOpenConnectionList *Ptr;
+        t_SessionOpenConnectionRefList *RefPtr; // If not NULL we save from this instead of 'Ptr'
         bool LoadElement(class TinyCFG *CFG);
         bool SaveElement(class TinyCFG *CFG);
 };
 
 /*** FUNCTION PROTOTYPES      ***/
 static void Session_RegisterAllMembers(struct Session &session,
-        class TinyCFG &cfg);
+        class TinyCFG &cfg,t_SessionOpenConnectionRefList *OpenConRefs=NULL);
 static void Session_DefaultSession(struct Session &session);
 static bool RegisterCRCType(class TinyCFG &cfg,const char *XmlName,
         e_CRCType &Data);
 static bool RegisterDirectSendPanelLineEndType(class TinyCFG &cfg,
         const char *XmlName,e_DirectSendPanel_LineEndType &Data);
+static bool Session_GetDefaultFilename(std::string &Filename);
+static void Session_SnapshotOpenConnections(
+        t_SessionOpenConnectionRefList &RetList);
+static bool Session_WriteFile(struct Session &session,
+        t_SessionOpenConnectionRefList *OpenConRefs,const char *Filename);
+static void Session_SaveThread(void *Arg);
+static void Session_Wait4BackgroundSave(void);
+static void Session_AutoSaveTimeout(uintptr_t UserData);
+bool RegisterSessionOpenConnectionsList_TinyCFG(class TinyCFG &cfg,
+        const char *XmlName,t_SessionOpenConnectionList &Data,
+        t_SessionOpenConnectionRefList *RefData);
 
 /*** VARIABLE DEFINITIONS     ***/
 struct Session g_Session;
 bool g_SessionChanged;  // Has the session changed since the last time we saved?
-time_t m_SessionLastSaveCheck;
+static struct TimerWheelTimer *m_SessionAutoSaveTimer;
 bool m_SessionChanged;
+static t_SessionConSnapshotMap m_SessionConSnapshots;
+static struct ThreadMutex *m_SessionSaveMutex;
+static struct ThreadHandle *m_SessionSaveThread;
+static bool m_SessionSaveBusy;      // Protected by 'm_SessionSaveMutex'
+static bool m_SessionSaveFailed;    // Protected by 'm_SessionSaveMutex'
 
 /*******************************************************************************
  * NAME:
@@ -96,9 +139,25 @@ bool m_SessionChanged;
  ******************************************************************************/
 void InitSessionSystem(void)
 {
-    m_SessionLastSaveCheck=time(NULL);
     Session_DefaultSession(g_Session);
     m_SessionChanged=false;
+
+    /* If we can't get a mutex we just save on the main thread */
+    m_SessionSaveMutex=AllocMutex();
+    m_SessionSaveThread=NULL;
+    m_SessionSaveBusy=false;
+    m_SessionSaveFailed=false;
+
+    /* If we can't get a timer we just don't auto save */
+    m_SessionAutoSaveTimer=TimerWheel_AllocTimer();
+    if(m_SessionAutoSaveTimer!=NULL)
+    {
+        TimerWheel_SetupTimer(m_SessionAutoSaveTimer,Session_AutoSaveTimeout,
+                0,true);
+        TimerWheel_SetTimeout(m_SessionAutoSaveTimer,
+                SESSION_AUTOSAVE_SECS*1000);
+        TimerWheel_Start(m_SessionAutoSaveTimer);
+    }
 }
 
 /*******************************************************************************
@@ -185,36 +244,31 @@ bool LoadSession(const char *Filename)
  ******************************************************************************/
 bool SaveSession(const char *Filename)
 {
-    class TinyCFG cfg("Session");
     const char *UseFilename;
     string AppData;
 
+    /* Make sure an auto save isn't still writing the file */
+    Session_Wait4BackgroundSave();
+
     try
     {
         UseFilename=Filename;
         if(Filename==NULL)
         {
-            if(GetAppDataPath(AppData)==false)
+            if(!Session_GetDefaultFilename(AppData))
                 return false;
-            /* See if this path exists */
-            if(!PathExists(AppData.c_str()))
-            {
-                /* Try making it */
-                if(!MakePathDir(AppData.c_str()))
-                    return false;
-            }
-
-            AppData+=SESSION_FILE;
             UseFilename=AppData.c_str();
         }
 
-        Session_RegisterAllMembers(g_Session,cfg);
-
+        /* Not all of the direct send panel changes are tracked so we take a
+           fresh copy of every connection */
+        m_SessionConSnapshots.clear();
         ScanOpenConnections2Session();
 
 /* DEBUG PAUL: We need to ask each plugin to store it's session data here */
 
-        cfg.SaveCFGFile(UseFilename);
+        if(!Session_WriteFile(g_Session,NULL,UseFilename))
+            return false;
     }
     catch(...)
     {
@@ -228,36 +282,27 @@ bool SaveSession(const char *Filename)
 
 /*******************************************************************************
  * NAME:
- *    AutoSaveSessionTick
+ *    Session_AutoSaveTimeout
  *
  * SYNOPSIS:
- *    void AutoSaveSessionTick(void);
+ *    static void Session_AutoSaveTimeout(uintptr_t UserData);
  *
  * PARAMETERS:
- *    NONE
+ *    UserData [I] -- Not used
  *
  * FUNCTION:
- *    This function is called regularly to see if the session file needs to
- *    be saved.
+ *    This function is called from the auto save timer (every
+ *    SESSION_AUTOSAVE_SECS) to see if the session file needs to be saved.
  *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
- *******************************************************************************
- * REVISION HISTORY:
- *    Paul Hutchinson (27 Sep 2018)
- *       Created
+ *    SaveSessionIfNeeded()
  ******************************************************************************/
-void AutoSaveSessionTick(void)
+static void Session_AutoSaveTimeout(uintptr_t UserData)
 {
-    /* Only check every 1 minutes */
-    if(difftime(time(NULL),m_SessionLastSaveCheck)>60)
-    {
-        m_SessionLastSaveCheck=time(NULL);
-        SaveSessionIfNeeded();
-    }
+    SaveSessionIfNeeded();
 }
 
 /*******************************************************************************
@@ -274,18 +319,85 @@ void AutoSaveSessionTick(void)
  *    This function can be called at any point to save out the session file
  *    again.  It will only save out the session file if there was a change.
  *
+ *    The open connections are copied (only the ones that changed since the
+ *    last save) and then the file is built and written on a background
+ *    thread.  If the last save is still being written this does nothing and
+ *    the save will happen on a later call.
+ *
  * RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    SaveSession()
  ******************************************************************************/
 void SaveSessionIfNeeded(void)
 {
-    if(m_SessionChanged)
+    struct SessionSaveJob *Job;
+    bool Busy;
+    bool Failed;
+
+    /* See if the last save has finished */
+    if(m_SessionSaveThread!=NULL)
     {
-        /* Something changed we need to save it */
+        LockMutex(m_SessionSaveMutex);
+        Busy=m_SessionSaveBusy;
+        Failed=m_SessionSaveFailed;
+        UnLockMutex(m_SessionSaveMutex);
+
+        if(Busy)
+            return;
+
+        Wait4ThreadToExit(m_SessionSaveThread);
+        m_SessionSaveThread=NULL;
+
+        /* If it didn't get saved we need to try again */
+        if(Failed)
+            m_SessionChanged=true;
+    }
+
+    if(!m_SessionChanged)
+        return;
+
+    if(m_SessionSaveMutex==NULL)
+    {
+        /* We can't use a thread, do it here */
         SaveSession();
+        return;
+    }
+
+    Job=NULL;
+    try
+    {
+        Job=new struct SessionSaveJob;
+
+        if(!Session_GetDefaultFilename(Job->Filename))
+            throw(0);
+
+        Session_SnapshotOpenConnections(Job->OpenConnections);
+
+        /* 'OpenConnections' is only needed when we restore the connections
+           at startup, the thread saves from the snapshots */
+        g_Session.OpenConnections.clear();
+        Job->Data=g_Session;
+    }
+    catch(...)
+    {
+        delete Job;
+        return;
+    }
+
+    /* Anything that changes from here on will need another save */
+    m_SessionChanged=false;
+
+    m_SessionSaveBusy=true;
+    m_SessionSaveFailed=false;
+    m_SessionSaveThread=StartThread(false,Session_SaveThread,Job);
+    if(m_SessionSaveThread==NULL)
+    {
+        /* Couldn't start the thread, save it here */
+        Session_SaveThread(Job);
+        if(m_SessionSaveFailed)
+            m_SessionChanged=true;
     }
 }
 
@@ -344,50 +456,266 @@ void NoteSessionChanged(void)
  ******************************************************************************/
 void ScanOpenConnections2Session(void)
 {
-    struct SessionOpenConnection NewOpenConInfo;
+    t_SessionOpenConnectionRefList OpenCons;
+    unsigned int r;
+
+    g_Session.OpenConnections.clear();
+
+    Session_SnapshotOpenConnections(OpenCons);
+
+    try
+    {
+        for(r=0;r<OpenCons.size();r++)
+            g_Session.OpenConnections.push_back(*OpenCons[r]);
+    }
+    catch(...)
+    {
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Session_SnapshotOpenConnections
+ *
+ * SYNOPSIS:
+ *    static void Session_SnapshotOpenConnections(
+ *              t_SessionOpenConnectionRefList &RetList);
+ *
+ * PARAMETERS:
+ *    RetList [O] -- The info for all the open connections
+ *
+ * FUNCTION:
+ *    This function gets the session info for all the open connections.
+ *    Only connections that have changed since the last time this was called
+ *    are copied, the rest reuse the copy that was taken last time.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ScanOpenConnections2Session(), Connection::GetSessionGeneration()
+ ******************************************************************************/
+static void Session_SnapshotOpenConnections(
+        t_SessionOpenConnectionRefList &RetList)
+{
+    std::shared_ptr<struct SessionOpenConnection> NewOpenConInfo;
+    struct SessionConSnapshot NewSnapshot;
+    t_SessionConSnapshotMap Snapshots;
+    i_SessionConSnapshotMap Last;
     t_ConnectionList ConList;
     i_ConnectionList CurrentCon;
     class Connection *Con;
 
-    g_Session.OpenConnections.clear();
+    RetList.clear();
 
     /* If we aren't restoring connections on startup then we just store blank
        data in session */
     if(!g_Settings.ReopenOnConnectionsOnStartup)
+    {
+        m_SessionConSnapshots.clear();
         return;
+    }
 
     try
     {
         Con_GetListOfConnections(ConList);
+        RetList.reserve(ConList.size());
 
         for(CurrentCon=ConList.begin();CurrentCon!=ConList.end();CurrentCon++)
         {
             Con=*CurrentCon;
 
-            Con->GetDisplayName(NewOpenConInfo.Name);
-            NewOpenConInfo.WasOpen=Con->GetConnectedStatus();
-            Con->GetDirectSendLineHistory(NewOpenConInfo.TextLineHistory);
+            Last=m_SessionConSnapshots.find(Con);
+            if(Last!=m_SessionConSnapshots.end() &&
+                    Last->second.Generation==Con->GetSessionGeneration())
+            {
+                /* Nothing changed, use the copy we already have */
+                NewSnapshot=Last->second;
+            }
+            else
+            {
+                NewOpenConInfo=std::make_shared<struct SessionOpenConnection>();
+
+                Con->GetDisplayName(NewOpenConInfo->Name);
+                NewOpenConInfo->WasOpen=Con->GetConnectedStatus();
+                Con->GetDirectSendLineHistory(NewOpenConInfo->TextLineHistory);
+
+                NewOpenConInfo->DirectSendPanelLineEnd=Con->GetDirectPanelLineEnd();
+                NewOpenConInfo->DirectSendPanel_InHexMode=Con->GetDirectPanelInHexMode();
+                NewOpenConInfo->DirectSendPanelOpen=Con->IsDirectSendPanelOpen();
 
-            NewOpenConInfo.DirectSendPanelLineEnd=Con->GetDirectPanelLineEnd();
-            NewOpenConInfo.DirectSendPanel_InHexMode=Con->GetDirectPanelInHexMode();
-            NewOpenConInfo.DirectSendPanelOpen=Con->IsDirectSendPanelOpen();
+                if(!Con->GetConnectionOptions(NewOpenConInfo->Options))
+                    throw(0);
 
-            if(!Con->GetConnectionOptions(NewOpenConInfo.Options))
-                throw(0);
+                if(!Con->GetURI(NewOpenConInfo->URI))
+                    throw(0);
 
-            if(!Con->GetURI(NewOpenConInfo.URI))
-                throw(0);
+                NewOpenConInfo->UseCustomSettings=Con->UsingCustomSettings;
+                NewOpenConInfo->CustomSettings=Con->CustomSettings;
 
-            NewOpenConInfo.UseCustomSettings=Con->UsingCustomSettings;
-            NewOpenConInfo.CustomSettings=Con->CustomSettings;
+                NewSnapshot.Generation=Con->GetSessionGeneration();
+                NewSnapshot.Info=NewOpenConInfo;
+            }
 
             /* Add this connection to the list of open connections */
-            g_Session.OpenConnections.push_back(NewOpenConInfo);
+            Snapshots[Con]=NewSnapshot;
+            RetList.push_back(NewSnapshot.Info);
         }
     }
     catch(...)
     {
     }
+
+    /* Closed connections fall out here */
+    m_SessionConSnapshots.swap(Snapshots);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Session_GetDefaultFilename
+ *
+ * SYNOPSIS:
+ *    static bool Session_GetDefaultFilename(std::string &Filename);
+ *
+ * PARAMETERS:
+ *    Filename [O] -- The full path to the session file
+ *
+ * FUNCTION:
+ *    This function gets the path to the default session file.  It makes
+ *    the app data dir if it doesn't exist.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *    SaveSession()
+ ******************************************************************************/
+static bool Session_GetDefaultFilename(std::string &Filename)
+{
+    if(GetAppDataPath(Filename)==false)
+        return false;
+
+    /* See if this path exists */
+    if(!PathExists(Filename.c_str()))
+    {
+        /* Try making it */
+        if(!MakePathDir(Filename.c_str()))
+            return false;
+    }
+
+    Filename+=SESSION_FILE;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Session_WriteFile
+ *
+ * SYNOPSIS:
+ *    static bool Session_WriteFile(struct Session &session,
+ *              t_SessionOpenConnectionRefList *OpenConRefs,
+ *              const char *Filename);
+ *
+ * PARAMETERS:
+ *    session [I] -- The session to save
+ *    OpenConRefs [I] -- The open connections to save.  If this is NULL
+ *                       then 'session.OpenConnections' is used.
+ *    Filename [I] -- The file to write
+ *
+ * FUNCTION:
+ *    This function writes a session file.  It doesn't touch any globals so
+ *    it can be called from the save thread.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *    SaveSession(), Session_SaveThread()
+ ******************************************************************************/
+static bool Session_WriteFile(struct Session &session,
+        t_SessionOpenConnectionRefList *OpenConRefs,const char *Filename)
+{
+    class TinyCFG cfg("Session");
+
+    try
+    {
+        Session_RegisterAllMembers(session,cfg,OpenConRefs);
+
+        if(!cfg.SaveCFGFile(Filename))
+            return false;
+    }
+    catch(...)
+    {
+        return false;
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Session_SaveThread
+ *
+ * SYNOPSIS:
+ *    static void Session_SaveThread(void *Arg);
+ *
+ * PARAMETERS:
+ *    Arg [I] -- The 'struct SessionSaveJob' to save.  This is freed.
+ *
+ * FUNCTION:
+ *    This is the thread that writes the session file for the auto save.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    SaveSessionIfNeeded()
+ ******************************************************************************/
+static void Session_SaveThread(void *Arg)
+{
+    struct SessionSaveJob *Job=(struct SessionSaveJob *)Arg;
+    bool Saved;
+
+    Saved=Session_WriteFile(Job->Data,&Job->OpenConnections,
+            Job->Filename.c_str());
+
+    delete Job;
+
+    LockMutex(m_SessionSaveMutex);
+    m_SessionSaveBusy=false;
+    m_SessionSaveFailed=!Saved;
+    UnLockMutex(m_SessionSaveMutex);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Session_Wait4BackgroundSave
+ *
+ * SYNOPSIS:
+ *    static void Session_Wait4BackgroundSave(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function waits for the auto save thread to finish writing the
+ *    session file (if it's running).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    SaveSessionIfNeeded()
+ ******************************************************************************/
+static void Session_Wait4BackgroundSave(void)
+{
+    if(m_SessionSaveThread==NULL)
+        return;
+
+    Wait4ThreadToExit(m_SessionSaveThread);
+    m_SessionSaveThread=NULL;
 }
 
 /////////////////////
@@ -435,6 +763,8 @@ bool SessionOpenConnections_TinyCFG::LoadElement(class TinyCFG *CFG)
 bool SessionOpenConnections_TinyCFG::SaveElement(class TinyCFG *CFG)
 {
     i_SessionOpenConnectionList i;
+    const struct SessionOpenConnection *Info;
+    unsigned int r;
     string MenuName;
     string Name;
     string URI;
@@ -462,18 +792,34 @@ bool SessionOpenConnections_TinyCFG::SaveElement(class TinyCFG *CFG)
     SubCFG.Register("DirectPanelInHexMode",DirectSendPanel_InHexMode);
     SubCFG.Register("DirectSendPanelOpen",DirectSendPanelOpen);
 
-    for(i=Ptr->begin();i!=Ptr->end();i++)
+    i=Ptr->begin();
+    r=0;
+    for(;;)
     {
-        Name=i->Name;
-        URI=i->URI;
-        Options=i->Options;
-        UseCustomSettings=i->UseCustomSettings;
-        CustomSettings=i->CustomSettings;
-        WasOpen=i->WasOpen;
-        DirectSendPanel_InHexMode=i->DirectSendPanel_InHexMode;
-        DirectSendPanelOpen=i->DirectSendPanelOpen;
-        TextLineHistory=i->TextLineHistory;
-        DirectSendPanelLineEnd=i->DirectSendPanelLineEnd;
+        /* We save from the snapshots if we have them */
+        if(RefPtr!=NULL)
+        {
+            if(r>=RefPtr->size())
+                break;
+            Info=(*RefPtr)[r++].get();
+        }
+        else
+        {
+            if(i==Ptr->end())
+                break;
+            Info=&*i++;
+        }
+
+        Name=Info->Name;
+        URI=Info->URI;
+        Options=Info->Options;
+        UseCustomSettings=Info->UseCustomSettings;
+        CustomSettings=Info->CustomSettings;
+        WasOpen=Info->WasOpen;
+        DirectSendPanel_InHexMode=Info->DirectSendPanel_InHexMode;
+        DirectSendPanelOpen=Info->DirectSendPanelOpen;
+        TextLineHistory=Info->TextLineHistory;
+        DirectSendPanelLineEnd=Info->DirectSendPanelLineEnd;
 
         SubCFG.WriteCFGUsingParentCFG(CFG);
     }
@@ -481,7 +827,8 @@ bool SessionOpenConnections_TinyCFG::SaveElement(class TinyCFG *CFG)
 }
 
 bool RegisterSessionOpenConnectionsList_TinyCFG(class TinyCFG &cfg,
-        const char *XmlName,t_SessionOpenConnectionList &Data)
+        const char *XmlName,t_SessionOpenConnectionList &Data,
+        t_SessionOpenConnectionRefList *RefData)
 {
     class SessionOpenConnections_TinyCFG *NewDataClass;
 
@@ -497,6 +844,7 @@ bool RegisterSessionOpenConnectionsList_TinyCFG(class TinyCFG &cfg,
 
     /* Setup the data */
     NewDataClass->Ptr=&Data;
+    NewDataClass->RefPtr=RefData;
     NewDataClass->XmlName=XmlName;
 
     return cfg.RegisterGeneric(NewDataClass);
@@ -894,7 +1242,7 @@ static bool RegisterDirectSendPanelLineEndType(class TinyCFG &cfg,
 ///////////////////
 
 static void Session_RegisterAllMembers(struct Session &session,
-        class TinyCFG &cfg)
+        class TinyCFG &cfg,t_SessionOpenConnectionRefList *OpenConRefs)
 {
     cfg.StartBlock("MainWindow");
     cfg.Register("AppMaximized",session.AppMaximized);
@@ -919,7 +1267,7 @@ static void Session_RegisterAllMembers(struct Session &session,
     cfg.Register("LastConnectionOpened",session.LastConnectionOpened);
     RegisterConnectionOptions_TinyCFG(cfg,"Options",session.ConnectionsOptions);
 
-    RegisterSessionOpenConnectionsList_TinyCFG(cfg,"OpenConnections",session.OpenConnections);
+    RegisterSessionOpenConnectionsList_TinyCFG(cfg,"OpenConnections",session.OpenConnections,OpenConRefs);
 
     cfg.EndBlock();
 
@@ -944,6 +1292,10 @@ static void Session_RegisterAllMembers(struct Session &session,
     cfg.Register("LastScriptPath",session.LastScriptPath);
     cfg.EndBlock();
 
+    cfg.StartBlock("SaveSelection");
+    cfg.Register("LastPath",session.LastSaveSelectionPath);
+    cfg.EndBlock();
+
     cfg.Register("NextCheckTime",session.NextCheckTime);
 }
 
@@ -982,6 +1334,9 @@ static void Session_DefaultSession(struct Session &session)
     /* Scripts */
     session.LastScriptPath="";
 
+    /* Save selection */
+    session.LastSaveSelectionPath="";
+
     /* New Version Check */
     session.NextCheckTime=0;
 }
@@ -114,6 +114,9 @@ struct Session
     /* Scripts */
     std::string LastScriptPath;
 
+    /* Save selection */
+    std::string LastSaveSelectionPath;
+
     /* New Version Check */
     uint64_t NextCheckTime;
 };
@@ -125,7 +128,6 @@ extern struct Session g_Session;
 void InitSessionSystem(void);
 bool SaveSession(const char *Filename=NULL);
 bool LoadSession(const char *Filename=NULL);
-void AutoSaveSessionTick(void);
 void SaveSessionIfNeeded(void);
 void NoteSessionChanged(void);
 void ScanOpenConnections2Session(void);
@@ -35,6 +35,7 @@
 #include "App/Commands.h"
 #include "App/Connections.h"
 #include "App/CursorKeyMode.h"
+#include "App/PerfStats.h"
 #include "App/Portable.h"
 #include "App/VersionCheckSystem.h"
 #include "OS/Directorys.h"
@@ -119,8 +120,11 @@ bool Settings_RegisterSelectionColorType(class TinyCFG &cfg,const char *XmlName,
 bool Settings_RegisterDataProcessorType(class TinyCFG &cfg,const char *XmlName,
       e_DataProcessorTypeType &Data);
 
+static void Settings_GetDefaultFixedWidthFont(std::string &FontName);
+
 /*** VARIABLE DEFINITIONS     ***/
 class Settings g_Settings;
+static std::string m_Settings_DefaultFixedWidthFont;
 const char *m_SysColorNames[]=
 {
     "Black",
@@ -133,6 +137,66 @@ const char *m_SysColorNames[]=
     "White"
 };
 
+/*******************************************************************************
+ * NAME:
+ *    InitSettings
+ *
+ * SYNOPSIS:
+ *    void InitSettings(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function init's the settings system.  It asks the UI for the
+ *    default font names so defaulting settings after this does not touch the
+ *    UI.  The session and bookmarks are loaded in a background thread and
+ *    default their custom settings as they load, so this must be called
+ *    from the main thread before they start.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    LoadSettings()
+ ******************************************************************************/
+void InitSettings(void)
+{
+    UI_GetDefaultFixedWidthFont(m_Settings_DefaultFixedWidthFont);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Settings_GetDefaultFixedWidthFont
+ *
+ * SYNOPSIS:
+ *    static void Settings_GetDefaultFixedWidthFont(std::string &FontName);
+ *
+ * PARAMETERS:
+ *    FontName [O] -- The name of the default fixed width font
+ *
+ * FUNCTION:
+ *    This function gets the default fixed width font that InitSettings()
+ *    got from the UI.  If InitSettings() has not been called yet (the
+ *    global settings default themselves when they are constructed) then
+ *    it asks the UI.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    InitSettings()
+ ******************************************************************************/
+static void Settings_GetDefaultFixedWidthFont(std::string &FontName)
+{
+    if(m_Settings_DefaultFixedWidthFont.empty())
+    {
+        UI_GetDefaultFixedWidthFont(FontName);
+        return;
+    }
+    FontName=m_Settings_DefaultFixedWidthFont;
+}
+
 /*******************************************************************************
  * NAME:
  *    LoadSettings
@@ -1210,6 +1274,8 @@ void ApplySettings(void)
     CursorKeyMode_ApplySettings();
 
     NewVersionCheck_ApplySettings();
+
+    PerfStats_ApplySettings();
 }
 
 void Settings::RegisterAllMembers(class TinyCFG &cfg)
@@ -1283,6 +1349,7 @@ void Settings::RegisterAllMembers(class TinyCFG &cfg)
 
     cfg.StartBlock("Connections");
         cfg.Register("AutoConnectOnNewConnection",AutoConnectOnNewConnection);
+        cfg.Register("ZModemAutoDownload",ZModemAutoDownload);
     cfg.EndBlock();
 
     cfg.StartBlock("Behaviour");
@@ -1311,6 +1378,12 @@ void Settings::RegisterAllMembers(class TinyCFG &cfg)
     cfg.StartBlock("IODriver");
     RegisterPluginSettingsList(cfg,"PlugsinSettings",IODriverPluginsSettings);
     cfg.EndBlock();
+
+    cfg.StartBlock("Diagnostics");
+        cfg.Register("PerfStatsExportFile",PerfStatsExportFile);
+        cfg.Register("PerfStatsSocketPath",PerfStatsSocketPath);
+        cfg.Register("PerfStatsExportRate",PerfStatsExportRate);
+    cfg.EndBlock();
 }
 
 void ConSettings::RegisterAllMembers(class TinyCFG &cfg)
@@ -1542,6 +1615,7 @@ void Settings::DefaultSettings(void)
 
     AlwaysShowTabs=true;
     AutoConnectOnNewConnection=true;
+    ZModemAutoDownload=true;
 
     DefaultCmdKeyMapping(KeyMapping);
     DotInputStartsAt0=false;
@@ -1575,7 +1649,7 @@ void Settings::DefaultSettings(void)
     HexDisplaysFGColor=0xFFFFFF;
     HexDisplaysBGColor=0x000000;
     HexDisplaysSelBGColor=SELECTION_BG_COLOR_DEFAULT;
-    UI_GetDefaultFixedWidthFont(HexDisplaysFontName);
+    Settings_GetDefaultFixedWidthFont(HexDisplaysFontName);
     HexDisplaysFontSize=12;
     HexDisplaysFontBold=false;
     HexDisplaysFontItalic=false;
@@ -1596,6 +1670,11 @@ void Settings::DefaultSettings(void)
 
     /* Default all the plugins */
     DefaultConSettings.PluginsSettings.clear();
+
+    /* Diagnostics */
+    PerfStatsExportFile="";
+    PerfStatsSocketPath="";
+    PerfStatsExportRate=10;
 }
 
 void ConSettings::DefaultSettings(void)
@@ -1603,7 +1682,7 @@ void ConSettings::DefaultSettings(void)
     CursorColor=0xFFFB00;
     CursorBlink=true;
 
-    UI_GetDefaultFixedWidthFont(FontName);
+    Settings_GetDefaultFixedWidthFont(FontName);
     FontSize=12;
     FontBold=false;
     FontItalic=false;
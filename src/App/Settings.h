@@ -269,6 +269,7 @@ class Settings
 
         /***** Connections *****/
         bool AutoConnectOnNewConnection;
+        bool ZModemAutoDownload;        // Start a ZModem download when we see a sender start
 
         /* Keyboard */
         e_CursorKeyToggleModeType CursorKeyToggleMode;
@@ -296,6 +297,11 @@ class Settings
         bool ReopenOnConnectionsOnStartup;
         bool AutoRescanConnections;
 
+        /***** Diagnostics *****/
+        std::string PerfStatsExportFile;
+        std::string PerfStatsSocketPath;
+        unsigned int PerfStatsExportRate;
+
         /* Connection settings defaults */
         class ConSettings DefaultConSettings;
 
@@ -319,6 +325,7 @@ class Settings
 extern class Settings g_Settings;
 
 /***  EXTERNAL FUNCTION PROTOTYPES     ***/
+void InitSettings(void);
 bool LoadSettings(const char *Filename=NULL);
 bool SaveSettings(const char *Filename=NULL);
 void ApplySettings(void);
@@ -42,11 +42,35 @@
 /*** MACROS                   ***/
 
 /*** TYPE DEFINITIONS         ***/
+typedef enum
+{
+    e_UTF8Class_ASCII,
+    e_UTF8Class_Cont,           // 0x80-0xBF
+    e_UTF8Class_Invalid,        // 0xC0,0xC1 (always overlong), 0xF5-0xFF
+    e_UTF8Class_2Byte,          // 0xC2-0xDF
+    e_UTF8Class_3ByteE0,        // 0xE0 (2nd byte 0xA0-0xBF or it's overlong)
+    e_UTF8Class_3Byte,          // 0xE1-0xEC,0xEE,0xEF
+    e_UTF8Class_3ByteED,        // 0xED (2nd byte 0x80-0x9F or it's a surrogate)
+    e_UTF8Class_4ByteF0,        // 0xF0 (2nd byte 0x90-0xBF or it's overlong)
+    e_UTF8Class_4Byte,          // 0xF1-0xF3
+    e_UTF8Class_4ByteF4,        // 0xF4 (2nd byte 0x80-0x8F or it's >0x10FFFF)
+    e_UTF8ClassMAX
+} e_UTF8ClassType;
+
+struct UTF8ClassInfo
+{
+    uint8_t BytesLeft;          // Number of continuation bytes that follow
+    uint8_t SecondMin;          // The range the 2nd byte must be in
+    uint8_t SecondMax;
+};
+
 struct UnicodeData
 {
     uint8_t BufferedBytes[10];
     int InsertPos;
     int BytesLeft;
+    uint8_t NextMin;            // The range the next continuation byte must be in
+    uint8_t NextMax;
 };
 
 /*** FUNCTION PROTOTYPES      ***/
@@ -57,6 +81,10 @@ const struct DataProcessorInfo *UnicodeDecoder_GetProcessorInfo(unsigned int *Si
 void UnicodeDecoder_ProcessByte(t_DataProcessorHandleType *DataHandle,
         const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
         PG_BOOL *Consumed);
+int UnicodeDecoder_ScanTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes);
+void UnicodeDecoder_ProcessTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes);
 
 /*** VARIABLE DEFINITIONS     ***/
 struct DataProcessorAPI m_UnicodeDecoderCBs=
@@ -74,6 +102,11 @@ struct DataProcessorAPI m_UnicodeDecoderCBs=
     NULL,       // FreeSettingsWidgets
     NULL,       // SetSettingsFromWidgets
     NULL,       // ApplySettings
+    /* V4 */
+    NULL,       // ProcessIncomingTextBlockDone
+    /* V5 */
+    UnicodeDecoder_ScanTextRun,
+    UnicodeDecoder_ProcessTextRun,
 };
 struct DataProcessorInfo m_UnicodeDecoder_Info=
 {
@@ -85,6 +118,39 @@ struct DataProcessorInfo m_UnicodeDecoder_Info=
     e_BinaryDataProcessorModeMAX,
 };
 
+/* The class of every byte when it starts a char */
+static const uint8_t m_UTF8LeadClass[256]=
+{
+    /* 0x00-0x7F */
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+    /* 0x80-0xBF */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+    /* 0xC0-0xDF */
+    2,2,3,3,3,3,3,3,3,3,3,3,3,3,3,3, 3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+    /* 0xE0-0xEF */
+    4,5,5,5,5,5,5,5,5,5,5,5,5,6,5,5,
+    /* 0xF0-0xFF */
+    7,8,8,8,9,2,2,2,2,2,2,2,2,2,2,2,
+};
+
+static const struct UTF8ClassInfo m_UTF8Classes[e_UTF8ClassMAX]=
+{
+    {0,0x00,0x00},  // e_UTF8Class_ASCII
+    {0,0x00,0x00},  // e_UTF8Class_Cont
+    {0,0x00,0x00},  // e_UTF8Class_Invalid
+    {1,0x80,0xBF},  // e_UTF8Class_2Byte
+    {2,0xA0,0xBF},  // e_UTF8Class_3ByteE0
+    {2,0x80,0xBF},  // e_UTF8Class_3Byte
+    {2,0x80,0x9F},  // e_UTF8Class_3ByteED
+    {3,0x90,0xBF},  // e_UTF8Class_4ByteF0
+    {3,0x80,0xBF},  // e_UTF8Class_4Byte
+    {3,0x80,0x8F},  // e_UTF8Class_4ByteF4
+};
+
 static const struct PI_UIAPI *m_UIAPI;
 static const struct PI_SystemAPI *m_System;
 static const struct DPS_API *m_DPS;
@@ -174,6 +240,8 @@ t_DataProcessorHandleType *UnicodeDecoder_AllocateData(void)
 
     Data->InsertPos=0;
     Data->BytesLeft=0;
+    Data->NextMin=0x80;
+    Data->NextMax=0xBF;
 
     return (t_DataProcessorHandleType *)Data;
 }
@@ -283,6 +351,11 @@ const struct DataProcessorInfo *UnicodeDecoder_GetProcessorInfo(
  *  FUNCTION:
  *    This function is called for each byte that comes in.
  *
+ *    Each byte is looked up in 'm_UTF8LeadClass' so AscII (the normal case)
+ *    is one table read.  The table also gives the range the 2nd byte has to
+ *    be in so overlong forms, surrogates, and code points past 0x10FFFF are
+ *    turned into the error char instead of being passed on.
+ *
  *  RETURNS:
  *    NONE
  *
@@ -294,20 +367,26 @@ void UnicodeDecoder_ProcessByte(t_DataProcessorHandleType *DataHandle,
         PG_BOOL *Consumed)
 {
     struct UnicodeData *Data=(struct UnicodeData *)DataHandle;
+    const struct UTF8ClassInfo *Class;
+    uint8_t LeadClass;
 
-    if((RawByte&0x80)==0x00)
+    LeadClass=m_UTF8LeadClass[RawByte];
+    if(LeadClass==e_UTF8Class_ASCII)
     {
         /* AscII */
         Data->BytesLeft=0;
         return;
     }
-    else if((RawByte&0xC0)==0x80)
+    else if(LeadClass==e_UTF8Class_Cont)
     {
         /* Continued bytes */
-        if(Data->BytesLeft>0)
+        if(Data->BytesLeft>0 && RawByte>=Data->NextMin &&
+                RawByte<=Data->NextMax)
         {
             Data->BufferedBytes[Data->InsertPos++]=RawByte;
             Data->BytesLeft--;
+            Data->NextMin=0x80;
+            Data->NextMax=0xBF;
             if(Data->BytesLeft==0)
             {
                 /* This was the last char needed */
@@ -321,39 +400,106 @@ void UnicodeDecoder_ProcessByte(t_DataProcessorHandleType *DataHandle,
         }
         else
         {
-            /* Error */
+            /* Error (stray, overlong, surrogate, or past 0x10FFFF) */
             UnicodeDecoder_Error(ProcessedChar,*CharLen);
+            Data->BytesLeft=0;
         }
         return;
     }
-
-    Data->BufferedBytes[0]=RawByte;
-    Data->InsertPos=1;
-    if((RawByte&0xE0)==0xC0)
-    {
-        /* 2 byte */
-        Data->BytesLeft=1;
-    }
-    else if((RawByte&0xF0)==0xE0)
-    {
-        /* 3 byte */
-        Data->BytesLeft=2;
-    }
-    else if((RawByte&0xF8)==0xF0)
-    {
-        /* 4 byte */
-        Data->BytesLeft=3;
-    }
-    else
+    else if(LeadClass==e_UTF8Class_Invalid)
     {
         /* Error */
         UnicodeDecoder_Error(ProcessedChar,*CharLen);
         Data->BytesLeft=0;
         return;
     }
+
+    Class=&m_UTF8Classes[LeadClass];
+    Data->BufferedBytes[0]=RawByte;
+    Data->InsertPos=1;
+    Data->BytesLeft=Class->BytesLeft;
+    Data->NextMin=Class->SecondMin;
+    Data->NextMax=Class->SecondMax;
+
     *Consumed=true;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    UnicodeDecoder_ScanTextRun
+ *
+ * SYNOPSIS:
+ *    int UnicodeDecoder_ScanTextRun(t_DataProcessorHandleType *DataHandle,
+ *              const uint8_t *Run,int Bytes);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to your internal data.
+ *    Run [I] -- The bytes that have not been processed yet
+ *    Bytes [I] -- The number of bytes in 'Run'
+ *
+ * FUNCTION:
+ *    This function finds how many bytes at the start of 'Run' are AscII.
+ *    AscII is passed though untouched, unless we are in the middle of a
+ *    char (then the AscII byte is an error and we say no).
+ *
+ *    This is the place a block (SIMD) decoder would sit.  Checking 8 bytes
+ *    at a time for the high bit was tried here, but it made no difference
+ *    to the PipelineBench processors stage (the time goes on the multi byte
+ *    chars, which still come in one at a time), so it is a table walk.
+ *
+ * RETURNS:
+ *    The number of bytes that can be passed though.
+ *
+ * SEE ALSO:
+ *    UnicodeDecoder_ProcessTextRun()
+ ******************************************************************************/
+int UnicodeDecoder_ScanTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes)
+{
+    struct UnicodeData *Data=(struct UnicodeData *)DataHandle;
+    int r;
+
+    if(Data->BytesLeft>0)
+        return 0;
+
+    for(r=0;r<Bytes;r++)
+        if(m_UTF8LeadClass[Run[r]]!=e_UTF8Class_ASCII)
+            break;
+
+    return r;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    UnicodeDecoder_ProcessTextRun
+ *
+ * SYNOPSIS:
+ *    void UnicodeDecoder_ProcessTextRun(t_DataProcessorHandleType *DataHandle,
+ *              const uint8_t *Run,int Bytes);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to your internal data.
+ *    Run [I] -- The AscII bytes being passed though
+ *    Bytes [I] -- The number of bytes in 'Run'
+ *
+ * FUNCTION:
+ *    This function is called for a run of AscII that
+ *    UnicodeDecoder_ScanTextRun() said could be passed though.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    UnicodeDecoder_ScanTextRun()
+ ******************************************************************************/
+void UnicodeDecoder_ProcessTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes)
+{
+    struct UnicodeData *Data=(struct UnicodeData *)DataHandle;
+
+    Data->BytesLeft=0;
+}
+
 /*******************************************************************************
  * NAME:
  *    UnicodeDecoder_Error
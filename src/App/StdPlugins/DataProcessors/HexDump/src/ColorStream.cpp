@@ -608,6 +608,7 @@ void ColorStreamProcessIncomingByte_MoveToNextField(struct ColorStreamData *CSD)
 void ColorStreamProcessIncomingByteFinish(struct ColorStreamData *CSD,uint8_t Byte,bool DidStyling)
 {
     struct BPDSParsedData *ReadData;
+    struct DPS_StyleSpan Span;
 
     if(CSD->MarkStartOfField!=NULL)
     {
@@ -618,10 +619,16 @@ void ColorStreamProcessIncomingByteFinish(struct ColorStreamData *CSD,uint8_t By
         {
             g_DPS->MoveMark(Mark,-(CSD->MarkSize));
 
+            /* Do the whole style in 1 go (so we only redraw once) */
             ReadData=(struct BPDSParsedData *)CSD->MarkStartOfField->UserData;
-            g_DPS->ApplyAttrib2Mark(Mark,ReadData->Style.Attribs,0,CSD->MarkSize);
-            g_DPS->ApplyFGColor2Mark(Mark,ReadData->Style.FGColor,0,CSD->MarkSize);
-            g_DPS->ApplyBGColor2Mark(Mark,ReadData->Style.BGColor,0,CSD->MarkSize);
+            Span.Offset=0;
+            Span.Len=CSD->MarkSize;
+            Span.What=DPS_STYLESPAN_SET_ATTRIBS|DPS_STYLESPAN_FGCOLOR|
+                    DPS_STYLESPAN_BGCOLOR;
+            Span.Attribs=ReadData->Style.Attribs;
+            Span.FGColor=ReadData->Style.FGColor;
+            Span.BGColor=ReadData->Style.BGColor;
+            g_DPS->ApplyStyleSpans2Mark(Mark,&Span,1);
 
             g_DPS->FreeMark(Mark);
         }
@@ -0,0 +1,1551 @@
+/*******************************************************************************
+ * FILENAME: HighlightDFA.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the highlighter DFA in it.  All the rules are parsed
+ *    into a tree, the trees are turned into one NFA (Thompson's
+ *    construction, with a match state per rule), and then the NFA is turned
+ *    into a DFA (subset construction).
+ *
+ *    To keep the table small the bytes are first split into classes of
+ *    bytes that no rule can tell apart (most rule sets only end up with
+ *    a few dozen classes) so the table is States x Classes instead of
+ *    States x 256.
+ *
+ *    The regex's support:
+ *          abc     Literal chars (UTF-8 is fine)
+ *          .       Any char
+ *          [a-z]   Sets of (ASCII) chars, [^a-z] for not in the set
+ *          \d \w \s \D \W \S \t \n \r \f \v \xHH and \ before any symbol
+ *          (a|b)   Groups and alternatives ((?:) is the same as ())
+ *          * + ? {n} {n,} {n,m}
+ *
+ *    There are no anchors or back references (a DFA can't do back
+ *    references).
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "HighlightDFA.h"
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define HDFA_MAX_PARSE_DEPTH                    100
+
+/*** MACROS                   ***/
+#define HDFA_BIT_SET(Bits,b)                    ((Bits)[(b)>>5]|=(1U<<((b)&31)))
+#define HDFA_BIT_IS_SET(Bits,b)                 (((Bits)[(b)>>5]>>((b)&31))&1)
+
+/*** TYPE DEFINITIONS         ***/
+typedef map<vector<int>,int> t_HDFAStateLookupType;
+typedef t_HDFAStateLookupType::iterator i_HDFAStateLookupType;
+
+/*** FUNCTION PROTOTYPES      ***/
+static void HDFA_InvertASCII(uint32_t *Bits);
+
+/*** VARIABLE DEFINITIONS     ***/
+
+HighlightDFA::HighlightDFA()
+{
+    ParseStart=NULL;
+    ParsePos=NULL;
+    ParseIgnoreCase=false;
+    Clear();
+}
+
+HighlightDFA::~HighlightDFA()
+{
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::Clear
+ *
+ * SYNOPSIS:
+ *    void HighlightDFA::Clear(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function throws away all the rules and the compiled DFA.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+void HighlightDFA::Clear(void)
+{
+    Nodes.clear();
+    Rules.clear();
+    NFA.clear();
+    Trans.clear();
+    Accept.clear();
+    Final.clear();
+    memset(ClassOf,0x00,sizeof(ClassOf));
+    NumClasses=1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::AddRegex
+ *
+ * SYNOPSIS:
+ *    bool HighlightDFA::AddRegex(const char *Pattern,bool IgnoreCase,
+ *              int RuleID,std::string &ErrorMsg,unsigned int &ErrorOffset);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The regex to add (see the top of the file for what
+ *                   is supported)
+ *    IgnoreCase [I] -- Match ASCII letters in either case
+ *    RuleID [I] -- The ID to return from GetAccept() when this rule
+ *                  matches.  When more than one rule matches the same
+ *                  text the lowest ID wins.
+ *    ErrorMsg [O] -- What went wrong (if we return false)
+ *    ErrorOffset [O] -- Where in 'Pattern' it went wrong
+ *
+ * FUNCTION:
+ *    This function parses a regex and adds it to the list of rules.  You
+ *    need to call Compile() after adding all the rules.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error in the regex.  'ErrorMsg' has been filled
+ *             in.
+ *
+ * SEE ALSO:
+ *    AddKeywords(), Compile()
+ ******************************************************************************/
+bool HighlightDFA::AddRegex(const char *Pattern,bool IgnoreCase,int RuleID,
+        std::string &ErrorMsg,unsigned int &ErrorOffset)
+{
+    struct HDFARule NewRule;
+    size_t FirstNode;
+    int Root;
+
+    FirstNode=Nodes.size();
+    ErrorOffset=0;
+
+    if(*Pattern==0)
+    {
+        ErrorMsg="Empty pattern";
+        return false;
+    }
+
+    try
+    {
+        ParseStart=Pattern;
+        ParsePos=Pattern;
+        ParseIgnoreCase=IgnoreCase;
+        ParseError="";
+
+        Root=ParseAlt(0);
+        if(Root>=0 && *ParsePos!=0)
+        {
+            /* The only thing that stops ParseAlt() early is a ')' */
+            ParseError="Unmatched ')'";
+            Root=-1;
+        }
+
+        if(Root<0)
+        {
+            ErrorMsg=ParseError;
+            ErrorOffset=ParsePos-ParseStart;
+            Nodes.resize(FirstNode);
+            return false;
+        }
+
+        NewRule.Root=Root;
+        NewRule.RuleID=RuleID;
+        Rules.push_back(NewRule);
+    }
+    catch(...)
+    {
+        ErrorMsg="Out of memory";
+        Nodes.resize(FirstNode);
+        return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::AddKeywords
+ *
+ * SYNOPSIS:
+ *    bool HighlightDFA::AddKeywords(const char *Words,bool IgnoreCase,
+ *              int RuleID,std::string &ErrorMsg);
+ *
+ * PARAMETERS:
+ *    Words [I] -- A list of words split by spaces.  These are taken as is
+ *                 (no regex chars).
+ *    IgnoreCase [I] -- Match ASCII letters in either case
+ *    RuleID [I] -- The ID to return from GetAccept() when one of the words
+ *                  matches.  See AddRegex().
+ *    ErrorMsg [O] -- What went wrong (if we return false)
+ *
+ * FUNCTION:
+ *    This function adds a list of keywords as one rule.  You need to call
+ *    Compile() after adding all the rules.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.  'ErrorMsg' has been filled in.
+ *
+ * SEE ALSO:
+ *    AddRegex(), Compile()
+ ******************************************************************************/
+bool HighlightDFA::AddKeywords(const char *Words,bool IgnoreCase,int RuleID,
+        std::string &ErrorMsg)
+{
+    struct HDFARule NewRule;
+    size_t FirstNode;
+    const char *Pos;
+    int Root;
+    int Word;
+    int Byte;
+
+    FirstNode=Nodes.size();
+    ParseIgnoreCase=IgnoreCase;
+
+    try
+    {
+        Root=-1;
+        Pos=Words;
+        while(*Pos!=0)
+        {
+            if(*Pos==' ' || *Pos=='\t')
+            {
+                Pos++;
+                continue;
+            }
+
+            Word=-1;
+            while(*Pos!=0 && *Pos!=' ' && *Pos!='\t')
+            {
+                Byte=NewByteNode(*Pos++);
+                if(Word<0)
+                    Word=Byte;
+                else
+                    Word=NewNode(e_HDFANode_Concat,Word,Byte);
+            }
+
+            if(Root<0)
+                Root=Word;
+            else
+                Root=NewNode(e_HDFANode_Alt,Root,Word);
+        }
+
+        if(Root<0)
+        {
+            ErrorMsg="No keywords";
+            return false;
+        }
+
+        NewRule.Root=Root;
+        NewRule.RuleID=RuleID;
+        Rules.push_back(NewRule);
+    }
+    catch(...)
+    {
+        ErrorMsg="Out of memory";
+        Nodes.resize(FirstNode);
+        return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::IsEmpty
+ *
+ * SYNOPSIS:
+ *    bool HighlightDFA::IsEmpty(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function checks if any rules have been added.
+ *
+ * RETURNS:
+ *    true -- There are no rules
+ *    false -- There is at least 1 rule
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+bool HighlightDFA::IsEmpty(void)
+{
+    return Rules.empty();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::GetStateCount
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::GetStateCount(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the number of states in the compiled DFA
+ *    (including the dead state).
+ *
+ * RETURNS:
+ *    The number of states.  0 if Compile() hasn't been called.
+ *
+ * SEE ALSO:
+ *    Compile()
+ ******************************************************************************/
+int HighlightDFA::GetStateCount(void)
+{
+    return Accept.size();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::Compile
+ *
+ * SYNOPSIS:
+ *    bool HighlightDFA::Compile(std::string &ErrorMsg);
+ *
+ * PARAMETERS:
+ *    ErrorMsg [O] -- What went wrong (if we return false)
+ *
+ * FUNCTION:
+ *    This function takes all the rules that have been added and builds the
+ *    DFA.  After this Step() can be used starting from
+ *    HIGHLIGHTDFA_START_STATE.  Once Step() returns HIGHLIGHTDFA_DEAD_STATE
+ *    no rule can match.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- The rules made too many states (or we ran out of memory).
+ *             The DFA will not match anything.
+ *
+ * SEE ALSO:
+ *    AddRegex(), AddKeywords(), Step()
+ ******************************************************************************/
+bool HighlightDFA::Compile(std::string &ErrorMsg)
+{
+    vector<int> Starts;
+    vector< vector<int> > DStates;
+    t_HDFAStateLookupType Lookup;
+    i_HDFAStateLookupType Found;
+    vector<int> Cur;
+    vector<int> Next;
+    vector<int> Marks;
+    vector<int> Stack;
+    uint8_t ClassRep[256];
+    int Stamp;
+    unsigned int s;
+    unsigned int r;
+    int c;
+    int b;
+    int BestRule;
+    bool AllDead;
+    int NewState;
+
+    Trans.clear();
+    Accept.clear();
+    Final.clear();
+    NFA.clear();
+
+    try
+    {
+        /* Thompson's construction, each rule ends in it's own match state */
+        for(r=0;r<Rules.size();r++)
+        {
+            NewState=NewNFAState(e_HDFANFA_Match,-1,-1,-1,Rules[r].RuleID);
+            Starts.push_back(GenNFA(Rules[r].Root,NewState));
+        }
+
+        BuildByteClasses();
+        for(b=255;b>=0;b--)
+            ClassRep[ClassOf[b]]=b;
+
+        Marks.assign(NFA.size(),0);
+        Stamp=0;
+
+        /* State 0 is the dead state, state 1 is the start */
+        DStates.push_back(vector<int>());
+        Lookup[DStates[0]]=0;
+
+        Cur=Starts;
+        Closure(Cur,Marks,Stamp,Stack);
+        DStates.push_back(Cur);
+        Lookup.insert(make_pair(Cur,1));
+
+        /* Subset construction */
+        for(s=0;s<DStates.size();s++)
+        {
+            Cur=DStates[s];
+
+            AllDead=true;
+            for(c=0;c<NumClasses;c++)
+            {
+                Next.clear();
+                for(r=0;r<Cur.size();r++)
+                {
+                    if(NFA[Cur[r]].Type==e_HDFANFA_Set &&
+                            HDFA_BIT_IS_SET(Nodes[NFA[Cur[r]].Set].Bits,
+                            ClassRep[c]))
+                    {
+                        Next.push_back(NFA[Cur[r]].Out);
+                    }
+                }
+                Closure(Next,Marks,Stamp,Stack);
+
+                Found=Lookup.find(Next);
+                if(Found!=Lookup.end())
+                {
+                    NewState=Found->second;
+                }
+                else
+                {
+                    if(DStates.size()>=HIGHLIGHTDFA_MAX_STATES)
+                        throw(0);
+                    NewState=DStates.size();
+                    DStates.push_back(Next);
+                    Lookup.insert(make_pair(Next,NewState));
+                }
+
+                Trans.push_back(NewState);
+                if(NewState!=HIGHLIGHTDFA_DEAD_STATE)
+                    AllDead=false;
+            }
+
+            BestRule=HIGHLIGHTDFA_NO_RULE;
+            for(r=0;r<Cur.size();r++)
+            {
+                if(NFA[Cur[r]].Type==e_HDFANFA_Match &&
+                        (BestRule==HIGHLIGHTDFA_NO_RULE ||
+                        NFA[Cur[r]].Rule<BestRule))
+                {
+                    BestRule=NFA[Cur[r]].Rule;
+                }
+            }
+            Accept.push_back(BestRule);
+            Final.push_back(AllDead);
+        }
+    }
+    catch(...)
+    {
+        ErrorMsg="The rules are too complex (they need more than ";
+        ErrorMsg+=to_string(HIGHLIGHTDFA_MAX_STATES);
+        ErrorMsg+=" states)";
+
+        /* Leave a DFA that never matches */
+        NFA.clear();
+        memset(ClassOf,0x00,sizeof(ClassOf));
+        NumClasses=1;
+        Trans.assign(2,HIGHLIGHTDFA_DEAD_STATE);
+        Accept.assign(2,HIGHLIGHTDFA_NO_RULE);
+        Final.assign(2,true);
+        return false;
+    }
+
+    /* We don't need the NFA any more */
+    vector<struct HDFANFAState>().swap(NFA);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::NewNode
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::NewNode(e_HDFANodeType Type,int Left,int Right);
+ *
+ * PARAMETERS:
+ *    Type [I] -- The type of node to add
+ *    Left [I] -- The left child (or the thing to repeat)
+ *    Right [I] -- The right child
+ *
+ * FUNCTION:
+ *    This function adds a new node to the parse tree.
+ *
+ * RETURNS:
+ *    The index of the new node.
+ *
+ * SEE ALSO:
+ *    NewSetNode()
+ ******************************************************************************/
+int HighlightDFA::NewNode(e_HDFANodeType Type,int Left,int Right)
+{
+    struct HDFANode NewNode;
+
+    memset(&NewNode,0x00,sizeof(NewNode));
+    NewNode.Type=Type;
+    NewNode.Left=Left;
+    NewNode.Right=Right;
+    NewNode.Min=0;
+    NewNode.Max=-1;
+
+    Nodes.push_back(NewNode);
+
+    return Nodes.size()-1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::NewSetNode
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::NewSetNode(const uint32_t *Bits);
+ *
+ * PARAMETERS:
+ *    Bits [I] -- The 256 bits of what bytes this node matches
+ *
+ * FUNCTION:
+ *    This function adds a node that matches 1 byte.
+ *
+ * RETURNS:
+ *    The index of the new node.
+ *
+ * SEE ALSO:
+ *    NewByteNode(), NewRangeNode()
+ ******************************************************************************/
+int HighlightDFA::NewSetNode(const uint32_t *Bits)
+{
+    int Node;
+
+    Node=NewNode(e_HDFANode_Set,-1,-1);
+    memcpy(Nodes[Node].Bits,Bits,sizeof(Nodes[Node].Bits));
+
+    return Node;
+}
+
+int HighlightDFA::NewByteNode(uint8_t Byte)
+{
+    uint32_t Bits[8];
+
+    memset(Bits,0x00,sizeof(Bits));
+    HDFA_BIT_SET(Bits,Byte);
+    if(ParseIgnoreCase)
+        AddCase2Bits(Bits);
+
+    return NewSetNode(Bits);
+}
+
+int HighlightDFA::NewRangeNode(uint8_t Low,uint8_t High)
+{
+    uint32_t Bits[8];
+    int b;
+
+    memset(Bits,0x00,sizeof(Bits));
+    for(b=Low;b<=High;b++)
+        HDFA_BIT_SET(Bits,b);
+
+    return NewSetNode(Bits);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::NewMultiByteCharNode
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::NewMultiByteCharNode(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function adds the nodes to match any 1 UTF-8 char that is more
+ *    than 1 byte long.  This is used for '.' and [^] so they match a whole
+ *    char and not just the first byte of it.
+ *
+ * RETURNS:
+ *    The index of the new node.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+int HighlightDFA::NewMultiByteCharNode(void)
+{
+    int Two;
+    int Three;
+    int Four;
+    int r;
+
+    Two=NewNode(e_HDFANode_Concat,NewRangeNode(0xC2,0xDF),
+            NewRangeNode(0x80,0xBF));
+
+    Three=NewRangeNode(0xE0,0xEF);
+    for(r=0;r<2;r++)
+        Three=NewNode(e_HDFANode_Concat,Three,NewRangeNode(0x80,0xBF));
+
+    Four=NewRangeNode(0xF0,0xF4);
+    for(r=0;r<3;r++)
+        Four=NewNode(e_HDFANode_Concat,Four,NewRangeNode(0x80,0xBF));
+
+    return NewNode(e_HDFANode_Alt,NewNode(e_HDFANode_Alt,Two,Three),Four);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::AddCase2Bits
+ *
+ * SYNOPSIS:
+ *    void HighlightDFA::AddCase2Bits(uint32_t *Bits);
+ *
+ * PARAMETERS:
+ *    Bits [I/O] -- The set of bytes to add the other case to
+ *
+ * FUNCTION:
+ *    This function makes it so if an ASCII letter is in the set then both
+ *    the upper and lower case of it are in the set.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+void HighlightDFA::AddCase2Bits(uint32_t *Bits)
+{
+    int c;
+
+    for(c='a';c<='z';c++)
+    {
+        if(HDFA_BIT_IS_SET(Bits,c) || HDFA_BIT_IS_SET(Bits,c-'a'+'A'))
+        {
+            HDFA_BIT_SET(Bits,c);
+            HDFA_BIT_SET(Bits,c-'a'+'A');
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::ParseAlt
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::ParseAlt(int Depth);
+ *
+ * PARAMETERS:
+ *    Depth [I] -- How many groups deep we are
+ *
+ * FUNCTION:
+ *    This function parses 'a|b|c' from 'ParsePos'.  It stops at the end
+ *    of the string or a ')'.
+ *
+ * RETURNS:
+ *    The index of the node for what we parsed or -1 if there was an error
+ *    ('ParseError' will have been set).
+ *
+ * SEE ALSO:
+ *    ParseConcat()
+ ******************************************************************************/
+int HighlightDFA::ParseAlt(int Depth)
+{
+    int Left;
+    int Right;
+
+    if(Depth>HDFA_MAX_PARSE_DEPTH)
+    {
+        ParseError="Too many nested groups";
+        return -1;
+    }
+
+    Left=ParseConcat(Depth);
+    if(Left<0)
+        return -1;
+
+    while(*ParsePos=='|')
+    {
+        ParsePos++;
+        Right=ParseConcat(Depth);
+        if(Right<0)
+            return -1;
+        Left=NewNode(e_HDFANode_Alt,Left,Right);
+    }
+
+    return Left;
+}
+
+int HighlightDFA::ParseConcat(int Depth)
+{
+    int Result;
+    int Atom;
+
+    Result=-1;
+    while(*ParsePos!=0 && *ParsePos!='|' && *ParsePos!=')')
+    {
+        Atom=ParseRepeat(Depth);
+        if(Atom<0)
+            return -1;
+
+        if(Result<0)
+            Result=Atom;
+        else
+            Result=NewNode(e_HDFANode_Concat,Result,Atom);
+    }
+
+    if(Result<0)
+        Result=NewNode(e_HDFANode_Empty,-1,-1);
+
+    return Result;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::ParseRepeat
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::ParseRepeat(int Depth);
+ *
+ * PARAMETERS:
+ *    Depth [I] -- How many groups deep we are
+ *
+ * FUNCTION:
+ *    This function parses an atom and any * + ? {n,m} after it.  Lazy
+ *    versions (*?) are taken as the normal versions because we always
+ *    take the longest match anyway.
+ *
+ * RETURNS:
+ *    The index of the node for what we parsed or -1 if there was an error
+ *    ('ParseError' will have been set).
+ *
+ * SEE ALSO:
+ *    ParseAtom(), ParseRepeatCount()
+ ******************************************************************************/
+int HighlightDFA::ParseRepeat(int Depth)
+{
+    const char *Save;
+    int Atom;
+    int Min;
+    int Max;
+
+    Atom=ParseAtom(Depth);
+    if(Atom<0)
+        return -1;
+
+    for(;;)
+    {
+        if(*ParsePos=='*')
+        {
+            Min=0;
+            Max=-1;
+            ParsePos++;
+        }
+        else if(*ParsePos=='+')
+        {
+            Min=1;
+            Max=-1;
+            ParsePos++;
+        }
+        else if(*ParsePos=='?')
+        {
+            Min=0;
+            Max=1;
+            ParsePos++;
+        }
+        else if(*ParsePos=='{')
+        {
+            Save=ParsePos;
+            if(!ParseRepeatCount(Min,Max))
+            {
+                if(ParseError!="")
+                    return -1;
+
+                /* Not a repeat, it's just a '{' */
+                ParsePos=Save;
+                break;
+            }
+        }
+        else
+        {
+            break;
+        }
+
+        Atom=NewNode(e_HDFANode_Repeat,Atom,-1);
+        Nodes[Atom].Min=Min;
+        Nodes[Atom].Max=Max;
+    }
+
+    return Atom;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::ParseRepeatCount
+ *
+ * SYNOPSIS:
+ *    bool HighlightDFA::ParseRepeatCount(int &Min,int &Max);
+ *
+ * PARAMETERS:
+ *    Min [O] -- The min number of times to repeat
+ *    Max [O] -- The max number of times to repeat (-1 = no limit)
+ *
+ * FUNCTION:
+ *    This function parses {n}, {n,}, or {n,m}.  'ParsePos' must be on the
+ *    '{'.
+ *
+ * RETURNS:
+ *    true -- We parsed a repeat count
+ *    false -- This isn't a repeat count.  If 'ParseError' is set then
+ *             the count was bad, if not then the '{' should be taken as
+ *             a normal char.
+ *
+ * SEE ALSO:
+ *    ParseRepeat()
+ ******************************************************************************/
+bool HighlightDFA::ParseRepeatCount(int &Min,int &Max)
+{
+    const char *Pos;
+
+    Pos=ParsePos+1;
+    if(*Pos<'0' || *Pos>'9')
+        return false;
+
+    Min=0;
+    while(*Pos>='0' && *Pos<='9' && Min<=HIGHLIGHTDFA_MAX_REPEAT)
+        Min=Min*10+*Pos++-'0';
+
+    Max=Min;
+    if(*Pos==',')
+    {
+        Pos++;
+        Max=-1;
+        if(*Pos>='0' && *Pos<='9')
+        {
+            Max=0;
+            while(*Pos>='0' && *Pos<='9' && Max<=HIGHLIGHTDFA_MAX_REPEAT)
+                Max=Max*10+*Pos++-'0';
+        }
+    }
+
+    if(*Pos!='}')
+    {
+        /* If we stopped on a digit the number was too big */
+        if(*Pos>='0' && *Pos<='9')
+            ParseError="Repeat count too big";
+        return false;
+    }
+    Pos++;
+
+    if(Min>HIGHLIGHTDFA_MAX_REPEAT || Max>HIGHLIGHTDFA_MAX_REPEAT)
+    {
+        ParseError="Repeat count too big";
+        return false;
+    }
+
+    if(Max>=0 && Max<Min)
+    {
+        ParseError="Bad repeat range";
+        return false;
+    }
+
+    ParsePos=Pos;
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::ParseAtom
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::ParseAtom(int Depth);
+ *
+ * PARAMETERS:
+ *    Depth [I] -- How many groups deep we are
+ *
+ * FUNCTION:
+ *    This function parses 1 char, set, escape, or group.
+ *
+ * RETURNS:
+ *    The index of the node for what we parsed or -1 if there was an error
+ *    ('ParseError' will have been set).
+ *
+ * SEE ALSO:
+ *    ParseClass(), ParseEscape()
+ ******************************************************************************/
+int HighlightDFA::ParseAtom(int Depth)
+{
+    uint32_t Bits[8];
+    bool Negated;
+    uint8_t c;
+    int Node;
+
+    c=*ParsePos;
+    switch(c)
+    {
+        case '(':
+            ParsePos++;
+            if(ParsePos[0]=='?' && ParsePos[1]==':')
+                ParsePos+=2;
+            Node=ParseAlt(Depth+1);
+            if(Node<0)
+                return -1;
+            if(*ParsePos!=')')
+            {
+                ParseError="Missing ')'";
+                return -1;
+            }
+            ParsePos++;
+            return Node;
+        case '[':
+            return ParseClass();
+        case '.':
+            ParsePos++;
+            memset(Bits,0x00,sizeof(Bits));
+            HDFA_BIT_SET(Bits,'\n');
+            HDFA_InvertASCII(Bits);
+            return NewNode(e_HDFANode_Alt,NewSetNode(Bits),
+                    NewMultiByteCharNode());
+        case '\\':
+            ParsePos++;
+            if(!ParseEscape(Bits,Negated))
+                return -1;
+            if(ParseIgnoreCase)
+                AddCase2Bits(Bits);
+            if(Negated)
+            {
+                HDFA_InvertASCII(Bits);
+                return NewNode(e_HDFANode_Alt,NewSetNode(Bits),
+                        NewMultiByteCharNode());
+            }
+            return NewSetNode(Bits);
+        case '*':
+        case '+':
+        case '?':
+            ParseError="Nothing to repeat";
+            return -1;
+        case '^':
+        case '$':
+            ParseError="Anchors (^ and $) are not supported";
+            return -1;
+        default:
+        break;
+    }
+
+    if(c>=0x80)
+        return ParseUTF8Literal();
+
+    ParsePos++;
+    return NewByteNode(c);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::ParseUTF8Literal
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::ParseUTF8Literal(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function parses a UTF-8 char that is more than 1 byte long.  All
+ *    the bytes of the char are kept together so a * after it repeats the
+ *    whole char.
+ *
+ * RETURNS:
+ *    The index of the node for what we parsed.
+ *
+ * SEE ALSO:
+ *    ParseAtom()
+ ******************************************************************************/
+int HighlightDFA::ParseUTF8Literal(void)
+{
+    uint8_t Lead;
+    int Node;
+    int Len;
+    int r;
+
+    Lead=*ParsePos++;
+    if(Lead>=0xF0)
+        Len=4;
+    else if(Lead>=0xE0)
+        Len=3;
+    else if(Lead>=0xC0)
+        Len=2;
+    else
+        Len=1;
+
+    Node=NewByteNode(Lead);
+    for(r=1;r<Len && ((uint8_t)*ParsePos&0xC0)==0x80;r++)
+        Node=NewNode(e_HDFANode_Concat,Node,NewByteNode(*ParsePos++));
+
+    return Node;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::ParseEscape
+ *
+ * SYNOPSIS:
+ *    bool HighlightDFA::ParseEscape(uint32_t *Bits,bool &Negated);
+ *
+ * PARAMETERS:
+ *    Bits [O] -- The set of bytes this escape matches
+ *    Negated [O] -- This is an escape like \D that matches everything
+ *                   not in 'Bits'.
+ *
+ * FUNCTION:
+ *    This function parses the char after a \.  'ParsePos' must be on the
+ *    char after the \.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error ('ParseError' will have been set).
+ *
+ * SEE ALSO:
+ *    ParseAtom(), ParseClass()
+ ******************************************************************************/
+bool HighlightDFA::ParseEscape(uint32_t *Bits,bool &Negated)
+{
+    uint8_t c;
+    int Value;
+    int r;
+    int d;
+
+    memset(Bits,0x00,sizeof(uint32_t)*8);
+    Negated=false;
+
+    c=*ParsePos;
+    if(c==0)
+    {
+        ParseError="Trailing \\";
+        return false;
+    }
+    ParsePos++;
+
+    switch(c)
+    {
+        case 'D':
+            Negated=true;
+        /* Fall through */
+        case 'd':
+            for(r='0';r<='9';r++)
+                HDFA_BIT_SET(Bits,r);
+        break;
+        case 'W':
+            Negated=true;
+        /* Fall through */
+        case 'w':
+            for(r='0';r<='9';r++)
+                HDFA_BIT_SET(Bits,r);
+            for(r='a';r<='z';r++)
+            {
+                HDFA_BIT_SET(Bits,r);
+                HDFA_BIT_SET(Bits,r-'a'+'A');
+            }
+            HDFA_BIT_SET(Bits,'_');
+        break;
+        case 'S':
+            Negated=true;
+        /* Fall through */
+        case 's':
+            HDFA_BIT_SET(Bits,' ');
+            HDFA_BIT_SET(Bits,'\t');
+            HDFA_BIT_SET(Bits,'\n');
+            HDFA_BIT_SET(Bits,'\r');
+            HDFA_BIT_SET(Bits,'\f');
+            HDFA_BIT_SET(Bits,'\v');
+        break;
+        case 't':
+            HDFA_BIT_SET(Bits,'\t');
+        break;
+        case 'n':
+            HDFA_BIT_SET(Bits,'\n');
+        break;
+        case 'r':
+            HDFA_BIT_SET(Bits,'\r');
+        break;
+        case 'f':
+            HDFA_BIT_SET(Bits,'\f');
+        break;
+        case 'v':
+            HDFA_BIT_SET(Bits,'\v');
+        break;
+        case 'x':
+            Value=0;
+            for(r=0;r<2;r++)
+            {
+                c=*ParsePos;
+                if(c>='0' && c<='9')
+                    d=c-'0';
+                else if(c>='a' && c<='f')
+                    d=c-'a'+10;
+                else if(c>='A' && c<='F')
+                    d=c-'A'+10;
+                else
+                {
+                    ParseError="\\x needs 2 hex digits";
+                    return false;
+                }
+                Value=Value*16+d;
+                ParsePos++;
+            }
+            HDFA_BIT_SET(Bits,Value);
+        break;
+        default:
+            if((c>='a' && c<='z') || (c>='A' && c<='Z') ||
+                    (c>='0' && c<='9') || c>=0x80)
+            {
+                ParsePos--;
+                ParseError="Unknown escape";
+                return false;
+            }
+            HDFA_BIT_SET(Bits,c);
+        break;
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::ParseClass
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::ParseClass(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function parses a [] set.  'ParsePos' must be on the '['.  Only
+ *    ASCII chars can be in the set, but a [^] set will match any non ASCII
+ *    char.
+ *
+ * RETURNS:
+ *    The index of the node for what we parsed or -1 if there was an error
+ *    ('ParseError' will have been set).
+ *
+ * SEE ALSO:
+ *    ParseAtom()
+ ******************************************************************************/
+int HighlightDFA::ParseClass(void)
+{
+    uint32_t ClassBits[8];
+    uint32_t Bits[8];
+    bool Negate;
+    bool Negated;
+    bool First;
+    int Low;
+    int High;
+    int b;
+    int r;
+    int Count;
+
+    ParsePos++;
+    Negate=false;
+    if(*ParsePos=='^')
+    {
+        Negate=true;
+        ParsePos++;
+    }
+
+    memset(ClassBits,0x00,sizeof(ClassBits));
+    First=true;
+    for(;;)
+    {
+        if(*ParsePos==0)
+        {
+            ParseError="Missing ']'";
+            return -1;
+        }
+        if(*ParsePos==']' && !First)
+        {
+            ParsePos++;
+            break;
+        }
+        First=false;
+
+        Low=-1;
+        if(*ParsePos=='\\')
+        {
+            ParsePos++;
+            if(!ParseEscape(Bits,Negated))
+                return -1;
+            if(Negated)
+                HDFA_InvertASCII(Bits);
+
+            /* If it's just 1 byte it can start a range */
+            Count=0;
+            for(b=0;b<256;b++)
+            {
+                if(HDFA_BIT_IS_SET(Bits,b))
+                {
+                    Low=b;
+                    Count++;
+                }
+            }
+            if(Count!=1)
+            {
+                for(r=0;r<8;r++)
+                    ClassBits[r]|=Bits[r];
+                continue;
+            }
+        }
+        else if((uint8_t)*ParsePos>=0x80)
+        {
+            ParseError="Only ASCII chars can be used in []";
+            return -1;
+        }
+        else
+        {
+            Low=*ParsePos++;
+        }
+
+        High=Low;
+        if(ParsePos[0]=='-' && ParsePos[1]!=']' && ParsePos[1]!=0)
+        {
+            ParsePos++;
+            if(*ParsePos=='\\')
+            {
+                ParsePos++;
+                if(!ParseEscape(Bits,Negated))
+                    return -1;
+                Count=0;
+                for(b=0;b<256;b++)
+                {
+                    if(HDFA_BIT_IS_SET(Bits,b))
+                    {
+                        High=b;
+                        Count++;
+                    }
+                }
+                if(Count!=1 || Negated)
+                {
+                    ParseError="Bad range in []";
+                    return -1;
+                }
+            }
+            else if((uint8_t)*ParsePos>=0x80)
+            {
+                ParseError="Only ASCII chars can be used in []";
+                return -1;
+            }
+            else
+            {
+                High=*ParsePos++;
+            }
+
+            if(High<Low)
+            {
+                ParseError="Bad range in []";
+                return -1;
+            }
+        }
+
+        for(b=Low;b<=High;b++)
+            HDFA_BIT_SET(ClassBits,b);
+    }
+
+    if(ParseIgnoreCase)
+        AddCase2Bits(ClassBits);
+
+    if(Negate)
+    {
+        HDFA_InvertASCII(ClassBits);
+        return NewNode(e_HDFANode_Alt,NewSetNode(ClassBits),
+                NewMultiByteCharNode());
+    }
+
+    return NewSetNode(ClassBits);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::NewNFAState
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::NewNFAState(e_HDFANFAType Type,int Set,int Out,
+ *              int Out1,int Rule);
+ *
+ * PARAMETERS:
+ *    Type [I] -- The type of NFA state
+ *    Set [I] -- The node with the bits to match (for e_HDFANFA_Set)
+ *    Out [I] -- The next state
+ *    Out1 [I] -- The other next state (for e_HDFANFA_Split)
+ *    Rule [I] -- The rule ID (for e_HDFANFA_Match)
+ *
+ * FUNCTION:
+ *    This function adds a state to the NFA.
+ *
+ * RETURNS:
+ *    The index of the new state.
+ *
+ * NOTES:
+ *    This throws if there are too many states.
+ *
+ * SEE ALSO:
+ *    GenNFA()
+ ******************************************************************************/
+int HighlightDFA::NewNFAState(e_HDFANFAType Type,int Set,int Out,int Out1,
+        int Rule)
+{
+    struct HDFANFAState NewState;
+
+    if(NFA.size()>=HIGHLIGHTDFA_MAX_NFA_STATES)
+        throw(0);
+
+    NewState.Type=Type;
+    NewState.Set=Set;
+    NewState.Out=Out;
+    NewState.Out1=Out1;
+    NewState.Rule=Rule;
+    NFA.push_back(NewState);
+
+    return NFA.size()-1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::GenNFA
+ *
+ * SYNOPSIS:
+ *    int HighlightDFA::GenNFA(int Node,int Next);
+ *
+ * PARAMETERS:
+ *    Node [I] -- The parse tree node to make the NFA for
+ *    Next [I] -- The NFA state to go to after 'Node' matches
+ *
+ * FUNCTION:
+ *    This function makes the NFA states for a node in the parse tree.  We
+ *    work backwards (we already know where we go after this node) so there
+ *    is no patching of dangling outs needed.  Because the NFA states are
+ *    made fresh every call, repeats like {2,5} just call this on the same
+ *    node more than once.
+ *
+ * RETURNS:
+ *    The NFA state to start matching 'Node' at.
+ *
+ * SEE ALSO:
+ *    Compile()
+ ******************************************************************************/
+int HighlightDFA::GenNFA(int Node,int Next)
+{
+    int Left;
+    int Right;
+    int Min;
+    int Max;
+    int Tail;
+    int Loop;
+    int r;
+
+    Left=Nodes[Node].Left;
+    Right=Nodes[Node].Right;
+    switch(Nodes[Node].Type)
+    {
+        case e_HDFANode_Set:
+            return NewNFAState(e_HDFANFA_Set,Node,Next,-1,-1);
+        case e_HDFANode_Concat:
+            return GenNFA(Left,GenNFA(Right,Next));
+        case e_HDFANode_Alt:
+            Left=GenNFA(Left,Next);
+            Right=GenNFA(Right,Next);
+            return NewNFAState(e_HDFANFA_Split,-1,Left,Right,-1);
+        case e_HDFANode_Repeat:
+            Min=Nodes[Node].Min;
+            Max=Nodes[Node].Max;
+            Tail=Next;
+            if(Max<0)
+            {
+                Loop=NewNFAState(e_HDFANFA_Split,-1,-1,Next,-1);
+                NFA[Loop].Out=GenNFA(Left,Loop);
+                Tail=Loop;
+            }
+            else
+            {
+                /* Each optional copy can skip to the end */
+                for(r=Min;r<Max;r++)
+                {
+                    Tail=NewNFAState(e_HDFANFA_Split,-1,GenNFA(Left,Tail),
+                            Next,-1);
+                }
+            }
+            for(r=0;r<Min;r++)
+                Tail=GenNFA(Left,Tail);
+            return Tail;
+        case e_HDFANode_Empty:
+        case e_HDFANodeMAX:
+        default:
+        break;
+    }
+    return Next;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::BuildByteClasses
+ *
+ * SYNOPSIS:
+ *    void HighlightDFA::BuildByteClasses(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function splits the 256 bytes into classes where every byte in
+ *    a class is matched by exactly the same NFA states.  We start with
+ *    every byte in 1 class, and then split the classes by each set used
+ *    in the NFA.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Compile()
+ ******************************************************************************/
+void HighlightDFA::BuildByteClasses(void)
+{
+    vector<int> Remap;
+    uint8_t NewClassOf[256];
+    unsigned int s;
+    int NewCount;
+    int Key;
+    int b;
+    const uint32_t *Bits;
+
+    memset(ClassOf,0x00,sizeof(ClassOf));
+    NumClasses=1;
+
+    for(s=0;s<NFA.size();s++)
+    {
+        if(NFA[s].Type!=e_HDFANFA_Set)
+            continue;
+
+        Bits=Nodes[NFA[s].Set].Bits;
+        Remap.assign(NumClasses*2,-1);
+        NewCount=0;
+        for(b=0;b<256;b++)
+        {
+            Key=ClassOf[b]*2+HDFA_BIT_IS_SET(Bits,b);
+            if(Remap[Key]<0)
+                Remap[Key]=NewCount++;
+            NewClassOf[b]=Remap[Key];
+        }
+
+        memcpy(ClassOf,NewClassOf,sizeof(ClassOf));
+        NumClasses=NewCount;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HighlightDFA::Closure
+ *
+ * SYNOPSIS:
+ *    void HighlightDFA::Closure(std::vector<int> &States,
+ *              std::vector<int> &Marks,int &Stamp,std::vector<int> &Stack);
+ *
+ * PARAMETERS:
+ *    States [I/O] -- The NFA states to start from.  This is replaced with
+ *                    all the states we can get to without matching a byte.
+ *    Marks [I/O] -- Work space, one entry per NFA state
+ *    Stamp [I/O] -- The value in 'Marks' that means we have seen a state.
+ *                   This is bumped each call so 'Marks' never has to be
+ *                   cleared.
+ *    Stack [I/O] -- Work space
+ *
+ * FUNCTION:
+ *    This function follows the split states from 'States'.  Only the set
+ *    and match states are kept (that's all the DFA needs) and they are
+ *    sorted so the same set of states always looks the same.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Compile()
+ ******************************************************************************/
+void HighlightDFA::Closure(std::vector<int> &States,std::vector<int> &Marks,
+        int &Stamp,std::vector<int> &Stack)
+{
+    int s;
+
+    Stamp++;
+    Stack=States;
+    States.clear();
+    while(!Stack.empty())
+    {
+        s=Stack.back();
+        Stack.pop_back();
+
+        if(s<0 || Marks[s]==Stamp)
+            continue;
+        Marks[s]=Stamp;
+
+        if(NFA[s].Type==e_HDFANFA_Split)
+        {
+            Stack.push_back(NFA[s].Out1);
+            Stack.push_back(NFA[s].Out);
+        }
+        else
+        {
+            States.push_back(s);
+        }
+    }
+
+    sort(States.begin(),States.end());
+}
+
+/*******************************************************************************
+ * NAME:
+ *    HDFA_InvertASCII
+ *
+ * SYNOPSIS:
+ *    static void HDFA_InvertASCII(uint32_t *Bits);
+ *
+ * PARAMETERS:
+ *    Bits [I/O] -- The set to invert
+ *
+ * FUNCTION:
+ *    This function inverts the ASCII part of a set and clears the rest.
+ *    The non ASCII chars are added back as whole UTF-8 chars with
+ *    NewMultiByteCharNode().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void HDFA_InvertASCII(uint32_t *Bits)
+{
+    int r;
+
+    for(r=0;r<4;r++)
+        Bits[r]=~Bits[r];
+    for(r=4;r<8;r++)
+        Bits[r]=0;
+}
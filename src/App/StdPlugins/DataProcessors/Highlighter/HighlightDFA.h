@@ -0,0 +1,170 @@
+/*******************************************************************************
+ * FILENAME: HighlightDFA.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the def's for the highlighter DFA in it.  This takes a
+ *    set of rules (keyword lists and regex's) and compiles all of them into
+ *    one DFA so matching a byte costs 1 table look up no matter how many
+ *    rules there are.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __HIGHLIGHTDFA_H_
+#define __HIGHLIGHTDFA_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/***  DEFINES                          ***/
+#define HIGHLIGHTDFA_DEAD_STATE         0       // No rule can match from here
+#define HIGHLIGHTDFA_START_STATE        1
+#define HIGHLIGHTDFA_NO_RULE            -1
+#define HIGHLIGHTDFA_MAX_STATES         4096    // Must fit in the uint16_t 'Trans' table
+#define HIGHLIGHTDFA_MAX_NFA_STATES     100000
+#define HIGHLIGHTDFA_MAX_REPEAT         255
+
+/***  MACROS                           ***/
+
+/***  TYPE DEFINITIONS                 ***/
+typedef enum
+{
+    e_HDFANode_Set,                     // Match 1 byte from 'Bits'
+    e_HDFANode_Concat,                  // 'Left' then 'Right'
+    e_HDFANode_Alt,                     // 'Left' or 'Right'
+    e_HDFANode_Repeat,                  // 'Left' from 'Min' to 'Max' times (-1=no limit)
+    e_HDFANode_Empty,                   // Matches nothing
+    e_HDFANodeMAX
+} e_HDFANodeType;
+
+struct HDFANode
+{
+    e_HDFANodeType Type;
+    uint32_t Bits[8];
+    int Left;
+    int Right;
+    int Min;
+    int Max;
+};
+
+typedef enum
+{
+    e_HDFANFA_Set,
+    e_HDFANFA_Split,
+    e_HDFANFA_Match,
+    e_HDFANFAMAX
+} e_HDFANFAType;
+
+struct HDFANFAState
+{
+    e_HDFANFAType Type;
+    int Set;                            // Index into 'Nodes' for the bits
+    int Out;
+    int Out1;
+    int Rule;
+};
+
+struct HDFARule
+{
+    int Root;                           // Index into 'Nodes'
+    int RuleID;
+};
+
+/***  CLASS DEFINITIONS                ***/
+class HighlightDFA
+{
+    public:
+        HighlightDFA();
+        ~HighlightDFA();
+        void Clear(void);
+        bool AddRegex(const char *Pattern,bool IgnoreCase,int RuleID,
+                std::string &ErrorMsg,unsigned int &ErrorOffset);
+        bool AddKeywords(const char *Words,bool IgnoreCase,int RuleID,
+                std::string &ErrorMsg);
+        bool Compile(std::string &ErrorMsg);
+        bool IsEmpty(void);
+        int GetStateCount(void);
+
+        /* These are called for every byte so they are inline */
+        inline int Step(int State,uint8_t Byte)
+        {
+            return Trans[State*NumClasses+ClassOf[Byte]];
+        }
+        inline int GetAccept(int State)
+        {
+            return Accept[State];
+        }
+        inline bool IsFinal(int State)
+        {
+            return Final[State];
+        }
+
+    private:
+        std::vector<struct HDFANode> Nodes;
+        std::vector<struct HDFARule> Rules;
+
+        /* Parser */
+        const char *ParseStart;
+        const char *ParsePos;
+        bool ParseIgnoreCase;
+        std::string ParseError;
+
+        /* NFA (only used while compiling) */
+        std::vector<struct HDFANFAState> NFA;
+
+        /* The compiled DFA */
+        uint8_t ClassOf[256];
+        int NumClasses;
+        std::vector<uint16_t> Trans;
+        std::vector<int> Accept;
+        std::vector<uint8_t> Final;
+
+        int NewNode(e_HDFANodeType Type,int Left,int Right);
+        int NewSetNode(const uint32_t *Bits);
+        int NewByteNode(uint8_t Byte);
+        int NewRangeNode(uint8_t Low,uint8_t High);
+        int NewMultiByteCharNode(void);
+        void AddCase2Bits(uint32_t *Bits);
+        int ParseAlt(int Depth);
+        int ParseConcat(int Depth);
+        int ParseRepeat(int Depth);
+        int ParseAtom(int Depth);
+        int ParseClass(void);
+        int ParseUTF8Literal(void);
+        bool ParseEscape(uint32_t *Bits,bool &Negated);
+        bool ParseRepeatCount(int &Min,int &Max);
+        int GenNFA(int Node,int Next);
+        int NewNFAState(e_HDFANFAType Type,int Set,int Out,int Out1,int Rule);
+        void BuildByteClasses(void);
+        void Closure(std::vector<int> &States,std::vector<int> &Marks,
+                int &Stamp,std::vector<int> &Stack);
+};
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+
+#endif   /* end of "#ifndef __HIGHLIGHTDFA_H_" */
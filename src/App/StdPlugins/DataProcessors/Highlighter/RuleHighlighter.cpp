@@ -0,0 +1,1685 @@
+/*******************************************************************************
+ * FILENAME: RuleHighlighter.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This is a highlighter that takes all the rules the user has (keyword
+ *    lists, regex's, and the presets like URLs) and compiles them into one
+ *    DFA (see HighlightDFA.cpp).  Every char costs 1 table look up per byte
+ *    no matter how many rules there are.
+ *
+ *    The text is never changed.  Chars are passed though to the screen and
+ *    we only remember where matches are (as char offsets from a mark at
+ *    the start of the text run).  The matches are styled with
+ *    ApplyStyleSpans2Mark() when the block of bytes is done (or when the
+ *    run of text ends because of a control char / cursor move).
+ *
+ *    Runs of plain AscII text also come in though
+ *    RuleHighlighter_ProcessTextRun() so having this processor on doesn't
+ *    turn off the DPS text run fast path.
+ *
+ *    Matches are the longest match starting at the left most char (like
+ *    lex).  When more than 1 rule matches the same text the first rule
+ *    wins (the user rules come before the presets).
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "RuleHighlighter.h"
+#include "HighlightDFA.h"
+#include "PluginSDK/Plugin.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define REGISTER_PLUGIN_FUNCTION_PRIV_NAME      RuleHighlighter // The name to append on the RegisterPlugin() function for built in version
+#define NEEDED_MIN_API_VERSION                  0x02030000
+
+#define RULEHIGHLIGHTER_MAX_CUSTOM_RULES        8
+#define RULEHIGHLIGHTER_NUMBER_OF_PRESETS       3       // The number of entries in 'm_Presets'
+#define RULEHIGHLIGHTER_MAX_RULES               (RULEHIGHLIGHTER_MAX_CUSTOM_RULES+RULEHIGHLIGHTER_NUMBER_OF_PRESETS)
+#define RULEHIGHLIGHTER_MAX_PENDING_CHARS       256     // The longest match we will wait for
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+typedef enum
+{
+    e_RuleHighlighterType_Keywords,
+    e_RuleHighlighterType_Regex,
+    e_RuleHighlighterTypeMAX
+} e_RuleHighlighterTypeType;
+
+struct RuleHighlighterPreset
+{
+    const char *Name;
+    const char *Regex;
+    struct StyleData DefaultStyle;
+};
+
+struct RuleHighlighterData
+{
+    class HighlightDFA DFA;
+    bool HaveRules;
+    struct StyleData Styles[RULEHIGHLIGHTER_MAX_RULES];
+
+    /* The run of text we are matching in */
+    t_DataProMark *Mark;
+    bool InRun;
+    int32_t LastCursorX;
+    int32_t LastCursorY;
+
+    /* The match we are working on */
+    uint32_t BufStart;                  // Chars from 'Mark' to the first char in 'Buf'
+    vector<uint8_t> Buf;                // The chars that might still be part of a match
+    vector<uint32_t> CharEnds;          // The byte offset of the end of each char in 'Buf'
+    unsigned int Scanned;               // The number of chars in 'Buf' the DFA has seen
+    int State;
+    unsigned int AcceptChars;           // The chars in the longest match so far (0=none)
+    int AcceptRule;
+
+    /* Matches we have found but not applied yet */
+    vector<struct DPS_StyleSpan> Spans;
+};
+
+struct RuleHighlighter_RuleWidgets
+{
+    struct PI_GroupBox *GroupBox;
+    struct PI_TextInput *Pattern;
+    struct PI_ComboBox *Type;
+    struct PI_Checkbox *IgnoreCase;
+    struct PI_StylePick *Style;
+};
+
+struct RuleHighlighter_PresetWidgets
+{
+    struct PI_Checkbox *Enabled;
+    struct PI_StylePick *Style;
+};
+
+struct RuleHighlighter_SettingsWidgets
+{
+    t_WidgetSysHandle *PresetsTab;
+    t_WidgetSysHandle *RulesTab;
+
+    struct RuleHighlighter_PresetWidgets Presets[RULEHIGHLIGHTER_NUMBER_OF_PRESETS];
+    struct RuleHighlighter_RuleWidgets Rules[RULEHIGHLIGHTER_MAX_CUSTOM_RULES];
+    struct PI_GroupBox *ErrorsGroupBox;
+    struct PI_TextBox *ErrorsTextBox;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+t_DataProcessorHandleType *RuleHighlighter_AllocateData(void);
+void RuleHighlighter_FreeData(t_DataProcessorHandleType *DataHandle);
+const struct DataProcessorInfo *RuleHighlighter_GetProcessorInfo(unsigned int *SizeOfInfo);
+void RuleHighlighter_ProcessByte(t_DataProcessorHandleType *DataHandle,
+        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
+        PG_BOOL *Consumed);
+void RuleHighlighter_ProcessBlockDone(t_DataProcessorHandleType *DataHandle);
+int RuleHighlighter_ScanTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes);
+void RuleHighlighter_ProcessTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes);
+static t_DataProSettingsWidgetsType *RuleHighlighter_AllocSettingsWidgets(t_WidgetSysHandle *WidgetHandle,t_PIKVList *Settings);
+static void RuleHighlighter_FreeSettingsWidgets(t_DataProSettingsWidgetsType *PrivData);
+static void RuleHighlighter_SetSettingsFromWidgets(t_DataProSettingsWidgetsType *PrivData,t_PIKVList *Settings);
+static void RuleHighlighter_ApplySettings(t_DataProcessorHandleType *DataHandle,t_PIKVList *Settings);
+static void RuleHighlighter_RuleChanged_EventCB(const struct PICBEvent *Event,void *UserData);
+static void RuleHighlighter_CheckRulesForErrors(struct RuleHighlighter_SettingsWidgets *WData);
+static bool RuleHighlighter_AddRule(class HighlightDFA *DFA,
+        e_RuleHighlighterTypeType Type,const char *Pattern,bool IgnoreCase,
+        int RuleID,string &ErrorMsg);
+static void RuleHighlighter_GetStyleSetting(t_PIKVList *Settings,
+        const char *Key,const struct StyleData *Default,struct StyleData *SD);
+static void RuleHighlighter_FixDefaultStyles(void);
+static void RuleHighlighter_ResetMatch(struct RuleHighlighterData *Data);
+static void RuleHighlighter_AddChar(struct RuleHighlighterData *Data,
+        const uint8_t *Chr,int Len);
+static void RuleHighlighter_Scan(struct RuleHighlighterData *Data,bool AtEnd);
+static void RuleHighlighter_DropChars(struct RuleHighlighterData *Data,
+        unsigned int Count);
+static void RuleHighlighter_AddSpan(struct RuleHighlighterData *Data,
+        uint32_t Offset,uint32_t Len,int Rule);
+static void RuleHighlighter_StartRun(struct RuleHighlighterData *Data,
+        int32_t CursorX,int32_t CursorY);
+static void RuleHighlighter_EndRun(struct RuleHighlighterData *Data);
+static void RuleHighlighter_ApplySpans(struct RuleHighlighterData *Data);
+
+/*** VARIABLE DEFINITIONS     ***/
+static const struct PI_UIAPI *m_RuleHighlighter_UIAPI;
+static const struct PI_SystemAPI *m_RuleHighlighter_SysAPI;
+static const struct DPS_API *m_DPS;
+static bool m_DefaultStylesFixed;
+
+struct DataProcessorAPI m_RuleHighlighterCBs=
+{
+    RuleHighlighter_AllocateData,
+    RuleHighlighter_FreeData,
+    RuleHighlighter_GetProcessorInfo,
+    NULL,       // ProcessKeyPress
+    RuleHighlighter_ProcessByte,
+    NULL,       // ProcessIncomingBinaryByte
+    /* V2 */
+    NULL,       // ProcessOutGoingData
+    /* V3 */
+    RuleHighlighter_AllocSettingsWidgets,
+    RuleHighlighter_FreeSettingsWidgets,
+    RuleHighlighter_SetSettingsFromWidgets,
+    RuleHighlighter_ApplySettings,
+    /* V4 */
+    RuleHighlighter_ProcessBlockDone,
+    /* V5 */
+    RuleHighlighter_ScanTextRun,
+    RuleHighlighter_ProcessTextRun,
+};
+
+struct DataProcessorInfo m_RuleHighlighter_Info=
+{
+    "Rule Highlighter",
+    "Highlights keywords, regex's, URLs, and IP addresses",
+    "Highlights the text that matches any of your rules.\n"
+        "All the rules are compiled together so having lots of rules "
+        "doesn't slow down the incoming data.\n"
+        "\n"
+        "Keyword rules are a list of words split by spaces.\n"
+        "Regex rules support . [] [^] \\d \\w \\s \\D \\W \\S \\xHH () | "
+        "* + ? {n} {n,} {n,m}\n",
+    e_DataProcessorType_Text,
+    e_TextDataProcessorClass_Highlighter,
+    e_BinaryDataProcessorModeMAX,
+};
+
+static struct RuleHighlighterPreset m_Presets[RULEHIGHLIGHTER_NUMBER_OF_PRESETS]=
+{
+    {
+        "URLs",
+        "(https?|ftp|file)://[-A-Za-z0-9+&@#/%?=~_|!:,.;]*"
+                "[-A-Za-z0-9+&@#/%=~_|]",
+        {-1U,-1U,TXT_ATTRIB_UNDERLINE,0,{0}},
+    },
+    {
+        "IPv4 addresses",
+        "[0-9]{1,3}\\.[0-9]{1,3}\\.[0-9]{1,3}\\.[0-9]{1,3}(:[0-9]{1,5})?",
+        {0x00AAAA,-1U,0,0,{0}},
+    },
+    {
+        "Hex numbers (0x...)",
+        "0[xX][0-9A-Fa-f]+",
+        {0xE5A50A,-1U,0,0,{0}},
+    },
+};
+
+static struct StyleData m_DefaultRuleStyle={0xFF0000,-1U,TXT_ATTRIB_BOLD,0,{0}};
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_RegisterPlugin
+ *
+ * SYNOPSIS:
+ *    unsigned int RuleHighlighter_RegisterPlugin(const struct PI_SystemAPI *SysAPI,
+ *          unsigned int Version);
+ *
+ * PARAMETERS:
+ *    SysAPI [I] -- The main API to WhippyTerm
+ *    Version [I] -- What version of WhippyTerm is running.  This is used
+ *                   to make sure we are compatible.  This is in the
+ *                   Major<<24 | Minor<<16 | Rev<<8 | Patch
+ *
+ * FUNCTION:
+ *    This function registers this plugin with the system.
+ *
+ * RETURNS:
+ *    0 if we support this version of WhippyTerm, and the minimum version
+ *    we need if we are not.
+ *
+ * NOTES:
+ *    This function is normally is called from the RegisterPlugin() when
+ *    it is being used as a normal plugin.  As a std plugin it is called
+ *    from RegisterStdPlugins() instead.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+/* This needs to be extern "C" because it is the main entry point for the
+   plugin system */
+extern "C"
+{
+    unsigned int REGISTER_PLUGIN_FUNCTION(const struct PI_SystemAPI *SysAPI,
+            unsigned int Version)
+    {
+        if(Version<NEEDED_MIN_API_VERSION)
+            return NEEDED_MIN_API_VERSION;
+
+        m_RuleHighlighter_SysAPI=SysAPI;
+        m_DPS=SysAPI->GetAPI_DataProcessors();
+        m_RuleHighlighter_UIAPI=m_DPS->GetAPI_UI();
+
+        /* If we are have the correct experimental API */
+        if(m_RuleHighlighter_SysAPI->GetExperimentalID()>0 &&
+                m_RuleHighlighter_SysAPI->GetExperimentalID()<1)
+        {
+            return 0xFFFFFFFF;
+        }
+
+        m_DPS->RegisterDataProcessor("RuleHighlighter",&m_RuleHighlighterCBs,
+                sizeof(m_RuleHighlighterCBs));
+
+        return 0;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_AllocateData
+ *
+ * SYNOPSIS:
+ *    t_DataProcessorHandleType *RuleHighlighter_AllocateData(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function allocates any needed data for this input filter.
+ *
+ * RETURNS:
+ *    A pointer to the data, NULL if there was an error.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+t_DataProcessorHandleType *RuleHighlighter_AllocateData(void)
+{
+    struct RuleHighlighterData *Data;
+
+    Data=NULL;
+    try
+    {
+        Data=new struct RuleHighlighterData;
+
+        Data->HaveRules=false;
+        Data->Mark=NULL;
+        Data->InRun=false;
+        Data->LastCursorX=0;
+        Data->LastCursorY=0;
+        RuleHighlighter_ResetMatch(Data);
+    }
+    catch(...)
+    {
+        if(Data!=NULL)
+            delete Data;
+        Data=NULL;
+    }
+
+    return (t_DataProcessorHandleType *)Data;
+}
+
+/*******************************************************************************
+ *  NAME:
+ *    RuleHighlighter_FreeData
+ *
+ *  SYNOPSIS:
+ *    void RuleHighlighter_FreeData(t_DataProcessorHandleType *DataHandle);
+ *
+ *  PARAMETERS:
+ *    DataHandle [I] -- The data handle to free.  This will need to be
+ *                      case to your internal data type before you use it.
+ *
+ *  FUNCTION:
+ *    This function frees the memory allocated with AllocateData().
+ *
+ *  RETURNS:
+ *    NONE
+ *
+ *  NOTES:
+ *    We don't free 'Mark', the display frees it's marks when it is freed.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+void RuleHighlighter_FreeData(t_DataProcessorHandleType *DataHandle)
+{
+    struct RuleHighlighterData *Data=(struct RuleHighlighterData *)DataHandle;
+
+    delete Data;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_GetProcessorInfo
+ *
+ * SYNOPSIS:
+ *    const struct DataProcessorInfo *RuleHighlighter_GetProcessorInfo(
+ *              unsigned int *SizeOfInfo);
+ *
+ * PARAMETERS:
+ *    SizeOfInfo [O] -- The size of 'struct DataProcessorInfo'.  This is used
+ *                        for forward / backward compatibility.
+ *
+ * FUNCTION:
+ *    This function gets info about the plugin.
+ *
+ * RETURNS:
+ *    The info for this plugin.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+const struct DataProcessorInfo *RuleHighlighter_GetProcessorInfo(
+        unsigned int *SizeOfInfo)
+{
+    *SizeOfInfo=sizeof(struct DataProcessorInfo);
+    return &m_RuleHighlighter_Info;
+}
+
+/*******************************************************************************
+ *  NAME:
+ *    RuleHighlighter_ProcessByte
+ *
+ *  SYNOPSIS:
+ *    void RuleHighlighter_ProcessByte(t_DataProcessorHandleType *DataHandle,
+ *              const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
+ *              PG_BOOL *Consumed);
+ *
+ *  PARAMETERS:
+ *    DataHandle [I] -- The data handle to your internal data.
+ *    RawByte [I] -- The raw byte to process.  This is the byte that came in.
+ *    ProcessedChar [I/O] -- This is a unicode char that has already been
+ *                         processed by some of the other input filters.  You
+ *                         can change this as you need.  It must remain only
+ *                         one unicode char.
+ *    CharLen [I/O] -- This number of bytes in 'ProcessedChar'
+ *    Consumed [I/O] -- This tells the system (and other filters) if the
+ *                      char has been used up and will not be added to the
+ *                      screen.
+ *
+ *  FUNCTION:
+ *    This function is called for each byte that comes in.  Chars that will
+ *    be added to the screen are fed into the DFA.  Anything that stops the
+ *    chars from being one after the other on the screen (C0 control chars
+ *    even if nothing consumed them, escape sequences, the cursor moving or
+ *    wrapping) ends the run of text we are matching in, so a match never
+ *    spans one.
+ *
+ *  RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_ProcessBlockDone()
+ ******************************************************************************/
+void RuleHighlighter_ProcessByte(t_DataProcessorHandleType *DataHandle,
+        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
+        PG_BOOL *Consumed)
+{
+    struct RuleHighlighterData *Data=(struct RuleHighlighterData *)DataHandle;
+    int32_t CursorX;
+    int32_t CursorY;
+
+    if(!Data->HaveRules)
+        return;
+
+    if(*Consumed)
+    {
+        /* Partial UTF-8 chars are consumed, anything else breaks the run */
+        if(RawByte<0x80)
+            RuleHighlighter_EndRun(Data);
+        return;
+    }
+
+    if(*CharLen==1 && (ProcessedChar[0]<0x20 || ProcessedChar[0]==0x7F))
+    {
+        /* A control char that nothing used (no term emulator) */
+        RuleHighlighter_EndRun(Data);
+        return;
+    }
+
+    m_DPS->GetCursorXY(&CursorX,&CursorY);
+    RuleHighlighter_StartRun(Data,CursorX,CursorY);
+    if(!Data->InRun)
+        return;
+
+    RuleHighlighter_AddChar(Data,ProcessedChar,*CharLen);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_ScanTextRun
+ *
+ * SYNOPSIS:
+ *    int RuleHighlighter_ScanTextRun(t_DataProcessorHandleType *DataHandle,
+ *              const uint8_t *Run,int Bytes);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to your internal data.
+ *    Run [I] -- The bytes that have not been processed yet
+ *    Bytes [I] -- The number of bytes in 'Run'
+ *
+ * FUNCTION:
+ *    This function finds how many bytes at the start of 'Run' are printable
+ *    AscII that fit on the rest of the current line.  We never change the
+ *    text so these can all be passed though, but the run has to stop
+ *    before the line wraps because RuleHighlighter_ProcessTextRun() can't
+ *    see the cursor move to the next line.
+ *
+ * RETURNS:
+ *    The number of bytes that can be passed though.
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_ProcessTextRun()
+ ******************************************************************************/
+int RuleHighlighter_ScanTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes)
+{
+    struct RuleHighlighterData *Data=(struct RuleHighlighterData *)DataHandle;
+    int32_t CursorX;
+    int32_t CursorY;
+    int32_t Rows;
+    int32_t Columns;
+    int r;
+
+    if(!Data->HaveRules)
+        return Bytes;
+
+    m_DPS->GetCursorXY(&CursorX,&CursorY);
+    m_DPS->GetScreenSize(&Rows,&Columns);
+    if(CursorX<0 || CursorX>=Columns)
+        return 0;
+    if(Bytes>Columns-CursorX)
+        Bytes=Columns-CursorX;
+
+    for(r=0;r<Bytes;r++)
+        if(Run[r]<0x20 || Run[r]>=0x7F)
+            break;
+
+    return r;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_ProcessTextRun
+ *
+ * SYNOPSIS:
+ *    void RuleHighlighter_ProcessTextRun(t_DataProcessorHandleType *DataHandle,
+ *              const uint8_t *Run,int Bytes);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to your internal data.
+ *    Run [I] -- The bytes being passed though
+ *    Bytes [I] -- The number of bytes in 'Run'
+ *
+ * FUNCTION:
+ *    This function feeds a run of bytes that RuleHighlighter_ScanTextRun()
+ *    said could be passed though into the DFA.  This does the same as
+ *    RuleHighlighter_ProcessByte() would for each byte, but only gets the
+ *    cursor pos once (the run is all on one line).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_ScanTextRun(), RuleHighlighter_ProcessByte()
+ ******************************************************************************/
+void RuleHighlighter_ProcessTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes)
+{
+    struct RuleHighlighterData *Data=(struct RuleHighlighterData *)DataHandle;
+    int32_t CursorX;
+    int32_t CursorY;
+    int r;
+
+    if(!Data->HaveRules || Bytes<=0)
+        return;
+
+    m_DPS->GetCursorXY(&CursorX,&CursorY);
+    RuleHighlighter_StartRun(Data,CursorX,CursorY);
+    if(!Data->InRun)
+        return;
+
+    for(r=0;r<Bytes;r++)
+        RuleHighlighter_AddChar(Data,&Run[r],1);
+
+    Data->LastCursorX=CursorX+Bytes-1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_ProcessBlockDone
+ *
+ * SYNOPSIS:
+ *    void RuleHighlighter_ProcessBlockDone(t_DataProcessorHandleType *DataHandle);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to your internal data.
+ *
+ * FUNCTION:
+ *    This function is called after a block of bytes has been processed.  We
+ *    style all the matches we found in the block.  A match that might
+ *    still get longer is left until the next block.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_ProcessByte()
+ ******************************************************************************/
+void RuleHighlighter_ProcessBlockDone(t_DataProcessorHandleType *DataHandle)
+{
+    struct RuleHighlighterData *Data=(struct RuleHighlighterData *)DataHandle;
+
+    RuleHighlighter_ApplySpans(Data);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_ResetMatch
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_ResetMatch(struct RuleHighlighterData *Data);
+ *
+ * PARAMETERS:
+ *    Data [I/O] -- Our data
+ *
+ * FUNCTION:
+ *    This function throws away the match we are working on and starts
+ *    again at the mark.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void RuleHighlighter_ResetMatch(struct RuleHighlighterData *Data)
+{
+    Data->BufStart=0;
+    Data->Buf.clear();
+    Data->CharEnds.clear();
+    Data->Scanned=0;
+    Data->State=HIGHLIGHTDFA_START_STATE;
+    Data->AcceptChars=0;
+    Data->AcceptRule=HIGHLIGHTDFA_NO_RULE;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_AddChar
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_AddChar(struct RuleHighlighterData *Data,
+ *              const uint8_t *Chr,int Len);
+ *
+ * PARAMETERS:
+ *    Data [I/O] -- Our data
+ *    Chr [I] -- The char that is being added to the screen
+ *    Len [I] -- The number of bytes in 'Chr'
+ *
+ * FUNCTION:
+ *    This function adds the next char of the run to the matcher.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_Scan()
+ ******************************************************************************/
+static void RuleHighlighter_AddChar(struct RuleHighlighterData *Data,
+        const uint8_t *Chr,int Len)
+{
+    int State;
+    int r;
+
+    if(Data->CharEnds.empty())
+    {
+        /* Most chars can't start a match, skip them without buffering */
+        State=HIGHLIGHTDFA_START_STATE;
+        for(r=0;r<Len && State!=HIGHLIGHTDFA_DEAD_STATE;r++)
+            State=Data->DFA.Step(State,Chr[r]);
+
+        if(State==HIGHLIGHTDFA_DEAD_STATE)
+        {
+            Data->BufStart++;
+            return;
+        }
+    }
+
+    try
+    {
+        Data->Buf.insert(Data->Buf.end(),Chr,Chr+Len);
+        Data->CharEnds.push_back(Data->Buf.size());
+    }
+    catch(...)
+    {
+        RuleHighlighter_ResetMatch(Data);
+        return;
+    }
+
+    RuleHighlighter_Scan(Data,false);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_Scan
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_Scan(struct RuleHighlighterData *Data,
+ *              bool AtEnd);
+ *
+ * PARAMETERS:
+ *    Data [I/O] -- Our data
+ *    AtEnd [I] -- The run of text is over, no more chars are coming
+ *
+ * FUNCTION:
+ *    This function runs the chars in the buffer though the DFA.  When the
+ *    DFA dies (or we are at the end) the longest match we saw is added
+ *    as a span and we start again after it.  If there wasn't a match we
+ *    start again 1 char later.  Only the chars after the match are looked
+ *    at again.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_AddChar()
+ ******************************************************************************/
+static void RuleHighlighter_Scan(struct RuleHighlighterData *Data,bool AtEnd)
+{
+    uint32_t b;
+    uint32_t Start;
+    uint32_t End;
+    int Rule;
+
+    for(;;)
+    {
+        if(Data->Scanned<Data->CharEnds.size())
+        {
+            Start=Data->Scanned==0?0:Data->CharEnds[Data->Scanned-1];
+            End=Data->CharEnds[Data->Scanned];
+            for(b=Start;b<End && Data->State!=HIGHLIGHTDFA_DEAD_STATE;b++)
+                Data->State=Data->DFA.Step(Data->State,Data->Buf[b]);
+
+            if(Data->State!=HIGHLIGHTDFA_DEAD_STATE)
+            {
+                Data->Scanned++;
+                Rule=Data->DFA.GetAccept(Data->State);
+                if(Rule!=HIGHLIGHTDFA_NO_RULE)
+                {
+                    Data->AcceptChars=Data->Scanned;
+                    Data->AcceptRule=Rule;
+                }
+
+                /* Keep going unless nothing can make this match longer */
+                if(!Data->DFA.IsFinal(Data->State) &&
+                        Data->Scanned<RULEHIGHLIGHTER_MAX_PENDING_CHARS)
+                {
+                    continue;
+                }
+            }
+        }
+        else if(!AtEnd || Data->CharEnds.empty())
+        {
+            /* Wait for more chars */
+            break;
+        }
+
+        /* Take the longest match (or give up on the first char) */
+        if(Data->AcceptChars>0)
+        {
+            RuleHighlighter_AddSpan(Data,Data->BufStart,Data->AcceptChars,
+                    Data->AcceptRule);
+            RuleHighlighter_DropChars(Data,Data->AcceptChars);
+        }
+        else
+        {
+            RuleHighlighter_DropChars(Data,1);
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_DropChars
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_DropChars(struct RuleHighlighterData *Data,
+ *              unsigned int Count);
+ *
+ * PARAMETERS:
+ *    Data [I/O] -- Our data
+ *    Count [I] -- The number of chars to remove from the front of the buffer
+ *
+ * FUNCTION:
+ *    This function removes chars we are done with from the buffer and resets
+ *    the DFA so the rest of the buffer will be scanned again.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_Scan()
+ ******************************************************************************/
+static void RuleHighlighter_DropChars(struct RuleHighlighterData *Data,
+        unsigned int Count)
+{
+    uint32_t Bytes;
+    unsigned int r;
+
+    if(Count>=Data->CharEnds.size())
+    {
+        Data->BufStart+=Data->CharEnds.size();
+        Data->Buf.clear();
+        Data->CharEnds.clear();
+    }
+    else
+    {
+        Bytes=Data->CharEnds[Count-1];
+        Data->Buf.erase(Data->Buf.begin(),Data->Buf.begin()+Bytes);
+        Data->CharEnds.erase(Data->CharEnds.begin(),
+                Data->CharEnds.begin()+Count);
+        for(r=0;r<Data->CharEnds.size();r++)
+            Data->CharEnds[r]-=Bytes;
+        Data->BufStart+=Count;
+    }
+
+    Data->Scanned=0;
+    Data->State=HIGHLIGHTDFA_START_STATE;
+    Data->AcceptChars=0;
+    Data->AcceptRule=HIGHLIGHTDFA_NO_RULE;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_AddSpan
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_AddSpan(struct RuleHighlighterData *Data,
+ *              uint32_t Offset,uint32_t Len,int Rule);
+ *
+ * PARAMETERS:
+ *    Data [I/O] -- Our data
+ *    Offset [I] -- The chars from the mark the match starts at
+ *    Len [I] -- The number of chars in the match
+ *    Rule [I] -- The rule that matched
+ *
+ * FUNCTION:
+ *    This function adds a span to be styled when the block is done.  The
+ *    colors are only changed if the rule's style isn't the default color
+ *    so a rule that only underlines keeps what ever color the text had.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_ApplySpans()
+ ******************************************************************************/
+static void RuleHighlighter_AddSpan(struct RuleHighlighterData *Data,
+        uint32_t Offset,uint32_t Len,int Rule)
+{
+    struct DPS_StyleSpan NewSpan;
+    const struct StyleData *Style;
+
+    if(Rule<0 || (unsigned)Rule>=RULEHIGHLIGHTER_MAX_RULES)
+        return;
+    Style=&Data->Styles[Rule];
+
+    NewSpan.Offset=Offset;
+    NewSpan.Len=Len;
+    NewSpan.What=0;
+    NewSpan.Attribs=Style->Attribs;
+    NewSpan.FGColor=Style->FGColor;
+    NewSpan.BGColor=Style->BGColor;
+
+    if(Style->Attribs!=0)
+        NewSpan.What|=DPS_STYLESPAN_SET_ATTRIBS;
+    if(Style->FGColor!=m_DPS->GetSysDefaultColor(e_DefaultColors_FG))
+        NewSpan.What|=DPS_STYLESPAN_FGCOLOR;
+    if(Style->BGColor!=m_DPS->GetSysDefaultColor(e_DefaultColors_BG))
+        NewSpan.What|=DPS_STYLESPAN_BGCOLOR;
+
+    if(NewSpan.What==0)
+        return;
+
+    try
+    {
+        Data->Spans.push_back(NewSpan);
+    }
+    catch(...)
+    {
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_StartRun
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_StartRun(struct RuleHighlighterData *Data,
+ *              int32_t CursorX,int32_t CursorY);
+ *
+ * PARAMETERS:
+ *    Data [I/O] -- Our data
+ *    CursorX [I] -- Where the next char is going to be added
+ *    CursorY [I] -- Where the next char is going to be added
+ *
+ * FUNCTION:
+ *    This function is called before a char is added to the matcher.  If the
+ *    cursor isn't just after the last char we saw (it moved or we wrapped)
+ *    then the old run is ended.  If we aren't in a run a new one is started
+ *    at the cursor.
+ *
+ *    'Data->InRun' will be false if we couldn't start a run.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_EndRun()
+ ******************************************************************************/
+static void RuleHighlighter_StartRun(struct RuleHighlighterData *Data,
+        int32_t CursorX,int32_t CursorY)
+{
+    if(Data->InRun && (CursorY!=Data->LastCursorY ||
+            CursorX<=Data->LastCursorX))
+    {
+        /* The cursor moved (or we wrapped) */
+        RuleHighlighter_EndRun(Data);
+    }
+
+    if(!Data->InRun)
+    {
+        if(Data->Mark==NULL)
+        {
+            Data->Mark=m_DPS->AllocateMark();
+            if(Data->Mark==NULL)
+                return;
+        }
+        else
+        {
+            m_DPS->SetMark2CursorPos(Data->Mark);
+        }
+        Data->InRun=true;
+        RuleHighlighter_ResetMatch(Data);
+    }
+    Data->LastCursorX=CursorX;
+    Data->LastCursorY=CursorY;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_EndRun
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_EndRun(struct RuleHighlighterData *Data);
+ *
+ * PARAMETERS:
+ *    Data [I/O] -- Our data
+ *
+ * FUNCTION:
+ *    This function finishes off the run of text we are matching in.  Any
+ *    match that was waiting to see if it would get longer is finished and
+ *    all the spans are applied (the mark is about to be moved).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_ProcessByte()
+ ******************************************************************************/
+static void RuleHighlighter_EndRun(struct RuleHighlighterData *Data)
+{
+    if(!Data->InRun)
+        return;
+
+    RuleHighlighter_Scan(Data,true);
+    RuleHighlighter_ApplySpans(Data);
+    RuleHighlighter_ResetMatch(Data);
+    Data->InRun=false;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_ApplySpans
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_ApplySpans(struct RuleHighlighterData *Data);
+ *
+ * PARAMETERS:
+ *    Data [I/O] -- Our data
+ *
+ * FUNCTION:
+ *    This function styles all the matches we have found with one call to
+ *    ApplyStyleSpans2Mark().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    RuleHighlighter_AddSpan()
+ ******************************************************************************/
+static void RuleHighlighter_ApplySpans(struct RuleHighlighterData *Data)
+{
+    if(Data->Spans.empty())
+        return;
+
+    if(Data->Mark!=NULL && m_DPS->IsMarkValid(Data->Mark))
+    {
+        m_DPS->ApplyStyleSpans2Mark(Data->Mark,Data->Spans.data(),
+                Data->Spans.size());
+    }
+    Data->Spans.clear();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_AddRule
+ *
+ * SYNOPSIS:
+ *    static bool RuleHighlighter_AddRule(class HighlightDFA *DFA,
+ *              e_RuleHighlighterTypeType Type,const char *Pattern,
+ *              bool IgnoreCase,int RuleID,string &ErrorMsg);
+ *
+ * PARAMETERS:
+ *    DFA [I/O] -- The DFA to add the rule to
+ *    Type [I] -- What type of rule this is
+ *    Pattern [I] -- The keywords / regex
+ *    IgnoreCase [I] -- Match ASCII letters in any case
+ *    RuleID [I] -- The rule number
+ *    ErrorMsg [O] -- What went wrong (with a ^ under where in 'Pattern')
+ *
+ * FUNCTION:
+ *    This function adds a user rule to a DFA.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error in the rule
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool RuleHighlighter_AddRule(class HighlightDFA *DFA,
+        e_RuleHighlighterTypeType Type,const char *Pattern,bool IgnoreCase,
+        int RuleID,string &ErrorMsg)
+{
+    unsigned int ErrorOffset;
+    string Msg;
+
+    if(Type==e_RuleHighlighterType_Keywords)
+        return DFA->AddKeywords(Pattern,IgnoreCase,RuleID,ErrorMsg);
+
+    if(DFA->AddRegex(Pattern,IgnoreCase,RuleID,Msg,ErrorOffset))
+        return true;
+
+    ErrorMsg="   ";
+    ErrorMsg+=Msg;
+    ErrorMsg+=" at offset ";
+    ErrorMsg+=to_string(ErrorOffset);
+    ErrorMsg+=".\n   ";
+    ErrorMsg+=Pattern;
+    ErrorMsg+="\n   ";
+    ErrorMsg.append(ErrorOffset,' ');
+    ErrorMsg+="^";
+
+    return false;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_GetStyleSetting
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_GetStyleSetting(t_PIKVList *Settings,
+ *              const char *Key,const struct StyleData *Default,
+ *              struct StyleData *SD);
+ *
+ * PARAMETERS:
+ *    Settings [I] -- The settings to read from
+ *    Key [I] -- The key the style is stored under
+ *    Default [I] -- The style to use if it isn't in the settings
+ *    SD [O] -- The style
+ *
+ * FUNCTION:
+ *    This function reads a style from the settings.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void RuleHighlighter_GetStyleSetting(t_PIKVList *Settings,
+        const char *Key,const struct StyleData *Default,struct StyleData *SD)
+{
+    const char *Str;
+
+    Str=m_RuleHighlighter_SysAPI->KVGetItem(Settings,Key);
+    if(Str!=NULL)
+    {
+        memset(SD,0x00,sizeof(struct StyleData));
+        m_RuleHighlighter_UIAPI->Str2StyleHelper(SD,Str);
+    }
+    else
+    {
+        *SD=*Default;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_FixDefaultStyles
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_FixDefaultStyles(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function changes the -1 colors in the default styles to the
+ *    system default colors.  We can't do this until the system is up.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void RuleHighlighter_FixDefaultStyles(void)
+{
+    struct StyleData *SD;
+    unsigned int r;
+
+    if(m_DefaultStylesFixed)
+        return;
+
+    for(r=0;r<=RULEHIGHLIGHTER_NUMBER_OF_PRESETS;r++)
+    {
+        if(r<RULEHIGHLIGHTER_NUMBER_OF_PRESETS)
+            SD=&m_Presets[r].DefaultStyle;
+        else
+            SD=&m_DefaultRuleStyle;
+
+        if(SD->FGColor==-1U)
+            SD->FGColor=m_DPS->GetSysDefaultColor(e_DefaultColors_FG);
+        if(SD->BGColor==-1U)
+            SD->BGColor=m_DPS->GetSysDefaultColor(e_DefaultColors_BG);
+        SD->ULineColor=SD->FGColor;
+    }
+    m_DefaultStylesFixed=true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    AllocSettingsWidgets
+ *
+ * SYNOPSIS:
+ *    t_DataProSettingsWidgetsType *AllocSettingsWidgets(
+ *              t_WidgetSysHandle *WidgetHandle,t_PIKVList *Settings);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to add new widgets to
+ *    Settings [I] -- The current settings.  This is a standard key/value
+ *                    list.
+ *
+ * FUNCTION:
+ *    This function is called when the user presses the "Settings" button
+ *    to change any settings for this plugin (in the settings dialog).
+ *
+ *    The first tab has the presets, and a "Rules" tab has the user rules.
+ *
+ * RETURNS:
+ *    The private settings data that you want to use, or NULL if there was
+ *    an error.
+ *
+ * SEE ALSO:
+ *    FreeSettingsWidgets(), SetCurrentSettingsTabName(), AddNewSettingsTab()
+ ******************************************************************************/
+t_DataProSettingsWidgetsType *RuleHighlighter_AllocSettingsWidgets(t_WidgetSysHandle *WidgetHandle,t_PIKVList *Settings)
+{
+    struct RuleHighlighter_SettingsWidgets *WData;
+    struct RuleHighlighter_RuleWidgets *Rule;
+    const char *Str;
+    unsigned int r;
+    char buff[100];
+    struct StyleData TmpStyleData;
+
+    WData=NULL;
+    try
+    {
+        RuleHighlighter_FixDefaultStyles();
+
+        WData=new struct RuleHighlighter_SettingsWidgets;
+
+        /* Zero everything */
+        WData->PresetsTab=NULL;
+        WData->RulesTab=NULL;
+        for(r=0;r<RULEHIGHLIGHTER_NUMBER_OF_PRESETS;r++)
+        {
+            WData->Presets[r].Enabled=NULL;
+            WData->Presets[r].Style=NULL;
+        }
+        for(r=0;r<RULEHIGHLIGHTER_MAX_CUSTOM_RULES;r++)
+        {
+            WData->Rules[r].GroupBox=NULL;
+            WData->Rules[r].Pattern=NULL;
+            WData->Rules[r].Type=NULL;
+            WData->Rules[r].IgnoreCase=NULL;
+            WData->Rules[r].Style=NULL;
+        }
+        WData->ErrorsGroupBox=NULL;
+        WData->ErrorsTextBox=NULL;
+
+        /* Presets tab */
+        WData->PresetsTab=WidgetHandle;
+        m_DPS->SetCurrentSettingsTabName("Presets");
+
+        for(r=0;r<RULEHIGHLIGHTER_NUMBER_OF_PRESETS;r++)
+        {
+            WData->Presets[r].Enabled=m_RuleHighlighter_UIAPI->AddCheckbox(
+                    WData->PresetsTab,m_Presets[r].Name,NULL,NULL);
+            if(WData->Presets[r].Enabled==NULL)
+                throw(0);
+            sprintf(buff,"Preset_%d",r);
+            Str=m_RuleHighlighter_SysAPI->KVGetItem(Settings,buff);
+            if(Str==NULL)
+                Str="1";
+            m_RuleHighlighter_UIAPI->SetCheckboxChecked(WData->PresetsTab,
+                    WData->Presets[r].Enabled->Ctrl,atoi(Str));
+
+            sprintf(buff,"PresetStyle_%d",r);
+            RuleHighlighter_GetStyleSetting(Settings,buff,
+                    &m_Presets[r].DefaultStyle,&TmpStyleData);
+            WData->Presets[r].Style=m_RuleHighlighter_UIAPI->AddStylePick(
+                    WData->PresetsTab,"Style",&TmpStyleData,NULL,NULL);
+            if(WData->Presets[r].Style==NULL)
+                throw(0);
+        }
+
+        /* Rules tab */
+        WData->RulesTab=m_DPS->AddNewSettingsTab("Rules");
+        if(WData->RulesTab==NULL)
+            throw(0);
+
+        for(r=0;r<RULEHIGHLIGHTER_MAX_CUSTOM_RULES;r++)
+        {
+            Rule=&WData->Rules[r];
+
+            sprintf(buff,"Rule %d",r+1);
+            Rule->GroupBox=m_RuleHighlighter_UIAPI->AddGroupBox(WData->RulesTab,
+                    buff);
+            if(Rule->GroupBox==NULL)
+                throw(0);
+
+            Rule->Type=m_RuleHighlighter_UIAPI->AddComboBox(Rule->GroupBox->
+                    GroupWidgetHandle,false,"Type",
+                    RuleHighlighter_RuleChanged_EventCB,(void *)WData);
+            if(Rule->Type==NULL)
+                throw(0);
+            m_RuleHighlighter_UIAPI->AddItem2ComboBox(Rule->GroupBox->
+                    GroupWidgetHandle,Rule->Type->Ctrl,"Keywords",
+                    e_RuleHighlighterType_Keywords);
+            m_RuleHighlighter_UIAPI->AddItem2ComboBox(Rule->GroupBox->
+                    GroupWidgetHandle,Rule->Type->Ctrl,"Regex",
+                    e_RuleHighlighterType_Regex);
+            sprintf(buff,"RuleType_%d",r);
+            Str=m_RuleHighlighter_SysAPI->KVGetItem(Settings,buff);
+            if(Str==NULL)
+                Str="0";
+            m_RuleHighlighter_UIAPI->SetComboBoxSelectedEntry(Rule->GroupBox->
+                    GroupWidgetHandle,Rule->Type->Ctrl,atoi(Str));
+
+            Rule->Pattern=m_RuleHighlighter_UIAPI->AddTextInput(Rule->
+                    GroupBox->GroupWidgetHandle,"Pattern",
+                    RuleHighlighter_RuleChanged_EventCB,(void *)WData);
+            if(Rule->Pattern==NULL)
+                throw(0);
+            sprintf(buff,"RulePattern_%d",r);
+            Str=m_RuleHighlighter_SysAPI->KVGetItem(Settings,buff);
+            if(Str==NULL)
+                Str="";
+            m_RuleHighlighter_UIAPI->SetTextInputText(Rule->GroupBox->
+                    GroupWidgetHandle,Rule->Pattern->Ctrl,Str);
+
+            Rule->IgnoreCase=m_RuleHighlighter_UIAPI->AddCheckbox(Rule->
+                    GroupBox->GroupWidgetHandle,"Ignore case",NULL,NULL);
+            if(Rule->IgnoreCase==NULL)
+                throw(0);
+            sprintf(buff,"RuleIgnoreCase_%d",r);
+            Str=m_RuleHighlighter_SysAPI->KVGetItem(Settings,buff);
+            if(Str==NULL)
+                Str="0";
+            m_RuleHighlighter_UIAPI->SetCheckboxChecked(Rule->GroupBox->
+                    GroupWidgetHandle,Rule->IgnoreCase->Ctrl,atoi(Str));
+
+            sprintf(buff,"RuleStyle_%d",r);
+            RuleHighlighter_GetStyleSetting(Settings,buff,&m_DefaultRuleStyle,
+                    &TmpStyleData);
+            Rule->Style=m_RuleHighlighter_UIAPI->AddStylePick(Rule->GroupBox->
+                    GroupWidgetHandle,"Style",&TmpStyleData,NULL,NULL);
+            if(Rule->Style==NULL)
+                throw(0);
+        }
+
+        /* Errors */
+        WData->ErrorsGroupBox=m_RuleHighlighter_UIAPI->AddGroupBox(WData->
+                RulesTab,"Errors");
+        if(WData->ErrorsGroupBox==NULL)
+            throw(0);
+
+        WData->ErrorsTextBox=m_RuleHighlighter_UIAPI->AddTextBox(WData->
+                ErrorsGroupBox->GroupWidgetHandle,"","");
+        if(WData->ErrorsTextBox==NULL)
+            throw(0);
+
+        m_RuleHighlighter_UIAPI->ChangeTextBoxProp(WData->ErrorsGroupBox->
+                GroupWidgetHandle,WData->ErrorsTextBox->Ctrl,
+                e_TextBoxProp_FontMode,true,NULL);
+
+        RuleHighlighter_CheckRulesForErrors(WData);
+    }
+    catch(...)
+    {
+        if(WData!=NULL)
+        {
+            RuleHighlighter_FreeSettingsWidgets(
+                    (t_DataProSettingsWidgetsType *)WData);
+        }
+        return NULL;
+    }
+
+    return (t_DataProSettingsWidgetsType *)WData;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    FreeSettingsWidgets
+ *
+ * SYNOPSIS:
+ *    void FreeSettingsWidgets(t_DataProSettingsWidgetsType *PrivData);
+ *
+ * PARAMETERS:
+ *    PrivData [I] -- The private data to free
+ *
+ * FUNCTION:
+ *    This function is called when the system frees the settings widets.
+ *    It should free any private data you allocated in AllocSettingsWidgets().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    AllocSettingsWidgets()
+ ******************************************************************************/
+void RuleHighlighter_FreeSettingsWidgets(t_DataProSettingsWidgetsType *PrivData)
+{
+    struct RuleHighlighter_SettingsWidgets *WData=(struct RuleHighlighter_SettingsWidgets *)PrivData;
+    struct RuleHighlighter_RuleWidgets *Rule;
+    int r;
+
+    /* Free everything in reverse order */
+    if(WData->ErrorsTextBox!=NULL)
+    {
+        m_RuleHighlighter_UIAPI->FreeTextBox(WData->ErrorsGroupBox->
+                GroupWidgetHandle,WData->ErrorsTextBox);
+    }
+
+    if(WData->ErrorsGroupBox!=NULL)
+    {
+        m_RuleHighlighter_UIAPI->FreeGroupBox(WData->RulesTab,
+                WData->ErrorsGroupBox);
+    }
+
+    for(r=RULEHIGHLIGHTER_MAX_CUSTOM_RULES-1;r>=0;r--)
+    {
+        Rule=&WData->Rules[r];
+        if(Rule->GroupBox==NULL)
+            continue;
+
+        if(Rule->Style!=NULL)
+        {
+            m_RuleHighlighter_UIAPI->FreeStylePick(Rule->GroupBox->
+                    GroupWidgetHandle,Rule->Style);
+        }
+        if(Rule->IgnoreCase!=NULL)
+        {
+            m_RuleHighlighter_UIAPI->FreeCheckbox(Rule->GroupBox->
+                    GroupWidgetHandle,Rule->IgnoreCase);
+        }
+        if(Rule->Pattern!=NULL)
+        {
+            m_RuleHighlighter_UIAPI->FreeTextInput(Rule->GroupBox->
+                    GroupWidgetHandle,Rule->Pattern);
+        }
+        if(Rule->Type!=NULL)
+        {
+            m_RuleHighlighter_UIAPI->FreeComboBox(Rule->GroupBox->
+                    GroupWidgetHandle,Rule->Type);
+        }
+
+        m_RuleHighlighter_UIAPI->FreeGroupBox(WData->RulesTab,Rule->GroupBox);
+    }
+
+    for(r=RULEHIGHLIGHTER_NUMBER_OF_PRESETS-1;r>=0;r--)
+    {
+        if(WData->Presets[r].Style!=NULL)
+        {
+            m_RuleHighlighter_UIAPI->FreeStylePick(WData->PresetsTab,
+                    WData->Presets[r].Style);
+        }
+        if(WData->Presets[r].Enabled!=NULL)
+        {
+            m_RuleHighlighter_UIAPI->FreeCheckbox(WData->PresetsTab,
+                    WData->Presets[r].Enabled);
+        }
+    }
+
+    delete WData;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    SetSettingsFromWidgets
+ *
+ * SYNOPSIS:
+ *    void SetSettingsFromWidgets(t_DataProSettingsWidgetsType *PrivData,
+ *              t_PIKVList *Settings);
+ *
+ * PARAMETERS:
+ *    PrivData [I] -- Your private data allocated in AllocSettingsWidgets()
+ *    Settings [O] -- This is where you store the settings.
+ *
+ * FUNCTION:
+ *    This function takes the widgets added with AllocSettingsWidgets() and
+ *    stores them is a key/value pair list in 'Settings'.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    AllocSettingsWidgets()
+ ******************************************************************************/
+void RuleHighlighter_SetSettingsFromWidgets(t_DataProSettingsWidgetsType *PrivData,t_PIKVList *Settings)
+{
+    struct RuleHighlighter_SettingsWidgets *WData=(struct RuleHighlighter_SettingsWidgets *)PrivData;
+    struct RuleHighlighter_RuleWidgets *Rule;
+    unsigned int r;
+    char buff[100];
+    char ValueBuff[100];
+    struct StyleData SD;
+    char SDStr[SUGGESTED_STYLE_DATA_STR_BUFFER_LEN];
+    const char *Str;
+
+    for(r=0;r<RULEHIGHLIGHTER_NUMBER_OF_PRESETS;r++)
+    {
+        Str=m_RuleHighlighter_UIAPI->IsCheckboxChecked(WData->PresetsTab,
+                WData->Presets[r].Enabled->Ctrl)?"1":"0";
+        sprintf(buff,"Preset_%d",r);
+        m_RuleHighlighter_SysAPI->KVAddItem(Settings,buff,Str);
+
+        m_RuleHighlighter_UIAPI->GetStylePickValue(WData->PresetsTab,
+                WData->Presets[r].Style->Ctrl,&SD);
+        if(m_RuleHighlighter_UIAPI->Style2StrHelper(&SD,SDStr,sizeof(SDStr)))
+        {
+            sprintf(buff,"PresetStyle_%d",r);
+            m_RuleHighlighter_SysAPI->KVAddItem(Settings,buff,SDStr);
+        }
+    }
+
+    for(r=0;r<RULEHIGHLIGHTER_MAX_CUSTOM_RULES;r++)
+    {
+        Rule=&WData->Rules[r];
+
+        Str=m_RuleHighlighter_UIAPI->GetTextInputText(Rule->GroupBox->
+                GroupWidgetHandle,Rule->Pattern->Ctrl);
+        sprintf(buff,"RulePattern_%d",r);
+        m_RuleHighlighter_SysAPI->KVAddItem(Settings,buff,Str);
+
+        sprintf(ValueBuff,"%d",(int)m_RuleHighlighter_UIAPI->
+                GetComboBoxSelectedEntry(Rule->GroupBox->GroupWidgetHandle,
+                Rule->Type->Ctrl));
+        sprintf(buff,"RuleType_%d",r);
+        m_RuleHighlighter_SysAPI->KVAddItem(Settings,buff,ValueBuff);
+
+        Str=m_RuleHighlighter_UIAPI->IsCheckboxChecked(Rule->GroupBox->
+                GroupWidgetHandle,Rule->IgnoreCase->Ctrl)?"1":"0";
+        sprintf(buff,"RuleIgnoreCase_%d",r);
+        m_RuleHighlighter_SysAPI->KVAddItem(Settings,buff,Str);
+
+        m_RuleHighlighter_UIAPI->GetStylePickValue(Rule->GroupBox->
+                GroupWidgetHandle,Rule->Style->Ctrl,&SD);
+        if(m_RuleHighlighter_UIAPI->Style2StrHelper(&SD,SDStr,sizeof(SDStr)))
+        {
+            sprintf(buff,"RuleStyle_%d",r);
+            m_RuleHighlighter_SysAPI->KVAddItem(Settings,buff,SDStr);
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ApplySettings
+ *
+ * SYNOPSIS:
+ *    void ApplySettings(t_DataProcessorHandleType *DataHandle,
+ *              t_PIKVList *Settings);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to work on.  This is your internal
+ *                      data.
+ *    Settings [I] -- This is where you get your settings from.
+ *
+ * FUNCTION:
+ *    This function reads all the rules from the settings and compiles them
+ *    into the DFA.  Rules with errors are skipped (the settings dialog shows
+ *    the errors).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void RuleHighlighter_ApplySettings(t_DataProcessorHandleType *DataHandle,
+        t_PIKVList *Settings)
+{
+    struct RuleHighlighterData *Data=(struct RuleHighlighterData *)DataHandle;
+    e_RuleHighlighterTypeType Type;
+    const char *Str;
+    unsigned int r;
+    int RuleID;
+    char buff[100];
+    bool IgnoreCase;
+    string ErrorMsg;
+    unsigned int ErrorOffset;
+
+    RuleHighlighter_FixDefaultStyles();
+
+    Data->DFA.Clear();
+    Data->Spans.clear();
+    Data->InRun=false;
+    RuleHighlighter_ResetMatch(Data);
+
+    /* The user rules come first so they win over the presets */
+    for(r=0;r<RULEHIGHLIGHTER_MAX_CUSTOM_RULES;r++)
+    {
+        RuleID=r;
+
+        sprintf(buff,"RuleStyle_%d",r);
+        RuleHighlighter_GetStyleSetting(Settings,buff,&m_DefaultRuleStyle,
+                &Data->Styles[RuleID]);
+
+        sprintf(buff,"RulePattern_%d",r);
+        Str=m_RuleHighlighter_SysAPI->KVGetItem(Settings,buff);
+        if(Str==NULL || *Str==0)
+            continue;
+
+        sprintf(buff,"RuleType_%d",r);
+        Type=e_RuleHighlighterType_Keywords;
+        if(m_RuleHighlighter_SysAPI->KVGetItem(Settings,buff)!=NULL)
+        {
+            Type=(e_RuleHighlighterTypeType)atoi(m_RuleHighlighter_SysAPI->
+                    KVGetItem(Settings,buff));
+        }
+
+        sprintf(buff,"RuleIgnoreCase_%d",r);
+        IgnoreCase=false;
+        if(m_RuleHighlighter_SysAPI->KVGetItem(Settings,buff)!=NULL)
+        {
+            IgnoreCase=atoi(m_RuleHighlighter_SysAPI->KVGetItem(Settings,
+                    buff));
+        }
+
+        RuleHighlighter_AddRule(&Data->DFA,Type,Str,IgnoreCase,RuleID,
+                ErrorMsg);
+    }
+
+    for(r=0;r<RULEHIGHLIGHTER_NUMBER_OF_PRESETS;r++)
+    {
+        RuleID=RULEHIGHLIGHTER_MAX_CUSTOM_RULES+r;
+
+        sprintf(buff,"PresetStyle_%d",r);
+        RuleHighlighter_GetStyleSetting(Settings,buff,
+                &m_Presets[r].DefaultStyle,&Data->Styles[RuleID]);
+
+        sprintf(buff,"Preset_%d",r);
+        Str=m_RuleHighlighter_SysAPI->KVGetItem(Settings,buff);
+        if(Str!=NULL && atoi(Str)==0)
+            continue;
+
+        Data->DFA.AddRegex(m_Presets[r].Regex,false,RuleID,ErrorMsg,
+                ErrorOffset);
+    }
+
+    Data->HaveRules=false;
+    if(!Data->DFA.IsEmpty() && Data->DFA.Compile(ErrorMsg))
+        Data->HaveRules=true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_RuleChanged_EventCB
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_RuleChanged_EventCB(
+ *              const struct PICBEvent *Event,void *UserData);
+ *
+ * PARAMETERS:
+ *    Event [I] -- The event structure describing what happened.
+ *    UserData [I] -- The settings widgets
+ *
+ * FUNCTION:
+ *    This is a callback.  It is called when the user changes the pattern or
+ *    type of a rule.  We check the rules again for errors.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void RuleHighlighter_RuleChanged_EventCB(const struct PICBEvent *Event,
+        void *UserData)
+{
+    struct RuleHighlighter_SettingsWidgets *WData=(struct RuleHighlighter_SettingsWidgets *)UserData;
+
+    if(Event->EventType==e_PIECB_TextInputEditFinished ||
+            Event->EventType==e_PIECB_IndexChanged)
+    {
+        RuleHighlighter_CheckRulesForErrors(WData);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    RuleHighlighter_CheckRulesForErrors
+ *
+ * SYNOPSIS:
+ *    static void RuleHighlighter_CheckRulesForErrors(struct
+ *              RuleHighlighter_SettingsWidgets *WData);
+ *
+ * PARAMETERS:
+ *    WData [I] -- The settings widgets associated with this dialog.
+ *
+ * FUNCTION:
+ *    This function checks all the user rules for errors (and that they all
+ *    fit in one DFA) and shows the errors in the errors box.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void RuleHighlighter_CheckRulesForErrors(struct RuleHighlighter_SettingsWidgets *WData)
+{
+    struct RuleHighlighter_RuleWidgets *Rule;
+    e_RuleHighlighterTypeType Type;
+    class HighlightDFA AllRules;
+    string ErrorMsgs;
+    string Msg;
+    const char *Str;
+    unsigned int r;
+    char buff[100];
+    bool IgnoreCase;
+
+    /* We get called while the widgets are still being added */
+    if(WData->ErrorsTextBox==NULL)
+        return;
+
+    ErrorMsgs="";
+    for(r=0;r<RULEHIGHLIGHTER_MAX_CUSTOM_RULES;r++)
+    {
+        Rule=&WData->Rules[r];
+
+        Str=m_RuleHighlighter_UIAPI->GetTextInputText(Rule->GroupBox->
+                GroupWidgetHandle,Rule->Pattern->Ctrl);
+        if(Str==NULL || *Str==0)
+            continue;
+
+        Type=(e_RuleHighlighterTypeType)m_RuleHighlighter_UIAPI->
+                GetComboBoxSelectedEntry(Rule->GroupBox->GroupWidgetHandle,
+                Rule->Type->Ctrl);
+        IgnoreCase=m_RuleHighlighter_UIAPI->IsCheckboxChecked(Rule->GroupBox->
+                GroupWidgetHandle,Rule->IgnoreCase->Ctrl);
+
+        if(!RuleHighlighter_AddRule(&AllRules,Type,Str,IgnoreCase,r,Msg))
+        {
+            if(ErrorMsgs!="")
+                ErrorMsgs+="-------------\n";
+            sprintf(buff,"Rule %d has an error:\n",r+1);
+            ErrorMsgs+=buff;
+            ErrorMsgs+=Msg;
+            ErrorMsgs+="\n";
+        }
+    }
+
+    if(ErrorMsgs=="" && !AllRules.IsEmpty() && !AllRules.Compile(Msg))
+        ErrorMsgs=Msg;
+
+    m_RuleHighlighter_UIAPI->SetTextBox(WData->ErrorsGroupBox->
+            GroupWidgetHandle,WData->ErrorsTextBox->Ctrl,ErrorMsgs.c_str());
+}
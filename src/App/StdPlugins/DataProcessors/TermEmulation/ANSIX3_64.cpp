@@ -242,6 +242,8 @@ using namespace std;
 #define NEEDED_MIN_API_VERSION                  0x01000000
 
 #define MAX_SEARCH_ABORT_COUNT  128
+#define ANSIX364_MAX_ARG_VALUE  100000  // Stop adding digits to an arg after this
+#define ANSIX364_MAX_CSI_ARGS   32      // Must fit in the bits of 'CSISubArgs'
 
 #ifndef OFFICIAL_RELEASE
  #error "OFFICIAL_RELEASE not defined.  Did you include Version.h"
@@ -252,6 +254,9 @@ using namespace std;
 #define LOG_UNKNOWN_CODES_FILENAME          "/ram/unknowncodes.txt"
 
 /*** MACROS                   ***/
+#define ANSITRANS(Action,State)     {e_ANSIAction_##Action,e_ESCState_##State}
+#define ANSIX364_IS_SUBARG(Data,Arg) ((Arg)<(Data)->CSIArgCount && \
+                                        ((Data)->CSISubArgs&(1U<<(Arg))))
 
 /*** TYPE DEFINITIONS         ***/
 typedef enum
@@ -262,9 +267,56 @@ typedef enum
     e_ESCState_ESC,
     e_ESCState_CSI,
     e_ESCState_CSIQuest,
+    e_ESCState_ESCIntermediate,         // ESC followed by 0x20-0x2F (charset selects and friends)
+    e_ESCState_CSIIgnore,               // A CSI we don't support, eat it up to the final byte
     e_ESCStateMAX
 } e_ESCStateType;
 
+/* What kind of byte this is (see m_ANSIX364ByteClass) */
+typedef enum
+{
+    e_ANSIByteClass_Execute,            // C0 controls
+    e_ANSIByteClass_Bell,               // BEL (also ends an OSC string)
+    e_ANSIByteClass_Cancel,             // CAN, SUB
+    e_ANSIByteClass_Escape,             // ESC
+    e_ANSIByteClass_Delete,             // DEL
+    e_ANSIByteClass_Intermediate,       // 0x20-0x2F
+    e_ANSIByteClass_Digit,              // 0-9
+    e_ANSIByteClass_Colon,              // :
+    e_ANSIByteClass_Semicolon,          // ;
+    e_ANSIByteClass_Private,            // < = >
+    e_ANSIByteClass_Quest,              // ?
+    e_ANSIByteClass_Final,              // 0x40-0x7E (that isn't below)
+    e_ANSIByteClass_CSIIntro,           // [
+    e_ANSIByteClass_StringIntro,        // P X ] ^ _
+    e_ANSIByteClass_High,               // 0x80-0xFF
+    e_ANSIByteClassMAX
+} e_ANSIByteClassType;
+
+/* What to do with a byte (see m_ANSIX364Transitions) */
+typedef enum
+{
+    e_ANSIAction_Ignore,                // Eat it
+    e_ANSIAction_Print,                 // Normal char, pass it on to the screen
+    e_ANSIAction_Execute,               // Do a control char
+    e_ANSIAction_Clear,                 // Start of a new sequence, clear the args
+    e_ANSIAction_Param,                 // Add a digit to the current arg
+    e_ANSIAction_NextArg,               // Move to the next arg
+    e_ANSIAction_SubArg,                // Move to the next arg and mark it as a sub arg (:)
+    e_ANSIAction_CSIDispatch,
+    e_ANSIAction_CSIQuestDispatch,
+    e_ANSIAction_ESCDispatch,
+    e_ANSIAction_StringStart,
+    e_ANSIAction_StringChar,
+    e_ANSIActionMAX
+} e_ANSIActionType;
+
+struct ANSIX364Transition
+{
+    uint8_t Action;                     // e_ANSIActionType
+    uint8_t NextState;                  // e_ESCStateType
+};
+
 struct ANSIX364DecoderSavedCursorAttribs
 {
     int32_t SavedCursorX;
@@ -278,17 +330,20 @@ struct ANSIX364DecoderSavedCursorAttribs
 struct ANSIX364DecoderData
 {
     e_ESCStateType CurrentMode;
-    int CSIArg[10];
+    int CSIArg[ANSIX364_MAX_CSI_ARGS];
     unsigned int CSIArgCount;
+    uint32_t CSISubArgs;                // Bit n set = CSIArg[n] came after a ':'
     unsigned int SearchAbortCount;
-    unsigned int SearchIndex;
     int CurrentNum;
     bool DoingDim;
     bool DoingBright;
+    bool ULineColorSet;                 // SGR 58 picked the underline color
     uint8_t *LastProcessedChar;
     int LastProcessedCharLen;
     int LastProcessedCharBuffSize;
     struct ANSIX364DecoderSavedCursorAttribs SavedCursorAttribs;
+    int32_t ScrollTop;                  // First line of the scroll region
+    int32_t ScrollBottom;               // Line after the region (0 = no region)
 
     bool BoldEnabled;
     bool ItalicEnabled;
@@ -319,9 +374,15 @@ void ANSIX364Decoder_ProcessIncomingTextByte(t_DataProcessorHandleType *DataHand
         const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
         PG_BOOL *Consumed);
 void ANSIX364Decoder_HandleSGR(struct ANSIX364DecoderData *Data);
-void ANSIX364Decoder_ProcessCSI(struct ANSIX364DecoderData *Data,
-        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
-        PG_BOOL *Consumed);
+static bool ANSIX364Decoder_GetExtColor(struct ANSIX364DecoderData *Data,
+        unsigned int *Index,uint32_t *RetColor);
+int ANSIX364Decoder_ScanTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes);
+void ANSIX364Decoder_ProcessTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes);
+void ANSIX364Decoder_DoAction(struct ANSIX364DecoderData *Data,
+        e_ANSIActionType Action,const uint8_t RawByte,uint8_t *ProcessedChar,
+        int *CharLen,PG_BOOL *Consumed);
 void ANSIX364Decoder_DoCSICommand(struct ANSIX364DecoderData *Data,
         const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
         PG_BOOL *Consumed);
@@ -329,19 +390,19 @@ void ANSIX364Decoder_ResetSGR(struct ANSIX364DecoderData *Data);
 PG_BOOL ANSIX364Decoder_ProcessKeyPress(t_DataProcessorHandleType *DataHandle,
             const uint8_t *KeyChar,int KeyCharLen,e_UIKeys ExtendedKey,
             uint8_t Mod);
-void ANSIX364Decoder_ProcessESC(struct ANSIX364DecoderData *Data,
-        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
-        PG_BOOL *Consumed);
-void ANSIX364Decoder_ProcessNormalChar(struct ANSIX364DecoderData *Data,
-        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
-        PG_BOOL *Consumed);
-void ANSIX364Decoder_ProcessCSIQuest(struct ANSIX364DecoderData *Data,
+void ANSIX364Decoder_DoESCCommand(struct ANSIX364DecoderData *Data,
         const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
         PG_BOOL *Consumed);
+void ANSIX364Decoder_ExecuteCtrl(struct ANSIX364DecoderData *Data,
+        const uint8_t RawByte);
 void ANSIX364Decoder_DoCSIQuestCommand(struct ANSIX364DecoderData *Data,
         const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
         PG_BOOL *Consumed);
 static void ANSIX364Decoder_DefaultData(struct ANSIX364DecoderData *Data);
+static void ANSIX364Decoder_SaveCursor(struct ANSIX364DecoderData *Data);
+static void ANSIX364Decoder_RestoreCursor(struct ANSIX364DecoderData *Data);
+static void ANSIX364Decoder_NoteLastChar(struct ANSIX364DecoderData *Data,
+        const uint8_t *Chr,int Len);
 static t_DataProSettingsWidgetsType *ANSIX364Decoder_AllocSettingsWidgets(t_WidgetSysHandle *WidgetHandle,t_PIKVList *Settings);
 static void ANSIX364Decoder_FreeSettingsWidgets(t_DataProSettingsWidgetsType *PrivData);
 static void ANSIX364Decoder_SetSettingsFromWidgets(t_DataProSettingsWidgetsType *PrivData,t_PIKVList *Settings);
@@ -352,6 +413,182 @@ static const struct PI_UIAPI *m_UIAPI;
 static const struct PI_SystemAPI *m_System;
 static const struct DPS_API *m_DPS;
 
+/* The class of every byte */
+static const uint8_t m_ANSIX364ByteClass[256]=
+{
+    /* 0x00-0x1F (C0) */
+    0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,2,0,2,3,0,0,0,0,
+    /* 0x20-0x3F */
+    5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5, 6,6,6,6,6,6,6,6,6,6,7,8,9,9,9,10,
+    /* 0x40-0x5F */
+    11,11,11,11,11,11,11,11,11,11,11,11,11,11,11,11,
+    13,11,11,11,11,11,11,11,13,11,11,12,11,13,13,13,
+    /* 0x60-0x7F */
+    11,11,11,11,11,11,11,11,11,11,11,11,11,11,11,11,
+    11,11,11,11,11,11,11,11,11,11,11,11,11,11,11,4,
+    /* 0x80-0xFF */
+    14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,
+    14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,
+    14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,
+    14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,
+    14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,
+    14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,
+    14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,
+    14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,
+};
+
+/* What to do with each class of byte in each state (based on the DEC VT500
+   parser).  A control char in the middle of a sequence is done without
+   ending the sequence, CAN/SUB abort it, and ESC always starts a new one. */
+static const struct ANSIX364Transition
+        m_ANSIX364Transitions[e_ESCStateMAX][e_ANSIByteClassMAX]=
+{
+    /* e_ESCState_Normal */
+    {
+        ANSITRANS(Execute,Normal),          // Execute
+        ANSITRANS(Execute,Normal),          // Bell
+        ANSITRANS(Execute,Normal),          // Cancel
+        ANSITRANS(Clear,ESC),               // Escape
+        ANSITRANS(Execute,Normal),          // Delete
+        ANSITRANS(Print,Normal),            // Intermediate
+        ANSITRANS(Print,Normal),            // Digit
+        ANSITRANS(Print,Normal),            // Colon
+        ANSITRANS(Print,Normal),            // Semicolon
+        ANSITRANS(Print,Normal),            // Private
+        ANSITRANS(Print,Normal),            // Quest
+        ANSITRANS(Print,Normal),            // Final
+        ANSITRANS(Print,Normal),            // CSIIntro
+        ANSITRANS(Print,Normal),            // StringIntro
+        ANSITRANS(Print,Normal),            // High
+    },
+    /* e_ESCState_Search4Exit */
+    {
+        ANSITRANS(Execute,Search4Exit),     // Execute
+        ANSITRANS(Execute,Search4Exit),     // Bell
+        ANSITRANS(Execute,Normal),          // Cancel
+        ANSITRANS(Clear,ESC),               // Escape
+        ANSITRANS(Ignore,Search4Exit),      // Delete
+        ANSITRANS(Ignore,Normal),           // Intermediate
+        ANSITRANS(Ignore,Search4Exit),      // Digit
+        ANSITRANS(Ignore,Search4Exit),      // Colon
+        ANSITRANS(Ignore,Search4Exit),      // Semicolon
+        ANSITRANS(Ignore,Normal),           // Private
+        ANSITRANS(Ignore,Normal),           // Quest
+        ANSITRANS(Ignore,Normal),           // Final
+        ANSITRANS(Ignore,Normal),           // CSIIntro
+        ANSITRANS(Ignore,Normal),           // StringIntro
+        ANSITRANS(Ignore,Normal),           // High
+    },
+    /* e_ESCState_Search4ST */
+    {
+        ANSITRANS(StringChar,Search4ST),    // Execute
+        ANSITRANS(Ignore,Normal),           // Bell
+        ANSITRANS(Ignore,Normal),           // Cancel
+        ANSITRANS(Clear,ESC),               // Escape
+        ANSITRANS(Ignore,Search4ST),        // Delete
+        ANSITRANS(StringChar,Search4ST),    // Intermediate
+        ANSITRANS(StringChar,Search4ST),    // Digit
+        ANSITRANS(StringChar,Search4ST),    // Colon
+        ANSITRANS(StringChar,Search4ST),    // Semicolon
+        ANSITRANS(StringChar,Search4ST),    // Private
+        ANSITRANS(StringChar,Search4ST),    // Quest
+        ANSITRANS(StringChar,Search4ST),    // Final
+        ANSITRANS(StringChar,Search4ST),    // CSIIntro
+        ANSITRANS(StringChar,Search4ST),    // StringIntro
+        ANSITRANS(StringChar,Search4ST),    // High
+    },
+    /* e_ESCState_ESC */
+    {
+        ANSITRANS(Execute,ESC),             // Execute
+        ANSITRANS(Execute,ESC),             // Bell
+        ANSITRANS(Execute,Normal),          // Cancel
+        ANSITRANS(Clear,ESC),               // Escape
+        ANSITRANS(Ignore,ESC),              // Delete
+        ANSITRANS(Ignore,ESCIntermediate),  // Intermediate
+        ANSITRANS(ESCDispatch,Normal),      // Digit
+        ANSITRANS(ESCDispatch,Normal),      // Colon
+        ANSITRANS(ESCDispatch,Normal),      // Semicolon
+        ANSITRANS(ESCDispatch,Normal),      // Private
+        ANSITRANS(Ignore,Search4Exit),      // Quest
+        ANSITRANS(ESCDispatch,Normal),      // Final
+        ANSITRANS(Clear,CSI),               // CSIIntro
+        ANSITRANS(StringStart,Search4ST),   // StringIntro
+        ANSITRANS(Ignore,Normal),           // High
+    },
+    /* e_ESCState_CSI */
+    {
+        ANSITRANS(Execute,CSI),             // Execute
+        ANSITRANS(Execute,CSI),             // Bell
+        ANSITRANS(Execute,Normal),          // Cancel
+        ANSITRANS(Clear,ESC),               // Escape
+        ANSITRANS(Ignore,CSI),              // Delete
+        ANSITRANS(Ignore,CSIIgnore),        // Intermediate
+        ANSITRANS(Param,CSI),               // Digit
+        ANSITRANS(SubArg,CSI),              // Colon (sub args)
+        ANSITRANS(NextArg,CSI),             // Semicolon
+        ANSITRANS(Ignore,CSIIgnore),        // Private
+        ANSITRANS(Clear,CSIQuest),          // Quest
+        ANSITRANS(CSIDispatch,Normal),      // Final
+        ANSITRANS(CSIDispatch,Normal),      // CSIIntro
+        ANSITRANS(CSIDispatch,Normal),      // StringIntro
+        ANSITRANS(Ignore,Normal),           // High
+    },
+    /* e_ESCState_CSIQuest */
+    {
+        ANSITRANS(Execute,CSIQuest),        // Execute
+        ANSITRANS(Execute,CSIQuest),        // Bell
+        ANSITRANS(Execute,Normal),          // Cancel
+        ANSITRANS(Clear,ESC),               // Escape
+        ANSITRANS(Ignore,CSIQuest),         // Delete
+        ANSITRANS(Ignore,CSIIgnore),        // Intermediate
+        ANSITRANS(Param,CSIQuest),          // Digit
+        ANSITRANS(NextArg,CSIQuest),        // Colon
+        ANSITRANS(NextArg,CSIQuest),        // Semicolon
+        ANSITRANS(Ignore,CSIIgnore),        // Private
+        ANSITRANS(Ignore,CSIIgnore),        // Quest
+        ANSITRANS(CSIQuestDispatch,Normal), // Final
+        ANSITRANS(CSIQuestDispatch,Normal), // CSIIntro
+        ANSITRANS(CSIQuestDispatch,Normal), // StringIntro
+        ANSITRANS(Ignore,Normal),           // High
+    },
+    /* e_ESCState_ESCIntermediate */
+    {
+        ANSITRANS(Execute,ESCIntermediate), // Execute
+        ANSITRANS(Execute,ESCIntermediate), // Bell
+        ANSITRANS(Execute,Normal),          // Cancel
+        ANSITRANS(Clear,ESC),               // Escape
+        ANSITRANS(Ignore,ESCIntermediate),  // Delete
+        ANSITRANS(Ignore,ESCIntermediate),  // Intermediate
+        ANSITRANS(Ignore,Normal),           // Digit
+        ANSITRANS(Ignore,Normal),           // Colon
+        ANSITRANS(Ignore,Normal),           // Semicolon
+        ANSITRANS(Ignore,Normal),           // Private
+        ANSITRANS(Ignore,Normal),           // Quest
+        ANSITRANS(Ignore,Normal),           // Final
+        ANSITRANS(Ignore,Normal),           // CSIIntro
+        ANSITRANS(Ignore,Normal),           // StringIntro
+        ANSITRANS(Ignore,Normal),           // High
+    },
+    /* e_ESCState_CSIIgnore */
+    {
+        ANSITRANS(Execute,CSIIgnore),       // Execute
+        ANSITRANS(Execute,CSIIgnore),       // Bell
+        ANSITRANS(Execute,Normal),          // Cancel
+        ANSITRANS(Clear,ESC),               // Escape
+        ANSITRANS(Ignore,CSIIgnore),        // Delete
+        ANSITRANS(Ignore,CSIIgnore),        // Intermediate
+        ANSITRANS(Ignore,CSIIgnore),        // Digit
+        ANSITRANS(Ignore,CSIIgnore),        // Colon
+        ANSITRANS(Ignore,CSIIgnore),        // Semicolon
+        ANSITRANS(Ignore,CSIIgnore),        // Private
+        ANSITRANS(Ignore,CSIIgnore),        // Quest
+        ANSITRANS(Ignore,Normal),           // Final
+        ANSITRANS(Ignore,Normal),           // CSIIntro
+        ANSITRANS(Ignore,Normal),           // StringIntro
+        ANSITRANS(Ignore,Normal),           // High
+    },
+};
+
 struct DataProcessorAPI m_ANSIX364DecoderAPI=
 {
     ANSIX364Decoder_AllocateData,
@@ -367,6 +604,11 @@ struct DataProcessorAPI m_ANSIX364DecoderAPI=
     ANSIX364Decoder_FreeSettingsWidgets,
     ANSIX364Decoder_SetSettingsFromWidgets,
     ANSIX364Decoder_ApplySettings,
+    /* V4 */
+    NULL,       // ProcessIncomingTextBlockDone
+    /* V5 */
+    ANSIX364Decoder_ScanTextRun,
+    ANSIX364Decoder_ProcessTextRun,
 };
 struct DataProcessorInfo m_ANSIX364Decoder_Info=
 {
@@ -582,6 +824,7 @@ static void ANSIX364Decoder_DefaultData(struct ANSIX364DecoderData *Data)
 {
     Data->CurrentMode=e_ESCState_Normal;
     Data->CSIArgCount=0;
+    Data->CSISubArgs=0;
     Data->SearchAbortCount=0;
     Data->CurrentNum=0;
     Data->LastProcessedCharLen=0;
@@ -595,6 +838,8 @@ static void ANSIX364Decoder_DefaultData(struct ANSIX364DecoderData *Data)
             m_DPS->GetSysDefaultColor(e_DefaultColors_BG);
     Data->SavedCursorAttribs.SavedULineColor=
             m_DPS->GetSysDefaultColor(e_DefaultColors_FG);
+    Data->ScrollTop=0;
+    Data->ScrollBottom=0;
 
     ANSIX364Decoder_ResetSGR(Data);
 }
@@ -1004,113 +1249,342 @@ PG_BOOL ANSIX364Decoder_ProcessKeyPress(t_DataProcessorHandleType *DataHandle,
  *  FUNCTION:
  *    This function is called for each byte that comes in.
  *
+ *    The byte is looked up in 'm_ANSIX364ByteClass' and then the class and
+ *    the current state are looked up in 'm_ANSIX364Transitions' to get
+ *    what to do and the next state.  Normal text is one lookup of each.
+ *
  *  RETURNS:
  *    NONE
  *
  * SEE ALSO:
- *    
+ *    ANSIX364Decoder_DoAction()
  ******************************************************************************/
 void ANSIX364Decoder_ProcessIncomingTextByte(t_DataProcessorHandleType *DataHandle,
         const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
         PG_BOOL *Consumed)
 {
     struct ANSIX364DecoderData *Data=(struct ANSIX364DecoderData *)DataHandle;
+    const struct ANSIX364Transition *Trans;
+
+    Trans=&m_ANSIX364Transitions[Data->CurrentMode]
+            [m_ANSIX364ByteClass[RawByte]];
 
-    switch(Data->CurrentMode)
+    if(Trans->Action==e_ANSIAction_Print)
     {
-        case e_ESCState_Normal:
-            ANSIX364Decoder_ProcessNormalChar(Data,RawByte,ProcessedChar,
+        /* Normal char, just note it for REP */
+        ANSIX364Decoder_NoteLastChar(Data,ProcessedChar,*CharLen);
+        return;
+    }
+
+    *Consumed=true;
+    Data->CurrentMode=(e_ESCStateType)Trans->NextState;
+    ANSIX364Decoder_DoAction(Data,(e_ANSIActionType)Trans->Action,RawByte,
+            ProcessedChar,CharLen,Consumed);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ANSIX364Decoder_ScanTextRun
+ *
+ * SYNOPSIS:
+ *    int ANSIX364Decoder_ScanTextRun(t_DataProcessorHandleType *DataHandle,
+ *              const uint8_t *Run,int Bytes);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to your internal data.
+ *    Run [I] -- The bytes that have not been processed yet
+ *    Bytes [I] -- The number of bytes in 'Run'
+ *
+ * FUNCTION:
+ *    This function finds how many bytes at the start of 'Run' are printable
+ *    AscII that we would pass though.  This is only the case when we are
+ *    not in the middle of an escape sequence.
+ *
+ *    Bytes past 0x7F are left to ANSIX364Decoder_ProcessIncomingTextByte()
+ *    because they are normally only part of a char.
+ *
+ * RETURNS:
+ *    The number of bytes that can be passed though.
+ *
+ * SEE ALSO:
+ *    ANSIX364Decoder_ProcessTextRun()
+ ******************************************************************************/
+int ANSIX364Decoder_ScanTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes)
+{
+    struct ANSIX364DecoderData *Data=(struct ANSIX364DecoderData *)DataHandle;
+    int r;
+
+    if(Data->CurrentMode!=e_ESCState_Normal)
+        return 0;
+
+    for(r=0;r<Bytes;r++)
+        if(Run[r]<0x20 || Run[r]>0x7E)
+            break;
+
+    return r;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ANSIX364Decoder_ProcessTextRun
+ *
+ * SYNOPSIS:
+ *    void ANSIX364Decoder_ProcessTextRun(t_DataProcessorHandleType *DataHandle,
+ *              const uint8_t *Run,int Bytes);
+ *
+ * PARAMETERS:
+ *    DataHandle [I] -- The data handle to your internal data.
+ *    Run [I] -- The printable bytes being passed though
+ *    Bytes [I] -- The number of bytes in 'Run'
+ *
+ * FUNCTION:
+ *    This function is called for a run of text that
+ *    ANSIX364Decoder_ScanTextRun() said could be passed though.  The only
+ *    thing we need from it is the last char (for REP).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ANSIX364Decoder_ScanTextRun()
+ ******************************************************************************/
+void ANSIX364Decoder_ProcessTextRun(t_DataProcessorHandleType *DataHandle,
+        const uint8_t *Run,int Bytes)
+{
+    struct ANSIX364DecoderData *Data=(struct ANSIX364DecoderData *)DataHandle;
+
+    if(Bytes>0)
+        ANSIX364Decoder_NoteLastChar(Data,&Run[Bytes-1],1);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ANSIX364Decoder_DoAction
+ *
+ * SYNOPSIS:
+ *    void ANSIX364Decoder_DoAction(struct ANSIX364DecoderData *Data,
+ *          e_ANSIActionType Action,const uint8_t RawByte,
+ *          uint8_t *ProcessedChar,int *CharLen,PG_BOOL *Consumed);
+ *
+ * PARAMETERS:
+ *    Data [I] -- Our internal data.
+ *    Action [I] -- What to do (from 'm_ANSIX364Transitions')
+ *    RawByte [I] -- The raw input byte from the data stream.
+ *    ProcessedChar [I/O] -- The processed char (see
+ *                           ANSIX364Decoder_ProcessIncomingTextByte())
+ *    CharLen [I/O] -- The length of 'ProcessedChar'
+ *    Consumed [I/O] -- Set to true if the byte was consumed by this processor.
+ *
+ * FUNCTION:
+ *    This function does the action from the transition table for a byte
+ *    that isn't a normal char.  The new state has already been set.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ANSIX364Decoder_ProcessIncomingTextByte()
+ ******************************************************************************/
+void ANSIX364Decoder_DoAction(struct ANSIX364DecoderData *Data,
+        e_ANSIActionType Action,const uint8_t RawByte,uint8_t *ProcessedChar,
+        int *CharLen,PG_BOOL *Consumed)
+{
+    switch(Action)
+    {
+        case e_ANSIAction_Execute:
+            ANSIX364Decoder_ExecuteCtrl(Data,RawByte);
+        break;
+        case e_ANSIAction_Clear:
+            Data->CSIArgCount=0;
+            Data->CSISubArgs=0;
+            Data->CurrentNum=0;
+            Data->CSIArg[0]=0;
+        break;
+        case e_ANSIAction_Param:
+            /* Add to the number (and stop before it overflows) */
+            if(Data->CurrentNum<ANSIX364_MAX_ARG_VALUE)
+                Data->CurrentNum=Data->CurrentNum*10+(RawByte-'0');
+        break;
+        case e_ANSIAction_NextArg:
+            if(Data->CSIArgCount<sizeof(Data->CSIArg)/sizeof(int))
+                Data->CSIArg[Data->CSIArgCount++]=Data->CurrentNum;
+            Data->CurrentNum=0;
+        break;
+        case e_ANSIAction_SubArg:
+            if(Data->CSIArgCount<sizeof(Data->CSIArg)/sizeof(int))
+                Data->CSIArg[Data->CSIArgCount++]=Data->CurrentNum;
+            if(Data->CSIArgCount<sizeof(Data->CSIArg)/sizeof(int))
+                Data->CSISubArgs|=1U<<Data->CSIArgCount;
+            Data->CurrentNum=0;
+        break;
+        case e_ANSIAction_CSIDispatch:
+            if(Data->CSIArgCount<sizeof(Data->CSIArg)/sizeof(int))
+                Data->CSIArg[Data->CSIArgCount++]=Data->CurrentNum;
+
+            ANSIX364Decoder_DoCSICommand(Data,RawByte,ProcessedChar,CharLen,
+                    Consumed);
+        break;
+        case e_ANSIAction_CSIQuestDispatch:
+            if(Data->CSIArgCount<sizeof(Data->CSIArg)/sizeof(int))
+                Data->CSIArg[Data->CSIArgCount++]=Data->CurrentNum;
+
+            ANSIX364Decoder_DoCSIQuestCommand(Data,RawByte,ProcessedChar,
                     CharLen,Consumed);
         break;
-        case e_ESCState_Search4Exit:
-            /* We are searching for a char that will make us exit (and ignore)
-               the current mode */
-            if(RawByte!=':' && RawByte!=';' && (RawByte<'0' || RawByte>'9'))
-            {
-                Data->CurrentMode=e_ESCState_Normal;
-            }
-            *Consumed=true;
+        case e_ANSIAction_ESCDispatch:
+            ANSIX364Decoder_DoESCCommand(Data,RawByte,ProcessedChar,CharLen,
+                    Consumed);
         break;
-        case e_ESCState_Search4ST:
-            /* Search until we find a ST (String Terminator) or we have to many
-               chars (we don't want to get locked into this) */
-            if((RawByte<0x08 || RawByte>0x0D) &&
-                    (RawByte<0x20 || RawByte>0x7E) &&
-                    RawByte!=0x1B)
-            {
-                /* This char is not in the valid range, abort */
-                Data->CurrentMode=e_ESCState_Normal;
-                break;
-            }
-            switch(Data->SearchIndex)
-            {
-                case 0: // First byte
-                    if(RawByte==0x1B)   // ESC
-                    {
-                        /* Ok, we need to check the new char */
-                        Data->SearchIndex++;
-                    }
-                break;
-                case 1: // Second byte
-                    if(RawByte=='\\')   // STRING TERMINATOR
-                    {
-                        /* Ok we are done */
-                        Data->CurrentMode=e_ESCState_Normal;
-                    }
-                    else
-                    {
-                        Data->SearchIndex=0;
-                    }
-                break;
-                default:
-                break;
-            }
+        case e_ANSIAction_StringStart:
+            Data->SearchAbortCount=0;
+        break;
+        case e_ANSIAction_StringChar:
             Data->SearchAbortCount++;
             if(Data->SearchAbortCount>MAX_SEARCH_ABORT_COUNT)
             {
                 /* The string is too long so we abort (so we don't get stuck) */
                 Data->CurrentMode=e_ESCState_Normal;
             }
-            *Consumed=true;
-        break;
-        case e_ESCState_ESC:
-            ANSIX364Decoder_ProcessESC(Data,RawByte,ProcessedChar,
-                    CharLen,Consumed);
-        break;
-        case e_ESCState_CSI:
-            ANSIX364Decoder_ProcessCSI(Data,RawByte,ProcessedChar,
-                    CharLen,Consumed);
-        break;
-        case e_ESCState_CSIQuest:
-            ANSIX364Decoder_ProcessCSIQuest(Data,RawByte,ProcessedChar,
-                    CharLen,Consumed);
         break;
-        case e_ESCStateMAX:
+        case e_ANSIAction_Print:    // Done in ProcessIncomingTextByte()
+        case e_ANSIAction_Ignore:
+        case e_ANSIActionMAX:
         default:
-            /* Invalid mode switch back to normal */
-            Data->CurrentMode=e_ESCState_Normal;
         break;
     }
 }
 
 /*******************************************************************************
  * NAME:
- *    ANSIX364Decoder_ProcessNormalChar
+ *    ANSIX364Decoder_SaveCursor
  *
  * SYNOPSIS:
- *    void ANSIX364Decoder_ProcessNormalChar(struct ANSIX364DecoderData *Data,
- *        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
- *        PG_BOOL *Consumed);
+ *    static void ANSIX364Decoder_SaveCursor(struct ANSIX364DecoderData *Data);
+ *
+ * PARAMETERS:
+ *    Data [I] -- Our internal data.
+ *
+ * FUNCTION:
+ *    This function saves the cursor position and the current attributes
+ *    (DECSC).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ANSIX364Decoder_RestoreCursor()
+ ******************************************************************************/
+static void ANSIX364Decoder_SaveCursor(struct ANSIX364DecoderData *Data)
+{
+    struct StyleData SD;
+
+    m_DPS->GetCursorXY(&Data->SavedCursorAttribs.SavedCursorX,
+            &Data->SavedCursorAttribs.SavedCursorY);
+    m_DPS->GetStyle(&SD);
+    Data->SavedCursorAttribs.SavedFGColor=SD.FGColor;
+    Data->SavedCursorAttribs.SavedBGColor=SD.BGColor;
+    Data->SavedCursorAttribs.SavedAttribs=SD.Attribs;
+    Data->SavedCursorAttribs.SavedULineColor=SD.ULineColor;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ANSIX364Decoder_RestoreCursor
+ *
+ * SYNOPSIS:
+ *    static void ANSIX364Decoder_RestoreCursor(
+ *          struct ANSIX364DecoderData *Data);
+ *
+ * PARAMETERS:
+ *    Data [I] -- Our internal data.
+ *
+ * FUNCTION:
+ *    This function puts back the cursor position and attributes saved with
+ *    ANSIX364Decoder_SaveCursor() (DECRC).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ANSIX364Decoder_SaveCursor()
+ ******************************************************************************/
+static void ANSIX364Decoder_RestoreCursor(struct ANSIX364DecoderData *Data)
+{
+    struct StyleData SD;
+
+    m_DPS->SetCursorXY(Data->SavedCursorAttribs.SavedCursorX,
+            Data->SavedCursorAttribs.SavedCursorY);
+    SD.FGColor=Data->SavedCursorAttribs.SavedFGColor;
+    SD.BGColor=Data->SavedCursorAttribs.SavedBGColor;
+    SD.Attribs=Data->SavedCursorAttribs.SavedAttribs;
+    SD.ULineColor=Data->SavedCursorAttribs.SavedULineColor;
+    m_DPS->SetStyle(&SD);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ANSIX364Decoder_NoteLastChar
+ *
+ * SYNOPSIS:
+ *    void ANSIX364Decoder_NoteLastChar(struct ANSIX364DecoderData *Data,
+ *          const uint8_t *Chr,int Len);
+ *
+ * PARAMETERS:
+ *    Data [I] -- Our internal data.
+ *    Chr [I] -- The char that was passed on to the screen
+ *    Len [I] -- The number of bytes in 'Chr'
+ *
+ * FUNCTION:
+ *    This function notes the last char that was added to the screen so REP
+ *    can repeat it.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ANSIX364Decoder_DoCSICommand()
+ ******************************************************************************/
+static void ANSIX364Decoder_NoteLastChar(struct ANSIX364DecoderData *Data,
+        const uint8_t *Chr,int Len)
+{
+    Data->LastProcessedCharLen=Len;
+    if(Len>Data->LastProcessedCharBuffSize)
+    {
+        uint8_t *NewBuffer;
+
+        /* We need a bigger buffer */
+        NewBuffer=(uint8_t *)realloc(Data->LastProcessedChar,Len);
+        if(NewBuffer!=NULL)
+        {
+            Data->LastProcessedChar=NewBuffer;
+            Data->LastProcessedCharBuffSize=Len;
+        }
+        else
+        {
+            Data->LastProcessedCharLen=0;
+        }
+    }
+    if(Data->LastProcessedCharLen>0)
+        memcpy(Data->LastProcessedChar,Chr,Len);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ANSIX364Decoder_ExecuteCtrl
+ *
+ * SYNOPSIS:
+ *    void ANSIX364Decoder_ExecuteCtrl(struct ANSIX364DecoderData *Data,
+ *        const uint8_t RawByte);
  *
  * PARAMETERS:
  *    Data [I] -- Caller-supplied data.
- *    RawByte [I] -- The raw input byte from the data stream.
- *    ProcessedChar [O] -- Receives the processed character (output).
- *    CharLen [O] -- Receives the length of the processed character.
- *    Consumed [O] -- Set to true if the byte was consumed by this processor.
+ *    RawByte [I] -- The control char (C0 or DEL)
  *
  * FUNCTION:
- *    This function processes a char in normal mode as they come in.
+ *    This function does a control char.  These can come in the middle of
+ *    an escape sequence as well as in normal text.  Control chars we don't
+ *    do anything with are added as a non-printable note.
  *
  * RETURNS:
  *    NONE
@@ -1118,9 +1592,8 @@ void ANSIX364Decoder_ProcessIncomingTextByte(t_DataProcessorHandleType *DataHand
  * SEE ALSO:
  *    
  ******************************************************************************/
-void ANSIX364Decoder_ProcessNormalChar(struct ANSIX364DecoderData *Data,
-        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
-        PG_BOOL *Consumed)
+void ANSIX364Decoder_ExecuteCtrl(struct ANSIX364DecoderData *Data,
+        const uint8_t RawByte)
 {
     const char *CodeStr;
 
@@ -1152,23 +1625,19 @@ void ANSIX364Decoder_ProcessNormalChar(struct ANSIX364DecoderData *Data,
         case 7: // BEL  Bell
             CodeStr="BEL";
             m_DPS->DoSystemBell(false);
-            *Consumed=true;
         break;
         case 8: // BS  Backspace
             /* Backspace */
 //                CodeStr="BS";
             m_DPS->DoBackspace();
-            *Consumed=true;
         break;
         case 9: // HT  Character Tabulation, Horizontal Tabulation
             m_DPS->DoTab();
-            *Consumed=true;
         break;
         case 10:    // LF  Line Feed
             /* New line */
             m_DPS->DoNewLine();
 //                CodeStr="LF";
-            *Consumed=true;
         break;
         case 11:    // VT  Line Tabulation, Vertical Tabulation
             CodeStr="VT";
@@ -1176,12 +1645,10 @@ void ANSIX364Decoder_ProcessNormalChar(struct ANSIX364DecoderData *Data,
         case 12:    // FF  Form Feed
             m_DPS->DoClearScreen();
 //                CodeStr="FF";
-            *Consumed=true;
         break;
         case 13:    // CR  Carriage Return
             m_DPS->DoReturn();
 //                CodeStr="CR";
-            *Consumed=true;
         break;
         case 14:    // SO  Shift Out
             CodeStr="SO";
@@ -1222,14 +1689,6 @@ void ANSIX364Decoder_ProcessNormalChar(struct ANSIX364DecoderData *Data,
         case 26:    // SUB  Substitute
             CodeStr="SUB";
         break;
-        case 27:    // ESC  Escape
-//                CodeStr="ESC";
-            Data->CSIArgCount=0;
-            Data->CurrentNum=0;
-            Data->CSIArg[0]=0;
-            Data->CurrentMode=e_ESCState_ESC;
-            *Consumed=true;
-        break;
         case 28:    // FS  File Separator
             CodeStr="FS";
         break;
@@ -1246,111 +1705,10 @@ void ANSIX364Decoder_ProcessNormalChar(struct ANSIX364DecoderData *Data,
             CodeStr="DEL";
         break;
         default:
-            /* Note what char this was */
-            Data->LastProcessedCharLen=*CharLen;
-            if(*CharLen>Data->LastProcessedCharBuffSize)
-            {
-                uint8_t *NewBuffer;
-
-                /* We need a bigger buffer */
-                NewBuffer=(uint8_t *)realloc(Data->LastProcessedChar,*CharLen);
-                if(NewBuffer!=NULL)
-                {
-                    Data->LastProcessedChar=NewBuffer;
-                    Data->LastProcessedCharBuffSize=*CharLen;
-                }
-                else
-                {
-                    Data->LastProcessedCharLen=0;
-                }
-            }
-            if(Data->LastProcessedCharLen>0)
-                memcpy(Data->LastProcessedChar,ProcessedChar,*CharLen);
         break;
     }
     if(CodeStr!=NULL)
-    {
         m_DPS->NoteNonPrintable(CodeStr);
-        *Consumed=true;
-    }
-}
-
-/*******************************************************************************
- * NAME:
- *    ANSIX364Decoder_ProcessCSI
- *
- * SYNOPSIS:
- *    void ANSIX364Decoder_ProcessCSI(struct ANSIX364DecoderData *Data,
- *        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
- *        PG_BOOL *Consumed);
- *
- * PARAMETERS:
- *    Data [I] -- Caller-supplied data.
- *    RawByte [I] -- The raw input byte from the data stream.
- *    ProcessedChar [O] -- Receives the processed character (output).
- *    CharLen [O] -- Receives the length of the processed character.
- *    Consumed [O] -- Set to true if the byte was consumed by this processor.
- *
- * FUNCTION:
- *    This function processes a char in CSI mode as they come in.
- *
- * RETURNS:
- *    NONE
- *
- * SEE ALSO:
- *    
- ******************************************************************************/
-void ANSIX364Decoder_ProcessCSI(struct ANSIX364DecoderData *Data,
-        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
-        PG_BOOL *Consumed)
-{
-    /* We keep going until we see something that isn't a "0-9:;<=>?" */
-    *Consumed=true;
-
-    switch(RawByte)
-    {
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-            /* Add to the number */
-            Data->CurrentNum*=10;
-            Data->CurrentNum+=RawByte-'0';
-        break;
-        case ':':   // Sub arg...
-        break;
-        case ';':
-            /* Next arg */
-            if(Data->CSIArgCount<sizeof(Data->CSIArg)/sizeof(int))
-                Data->CSIArg[Data->CSIArgCount++]=Data->CurrentNum;
-            Data->CurrentNum=0;
-        break;
-        case '?':   // Private parameter strings
-            Data->CSIArgCount=0;
-            Data->CurrentNum=0;
-            Data->CSIArg[0]=0;
-            Data->CurrentMode=e_ESCState_CSIQuest;
-        break;
-        case '<':   // Private parameter strings
-        case '=':   // Private parameter strings
-        case '>':   // Private parameter strings
-        break;
-        default:
-            /* This is the end of the command */
-            if(Data->CSIArgCount<sizeof(Data->CSIArg)/sizeof(int))
-                Data->CSIArg[Data->CSIArgCount++]=Data->CurrentNum;
-
-            ANSIX364Decoder_DoCSICommand(Data,RawByte,ProcessedChar,CharLen,
-                    Consumed);
-            Data->CurrentMode=e_ESCState_Normal;
-        break;
-    }
 }
 
 /*******************************************************************************
@@ -1383,6 +1741,8 @@ void ANSIX364Decoder_DoCSICommand(struct ANSIX364DecoderData *Data,
         PG_BOOL *Consumed)
 {
     int32_t CursorX,CursorY;
+    int32_t Rows,Columns;
+    int32_t Top,Bottom;
     int p1;
     int p2;
     int r;
@@ -1425,7 +1785,6 @@ void ANSIX364Decoder_DoCSICommand(struct ANSIX364DecoderData *Data,
         case 'o':   // DAQ
         case 'p':   // Private Use
         case 'q':   // Private Use
-        case 'r':   // Private Use
         case 'v':   // Private Use
         case 'w':   // Private Use
         case 'x':   // Private Use
@@ -1560,19 +1919,25 @@ void ANSIX364Decoder_DoCSICommand(struct ANSIX364DecoderData *Data,
             }
         break;
         case 'L':   // IL - Insert lines
-            m_DPS->DoScrollArea(0,CursorY,-1,-1,0,p1);
-        break;
         case 'M':   // DL - Delete Line
-            m_DPS->DoScrollArea(0,CursorY,-1,-1,0,-p1);
+            /* Only the lines from the cursor to the bottom margin move, and
+               nothing happens if the cursor is outside the scroll region */
+            if(CursorY<Data->ScrollTop ||
+                    (Data->ScrollBottom!=0 && CursorY>=Data->ScrollBottom))
+            {
+                break;
+            }
+            Bottom=Data->ScrollBottom!=0?Data->ScrollBottom:-1;
+            m_DPS->DoScrollArea(0,CursorY,-1,Bottom,0,RawByte=='L'?p1:-p1);
         break;
         case 'P':   // DCH - Delete Character
             m_DPS->DoScrollArea(CursorX,CursorY,-1,CursorY+1,-p1,0);
         break;
         case 'S':   // SU - Scroll Up
-            m_DPS->DoScrollArea(0,0,-1,-1,0,-p1);
-        break;
         case 'T':   // SD - Scroll Down
-            m_DPS->DoScrollArea(0,0,-1,-1,0,p1);
+            Bottom=Data->ScrollBottom!=0?Data->ScrollBottom:-1;
+            m_DPS->DoScrollArea(0,Data->ScrollTop,-1,Bottom,0,
+                    RawByte=='S'?-p1:p1);
         break;
         case 'X':   // ECH - Erase Character
             m_DPS->DoClearArea(CursorX,CursorY,CursorX+p1,CursorY+1);
@@ -1634,6 +1999,27 @@ void ANSIX364Decoder_DoCSICommand(struct ANSIX364DecoderData *Data,
                 break;
             }
         break;
+        case 'r':   // DECSTBM - Set Top and Bottom Margins
+            m_DPS->GetScreenSize(&Rows,&Columns);
+            Top=p1-1;
+            Bottom=Rows;
+            if(Data->CSIArgCount>=2 && Data->CSIArg[1]>0 &&
+                    Data->CSIArg[1]<Rows)
+            {
+                Bottom=Data->CSIArg[1];
+            }
+
+            /* The region has to be at least 2 lines */
+            if(Top>=Bottom-1)
+                break;
+
+            if(Top==0 && Bottom==Rows)
+                Bottom=0;   // The whole screen, same as no region
+            Data->ScrollTop=Top;
+            Data->ScrollBottom=Bottom;
+            m_DPS->DoSetScrollRegion(Top,Bottom);
+            m_DPS->SetCursorXY(0,0);
+        break;
         case 's':   // SCP - Save Cursor Position
             m_DPS->GetCursorXY(&Data->SavedCursorAttribs.SavedCursorX,
                     &Data->SavedCursorAttribs.SavedCursorY);
@@ -1660,6 +2046,10 @@ void ANSIX364Decoder_DoCSICommand(struct ANSIX364DecoderData *Data,
  * FUNCTION:
  *    This function does a SGR command (\33[m type).
  *
+ *    The current style is read once at the start with GetStyle() and
+ *    written back once at the end with SetStyle() no matter how many args
+ *    the SGR had.
+ *
  * RETURNS:
  *    NONE
  *
@@ -1671,15 +2061,18 @@ void ANSIX364Decoder_HandleSGR(struct ANSIX364DecoderData *Data)
     unsigned int r;
     uint32_t TmpCol;
     e_SysColShadeType Shade;
+    struct StyleData SD;
     uint32_t Attribs;
     uint32_t FGColor;
     uint32_t BGColor;
     uint32_t ULineColor;
+    int ULineStyle;
 
-    FGColor=m_DPS->GetFGColor();
-    BGColor=m_DPS->GetBGColor();
-    Attribs=m_DPS->GetAttribs();
-    ULineColor=m_DPS->GetULineColor();
+    m_DPS->GetStyle(&SD);
+    FGColor=SD.FGColor;
+    BGColor=SD.BGColor;
+    Attribs=SD.Attribs;
+    ULineColor=SD.ULineColor;
 
     for(r=0;r<Data->CSIArgCount;r++)
     {
@@ -1705,11 +2098,25 @@ void ANSIX364Decoder_HandleSGR(struct ANSIX364DecoderData *Data)
                 if(Data->ItalicEnabled)
                     Attribs|=TXT_ATTRIB_ITALIC;
             break;
-            case 4: // singly underlined
-                if(Data->UnderlineEnabled)
+            case 4: // singly underlined (4:n picks the style, 0=off 2=double)
+                ULineStyle=1;
+                if(ANSIX364_IS_SUBARG(Data,r+1))
+                    ULineStyle=Data->CSIArg[r+1];
+                if(ULineStyle==0)
+                {
+                    Attribs&=~(TXT_ATTRIB_UNDERLINE|TXT_ATTRIB_UNDERLINE_DOUBLE);
+                }
+                else if(ULineStyle==2 && Data->DoubleUnderlineEnabled)
+                {
+                    Attribs|=TXT_ATTRIB_UNDERLINE_DOUBLE;
+                    if(!Data->ULineColorSet)
+                        ULineColor=FGColor;
+                }
+                else if(Data->UnderlineEnabled)
                 {
                     Attribs|=TXT_ATTRIB_UNDERLINE;
-                    ULineColor=FGColor;
+                    if(!Data->ULineColorSet)
+                        ULineColor=FGColor;
                 }
             break;
             case 5: // slowly blinking (less then 150 per minute)
@@ -1740,7 +2147,8 @@ void ANSIX364Decoder_HandleSGR(struct ANSIX364DecoderData *Data)
                 if(Data->DoubleUnderlineEnabled)
                 {
                     Attribs|=TXT_ATTRIB_UNDERLINE_DOUBLE;
-                    ULineColor=FGColor;
+                    if(!Data->ULineColorSet)
+                        ULineColor=FGColor;
                 }
             break;
             case 22: // normal colour or normal intensity (neither bold nor faint)
@@ -1782,6 +2190,8 @@ void ANSIX364Decoder_HandleSGR(struct ANSIX364DecoderData *Data)
                 FGColor=TmpCol;
             break;
             case 38: // (reserved for future standardization; intended for setting character foreground colour as specified in ISO 8613-6 [CCITT Recommendation T.416])
+                if(ANSIX364Decoder_GetExtColor(Data,&r,&TmpCol))
+                    FGColor=TmpCol;
             break;
             case 39: // default display colour (implementation-defined)
                 FGColor=m_DPS->GetSysDefaultColor(e_DefaultColors_FG);
@@ -1798,6 +2208,8 @@ void ANSIX364Decoder_HandleSGR(struct ANSIX364DecoderData *Data)
                 BGColor=TmpCol;
             break;
             case 48: // (reserved for future standardization; intended for setting character background colour as specified in ISO 8613-6 [CCITT Recommendation T.416])
+                if(ANSIX364Decoder_GetExtColor(Data,&r,&TmpCol))
+                    BGColor=TmpCol;
             break;
             case 49: // default background colour (implementation-defined)
                 BGColor=m_DPS->GetSysDefaultColor(e_DefaultColors_BG);
@@ -1811,7 +2223,8 @@ void ANSIX364Decoder_HandleSGR(struct ANSIX364DecoderData *Data)
                 if(Data->OverlineEnabled)
                 {
                     Attribs|=TXT_ATTRIB_OVERLINE;
-                    ULineColor=FGColor;
+                    if(!Data->ULineColorSet)
+                        ULineColor=FGColor;
                 }
             break;
             case 54: // not framed, not encircled
@@ -1821,8 +2234,18 @@ void ANSIX364Decoder_HandleSGR(struct ANSIX364DecoderData *Data)
             break;
             case 56: // (reserved for future standardization)
             case 57: // (reserved for future standardization)
-            case 58: // (reserved for future standardization)
-            case 59: // (reserved for future standardization)
+            break;
+            case 58: // underline colour (not in ECMA-48, same args as 38)
+                if(ANSIX364Decoder_GetExtColor(Data,&r,&TmpCol))
+                {
+                    ULineColor=TmpCol;
+                    Data->ULineColorSet=true;
+                }
+            break;
+            case 59: // default underline colour
+                ULineColor=FGColor;
+                Data->ULineColorSet=false;
+            break;
             case 60: // ideogram underline or right side line
             case 61: // ideogram double underline or double line on the right side
             case 62: // ideogram overline or left side line
@@ -1855,11 +2278,164 @@ void ANSIX364Decoder_HandleSGR(struct ANSIX364DecoderData *Data)
             default:
             break;
         }
+
+        /* Skip any sub args we didn't use (4:3 and friends) */
+        while(ANSIX364_IS_SUBARG(Data,r+1))
+            r++;
     }
-    m_DPS->SetFGColor(FGColor);
-    m_DPS->SetBGColor(BGColor);
-    m_DPS->SetAttribs(Attribs);
-    m_DPS->SetULineColor(ULineColor);
+
+    SD.FGColor=FGColor;
+    SD.BGColor=BGColor;
+    SD.Attribs=Attribs;
+    SD.ULineColor=ULineColor;
+    m_DPS->SetStyle(&SD);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ANSIX364Decoder_GetExtColor
+ *
+ * SYNOPSIS:
+ *    static bool ANSIX364Decoder_GetExtColor(struct ANSIX364DecoderData *Data,
+ *          unsigned int *Index,uint32_t *RetColor);
+ *
+ * PARAMETERS:
+ *    Data [I] -- Our internal data.
+ *    Index [I/O] -- The index into 'Data->CSIArg' of the 38/48/58.  This is
+ *                   moved to the last arg that was used by the color.
+ *    RetColor [O] -- The color in 0xRRGGBB format
+ *
+ * FUNCTION:
+ *    This function decodes the args after a SGR 38, 48 or 58.  It handles
+ *    both the xterm form:
+ *          38;5;n          -- 256 color palette
+ *          38;2;r;g;b      -- 24 bit color
+ *    and the ITU T.416 form with ':' between the sub args:
+ *          38:5:n
+ *          38:2::r:g:b     -- The empty arg is the color space ID (ignored)
+ *          38:2:r:g:b
+ *
+ *    The 256 color palette is the 16 system colors followed by a 6x6x6 color
+ *    cube and then a 24 step gray ramp.
+ *
+ * RETURNS:
+ *    true -- 'RetColor' has been set
+ *    false -- The color wasn't valid.  'Index' has still been moved past
+ *             the args so they are not taken as more SGR's.
+ *
+ * SEE ALSO:
+ *    ANSIX364Decoder_HandleSGR()
+ ******************************************************************************/
+static bool ANSIX364Decoder_GetExtColor(struct ANSIX364DecoderData *Data,
+        unsigned int *Index,uint32_t *RetColor)
+{
+    static const uint8_t CubeLevels[6]={0x00,0x5F,0x87,0xAF,0xD7,0xFF};
+    unsigned int Start;
+    unsigned int Count;
+    const int *Args;
+    int Red;
+    int Green;
+    int Blue;
+    int Pal;
+
+    Red=0;
+    Green=0;
+    Blue=0;
+
+    Start=*Index+1;
+    if(ANSIX364_IS_SUBARG(Data,Start))
+    {
+        /* The args are ':' sub args, only take those */
+        Count=0;
+        while(ANSIX364_IS_SUBARG(Data,Start+Count))
+            Count++;
+        *Index=Start+Count-1;
+        Args=&Data->CSIArg[Start];
+        if(Args[0]==5 && Count>=2)
+        {
+            Pal=Args[1];
+        }
+        else if(Args[0]==2 && Count>=5)
+        {
+            Red=Args[2];
+            Green=Args[3];
+            Blue=Args[4];
+            Pal=-1;
+        }
+        else if(Args[0]==2 && Count==4)
+        {
+            Red=Args[1];
+            Green=Args[2];
+            Blue=Args[3];
+            Pal=-1;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    else
+    {
+        Count=Data->CSIArgCount-Start;
+        Args=&Data->CSIArg[Start];
+        if(Count>=2 && Args[0]==5)
+        {
+            Pal=Args[1];
+            *Index=Start+1;
+        }
+        else if(Count>=4 && Args[0]==2)
+        {
+            Red=Args[1];
+            Green=Args[2];
+            Blue=Args[3];
+            Pal=-1;
+            *Index=Start+3;
+        }
+        else
+        {
+            /* We don't know how many args this takes, so eat the rest */
+            *Index=Data->CSIArgCount-1;
+            return false;
+        }
+    }
+
+    if(Pal>=0)
+    {
+        if(Pal<8)
+        {
+            *RetColor=m_DPS->GetSysColor(e_SysColShade_Normal,Pal);
+            return true;
+        }
+        if(Pal<16)
+        {
+            *RetColor=m_DPS->GetSysColor(e_SysColShade_Bright,Pal-8);
+            return true;
+        }
+        if(Pal<232)
+        {
+            Pal-=16;
+            *RetColor=(CubeLevels[Pal/36]<<16) | (CubeLevels[(Pal/6)%6]<<8) |
+                    CubeLevels[Pal%6];
+            return true;
+        }
+        if(Pal<256)
+        {
+            Red=8+(Pal-232)*10;
+            *RetColor=(Red<<16) | (Red<<8) | Red;
+            return true;
+        }
+        return false;
+    }
+
+    if(Red>255)
+        Red=255;
+    if(Green>255)
+        Green=255;
+    if(Blue>255)
+        Blue=255;
+    *RetColor=(Red<<16) | (Green<<8) | Blue;
+
+    return true;
 }
 
 /*******************************************************************************
@@ -1885,14 +2461,15 @@ void ANSIX364Decoder_ResetSGR(struct ANSIX364DecoderData *Data)
 {
     Data->DoingDim=false;
     Data->DoingBright=false;
+    Data->ULineColorSet=false;
 }
 
 /*******************************************************************************
  * NAME:
- *    ANSIX364Decoder_ProcessESC
+ *    ANSIX364Decoder_DoESCCommand
  *
  * SYNOPSIS:
- *    void ANSIX364Decoder_ProcessESC(struct ANSIX364DecoderData *Data,
+ *    void ANSIX364Decoder_DoESCCommand(struct ANSIX364DecoderData *Data,
  *          const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
  *          PG_BOOL *Consumed);
  *
@@ -1909,8 +2486,9 @@ void ANSIX364Decoder_ResetSGR(struct ANSIX364DecoderData *Data)
  *                      screen.
  *
  * FUNCTION:
- *    This function handles when we are 'ESC' mode.  We have just seen an
- *    ESC and we are trying to decide what to with the first byte after it.
+ *    This function does an ESC command.  We have just seen an ESC and this
+ *    is the byte after it.  The bytes that start a longer sequence (CSI,
+ *    strings, etc) are handled by the transition table and don't get here.
  *
  * RETURNS:
  *    NONE
@@ -1918,24 +2496,17 @@ void ANSIX364Decoder_ResetSGR(struct ANSIX364DecoderData *Data)
  * SEE ALSO:
  *    ANSIX364Decoder_ProcessIncomingTextByte()
  ******************************************************************************/
-void ANSIX364Decoder_ProcessESC(struct ANSIX364DecoderData *Data,
+void ANSIX364Decoder_DoESCCommand(struct ANSIX364DecoderData *Data,
         const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
         PG_BOOL *Consumed)
 {
     int32_t NewPos;
     int32_t CursorX,CursorY;
 
-    *Consumed=true;
-
     // https://en.wikipedia.org/wiki/C0_and_C1_control_codes
     // https://www.gnu.org/software/screen/manual/html_node/Control-Sequences.html
     switch(RawByte)
     {
-        case 27:    // ESC
-            /* Pass it along */
-            *Consumed=false;
-        break;
-
         /* We don't support these (or they are not defined) */
         case '0':   // 
         case '1':   // 
@@ -1969,7 +2540,6 @@ void ANSIX364Decoder_ProcessESC(struct ANSIX364DecoderData *Data,
         case 'W':   // EPA  End of Protected Area
         case 'Y':   // Single Graphic Character Introducer
         case 'Z':   // SCI  Single Character Introducer
-        case '\\':  // ST  String Terminator
         case '`':   // DMI  DISABLE MANUAL INPUT
         case 'a':   // INT  INTERRUPT
         case 'b':   // EMI  ENABLE MANUAL INPUT
@@ -2011,23 +2581,13 @@ void ANSIX364Decoder_ProcessESC(struct ANSIX364DecoderData *Data,
 #endif
         break;
         case '7':   // Save Cursor and Attributes
-            m_DPS->GetCursorXY(&Data->SavedCursorAttribs.SavedCursorX,
-                    &Data->SavedCursorAttribs.SavedCursorY);
-            Data->SavedCursorAttribs.SavedFGColor=m_DPS->GetFGColor();
-            Data->SavedCursorAttribs.SavedBGColor=m_DPS->GetBGColor();
-            Data->SavedCursorAttribs.SavedAttribs=m_DPS->GetAttribs();
-            Data->SavedCursorAttribs.SavedULineColor=m_DPS->GetULineColor();
+            ANSIX364Decoder_SaveCursor(Data);
         break;
         case '8':   // Restore Cursor and Attributes
-            m_DPS->SetCursorXY(Data->SavedCursorAttribs.SavedCursorX,
-                    Data->SavedCursorAttribs.SavedCursorY);
-            m_DPS->SetFGColor(Data->SavedCursorAttribs.SavedFGColor);
-            m_DPS->SetBGColor(Data->SavedCursorAttribs.SavedBGColor);
-            m_DPS->SetAttribs(Data->SavedCursorAttribs.SavedAttribs);
-            m_DPS->SetULineColor(Data->SavedCursorAttribs.SavedULineColor);
+            ANSIX364Decoder_RestoreCursor(Data);
         break;
-        case '?':   // Question mark mode (private commands)
-            Data->CurrentMode=e_ESCState_Search4Exit;
+        case '\\':  // ST  String Terminator
+            /* End of a string we skipped */
         break;
         case 'D':   // Index
             m_DPS->DoNewLine();
@@ -2041,31 +2601,18 @@ void ANSIX364Decoder_ProcessESC(struct ANSIX364DecoderData *Data,
         break;
         case 'M':   // RI  Reverse Line Feed Reverse Index
             m_DPS->GetCursorXY(&CursorX,&CursorY);
+            if(CursorY==Data->ScrollTop)
+            {
+                /* On the top margin, scroll the region down */
+                m_DPS->DoScrollArea(0,Data->ScrollTop,-1,
+                        Data->ScrollBottom!=0?Data->ScrollBottom:-1,0,1);
+                break;
+            }
             NewPos=CursorY-1;
             if(NewPos<0)
                 NewPos=0;
             m_DPS->SetCursorXY(CursorX,NewPos);
         break;
-        case 'P':   // DCS  Device Control String
-            Data->SearchAbortCount=0;
-            Data->SearchIndex=0;
-            Data->CurrentMode=e_ESCState_Search4ST;
-        break;
-        case 'X':   // SOS  Start of String
-            Data->SearchAbortCount=0;
-            Data->SearchIndex=0;
-            Data->CurrentMode=e_ESCState_Search4ST;
-        break;
-        case '[':   // CSI  Control Sequence Introducer (CSI)
-            Data->CurrentMode=e_ESCState_CSI;
-        break;
-        case ']':   // OSC  Operating System Command
-        case '^':   // PM  Privacy Message
-        case '_':   // APC  Application Program Command
-            Data->SearchAbortCount=0;
-            Data->SearchIndex=0;
-            Data->CurrentMode=e_ESCState_Search4ST;
-        break;
         case 'c':   // RIS  RESET TO INITIAL STATE
             ANSIX364Decoder_DefaultData(Data);
 
@@ -2074,6 +2621,8 @@ void ANSIX364Decoder_ProcessESC(struct ANSIX364DecoderData *Data,
             m_DPS->SetAttribs(0);
             m_DPS->SetULineColor(m_DPS->GetSysDefaultColor(e_DefaultColors_FG));
 
+            m_DPS->DoSetAltScreen(false);
+            m_DPS->DoSetScrollRegion(0,0);
             m_DPS->DoClearScreen();
             m_DPS->DoClearScreenAndBackBuffer();
         break;
@@ -2084,85 +2633,17 @@ void ANSIX364Decoder_ProcessESC(struct ANSIX364DecoderData *Data,
             /* Not supported */
         break;
 
+        /* These are done by the transition table */
+        case '?':   // Question mark mode (private commands)
+        case 'P':   // DCS  Device Control String
+        case 'X':   // SOS  Start of String
+        case '[':   // CSI  Control Sequence Introducer (CSI)
+        case ']':   // OSC  Operating System Command
+        case '^':   // PM  Privacy Message
+        case '_':   // APC  Application Program Command
         default:
         break;
     }
-
-    /* If we are still in the ESC mode then switch back to normal */
-    if(Data->CurrentMode==e_ESCState_ESC)
-        Data->CurrentMode=e_ESCState_Normal;
-}
-
-/*******************************************************************************
- * NAME:
- *    ANSIX364Decoder_ProcessCSIQuest
- *
- * SYNOPSIS:
- *    void ANSIX364Decoder_ProcessCSIQuest(struct ANSIX364DecoderData *Data,
- *          const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
- *          PG_BOOL *Consumed);
- *
- * PARAMETERS:
- *    Data [I] -- Our internal data.
- *    RawByte [I] -- The raw byte to process.  This is the byte that came in.
- *    ProcessedChar [I/O] -- This is a unicode char that has already been
- *                         processed by some of the other input filters.  You
- *                         can change this as you need.  It must remain only
- *                         one unicode char.
- *    CharLen [I/O] -- This number of bytes in 'ProcessedChar'
- *    Consumed [I/O] -- This tells the system (and other filters) if the
- *                      char has been used up and will not be added to the
- *                      screen.
- *
- * FUNCTION:
- *    This function handles when we are 'CSI' question mark mode (private
- *    parameter string).
- *
- * RETURNS:
- *    NONE
- *
- * SEE ALSO:
- *    ANSIX364Decoder_ProcessIncomingTextByte()
- ******************************************************************************/
-void ANSIX364Decoder_ProcessCSIQuest(struct ANSIX364DecoderData *Data,
-        const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
-        PG_BOOL *Consumed)
-{
-    *Consumed=true;
-
-    switch(RawByte)
-    {
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-            /* Add to the number */
-            Data->CurrentNum*=10;
-            Data->CurrentNum+=RawByte-'0';
-        break;
-        case ':':   // Sub arg...
-        case ';':   // Next arg
-            /* Next arg */
-            if(Data->CSIArgCount<sizeof(Data->CSIArg)/sizeof(int))
-                Data->CSIArg[Data->CSIArgCount++]=Data->CurrentNum;
-            Data->CurrentNum=0;
-        break;
-        default:
-            /* This is the end of the command */
-            if(Data->CSIArgCount<sizeof(Data->CSIArg)/sizeof(int))
-                Data->CSIArg[Data->CSIArgCount++]=Data->CurrentNum;
-
-            ANSIX364Decoder_DoCSIQuestCommand(Data,RawByte,ProcessedChar,
-                    CharLen,Consumed);
-            Data->CurrentMode=e_ESCState_Normal;
-        break;
-    }
 }
 
 /*******************************************************************************
@@ -2194,15 +2675,38 @@ void ANSIX364Decoder_DoCSIQuestCommand(struct ANSIX364DecoderData *Data,
         const uint8_t RawByte,uint8_t *ProcessedChar,int *CharLen,
         PG_BOOL *Consumed)
 {
+    unsigned int r;
+    bool Set;
+
     switch(RawByte)
     {
         case 'l':   // Reset
-//            switch(Data->CurrentNum)
-//            {
-//                case 
-//            }
-        break;
         case 'h':   // Set
+            Set=(RawByte=='h');
+            for(r=0;r<Data->CSIArgCount;r++)
+            {
+                switch(Data->CSIArg[r])
+                {
+                    case 47:    // Alternate screen
+                    case 1047:  // Alternate screen (cleared on the way out)
+                        m_DPS->DoSetAltScreen(Set);
+                    break;
+                    case 1049:  // Save cursor and use the alternate screen
+                        if(Set)
+                        {
+                            ANSIX364Decoder_SaveCursor(Data);
+                            m_DPS->DoSetAltScreen(true);
+                        }
+                        else
+                        {
+                            m_DPS->DoSetAltScreen(false);
+                            ANSIX364Decoder_RestoreCursor(Data);
+                        }
+                    break;
+                    default:
+                    break;
+                }
+            }
         break;
         default:
 #ifdef LOG_UNKNOWN_CODES
@@ -50,6 +50,7 @@ using namespace std;
 #define MAX_START_WAIT_TIME                 90  // You have 90 seconds for the rx to startup
 #define XMODEM_MAX_NAKS                     5   // Number of nak's that will abort the tran
 #define MAX_PACKET_WAIT_TIME                30  // How long do we wait with no after the last packet before we abort
+#define XMODEM_READAHEAD_SIZE               (64*1024)   // How much of the file we read at a time when uploading
 
 #define XMODEM_DOWNLOAD_START_TIMEOUT       10  // 10 seconds between start chars
 #define XMODEM_DOWNLOAD_START_TRYS_BEFORE_FALLBACK          5   // How many times do we try starting the download before we switch from CRC to Checksum
@@ -99,9 +100,29 @@ EOT                                     -->
                                         <-- ACK
 */
 
-struct XModemUploadData
+/* We read the file in big chunks instead of seeking and reading every block */
+struct XModemReadAhead
 {
     FILE *FileHandle;
+    uint8_t *Buffer;            // XMODEM_READAHEAD_SIZE bytes
+    uint32_t Pos;               // Next byte to hand out
+    uint32_t Len;               // Bytes in 'Buffer'
+    bool EndOfFile;
+};
+
+struct XModemTxPacket
+{
+    uint8_t Packet[XMODEM_MAX_PACKET_SIZE];
+    int Size;                   // Bytes in 'Packet' (with header and CRC)
+    int DataBytes;              // Bytes from the file (0 = end of file)
+};
+
+struct XModemUploadData
+{
+    struct XModemReadAhead Reader;
+    struct XModemTxPacket TxPacket[2];  // On the wire and the next one
+    bool PacketReady[2];
+    int CurPacket;              // The 'TxPacket' for 'PacketNum'
     uint32_t PacketNum;
     uint8_t PaddingChar;
     int BlockSize;
@@ -180,6 +201,13 @@ static bool XModem_AllocCommonWidgets(struct XModem_Widgets *Widgets,
         t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options);
 static void XModem_FreeCommonWidgets(struct XModem_Widgets *Widgets);
 static bool XModem_StoreCommonWidgetsOptions(struct XModem_Widgets *Widgets,t_PIKVList *Options);
+static bool XModem_ReadAheadOpen(struct XModemReadAhead *Reader,
+        const char *Filename);
+static void XModem_ReadAheadClose(struct XModemReadAhead *Reader);
+static int XModem_ReadAheadGet(struct XModemReadAhead *Reader,uint8_t *Dest,
+        int Bytes);
+static void XModemUpload_BuildPacket(struct XModemUploadData *Data,
+        int Index,uint32_t PacketNum);
 
 t_FTPHandlerDataType *XModemUpload_AllocateData(void);
 void XModemUpload_FreeData(t_FTPHandlerDataType *DataHandle);
@@ -420,6 +448,138 @@ static uint8_t XModem_CalcChecksum(uint8_t *DataPtr,int Bytes)
     return csum;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    XModem_ReadAheadOpen
+ *
+ * SYNOPSIS:
+ *    static bool XModem_ReadAheadOpen(struct XModemReadAhead *Reader,
+ *          const char *Filename);
+ *
+ * PARAMETERS:
+ *    Reader [O] -- The reader to setup
+ *    Filename [I] -- The file to open
+ *
+ * FUNCTION:
+ *    This function opens a file for reading in big chunks.  Blocks are then
+ *    taken out of the memory buffer with XModem_ReadAheadGet() so we don't
+ *    go to the disk for every packet.
+ *
+ * RETURNS:
+ *    true -- The file is open
+ *    false -- We couldn't open the file or get memory for the buffer
+ *
+ * SEE ALSO:
+ *    XModem_ReadAheadGet(), XModem_ReadAheadClose()
+ ******************************************************************************/
+static bool XModem_ReadAheadOpen(struct XModemReadAhead *Reader,
+        const char *Filename)
+{
+    Reader->Pos=0;
+    Reader->Len=0;
+    Reader->EndOfFile=false;
+
+    Reader->Buffer=(uint8_t *)malloc(XMODEM_READAHEAD_SIZE);
+    if(Reader->Buffer==NULL)
+        return false;
+
+    Reader->FileHandle=fopen(Filename,"rb");
+    if(Reader->FileHandle==NULL)
+    {
+        free(Reader->Buffer);
+        Reader->Buffer=NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    XModem_ReadAheadClose
+ *
+ * SYNOPSIS:
+ *    static void XModem_ReadAheadClose(struct XModemReadAhead *Reader);
+ *
+ * PARAMETERS:
+ *    Reader [I] -- The reader to close
+ *
+ * FUNCTION:
+ *    This function closes the file and frees the buffer.  It is safe to call
+ *    this on a reader that is already closed.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    XModem_ReadAheadOpen()
+ ******************************************************************************/
+static void XModem_ReadAheadClose(struct XModemReadAhead *Reader)
+{
+    if(Reader->FileHandle!=NULL)
+        fclose(Reader->FileHandle);
+    Reader->FileHandle=NULL;
+
+    free(Reader->Buffer);
+    Reader->Buffer=NULL;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    XModem_ReadAheadGet
+ *
+ * SYNOPSIS:
+ *    static int XModem_ReadAheadGet(struct XModemReadAhead *Reader,
+ *          uint8_t *Dest,int Bytes);
+ *
+ * PARAMETERS:
+ *    Reader [I] -- The reader to get bytes from
+ *    Dest [O] -- Where to copy the bytes to
+ *    Bytes [I] -- How many bytes we want (never more than
+ *                 XMODEM_READAHEAD_SIZE)
+ *
+ * FUNCTION:
+ *    This function gets the next bytes from the file.  When the buffer
+ *    doesn't have enough left we move what's left to the front and fill the
+ *    rest from the file with one read.
+ *
+ * RETURNS:
+ *    The number of bytes copied.  This will be less than 'Bytes' at the end
+ *    of the file (or if there was a read error).
+ *
+ * SEE ALSO:
+ *    XModem_ReadAheadOpen()
+ ******************************************************************************/
+static int XModem_ReadAheadGet(struct XModemReadAhead *Reader,uint8_t *Dest,
+        int Bytes)
+{
+    uint32_t Left;
+    size_t Got;
+
+    Left=Reader->Len-Reader->Pos;
+    if(Left<(uint32_t)Bytes && !Reader->EndOfFile)
+    {
+        memmove(Reader->Buffer,&Reader->Buffer[Reader->Pos],Left);
+        Reader->Pos=0;
+        Reader->Len=Left;
+
+        Got=fread(&Reader->Buffer[Left],1,XMODEM_READAHEAD_SIZE-Left,
+                Reader->FileHandle);
+        if(Got<XMODEM_READAHEAD_SIZE-Left)
+            Reader->EndOfFile=true;
+        Reader->Len+=Got;
+        Left=Reader->Len;
+    }
+
+    if(Left>(uint32_t)Bytes)
+        Left=Bytes;
+
+    memcpy(Dest,&Reader->Buffer[Reader->Pos],Left);
+    Reader->Pos+=Left;
+
+    return Left;
+}
+
 /*******************************************************************************
  * NAME:
  *    XModemUpload_AllocateData
@@ -446,7 +606,8 @@ t_FTPHandlerDataType *XModemUpload_AllocateData(void)
     try
     {
         Data=new struct XModemUploadData;
-        Data->FileHandle=NULL;
+        Data->Reader.FileHandle=NULL;
+        Data->Reader.Buffer=NULL;
     }
     catch(...)
     {
@@ -480,8 +641,7 @@ void XModemUpload_FreeData(t_FTPHandlerDataType *DataHandle)
 {
     struct XModemUploadData *Data=(struct XModemUploadData *)DataHandle;
 
-    if(Data->FileHandle!=NULL)
-        fclose(Data->FileHandle);
+    XModem_ReadAheadClose(&Data->Reader);
 
     delete Data;
 }
@@ -1015,6 +1175,9 @@ static PG_BOOL XModemUpload_StartUpload(t_FTPSystemData *SysHandle,
 
     Data->PaddingChar=26;
     Data->PacketNum=0;
+    Data->CurPacket=0;
+    Data->PacketReady[0]=false;
+    Data->PacketReady[1]=false;
     Data->BlockSize=XMODEM_STANDARD_PACKET_SIZE;
     Data->UseCRC=false;
     Data->Waiting4Start=true;
@@ -1054,8 +1217,7 @@ static PG_BOOL XModemUpload_StartUpload(t_FTPSystemData *SysHandle,
     if(Value!=NULL)
         Data->MaxPacketWaitTime=atoi(Value);
 
-    Data->FileHandle=fopen(FilenameWithPath,"rb");
-    if(Data->FileHandle==NULL)
+    if(!XModem_ReadAheadOpen(&Data->Reader,FilenameWithPath))
         return false;
 
     switch(Mode)
@@ -1134,11 +1296,7 @@ static void XModemUpload_AbortUpload(t_FTPSystemData *SysHandle,
     Data->Done=true;
     Data->Aborted=true;
 
-    if(Data->FileHandle!=NULL)
-    {
-        fclose(Data->FileHandle);
-        Data->FileHandle=NULL;
-    }
+    XModem_ReadAheadClose(&Data->Reader);
     Data->ErrorStr="User abort";
 }
 
@@ -1172,13 +1330,10 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
         t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes)
 {
     struct XModemUploadData *Data=(struct XModemUploadData *)DataHandle;
-    int BytesRead;
+    struct XModemTxPacket *Pkt;
     uint32_t b;
-    int SendBlockNum;
+    bool SendBlock;
     uint8_t Block[XMODEM_MAX_PACKET_SIZE];
-    uint16_t CRC;
-    uint8_t csum;
-    int SendSize;
 
     if(Data->Aborted)
     {
@@ -1188,10 +1343,10 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
         return true;
     }
 
-    if(Data->FileHandle==NULL)
+    if(Data->Reader.FileHandle==NULL)
         return false;
 
-    SendBlockNum=-1;    // Don't send anything
+    SendBlock=false;
     for(b=0;b<Bytes;b++)
     {
         if(Data->Waiting4Start)
@@ -1204,7 +1359,7 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
                 {
                     /* Ok, we are ready to start */
                     Data->Waiting4Start=false;
-                    SendBlockNum=Data->PacketNum;
+                    SendBlock=true;
                 }
 
                 if(RxData[b]==XMODEM_NAK)
@@ -1215,7 +1370,7 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
                     Data->BlockSize=XMODEM_STANDARD_PACKET_SIZE;
 
                     Data->Waiting4Start=false;
-                    SendBlockNum=Data->PacketNum;
+                    SendBlock=true;
                 }
             }
             else
@@ -1224,7 +1379,7 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
                 if(RxData[b]==XMODEM_NAK)
                 {
                     Data->Waiting4Start=false;
-                    SendBlockNum=Data->PacketNum;
+                    SendBlock=true;
                 }
             }
         }
@@ -1252,9 +1407,17 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
                 }
                 else
                 {
-                    /* Move to the next block */
+                    /* Move to the next block (normally built while the
+                       last one was on the wire) */
+                    if(!Data->PacketReady[Data->CurPacket^1])
+                    {
+                        XModemUpload_BuildPacket(Data,Data->CurPacket^1,
+                                Data->PacketNum+1);
+                    }
+                    Data->PacketReady[Data->CurPacket]=false;
+                    Data->CurPacket^=1;
                     Data->PacketNum++;
-                    SendBlockNum=Data->PacketNum;
+                    SendBlock=true;
                     Data->NAKCount=0;
 
                     m_FTPS->ULProgress(SysHandle,Data->PacketNum*
@@ -1273,8 +1436,8 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
                 }
                 else
                 {
-                    /* We got nak'ed, resend last block */
-                    SendBlockNum=Data->PacketNum;
+                    /* We got nak'ed, resend the block we still have */
+                    SendBlock=true;
 
                     Data->NAKCount++;
                     if(Data->NAKCount>Data->MaxNaks)
@@ -1291,49 +1454,20 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
         }
     }
 
-    if(SendBlockNum>=0)
+    if(SendBlock)
     {
         Data->LastPacketTimeout=0;
 
-        /* Seek to this packet */
-        fseek(Data->FileHandle,SendBlockNum*Data->BlockSize,SEEK_SET);
+        if(!Data->PacketReady[Data->CurPacket])
+            XModemUpload_BuildPacket(Data,Data->CurPacket,Data->PacketNum);
+        Pkt=&Data->TxPacket[Data->CurPacket];
 
-        SendSize=1;    // Ctrl byte
-        SendSize+=Data->BlockSize;
-        SendSize+=2;    // Packnum
-        if(Data->UseCRC)
-            SendSize+=2;    // CRC16
-        else
-            SendSize+=1;    // checksum
-
-        if(Data->BlockSize==XMODEM_LARGE_PACKET_SIZE)
-            Block[0]=XMODEM_STX;
-        else
-            Block[0]=XMODEM_SOH;
-        Block[1]=(Data->PacketNum+1)&0xFF;
-        Block[2]=~Block[1];
-
-        /* Load this block into the packet */
-        memset(&Block[3],Data->PaddingChar,Data->BlockSize);
-        BytesRead=fread(&Block[3],1,Data->BlockSize,Data->FileHandle);
-
-        if(Data->UseCRC)
+        if(Pkt->DataBytes>0)
         {
-            CRC=XModem_CalcCRC(&Block[3],Data->BlockSize);
-            Block[3+Data->BlockSize+0]=CRC>>8;
-            Block[3+Data->BlockSize+1]=CRC&0xFF;
-        }
-        else
-        {
-            csum=XModem_CalcChecksum(&Block[3],Data->BlockSize);
-            Block[3+Data->BlockSize+0]=csum;
-        }
-        if(BytesRead>0)
-        {
-            switch(m_FTPS->ULSendData(SysHandle,Block,SendSize))
+            switch(m_FTPS->ULSendData(SysHandle,Pkt->Packet,Pkt->Size))
             {
                 case e_FTPS_SendDataRet_Success:
-                    if(BytesRead<Data->BlockSize)
+                    if(Pkt->DataBytes<Data->BlockSize)
                     {
                         /* Ok, we are done */
                         Data->Done=true;
@@ -1350,8 +1484,15 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
                     /* Wait for the rx to timeout and nak */
                 break;
             }
+
+            /* Get the next block ready while we wait for the ACK */
+            if(!Data->Done && !Data->PacketReady[Data->CurPacket^1])
+            {
+                XModemUpload_BuildPacket(Data,Data->CurPacket^1,
+                        Data->PacketNum+1);
+            }
         }
-        else if(BytesRead==0)
+        else
         {
             /* We are done */
             Data->Done=true;
@@ -1365,6 +1506,78 @@ static PG_BOOL XModemUpload_RxData(t_FTPSystemData *SysHandle,
     return true;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    XModemUpload_BuildPacket
+ *
+ * SYNOPSIS:
+ *    static void XModemUpload_BuildPacket(struct XModemUploadData *Data,
+ *          int Index,uint32_t PacketNum);
+ *
+ * PARAMETERS:
+ *    Data [I] -- The upload data
+ *    Index [I] -- Which of the 'TxPacket' buffers to build into
+ *    PacketNum [I] -- The packet we are building (0 = first packet)
+ *
+ * FUNCTION:
+ *    This function takes the next block from the file and builds the packet
+ *    for it (header, padding, and checksum / CRC).  The packet is kept
+ *    until it is ACK'ed so a NAK can resend it without going back to the
+ *    file.
+ *
+ *    Packets must be built in order because this reads the file in order.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    XModem_ReadAheadGet()
+ ******************************************************************************/
+static void XModemUpload_BuildPacket(struct XModemUploadData *Data,
+        int Index,uint32_t PacketNum)
+{
+    struct XModemTxPacket *Pkt;
+    uint8_t *Block;
+    uint16_t CRC;
+
+    Pkt=&Data->TxPacket[Index];
+    Block=Pkt->Packet;
+
+    Pkt->Size=1;        // Ctrl byte
+    Pkt->Size+=2;       // Packnum
+    Pkt->Size+=Data->BlockSize;
+    if(Data->UseCRC)
+        Pkt->Size+=2;   // CRC16
+    else
+        Pkt->Size+=1;   // checksum
+
+    if(Data->BlockSize==XMODEM_LARGE_PACKET_SIZE)
+        Block[0]=XMODEM_STX;
+    else
+        Block[0]=XMODEM_SOH;
+    Block[1]=(PacketNum+1)&0xFF;
+    Block[2]=~Block[1];
+
+    /* Load this block into the packet */
+    memset(&Block[3],Data->PaddingChar,Data->BlockSize);
+    Pkt->DataBytes=XModem_ReadAheadGet(&Data->Reader,&Block[3],
+            Data->BlockSize);
+
+    if(Data->UseCRC)
+    {
+        CRC=XModem_CalcCRC(&Block[3],Data->BlockSize);
+        Block[3+Data->BlockSize+0]=CRC>>8;
+        Block[3+Data->BlockSize+1]=CRC&0xFF;
+    }
+    else
+    {
+        Block[3+Data->BlockSize+0]=XModem_CalcChecksum(&Block[3],
+                Data->BlockSize);
+    }
+
+    Data->PacketReady[Index]=true;
+}
+
 /*******************************************************************************
  * NAME:
  *    XModemUpload_Timeout
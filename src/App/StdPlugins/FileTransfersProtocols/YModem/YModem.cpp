@@ -0,0 +1,2709 @@
+/*******************************************************************************
+ * FILENAME: YModem.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This is the driver for a YModem / YModem-G transfer (up and down).
+ *
+ *    YModem is XModem-1K with a block 0 in front of each file that has the
+ *    filename and size in it.  YModem-G is the same thing without any ACK's
+ *    for the data blocks so the sender streams the file at line rate (any
+ *    error aborts the transfer).
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "YModem.h"
+#include "PluginSDK/Plugin.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <string>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define REGISTER_PLUGIN_FUNCTION_PRIV_NAME      YModem // The name to append on the RegisterPlugin() function for built in version
+#define NEEDED_MIN_API_VERSION                  0x02020000
+
+#define YMODEM_MAX_PACKET_SIZE              (3+1024+2)
+#define YMODEM_STANDARD_PACKET_SIZE         128
+#define YMODEM_LARGE_PACKET_SIZE            1024
+#define YMODEM_READAHEAD_SIZE               (64*1024)   // How much of the file we read at a time
+#define MAX_START_WAIT_TIME                 90  // You have 90 seconds for the rx to startup
+#define YMODEM_MAX_NAKS                     5   // Number of nak's that will abort the tran
+#define MAX_PACKET_WAIT_TIME                30  // How long do we wait with no after the last packet before we abort
+
+#define YMODEM_TICK_MS                      1000    // Normal timeout tick
+#define YMODEM_STREAM_TICK_MS               10      // Tick while we are feeding the driver
+#define YMODEM_STREAM_BURST                 64      // Most packets we queue per tick
+#define YMODEM_CAN_COUNT                    8       // How many CAN's we send to abort
+
+#define YMODEM_DOWNLOAD_START_TIMEOUT       10  // 10 seconds between start chars
+#define YMODEM_DOWNLOAD_WAIT4QUIET_TIMEOUT  2   // 2 seconds
+
+#define YMODEM_SOH                  1
+#define YMODEM_STX                  2
+#define YMODEM_EOT                  4
+#define YMODEM_ACK                  6
+#define YMODEM_NAK                  21
+#define YMODEM_CAN                  24
+#define YMODEM_CPMEOF               26
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+typedef enum
+{
+    /* DO NOT REMOVE / REORDER THIS LIST.  They are stored to disk */
+    e_YModemMode_YModem         =0,
+    e_YModemMode_YModemG        =1,
+    e_YModemModeMAX
+} e_YModemModeType;
+
+/* YModem in a nut shell:
+SENDER                                      RECEIVER
+                                        <-- C (G for YModem-G)
+SOH 00 FF foo.c NUL 1234 NUL[..] CRC CRC -->
+                                        <-- ACK (not sent for YModem-G)
+                                        <-- C (G for YModem-G)
+STX 01 FE Data[1024] CRC CRC            -->
+                                        <-- ACK (not sent for YModem-G)
+SOH 02 FD Data[210] CPMEOF[..] CRC CRC  -->
+                                        <-- ACK (not sent for YModem-G)
+EOT                                     -->
+                                        <-- NAK (not sent for YModem-G)
+EOT                                     -->
+                                        <-- ACK
+                                        <-- C (G for YModem-G)
+SOH 00 FF NUL[128] CRC CRC              -->
+                                        <-- ACK (not sent for YModem-G)
+*/
+
+/* We read the file in big chunks instead of seeking and reading every block */
+struct YModemReadAhead
+{
+    FILE *FileHandle;
+    uint8_t *Buffer;            // YMODEM_READAHEAD_SIZE bytes
+    uint32_t Pos;               // Next byte to hand out
+    uint32_t Len;               // Bytes in 'Buffer'
+    bool EndOfFile;
+};
+
+struct YModemTxPacket
+{
+    uint8_t Packet[YMODEM_MAX_PACKET_SIZE];
+    int Size;                   // Bytes in 'Packet' (with header and CRC)
+    int DataBytes;              // Bytes from the file (0 = end of file)
+};
+
+typedef enum
+{
+    e_YModemUpload_Waiting4Start,       // Want 'C' / 'G' for the header
+    e_YModemUpload_Waiting4HeaderAck,
+    e_YModemUpload_Waiting4DataStart,   // Want 'C' / 'G' for the data
+    e_YModemUpload_Sending,
+    e_YModemUpload_Waiting4EOTAck,
+    e_YModemUpload_Waiting4EndStart,    // Want 'C' / 'G' for the end of batch
+    e_YModemUpload_Waiting4EndAck,
+    e_YModemUploadMAX
+} e_YModemUploadType;
+
+struct YModemUploadData
+{
+    struct YModemReadAhead Reader;
+    struct YModemTxPacket TxPacket[2];  // On the wire and the next one
+    bool PacketReady[2];
+    int CurPacket;              // The 'TxPacket' for 'PacketNum'
+    uint32_t PacketNum;
+    uint64_t BytesSent;         // File bytes that have been ACK'ed / streamed
+    string Filename;            // Without the path
+    uint64_t FileSize;
+    e_YModemUploadType State;
+    bool Streaming;             // YModem-G
+    bool SendPending;           // The driver was busy, retry on the next tick
+    uint32_t TickMS;
+    uint32_t IdleMS;            // Time since we last heard from the rx
+    int NAKCount;
+    int CANCount;
+    int MaxStartWaitTime;
+    int MaxNaks;
+    int MaxPacketWaitTime;
+    string ErrorStr;
+};
+
+typedef enum
+{
+    e_YModemDownload_StartOfHeader,
+    e_YModemDownload_PacketNum,
+    e_YModemDownload_InvPacketNum,
+    e_YModemDownload_Data,
+    e_YModemDownload_CRC1,
+    e_YModemDownload_CRC2,
+    e_YModemDownloadMAX
+} e_YModemDownloadType;
+
+struct YModemDownloadData
+{
+    FILE *FileHandle;
+    string FirstFilename;       // What the user picked, the first file goes here
+    string SaveDir;             // The rest of the batch goes here
+    int FilesDone;
+    bool Streaming;             // YModem-G
+    bool Waiting4Header;        // Next packet should be block 0
+    uint8_t PacketNum;          // The packet we want next
+    bool FileSizeKnown;
+    uint64_t FileSize;
+    uint64_t FileBytes;         // Bytes written to this file
+    uint64_t BytesRx;           // Bytes written for the whole batch
+    e_YModemDownloadType DownloadState;
+    uint8_t RxPacketNum;
+    bool BadPacket;
+    uint16_t RxCRC;
+    int ByteCount;
+    int ExpectedByteCount;
+    uint8_t RxBlock[YMODEM_LARGE_PACKET_SIZE];
+    int EOTCount;
+    int CANCount;
+    bool GotFirstHeader;
+    int StartTimeout;
+    int TimeSinceLastStartChar;
+    int LastByteTimeout;
+    int LastPacketTimeout;
+    int MaxStartWaitTime;
+    int MaxPacketWaitTime;
+    string ErrorStr;
+};
+
+struct YModem_Widgets
+{
+    t_WidgetSysHandle *WidgetHandle;
+    struct PI_RadioBttnGroup *ModeGroup;
+    struct PI_RadioBttn *ModeBttnYModem;
+    struct PI_RadioBttn *ModeBttnYModemG;
+    struct PI_NumberInput *MaxStartWaitTime;
+    struct PI_NumberInput *MaxNAKPackets;
+    struct PI_NumberInput *PacketTimeOut;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+static uint16_t YModem_CalcCRC(uint8_t *DataPtr,int Bytes);
+static bool YModem_ReadAheadOpen(struct YModemReadAhead *Reader,
+        const char *Filename);
+static void YModem_ReadAheadClose(struct YModemReadAhead *Reader);
+static int YModem_ReadAheadGet(struct YModemReadAhead *Reader,uint8_t *Dest,
+        int Bytes);
+static void YModem_FinishPacket(struct YModemTxPacket *Pkt,uint8_t PacketNum,
+        int BlockSize);
+static t_FTPOptionsWidgetsType *YModem_AllocWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options,bool Download);
+static void YModem_FreeWidgets(t_FTPOptionsWidgetsType *FTPOptions);
+static void YModem_StoreWidgets(t_FTPOptionsWidgetsType *FTPOptions,
+        t_PIKVList *Options);
+static void YModem_ReadCommonOptions(t_PIKVList *Options,int *MaxStartWaitTime,
+        int *MaxNaks,int *MaxPacketWaitTime);
+
+static t_FTPHandlerDataType *YModemUpload_AllocateData(void);
+static void YModemUpload_FreeData(t_FTPHandlerDataType *DataHandle);
+static t_FTPOptionsWidgetsType *YModemUpload_AllocOptionsWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options);
+static PG_BOOL YModemUpload_StartUpload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,const char *FilenameWithPath,
+        const char *FilenameOnly,uint64_t FileSize,t_PIKVList *Options);
+static void YModemUpload_AbortUpload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static void YModemUpload_Timeout(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static PG_BOOL YModemUpload_RxData(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes);
+static const char *YModemUpload_GetLastErrorMsg(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static PG_BOOL YModemUpload_Init(t_FTPSystemData *SysHandle);
+static void YModemUpload_BuildHeader(struct YModemUploadData *Data,
+        bool EndOfBatch);
+static void YModemUpload_BuildPacket(struct YModemUploadData *Data,int Index,
+        uint32_t PacketNum);
+static void YModemUpload_BuildEOT(struct YModemUploadData *Data);
+static void YModemUpload_SetTick(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data,uint32_t MSec);
+static bool YModemUpload_SendCurrent(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data);
+static bool YModemUpload_NextPacket(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data);
+static bool YModemUpload_Stream(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data);
+static void YModemUpload_Fail(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data,const char *Msg);
+
+static t_FTPHandlerDataType *YModemDownload_AllocateData(void);
+static void YModemDownload_FreeData(t_FTPHandlerDataType *DataHandle);
+static t_FTPOptionsWidgetsType *YModemDownload_AllocOptionsWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options);
+static PG_BOOL YModemDownload_StartDownload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,t_PIKVList *Options);
+static void YModemDownload_AbortDownload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static void YModemDownload_Timeout(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static PG_BOOL YModemDownload_RxData(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes);
+static const char *YModemDownload_GetLastErrorMsg(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static PG_BOOL YModemDownload_Init(t_FTPSystemData *SysHandle);
+static bool YModemDownload_ProcessPacket(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data);
+static bool YModemDownload_ProcessHeader(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data);
+static bool YModemDownload_ProcessEOT(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data);
+static void YModemDownload_SendByte(t_FTPSystemData *SysHandle,uint8_t c);
+static void YModemDownload_SendStart(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data);
+static void YModemDownload_Fail(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data,const char *Msg);
+
+/*** VARIABLE DEFINITIONS     ***/
+struct FileTransferHandlerAPI m_YModemUploadCBs=
+{
+    YModemUpload_AllocateData,
+    YModemUpload_FreeData,
+    YModemUpload_AllocOptionsWidgets,
+    YModem_FreeWidgets,
+    YModem_StoreWidgets,
+    YModemUpload_StartUpload,
+    NULL,
+    YModemUpload_AbortUpload,
+    YModemUpload_Timeout,
+    YModemUpload_RxData,
+
+    /* V2 */
+    YModemUpload_GetLastErrorMsg,
+
+    /* V3 */
+    YModemUpload_Init,
+    NULL
+
+    /* If you add more remember to add to update 'm_YModemUpload_Info' to the
+       new version */
+};
+struct FTPHandlerInfo m_YModemUpload_Info=
+{
+    "YModemUpload",
+    "YModem",
+    "Sends a file using YModem or YModem-G.",
+    "Sends a file using YModem.  If the receiver asks for YModem-G the "
+            "file is streamed without waiting for ACK's.",
+    FILE_TRANSFER_HANDLER_API_VERSION_3,
+    FTPS_API_VERSION_2,
+    &m_YModemUploadCBs,
+    e_FileTransferProtocolMode_Upload
+};
+
+struct FileTransferHandlerAPI m_YModemDownloadCBs=
+{
+    YModemDownload_AllocateData,
+    YModemDownload_FreeData,
+    YModemDownload_AllocOptionsWidgets,
+    YModem_FreeWidgets,
+    YModem_StoreWidgets,
+    NULL,
+    YModemDownload_StartDownload,
+    YModemDownload_AbortDownload,
+    YModemDownload_Timeout,
+    YModemDownload_RxData,
+
+    /* V2 */
+    YModemDownload_GetLastErrorMsg,
+
+    /* V3 */
+    YModemDownload_Init,
+    NULL
+
+    /* If you add more remember to add to update 'm_YModemDownload_Info' to
+       the new version */
+};
+struct FTPHandlerInfo m_YModemDownload_Info=
+{
+    "YModemDownload",
+    "YModem",
+    "Receive a file using YModem or YModem-G.",
+    "Receive a batch of files using YModem or YModem-G.  The first file is "
+            "saved to the filename you pick, any others are saved next to "
+            "it using the names the sender gives.",
+    FILE_TRANSFER_HANDLER_API_VERSION_3,
+    FTPS_API_VERSION_2,
+    &m_YModemDownloadCBs,
+    e_FileTransferProtocolMode_Download,
+};
+
+static const struct PI_UIAPI *m_UIAPI;
+static const struct PI_SystemAPI *m_System;
+static const struct FTPS_API *m_FTPS;
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_RegisterPlugin
+ *
+ * SYNOPSIS:
+ *    unsigned int YModem_RegisterPlugin(const struct PI_SystemAPI *SysAPI,
+ *          unsigned int Version);
+ *
+ * PARAMETERS:
+ *    SysAPI [I] -- The main API to WhippyTerm
+ *    Version [I] -- What version of WhippyTerm is running.  This is used
+ *                   to make sure we are compatible.  This is in the
+ *                   Major<<24 | Minor<<16 | Rev<<8 | Patch format
+ *
+ * FUNCTION:
+ *    This function registers this plugin with the system.
+ *
+ * RETURNS:
+ *    0 if we support this version of WhippyTerm, and the minimum version
+ *    we need if we are not.
+ *
+ * NOTES:
+ *    This function is normally is called from the RegisterPlugin() when
+ *    it is being used as a normal plugin.  As a std plugin it is called
+ *    from RegisterStdPlugins() instead.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+/* This needs to be extern "C" because it is the main entry point for the
+   plugin system */
+extern "C"
+{
+    unsigned int REGISTER_PLUGIN_FUNCTION(const struct PI_SystemAPI *SysAPI,
+            unsigned int Version)
+    {
+        if(Version<NEEDED_MIN_API_VERSION)
+            return NEEDED_MIN_API_VERSION;
+
+        m_System=SysAPI;
+        m_FTPS=SysAPI->GetAPI_FileTransfersProtocol();
+        m_UIAPI=m_FTPS->GetAPI_UI();
+
+        /* If we are have the correct experimental API */
+        if(m_System->GetExperimentalID()>0 &&
+                m_System->GetExperimentalID()<1)
+        {
+            return 0xFFFFFFFF;
+        }
+
+        m_FTPS->RegisterFileTransferProtocol(&m_YModemUpload_Info);
+        m_FTPS->RegisterFileTransferProtocol(&m_YModemDownload_Info);
+
+        return 0;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_CalcCRC
+ *
+ * SYNOPSIS:
+ *    static uint16_t YModem_CalcCRC(uint8_t *DataPtr,int Bytes);
+ *
+ * PARAMETERS:
+ *    DataPtr [I] -- The data to calc the CRC for
+ *    Bytes [I] -- The number of bytes in 'DataPtr'
+ *
+ * FUNCTION:
+ *    This function calc's the CRC16 for a block of YModem data.
+ *
+ * RETURNS:
+ *    The CRC for this block.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static uint16_t YModem_CalcCRC(uint8_t *DataPtr,int Bytes)
+{
+    uint16_t crc;
+    int i;
+
+    crc=0;
+    while(--Bytes>=0)
+    {
+        crc=crc^(uint16_t)(*DataPtr)<<8;
+        DataPtr++;
+
+        for(i=0;i<8;i++)
+        {
+            if(crc&0x8000)
+                crc=crc<<1^0x1021;
+            else
+                crc=crc<<1;
+        }
+    }
+    return crc&0xFFFF;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_ReadAheadOpen
+ *
+ * SYNOPSIS:
+ *    static bool YModem_ReadAheadOpen(struct YModemReadAhead *Reader,
+ *          const char *Filename);
+ *
+ * PARAMETERS:
+ *    Reader [O] -- The reader to setup
+ *    Filename [I] -- The file to open
+ *
+ * FUNCTION:
+ *    This function opens a file for reading in big chunks.  Blocks are then
+ *    taken out of the memory buffer with YModem_ReadAheadGet() so we don't
+ *    go to the disk for every packet.
+ *
+ * RETURNS:
+ *    true -- The file is open
+ *    false -- We couldn't open the file or get memory for the buffer
+ *
+ * SEE ALSO:
+ *    YModem_ReadAheadGet(), YModem_ReadAheadClose()
+ ******************************************************************************/
+static bool YModem_ReadAheadOpen(struct YModemReadAhead *Reader,
+        const char *Filename)
+{
+    Reader->Pos=0;
+    Reader->Len=0;
+    Reader->EndOfFile=false;
+
+    Reader->Buffer=(uint8_t *)malloc(YMODEM_READAHEAD_SIZE);
+    if(Reader->Buffer==NULL)
+        return false;
+
+    Reader->FileHandle=fopen(Filename,"rb");
+    if(Reader->FileHandle==NULL)
+    {
+        free(Reader->Buffer);
+        Reader->Buffer=NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_ReadAheadClose
+ *
+ * SYNOPSIS:
+ *    static void YModem_ReadAheadClose(struct YModemReadAhead *Reader);
+ *
+ * PARAMETERS:
+ *    Reader [I] -- The reader to close
+ *
+ * FUNCTION:
+ *    This function closes the file and frees the buffer.  It is safe to call
+ *    this on a reader that is already closed.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    YModem_ReadAheadOpen()
+ ******************************************************************************/
+static void YModem_ReadAheadClose(struct YModemReadAhead *Reader)
+{
+    if(Reader->FileHandle!=NULL)
+        fclose(Reader->FileHandle);
+    Reader->FileHandle=NULL;
+
+    free(Reader->Buffer);
+    Reader->Buffer=NULL;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_ReadAheadGet
+ *
+ * SYNOPSIS:
+ *    static int YModem_ReadAheadGet(struct YModemReadAhead *Reader,
+ *          uint8_t *Dest,int Bytes);
+ *
+ * PARAMETERS:
+ *    Reader [I] -- The reader to get bytes from
+ *    Dest [O] -- Where to copy the bytes to
+ *    Bytes [I] -- How many bytes we want (never more than
+ *                 YMODEM_READAHEAD_SIZE)
+ *
+ * FUNCTION:
+ *    This function gets the next bytes from the file.  When the buffer
+ *    doesn't have enough left we move what's left to the front and fill the
+ *    rest from the file with one read.
+ *
+ * RETURNS:
+ *    The number of bytes copied.  This will be less than 'Bytes' at the end
+ *    of the file (or if there was a read error).
+ *
+ * SEE ALSO:
+ *    YModem_ReadAheadOpen()
+ ******************************************************************************/
+static int YModem_ReadAheadGet(struct YModemReadAhead *Reader,uint8_t *Dest,
+        int Bytes)
+{
+    uint32_t Left;
+    size_t Got;
+
+    Left=Reader->Len-Reader->Pos;
+    if(Left<(uint32_t)Bytes && !Reader->EndOfFile)
+    {
+        memmove(Reader->Buffer,&Reader->Buffer[Reader->Pos],Left);
+        Reader->Pos=0;
+        Reader->Len=Left;
+
+        Got=fread(&Reader->Buffer[Left],1,YMODEM_READAHEAD_SIZE-Left,
+                Reader->FileHandle);
+        if(Got<YMODEM_READAHEAD_SIZE-Left)
+            Reader->EndOfFile=true;
+        Reader->Len+=Got;
+        Left=Reader->Len;
+    }
+
+    if(Left>(uint32_t)Bytes)
+        Left=Bytes;
+
+    memcpy(Dest,&Reader->Buffer[Reader->Pos],Left);
+    Reader->Pos+=Left;
+
+    return Left;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_FinishPacket
+ *
+ * SYNOPSIS:
+ *    static void YModem_FinishPacket(struct YModemTxPacket *Pkt,
+ *          uint8_t PacketNum,int BlockSize);
+ *
+ * PARAMETERS:
+ *    Pkt [I/O] -- The packet to finish.  The data must already be in the
+ *                 packet (padded out to 'BlockSize')
+ *    PacketNum [I] -- The packet number to put in the header
+ *    BlockSize [I] -- YMODEM_STANDARD_PACKET_SIZE or YMODEM_LARGE_PACKET_SIZE
+ *
+ * FUNCTION:
+ *    This function fills in the header and CRC for a packet.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModem_FinishPacket(struct YModemTxPacket *Pkt,uint8_t PacketNum,
+        int BlockSize)
+{
+    uint16_t CRC;
+
+    if(BlockSize==YMODEM_LARGE_PACKET_SIZE)
+        Pkt->Packet[0]=YMODEM_STX;
+    else
+        Pkt->Packet[0]=YMODEM_SOH;
+    Pkt->Packet[1]=PacketNum;
+    Pkt->Packet[2]=~PacketNum;
+
+    CRC=YModem_CalcCRC(&Pkt->Packet[3],BlockSize);
+    Pkt->Packet[3+BlockSize+0]=CRC>>8;
+    Pkt->Packet[3+BlockSize+1]=CRC&0xFF;
+
+    Pkt->Size=3+BlockSize+2;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_AllocWidgets
+ *
+ * SYNOPSIS:
+ *    static t_FTPOptionsWidgetsType *YModem_AllocWidgets(
+ *          t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options,
+ *          bool Download);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *    Options [I] -- The options to add widgets for
+ *    Download [I] -- true = add the download widgets, false = upload.
+ *                    The receiver picks between YModem and YModem-G so
+ *                    only the download has the mode.  Only the upload has
+ *                    the max NAK's.
+ *
+ * FUNCTION:
+ *    This function adds the options widgets for an upload or download.
+ *
+ * RETURNS:
+ *    The widgets or NULL if there was an error.
+ *
+ * SEE ALSO:
+ *    YModem_FreeWidgets(), YModem_StoreWidgets()
+ ******************************************************************************/
+static t_FTPOptionsWidgetsType *YModem_AllocWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options,bool Download)
+{
+    const char *Value;
+    struct YModem_Widgets *Widgets;
+    int MaxStartWaitTime;
+    int MaxNaks;
+    int MaxPacketWaitTime;
+
+    Widgets=NULL;
+    try
+    {
+        Widgets=new struct YModem_Widgets;
+        Widgets->WidgetHandle=WidgetHandle;
+        Widgets->ModeGroup=NULL;
+        Widgets->ModeBttnYModem=NULL;
+        Widgets->ModeBttnYModemG=NULL;
+        Widgets->MaxStartWaitTime=NULL;
+        Widgets->MaxNAKPackets=NULL;
+        Widgets->PacketTimeOut=NULL;
+
+        YModem_ReadCommonOptions(Options,&MaxStartWaitTime,&MaxNaks,
+                &MaxPacketWaitTime);
+
+        if(Download)
+        {
+            /* Mode */
+            Widgets->ModeGroup=m_UIAPI->AllocRadioBttnGroup(WidgetHandle,
+                    "Mode");
+            if(Widgets->ModeGroup==NULL)
+                throw(0);
+            Widgets->ModeBttnYModem=m_UIAPI->AddRadioBttn(WidgetHandle,
+                    Widgets->ModeGroup,"YModem",NULL,NULL);
+            Widgets->ModeBttnYModemG=m_UIAPI->AddRadioBttn(WidgetHandle,
+                    Widgets->ModeGroup,"YModem-G (streaming, no error "
+                    "recovery)",NULL,NULL);
+            if(Widgets->ModeBttnYModem==NULL ||
+                    Widgets->ModeBttnYModemG==NULL)
+            {
+                throw(0);
+            }
+
+            Value=m_System->KVGetItem(Options,"Mode");
+            if(Value!=NULL && atoi(Value)==e_YModemMode_YModemG)
+            {
+                m_UIAPI->SetRadioBttnChecked(WidgetHandle,
+                        Widgets->ModeBttnYModemG,true);
+            }
+            else
+            {
+                m_UIAPI->SetRadioBttnChecked(WidgetHandle,
+                        Widgets->ModeBttnYModem,true);
+            }
+        }
+
+        Widgets->MaxStartWaitTime=m_UIAPI->AddNumberInput(WidgetHandle,
+                "Max start wait time (seconds)",NULL,NULL);
+        if(Widgets->MaxStartWaitTime==NULL)
+            throw(0);
+        m_UIAPI->SetNumberInputMinMax(WidgetHandle,
+                Widgets->MaxStartWaitTime->Ctrl,5,120);   // 5s-120s
+        m_UIAPI->SetNumberInputValue(WidgetHandle,
+                Widgets->MaxStartWaitTime->Ctrl,MaxStartWaitTime);
+
+        Widgets->PacketTimeOut=m_UIAPI->AddNumberInput(WidgetHandle,
+                "Packet time out (seconds)",NULL,NULL);
+        if(Widgets->PacketTimeOut==NULL)
+            throw(0);
+        m_UIAPI->SetNumberInputMinMax(WidgetHandle,
+                Widgets->PacketTimeOut->Ctrl,1,300);
+        m_UIAPI->SetNumberInputValue(WidgetHandle,
+                Widgets->PacketTimeOut->Ctrl,MaxPacketWaitTime);
+
+        if(!Download)
+        {
+            Widgets->MaxNAKPackets=m_UIAPI->AddNumberInput(WidgetHandle,
+                    "Max number of failed blocks",NULL,NULL);
+            if(Widgets->MaxNAKPackets==NULL)
+                throw(0);
+            m_UIAPI->SetNumberInputMinMax(WidgetHandle,
+                    Widgets->MaxNAKPackets->Ctrl,1,20);
+            m_UIAPI->SetNumberInputValue(WidgetHandle,
+                    Widgets->MaxNAKPackets->Ctrl,MaxNaks);
+        }
+    }
+    catch(...)
+    {
+        if(Widgets!=NULL)
+            YModem_FreeWidgets((t_FTPOptionsWidgetsType *)Widgets);
+        return NULL;
+    }
+
+    return (t_FTPOptionsWidgetsType *)Widgets;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_FreeWidgets
+ *
+ * SYNOPSIS:
+ *    static void YModem_FreeWidgets(t_FTPOptionsWidgetsType *FTPOptions);
+ *
+ * PARAMETERS:
+ *    FTPOptions [I] -- The options data that was allocated with
+ *          YModem_AllocWidgets().
+ *
+ * FUNCTION:
+ *    Frees the widgets added with YModem_AllocWidgets().  This is used for
+ *    both the upload and download.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    YModem_AllocWidgets()
+ ******************************************************************************/
+static void YModem_FreeWidgets(t_FTPOptionsWidgetsType *FTPOptions)
+{
+    struct YModem_Widgets *Widgets=(struct YModem_Widgets *)FTPOptions;
+
+    if(Widgets->MaxNAKPackets!=NULL)
+    {
+        m_UIAPI->FreeNumberInput(Widgets->WidgetHandle,
+                Widgets->MaxNAKPackets);
+    }
+
+    if(Widgets->PacketTimeOut!=NULL)
+    {
+        m_UIAPI->FreeNumberInput(Widgets->WidgetHandle,
+                Widgets->PacketTimeOut);
+    }
+
+    if(Widgets->MaxStartWaitTime!=NULL)
+    {
+        m_UIAPI->FreeNumberInput(Widgets->WidgetHandle,
+                Widgets->MaxStartWaitTime);
+    }
+
+    if(Widgets->ModeBttnYModemG!=NULL)
+        m_UIAPI->FreeRadioBttn(Widgets->WidgetHandle,Widgets->ModeBttnYModemG);
+    if(Widgets->ModeBttnYModem!=NULL)
+        m_UIAPI->FreeRadioBttn(Widgets->WidgetHandle,Widgets->ModeBttnYModem);
+    if(Widgets->ModeGroup!=NULL)
+        m_UIAPI->FreeRadioBttnGroup(Widgets->WidgetHandle,Widgets->ModeGroup);
+
+    delete Widgets;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_StoreWidgets
+ *
+ * SYNOPSIS:
+ *    static void YModem_StoreWidgets(t_FTPOptionsWidgetsType *FTPOptions,
+ *          t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    FTPOptions [I] -- The options data that was allocated with
+ *          YModem_AllocWidgets().
+ *    Options [O] -- The options for this protocol.
+ *
+ * FUNCTION:
+ *    This function takes the widgets added with YModem_AllocWidgets() and
+ *    stores them is a key/value pair list in 'Options'.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    YModem_AllocWidgets()
+ ******************************************************************************/
+static void YModem_StoreWidgets(t_FTPOptionsWidgetsType *FTPOptions,
+        t_PIKVList *Options)
+{
+    struct YModem_Widgets *Widgets=(struct YModem_Widgets *)FTPOptions;
+    uintptr_t Value;
+    char buff[100];
+
+    if(Widgets->MaxStartWaitTime==NULL || Widgets->PacketTimeOut==NULL)
+        return;
+
+    m_System->KVClear(Options);
+
+    if(Widgets->ModeBttnYModemG!=NULL)
+    {
+        Value=e_YModemMode_YModem;
+        if(m_UIAPI->IsRadioBttnChecked(Widgets->WidgetHandle,
+                Widgets->ModeBttnYModemG))
+        {
+            Value=e_YModemMode_YModemG;
+        }
+        sprintf(buff,"%" PRIuPTR,Value);
+        m_System->KVAddItem(Options,"Mode",buff);
+    }
+
+    Value=m_UIAPI->GetNumberInputValue(Widgets->WidgetHandle,
+            Widgets->MaxStartWaitTime->Ctrl);
+    sprintf(buff,"%" PRIuPTR,Value);
+    m_System->KVAddItem(Options,"MAX_START_WAIT_TIME",buff);
+
+    Value=m_UIAPI->GetNumberInputValue(Widgets->WidgetHandle,
+            Widgets->PacketTimeOut->Ctrl);
+    sprintf(buff,"%" PRIuPTR,Value);
+    m_System->KVAddItem(Options,"MAX_PACKET_WAIT_TIME",buff);
+
+    if(Widgets->MaxNAKPackets!=NULL)
+    {
+        Value=m_UIAPI->GetNumberInputValue(Widgets->WidgetHandle,
+                Widgets->MaxNAKPackets->Ctrl);
+        sprintf(buff,"%" PRIuPTR,Value);
+        m_System->KVAddItem(Options,"MAX_NAKS",buff);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModem_ReadCommonOptions
+ *
+ * SYNOPSIS:
+ *    static void YModem_ReadCommonOptions(t_PIKVList *Options,
+ *          int *MaxStartWaitTime,int *MaxNaks,int *MaxPacketWaitTime);
+ *
+ * PARAMETERS:
+ *    Options [I] -- The options to read
+ *    MaxStartWaitTime [O] -- How long we wait for the other side to start
+ *    MaxNaks [O] -- How many NAK's in a row before we give up
+ *    MaxPacketWaitTime [O] -- How long we wait for a packet / ACK
+ *
+ * FUNCTION:
+ *    This function reads the options that the upload and download share,
+ *    filling in the defaults for anything that isn't set.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModem_ReadCommonOptions(t_PIKVList *Options,int *MaxStartWaitTime,
+        int *MaxNaks,int *MaxPacketWaitTime)
+{
+    const char *Value;
+
+    *MaxStartWaitTime=MAX_START_WAIT_TIME;
+    *MaxNaks=YMODEM_MAX_NAKS;
+    *MaxPacketWaitTime=MAX_PACKET_WAIT_TIME;
+
+    Value=m_System->KVGetItem(Options,"MAX_START_WAIT_TIME");
+    if(Value!=NULL)
+        *MaxStartWaitTime=atoi(Value);
+
+    Value=m_System->KVGetItem(Options,"MAX_NAKS");
+    if(Value!=NULL)
+        *MaxNaks=atoi(Value);
+
+    Value=m_System->KVGetItem(Options,"MAX_PACKET_WAIT_TIME");
+    if(Value!=NULL)
+        *MaxPacketWaitTime=atoi(Value);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_AllocateData
+ *
+ * SYNOPSIS:
+ *    static t_FTPHandlerDataType *YModemUpload_AllocateData(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function allocates any needed data for this file transfer protocol.
+ *
+ * RETURNS:
+ *    A pointer to the data, NULL if there was an error.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static t_FTPHandlerDataType *YModemUpload_AllocateData(void)
+{
+    struct YModemUploadData *Data;
+
+    try
+    {
+        Data=new struct YModemUploadData;
+        Data->Reader.FileHandle=NULL;
+        Data->Reader.Buffer=NULL;
+    }
+    catch(...)
+    {
+        return NULL;
+    }
+
+    return (t_FTPHandlerDataType *)Data;
+}
+
+/*******************************************************************************
+ *  NAME:
+ *    YModemUpload_FreeData
+ *
+ *  SYNOPSIS:
+ *    static void YModemUpload_FreeData(t_FTPHandlerDataType *DataHandle);
+ *
+ *  PARAMETERS:
+ *    DataHandle [I] -- The data handle to free.  This will need to be
+ *                      case to your internal data type before you use it.
+ *
+ *  FUNCTION:
+ *    This function frees the memory allocated with AllocateData().
+ *
+ *  RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemUpload_FreeData(t_FTPHandlerDataType *DataHandle)
+{
+    struct YModemUploadData *Data=(struct YModemUploadData *)DataHandle;
+
+    YModem_ReadAheadClose(&Data->Reader);
+
+    delete Data;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_Init
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL YModemUpload_Init(t_FTPSystemData *SysHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *
+ * FUNCTION:
+ *    This function is called on startup init.  It lets the plugin add needed
+ *    things to the system (and other init stuff).
+ *
+ * RETURNS:
+ *    true -- Init worked
+ *    false -- There was some kind of error.  Plugin will not be installed.
+ *
+ * SEE ALSO:
+ *    ShutDown()
+ ******************************************************************************/
+static PG_BOOL YModemUpload_Init(t_FTPSystemData *SysHandle)
+{
+#ifdef INCLUDESCRIPTING
+    static struct ScriptDataType UploadArgs[]=
+    {
+        {"StartTimeout","MAX_START_WAIT_TIME",e_ScriptDataArg_Int},
+        {"PacketTimeout","MAX_PACKET_WAIT_TIME",e_ScriptDataArg_Int},
+        {"MaxNaks","MAX_NAKS",e_ScriptDataArg_Int},
+    };
+
+    return m_FTPS->AddScriptUploadCMD(SysHandle,"YModem",UploadArgs,
+            sizeof(UploadArgs)/sizeof(struct ScriptDataType),0);
+#else
+    return true;
+#endif
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_AllocOptionsWidgets
+ *
+ * SYNOPSIS:
+ *    static t_FTPOptionsWidgetsType *YModemUpload_AllocOptionsWidgets(
+ *          t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *    Options [I] -- The options to add widgets for
+ *
+ * FUNCTION:
+ *    This function adds options widgets to a container widget.  These are
+ *    options for this file transfer protocol.
+ *
+ * RETURNS:
+ *    The private options data or NULL if there was an error.
+ *
+ * SEE ALSO:
+ *    YModem_AllocWidgets()
+ ******************************************************************************/
+static t_FTPOptionsWidgetsType *YModemUpload_AllocOptionsWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options)
+{
+    return YModem_AllocWidgets(WidgetHandle,Options,false);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_StartUpload
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL YModemUpload_StartUpload(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle,const char *FilenameWithPath,
+ *          const char *FilenameOnly,uint64_t FileSize,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *    FilenameWithPath [I] -- The full filename and path
+ *    FilenameOnly [I] -- The filename without the path.
+ *    FileSize [I] -- The number of bytes in the file to upload
+ *    Options [I] -- The options to use for this transfer
+ *
+ * FUNCTION:
+ *    This function is called to start a transfer.  We open the file and wait
+ *    for the rx to ask for the header.
+ *
+ *    The upload system gives us one file so we send a batch of one.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static PG_BOOL YModemUpload_StartUpload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,const char *FilenameWithPath,
+        const char *FilenameOnly,uint64_t FileSize,t_PIKVList *Options)
+{
+    struct YModemUploadData *Data=(struct YModemUploadData *)DataHandle;
+
+    Data->PacketReady[0]=false;
+    Data->PacketReady[1]=false;
+    Data->CurPacket=0;
+    Data->PacketNum=0;
+    Data->BytesSent=0;
+    Data->Filename=FilenameOnly;
+    Data->FileSize=FileSize;
+    Data->State=e_YModemUpload_Waiting4Start;
+    Data->Streaming=false;
+    Data->SendPending=false;
+    Data->TickMS=0;
+    Data->IdleMS=0;
+    Data->NAKCount=0;
+    Data->CANCount=0;
+    Data->ErrorStr="";
+
+    YModem_ReadCommonOptions(Options,&Data->MaxStartWaitTime,&Data->MaxNaks,
+            &Data->MaxPacketWaitTime);
+
+    if(!YModem_ReadAheadOpen(&Data->Reader,FilenameWithPath))
+        return false;
+
+    YModemUpload_SetTick(SysHandle,Data,YMODEM_TICK_MS);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_AbortUpload
+ *
+ * SYNOPSIS:
+ *    static void YModemUpload_AbortUpload(t_FTPSystemData *SysHandle,
+ *              t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    Abort the current transfer.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemUpload_AbortUpload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct YModemUploadData *Data=(struct YModemUploadData *)DataHandle;
+    uint8_t Block[YMODEM_CAN_COUNT];
+
+    memset(Block,YMODEM_CAN,sizeof(Block));
+    m_FTPS->ULSendData(SysHandle,Block,sizeof(Block));
+
+    YModem_ReadAheadClose(&Data->Reader);
+    Data->ErrorStr="User abort";
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_RxData
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL YModemUpload_RxData(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *    RxData [I] -- A block with the data that was rx'ed in it.
+ *    Bytes [I] -- The number of bytes in 'RxData'
+ *
+ * FUNCTION:
+ *    This function is called when new data comes in the connection.  This
+ *    is where we find out the rx wants the next thing.
+ *
+ * RETURNS:
+ *    true -- Do not echo the data
+ *    false -- Go ahead and echo the data
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static PG_BOOL YModemUpload_RxData(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes)
+{
+    struct YModemUploadData *Data=(struct YModemUploadData *)DataHandle;
+    uint32_t b;
+    uint8_t c;
+
+    if(Data->Reader.FileHandle==NULL)
+        return false;
+
+    for(b=0;b<Bytes;b++)
+    {
+        c=RxData[b];
+        Data->IdleMS=0;
+
+        if(c==YMODEM_CAN)
+        {
+            Data->CANCount++;
+            if(Data->CANCount>=2)
+            {
+                Data->ErrorStr="Canceled by the receiver";
+                m_FTPS->ULFinish(SysHandle,true);
+                return true;    // 'Data' is no longer valid, so we are done
+            }
+            continue;
+        }
+        Data->CANCount=0;
+
+        switch(Data->State)
+        {
+            case e_YModemUpload_Waiting4Start:
+                if(c!='C' && c!='G')
+                    break;
+
+                /* The rx picks if we stream or not */
+                Data->Streaming=(c=='G');
+                YModemUpload_BuildHeader(Data,false);
+                if(Data->Streaming)
+                    Data->State=e_YModemUpload_Waiting4DataStart;
+                else
+                    Data->State=e_YModemUpload_Waiting4HeaderAck;
+                if(!YModemUpload_SendCurrent(SysHandle,Data))
+                    return true;    // 'Data' is no longer valid
+            break;
+            case e_YModemUpload_Waiting4HeaderAck:
+                if(c==YMODEM_ACK)
+                {
+                    Data->NAKCount=0;
+                    Data->State=e_YModemUpload_Waiting4DataStart;
+                }
+                else if(c==YMODEM_NAK)
+                {
+                    Data->NAKCount++;
+                    if(Data->NAKCount>Data->MaxNaks)
+                    {
+                        YModemUpload_Fail(SysHandle,Data,
+                                "Too many NAKs in a row");
+                        return true;    // 'Data' is no longer valid
+                    }
+                    if(!YModemUpload_SendCurrent(SysHandle,Data))
+                        return true;    // 'Data' is no longer valid
+                }
+            break;
+            case e_YModemUpload_Waiting4DataStart:
+                if(c==(Data->Streaming?'G':'C'))
+                {
+                    /* Start the data */
+                    Data->State=e_YModemUpload_Sending;
+                    Data->PacketNum=1;
+                    Data->CurPacket=0;
+                    Data->PacketReady[0]=false;
+                    Data->PacketReady[1]=false;
+                    YModemUpload_BuildPacket(Data,0,1);
+                    if(Data->TxPacket[0].DataBytes==0)
+                    {
+                        /* Empty file */
+                        YModemUpload_BuildEOT(Data);
+                        Data->State=e_YModemUpload_Waiting4EOTAck;
+                    }
+
+                    if(Data->Streaming &&
+                            Data->State==e_YModemUpload_Sending)
+                    {
+                        YModemUpload_SetTick(SysHandle,Data,
+                                YMODEM_STREAM_TICK_MS);
+                        if(!YModemUpload_Stream(SysHandle,Data))
+                            return true;    // 'Data' is no longer valid
+                    }
+                    else
+                    {
+                        if(!YModemUpload_SendCurrent(SysHandle,Data))
+                            return true;    // 'Data' is no longer valid
+                    }
+                }
+                else if(c==YMODEM_NAK && !Data->Streaming)
+                {
+                    /* They didn't get the header */
+                    Data->State=e_YModemUpload_Waiting4HeaderAck;
+                    if(!YModemUpload_SendCurrent(SysHandle,Data))
+                        return true;    // 'Data' is no longer valid
+                }
+            break;
+            case e_YModemUpload_Sending:
+                if(Data->Streaming)
+                {
+                    /* There is no going back in YModem-G */
+                    if(c==YMODEM_NAK)
+                    {
+                        YModemUpload_Fail(SysHandle,Data,
+                                "The receiver had an error (YModem-G can't "
+                                "resend)");
+                        return true;    // 'Data' is no longer valid
+                    }
+                    break;
+                }
+
+                if(c==YMODEM_ACK)
+                {
+                    Data->NAKCount=0;
+                    if(!YModemUpload_NextPacket(SysHandle,Data))
+                        return true;    // 'Data' is no longer valid
+                    if(!YModemUpload_SendCurrent(SysHandle,Data))
+                        return true;    // 'Data' is no longer valid
+                }
+                else if(c==YMODEM_NAK)
+                {
+                    /* Resend the packet we still have */
+                    Data->NAKCount++;
+                    if(Data->NAKCount>Data->MaxNaks)
+                    {
+                        YModemUpload_Fail(SysHandle,Data,
+                                "Too many NAKs in a row");
+                        return true;    // 'Data' is no longer valid
+                    }
+                    if(!YModemUpload_SendCurrent(SysHandle,Data))
+                        return true;    // 'Data' is no longer valid
+                }
+            break;
+            case e_YModemUpload_Waiting4EOTAck:
+                if(c==YMODEM_ACK)
+                {
+                    Data->State=e_YModemUpload_Waiting4EndStart;
+                    m_FTPS->ULProgress(SysHandle,Data->BytesSent);
+                }
+                else if(c==YMODEM_NAK)
+                {
+                    /* The rx NAK's the first EOT to make sure it's real */
+                    if(!YModemUpload_SendCurrent(SysHandle,Data))
+                        return true;    // 'Data' is no longer valid
+                }
+            break;
+            case e_YModemUpload_Waiting4EndStart:
+                if(c!='C' && c!='G')
+                    break;
+
+                /* Tell the rx there are no more files */
+                YModemUpload_BuildHeader(Data,true);
+                Data->State=e_YModemUpload_Waiting4EndAck;
+                if(!YModemUpload_SendCurrent(SysHandle,Data))
+                    return true;    // 'Data' is no longer valid
+
+                if(Data->Streaming && !Data->SendPending)
+                {
+                    /* There's no ACK for the end block in YModem-G */
+                    Data->ErrorStr="";
+                    m_FTPS->ULFinish(SysHandle,false);
+                    return true;    // 'Data' is no longer valid
+                }
+            break;
+            case e_YModemUpload_Waiting4EndAck:
+                if(c==YMODEM_ACK)
+                {
+                    Data->ErrorStr="";
+                    m_FTPS->ULFinish(SysHandle,false);
+                    return true;    // 'Data' is no longer valid
+                }
+                if(c==YMODEM_NAK)
+                {
+                    if(!YModemUpload_SendCurrent(SysHandle,Data))
+                        return true;    // 'Data' is no longer valid
+                }
+            break;
+            case e_YModemUploadMAX:
+            default:
+            break;
+        }
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_Timeout
+ *
+ * SYNOPSIS:
+ *    static void YModemUpload_Timeout(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    This function is called when the timeout timer (set with SetTimeout())
+ *    goes off.  While streaming this is what keeps the driver fed.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemUpload_Timeout(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct YModemUploadData *Data=(struct YModemUploadData *)DataHandle;
+    uint32_t MaxMS;
+
+    if(Data->Reader.FileHandle==NULL)
+        return;
+
+    Data->IdleMS+=Data->TickMS;
+
+    if(Data->Streaming && Data->State==e_YModemUpload_Sending)
+    {
+        /* We don't hear anything while streaming, so we can't time out */
+        Data->IdleMS=0;
+        YModemUpload_Stream(SysHandle,Data);
+        return;     // 'Data' may no longer be valid
+    }
+
+    if(Data->SendPending)
+    {
+        if(!YModemUpload_SendCurrent(SysHandle,Data))
+            return;     // 'Data' is no longer valid
+
+        if(Data->Streaming && !Data->SendPending &&
+                Data->State==e_YModemUpload_Waiting4EndAck)
+        {
+            Data->ErrorStr="";
+            m_FTPS->ULFinish(SysHandle,false);
+            return;     // 'Data' is no longer valid
+        }
+    }
+
+    if(Data->State==e_YModemUpload_Waiting4Start)
+        MaxMS=Data->MaxStartWaitTime*1000;
+    else
+        MaxMS=Data->MaxPacketWaitTime*1000;
+
+    if(Data->IdleMS>MaxMS)
+    {
+        if(Data->State==e_YModemUpload_Waiting4Start)
+            Data->ErrorStr="Timed out waiting to start";
+        else
+            Data->ErrorStr="Timed out waiting for an ACK/NACK";
+        m_FTPS->ULFinish(SysHandle,true);
+        return;     // 'Data' is no longer valid
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_GetLastErrorMsg
+ *
+ * SYNOPSIS:
+ *    static const char *YModemUpload_GetLastErrorMsg(
+ *          t_FTPSystemData *SysHandle,t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    This function gets the last error message from the system.  The system
+ *    will call then when a function returns an error or abort to find more
+ *    details.
+ *
+ * RETURNS:
+ *    A pointer to an error message or NULL if there was no message.  This must
+ *    remain valid until the next call to any 'FileTransferHandlerAPI' function.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static const char *YModemUpload_GetLastErrorMsg(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct YModemUploadData *Data=(struct YModemUploadData *)DataHandle;
+
+    if(Data->ErrorStr=="")
+        return NULL;
+
+    return Data->ErrorStr.c_str();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_BuildHeader
+ *
+ * SYNOPSIS:
+ *    static void YModemUpload_BuildHeader(struct YModemUploadData *Data,
+ *          bool EndOfBatch);
+ *
+ * PARAMETERS:
+ *    Data [I] -- The upload data
+ *    EndOfBatch [I] -- true = build the empty block 0 that ends the batch,
+ *                      false = build the block 0 with our filename and size.
+ *
+ * FUNCTION:
+ *    This function builds a block 0 into the current packet.  The header
+ *    has the filename (without the path), a NUL, and then the size in
+ *    decimal.  We use a 1K block if the name doesn't fit in 128 bytes.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemUpload_BuildHeader(struct YModemUploadData *Data,
+        bool EndOfBatch)
+{
+    struct YModemTxPacket *Pkt;
+    char SizeStr[30];
+    size_t NameLen;
+    size_t SizeLen;
+    int BlockSize;
+
+    Pkt=&Data->TxPacket[Data->CurPacket];
+    BlockSize=YMODEM_STANDARD_PACKET_SIZE;
+    memset(&Pkt->Packet[3],0x00,YMODEM_LARGE_PACKET_SIZE);
+
+    if(!EndOfBatch)
+    {
+        sprintf(SizeStr,"%" PRIu64,Data->FileSize);
+        SizeLen=strlen(SizeStr);
+        NameLen=Data->Filename.length();
+        if(NameLen+1+SizeLen+1>YMODEM_STANDARD_PACKET_SIZE)
+            BlockSize=YMODEM_LARGE_PACKET_SIZE;
+        if(NameLen+1+SizeLen+1>YMODEM_LARGE_PACKET_SIZE)
+            NameLen=YMODEM_LARGE_PACKET_SIZE-1-SizeLen-1;
+
+        memcpy(&Pkt->Packet[3],Data->Filename.c_str(),NameLen);
+        memcpy(&Pkt->Packet[3+NameLen+1],SizeStr,SizeLen);
+    }
+
+    YModem_FinishPacket(Pkt,0,BlockSize);
+    Pkt->DataBytes=0;
+    Data->PacketReady[Data->CurPacket]=true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_BuildPacket
+ *
+ * SYNOPSIS:
+ *    static void YModemUpload_BuildPacket(struct YModemUploadData *Data,
+ *          int Index,uint32_t PacketNum);
+ *
+ * PARAMETERS:
+ *    Data [I] -- The upload data
+ *    Index [I] -- Which of the 'TxPacket' buffers to build into
+ *    PacketNum [I] -- The packet we are building (1 = first data packet)
+ *
+ * FUNCTION:
+ *    This function takes the next 1K of the file and builds the packet for
+ *    it.  The last bit of the file goes in a 128 byte block if it fits.
+ *    The packet is kept until it is ACK'ed so a NAK can resend it without
+ *    going back to the file.
+ *
+ *    Packets must be built in order because this reads the file in order.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    YModem_ReadAheadGet()
+ ******************************************************************************/
+static void YModemUpload_BuildPacket(struct YModemUploadData *Data,int Index,
+        uint32_t PacketNum)
+{
+    struct YModemTxPacket *Pkt;
+    int BlockSize;
+
+    Pkt=&Data->TxPacket[Index];
+
+    memset(&Pkt->Packet[3],YMODEM_CPMEOF,YMODEM_LARGE_PACKET_SIZE);
+    Pkt->DataBytes=YModem_ReadAheadGet(&Data->Reader,&Pkt->Packet[3],
+            YMODEM_LARGE_PACKET_SIZE);
+
+    BlockSize=YMODEM_LARGE_PACKET_SIZE;
+    if(Pkt->DataBytes<=YMODEM_STANDARD_PACKET_SIZE)
+        BlockSize=YMODEM_STANDARD_PACKET_SIZE;
+
+    YModem_FinishPacket(Pkt,PacketNum&0xFF,BlockSize);
+    Data->PacketReady[Index]=true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_BuildEOT
+ *
+ * SYNOPSIS:
+ *    static void YModemUpload_BuildEOT(struct YModemUploadData *Data);
+ *
+ * PARAMETERS:
+ *    Data [I] -- The upload data
+ *
+ * FUNCTION:
+ *    This function replaces the current packet with an EOT so it can be
+ *    (re)sent like any other packet.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemUpload_BuildEOT(struct YModemUploadData *Data)
+{
+    struct YModemTxPacket *Pkt;
+
+    Pkt=&Data->TxPacket[Data->CurPacket];
+    Pkt->Packet[0]=YMODEM_EOT;
+    Pkt->Size=1;
+    Pkt->DataBytes=0;
+    Data->PacketReady[Data->CurPacket]=true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_SetTick
+ *
+ * SYNOPSIS:
+ *    static void YModemUpload_SetTick(t_FTPSystemData *SysHandle,
+ *          struct YModemUploadData *Data,uint32_t MSec);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *    MSec [I] -- How often we want our Timeout() called
+ *
+ * FUNCTION:
+ *    This function changes how often our timeout is called.  We don't have a
+ *    clock so we count the ticks to work out our timeouts.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemUpload_SetTick(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data,uint32_t MSec)
+{
+    if(Data->TickMS==MSec)
+        return;
+
+    Data->TickMS=MSec;
+    m_FTPS->SetTimeout(SysHandle,MSec);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_SendCurrent
+ *
+ * SYNOPSIS:
+ *    static bool YModemUpload_SendCurrent(t_FTPSystemData *SysHandle,
+ *          struct YModemUploadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *
+ * FUNCTION:
+ *    This function sends the current packet (header, data, EOT, or end of
+ *    batch).  If the driver is busy we speed up the tick and try again from
+ *    the timeout.
+ *
+ *    When we are not streaming we also build the next data packet while
+ *    we wait for the ACK.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The upload has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool YModemUpload_SendCurrent(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data)
+{
+    struct YModemTxPacket *Pkt;
+
+    Pkt=&Data->TxPacket[Data->CurPacket];
+    switch(m_FTPS->ULSendData(SysHandle,Pkt->Packet,Pkt->Size))
+    {
+        case e_FTPS_SendDataRet_Success:
+            Data->SendPending=false;
+            if(!Data->Streaming || Data->State!=e_YModemUpload_Sending)
+                YModemUpload_SetTick(SysHandle,Data,YMODEM_TICK_MS);
+        break;
+        case e_FTPS_SendDataRet_Busy:
+            Data->SendPending=true;
+            YModemUpload_SetTick(SysHandle,Data,YMODEM_STREAM_TICK_MS);
+            return true;
+        case e_FTPS_SendDataRet_Fail:
+        default:
+            Data->ErrorStr="Failed to send the data";
+            m_FTPS->ULFinish(SysHandle,true);
+            return false;
+    }
+
+    /* Get the next block ready while we wait for the ACK */
+    if(Data->State==e_YModemUpload_Sending &&
+            !Data->PacketReady[Data->CurPacket^1] && Pkt->DataBytes>0)
+    {
+        YModemUpload_BuildPacket(Data,Data->CurPacket^1,Data->PacketNum+1);
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_NextPacket
+ *
+ * SYNOPSIS:
+ *    static bool YModemUpload_NextPacket(t_FTPSystemData *SysHandle,
+ *          struct YModemUploadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *
+ * FUNCTION:
+ *    This function moves on to the next data packet (the current one has
+ *    been ACK'ed or streamed).  When we run out of file the current packet
+ *    becomes an EOT.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The upload has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool YModemUpload_NextPacket(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data)
+{
+    Data->BytesSent+=Data->TxPacket[Data->CurPacket].DataBytes;
+    if(Data->BytesSent>Data->FileSize)
+        Data->BytesSent=Data->FileSize;
+
+    /* Normally built while the last one was on the wire */
+    if(!Data->PacketReady[Data->CurPacket^1])
+        YModemUpload_BuildPacket(Data,Data->CurPacket^1,Data->PacketNum+1);
+    Data->PacketReady[Data->CurPacket]=false;
+    Data->CurPacket^=1;
+    Data->PacketNum++;
+
+    if(Data->TxPacket[Data->CurPacket].DataBytes==0)
+    {
+        YModemUpload_BuildEOT(Data);
+        Data->State=e_YModemUpload_Waiting4EOTAck;
+    }
+
+    if(!Data->Streaming)
+        m_FTPS->ULProgress(SysHandle,Data->BytesSent);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_Stream
+ *
+ * SYNOPSIS:
+ *    static bool YModemUpload_Stream(t_FTPSystemData *SysHandle,
+ *          struct YModemUploadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *
+ * FUNCTION:
+ *    This function sends as many YModem-G packets as the driver will take
+ *    (up to YMODEM_STREAM_BURST so we don't hold up the UI).  The rest go
+ *    out on the next tick.
+ *
+ *    A packet is never split between sends.  If the driver only takes the
+ *    start of one the connection sends the rest (and says busy until it
+ *    has), so busy here always means none of this packet went out.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The upload has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool YModemUpload_Stream(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data)
+{
+    struct YModemTxPacket *Pkt;
+    int Sent;
+
+    for(Sent=0;Sent<YMODEM_STREAM_BURST;Sent++)
+    {
+        Pkt=&Data->TxPacket[Data->CurPacket];
+        switch(m_FTPS->ULSendData(SysHandle,Pkt->Packet,Pkt->Size))
+        {
+            case e_FTPS_SendDataRet_Success:
+            break;
+            case e_FTPS_SendDataRet_Busy:
+                /* Try this packet again on the next tick (the EOT goes
+                   through the normal resend) */
+                Data->SendPending=(Data->State!=e_YModemUpload_Sending);
+                m_FTPS->ULProgress(SysHandle,Data->BytesSent);
+                return true;
+            case e_FTPS_SendDataRet_Fail:
+            default:
+                Data->ErrorStr="Failed to send the data";
+                m_FTPS->ULFinish(SysHandle,true);
+                return false;
+        }
+
+        if(Data->State!=e_YModemUpload_Sending)
+        {
+            /* That was the EOT, wait for the ACK at the normal rate */
+            YModemUpload_SetTick(SysHandle,Data,YMODEM_TICK_MS);
+            break;
+        }
+
+        if(!YModemUpload_NextPacket(SysHandle,Data))
+            return false;
+    }
+
+    m_FTPS->ULProgress(SysHandle,Data->BytesSent);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemUpload_Fail
+ *
+ * SYNOPSIS:
+ *    static void YModemUpload_Fail(t_FTPSystemData *SysHandle,
+ *          struct YModemUploadData *Data,const char *Msg);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *    Msg [I] -- Why we are giving up
+ *
+ * FUNCTION:
+ *    This function cancels the transfer (tells the rx) and finishes the
+ *    upload.  'Data' is no longer valid after this.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemUpload_Fail(t_FTPSystemData *SysHandle,
+        struct YModemUploadData *Data,const char *Msg)
+{
+    uint8_t Block[YMODEM_CAN_COUNT];
+
+    memset(Block,YMODEM_CAN,sizeof(Block));
+    m_FTPS->ULSendData(SysHandle,Block,sizeof(Block));
+
+    Data->ErrorStr=Msg;
+    m_FTPS->ULFinish(SysHandle,true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_Init
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL YModemDownload_Init(t_FTPSystemData *SysHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *
+ * FUNCTION:
+ *    This function is called on startup init.  It lets the plugin add needed
+ *    things to the system (and other init stuff).
+ *
+ * RETURNS:
+ *    true -- Init worked
+ *    false -- There was some kind of error.  Plugin will not be installed.
+ *
+ * SEE ALSO:
+ *    ShutDown()
+ ******************************************************************************/
+static PG_BOOL YModemDownload_Init(t_FTPSystemData *SysHandle)
+{
+#ifdef INCLUDESCRIPTING
+    static struct ScriptDataType DownloadArgs[]=
+    {
+        {"Streaming","Mode",e_ScriptDataArg_Bool},
+        {"StartTimeout","MAX_START_WAIT_TIME",e_ScriptDataArg_Int},
+        {"PacketTimeout","MAX_PACKET_WAIT_TIME",e_ScriptDataArg_Int},
+    };
+
+    return m_FTPS->AddScriptDownloadCMD(SysHandle,"YModem",DownloadArgs,
+            sizeof(DownloadArgs)/sizeof(struct ScriptDataType),0);
+#else
+    return true;
+#endif
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_AllocateData
+ *
+ * SYNOPSIS:
+ *    static t_FTPHandlerDataType *YModemDownload_AllocateData(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function allocates any needed data for this file transfer protocol.
+ *
+ * RETURNS:
+ *    A pointer to the data, NULL if there was an error.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static t_FTPHandlerDataType *YModemDownload_AllocateData(void)
+{
+    struct YModemDownloadData *Data;
+
+    try
+    {
+        Data=new struct YModemDownloadData;
+        Data->FileHandle=NULL;
+    }
+    catch(...)
+    {
+        return NULL;
+    }
+
+    return (t_FTPHandlerDataType *)Data;
+}
+
+/*******************************************************************************
+ *  NAME:
+ *    YModemDownload_FreeData
+ *
+ *  SYNOPSIS:
+ *    static void YModemDownload_FreeData(t_FTPHandlerDataType *DataHandle);
+ *
+ *  PARAMETERS:
+ *    DataHandle [I] -- The data handle to free.  This will need to be
+ *                      case to your internal data type before you use it.
+ *
+ *  FUNCTION:
+ *    This function frees the memory allocated with AllocateData().
+ *
+ *  RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemDownload_FreeData(t_FTPHandlerDataType *DataHandle)
+{
+    struct YModemDownloadData *Data=(struct YModemDownloadData *)DataHandle;
+
+    if(Data->FileHandle!=NULL)
+        fclose(Data->FileHandle);
+
+    delete Data;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_AllocOptionsWidgets
+ *
+ * SYNOPSIS:
+ *    static t_FTPOptionsWidgetsType *YModemDownload_AllocOptionsWidgets(
+ *          t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *    Options [I] -- The options to add widgets for
+ *
+ * FUNCTION:
+ *    This function adds options widgets to a container widget.  These are
+ *    options for this file transfer protocol.
+ *
+ * RETURNS:
+ *    The private options data or NULL if there was an error.
+ *
+ * SEE ALSO:
+ *    YModem_AllocWidgets()
+ ******************************************************************************/
+static t_FTPOptionsWidgetsType *YModemDownload_AllocOptionsWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options)
+{
+    return YModem_AllocWidgets(WidgetHandle,Options,true);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_StartDownload
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL YModemDownload_StartDownload(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *    Options [I] -- The options to use for this transfer
+ *
+ * FUNCTION:
+ *    This function is called to start a download transfer.  We ask for the
+ *    filename here (and not when block 0 comes in) so we aren't sitting in
+ *    a file requester while the data is coming in.  The first file in the
+ *    batch is saved to this name, the rest go in the same directory.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static PG_BOOL YModemDownload_StartDownload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,t_PIKVList *Options)
+{
+    struct YModemDownloadData *Data=(struct YModemDownloadData *)DataHandle;
+    const char *Value;
+    const char *Filename;
+    string::size_type Sep;
+    int MaxNaks;
+
+    Data->FilesDone=0;
+    Data->Streaming=false;
+    Data->Waiting4Header=true;
+    Data->PacketNum=0;
+    Data->FileSizeKnown=false;
+    Data->FileSize=0;
+    Data->FileBytes=0;
+    Data->BytesRx=0;
+    Data->DownloadState=e_YModemDownload_StartOfHeader;
+    Data->BadPacket=false;
+    Data->ByteCount=0;
+    Data->ExpectedByteCount=0;
+    Data->EOTCount=0;
+    Data->CANCount=0;
+    Data->GotFirstHeader=false;
+    Data->StartTimeout=0;
+    Data->TimeSinceLastStartChar=0;
+    Data->LastByteTimeout=0;
+    Data->LastPacketTimeout=0;
+    Data->ErrorStr="";
+
+    Value=m_System->KVGetItem(Options,"Mode");
+    if(Value!=NULL)
+    {
+        if(atoi(Value)>=e_YModemModeMAX)
+            return false;
+        Data->Streaming=(atoi(Value)==e_YModemMode_YModemG);
+    }
+
+    YModem_ReadCommonOptions(Options,&Data->MaxStartWaitTime,&MaxNaks,
+            &Data->MaxPacketWaitTime);
+
+    Filename=m_FTPS->GetDownloadFilename(SysHandle,NULL);
+    if(Filename==NULL)
+    {
+        /* We aborted */
+        return false;
+    }
+    Data->FirstFilename=Filename;
+
+    Sep=Data->FirstFilename.find_last_of("/\\");
+    if(Sep==string::npos)
+        Data->SaveDir="";
+    else
+        Data->SaveDir=Data->FirstFilename.substr(0,Sep+1);
+
+    m_FTPS->SetTimeout(SysHandle,YMODEM_TICK_MS);
+
+    YModemDownload_SendStart(SysHandle,Data);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_AbortDownload
+ *
+ * SYNOPSIS:
+ *    static void YModemDownload_AbortDownload(t_FTPSystemData *SysHandle,
+ *              t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    Abort the current transfer.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemDownload_AbortDownload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct YModemDownloadData *Data=(struct YModemDownloadData *)DataHandle;
+    uint8_t Block[YMODEM_CAN_COUNT];
+
+    memset(Block,YMODEM_CAN,sizeof(Block));
+    m_FTPS->DLSendData(SysHandle,Block,sizeof(Block));
+
+    if(Data->FileHandle!=NULL)
+    {
+        fclose(Data->FileHandle);
+        Data->FileHandle=NULL;
+    }
+
+    Data->ErrorStr="User abort";
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_RxData
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL YModemDownload_RxData(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *    RxData [I] -- A block with the data that was rx'ed in it.
+ *    Bytes [I] -- The number of bytes in 'RxData'
+ *
+ * FUNCTION:
+ *    This function is called when new data comes in the connection.
+ *
+ * RETURNS:
+ *    true -- Do not echo the data
+ *    false -- Go ahead and echo the data
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static PG_BOOL YModemDownload_RxData(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes)
+{
+    struct YModemDownloadData *Data=(struct YModemDownloadData *)DataHandle;
+    uint32_t b;
+    uint32_t Copy;
+    uint8_t c;
+
+    for(b=0;b<Bytes;b++)
+    {
+        c=RxData[b];
+        Data->LastByteTimeout=0;
+
+        switch(Data->DownloadState)
+        {
+            case e_YModemDownload_StartOfHeader:
+                if(c==YMODEM_CAN)
+                {
+                    Data->CANCount++;
+                    if(Data->CANCount>=2)
+                    {
+                        Data->ErrorStr="Canceled by the sender";
+                        m_FTPS->DLFinish(SysHandle,true);
+                        return true;    // Data has been free'ed we are done
+                    }
+                    break;
+                }
+                Data->CANCount=0;
+
+                if(c==YMODEM_SOH || c==YMODEM_STX)
+                {
+                    Data->ExpectedByteCount=(c==YMODEM_SOH)?
+                            YMODEM_STANDARD_PACKET_SIZE:
+                            YMODEM_LARGE_PACKET_SIZE;
+                    Data->ByteCount=0;
+                    Data->BadPacket=false;
+                    Data->DownloadState=e_YModemDownload_PacketNum;
+                }
+                else if(c==YMODEM_EOT)
+                {
+                    if(!YModemDownload_ProcessEOT(SysHandle,Data))
+                        return true;    // Data has been free'ed we are done
+                }
+            break;
+            case e_YModemDownload_PacketNum:
+                Data->RxPacketNum=c;
+                Data->DownloadState=e_YModemDownload_InvPacketNum;
+            break;
+            case e_YModemDownload_InvPacketNum:
+                if((uint8_t)(c^Data->RxPacketNum)!=0xFF)
+                    Data->BadPacket=true;
+                Data->DownloadState=e_YModemDownload_Data;
+            break;
+            case e_YModemDownload_Data:
+                /* Take as much of the block as we have in one go */
+                Copy=Data->ExpectedByteCount-Data->ByteCount;
+                if(Copy>Bytes-b)
+                    Copy=Bytes-b;
+                memcpy(&Data->RxBlock[Data->ByteCount],&RxData[b],Copy);
+                Data->ByteCount+=Copy;
+                b+=Copy-1;
+                if(Data->ByteCount>=Data->ExpectedByteCount)
+                    Data->DownloadState=e_YModemDownload_CRC1;
+            break;
+            case e_YModemDownload_CRC1:
+                Data->RxCRC=c<<8;
+                Data->DownloadState=e_YModemDownload_CRC2;
+            break;
+            case e_YModemDownload_CRC2:
+                Data->RxCRC|=c;
+                if(YModem_CalcCRC(Data->RxBlock,Data->ByteCount)!=Data->RxCRC)
+                    Data->BadPacket=true;
+
+                Data->DownloadState=e_YModemDownload_StartOfHeader;
+                if(!YModemDownload_ProcessPacket(SysHandle,Data))
+                    return true;    // Data has been free'ed we are done
+            break;
+            case e_YModemDownloadMAX:
+            default:
+                Data->DownloadState=e_YModemDownload_StartOfHeader;
+            break;
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_Timeout
+ *
+ * SYNOPSIS:
+ *    static void YModemDownload_Timeout(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    This function is called when the timeout timer (set with SetTimeout())
+ *    goes off (once a second).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemDownload_Timeout(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct YModemDownloadData *Data=(struct YModemDownloadData *)DataHandle;
+
+    Data->LastByteTimeout++;
+    Data->LastPacketTimeout++;
+
+    if(!Data->GotFirstHeader)
+    {
+        Data->StartTimeout++;
+        if(Data->StartTimeout>Data->MaxStartWaitTime)
+        {
+            YModemDownload_Fail(SysHandle,Data,"Time out waiting to start");
+            return;    // Data has been free'ed we are done
+        }
+    }
+    else if(Data->LastPacketTimeout>=Data->MaxPacketWaitTime)
+    {
+        YModemDownload_Fail(SysHandle,Data,"Time out waiting for packet");
+        return;    // Data has been free'ed we are done
+    }
+
+    if(Data->Waiting4Header &&
+            Data->DownloadState==e_YModemDownload_StartOfHeader)
+    {
+        /* Keep asking for the header until we get it */
+        Data->TimeSinceLastStartChar++;
+        if(Data->TimeSinceLastStartChar>=YMODEM_DOWNLOAD_START_TIMEOUT)
+            YModemDownload_SendStart(SysHandle,Data);
+    }
+    else if(!Data->Streaming &&
+            Data->LastByteTimeout>=YMODEM_DOWNLOAD_WAIT4QUIET_TIMEOUT &&
+            Data->DownloadState!=e_YModemDownload_StartOfHeader)
+    {
+        /* We lost part of a packet and the line has gone quiet, ask for it
+           again */
+        Data->DownloadState=e_YModemDownload_StartOfHeader;
+        YModemDownload_SendByte(SysHandle,YMODEM_NAK);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_GetLastErrorMsg
+ *
+ * SYNOPSIS:
+ *    static const char *YModemDownload_GetLastErrorMsg(
+ *          t_FTPSystemData *SysHandle,t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    This function gets the last error message from the system.  The system
+ *    will call then when a function returns an error or abort to find more
+ *    details.
+ *
+ * RETURNS:
+ *    A pointer to an error message or NULL if there was no message.  This must
+ *    remain valid until the next call to any 'FileTransferHandlerAPI' function.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static const char *YModemDownload_GetLastErrorMsg(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct YModemDownloadData *Data=(struct YModemDownloadData *)DataHandle;
+
+    if(Data->ErrorStr=="")
+        return NULL;
+
+    return Data->ErrorStr.c_str();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_ProcessPacket
+ *
+ * SYNOPSIS:
+ *    static bool YModemDownload_ProcessPacket(t_FTPSystemData *SysHandle,
+ *          struct YModemDownloadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data
+ *
+ * FUNCTION:
+ *    This function handles a packet that we have finished getting.  Bad
+ *    packets are NAK'ed (or abort the transfer in YModem-G).
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The download has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool YModemDownload_ProcessPacket(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data)
+{
+    uint64_t WriteBytes;
+
+    if(Data->BadPacket)
+    {
+        if(Data->Streaming)
+        {
+            YModemDownload_Fail(SysHandle,Data,"Bad packet (YModem-G can't "
+                    "resend)");
+            return false;
+        }
+        YModemDownload_SendByte(SysHandle,YMODEM_NAK);
+        return true;
+    }
+
+    if(Data->Waiting4Header)
+        return YModemDownload_ProcessHeader(SysHandle,Data);
+
+    if(Data->RxPacketNum!=Data->PacketNum)
+    {
+        if(Data->Streaming)
+        {
+            YModemDownload_Fail(SysHandle,Data,"Lost a packet (YModem-G "
+                    "can't resend)");
+            return false;
+        }
+
+        if(Data->RxPacketNum==(uint8_t)(Data->PacketNum-1))
+        {
+            /* They didn't get our ACK, we already have this one */
+            YModemDownload_SendByte(SysHandle,YMODEM_ACK);
+            if(Data->RxPacketNum==0)
+                YModemDownload_SendStart(SysHandle,Data);
+            return true;
+        }
+
+        YModemDownload_SendByte(SysHandle,YMODEM_NAK);
+        return true;
+    }
+
+    /* Trim the padding off the end of the file */
+    WriteBytes=Data->ByteCount;
+    if(Data->FileSizeKnown)
+    {
+        if(Data->FileBytes>=Data->FileSize)
+            WriteBytes=0;
+        else if(Data->FileSize-Data->FileBytes<WriteBytes)
+            WriteBytes=Data->FileSize-Data->FileBytes;
+    }
+
+    if(WriteBytes>0 && fwrite(Data->RxBlock,WriteBytes,1,Data->FileHandle)!=1)
+    {
+        YModemDownload_Fail(SysHandle,Data,"Failed to write to the file");
+        return false;
+    }
+
+    Data->FileBytes+=WriteBytes;
+    Data->BytesRx+=WriteBytes;
+    Data->PacketNum++;
+    Data->LastPacketTimeout=0;
+    Data->EOTCount=0;
+
+    if(!Data->Streaming)
+        YModemDownload_SendByte(SysHandle,YMODEM_ACK);
+
+    m_FTPS->DLProgress(SysHandle,Data->BytesRx);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_ProcessHeader
+ *
+ * SYNOPSIS:
+ *    static bool YModemDownload_ProcessHeader(t_FTPSystemData *SysHandle,
+ *          struct YModemDownloadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data
+ *
+ * FUNCTION:
+ *    This function handles a block 0.  An empty name ends the batch,
+ *    otherwise we open the file and ask for the data.
+ *
+ *    Only the name part of the filename the sender gives us is used (so
+ *    they can't write outside the directory the user picked).
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The download has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool YModemDownload_ProcessHeader(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data)
+{
+    string RxName;
+    string SaveName;
+    string::size_type Sep;
+    const char *SizeStart;
+    char *SizeEnd;
+    int NameLen;
+
+    if(Data->RxPacketNum!=0)
+    {
+        /* Not a header, they must have missed our start */
+        if(Data->Streaming)
+        {
+            YModemDownload_Fail(SysHandle,Data,"Expected a YModem header");
+            return false;
+        }
+        YModemDownload_SendByte(SysHandle,YMODEM_NAK);
+        return true;
+    }
+
+    Data->GotFirstHeader=true;
+    Data->LastPacketTimeout=0;
+
+    /* The block is 'name' NUL 'size' ' ' ... NUL */
+    for(NameLen=0;NameLen<Data->ByteCount;NameLen++)
+        if(Data->RxBlock[NameLen]==0)
+            break;
+
+    if(NameLen==0)
+    {
+        /* End of the batch */
+        if(!Data->Streaming)
+            YModemDownload_SendByte(SysHandle,YMODEM_ACK);
+        Data->ErrorStr="";
+        m_FTPS->DLFinish(SysHandle,false);
+        return false;
+    }
+    if(NameLen>=Data->ByteCount)
+    {
+        YModemDownload_Fail(SysHandle,Data,"Bad YModem header");
+        return false;
+    }
+
+    RxName.assign((char *)Data->RxBlock,NameLen);
+
+    Data->FileSizeKnown=false;
+    Data->FileSize=0;
+    Data->RxBlock[Data->ByteCount-1]=0;    // Make sure the size ends
+    SizeStart=(char *)&Data->RxBlock[NameLen+1];
+    if(*SizeStart>='0' && *SizeStart<='9')
+    {
+        Data->FileSize=strtoull(SizeStart,&SizeEnd,10);
+        Data->FileSizeKnown=true;
+    }
+
+    if(Data->FilesDone==0)
+    {
+        SaveName=Data->FirstFilename;
+    }
+    else
+    {
+        Sep=RxName.find_last_of("/\\");
+        if(Sep!=string::npos)
+            RxName.erase(0,Sep+1);
+        if(RxName=="" || RxName=="." || RxName=="..")
+            RxName="ymodem.bin";
+        SaveName=Data->SaveDir+RxName;
+    }
+
+    Data->FileHandle=fopen(SaveName.c_str(),"wb");
+    if(Data->FileHandle==NULL)
+    {
+        YModemDownload_Fail(SysHandle,Data,"Failed to open the file");
+        return false;
+    }
+
+    Data->Waiting4Header=false;
+    Data->PacketNum=1;
+    Data->FileBytes=0;
+    Data->EOTCount=0;
+
+    /* Ask for the data */
+    if(!Data->Streaming)
+        YModemDownload_SendByte(SysHandle,YMODEM_ACK);
+    YModemDownload_SendStart(SysHandle,Data);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_ProcessEOT
+ *
+ * SYNOPSIS:
+ *    static bool YModemDownload_ProcessEOT(t_FTPSystemData *SysHandle,
+ *          struct YModemDownloadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data
+ *
+ * FUNCTION:
+ *    This function handles the end of a file.  In YModem we NAK the first
+ *    EOT (so line noise can't end the file) and ACK the second.  Then we ask
+ *    for the next header.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The download has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool YModemDownload_ProcessEOT(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data)
+{
+    if(Data->Waiting4Header)
+    {
+        /* They missed our ACK to the EOT */
+        if(Data->FilesDone>0)
+            YModemDownload_SendByte(SysHandle,YMODEM_ACK);
+        return true;
+    }
+
+    Data->LastPacketTimeout=0;
+    if(!Data->Streaming && Data->EOTCount==0)
+    {
+        Data->EOTCount++;
+        YModemDownload_SendByte(SysHandle,YMODEM_NAK);
+        return true;
+    }
+
+    fclose(Data->FileHandle);
+    Data->FileHandle=NULL;
+    Data->FilesDone++;
+
+    Data->Waiting4Header=true;
+    Data->PacketNum=0;
+
+    YModemDownload_SendByte(SysHandle,YMODEM_ACK);
+    YModemDownload_SendStart(SysHandle,Data);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_SendByte
+ *
+ * SYNOPSIS:
+ *    static void YModemDownload_SendByte(t_FTPSystemData *SysHandle,
+ *          uint8_t c);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    c [I] -- The byte to send (ACK, NAK, etc)
+ *
+ * FUNCTION:
+ *    This function sends a control byte to the sender.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemDownload_SendByte(t_FTPSystemData *SysHandle,uint8_t c)
+{
+    m_FTPS->DLSendData(SysHandle,&c,1);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_SendStart
+ *
+ * SYNOPSIS:
+ *    static void YModemDownload_SendStart(t_FTPSystemData *SysHandle,
+ *          struct YModemDownloadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data
+ *
+ * FUNCTION:
+ *    This function asks the sender for the next thing ('C' for YModem, 'G'
+ *    for YModem-G).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemDownload_SendStart(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data)
+{
+    Data->TimeSinceLastStartChar=0;
+    YModemDownload_SendByte(SysHandle,Data->Streaming?'G':'C');
+}
+
+/*******************************************************************************
+ * NAME:
+ *    YModemDownload_Fail
+ *
+ * SYNOPSIS:
+ *    static void YModemDownload_Fail(t_FTPSystemData *SysHandle,
+ *          struct YModemDownloadData *Data,const char *Msg);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data
+ *    Msg [I] -- Why we are giving up
+ *
+ * FUNCTION:
+ *    This function cancels the transfer (tells the sender) and finishes the
+ *    download.  'Data' is no longer valid after this.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void YModemDownload_Fail(t_FTPSystemData *SysHandle,
+        struct YModemDownloadData *Data,const char *Msg)
+{
+    uint8_t Block[YMODEM_CAN_COUNT];
+
+    memset(Block,YMODEM_CAN,sizeof(Block));
+    m_FTPS->DLSendData(SysHandle,Block,sizeof(Block));
+
+    Data->ErrorStr=Msg;
+    m_FTPS->DLFinish(SysHandle,true);
+}
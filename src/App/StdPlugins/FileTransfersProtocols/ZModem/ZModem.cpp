@@ -0,0 +1,3506 @@
+/*******************************************************************************
+ * FILENAME: ZModem.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This is the driver for a ZModem transfer (up and down).
+ *
+ *    ZModem streams the file as data subpackets with a CRC on each one.  The
+ *    receiver never ACK's the data, if it finds an error it sends a ZRPOS
+ *    with where it wants the sender to start again.  The same ZRPOS is used
+ *    at the start of each file so the receiver can resume a file that was
+ *    cut off part way.
+ *
+ *    Positions on the wire are only 32 bits so we keep 64 bit positions and
+ *    take the wire value as the one closest to where we are.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "ZModem.h"
+#include "PluginSDK/Plugin.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <inttypes.h>
+#include <string>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define REGISTER_PLUGIN_FUNCTION_PRIV_NAME      ZModem // The name to append on the RegisterPlugin() function for built in version
+#define NEEDED_MIN_API_VERSION                  0x02020000
+
+#define ZMODEM_BLOCK_SIZE                   1024    // Data bytes in each subpacket we send
+#define ZMODEM_MAX_SUBPACKET                8192    // Biggest subpacket we will take
+#define ZMODEM_READAHEAD_SIZE               (64*1024)
+#define ZMODEM_TX_BUFF_SIZE                 (ZMODEM_BLOCK_SIZE*2+128)
+#define ZMODEM_MAX_FILENAME                 512
+#define MAX_START_WAIT_TIME                 90  // Seconds for the other side to startup
+#define MAX_PACKET_WAIT_TIME                30  // Seconds with nothing useful before we abort
+#define ZMODEM_MAX_SAME_RPOS                12  // ZRPOS to the same place before we give up
+
+#define ZMODEM_TICK_MS                      1000    // Normal timeout tick
+#define ZMODEM_STREAM_TICK_MS               10      // Tick while we are feeding the driver
+#define ZMODEM_STREAM_BURST                 256     // Most subpackets we queue per tick
+#define ZMODEM_RESEND_MS                    10000   // How long before we resend a header
+#define ZMODEM_QUIET_TIMEOUT                5       // Seconds of nothing before the rx asks again
+#define ZMODEM_PROGRESS_EVERY               (64*1024)
+
+/* Framing */
+#define ZPAD                '*'
+#define ZDLE                0x18
+#define ZBIN                'A'
+#define ZHEX                'B'
+#define ZBIN32              'C'
+#define ZCRCE               'h'     // End of frame, header follows
+#define ZCRCG               'i'     // Frame continues
+#define ZCRCQ               'j'     // Frame continues, ZACK wanted
+#define ZCRCW               'k'     // End of frame, ZACK wanted
+#define ZRUB0               'l'     // 0x7F
+#define ZRUB1               'm'     // 0xFF
+#define XON                 0x11
+#define XOFF                0x13
+#define CAN                 0x18
+
+/* Frame types */
+#define ZRQINIT             0
+#define ZRINIT              1
+#define ZSINIT              2
+#define ZACK                3
+#define ZFILE               4
+#define ZSKIP               5
+#define ZNAK                6
+#define ZABORT              7
+#define ZFIN                8
+#define ZRPOS               9
+#define ZDATA               10
+#define ZEOF                11
+#define ZFERR               12
+#define ZCRC                13
+#define ZCHALLENGE          14
+#define ZCOMPL              15
+#define ZCAN                16
+#define ZFREECNT            17
+#define ZCOMMAND            18
+
+/* Where things are in the 4 header bytes */
+#define ZP0                 0
+#define ZP1                 1
+#define ZF1                 2
+#define ZF0                 3
+
+/* ZRINIT flags (ZF0) */
+#define CANFDX              0x01
+#define CANOVIO             0x02
+#define CANFC32             0x20
+#define ESCCTL              0x40
+
+/* ZFILE conversion (ZF0) */
+#define ZCBIN               1
+#define ZCRESUM             3
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+typedef enum
+{
+    e_ZRxState_Hunt,                // Looking for a ZPAD
+    e_ZRxState_Pad,                 // Have ZPAD, want ZDLE
+    e_ZRxState_Format,              // Have ZPAD ZDLE, want A/B/C
+    e_ZRxState_HexHeader,
+    e_ZRxState_BinHeader,
+    e_ZRxState_Data,
+    e_ZRxStateMAX
+} e_ZRxStateType;
+
+typedef enum
+{
+    e_ZRxEvent_None,                // Used everything, nothing to report
+    e_ZRxEvent_Header,
+    e_ZRxEvent_BadHeader,
+    e_ZRxEvent_Data,
+    e_ZRxEvent_BadData,
+    e_ZRxEvent_Cancel,              // The other side sent a string of CAN's
+    e_ZRxEventMAX
+} e_ZRxEventType;
+
+/* Pulls headers and data subpackets out of the incoming bytes */
+struct ZModemRx
+{
+    e_ZRxStateType State;
+    bool Escaped;               // The last byte was a ZDLE
+    int CANCount;
+    bool Use32;                 // The last header was ZBIN32 (so is it's data)
+    char Hex[14];
+    int HexLen;
+    uint8_t Raw[9];             // Binary header (type, 4 bytes, CRC)
+    int RawLen;
+    int RawNeed;
+    bool InCRC;                 // Getting the CRC at the end of the data
+    uint8_t CRC[4];
+    int CRCLen;
+    uint8_t FrameEnd;           // ZCRCE / ZCRCG / ZCRCQ / ZCRCW
+    bool DataReturned;          // 'Data' was handed back, start a new one
+
+    /* Results */
+    uint8_t Type;
+    uint8_t Hdr[4];
+    uint8_t Data[ZMODEM_MAX_SUBPACKET];
+    uint32_t DataLen;
+};
+
+/* Outgoing bytes after ZDLE encoding */
+struct ZModemTx
+{
+    uint8_t Buff[ZMODEM_TX_BUFF_SIZE];
+    uint32_t Len;
+    uint8_t LastSent;
+    bool EscCtl;                // The other side wants all ctrl chars escaped
+    bool Use32;
+};
+
+struct ZModemReadAhead
+{
+    FILE *FileHandle;
+    uint8_t *Buffer;            // ZMODEM_READAHEAD_SIZE bytes
+    uint32_t Pos;
+    uint32_t Len;
+    bool EndOfFile;
+};
+
+typedef enum
+{
+    e_ZSend_Sent,
+    e_ZSend_Busy,               // Left in 'Tx', try again later
+    e_ZSend_Failed,             // The transfer has been finished
+    e_ZSendMAX
+} e_ZSendType;
+
+typedef enum
+{
+    e_ZUpload_Waiting4RInit,
+    e_ZUpload_Waiting4RPos,     // Sent ZFILE
+    e_ZUpload_Sending,
+    e_ZUpload_Waiting4Ack,      // The rx's buffer is full
+    e_ZUpload_Waiting4EOFResp,  // Sent ZEOF
+    e_ZUpload_Waiting4Fin,      // Sent ZFIN
+    e_ZUploadMAX
+} e_ZUploadType;
+
+struct ZModemUploadData
+{
+    struct ZModemRx Rx;
+    struct ZModemTx Tx;
+    bool TxPending;             // 'Tx' still needs to go out
+    struct ZModemReadAhead Reader;
+    string Filename;            // Without the path
+    uint64_t FileSize;
+    uint64_t TxPos;             // File position after what's in 'Tx'
+    uint64_t AckPos;            // Where the rx last told us it was
+    uint64_t LastSyncPos;
+    uint64_t LastProgress;
+    int SameSyncCount;
+    uint32_t RxBuffSize;        // 0 = the rx can take a full stream
+    e_ZUploadType State;
+    bool Resume;
+    uint32_t TickMS;
+    uint32_t IdleMS;            // Time since we heard something useful
+    uint32_t ResendMS;          // Time since we last sent a header
+    int MaxStartWaitTime;
+    int MaxPacketWaitTime;
+    string ErrorStr;
+};
+
+typedef enum
+{
+    e_ZDownload_Waiting4File,
+    e_ZDownload_Waiting4FileInfo,   // Have ZFILE, want the subpacket
+    e_ZDownload_Waiting4SInit,      // Have ZSINIT, want the subpacket
+    e_ZDownload_Waiting4Data,       // Want a ZDATA / ZEOF
+    e_ZDownload_Receiving,
+    e_ZDownloadMAX
+} e_ZDownloadType;
+
+struct ZModemDownloadData
+{
+    struct ZModemRx Rx;
+    struct ZModemTx Tx;
+    FILE *FileHandle;
+    string FirstFilename;       // What the user picked, the first file goes here
+    string SaveDir;             // The rest go here
+    int FilesDone;
+    e_ZDownloadType State;
+    bool Resume;                // Resume even if the sender didn't ask
+    bool SenderWantsResume;
+    uint64_t RxPos;             // Bytes we have of this file
+    uint64_t FileSize;
+    uint64_t BytesRx;           // Bytes written for the whole batch
+    uint64_t LastProgress;
+    bool GotFirstFile;
+    int StartTimeout;
+    int TimeSinceLastRInit;
+    int LastByteTimeout;
+    int LastPacketTimeout;
+    int MaxStartWaitTime;
+    int MaxPacketWaitTime;
+    string ErrorStr;
+};
+
+struct ZModem_Widgets
+{
+    t_WidgetSysHandle *WidgetHandle;
+    struct PI_Checkbox *Resume;
+    struct PI_NumberInput *MaxStartWaitTime;
+    struct PI_NumberInput *PacketTimeOut;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+static void ZModem_BuildTables(void);
+static uint16_t ZModem_CRC16(uint16_t crc,const uint8_t *DataPtr,uint32_t Bytes);
+static uint32_t ZModem_CRC32(uint32_t crc,const uint8_t *DataPtr,
+        uint32_t Bytes);
+static uint64_t ZModem_Pos64(const uint8_t *Hdr,uint64_t Near);
+static void ZModem_SetPos(uint8_t *Hdr,uint64_t Pos);
+static void ZModem_RxReset(struct ZModemRx *Rx);
+static void ZModem_RxExpectData(struct ZModemRx *Rx);
+static e_ZRxEventType ZModem_RxFeed(struct ZModemRx *Rx,const uint8_t *Data,
+        uint32_t Bytes,uint32_t *Used);
+static bool ZModem_RxCheckHeader(struct ZModemRx *Rx,const uint8_t *Bytes,
+        bool Use32);
+static void ZModem_TxReset(struct ZModemTx *Tx);
+static void ZModem_TxEscaped(struct ZModemTx *Tx,const uint8_t *Data,
+        uint32_t Bytes);
+static void ZModem_TxHexHeader(struct ZModemTx *Tx,uint8_t Type,
+        const uint8_t *Hdr);
+static void ZModem_TxBinHeader(struct ZModemTx *Tx,uint8_t Type,
+        const uint8_t *Hdr);
+static void ZModem_TxSubpacket(struct ZModemTx *Tx,const uint8_t *Data,
+        uint32_t Bytes,uint8_t FrameEnd);
+static bool ZModem_ReadAheadOpen(struct ZModemReadAhead *Reader,
+        const char *Filename);
+static void ZModem_ReadAheadClose(struct ZModemReadAhead *Reader);
+static bool ZModem_ReadAheadSeek(struct ZModemReadAhead *Reader,uint64_t Pos);
+static int ZModem_ReadAheadGet(struct ZModemReadAhead *Reader,uint8_t *Dest,
+        int Bytes);
+static t_FTPOptionsWidgetsType *ZModem_AllocWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options,bool Download);
+static void ZModem_FreeWidgets(t_FTPOptionsWidgetsType *FTPOptions);
+static void ZModem_StoreWidgets(t_FTPOptionsWidgetsType *FTPOptions,
+        t_PIKVList *Options);
+static void ZModem_ReadOptions(t_PIKVList *Options,int *MaxStartWaitTime,
+        int *MaxPacketWaitTime,bool *Resume);
+
+static t_FTPHandlerDataType *ZModemUpload_AllocateData(void);
+static void ZModemUpload_FreeData(t_FTPHandlerDataType *DataHandle);
+static t_FTPOptionsWidgetsType *ZModemUpload_AllocOptionsWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options);
+static PG_BOOL ZModemUpload_StartUpload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,const char *FilenameWithPath,
+        const char *FilenameOnly,uint64_t FileSize,t_PIKVList *Options);
+static void ZModemUpload_AbortUpload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static void ZModemUpload_Timeout(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static PG_BOOL ZModemUpload_RxData(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes);
+static const char *ZModemUpload_GetLastErrorMsg(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static PG_BOOL ZModemUpload_Init(t_FTPSystemData *SysHandle);
+static bool ZModemUpload_HandleHeader(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data);
+static e_ZSendType ZModemUpload_Send(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data);
+static bool ZModemUpload_SendHeader(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data,uint8_t Type);
+static bool ZModemUpload_SendFile(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data);
+static bool ZModemUpload_Reposition(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data,uint64_t Pos);
+static bool ZModemUpload_Stream(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data);
+static void ZModemUpload_SetTick(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data,uint32_t MSec);
+static void ZModemUpload_Fail(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data,const char *Msg);
+
+static t_FTPHandlerDataType *ZModemDownload_AllocateData(void);
+static void ZModemDownload_FreeData(t_FTPHandlerDataType *DataHandle);
+static t_FTPOptionsWidgetsType *ZModemDownload_AllocOptionsWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options);
+static PG_BOOL ZModemDownload_StartDownload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,t_PIKVList *Options);
+static void ZModemDownload_AbortDownload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static void ZModemDownload_Timeout(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static PG_BOOL ZModemDownload_RxData(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes);
+static const char *ZModemDownload_GetLastErrorMsg(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle);
+static PG_BOOL ZModemDownload_Init(t_FTPSystemData *SysHandle);
+static bool ZModemDownload_HandleHeader(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data);
+static bool ZModemDownload_HandleData(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data);
+static bool ZModemDownload_OpenFile(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data);
+static void ZModemDownload_SendHeader(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data,uint8_t Type,uint64_t Pos);
+static void ZModemDownload_SendRInit(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data);
+static void ZModemDownload_Fail(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data,const char *Msg);
+
+/*** VARIABLE DEFINITIONS     ***/
+struct FileTransferHandlerAPI m_ZModemUploadCBs=
+{
+    ZModemUpload_AllocateData,
+    ZModemUpload_FreeData,
+    ZModemUpload_AllocOptionsWidgets,
+    ZModem_FreeWidgets,
+    ZModem_StoreWidgets,
+    ZModemUpload_StartUpload,
+    NULL,
+    ZModemUpload_AbortUpload,
+    ZModemUpload_Timeout,
+    ZModemUpload_RxData,
+
+    /* V2 */
+    ZModemUpload_GetLastErrorMsg,
+
+    /* V3 */
+    ZModemUpload_Init,
+    NULL
+
+    /* If you add more remember to add to update 'm_ZModemUpload_Info' to the
+       new version */
+};
+struct FTPHandlerInfo m_ZModemUpload_Info=
+{
+    "ZModemUpload",
+    "ZModem",
+    "Sends a file using ZModem.",
+    "Sends a file using ZModem.  The file is streamed and the receiver "
+            "asks for any part it missed again.  With resume on the "
+            "receiver can carry on from the end of a file it already has "
+            "part of.",
+    FILE_TRANSFER_HANDLER_API_VERSION_3,
+    FTPS_API_VERSION_2,
+    &m_ZModemUploadCBs,
+    e_FileTransferProtocolMode_Upload
+};
+
+struct FileTransferHandlerAPI m_ZModemDownloadCBs=
+{
+    ZModemDownload_AllocateData,
+    ZModemDownload_FreeData,
+    ZModemDownload_AllocOptionsWidgets,
+    ZModem_FreeWidgets,
+    ZModem_StoreWidgets,
+    NULL,
+    ZModemDownload_StartDownload,
+    ZModemDownload_AbortDownload,
+    ZModemDownload_Timeout,
+    ZModemDownload_RxData,
+
+    /* V2 */
+    ZModemDownload_GetLastErrorMsg,
+
+    /* V3 */
+    ZModemDownload_Init,
+    NULL
+
+    /* If you add more remember to add to update 'm_ZModemDownload_Info' to
+       the new version */
+};
+struct FTPHandlerInfo m_ZModemDownload_Info=
+{
+    "ZModemDownload",
+    "ZModem",
+    "Receive files using ZModem.",
+    "Receive a batch of files using ZModem.  The first file is saved to "
+            "the filename you pick, any others are saved next to it using "
+            "the names the sender gives.  If the file is already there and "
+            "resume is on (or the sender asks for it) the transfer carries "
+            "on from the end of the file.",
+    FILE_TRANSFER_HANDLER_API_VERSION_3,
+    FTPS_API_VERSION_2,
+    &m_ZModemDownloadCBs,
+    e_FileTransferProtocolMode_Download,
+};
+
+static const struct PI_UIAPI *m_UIAPI;
+static const struct PI_SystemAPI *m_System;
+static const struct FTPS_API *m_FTPS;
+
+static uint32_t m_CRC32Table[256];
+static bool m_ZEscape[256];         // Always ZDLE encode these
+static bool m_ZRxSpecial[256];      // Bytes the rx can't just copy
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_RegisterPlugin
+ *
+ * SYNOPSIS:
+ *    unsigned int ZModem_RegisterPlugin(const struct PI_SystemAPI *SysAPI,
+ *          unsigned int Version);
+ *
+ * PARAMETERS:
+ *    SysAPI [I] -- The main API to WhippyTerm
+ *    Version [I] -- What version of WhippyTerm is running.  This is used
+ *                   to make sure we are compatible.  This is in the
+ *                   Major<<24 | Minor<<16 | Rev<<8 | Patch format
+ *
+ * FUNCTION:
+ *    This function registers this plugin with the system.
+ *
+ * RETURNS:
+ *    0 if we support this version of WhippyTerm, and the minimum version
+ *    we need if we are not.
+ *
+ * NOTES:
+ *    This function is normally is called from the RegisterPlugin() when
+ *    it is being used as a normal plugin.  As a std plugin it is called
+ *    from RegisterStdPlugins() instead.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+/* This needs to be extern "C" because it is the main entry point for the
+   plugin system */
+extern "C"
+{
+    unsigned int REGISTER_PLUGIN_FUNCTION(const struct PI_SystemAPI *SysAPI,
+            unsigned int Version)
+    {
+        if(Version<NEEDED_MIN_API_VERSION)
+            return NEEDED_MIN_API_VERSION;
+
+        m_System=SysAPI;
+        m_FTPS=SysAPI->GetAPI_FileTransfersProtocol();
+        m_UIAPI=m_FTPS->GetAPI_UI();
+
+        /* If we are have the correct experimental API */
+        if(m_System->GetExperimentalID()>0 &&
+                m_System->GetExperimentalID()<1)
+        {
+            return 0xFFFFFFFF;
+        }
+
+        ZModem_BuildTables();
+
+        m_FTPS->RegisterFileTransferProtocol(&m_ZModemUpload_Info);
+        m_FTPS->RegisterFileTransferProtocol(&m_ZModemDownload_Info);
+
+        return 0;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_BuildTables
+ *
+ * SYNOPSIS:
+ *    static void ZModem_BuildTables(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function fills in the CRC32 table and the tables of which bytes
+ *    need ZDLE encoding.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModem_BuildTables(void)
+{
+    uint32_t crc;
+    int r;
+    int b;
+
+    for(r=0;r<256;r++)
+    {
+        crc=r;
+        for(b=0;b<8;b++)
+        {
+            if(crc&1)
+                crc=(crc>>1)^0xEDB88320;
+            else
+                crc=crc>>1;
+        }
+        m_CRC32Table[r]=crc;
+    }
+
+    memset(m_ZEscape,0x00,sizeof(m_ZEscape));
+    m_ZEscape[ZDLE]=true;
+    m_ZEscape[0x10]=true;       // DLE
+    m_ZEscape[0x90]=true;
+    m_ZEscape[XON]=true;
+    m_ZEscape[XON|0x80]=true;
+    m_ZEscape[XOFF]=true;
+    m_ZEscape[XOFF|0x80]=true;
+
+    memset(m_ZRxSpecial,0x00,sizeof(m_ZRxSpecial));
+    m_ZRxSpecial[ZDLE]=true;
+    m_ZRxSpecial[XON]=true;
+    m_ZRxSpecial[XON|0x80]=true;
+    m_ZRxSpecial[XOFF]=true;
+    m_ZRxSpecial[XOFF|0x80]=true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_CRC16
+ *
+ * SYNOPSIS:
+ *    static uint16_t ZModem_CRC16(uint16_t crc,const uint8_t *DataPtr,
+ *          uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    crc [I] -- The CRC so far (start with 0)
+ *    DataPtr [I] -- The data to add to the CRC
+ *    Bytes [I] -- The number of bytes in 'DataPtr'
+ *
+ * FUNCTION:
+ *    This function adds bytes to a CRC16 (the XModem one).
+ *
+ * RETURNS:
+ *    The new CRC.
+ *
+ * SEE ALSO:
+ *    ZModem_CRC32()
+ ******************************************************************************/
+static uint16_t ZModem_CRC16(uint16_t crc,const uint8_t *DataPtr,uint32_t Bytes)
+{
+    int i;
+
+    while(Bytes-->0)
+    {
+        crc=crc^(uint16_t)(*DataPtr++)<<8;
+        for(i=0;i<8;i++)
+        {
+            if(crc&0x8000)
+                crc=crc<<1^0x1021;
+            else
+                crc=crc<<1;
+        }
+    }
+    return crc;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_CRC32
+ *
+ * SYNOPSIS:
+ *    static uint32_t ZModem_CRC32(uint32_t crc,const uint8_t *DataPtr,
+ *          uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    crc [I] -- The CRC so far (start with 0xFFFFFFFF)
+ *    DataPtr [I] -- The data to add to the CRC
+ *    Bytes [I] -- The number of bytes in 'DataPtr'
+ *
+ * FUNCTION:
+ *    This function adds bytes to a CRC32.  The value that goes on the wire
+ *    is the inverse of the final CRC (low byte first).
+ *
+ * RETURNS:
+ *    The new CRC.
+ *
+ * SEE ALSO:
+ *    ZModem_CRC16()
+ ******************************************************************************/
+static uint32_t ZModem_CRC32(uint32_t crc,const uint8_t *DataPtr,
+        uint32_t Bytes)
+{
+    while(Bytes-->0)
+        crc=m_CRC32Table[(crc^*DataPtr++)&0xFF]^(crc>>8);
+    return crc;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_Pos64
+ *
+ * SYNOPSIS:
+ *    static uint64_t ZModem_Pos64(const uint8_t *Hdr,uint64_t Near);
+ *
+ * PARAMETERS:
+ *    Hdr [I] -- The 4 header bytes with the position in them
+ *    Near [I] -- Where we are in the file
+ *
+ * FUNCTION:
+ *    This function gets a position out of a header.  ZModem only has 32 bits
+ *    for the position so for files over 4G we take the position that is
+ *    closest to where we are.
+ *
+ * RETURNS:
+ *    The 64 bit position.
+ *
+ * SEE ALSO:
+ *    ZModem_SetPos()
+ ******************************************************************************/
+static uint64_t ZModem_Pos64(const uint8_t *Hdr,uint64_t Near)
+{
+    uint64_t Pos;
+
+    Pos=(uint32_t)Hdr[ZP0] | (uint32_t)Hdr[ZP1]<<8 | (uint32_t)Hdr[2]<<16 |
+            (uint32_t)Hdr[3]<<24;
+    Pos|=Near&~0xFFFFFFFFULL;
+
+    if(Pos>Near+0x80000000ULL && Pos>=0x100000000ULL)
+        Pos-=0x100000000ULL;
+    else if(Pos+0x80000000ULL<Near)
+        Pos+=0x100000000ULL;
+
+    return Pos;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_SetPos
+ *
+ * SYNOPSIS:
+ *    static void ZModem_SetPos(uint8_t *Hdr,uint64_t Pos);
+ *
+ * PARAMETERS:
+ *    Hdr [O] -- The 4 header bytes to fill in
+ *    Pos [I] -- The position to put in the header (only the low 32 bits go)
+ *
+ * FUNCTION:
+ *    This function puts a position in a header.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ZModem_Pos64()
+ ******************************************************************************/
+static void ZModem_SetPos(uint8_t *Hdr,uint64_t Pos)
+{
+    Hdr[0]=Pos&0xFF;
+    Hdr[1]=(Pos>>8)&0xFF;
+    Hdr[2]=(Pos>>16)&0xFF;
+    Hdr[3]=(Pos>>24)&0xFF;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_RxReset
+ *
+ * SYNOPSIS:
+ *    static void ZModem_RxReset(struct ZModemRx *Rx);
+ *
+ * PARAMETERS:
+ *    Rx [I] -- The receive state to reset
+ *
+ * FUNCTION:
+ *    This function sets the receive state back to looking for a header.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ZModem_RxFeed()
+ ******************************************************************************/
+static void ZModem_RxReset(struct ZModemRx *Rx)
+{
+    Rx->State=e_ZRxState_Hunt;
+    Rx->Escaped=false;
+    Rx->CANCount=0;
+    Rx->Use32=false;
+    Rx->InCRC=false;
+    Rx->DataLen=0;
+    Rx->DataReturned=false;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_RxExpectData
+ *
+ * SYNOPSIS:
+ *    static void ZModem_RxExpectData(struct ZModemRx *Rx);
+ *
+ * PARAMETERS:
+ *    Rx [I] -- The receive state
+ *
+ * FUNCTION:
+ *    This function is called after a header that has data after it (ZFILE,
+ *    ZDATA, ZSINIT).  The next bytes are taken as a data subpacket with the
+ *    same CRC as the header.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ZModem_RxFeed()
+ ******************************************************************************/
+static void ZModem_RxExpectData(struct ZModemRx *Rx)
+{
+    Rx->State=e_ZRxState_Data;
+    Rx->Escaped=false;
+    Rx->InCRC=false;
+    Rx->DataLen=0;
+    Rx->DataReturned=false;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_RxCheckHeader
+ *
+ * SYNOPSIS:
+ *    static bool ZModem_RxCheckHeader(struct ZModemRx *Rx,
+ *          const uint8_t *Bytes,bool Use32);
+ *
+ * PARAMETERS:
+ *    Rx [I] -- The receive state.  The type and header bytes are copied
+ *              into this.
+ *    Bytes [I] -- The type, 4 header bytes, then the CRC
+ *    Use32 [I] -- The CRC is a CRC32 (else CRC16)
+ *
+ * FUNCTION:
+ *    This function checks the CRC on a header.
+ *
+ * RETURNS:
+ *    true -- The header is good
+ *    false -- Bad CRC
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool ZModem_RxCheckHeader(struct ZModemRx *Rx,const uint8_t *Bytes,
+        bool Use32)
+{
+    uint32_t crc32;
+    uint16_t crc16;
+
+    Rx->Type=Bytes[0];
+    memcpy(Rx->Hdr,&Bytes[1],4);
+
+    if(Use32)
+    {
+        crc32=~ZModem_CRC32(0xFFFFFFFF,Bytes,5);
+        return Bytes[5]==(crc32&0xFF) && Bytes[6]==((crc32>>8)&0xFF) &&
+                Bytes[7]==((crc32>>16)&0xFF) && Bytes[8]==(crc32>>24);
+    }
+
+    crc16=ZModem_CRC16(0,Bytes,5);
+    return Bytes[5]==(crc16>>8) && Bytes[6]==(crc16&0xFF);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_RxFeed
+ *
+ * SYNOPSIS:
+ *    static e_ZRxEventType ZModem_RxFeed(struct ZModemRx *Rx,
+ *          const uint8_t *Data,uint32_t Bytes,uint32_t *Used);
+ *
+ * PARAMETERS:
+ *    Rx [I] -- The receive state
+ *    Data [I] -- The bytes that came in
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *    Used [O] -- How many bytes of 'Data' we used.  Call again with the
+ *                rest.
+ *
+ * FUNCTION:
+ *    This function takes the incoming bytes and pulls the headers and data
+ *    subpackets out of them.  It stops as soon as it has something (so the
+ *    caller can call ZModem_RxExpectData() before the data starts).
+ *
+ *    Data that isn't in a frame is skipped.
+ *
+ * RETURNS:
+ *    e_ZRxEvent_None -- Used all the bytes without finding anything
+ *    e_ZRxEvent_Header -- 'Type' and 'Hdr' have a header
+ *    e_ZRxEvent_BadHeader -- A header with a bad CRC
+ *    e_ZRxEvent_Data -- 'Data' has a subpacket, 'FrameEnd' says what kind
+ *    e_ZRxEvent_BadData -- A subpacket with a bad CRC (or too long)
+ *    e_ZRxEvent_Cancel -- The other side sent 5 CAN's
+ *
+ * SEE ALSO:
+ *    ZModem_RxExpectData()
+ ******************************************************************************/
+static e_ZRxEventType ZModem_RxFeed(struct ZModemRx *Rx,const uint8_t *Data,
+        uint32_t Bytes,uint32_t *Used)
+{
+    uint32_t crc32;
+    uint16_t crc16;
+    uint32_t r;
+    uint32_t Start;
+    uint8_t c;
+    int h;
+    bool Good;
+
+    if(Rx->DataReturned)
+    {
+        /* The caller has taken the last subpacket */
+        Rx->DataLen=0;
+        Rx->DataReturned=false;
+    }
+
+    for(r=0;r<Bytes;r++)
+    {
+        c=Data[r];
+
+        if(c==CAN)
+        {
+            Rx->CANCount++;
+            if(Rx->CANCount>=5)
+            {
+                ZModem_RxReset(Rx);
+                *Used=r+1;
+                return e_ZRxEvent_Cancel;
+            }
+        }
+        else
+        {
+            Rx->CANCount=0;
+        }
+
+        switch(Rx->State)
+        {
+            case e_ZRxState_Hunt:
+                if(c==ZPAD)
+                    Rx->State=e_ZRxState_Pad;
+            break;
+            case e_ZRxState_Pad:
+                if(c==ZDLE)
+                    Rx->State=e_ZRxState_Format;
+                else if(c!=ZPAD)
+                    Rx->State=e_ZRxState_Hunt;
+            break;
+            case e_ZRxState_Format:
+                Rx->Escaped=false;
+                Rx->RawLen=0;
+                Rx->HexLen=0;
+                if(c==ZHEX)
+                {
+                    Rx->Use32=false;
+                    Rx->State=e_ZRxState_HexHeader;
+                }
+                else if(c==ZBIN || c==ZBIN32)
+                {
+                    Rx->Use32=(c==ZBIN32);
+                    Rx->RawNeed=Rx->Use32?9:7;
+                    Rx->State=e_ZRxState_BinHeader;
+                }
+                else
+                {
+                    Rx->State=e_ZRxState_Hunt;
+                }
+            break;
+            case e_ZRxState_HexHeader:
+                if((c>='0' && c<='9') || (c>='a' && c<='f') ||
+                        (c>='A' && c<='F'))
+                {
+                    Rx->Hex[Rx->HexLen++]=c;
+                    if(Rx->HexLen<14)
+                        break;
+
+                    for(h=0;h<7;h++)
+                    {
+                        Rx->Raw[h]=strtoul(string(&Rx->Hex[h*2],2).c_str(),
+                                NULL,16);
+                    }
+                    Good=ZModem_RxCheckHeader(Rx,Rx->Raw,false);
+                }
+                else
+                {
+                    Good=false;
+                }
+                Rx->State=e_ZRxState_Hunt;
+                *Used=r+1;
+                return Good?e_ZRxEvent_Header:e_ZRxEvent_BadHeader;
+            case e_ZRxState_BinHeader:
+                if(Rx->Escaped)
+                {
+                    Rx->Escaped=false;
+                    if(c==ZRUB0)
+                        c=0x7F;
+                    else if(c==ZRUB1)
+                        c=0xFF;
+                    else
+                        c^=0x40;
+                }
+                else if(c==ZDLE)
+                {
+                    Rx->Escaped=true;
+                    break;
+                }
+                else if(m_ZRxSpecial[c])
+                {
+                    /* Flow control */
+                    break;
+                }
+                Rx->Raw[Rx->RawLen++]=c;
+                if(Rx->RawLen<Rx->RawNeed)
+                    break;
+
+                Rx->State=e_ZRxState_Hunt;
+                *Used=r+1;
+                if(ZModem_RxCheckHeader(Rx,Rx->Raw,Rx->Use32))
+                    return e_ZRxEvent_Header;
+                return e_ZRxEvent_BadHeader;
+            case e_ZRxState_Data:
+                if(!Rx->Escaped && !Rx->InCRC)
+                {
+                    /* Copy everything up to the next special byte */
+                    Start=r;
+                    while(r<Bytes && !m_ZRxSpecial[Data[r]])
+                        r++;
+                    if(r>Start)
+                    {
+                        if(Rx->DataLen+(r-Start)>ZMODEM_MAX_SUBPACKET)
+                        {
+                            Rx->State=e_ZRxState_Hunt;
+                            *Used=r;
+                            return e_ZRxEvent_BadData;
+                        }
+                        memcpy(&Rx->Data[Rx->DataLen],&Data[Start],r-Start);
+                        Rx->DataLen+=r-Start;
+                        Rx->CANCount=0;
+                    }
+                    if(r>=Bytes)
+                    {
+                        *Used=Bytes;
+                        return e_ZRxEvent_None;
+                    }
+                    c=Data[r];
+                    if(c==CAN)
+                        Rx->CANCount=1;
+                }
+
+                if(Rx->Escaped)
+                {
+                    Rx->Escaped=false;
+                    if(!Rx->InCRC && c>=ZCRCE && c<=ZCRCW)
+                    {
+                        Rx->FrameEnd=c;
+                        Rx->InCRC=true;
+                        Rx->CRCLen=0;
+                        break;
+                    }
+                    if(c==ZRUB0)
+                        c=0x7F;
+                    else if(c==ZRUB1)
+                        c=0xFF;
+                    else
+                        c^=0x40;
+                }
+                else if(c==ZDLE)
+                {
+                    Rx->Escaped=true;
+                    break;
+                }
+                else if(m_ZRxSpecial[c])
+                {
+                    break;
+                }
+
+                if(!Rx->InCRC)
+                {
+                    if(Rx->DataLen>=ZMODEM_MAX_SUBPACKET)
+                    {
+                        Rx->State=e_ZRxState_Hunt;
+                        *Used=r+1;
+                        return e_ZRxEvent_BadData;
+                    }
+                    Rx->Data[Rx->DataLen++]=c;
+                    break;
+                }
+
+                Rx->CRC[Rx->CRCLen++]=c;
+                if(Rx->CRCLen<(Rx->Use32?4:2))
+                    break;
+
+                /* The CRC covers the data and the frame end */
+                if(Rx->Use32)
+                {
+                    crc32=ZModem_CRC32(0xFFFFFFFF,Rx->Data,Rx->DataLen);
+                    crc32=~ZModem_CRC32(crc32,&Rx->FrameEnd,1);
+                    Good=Rx->CRC[0]==(crc32&0xFF) &&
+                            Rx->CRC[1]==((crc32>>8)&0xFF) &&
+                            Rx->CRC[2]==((crc32>>16)&0xFF) &&
+                            Rx->CRC[3]==(crc32>>24);
+                }
+                else
+                {
+                    crc16=ZModem_CRC16(0,Rx->Data,Rx->DataLen);
+                    crc16=ZModem_CRC16(crc16,&Rx->FrameEnd,1);
+                    Good=Rx->CRC[0]==(crc16>>8) && Rx->CRC[1]==(crc16&0xFF);
+                }
+
+                Rx->InCRC=false;
+                Rx->State=e_ZRxState_Hunt;
+                if(Good && (Rx->FrameEnd==ZCRCG || Rx->FrameEnd==ZCRCQ))
+                {
+                    /* More subpackets follow (the caller takes the data
+                       before the next call) */
+                    Rx->State=e_ZRxState_Data;
+                }
+                *Used=r+1;
+                if(!Good)
+                    return e_ZRxEvent_BadData;
+                Rx->DataReturned=true;
+                return e_ZRxEvent_Data;
+            case e_ZRxStateMAX:
+            default:
+                Rx->State=e_ZRxState_Hunt;
+            break;
+        }
+    }
+
+    *Used=Bytes;
+    return e_ZRxEvent_None;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_TxReset
+ *
+ * SYNOPSIS:
+ *    static void ZModem_TxReset(struct ZModemTx *Tx);
+ *
+ * PARAMETERS:
+ *    Tx [I] -- The buffer to empty
+ *
+ * FUNCTION:
+ *    This function empties the outgoing buffer.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModem_TxReset(struct ZModemTx *Tx)
+{
+    Tx->Len=0;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_TxEscaped
+ *
+ * SYNOPSIS:
+ *    static void ZModem_TxEscaped(struct ZModemTx *Tx,const uint8_t *Data,
+ *          uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    Tx [I] -- The buffer to add to
+ *    Data [I] -- The bytes to add
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function ZDLE encodes bytes into the outgoing buffer.  We always
+ *    escape ZDLE, DLE, XON and XOFF (with and without the high bit), a CR
+ *    after an '@' (so telnet / modems don't see "@\r"), and all control
+ *    chars if the other side asked for it.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModem_TxEscaped(struct ZModemTx *Tx,const uint8_t *Data,
+        uint32_t Bytes)
+{
+    uint8_t *Out;
+    uint8_t c;
+    uint32_t r;
+
+    Out=&Tx->Buff[Tx->Len];
+    for(r=0;r<Bytes;r++)
+    {
+        c=Data[r];
+        if(m_ZEscape[c] || (Tx->EscCtl && (c&0x60)==0) ||
+                ((c&0x7F)=='\r' && (Tx->LastSent&0x7F)=='@'))
+        {
+            *Out++=ZDLE;
+            c^=0x40;
+        }
+        *Out++=c;
+        Tx->LastSent=c;
+    }
+    Tx->Len=Out-Tx->Buff;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_TxHexHeader
+ *
+ * SYNOPSIS:
+ *    static void ZModem_TxHexHeader(struct ZModemTx *Tx,uint8_t Type,
+ *          const uint8_t *Hdr);
+ *
+ * PARAMETERS:
+ *    Tx [I] -- The buffer to add to
+ *    Type [I] -- The frame type
+ *    Hdr [I] -- The 4 header bytes
+ *
+ * FUNCTION:
+ *    This function adds a hex header to the outgoing buffer.  These are used
+ *    for everything but ZFILE / ZDATA / ZEOF.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ZModem_TxBinHeader()
+ ******************************************************************************/
+static void ZModem_TxHexHeader(struct ZModemTx *Tx,uint8_t Type,
+        const uint8_t *Hdr)
+{
+    static const char Hex[]="0123456789abcdef";
+    uint8_t Bytes[7];
+    uint16_t crc;
+    int r;
+
+    Bytes[0]=Type;
+    memcpy(&Bytes[1],Hdr,4);
+    crc=ZModem_CRC16(0,Bytes,5);
+    Bytes[5]=crc>>8;
+    Bytes[6]=crc&0xFF;
+
+    Tx->Buff[Tx->Len++]=ZPAD;
+    Tx->Buff[Tx->Len++]=ZPAD;
+    Tx->Buff[Tx->Len++]=ZDLE;
+    Tx->Buff[Tx->Len++]=ZHEX;
+    for(r=0;r<7;r++)
+    {
+        Tx->Buff[Tx->Len++]=Hex[Bytes[r]>>4];
+        Tx->Buff[Tx->Len++]=Hex[Bytes[r]&0x0F];
+    }
+    Tx->Buff[Tx->Len++]='\r';
+    Tx->Buff[Tx->Len++]='\n'|0x80;
+    if(Type!=ZFIN && Type!=ZACK)
+        Tx->Buff[Tx->Len++]=XON;
+    Tx->LastSent=0;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_TxBinHeader
+ *
+ * SYNOPSIS:
+ *    static void ZModem_TxBinHeader(struct ZModemTx *Tx,uint8_t Type,
+ *          const uint8_t *Hdr);
+ *
+ * PARAMETERS:
+ *    Tx [I] -- The buffer to add to
+ *    Type [I] -- The frame type
+ *    Hdr [I] -- The 4 header bytes
+ *
+ * FUNCTION:
+ *    This function adds a binary header to the outgoing buffer.  It uses a
+ *    CRC32 if the other side can do it.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ZModem_TxHexHeader()
+ ******************************************************************************/
+static void ZModem_TxBinHeader(struct ZModemTx *Tx,uint8_t Type,
+        const uint8_t *Hdr)
+{
+    uint8_t Bytes[9];
+    uint32_t crc32;
+    uint16_t crc16;
+
+    Bytes[0]=Type;
+    memcpy(&Bytes[1],Hdr,4);
+
+    Tx->Buff[Tx->Len++]=ZPAD;
+    Tx->Buff[Tx->Len++]=ZDLE;
+    if(Tx->Use32)
+    {
+        crc32=~ZModem_CRC32(0xFFFFFFFF,Bytes,5);
+        Bytes[5]=crc32&0xFF;
+        Bytes[6]=(crc32>>8)&0xFF;
+        Bytes[7]=(crc32>>16)&0xFF;
+        Bytes[8]=crc32>>24;
+        Tx->Buff[Tx->Len++]=ZBIN32;
+        ZModem_TxEscaped(Tx,Bytes,9);
+    }
+    else
+    {
+        crc16=ZModem_CRC16(0,Bytes,5);
+        Bytes[5]=crc16>>8;
+        Bytes[6]=crc16&0xFF;
+        Tx->Buff[Tx->Len++]=ZBIN;
+        ZModem_TxEscaped(Tx,Bytes,7);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_TxSubpacket
+ *
+ * SYNOPSIS:
+ *    static void ZModem_TxSubpacket(struct ZModemTx *Tx,const uint8_t *Data,
+ *          uint32_t Bytes,uint8_t FrameEnd);
+ *
+ * PARAMETERS:
+ *    Tx [I] -- The buffer to add to
+ *    Data [I] -- The data for the subpacket
+ *    Bytes [I] -- The number of bytes in 'Data' (ZMODEM_BLOCK_SIZE max)
+ *    FrameEnd [I] -- ZCRCE, ZCRCG, ZCRCQ, or ZCRCW
+ *
+ * FUNCTION:
+ *    This function adds a data subpacket (data, frame end, CRC) to the
+ *    outgoing buffer.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModem_TxSubpacket(struct ZModemTx *Tx,const uint8_t *Data,
+        uint32_t Bytes,uint8_t FrameEnd)
+{
+    uint8_t CRCBytes[4];
+    uint32_t crc32;
+    uint16_t crc16;
+
+    ZModem_TxEscaped(Tx,Data,Bytes);
+    Tx->Buff[Tx->Len++]=ZDLE;
+    Tx->Buff[Tx->Len++]=FrameEnd;
+
+    if(Tx->Use32)
+    {
+        crc32=ZModem_CRC32(0xFFFFFFFF,Data,Bytes);
+        crc32=~ZModem_CRC32(crc32,&FrameEnd,1);
+        CRCBytes[0]=crc32&0xFF;
+        CRCBytes[1]=(crc32>>8)&0xFF;
+        CRCBytes[2]=(crc32>>16)&0xFF;
+        CRCBytes[3]=crc32>>24;
+        ZModem_TxEscaped(Tx,CRCBytes,4);
+    }
+    else
+    {
+        crc16=ZModem_CRC16(0,Data,Bytes);
+        crc16=ZModem_CRC16(crc16,&FrameEnd,1);
+        CRCBytes[0]=crc16>>8;
+        CRCBytes[1]=crc16&0xFF;
+        ZModem_TxEscaped(Tx,CRCBytes,2);
+    }
+
+    if(FrameEnd==ZCRCW)
+        Tx->Buff[Tx->Len++]=XON;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_ReadAheadOpen
+ *
+ * SYNOPSIS:
+ *    static bool ZModem_ReadAheadOpen(struct ZModemReadAhead *Reader,
+ *          const char *Filename);
+ *
+ * PARAMETERS:
+ *    Reader [O] -- The reader to setup
+ *    Filename [I] -- The file to open
+ *
+ * FUNCTION:
+ *    This function opens a file for reading in big chunks.
+ *
+ * RETURNS:
+ *    true -- The file is open
+ *    false -- We couldn't open the file or get memory for the buffer
+ *
+ * SEE ALSO:
+ *    ZModem_ReadAheadGet(), ZModem_ReadAheadSeek(), ZModem_ReadAheadClose()
+ ******************************************************************************/
+static bool ZModem_ReadAheadOpen(struct ZModemReadAhead *Reader,
+        const char *Filename)
+{
+    Reader->Pos=0;
+    Reader->Len=0;
+    Reader->EndOfFile=false;
+
+    Reader->Buffer=(uint8_t *)malloc(ZMODEM_READAHEAD_SIZE);
+    if(Reader->Buffer==NULL)
+        return false;
+
+    Reader->FileHandle=fopen(Filename,"rb");
+    if(Reader->FileHandle==NULL)
+    {
+        free(Reader->Buffer);
+        Reader->Buffer=NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_ReadAheadClose
+ *
+ * SYNOPSIS:
+ *    static void ZModem_ReadAheadClose(struct ZModemReadAhead *Reader);
+ *
+ * PARAMETERS:
+ *    Reader [I] -- The reader to close
+ *
+ * FUNCTION:
+ *    This function closes the file and frees the buffer.  It is safe to call
+ *    this on a reader that is already closed.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ZModem_ReadAheadOpen()
+ ******************************************************************************/
+static void ZModem_ReadAheadClose(struct ZModemReadAhead *Reader)
+{
+    if(Reader->FileHandle!=NULL)
+        fclose(Reader->FileHandle);
+    Reader->FileHandle=NULL;
+
+    free(Reader->Buffer);
+    Reader->Buffer=NULL;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_ReadAheadSeek
+ *
+ * SYNOPSIS:
+ *    static bool ZModem_ReadAheadSeek(struct ZModemReadAhead *Reader,
+ *          uint64_t Pos);
+ *
+ * PARAMETERS:
+ *    Reader [I] -- The reader to move
+ *    Pos [I] -- Where to read from next
+ *
+ * FUNCTION:
+ *    This function throws away what we have read ahead and moves to a new
+ *    place in the file (for a ZRPOS).
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- The seek failed
+ *
+ * SEE ALSO:
+ *    ZModem_ReadAheadGet()
+ ******************************************************************************/
+static bool ZModem_ReadAheadSeek(struct ZModemReadAhead *Reader,uint64_t Pos)
+{
+    Reader->Pos=0;
+    Reader->Len=0;
+    Reader->EndOfFile=false;
+
+#ifdef _WIN32
+    return _fseeki64(Reader->FileHandle,Pos,SEEK_SET)==0;
+#else
+    return fseeko(Reader->FileHandle,Pos,SEEK_SET)==0;
+#endif
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_ReadAheadGet
+ *
+ * SYNOPSIS:
+ *    static int ZModem_ReadAheadGet(struct ZModemReadAhead *Reader,
+ *          uint8_t *Dest,int Bytes);
+ *
+ * PARAMETERS:
+ *    Reader [I] -- The reader to get bytes from
+ *    Dest [O] -- Where to copy the bytes to
+ *    Bytes [I] -- How many bytes we want
+ *
+ * FUNCTION:
+ *    This function gets the next bytes from the file, refilling the buffer
+ *    with one read when it runs low.
+ *
+ * RETURNS:
+ *    The number of bytes copied.  This will be less than 'Bytes' at the end
+ *    of the file.
+ *
+ * SEE ALSO:
+ *    ZModem_ReadAheadOpen()
+ ******************************************************************************/
+static int ZModem_ReadAheadGet(struct ZModemReadAhead *Reader,uint8_t *Dest,
+        int Bytes)
+{
+    uint32_t Left;
+    size_t Got;
+
+    Left=Reader->Len-Reader->Pos;
+    if(Left<(uint32_t)Bytes && !Reader->EndOfFile)
+    {
+        memmove(Reader->Buffer,&Reader->Buffer[Reader->Pos],Left);
+        Reader->Pos=0;
+        Reader->Len=Left;
+
+        Got=fread(&Reader->Buffer[Left],1,ZMODEM_READAHEAD_SIZE-Left,
+                Reader->FileHandle);
+        if(Got<ZMODEM_READAHEAD_SIZE-Left)
+            Reader->EndOfFile=true;
+        Reader->Len+=Got;
+        Left=Reader->Len;
+    }
+
+    if(Left>(uint32_t)Bytes)
+        Left=Bytes;
+
+    memcpy(Dest,&Reader->Buffer[Reader->Pos],Left);
+    Reader->Pos+=Left;
+
+    return Left;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_AllocWidgets
+ *
+ * SYNOPSIS:
+ *    static t_FTPOptionsWidgetsType *ZModem_AllocWidgets(
+ *          t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options,
+ *          bool Download);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *    Options [I] -- The options to add widgets for
+ *    Download [I] -- true = add the download widgets, false = upload.  This
+ *                    only changes what the resume checkbox says.
+ *
+ * FUNCTION:
+ *    This function adds the options widgets for an upload or download.
+ *
+ * RETURNS:
+ *    The widgets or NULL if there was an error.
+ *
+ * SEE ALSO:
+ *    ZModem_FreeWidgets(), ZModem_StoreWidgets()
+ ******************************************************************************/
+static t_FTPOptionsWidgetsType *ZModem_AllocWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options,bool Download)
+{
+    struct ZModem_Widgets *Widgets;
+    int MaxStartWaitTime;
+    int MaxPacketWaitTime;
+    bool Resume;
+
+    Widgets=NULL;
+    try
+    {
+        Widgets=new struct ZModem_Widgets;
+        Widgets->WidgetHandle=WidgetHandle;
+        Widgets->Resume=NULL;
+        Widgets->MaxStartWaitTime=NULL;
+        Widgets->PacketTimeOut=NULL;
+
+        ZModem_ReadOptions(Options,&MaxStartWaitTime,&MaxPacketWaitTime,
+                &Resume);
+
+        Widgets->Resume=m_UIAPI->AddCheckbox(WidgetHandle,
+                Download?"Resume files we already have part of":
+                "Ask the receiver to resume a file it has part of",
+                NULL,NULL);
+        if(Widgets->Resume==NULL)
+            throw(0);
+        m_UIAPI->SetCheckboxChecked(WidgetHandle,Widgets->Resume->Ctrl,
+                Resume);
+
+        Widgets->MaxStartWaitTime=m_UIAPI->AddNumberInput(WidgetHandle,
+                "Max start wait time (seconds)",NULL,NULL);
+        if(Widgets->MaxStartWaitTime==NULL)
+            throw(0);
+        m_UIAPI->SetNumberInputMinMax(WidgetHandle,
+                Widgets->MaxStartWaitTime->Ctrl,5,120);
+        m_UIAPI->SetNumberInputValue(WidgetHandle,
+                Widgets->MaxStartWaitTime->Ctrl,MaxStartWaitTime);
+
+        Widgets->PacketTimeOut=m_UIAPI->AddNumberInput(WidgetHandle,
+                "Packet time out (seconds)",NULL,NULL);
+        if(Widgets->PacketTimeOut==NULL)
+            throw(0);
+        m_UIAPI->SetNumberInputMinMax(WidgetHandle,
+                Widgets->PacketTimeOut->Ctrl,1,300);
+        m_UIAPI->SetNumberInputValue(WidgetHandle,
+                Widgets->PacketTimeOut->Ctrl,MaxPacketWaitTime);
+    }
+    catch(...)
+    {
+        if(Widgets!=NULL)
+            ZModem_FreeWidgets((t_FTPOptionsWidgetsType *)Widgets);
+        return NULL;
+    }
+
+    return (t_FTPOptionsWidgetsType *)Widgets;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_FreeWidgets
+ *
+ * SYNOPSIS:
+ *    static void ZModem_FreeWidgets(t_FTPOptionsWidgetsType *FTPOptions);
+ *
+ * PARAMETERS:
+ *    FTPOptions [I] -- The options data that was allocated with
+ *          ZModem_AllocWidgets().
+ *
+ * FUNCTION:
+ *    Frees the widgets added with ZModem_AllocWidgets().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ZModem_AllocWidgets()
+ ******************************************************************************/
+static void ZModem_FreeWidgets(t_FTPOptionsWidgetsType *FTPOptions)
+{
+    struct ZModem_Widgets *Widgets=(struct ZModem_Widgets *)FTPOptions;
+
+    if(Widgets->PacketTimeOut!=NULL)
+    {
+        m_UIAPI->FreeNumberInput(Widgets->WidgetHandle,
+                Widgets->PacketTimeOut);
+    }
+
+    if(Widgets->MaxStartWaitTime!=NULL)
+    {
+        m_UIAPI->FreeNumberInput(Widgets->WidgetHandle,
+                Widgets->MaxStartWaitTime);
+    }
+
+    if(Widgets->Resume!=NULL)
+        m_UIAPI->FreeCheckbox(Widgets->WidgetHandle,Widgets->Resume);
+
+    delete Widgets;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_StoreWidgets
+ *
+ * SYNOPSIS:
+ *    static void ZModem_StoreWidgets(t_FTPOptionsWidgetsType *FTPOptions,
+ *          t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    FTPOptions [I] -- The options data that was allocated with
+ *          ZModem_AllocWidgets().
+ *    Options [O] -- The options for this protocol.
+ *
+ * FUNCTION:
+ *    This function takes the widgets added with ZModem_AllocWidgets() and
+ *    stores them is a key/value pair list in 'Options'.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ZModem_AllocWidgets()
+ ******************************************************************************/
+static void ZModem_StoreWidgets(t_FTPOptionsWidgetsType *FTPOptions,
+        t_PIKVList *Options)
+{
+    struct ZModem_Widgets *Widgets=(struct ZModem_Widgets *)FTPOptions;
+    uintptr_t Value;
+    char buff[100];
+
+    if(Widgets->Resume==NULL || Widgets->MaxStartWaitTime==NULL ||
+            Widgets->PacketTimeOut==NULL)
+    {
+        return;
+    }
+
+    m_System->KVClear(Options);
+
+    Value=m_UIAPI->IsCheckboxChecked(Widgets->WidgetHandle,
+            Widgets->Resume->Ctrl);
+    sprintf(buff,"%" PRIuPTR,Value);
+    m_System->KVAddItem(Options,"Resume",buff);
+
+    Value=m_UIAPI->GetNumberInputValue(Widgets->WidgetHandle,
+            Widgets->MaxStartWaitTime->Ctrl);
+    sprintf(buff,"%" PRIuPTR,Value);
+    m_System->KVAddItem(Options,"MAX_START_WAIT_TIME",buff);
+
+    Value=m_UIAPI->GetNumberInputValue(Widgets->WidgetHandle,
+            Widgets->PacketTimeOut->Ctrl);
+    sprintf(buff,"%" PRIuPTR,Value);
+    m_System->KVAddItem(Options,"MAX_PACKET_WAIT_TIME",buff);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModem_ReadOptions
+ *
+ * SYNOPSIS:
+ *    static void ZModem_ReadOptions(t_PIKVList *Options,
+ *          int *MaxStartWaitTime,int *MaxPacketWaitTime,bool *Resume);
+ *
+ * PARAMETERS:
+ *    Options [I] -- The options to read
+ *    MaxStartWaitTime [O] -- How long we wait for the other side to start
+ *    MaxPacketWaitTime [O] -- How long we wait with nothing useful coming in
+ *    Resume [O] -- Should we resume files
+ *
+ * FUNCTION:
+ *    This function reads the options, filling in the defaults for anything
+ *    that isn't set.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModem_ReadOptions(t_PIKVList *Options,int *MaxStartWaitTime,
+        int *MaxPacketWaitTime,bool *Resume)
+{
+    const char *Value;
+
+    *MaxStartWaitTime=MAX_START_WAIT_TIME;
+    *MaxPacketWaitTime=MAX_PACKET_WAIT_TIME;
+    *Resume=false;
+
+    Value=m_System->KVGetItem(Options,"MAX_START_WAIT_TIME");
+    if(Value!=NULL)
+        *MaxStartWaitTime=atoi(Value);
+
+    Value=m_System->KVGetItem(Options,"MAX_PACKET_WAIT_TIME");
+    if(Value!=NULL)
+        *MaxPacketWaitTime=atoi(Value);
+
+    Value=m_System->KVGetItem(Options,"Resume");
+    if(Value!=NULL)
+        *Resume=atoi(Value)!=0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_AllocateData
+ *
+ * SYNOPSIS:
+ *    static t_FTPHandlerDataType *ZModemUpload_AllocateData(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function allocates any needed data for this file transfer protocol.
+ *
+ * RETURNS:
+ *    A pointer to the data, NULL if there was an error.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static t_FTPHandlerDataType *ZModemUpload_AllocateData(void)
+{
+    struct ZModemUploadData *Data;
+
+    try
+    {
+        Data=new struct ZModemUploadData;
+        Data->Reader.FileHandle=NULL;
+        Data->Reader.Buffer=NULL;
+    }
+    catch(...)
+    {
+        return NULL;
+    }
+
+    return (t_FTPHandlerDataType *)Data;
+}
+
+/*******************************************************************************
+ *  NAME:
+ *    ZModemUpload_FreeData
+ *
+ *  SYNOPSIS:
+ *    static void ZModemUpload_FreeData(t_FTPHandlerDataType *DataHandle);
+ *
+ *  PARAMETERS:
+ *    DataHandle [I] -- The data handle to free.  This will need to be
+ *                      case to your internal data type before you use it.
+ *
+ *  FUNCTION:
+ *    This function frees the memory allocated with AllocateData().
+ *
+ *  RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemUpload_FreeData(t_FTPHandlerDataType *DataHandle)
+{
+    struct ZModemUploadData *Data=(struct ZModemUploadData *)DataHandle;
+
+    ZModem_ReadAheadClose(&Data->Reader);
+
+    delete Data;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_Init
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL ZModemUpload_Init(t_FTPSystemData *SysHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *
+ * FUNCTION:
+ *    This function is called on startup init.  It lets the plugin add needed
+ *    things to the system (and other init stuff).
+ *
+ * RETURNS:
+ *    true -- Init worked
+ *    false -- There was some kind of error.  Plugin will not be installed.
+ *
+ * SEE ALSO:
+ *    ShutDown()
+ ******************************************************************************/
+static PG_BOOL ZModemUpload_Init(t_FTPSystemData *SysHandle)
+{
+#ifdef INCLUDESCRIPTING
+    static struct ScriptDataType UploadArgs[]=
+    {
+        {"Resume","Resume",e_ScriptDataArg_Bool},
+        {"StartTimeout","MAX_START_WAIT_TIME",e_ScriptDataArg_Int},
+        {"PacketTimeout","MAX_PACKET_WAIT_TIME",e_ScriptDataArg_Int},
+    };
+
+    return m_FTPS->AddScriptUploadCMD(SysHandle,"ZModem",UploadArgs,
+            sizeof(UploadArgs)/sizeof(struct ScriptDataType),0);
+#else
+    return true;
+#endif
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_AllocOptionsWidgets
+ *
+ * SYNOPSIS:
+ *    static t_FTPOptionsWidgetsType *ZModemUpload_AllocOptionsWidgets(
+ *          t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *    Options [I] -- The options to add widgets for
+ *
+ * FUNCTION:
+ *    This function adds options widgets to a container widget.  These are
+ *    options for this file transfer protocol.
+ *
+ * RETURNS:
+ *    The private options data or NULL if there was an error.
+ *
+ * SEE ALSO:
+ *    ZModem_AllocWidgets()
+ ******************************************************************************/
+static t_FTPOptionsWidgetsType *ZModemUpload_AllocOptionsWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options)
+{
+    return ZModem_AllocWidgets(WidgetHandle,Options,false);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_StartUpload
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL ZModemUpload_StartUpload(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle,const char *FilenameWithPath,
+ *          const char *FilenameOnly,uint64_t FileSize,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *    FilenameWithPath [I] -- The full filename and path
+ *    FilenameOnly [I] -- The filename without the path.
+ *    FileSize [I] -- The number of bytes in the file to upload
+ *    Options [I] -- The options to use for this transfer
+ *
+ * FUNCTION:
+ *    This function is called to start a transfer.  We open the file and send
+ *    "rz\r" (to start the other side's receiver) and a ZRQINIT.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static PG_BOOL ZModemUpload_StartUpload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,const char *FilenameWithPath,
+        const char *FilenameOnly,uint64_t FileSize,t_PIKVList *Options)
+{
+    struct ZModemUploadData *Data=(struct ZModemUploadData *)DataHandle;
+
+    ZModem_RxReset(&Data->Rx);
+    ZModem_TxReset(&Data->Tx);
+    Data->Tx.LastSent=0;
+    Data->Tx.EscCtl=false;
+    Data->Tx.Use32=false;
+    Data->TxPending=false;
+    Data->Filename=FilenameOnly;
+    Data->FileSize=FileSize;
+    Data->TxPos=0;
+    Data->AckPos=0;
+    Data->LastSyncPos=0;
+    Data->LastProgress=0;
+    Data->SameSyncCount=0;
+    Data->RxBuffSize=0;
+    Data->State=e_ZUpload_Waiting4RInit;
+    Data->TickMS=0;
+    Data->IdleMS=0;
+    Data->ResendMS=0;
+    Data->ErrorStr="";
+
+    ZModem_ReadOptions(Options,&Data->MaxStartWaitTime,
+            &Data->MaxPacketWaitTime,&Data->Resume);
+
+    if(!ZModem_ReadAheadOpen(&Data->Reader,FilenameWithPath))
+        return false;
+
+    ZModemUpload_SetTick(SysHandle,Data,ZMODEM_TICK_MS);
+
+    memcpy(Data->Tx.Buff,"rz\r",3);
+    Data->Tx.Len=3;
+    if(!ZModemUpload_SendHeader(SysHandle,Data,ZRQINIT))
+        return false;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_AbortUpload
+ *
+ * SYNOPSIS:
+ *    static void ZModemUpload_AbortUpload(t_FTPSystemData *SysHandle,
+ *              t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    Abort the current transfer.  We send the usual string of CAN's (and
+ *    backspaces to clean them up if the other side isn't running).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemUpload_AbortUpload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct ZModemUploadData *Data=(struct ZModemUploadData *)DataHandle;
+    static const uint8_t CancelStr[]=
+    {
+        CAN,CAN,CAN,CAN,CAN,CAN,CAN,CAN,CAN,CAN,
+        8,8,8,8,8,8,8,8,8,8
+    };
+
+    m_FTPS->ULSendData(SysHandle,(void *)CancelStr,sizeof(CancelStr));
+
+    ZModem_ReadAheadClose(&Data->Reader);
+    Data->ErrorStr="User abort";
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_RxData
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL ZModemUpload_RxData(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *    RxData [I] -- A block with the data that was rx'ed in it.
+ *    Bytes [I] -- The number of bytes in 'RxData'
+ *
+ * FUNCTION:
+ *    This function is called when new data comes in the connection.  The
+ *    receiver only sends us headers.
+ *
+ * RETURNS:
+ *    true -- Do not echo the data
+ *    false -- Go ahead and echo the data
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static PG_BOOL ZModemUpload_RxData(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes)
+{
+    struct ZModemUploadData *Data=(struct ZModemUploadData *)DataHandle;
+    uint32_t Used;
+
+    if(Data->Reader.FileHandle==NULL)
+        return false;
+
+    while(Bytes>0)
+    {
+        switch(ZModem_RxFeed(&Data->Rx,RxData,Bytes,&Used))
+        {
+            case e_ZRxEvent_Header:
+                if(!ZModemUpload_HandleHeader(SysHandle,Data))
+                    return true;    // 'Data' is no longer valid
+            break;
+            case e_ZRxEvent_Cancel:
+                Data->ErrorStr="Canceled by the receiver";
+                m_FTPS->ULFinish(SysHandle,true);
+                return true;    // 'Data' is no longer valid
+            case e_ZRxEvent_None:
+            case e_ZRxEvent_BadHeader:
+            case e_ZRxEvent_Data:
+            case e_ZRxEvent_BadData:
+            case e_ZRxEventMAX:
+            default:
+                /* The rx will send it again */
+            break;
+        }
+        RxData+=Used;
+        Bytes-=Used;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_HandleHeader
+ *
+ * SYNOPSIS:
+ *    static bool ZModemUpload_HandleHeader(t_FTPSystemData *SysHandle,
+ *          struct ZModemUploadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data.  'Rx' has the header.
+ *
+ * FUNCTION:
+ *    This function handles a header from the receiver.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The upload has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool ZModemUpload_HandleHeader(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data)
+{
+    struct ZModemRx *Rx=&Data->Rx;
+    static const uint8_t OverAndOut[]={'O','O'};
+
+    switch(Rx->Type)
+    {
+        case ZRINIT:
+            Data->IdleMS=0;
+            if(Data->State==e_ZUpload_Waiting4RInit)
+            {
+                Data->Tx.Use32=(Rx->Hdr[ZF0]&CANFC32)!=0;
+                Data->Tx.EscCtl=(Rx->Hdr[ZF0]&ESCCTL)!=0;
+                Data->RxBuffSize=Rx->Hdr[ZP0]|Rx->Hdr[ZP1]<<8;
+                return ZModemUpload_SendFile(SysHandle,Data);
+            }
+            if(Data->State==e_ZUpload_Waiting4EOFResp ||
+                    Data->State==e_ZUpload_Waiting4Fin)
+            {
+                /* They have the file, we only have the one */
+                Data->State=e_ZUpload_Waiting4Fin;
+                return ZModemUpload_SendHeader(SysHandle,Data,ZFIN);
+            }
+        break;
+        case ZRPOS:
+            if(Data->State==e_ZUpload_Waiting4RInit ||
+                    Data->State==e_ZUpload_Waiting4Fin)
+            {
+                break;
+            }
+            return ZModemUpload_Reposition(SysHandle,Data,
+                    ZModem_Pos64(Rx->Hdr,Data->TxPos));
+        case ZACK:
+            if(Data->State==e_ZUpload_Waiting4Ack)
+            {
+                Data->IdleMS=0;
+                Data->AckPos=ZModem_Pos64(Rx->Hdr,Data->TxPos);
+                ZModem_TxReset(&Data->Tx);
+                ZModem_SetPos(Rx->Hdr,Data->TxPos);
+                ZModem_TxBinHeader(&Data->Tx,ZDATA,Rx->Hdr);
+                Data->TxPending=true;
+                Data->State=e_ZUpload_Sending;
+                ZModemUpload_SetTick(SysHandle,Data,ZMODEM_STREAM_TICK_MS);
+                return ZModemUpload_Stream(SysHandle,Data);
+            }
+        break;
+        case ZSKIP:
+            /* They already have it (or don't want it) */
+            if(Data->State==e_ZUpload_Waiting4RPos)
+            {
+                Data->IdleMS=0;
+                Data->State=e_ZUpload_Waiting4Fin;
+                return ZModemUpload_SendHeader(SysHandle,Data,ZFIN);
+            }
+        break;
+        case ZNAK:
+            /* Resend what they didn't get */
+            if(Data->State==e_ZUpload_Waiting4RInit)
+                return ZModemUpload_SendHeader(SysHandle,Data,ZRQINIT);
+            if(Data->State==e_ZUpload_Waiting4RPos)
+                return ZModemUpload_SendFile(SysHandle,Data);
+            if(Data->State==e_ZUpload_Waiting4Fin)
+                return ZModemUpload_SendHeader(SysHandle,Data,ZFIN);
+        break;
+        case ZFIN:
+            if(Data->State==e_ZUpload_Waiting4Fin)
+            {
+                m_FTPS->ULSendData(SysHandle,(void *)OverAndOut,
+                        sizeof(OverAndOut));
+                Data->ErrorStr="";
+                m_FTPS->ULFinish(SysHandle,false);
+                return false;
+            }
+        break;
+        case ZFERR:
+            ZModemUpload_Fail(SysHandle,Data,"The receiver had a file error");
+            return false;
+        case ZABORT:
+        case ZCAN:
+            Data->ErrorStr="Canceled by the receiver";
+            m_FTPS->ULFinish(SysHandle,true);
+            return false;
+        default:
+        break;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_Timeout
+ *
+ * SYNOPSIS:
+ *    static void ZModemUpload_Timeout(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    This function is called when the timeout timer (set with SetTimeout())
+ *    goes off.  While streaming this is what keeps the driver fed, the rest
+ *    of the time we resend our last header if the rx has gone quiet.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemUpload_Timeout(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct ZModemUploadData *Data=(struct ZModemUploadData *)DataHandle;
+    uint8_t Hdr[4];
+    uint32_t MaxMS;
+
+    if(Data->Reader.FileHandle==NULL)
+        return;
+
+    if(Data->State==e_ZUpload_Sending)
+    {
+        /* The rx doesn't talk while we stream */
+        Data->IdleMS=0;
+        ZModemUpload_Stream(SysHandle,Data);
+        return;     // 'Data' may no longer be valid
+    }
+
+    if(Data->TxPending)
+    {
+        if(ZModemUpload_Send(SysHandle,Data)==e_ZSend_Failed)
+            return;     // 'Data' is no longer valid
+        if(Data->TxPending)
+            return;
+        ZModemUpload_SetTick(SysHandle,Data,ZMODEM_TICK_MS);
+    }
+
+    Data->IdleMS+=Data->TickMS;
+    Data->ResendMS+=Data->TickMS;
+
+    if(Data->State==e_ZUpload_Waiting4RInit)
+        MaxMS=Data->MaxStartWaitTime*1000;
+    else
+        MaxMS=Data->MaxPacketWaitTime*1000;
+
+    if(Data->IdleMS>MaxMS)
+    {
+        if(Data->State==e_ZUpload_Waiting4Fin)
+        {
+            /* They said they had the file, they just didn't say bye */
+            Data->ErrorStr="";
+            m_FTPS->ULFinish(SysHandle,false);
+            return;     // 'Data' is no longer valid
+        }
+        if(Data->State==e_ZUpload_Waiting4RInit)
+            ZModemUpload_Fail(SysHandle,Data,"Timed out waiting to start");
+        else
+            ZModemUpload_Fail(SysHandle,Data,"Timed out waiting for the "
+                    "receiver");
+        return;     // 'Data' is no longer valid
+    }
+
+    if(Data->ResendMS<ZMODEM_RESEND_MS)
+        return;
+
+    switch(Data->State)
+    {
+        case e_ZUpload_Waiting4RInit:
+            ZModemUpload_SendHeader(SysHandle,Data,ZRQINIT);
+        break;
+        case e_ZUpload_Waiting4RPos:
+            ZModemUpload_SendFile(SysHandle,Data);
+        break;
+        case e_ZUpload_Waiting4Ack:
+        case e_ZUpload_Waiting4EOFResp:
+            /* Ask where they are.  If this isn't the end of the file the
+               ZEOF will get us a ZRPOS */
+            Data->ResendMS=0;
+            ZModem_TxReset(&Data->Tx);
+            ZModem_SetPos(Hdr,Data->TxPos);
+            ZModem_TxBinHeader(&Data->Tx,ZEOF,Hdr);
+            Data->State=e_ZUpload_Waiting4EOFResp;
+            ZModemUpload_Send(SysHandle,Data);
+        break;
+        case e_ZUpload_Waiting4Fin:
+            ZModemUpload_SendHeader(SysHandle,Data,ZFIN);
+        break;
+        case e_ZUpload_Sending:
+        case e_ZUploadMAX:
+        default:
+        break;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_GetLastErrorMsg
+ *
+ * SYNOPSIS:
+ *    static const char *ZModemUpload_GetLastErrorMsg(
+ *          t_FTPSystemData *SysHandle,t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    This function gets the last error message from the system.  The system
+ *    will call then when a function returns an error or abort to find more
+ *    details.
+ *
+ * RETURNS:
+ *    A pointer to an error message or NULL if there was no message.  This must
+ *    remain valid until the next call to any 'FileTransferHandlerAPI' function.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static const char *ZModemUpload_GetLastErrorMsg(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct ZModemUploadData *Data=(struct ZModemUploadData *)DataHandle;
+
+    if(Data->ErrorStr=="")
+        return NULL;
+
+    return Data->ErrorStr.c_str();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_Send
+ *
+ * SYNOPSIS:
+ *    static e_ZSendType ZModemUpload_Send(t_FTPSystemData *SysHandle,
+ *          struct ZModemUploadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *
+ * FUNCTION:
+ *    This function sends what is in 'Tx'.  If the driver is busy it is left
+ *    there (with 'TxPending' set) and we speed up the tick to try again.
+ *
+ * RETURNS:
+ *    e_ZSend_Sent -- It went out
+ *    e_ZSend_Busy -- Still in 'Tx'
+ *    e_ZSend_Failed -- The upload has been finished and 'Data' is no longer
+ *                      valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static e_ZSendType ZModemUpload_Send(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data)
+{
+    switch(m_FTPS->ULSendData(SysHandle,Data->Tx.Buff,Data->Tx.Len))
+    {
+        case e_FTPS_SendDataRet_Success:
+            Data->TxPending=false;
+            ZModem_TxReset(&Data->Tx);
+            return e_ZSend_Sent;
+        case e_FTPS_SendDataRet_Busy:
+            Data->TxPending=true;
+            ZModemUpload_SetTick(SysHandle,Data,ZMODEM_STREAM_TICK_MS);
+            return e_ZSend_Busy;
+        case e_FTPS_SendDataRet_Fail:
+        default:
+            Data->ErrorStr="Failed to send the data";
+            m_FTPS->ULFinish(SysHandle,true);
+            return e_ZSend_Failed;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_SendHeader
+ *
+ * SYNOPSIS:
+ *    static bool ZModemUpload_SendHeader(t_FTPSystemData *SysHandle,
+ *          struct ZModemUploadData *Data,uint8_t Type);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *    Type [I] -- The header to send (ZRQINIT or ZFIN)
+ *
+ * FUNCTION:
+ *    This function adds a hex header with no position / flags to 'Tx' and
+ *    sends it.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The upload has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool ZModemUpload_SendHeader(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data,uint8_t Type)
+{
+    static const uint8_t Zero[4]={0,0,0,0};
+
+    Data->ResendMS=0;
+    if(Data->TxPending)
+        ZModem_TxReset(&Data->Tx);
+    ZModem_TxHexHeader(&Data->Tx,Type,Zero);
+    return ZModemUpload_Send(SysHandle,Data)!=e_ZSend_Failed;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_SendFile
+ *
+ * SYNOPSIS:
+ *    static bool ZModemUpload_SendFile(t_FTPSystemData *SysHandle,
+ *          struct ZModemUploadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *
+ * FUNCTION:
+ *    This function sends the ZFILE header and the file info subpacket
+ *    ("name" NUL "size" NUL).  If resume is on we ask the rx to carry on
+ *    from what it has.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The upload has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool ZModemUpload_SendFile(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data)
+{
+    uint8_t Info[ZMODEM_MAX_FILENAME+32];
+    uint8_t Hdr[4];
+    size_t NameLen;
+    int Len;
+
+    NameLen=Data->Filename.length();
+    if(NameLen>ZMODEM_MAX_FILENAME-1)
+        NameLen=ZMODEM_MAX_FILENAME-1;
+    memcpy(Info,Data->Filename.c_str(),NameLen);
+    Info[NameLen]=0;
+    Len=NameLen+1;
+    Len+=sprintf((char *)&Info[Len],"%" PRIu64,Data->FileSize);
+    Info[Len++]=0;
+
+    Hdr[ZF0]=Data->Resume?ZCRESUM:ZCBIN;
+    Hdr[ZF1]=0;
+    Hdr[1]=0;
+    Hdr[0]=0;
+
+    ZModem_TxReset(&Data->Tx);
+    ZModem_TxBinHeader(&Data->Tx,ZFILE,Hdr);
+    ZModem_TxSubpacket(&Data->Tx,Info,Len,ZCRCW);
+
+    Data->State=e_ZUpload_Waiting4RPos;
+    Data->ResendMS=0;
+
+    return ZModemUpload_Send(SysHandle,Data)!=e_ZSend_Failed;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_Reposition
+ *
+ * SYNOPSIS:
+ *    static bool ZModemUpload_Reposition(t_FTPSystemData *SysHandle,
+ *          struct ZModemUploadData *Data,uint64_t Pos);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *    Pos [I] -- Where the rx wants us to send from
+ *
+ * FUNCTION:
+ *    This function handles a ZRPOS.  This is how the file starts (at 0 or
+ *    where the rx wants to resume from) and how errors are recovered.
+ *    Whatever we haven't sent yet is thrown away and we start a new ZDATA
+ *    frame from 'Pos'.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The upload has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool ZModemUpload_Reposition(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data,uint64_t Pos)
+{
+    uint8_t Hdr[4];
+
+    Data->IdleMS=0;
+
+    if(Pos>Data->FileSize)
+        Pos=Data->FileSize;
+
+    if(Pos==Data->LastSyncPos && Data->State!=e_ZUpload_Waiting4RPos)
+    {
+        Data->SameSyncCount++;
+        if(Data->SameSyncCount>ZMODEM_MAX_SAME_RPOS)
+        {
+            ZModemUpload_Fail(SysHandle,Data,"Too many errors at the same "
+                    "place in the file");
+            return false;
+        }
+    }
+    else
+    {
+        Data->SameSyncCount=0;
+    }
+    Data->LastSyncPos=Pos;
+
+    if(!ZModem_ReadAheadSeek(&Data->Reader,Pos))
+    {
+        ZModemUpload_Fail(SysHandle,Data,"Failed to seek in the file");
+        return false;
+    }
+
+    Data->TxPos=Pos;
+    Data->AckPos=Pos;
+
+    ZModem_TxReset(&Data->Tx);
+    ZModem_SetPos(Hdr,Pos);
+    ZModem_TxBinHeader(&Data->Tx,ZDATA,Hdr);
+    Data->TxPending=true;
+    Data->State=e_ZUpload_Sending;
+    ZModemUpload_SetTick(SysHandle,Data,ZMODEM_STREAM_TICK_MS);
+
+    return ZModemUpload_Stream(SysHandle,Data);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_Stream
+ *
+ * SYNOPSIS:
+ *    static bool ZModemUpload_Stream(t_FTPSystemData *SysHandle,
+ *          struct ZModemUploadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *
+ * FUNCTION:
+ *    This function sends as many data subpackets as the driver will take (up
+ *    to ZMODEM_STREAM_BURST so we don't hold up the UI).  The rest go out on
+ *    the next tick.
+ *
+ *    The last subpacket ends the frame and is followed by the ZEOF.  If the
+ *    rx has a limited buffer we end the frame with a ZCRCW when it's full
+ *    and wait for the ZACK.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The upload has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool ZModemUpload_Stream(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data)
+{
+    uint8_t Block[ZMODEM_BLOCK_SIZE];
+    uint8_t Hdr[4];
+    uint8_t FrameEnd;
+    int Sent;
+    int Bytes;
+    bool Last;
+
+    for(Sent=0;Sent<ZMODEM_STREAM_BURST;Sent++)
+    {
+        if(Data->TxPending)
+        {
+            switch(ZModemUpload_Send(SysHandle,Data))
+            {
+                case e_ZSend_Sent:
+                break;
+                case e_ZSend_Busy:
+                    Sent=ZMODEM_STREAM_BURST;
+                    continue;
+                case e_ZSend_Failed:
+                case e_ZSendMAX:
+                default:
+                return false;
+            }
+        }
+
+        if(Data->State!=e_ZUpload_Sending)
+        {
+            /* That was the end of the frame, wait at the normal rate */
+            ZModemUpload_SetTick(SysHandle,Data,ZMODEM_TICK_MS);
+            break;
+        }
+
+        Bytes=ZModem_ReadAheadGet(&Data->Reader,Block,ZMODEM_BLOCK_SIZE);
+        Data->TxPos+=Bytes;
+        Last=(Bytes<ZMODEM_BLOCK_SIZE || Data->TxPos>=Data->FileSize);
+
+        if(Last)
+            FrameEnd=ZCRCE;
+        else if(Data->RxBuffSize!=0 &&
+                Data->TxPos-Data->AckPos+ZMODEM_BLOCK_SIZE>Data->RxBuffSize)
+            FrameEnd=ZCRCW;
+        else
+            FrameEnd=ZCRCG;
+
+        ZModem_TxSubpacket(&Data->Tx,Block,Bytes,FrameEnd);
+        if(Last)
+        {
+            ZModem_SetPos(Hdr,Data->TxPos);
+            ZModem_TxBinHeader(&Data->Tx,ZEOF,Hdr);
+            Data->State=e_ZUpload_Waiting4EOFResp;
+            Data->ResendMS=0;
+        }
+        else if(FrameEnd==ZCRCW)
+        {
+            Data->State=e_ZUpload_Waiting4Ack;
+            Data->ResendMS=0;
+        }
+        Data->TxPending=true;
+    }
+
+    if(Data->TxPos-Data->LastProgress>=ZMODEM_PROGRESS_EVERY ||
+            Data->State!=e_ZUpload_Sending)
+    {
+        Data->LastProgress=Data->TxPos;
+        m_FTPS->ULProgress(SysHandle,Data->TxPos);
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_SetTick
+ *
+ * SYNOPSIS:
+ *    static void ZModemUpload_SetTick(t_FTPSystemData *SysHandle,
+ *          struct ZModemUploadData *Data,uint32_t MSec);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *    MSec [I] -- How often we want our Timeout() called
+ *
+ * FUNCTION:
+ *    This function changes how often our timeout is called.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemUpload_SetTick(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data,uint32_t MSec)
+{
+    if(Data->TickMS==MSec)
+        return;
+
+    Data->TickMS=MSec;
+    m_FTPS->SetTimeout(SysHandle,MSec);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemUpload_Fail
+ *
+ * SYNOPSIS:
+ *    static void ZModemUpload_Fail(t_FTPSystemData *SysHandle,
+ *          struct ZModemUploadData *Data,const char *Msg);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The upload data
+ *    Msg [I] -- Why we are giving up
+ *
+ * FUNCTION:
+ *    This function cancels the transfer (tells the rx) and finishes the
+ *    upload.  'Data' is no longer valid after this.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemUpload_Fail(t_FTPSystemData *SysHandle,
+        struct ZModemUploadData *Data,const char *Msg)
+{
+    ZModemUpload_AbortUpload(SysHandle,(t_FTPHandlerDataType *)Data);
+
+    Data->ErrorStr=Msg;
+    m_FTPS->ULFinish(SysHandle,true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_Init
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL ZModemDownload_Init(t_FTPSystemData *SysHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *
+ * FUNCTION:
+ *    This function is called on startup init.  It lets the plugin add needed
+ *    things to the system (and other init stuff).
+ *
+ * RETURNS:
+ *    true -- Init worked
+ *    false -- There was some kind of error.  Plugin will not be installed.
+ *
+ * SEE ALSO:
+ *    ShutDown()
+ ******************************************************************************/
+static PG_BOOL ZModemDownload_Init(t_FTPSystemData *SysHandle)
+{
+#ifdef INCLUDESCRIPTING
+    static struct ScriptDataType DownloadArgs[]=
+    {
+        {"Resume","Resume",e_ScriptDataArg_Bool},
+        {"StartTimeout","MAX_START_WAIT_TIME",e_ScriptDataArg_Int},
+        {"PacketTimeout","MAX_PACKET_WAIT_TIME",e_ScriptDataArg_Int},
+    };
+
+    return m_FTPS->AddScriptDownloadCMD(SysHandle,"ZModem",DownloadArgs,
+            sizeof(DownloadArgs)/sizeof(struct ScriptDataType),0);
+#else
+    return true;
+#endif
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_AllocateData
+ *
+ * SYNOPSIS:
+ *    static t_FTPHandlerDataType *ZModemDownload_AllocateData(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function allocates any needed data for this file transfer protocol.
+ *
+ * RETURNS:
+ *    A pointer to the data, NULL if there was an error.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static t_FTPHandlerDataType *ZModemDownload_AllocateData(void)
+{
+    struct ZModemDownloadData *Data;
+
+    try
+    {
+        Data=new struct ZModemDownloadData;
+        Data->FileHandle=NULL;
+    }
+    catch(...)
+    {
+        return NULL;
+    }
+
+    return (t_FTPHandlerDataType *)Data;
+}
+
+/*******************************************************************************
+ *  NAME:
+ *    ZModemDownload_FreeData
+ *
+ *  SYNOPSIS:
+ *    static void ZModemDownload_FreeData(t_FTPHandlerDataType *DataHandle);
+ *
+ *  PARAMETERS:
+ *    DataHandle [I] -- The data handle to free.  This will need to be
+ *                      case to your internal data type before you use it.
+ *
+ *  FUNCTION:
+ *    This function frees the memory allocated with AllocateData().
+ *
+ *  RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemDownload_FreeData(t_FTPHandlerDataType *DataHandle)
+{
+    struct ZModemDownloadData *Data=(struct ZModemDownloadData *)DataHandle;
+
+    if(Data->FileHandle!=NULL)
+        fclose(Data->FileHandle);
+
+    delete Data;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_AllocOptionsWidgets
+ *
+ * SYNOPSIS:
+ *    static t_FTPOptionsWidgetsType *ZModemDownload_AllocOptionsWidgets(
+ *          t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *    Options [I] -- The options to add widgets for
+ *
+ * FUNCTION:
+ *    This function adds options widgets to a container widget.  These are
+ *    options for this file transfer protocol.
+ *
+ * RETURNS:
+ *    The private options data or NULL if there was an error.
+ *
+ * SEE ALSO:
+ *    ZModem_AllocWidgets()
+ ******************************************************************************/
+static t_FTPOptionsWidgetsType *ZModemDownload_AllocOptionsWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_PIKVList *Options)
+{
+    return ZModem_AllocWidgets(WidgetHandle,Options,true);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_StartDownload
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL ZModemDownload_StartDownload(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *    Options [I] -- The options to use for this transfer
+ *
+ * FUNCTION:
+ *    This function is called to start a download transfer.  We ask for the
+ *    filename here (the first file in the batch is saved to this name, the
+ *    rest go in the same directory) and then send a ZRINIT.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static PG_BOOL ZModemDownload_StartDownload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,t_PIKVList *Options)
+{
+    struct ZModemDownloadData *Data=(struct ZModemDownloadData *)DataHandle;
+    const char *Filename;
+    string::size_type Sep;
+
+    ZModem_RxReset(&Data->Rx);
+    ZModem_TxReset(&Data->Tx);
+    Data->Tx.LastSent=0;
+    Data->Tx.EscCtl=false;
+    Data->Tx.Use32=false;
+    Data->FilesDone=0;
+    Data->State=e_ZDownload_Waiting4File;
+    Data->SenderWantsResume=false;
+    Data->RxPos=0;
+    Data->FileSize=0;
+    Data->BytesRx=0;
+    Data->LastProgress=0;
+    Data->GotFirstFile=false;
+    Data->StartTimeout=0;
+    Data->TimeSinceLastRInit=0;
+    Data->LastByteTimeout=0;
+    Data->LastPacketTimeout=0;
+    Data->ErrorStr="";
+
+    ZModem_ReadOptions(Options,&Data->MaxStartWaitTime,
+            &Data->MaxPacketWaitTime,&Data->Resume);
+
+    Filename=m_FTPS->GetDownloadFilename(SysHandle,NULL);
+    if(Filename==NULL)
+    {
+        /* We aborted */
+        return false;
+    }
+    Data->FirstFilename=Filename;
+
+    Sep=Data->FirstFilename.find_last_of("/\\");
+    if(Sep==string::npos)
+        Data->SaveDir="";
+    else
+        Data->SaveDir=Data->FirstFilename.substr(0,Sep+1);
+
+    m_FTPS->SetTimeout(SysHandle,ZMODEM_TICK_MS);
+
+    ZModemDownload_SendRInit(SysHandle,Data);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_AbortDownload
+ *
+ * SYNOPSIS:
+ *    static void ZModemDownload_AbortDownload(t_FTPSystemData *SysHandle,
+ *              t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    Abort the current transfer.  What we have of the file is kept so it can
+ *    be resumed.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemDownload_AbortDownload(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct ZModemDownloadData *Data=(struct ZModemDownloadData *)DataHandle;
+    static const uint8_t CancelStr[]=
+    {
+        CAN,CAN,CAN,CAN,CAN,CAN,CAN,CAN,CAN,CAN,
+        8,8,8,8,8,8,8,8,8,8
+    };
+
+    m_FTPS->DLSendData(SysHandle,(void *)CancelStr,sizeof(CancelStr));
+
+    if(Data->FileHandle!=NULL)
+    {
+        fclose(Data->FileHandle);
+        Data->FileHandle=NULL;
+    }
+
+    Data->ErrorStr="User abort";
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_RxData
+ *
+ * SYNOPSIS:
+ *    static PG_BOOL ZModemDownload_RxData(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *    RxData [I] -- A block with the data that was rx'ed in it.
+ *    Bytes [I] -- The number of bytes in 'RxData'
+ *
+ * FUNCTION:
+ *    This function is called when new data comes in the connection.
+ *
+ * RETURNS:
+ *    true -- Do not echo the data
+ *    false -- Go ahead and echo the data
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static PG_BOOL ZModemDownload_RxData(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle,uint8_t *RxData,uint32_t Bytes)
+{
+    struct ZModemDownloadData *Data=(struct ZModemDownloadData *)DataHandle;
+    uint32_t Used;
+
+    Data->LastByteTimeout=0;
+
+    while(Bytes>0)
+    {
+        switch(ZModem_RxFeed(&Data->Rx,RxData,Bytes,&Used))
+        {
+            case e_ZRxEvent_Header:
+                if(!ZModemDownload_HandleHeader(SysHandle,Data))
+                    return true;    // Data has been free'ed we are done
+            break;
+            case e_ZRxEvent_BadHeader:
+                if(Data->FileHandle!=NULL)
+                {
+                    ZModemDownload_SendHeader(SysHandle,Data,ZRPOS,
+                            Data->RxPos);
+                }
+                else
+                {
+                    ZModemDownload_SendHeader(SysHandle,Data,ZNAK,0);
+                }
+            break;
+            case e_ZRxEvent_Data:
+                if(!ZModemDownload_HandleData(SysHandle,Data))
+                    return true;    // Data has been free'ed we are done
+            break;
+            case e_ZRxEvent_BadData:
+                if(Data->State==e_ZDownload_Receiving)
+                {
+                    /* Ask for it again and ignore everything until the new
+                       ZDATA */
+                    Data->State=e_ZDownload_Waiting4Data;
+                    ZModemDownload_SendHeader(SysHandle,Data,ZRPOS,
+                            Data->RxPos);
+                }
+                else
+                {
+                    if(Data->State==e_ZDownload_Waiting4FileInfo ||
+                            Data->State==e_ZDownload_Waiting4SInit)
+                    {
+                        Data->State=e_ZDownload_Waiting4File;
+                    }
+                    ZModemDownload_SendHeader(SysHandle,Data,ZNAK,0);
+                }
+            break;
+            case e_ZRxEvent_Cancel:
+                Data->ErrorStr="Canceled by the sender";
+                m_FTPS->DLFinish(SysHandle,true);
+                return true;    // Data has been free'ed we are done
+            case e_ZRxEvent_None:
+            case e_ZRxEventMAX:
+            default:
+            break;
+        }
+        RxData+=Used;
+        Bytes-=Used;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_HandleHeader
+ *
+ * SYNOPSIS:
+ *    static bool ZModemDownload_HandleHeader(t_FTPSystemData *SysHandle,
+ *          struct ZModemDownloadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data.  'Rx' has the header.
+ *
+ * FUNCTION:
+ *    This function handles a header from the sender.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The download has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool ZModemDownload_HandleHeader(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data)
+{
+    struct ZModemRx *Rx=&Data->Rx;
+    uint64_t Pos;
+
+    switch(Rx->Type)
+    {
+        case ZRQINIT:
+            if(Data->FileHandle==NULL)
+                ZModemDownload_SendRInit(SysHandle,Data);
+        break;
+        case ZSINIT:
+            Data->State=e_ZDownload_Waiting4SInit;
+            ZModem_RxExpectData(Rx);
+        break;
+        case ZFILE:
+            Data->SenderWantsResume=(Rx->Hdr[ZF0]==ZCRESUM);
+            Data->State=e_ZDownload_Waiting4FileInfo;
+            ZModem_RxExpectData(Rx);
+        break;
+        case ZDATA:
+            if(Data->FileHandle==NULL)
+            {
+                /* We don't have a file going, start again */
+                ZModemDownload_SendRInit(SysHandle,Data);
+                break;
+            }
+            Pos=ZModem_Pos64(Rx->Hdr,Data->RxPos);
+            if(Pos!=Data->RxPos)
+            {
+                /* Not where we are (old data after an error) */
+                Data->State=e_ZDownload_Waiting4Data;
+                ZModemDownload_SendHeader(SysHandle,Data,ZRPOS,Data->RxPos);
+                break;
+            }
+            Data->State=e_ZDownload_Receiving;
+            ZModem_RxExpectData(Rx);
+        break;
+        case ZEOF:
+            if(Data->FileHandle==NULL)
+            {
+                /* They missed our ZRINIT */
+                ZModemDownload_SendRInit(SysHandle,Data);
+                break;
+            }
+            Pos=ZModem_Pos64(Rx->Hdr,Data->RxPos);
+            if(Pos!=Data->RxPos)
+            {
+                /* There is still data we don't have, ignore it (the ZRPOS
+                   we sent will sort it out) */
+                break;
+            }
+
+            fclose(Data->FileHandle);
+            Data->FileHandle=NULL;
+            Data->FilesDone++;
+            Data->LastPacketTimeout=0;
+            Data->LastProgress=Data->BytesRx;
+            m_FTPS->DLProgress(SysHandle,Data->BytesRx);
+            ZModemDownload_SendRInit(SysHandle,Data);
+        break;
+        case ZFIN:
+            ZModemDownload_SendHeader(SysHandle,Data,ZFIN,0);
+            Data->ErrorStr="";
+            m_FTPS->DLFinish(SysHandle,false);
+        return false;
+        case ZCAN:
+        case ZABORT:
+            Data->ErrorStr="Canceled by the sender";
+            m_FTPS->DLFinish(SysHandle,true);
+        return false;
+        default:
+            if(Data->FileHandle==NULL)
+                ZModemDownload_SendRInit(SysHandle,Data);
+        break;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_HandleData
+ *
+ * SYNOPSIS:
+ *    static bool ZModemDownload_HandleData(t_FTPSystemData *SysHandle,
+ *          struct ZModemDownloadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data.  'Rx' has the subpacket.
+ *
+ * FUNCTION:
+ *    This function handles a good data subpacket.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The download has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool ZModemDownload_HandleData(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data)
+{
+    struct ZModemRx *Rx=&Data->Rx;
+
+    switch(Data->State)
+    {
+        case e_ZDownload_Waiting4SInit:
+            /* We don't use the attention string */
+            Data->State=e_ZDownload_Waiting4File;
+            ZModemDownload_SendHeader(SysHandle,Data,ZACK,0);
+        break;
+        case e_ZDownload_Waiting4FileInfo:
+            if(Data->FileHandle!=NULL)
+            {
+                /* They didn't get our ZRPOS */
+                Data->State=e_ZDownload_Waiting4Data;
+                ZModemDownload_SendHeader(SysHandle,Data,ZRPOS,Data->RxPos);
+                break;
+            }
+            return ZModemDownload_OpenFile(SysHandle,Data);
+        case e_ZDownload_Receiving:
+            if(Rx->DataLen>0 &&
+                    fwrite(Rx->Data,Rx->DataLen,1,Data->FileHandle)!=1)
+            {
+                ZModemDownload_Fail(SysHandle,Data,"Failed to write to the "
+                        "file");
+                return false;
+            }
+            Data->RxPos+=Rx->DataLen;
+            Data->BytesRx+=Rx->DataLen;
+            Data->LastPacketTimeout=0;
+
+            if(Rx->FrameEnd==ZCRCQ || Rx->FrameEnd==ZCRCW)
+                ZModemDownload_SendHeader(SysHandle,Data,ZACK,Data->RxPos);
+            if(Rx->FrameEnd==ZCRCE || Rx->FrameEnd==ZCRCW)
+                Data->State=e_ZDownload_Waiting4Data;
+
+            if(Data->BytesRx-Data->LastProgress>=ZMODEM_PROGRESS_EVERY)
+            {
+                Data->LastProgress=Data->BytesRx;
+                m_FTPS->DLProgress(SysHandle,Data->BytesRx);
+            }
+        break;
+        case e_ZDownload_Waiting4File:
+        case e_ZDownload_Waiting4Data:
+        case e_ZDownloadMAX:
+        default:
+        break;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_OpenFile
+ *
+ * SYNOPSIS:
+ *    static bool ZModemDownload_OpenFile(t_FTPSystemData *SysHandle,
+ *          struct ZModemDownloadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data.  'Rx' has the ZFILE subpacket.
+ *
+ * FUNCTION:
+ *    This function works out where the file goes, opens it and tells the
+ *    sender where to start from.
+ *
+ *    The first file goes to the filename the user picked.  The rest go next
+ *    to it with the name the sender gave (without any path so the sender
+ *    can't write outside that directory).
+ *
+ *    If we are resuming and already have part of the file we start from the
+ *    end of what we have.  If we have all of it we skip it.
+ *
+ * RETURNS:
+ *    true -- Things are ok
+ *    false -- The download has been finished and 'Data' is no longer valid
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static bool ZModemDownload_OpenFile(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data)
+{
+    struct ZModemRx *Rx=&Data->Rx;
+    string RxName;
+    string SaveName;
+    string::size_type Sep;
+    const char *SizeStart;
+    uint32_t NameLen;
+    uint64_t Have;
+    bool SizeKnown;
+
+    Data->GotFirstFile=true;
+    Data->LastPacketTimeout=0;
+
+    for(NameLen=0;NameLen<Rx->DataLen;NameLen++)
+        if(Rx->Data[NameLen]==0)
+            break;
+    RxName.assign((char *)Rx->Data,NameLen);
+
+    SizeKnown=false;
+    Data->FileSize=0;
+    if(NameLen+1<Rx->DataLen)
+    {
+        Rx->Data[Rx->DataLen-1]=0;
+        SizeStart=(char *)&Rx->Data[NameLen+1];
+        if(*SizeStart>='0' && *SizeStart<='9')
+        {
+            Data->FileSize=strtoull(SizeStart,NULL,10);
+            SizeKnown=true;
+        }
+    }
+
+    if(Data->FilesDone==0)
+    {
+        SaveName=Data->FirstFilename;
+    }
+    else
+    {
+        Sep=RxName.find_last_of("/\\");
+        if(Sep!=string::npos)
+            RxName.erase(0,Sep+1);
+        if(RxName=="" || RxName=="." || RxName=="..")
+            RxName="zmodem.bin";
+        SaveName=Data->SaveDir+RxName;
+    }
+
+    Data->RxPos=0;
+    if(Data->Resume || Data->SenderWantsResume)
+    {
+        /* See how much we already have */
+        Data->FileHandle=fopen(SaveName.c_str(),"r+b");
+        if(Data->FileHandle!=NULL)
+        {
+#ifdef _WIN32
+            _fseeki64(Data->FileHandle,0,SEEK_END);
+            Have=_ftelli64(Data->FileHandle);
+#else
+            fseeko(Data->FileHandle,0,SEEK_END);
+            Have=ftello(Data->FileHandle);
+#endif
+            if(SizeKnown && Have>=Data->FileSize)
+            {
+                /* We have all of it */
+                fclose(Data->FileHandle);
+                Data->FileHandle=NULL;
+                Data->FilesDone++;
+                Data->State=e_ZDownload_Waiting4File;
+                ZModemDownload_SendHeader(SysHandle,Data,ZSKIP,0);
+                return true;
+            }
+            Data->RxPos=Have;
+        }
+    }
+    if(Data->FileHandle==NULL)
+        Data->FileHandle=fopen(SaveName.c_str(),"wb");
+    if(Data->FileHandle==NULL)
+    {
+        ZModemDownload_Fail(SysHandle,Data,"Failed to open the file");
+        return false;
+    }
+
+    Data->BytesRx+=Data->RxPos;
+    Data->State=e_ZDownload_Waiting4Data;
+    ZModemDownload_SendHeader(SysHandle,Data,ZRPOS,Data->RxPos);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_Timeout
+ *
+ * SYNOPSIS:
+ *    static void ZModemDownload_Timeout(t_FTPSystemData *SysHandle,
+ *          t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    This function is called when the timeout timer (set with SetTimeout())
+ *    goes off (once a second).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemDownload_Timeout(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct ZModemDownloadData *Data=(struct ZModemDownloadData *)DataHandle;
+
+    Data->LastByteTimeout++;
+    Data->LastPacketTimeout++;
+
+    if(!Data->GotFirstFile)
+    {
+        Data->StartTimeout++;
+        if(Data->StartTimeout>Data->MaxStartWaitTime)
+        {
+            ZModemDownload_Fail(SysHandle,Data,"Time out waiting to start");
+            return;    // Data has been free'ed we are done
+        }
+    }
+    else if(Data->LastPacketTimeout>=Data->MaxPacketWaitTime)
+    {
+        ZModemDownload_Fail(SysHandle,Data,"Time out waiting for data");
+        return;    // Data has been free'ed we are done
+    }
+
+    if(Data->FileHandle==NULL)
+    {
+        /* Keep asking for a file */
+        Data->TimeSinceLastRInit++;
+        if(Data->TimeSinceLastRInit>=ZMODEM_RESEND_MS/1000)
+            ZModemDownload_SendRInit(SysHandle,Data);
+    }
+    else if(Data->LastByteTimeout>=ZMODEM_QUIET_TIMEOUT)
+    {
+        /* The line has gone quiet, tell them where we are */
+        Data->LastByteTimeout=0;
+        Data->State=e_ZDownload_Waiting4Data;
+        ZModem_RxReset(&Data->Rx);
+        ZModemDownload_SendHeader(SysHandle,Data,ZRPOS,Data->RxPos);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_GetLastErrorMsg
+ *
+ * SYNOPSIS:
+ *    static const char *ZModemDownload_GetLastErrorMsg(
+ *          t_FTPSystemData *SysHandle,t_FTPHandlerDataType *DataHandle);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- An handle to be passed back to the file transfer protocol
+ *                     system through the 'struct FileTransferHandlerAPI' API.
+ *    DataHandle [I] -- An handle to the driver's data that was allocated with
+ *                      AllocateData().
+ *
+ * FUNCTION:
+ *    This function gets the last error message from the system.  The system
+ *    will call then when a function returns an error or abort to find more
+ *    details.
+ *
+ * RETURNS:
+ *    A pointer to an error message or NULL if there was no message.  This must
+ *    remain valid until the next call to any 'FileTransferHandlerAPI' function.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static const char *ZModemDownload_GetLastErrorMsg(t_FTPSystemData *SysHandle,
+        t_FTPHandlerDataType *DataHandle)
+{
+    struct ZModemDownloadData *Data=(struct ZModemDownloadData *)DataHandle;
+
+    if(Data->ErrorStr=="")
+        return NULL;
+
+    return Data->ErrorStr.c_str();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_SendHeader
+ *
+ * SYNOPSIS:
+ *    static void ZModemDownload_SendHeader(t_FTPSystemData *SysHandle,
+ *          struct ZModemDownloadData *Data,uint8_t Type,uint64_t Pos);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data
+ *    Type [I] -- The header type to send
+ *    Pos [I] -- The position to put in the header
+ *
+ * FUNCTION:
+ *    This function sends a hex header to the sender.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemDownload_SendHeader(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data,uint8_t Type,uint64_t Pos)
+{
+    uint8_t Hdr[4];
+
+    ZModem_SetPos(Hdr,Pos);
+    ZModem_TxReset(&Data->Tx);
+    ZModem_TxHexHeader(&Data->Tx,Type,Hdr);
+    m_FTPS->DLSendData(SysHandle,Data->Tx.Buff,Data->Tx.Len);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_SendRInit
+ *
+ * SYNOPSIS:
+ *    static void ZModemDownload_SendRInit(t_FTPSystemData *SysHandle,
+ *          struct ZModemDownloadData *Data);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data
+ *
+ * FUNCTION:
+ *    This function tells the sender we are ready for a file.  We can take a
+ *    full stream (no buffer limit) with CRC32.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemDownload_SendRInit(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data)
+{
+    uint8_t Hdr[4];
+
+    Data->TimeSinceLastRInit=0;
+    Data->State=e_ZDownload_Waiting4File;
+
+    Hdr[ZP0]=0;
+    Hdr[ZP1]=0;
+    Hdr[ZF1]=0;
+    Hdr[ZF0]=CANFDX|CANOVIO|CANFC32;
+
+    ZModem_TxReset(&Data->Tx);
+    ZModem_TxHexHeader(&Data->Tx,ZRINIT,Hdr);
+    m_FTPS->DLSendData(SysHandle,Data->Tx.Buff,Data->Tx.Len);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ZModemDownload_Fail
+ *
+ * SYNOPSIS:
+ *    static void ZModemDownload_Fail(t_FTPSystemData *SysHandle,
+ *          struct ZModemDownloadData *Data,const char *Msg);
+ *
+ * PARAMETERS:
+ *    SysHandle [I] -- The handle to the file transfer system
+ *    Data [I] -- The download data
+ *    Msg [I] -- Why we are giving up
+ *
+ * FUNCTION:
+ *    This function cancels the transfer (tells the sender) and finishes the
+ *    download.  'Data' is no longer valid after this.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static void ZModemDownload_Fail(t_FTPSystemData *SysHandle,
+        struct ZModemDownloadData *Data,const char *Msg)
+{
+    ZModemDownload_AbortDownload(SysHandle,(t_FTPHandlerDataType *)Data);
+
+    Data->ErrorStr=Msg;
+    m_FTPS->DLFinish(SysHandle,true);
+}
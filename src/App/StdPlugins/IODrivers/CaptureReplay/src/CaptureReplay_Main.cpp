@@ -0,0 +1,1244 @@
+/*******************************************************************************
+ * FILENAME: CaptureReplay_Main.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the capture replay driver in it.  This plays the RX
+ *    records from a binary capture file (CAPTUREFILE_EXTENSION) back in as
+ *    if they where coming in from a device.  It can play at the original
+ *    speed, sped up / slowed down, or as fast as the connection can take
+ *    it, and can start from any point in the capture.
+ *
+ *    This is a built in only driver because it uses the app's capture file
+ *    reader.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "CaptureReplay_Main.h"
+#include "App/Util/CaptureFile.h"
+#include "OS/OSTime.h"
+#include "OS/Thread.h"
+#include "PluginSDK/IODriver.h"
+#include "PluginSDK/Plugin.h"
+#include <string.h>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define CAPTUREREPLAY_URI_PREFIX                "REPLAY"
+#define REGISTER_PLUGIN_FUNCTION_PRIV_NAME      CaptureReplay // The name to append on the RegisterPlugin() function for built in version
+#define NEEDED_MIN_API_VERSION                  0x01000000
+#define CAPTUREREPLAY_MAX_GAP                   5000000000ULL   // Longest gap between records we will wait (ns)
+#define CAPTUREREPLAY_MAX_PENDING               (256*1024)      // Max bytes waiting for Read()
+#define CAPTUREREPLAY_POLL_MS                   10              // Longest we sleep before checking for quit
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct CaptureReplay_ConWidgets
+{
+    struct PI_TextInput *Filename;
+    struct PI_DoubleInput *Speed;
+    struct PI_NumberInput *StartAt;
+};
+
+struct CaptureReplay_OurData
+{
+    t_IOSystemHandle *IOHandle;
+    class CaptureFileReader Reader;
+    struct ThreadHandle *Thread;
+    struct ThreadMutex *Mutex;
+    double Speed;                       // 0 = as fast as we can
+    volatile bool RequestThreadQuit;
+    bool Opened;
+
+    /* These are protected by 'Mutex' */
+    std::vector<uint8_t> Pending;       // Bytes released by the thread
+    size_t PendingPos;                  // Next byte in 'Pending' for Read()
+    bool ReplayDone;
+    bool DisconnectSent;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+PG_BOOL CaptureReplay_Init(void);
+const struct IODriverInfo *CaptureReplay_GetDriverInfo(unsigned int *SizeOfInfo);
+const struct IODriverDetectedInfo *CaptureReplay_DetectDevices(void);
+void CaptureReplay_FreeDetectedDevices(const struct IODriverDetectedInfo *Devices);
+PG_BOOL CaptureReplay_GetConnectionInfo(const char *DeviceUniqueID,t_PIKVList *Options,struct IODriverDetectedInfo *RetInfo);
+t_ConnectionWidgetsType *CaptureReplay_ConnectionOptionsWidgets_AllocWidgets(
+        t_WidgetSysHandle *WidgetHandle);
+void CaptureReplay_ConnectionOptionsWidgets_FreeWidgets(t_WidgetSysHandle *WidgetHandle,t_ConnectionWidgetsType *ConOptions);
+void CaptureReplay_ConnectionOptionsWidgets_StoreUI(t_WidgetSysHandle *WidgetHandle,t_ConnectionWidgetsType *ConOptions,const char *DeviceUniqueID,t_PIKVList *Options);
+void CaptureReplay_ConnectionOptionsWidgets_UpdateUI(t_WidgetSysHandle *WidgetHandle,t_ConnectionWidgetsType *ConOptions,const char *DeviceUniqueID,t_PIKVList *Options);
+PG_BOOL CaptureReplay_Convert_URI_To_Options(const char *URI,t_PIKVList *Options,
+            char *DeviceUniqueID,unsigned int MaxDeviceUniqueIDLen,
+            PG_BOOL Update);
+PG_BOOL CaptureReplay_Convert_Options_To_URI(const char *DeviceUniqueID,
+            t_PIKVList *Options,char *URI,unsigned int MaxURILen);
+t_DriverIOHandleType *CaptureReplay_AllocateHandle(const char *DeviceUniqueID,
+        t_IOSystemHandle *IOHandle);
+void CaptureReplay_FreeHandle(t_DriverIOHandleType *DriverIO);
+PG_BOOL CaptureReplay_Open(t_DriverIOHandleType *DriverIO,const t_PIKVList *Options);
+void CaptureReplay_Close(t_DriverIOHandleType *DriverIO);
+int CaptureReplay_Read(t_DriverIOHandleType *DriverIO,uint8_t *Data,int MaxBytes);
+int CaptureReplay_Write(t_DriverIOHandleType *DriverIO,const uint8_t *Data,int Bytes);
+PG_BOOL CaptureReplay_ChangeOptions(t_DriverIOHandleType *DriverIO,
+        const t_PIKVList *Options);
+static void CaptureReplay_ReplayThread(void *Arg);
+
+/*** VARIABLE DEFINITIONS     ***/
+const struct IODriverAPI g_CaptureReplayPluginAPI=
+{
+    CaptureReplay_Init,
+    CaptureReplay_GetDriverInfo,
+    NULL,                                               // InstallPlugin
+    NULL,                                               // UnInstallPlugin
+    CaptureReplay_DetectDevices,
+    CaptureReplay_FreeDetectedDevices,
+    CaptureReplay_GetConnectionInfo,
+    CaptureReplay_ConnectionOptionsWidgets_AllocWidgets,
+    CaptureReplay_ConnectionOptionsWidgets_FreeWidgets,
+    CaptureReplay_ConnectionOptionsWidgets_StoreUI,
+    CaptureReplay_ConnectionOptionsWidgets_UpdateUI,
+    CaptureReplay_Convert_URI_To_Options,
+    CaptureReplay_Convert_Options_To_URI,
+    CaptureReplay_AllocateHandle,
+    CaptureReplay_FreeHandle,
+    CaptureReplay_Open,
+    CaptureReplay_Close,
+    CaptureReplay_Read,
+    CaptureReplay_Write,
+    CaptureReplay_ChangeOptions,
+    NULL,                                               // Transmit
+    NULL,                                               // ConnectionAuxCtrlWidgets_AllocWidgets
+    NULL,                                               // ConnectionAuxCtrlWidgets_FreeWidgets
+    /* V2 */
+    NULL,   // GetLastErrorMessage
+    /* V3 */
+    NULL,   // AllocSettingsWidgets
+    NULL,   // FreeSettingsWidgets
+    NULL,   // SetSettingsFromWidgets
+    NULL,   // ApplySettings
+};
+
+struct IODriverInfo m_CaptureReplayInfo=
+{
+    0,
+    "<URI>REPLAY://[filename]</URI>"
+    "<ARG>filename -- The " CAPTUREFILE_EXTENSION " capture file to play back</ARG>"
+    "<Example>REPLAY:///home/user/Capture" CAPTUREFILE_EXTENSION "</Example>"
+};
+
+const struct IOS_API *g_CapRep_IOSystem;
+const struct PI_UIAPI *g_CapRep_UI;
+const struct PI_SystemAPI *g_CapRep_System;
+
+static const struct IODriverDetectedInfo g_CapRep_DeviceInfo=
+{
+    NULL,
+    sizeof(struct IODriverDetectedInfo),
+    0,                          // Flags
+    CAPTUREREPLAY_URI_PREFIX,   // DeviceUniqueID
+    "Capture Replay",           // Name
+    "Replay",                   // Title
+};
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_RegisterPlugin
+ *
+ * SYNOPSIS:
+ *    unsigned int CaptureReplay_RegisterPlugin(
+ *          const struct PI_SystemAPI *SysAPI,unsigned int Version);
+ *
+ * PARAMETERS:
+ *    SysAPI [I] -- The main API to WhippyTerm
+ *    Version [I] -- What version of WhippyTerm is running.  This is used
+ *                   to make sure we are compatible.  This is in the
+ *                   Major<<24 | Minor<<16 | Rev<<8 | Patch format
+ *
+ * FUNCTION:
+ *    This function registers this plugin with the system.
+ *
+ * RETURNS:
+ *    0 if we support this version of WhippyTerm, and the minimum version
+ *    we need if we are not.
+ *
+ * NOTES:
+ *    This is only ever used as a built in plugin so it is called from
+ *    RegisterStdPlugins().
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+/* This needs to be extern "C" because it is the main entry point for the
+   plugin system */
+extern "C"
+{
+    unsigned int REGISTER_PLUGIN_FUNCTION(const struct PI_SystemAPI *SysAPI,
+            unsigned int Version)
+    {
+        if(Version<NEEDED_MIN_API_VERSION)
+            return NEEDED_MIN_API_VERSION;
+
+        g_CapRep_System=SysAPI;
+        g_CapRep_IOSystem=g_CapRep_System->GetAPI_IO();
+        g_CapRep_UI=g_CapRep_IOSystem->GetAPI_UI();
+
+        /* If we are have the correct experimental API */
+        if(g_CapRep_System->GetExperimentalID()>0 &&
+                g_CapRep_System->GetExperimentalID()<1)
+        {
+            return 0xFFFFFFFF;
+        }
+
+        g_CapRep_IOSystem->RegisterDriver("CaptureReplay",
+                CAPTUREREPLAY_URI_PREFIX,&g_CaptureReplayPluginAPI,
+                sizeof(g_CaptureReplayPluginAPI));
+
+        return 0;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_Init
+ *
+ * SYNOPSIS:
+ *    PG_BOOL CaptureReplay_Init(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function init's anything needed for the plugin.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.  The driver will not be used.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+PG_BOOL CaptureReplay_Init(void)
+{
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_GetDriverInfo
+ *
+ * SYNOPSIS:
+ *    const struct IODriverInfo *CaptureReplay_GetDriverInfo(
+ *              unsigned int *SizeOfInfo);
+ *
+ * PARAMETERS:
+ *    SizeOfInfo [O] -- The size of 'struct IODriverInfo'.  This is used
+ *                      for forward / backward compatibility.
+ *
+ * FUNCTION:
+ *    This function gets info about the plugin.
+ *
+ * RETURNS:
+ *    The info about this driver.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+const struct IODriverInfo *CaptureReplay_GetDriverInfo(unsigned int *SizeOfInfo)
+{
+    *SizeOfInfo=sizeof(struct IODriverInfo);
+    return &m_CaptureReplayInfo;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_DetectDevices
+ *
+ * SYNOPSIS:
+ *    const struct IODriverDetectedInfo *CaptureReplay_DetectDevices(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function returns the one "device" this driver has.  The file
+ *    to play is picked in the connection options.
+ *
+ * RETURNS:
+ *    The first node in the linked list.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_FreeDetectedDevices()
+ ******************************************************************************/
+const struct IODriverDetectedInfo *CaptureReplay_DetectDevices(void)
+{
+    return &g_CapRep_DeviceInfo;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_FreeDetectedDevices
+ *
+ * SYNOPSIS:
+ *    void CaptureReplay_FreeDetectedDevices(
+ *              const struct IODriverDetectedInfo *Devices);
+ *
+ * PARAMETERS:
+ *    Devices [I] -- The linked list to free
+ *
+ * FUNCTION:
+ *    This function frees the list from CaptureReplay_DetectDevices().  The
+ *    list is static so this does nothing.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureReplay_DetectDevices()
+ ******************************************************************************/
+void CaptureReplay_FreeDetectedDevices(const struct IODriverDetectedInfo *Devices)
+{
+    /* Does nothing */
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_GetConnectionInfo
+ *
+ * SYNOPSIS:
+ *    PG_BOOL CaptureReplay_GetConnectionInfo(const char *DeviceUniqueID,
+ *              t_PIKVList *Options,struct IODriverDetectedInfo *RetInfo);
+ *
+ * PARAMETERS:
+ *    DeviceUniqueID [I] -- This is the unique ID for the device we are working
+ *                          on.
+ *    Options [I] -- The options for this connection
+ *    RetInfo [O] -- The structure to fill in with info about this device.
+ *
+ * FUNCTION:
+ *    Get info about this connection.  The title is set to the name of the
+ *    file being played.
+ *
+ * RETURNS:
+ *    true -- 'RetInfo' has been filled in.
+ *    false -- There was an error in getting the info.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_DetectDevices()
+ ******************************************************************************/
+PG_BOOL CaptureReplay_GetConnectionInfo(const char *DeviceUniqueID,
+        t_PIKVList *Options,struct IODriverDetectedInfo *RetInfo)
+{
+    const char *FilenameStr;
+    const char *Base;
+    const char *Pos;
+
+    strcpy(RetInfo->Name,g_CapRep_DeviceInfo.Name);
+    RetInfo->Flags=g_CapRep_DeviceInfo.Flags;
+
+    FilenameStr=g_CapRep_System->KVGetItem(Options,"Filename");
+    if(FilenameStr==NULL || *FilenameStr==0)
+    {
+        snprintf(RetInfo->Title,sizeof(RetInfo->Title),"%s",
+                g_CapRep_DeviceInfo.Title);
+        return true;
+    }
+
+    /* Just use the name of the file (no path) */
+    Base=FilenameStr;
+    for(Pos=FilenameStr;*Pos!=0;Pos++)
+        if(*Pos=='/' || *Pos=='\\')
+            Base=Pos+1;
+
+    snprintf(RetInfo->Title,sizeof(RetInfo->Title),"%s",Base);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_ConnectionOptionsWidgets_AllocWidgets
+ *
+ * SYNOPSIS:
+ *    t_ConnectionWidgetsType *CaptureReplay_ConnectionOptionsWidgets_AllocWidgets(
+ *          t_WidgetSysHandle *WidgetHandle);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *
+ * FUNCTION:
+ *    This function adds the options widgets to a container widget.
+ *
+ * RETURNS:
+ *    The private options data that you want to use.  This is a private
+ *    structure that you allocate and then cast to
+ *    (t_ConnectionWidgetsType *) when you return.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_ConnectionOptionsWidgets_FreeWidgets()
+ ******************************************************************************/
+t_ConnectionWidgetsType *CaptureReplay_ConnectionOptionsWidgets_AllocWidgets(
+        t_WidgetSysHandle *WidgetHandle)
+{
+    struct CaptureReplay_ConWidgets *ConWidgets;
+
+    ConWidgets=NULL;
+    try
+    {
+        ConWidgets=new struct CaptureReplay_ConWidgets;
+        ConWidgets->Filename=NULL;
+        ConWidgets->Speed=NULL;
+        ConWidgets->StartAt=NULL;
+
+        ConWidgets->Filename=g_CapRep_UI->AddTextInput(WidgetHandle,
+                "Capture File",NULL,NULL);
+        if(ConWidgets->Filename==NULL)
+            throw(0);
+
+        ConWidgets->Speed=g_CapRep_UI->AddDoubleInput(WidgetHandle,
+                "Speed (0=max)",NULL,NULL);
+        if(ConWidgets->Speed==NULL)
+            throw(0);
+
+        g_CapRep_UI->SetDoubleInputMinMax(WidgetHandle,ConWidgets->Speed->Ctrl,
+                0,1000);
+        g_CapRep_UI->SetDoubleInputDecimals(WidgetHandle,
+                ConWidgets->Speed->Ctrl,2);
+
+        ConWidgets->StartAt=g_CapRep_UI->AddNumberInput(WidgetHandle,
+                "Start At (sec)",NULL,NULL);
+        if(ConWidgets->StartAt==NULL)
+            throw(0);
+
+        g_CapRep_UI->SetNumberInputMinMax(WidgetHandle,
+                ConWidgets->StartAt->Ctrl,0,2000000000);
+    }
+    catch(...)
+    {
+        if(ConWidgets!=NULL)
+        {
+            if(ConWidgets->Filename!=NULL)
+                g_CapRep_UI->FreeTextInput(WidgetHandle,ConWidgets->Filename);
+            if(ConWidgets->Speed!=NULL)
+                g_CapRep_UI->FreeDoubleInput(WidgetHandle,ConWidgets->Speed);
+            if(ConWidgets->StartAt!=NULL)
+                g_CapRep_UI->FreeNumberInput(WidgetHandle,ConWidgets->StartAt);
+
+            delete ConWidgets;
+        }
+        return NULL;
+    }
+
+    return (t_ConnectionWidgetsType *)ConWidgets;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_ConnectionOptionsWidgets_FreeWidgets
+ *
+ * SYNOPSIS:
+ *    void CaptureReplay_ConnectionOptionsWidgets_FreeWidgets(
+ *              t_WidgetSysHandle *WidgetHandle,
+ *              t_ConnectionWidgetsType *ConOptions);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *    ConOptions [I] -- The options data that was allocated with
+ *          CaptureReplay_ConnectionOptionsWidgets_AllocWidgets().
+ *
+ * FUNCTION:
+ *    Frees the widgets added with
+ *    CaptureReplay_ConnectionOptionsWidgets_AllocWidgets()
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureReplay_ConnectionOptionsWidgets_AllocWidgets()
+ ******************************************************************************/
+void CaptureReplay_ConnectionOptionsWidgets_FreeWidgets(
+        t_WidgetSysHandle *WidgetHandle,t_ConnectionWidgetsType *ConOptions)
+{
+    struct CaptureReplay_ConWidgets *ConWidgets=
+            (struct CaptureReplay_ConWidgets *)ConOptions;
+
+    if(ConWidgets->Filename!=NULL)
+        g_CapRep_UI->FreeTextInput(WidgetHandle,ConWidgets->Filename);
+    if(ConWidgets->Speed!=NULL)
+        g_CapRep_UI->FreeDoubleInput(WidgetHandle,ConWidgets->Speed);
+    if(ConWidgets->StartAt!=NULL)
+        g_CapRep_UI->FreeNumberInput(WidgetHandle,ConWidgets->StartAt);
+
+    delete ConWidgets;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_ConnectionOptionsWidgets_StoreUI
+ *
+ * SYNOPSIS:
+ *    void CaptureReplay_ConnectionOptionsWidgets_StoreUI(
+ *              t_WidgetSysHandle *WidgetHandle,
+ *              t_ConnectionWidgetsType *ConOptions,
+ *              const char *DeviceUniqueID,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *    ConOptions [I] -- The options data that was allocated with
+ *          CaptureReplay_ConnectionOptionsWidgets_AllocWidgets().
+ *    DeviceUniqueID [I] -- This is the unique ID for the device we are working
+ *                          on.
+ *    Options [O] -- The options for this connection.
+ *
+ * FUNCTION:
+ *    This function takes the widgets added with
+ *    CaptureReplay_ConnectionOptionsWidgets_AllocWidgets() and stores them
+ *    in a key/value pair list.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureReplay_ConnectionOptionsWidgets_UpdateUI()
+ ******************************************************************************/
+void CaptureReplay_ConnectionOptionsWidgets_StoreUI(
+        t_WidgetSysHandle *WidgetHandle,t_ConnectionWidgetsType *ConOptions,
+        const char *DeviceUniqueID,t_PIKVList *Options)
+{
+    struct CaptureReplay_ConWidgets *ConWidgets=
+            (struct CaptureReplay_ConWidgets *)ConOptions;
+    const char *FilenameStr;
+    char buff[100];
+
+    if(ConWidgets->Filename==NULL || ConWidgets->Speed==NULL ||
+            ConWidgets->StartAt==NULL)
+    {
+        return;
+    }
+
+    g_CapRep_System->KVClear(Options);
+
+    FilenameStr=g_CapRep_UI->GetTextInputText(WidgetHandle,
+            ConWidgets->Filename->Ctrl);
+    g_CapRep_System->KVAddItem(Options,"Filename",FilenameStr);
+
+    snprintf(buff,sizeof(buff),"%g",g_CapRep_UI->GetDoubleInputValue(
+            WidgetHandle,ConWidgets->Speed->Ctrl));
+    g_CapRep_System->KVAddItem(Options,"Speed",buff);
+
+    snprintf(buff,sizeof(buff),"%llu",(unsigned long long)g_CapRep_UI->
+            GetNumberInputValue(WidgetHandle,ConWidgets->StartAt->Ctrl));
+    g_CapRep_System->KVAddItem(Options,"StartAt",buff);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_ConnectionOptionsWidgets_UpdateUI
+ *
+ * SYNOPSIS:
+ *    void CaptureReplay_ConnectionOptionsWidgets_UpdateUI(
+ *              t_WidgetSysHandle *WidgetHandle,
+ *              t_ConnectionWidgetsType *ConOptions,
+ *              const char *DeviceUniqueID,t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    WidgetHandle [I] -- The handle to send to the widgets
+ *    ConOptions [I] -- The options data that was allocated with
+ *          CaptureReplay_ConnectionOptionsWidgets_AllocWidgets().
+ *    DeviceUniqueID [I] -- This is the unique ID for the device we are working
+ *                          on.
+ *    Options [I] -- The options for this connection.
+ *
+ * FUNCTION:
+ *    This function takes the widgets added with
+ *    CaptureReplay_ConnectionOptionsWidgets_AllocWidgets() and updates them
+ *    to match the key/value pair list.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureReplay_ConnectionOptionsWidgets_StoreUI()
+ ******************************************************************************/
+void CaptureReplay_ConnectionOptionsWidgets_UpdateUI(
+        t_WidgetSysHandle *WidgetHandle,t_ConnectionWidgetsType *ConOptions,
+        const char *DeviceUniqueID,t_PIKVList *Options)
+{
+    struct CaptureReplay_ConWidgets *ConWidgets=
+            (struct CaptureReplay_ConWidgets *)ConOptions;
+    const char *FilenameStr;
+    const char *SpeedStr;
+    const char *StartAtStr;
+
+    if(ConWidgets->Filename==NULL || ConWidgets->Speed==NULL ||
+            ConWidgets->StartAt==NULL)
+    {
+        return;
+    }
+
+    FilenameStr=g_CapRep_System->KVGetItem(Options,"Filename");
+    SpeedStr=g_CapRep_System->KVGetItem(Options,"Speed");
+    StartAtStr=g_CapRep_System->KVGetItem(Options,"StartAt");
+
+    if(FilenameStr==NULL)
+        FilenameStr="";
+    if(SpeedStr==NULL)
+        SpeedStr="1";
+    if(StartAtStr==NULL)
+        StartAtStr="0";
+
+    g_CapRep_UI->SetTextInputText(WidgetHandle,ConWidgets->Filename->Ctrl,
+            FilenameStr);
+    g_CapRep_UI->SetDoubleInputValue(WidgetHandle,ConWidgets->Speed->Ctrl,
+            atof(SpeedStr));
+    g_CapRep_UI->SetNumberInputValue(WidgetHandle,ConWidgets->StartAt->Ctrl,
+            strtoll(StartAtStr,NULL,10));
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_Convert_Options_To_URI
+ *
+ * SYNOPSIS:
+ *    PG_BOOL CaptureReplay_Convert_Options_To_URI(const char *DeviceUniqueID,
+ *              t_PIKVList *Options,char *URI,unsigned int MaxURILen);
+ *
+ * PARAMETERS:
+ *    DeviceUniqueID [I] -- This is the unique ID for the device we are working
+ *                          on.
+ *    Options [I] -- The options for this connection.
+ *    URI [O] -- A buffer to fill with the URI for this connection.
+ *    MaxURILen [I] -- The size of the 'URI' buffer.
+ *
+ * FUNCTION:
+ *    This function converts the options for this connection into a URI.
+ *    Only the filename is in the URI, the replay speed and start point
+ *    are defaulted when going the other way.
+ *
+ * RETURNS:
+ *    true -- all went well.
+ *    false -- There was an error or the URI didn't fit.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_Convert_URI_To_Options()
+ ******************************************************************************/
+PG_BOOL CaptureReplay_Convert_Options_To_URI(const char *DeviceUniqueID,
+            t_PIKVList *Options,char *URI,unsigned int MaxURILen)
+{
+    const char *FilenameStr;
+
+    FilenameStr=g_CapRep_System->KVGetItem(Options,"Filename");
+    if(FilenameStr==NULL)
+        return false;
+
+    if(strlen(CAPTUREREPLAY_URI_PREFIX)+3+strlen(FilenameStr)+1>=MaxURILen)
+        return false;
+
+    strcpy(URI,CAPTUREREPLAY_URI_PREFIX);
+    strcat(URI,"://");
+    strcat(URI,FilenameStr);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_Convert_URI_To_Options
+ *
+ * SYNOPSIS:
+ *    PG_BOOL CaptureReplay_Convert_URI_To_Options(const char *URI,
+ *              t_PIKVList *Options,char *DeviceUniqueID,
+ *              unsigned int MaxDeviceUniqueIDLen,PG_BOOL Update);
+ *
+ * PARAMETERS:
+ *    URI [I] -- The URI to convert to a device ID and options.
+ *    Options [O] -- The options for this new connection.
+ *    DeviceUniqueID [O] -- The unique ID for this device build from the 'URI'
+ *    MaxDeviceUniqueIDLen [I] -- The max length of the buffer for
+ *          'DeviceUniqueID'
+ *    Update [I] -- If this is true then we are updating 'Options'.  If
+ *                  false then you should default 'Options' before you
+ *                  fill in the options.
+ *
+ * FUNCTION:
+ *    This function converts a a URI string into a unique ID and options for
+ *    a connection to be opened.
+ *
+ * RETURNS:
+ *    true -- Things worked out.
+ *    false -- There was an error.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_Convert_Options_To_URI()
+ ******************************************************************************/
+PG_BOOL CaptureReplay_Convert_URI_To_Options(const char *URI,t_PIKVList *Options,
+            char *DeviceUniqueID,unsigned int MaxDeviceUniqueIDLen,
+            PG_BOOL Update)
+{
+    const char *FilenameStart;
+
+    /* Make sure it starts with REPLAY:// */
+    if(strncasecmp(URI,CAPTUREREPLAY_URI_PREFIX "://",
+            (sizeof(CAPTUREREPLAY_URI_PREFIX)-1)+1+2)!=0)   // +1 for ':' and +2 for '//'
+    {
+        return false;
+    }
+
+    FilenameStart=URI;
+    FilenameStart+=sizeof(CAPTUREREPLAY_URI_PREFIX)-1;  // -1 because of the \0
+    FilenameStart+=3;    // Slip ://
+
+    if(*FilenameStart==0)
+        return false;
+
+    if(strlen(FilenameStart)+1>=MaxDeviceUniqueIDLen)
+        return false;
+
+    if(!Update)
+        g_CapRep_System->KVClear(Options);
+
+    g_CapRep_System->KVAddItem(Options,"Filename",FilenameStart);
+    if(g_CapRep_System->KVGetItem(Options,"Speed")==NULL)
+        g_CapRep_System->KVAddItem(Options,"Speed","1");
+    if(g_CapRep_System->KVGetItem(Options,"StartAt")==NULL)
+        g_CapRep_System->KVAddItem(Options,"StartAt","0");
+
+    strcpy(DeviceUniqueID,FilenameStart);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_AllocateHandle
+ *
+ * SYNOPSIS:
+ *    t_DriverIOHandleType *CaptureReplay_AllocateHandle(
+ *              const char *DeviceUniqueID,t_IOSystemHandle *IOHandle);
+ *
+ * PARAMETERS:
+ *    DeviceUniqueID [I] -- This is the unique ID for the device we are working
+ *                          on.
+ *    IOHandle [I] -- A handle to the IO system.  This is used when talking
+ *                    the IO system (just store it and pass it went needed).
+ *
+ * FUNCTION:
+ *    This function allocates a connection to the device.
+ *
+ * RETURNS:
+ *    Newly allocated data for this connection or NULL on error.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_FreeHandle()
+ ******************************************************************************/
+t_DriverIOHandleType *CaptureReplay_AllocateHandle(const char *DeviceUniqueID,
+        t_IOSystemHandle *IOHandle)
+{
+    struct CaptureReplay_OurData *NewData;
+
+    NewData=NULL;
+    try
+    {
+        NewData=new struct CaptureReplay_OurData;
+        NewData->IOHandle=IOHandle;
+        NewData->Thread=NULL;
+        NewData->Speed=1;
+        NewData->RequestThreadQuit=false;
+        NewData->Opened=false;
+        NewData->PendingPos=0;
+        NewData->ReplayDone=false;
+        NewData->DisconnectSent=false;
+
+        NewData->Mutex=AllocMutex();
+        if(NewData->Mutex==NULL)
+            throw(0);
+    }
+    catch(...)
+    {
+        if(NewData!=NULL)
+            delete NewData;
+        return NULL;
+    }
+
+    return (t_DriverIOHandleType *)NewData;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_FreeHandle
+ *
+ * SYNOPSIS:
+ *    void CaptureReplay_FreeHandle(t_DriverIOHandleType *DriverIO);
+ *
+ * PARAMETERS:
+ *    DriverIO [I] -- The handle to this connection
+ *
+ * FUNCTION:
+ *    This function frees the data allocated with
+ *    CaptureReplay_AllocateHandle().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureReplay_AllocateHandle()
+ ******************************************************************************/
+void CaptureReplay_FreeHandle(t_DriverIOHandleType *DriverIO)
+{
+    struct CaptureReplay_OurData *OurData=
+            (struct CaptureReplay_OurData *)DriverIO;
+
+    if(OurData->Opened)
+        CaptureReplay_Close(DriverIO);
+
+    FreeMutex(OurData->Mutex);
+
+    delete OurData;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_Open
+ *
+ * SYNOPSIS:
+ *    PG_BOOL CaptureReplay_Open(t_DriverIOHandleType *DriverIO,
+ *              const t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    DriverIO [I] -- The handle to this connection
+ *    Options [I] -- The options to apply to this connection.
+ *
+ * FUNCTION:
+ *    This function opens the capture file, seeks to the start point and
+ *    starts the replay thread.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_Close(), CaptureReplay_Read()
+ ******************************************************************************/
+PG_BOOL CaptureReplay_Open(t_DriverIOHandleType *DriverIO,
+        const t_PIKVList *Options)
+{
+    struct CaptureReplay_OurData *OurData=
+            (struct CaptureReplay_OurData *)DriverIO;
+    const char *FilenameStr;
+    const char *SpeedStr;
+    const char *StartAtStr;
+    uint64_t StartAt;
+
+    if(OurData->Opened)
+        CaptureReplay_Close(DriverIO);
+
+    FilenameStr=g_CapRep_System->KVGetItem(Options,"Filename");
+    SpeedStr=g_CapRep_System->KVGetItem(Options,"Speed");
+    StartAtStr=g_CapRep_System->KVGetItem(Options,"StartAt");
+
+    if(FilenameStr==NULL)
+        return false;
+
+    OurData->Speed=1;
+    if(SpeedStr!=NULL)
+        OurData->Speed=atof(SpeedStr);
+    if(OurData->Speed<0)
+        OurData->Speed=0;
+
+    StartAt=0;
+    if(StartAtStr!=NULL)
+        StartAt=strtoull(StartAtStr,NULL,10);
+
+    if(!OurData->Reader.Open(FilenameStr))
+        return false;
+
+    OurData->Reader.SeekTime(StartAt*1000000000ULL);
+
+    OurData->Pending.clear();
+    OurData->PendingPos=0;
+    OurData->ReplayDone=false;
+    OurData->DisconnectSent=false;
+    OurData->RequestThreadQuit=false;
+
+    g_CapRep_IOSystem->DrvDataEvent(OurData->IOHandle,
+            e_DataEventCode_Connected);
+
+    OurData->Thread=StartThread(false,CaptureReplay_ReplayThread,OurData);
+    if(OurData->Thread==NULL)
+    {
+        OurData->Reader.Close();
+        g_CapRep_IOSystem->DrvDataEvent(OurData->IOHandle,
+                e_DataEventCode_Disconnected);
+        return false;
+    }
+
+    OurData->Opened=true;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_Close
+ *
+ * SYNOPSIS:
+ *    void CaptureReplay_Close(t_DriverIOHandleType *DriverIO);
+ *
+ * PARAMETERS:
+ *    DriverIO [I] -- The handle to this connection
+ *
+ * FUNCTION:
+ *    This function stops the replay and closes the capture file.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureReplay_Open()
+ ******************************************************************************/
+void CaptureReplay_Close(t_DriverIOHandleType *DriverIO)
+{
+    struct CaptureReplay_OurData *OurData=
+            (struct CaptureReplay_OurData *)DriverIO;
+    bool SendDisconnect;
+
+    if(!OurData->Opened)
+        return;
+
+    OurData->RequestThreadQuit=true;
+    Wait4ThreadToExit(OurData->Thread);
+    OurData->Thread=NULL;
+
+    OurData->Reader.Close();
+
+    LockMutex(OurData->Mutex);
+    OurData->Pending.clear();
+    OurData->PendingPos=0;
+    SendDisconnect=!OurData->DisconnectSent;
+    OurData->DisconnectSent=true;
+    UnLockMutex(OurData->Mutex);
+
+    OurData->Opened=false;
+
+    if(SendDisconnect)
+    {
+        g_CapRep_IOSystem->DrvDataEvent(OurData->IOHandle,
+                e_DataEventCode_Disconnected);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_Read
+ *
+ * SYNOPSIS:
+ *    int CaptureReplay_Read(t_DriverIOHandleType *DriverIO,uint8_t *Data,
+ *              int MaxBytes);
+ *
+ * PARAMETERS:
+ *    DriverIO [I] -- The handle to this connection
+ *    Data [I] -- A buffer to store the data that was read.
+ *    MaxBytes [I] -- The max number of bytes that can be stored in 'Data'
+ *
+ * FUNCTION:
+ *    This function gets the bytes the replay thread has released.  When the
+ *    end of the capture is reached (and all the bytes have been read) we
+ *    disconnect.
+ *
+ * RETURNS:
+ *    The number of bytes that was read or:
+ *      RETERROR_NOBYTES -- No bytes was read (0)
+ *      RETERROR_DISCONNECT -- This device is no longer open.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_Open()
+ ******************************************************************************/
+int CaptureReplay_Read(t_DriverIOHandleType *DriverIO,uint8_t *Data,
+        int MaxBytes)
+{
+    struct CaptureReplay_OurData *OurData=
+            (struct CaptureReplay_OurData *)DriverIO;
+    size_t Bytes;
+    bool SendDisconnect;
+
+    if(!OurData->Opened)
+        return RETERROR_DISCONNECT;
+
+    LockMutex(OurData->Mutex);
+
+    Bytes=OurData->Pending.size()-OurData->PendingPos;
+    if(Bytes>(size_t)MaxBytes)
+        Bytes=MaxBytes;
+
+    if(Bytes>0)
+    {
+        memcpy(Data,&OurData->Pending[OurData->PendingPos],Bytes);
+        OurData->PendingPos+=Bytes;
+
+        /* Drop what we have read (most of the time the buffer is
+           emptied so this is just a clear()) */
+        if(OurData->PendingPos>=OurData->Pending.size())
+        {
+            OurData->Pending.clear();
+            OurData->PendingPos=0;
+        }
+        else if(OurData->PendingPos>=OurData->Pending.size()/2)
+        {
+            OurData->Pending.erase(OurData->Pending.begin(),
+                    OurData->Pending.begin()+OurData->PendingPos);
+            OurData->PendingPos=0;
+        }
+    }
+
+    SendDisconnect=false;
+    if(OurData->ReplayDone && OurData->Pending.empty() &&
+            !OurData->DisconnectSent)
+    {
+        OurData->DisconnectSent=true;
+        SendDisconnect=true;
+    }
+
+    UnLockMutex(OurData->Mutex);
+
+    if(SendDisconnect)
+    {
+        g_CapRep_IOSystem->DrvDataEvent(OurData->IOHandle,
+                e_DataEventCode_Disconnected);
+    }
+
+    return Bytes;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_Write
+ *
+ * SYNOPSIS:
+ *    int CaptureReplay_Write(t_DriverIOHandleType *DriverIO,
+ *              const uint8_t *Data,int Bytes);
+ *
+ * PARAMETERS:
+ *    DriverIO [I] -- The handle to this connection
+ *    Data [I] -- The data to write to the device.
+ *    Bytes [I] -- The number of bytes to write.
+ *
+ * FUNCTION:
+ *    A replay has nothing to send to so the bytes are thrown away.
+ *
+ * RETURNS:
+ *    The number of bytes written or:
+ *      RETERROR_DISCONNECT -- This device is no longer open.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_Read()
+ ******************************************************************************/
+int CaptureReplay_Write(t_DriverIOHandleType *DriverIO,const uint8_t *Data,
+        int Bytes)
+{
+    struct CaptureReplay_OurData *OurData=
+            (struct CaptureReplay_OurData *)DriverIO;
+
+    if(!OurData->Opened)
+        return RETERROR_DISCONNECT;
+
+    return Bytes;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_ChangeOptions
+ *
+ * SYNOPSIS:
+ *    PG_BOOL CaptureReplay_ChangeOptions(t_DriverIOHandleType *DriverIO,
+ *              const t_PIKVList *Options);
+ *
+ * PARAMETERS:
+ *    DriverIO [I] -- The handle to this connection
+ *    Options [I] -- The options to apply to this connection.
+ *
+ * FUNCTION:
+ *    This function changes the options.  If we are playing then the replay
+ *    is restarted with the new options.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.
+ *
+ * SEE ALSO:
+ *    CaptureReplay_Open()
+ ******************************************************************************/
+PG_BOOL CaptureReplay_ChangeOptions(t_DriverIOHandleType *DriverIO,
+        const t_PIKVList *Options)
+{
+    struct CaptureReplay_OurData *OurData=
+            (struct CaptureReplay_OurData *)DriverIO;
+
+    if(!OurData->Opened)
+        return true;
+
+    return CaptureReplay_Open(DriverIO,Options);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureReplay_ReplayThread
+ *
+ * SYNOPSIS:
+ *    static void CaptureReplay_ReplayThread(void *Arg);
+ *
+ * PARAMETERS:
+ *    Arg [I] -- The 'struct CaptureReplay_OurData' for this connection
+ *
+ * FUNCTION:
+ *    This is the thread that walks the capture and releases the RX records
+ *    to CaptureReplay_Read() when they are due.
+ *
+ *    The times are taken from the records (scaled by 'Speed') and gaps
+ *    longer than CAPTUREREPLAY_MAX_GAP are cut down (appended captures can
+ *    have hours between them).  With a speed of 0 records are released as
+ *    fast as the connection reads them.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureReplay_Read()
+ ******************************************************************************/
+static void CaptureReplay_ReplayThread(void *Arg)
+{
+    struct CaptureReplay_OurData *OurData=(struct CaptureReplay_OurData *)Arg;
+    struct CaptureFileRecord Rec;
+    uint64_t StartClock;
+    uint64_t FirstTimestamp;
+    uint64_t PrevTimestamp;
+    uint64_t Skipped;
+    uint64_t Due;
+    uint64_t Now;
+    uint64_t WaitMS;
+    size_t Waiting;
+    bool First;
+    bool SendDisconnect;
+
+    StartClock=GetElapsedTime_ns();
+    FirstTimestamp=0;
+    PrevTimestamp=0;
+    Skipped=0;
+    First=true;
+
+    while(!OurData->RequestThreadQuit && OurData->Reader.ReadRecord(Rec))
+    {
+        if(Rec.Type!=e_CaptureRec_RX)
+            continue;
+
+        if(First)
+        {
+            FirstTimestamp=Rec.Timestamp;
+            PrevTimestamp=Rec.Timestamp;
+            First=false;
+        }
+
+        if(OurData->Speed>0)
+        {
+            if(Rec.Timestamp-PrevTimestamp>CAPTUREREPLAY_MAX_GAP)
+                Skipped+=Rec.Timestamp-PrevTimestamp-CAPTUREREPLAY_MAX_GAP;
+            PrevTimestamp=Rec.Timestamp;
+
+            Due=(uint64_t)((Rec.Timestamp-FirstTimestamp-Skipped)/
+                    OurData->Speed);
+
+            while(!OurData->RequestThreadQuit)
+            {
+                /* Anything due in less than 1ms goes now */
+                Now=GetElapsedTime_ns()-StartClock;
+                if(Now+1000000>=Due)
+                    break;
+
+                WaitMS=(Due-Now)/1000000;
+                if(WaitMS>CAPTUREREPLAY_POLL_MS)
+                    WaitMS=CAPTUREREPLAY_POLL_MS;
+                OS_Sleep(WaitMS);
+            }
+        }
+
+        /* Don't get too far ahead of the connection */
+        while(!OurData->RequestThreadQuit)
+        {
+            LockMutex(OurData->Mutex);
+            Waiting=OurData->Pending.size()-OurData->PendingPos;
+            UnLockMutex(OurData->Mutex);
+            if(Waiting<CAPTUREREPLAY_MAX_PENDING)
+                break;
+            OS_Sleep(1);
+        }
+        if(OurData->RequestThreadQuit)
+            break;
+
+        LockMutex(OurData->Mutex);
+        try
+        {
+            OurData->Pending.insert(OurData->Pending.end(),Rec.Data,
+                    Rec.Data+Rec.Length);
+        }
+        catch(...)
+        {
+            /* Out of memory, drop this record */
+        }
+        UnLockMutex(OurData->Mutex);
+
+        g_CapRep_IOSystem->DrvDataEvent(OurData->IOHandle,
+                e_DataEventCode_BytesAvailable);
+    }
+
+    if(OurData->RequestThreadQuit)
+        return;
+
+    /* We are at the end.  Disconnect once everything has been read */
+    LockMutex(OurData->Mutex);
+    OurData->ReplayDone=true;
+    SendDisconnect=false;
+    if(OurData->Pending.empty() && !OurData->DisconnectSent)
+    {
+        OurData->DisconnectSent=true;
+        SendDisconnect=true;
+    }
+    UnLockMutex(OurData->Mutex);
+
+    if(SendDisconnect)
+    {
+        g_CapRep_IOSystem->DrvDataEvent(OurData->IOHandle,
+                e_DataEventCode_Disconnected);
+    }
+    else
+    {
+        g_CapRep_IOSystem->DrvDataEvent(OurData->IOHandle,
+                e_DataEventCode_BytesAvailable);
+    }
+}
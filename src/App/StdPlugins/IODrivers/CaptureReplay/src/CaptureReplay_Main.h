@@ -0,0 +1,52 @@
+/*******************************************************************************
+ * FILENAME: CaptureReplay_Main.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __CAPTUREREPLAY_MAIN_H_
+#define __CAPTUREREPLAY_MAIN_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include "PluginSDK/Plugin.h"
+
+/***  DEFINES                          ***/
+
+/***  MACROS                           ***/
+
+/***  TYPE DEFINITIONS                 ***/
+
+/***  CLASS DEFINITIONS                ***/
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+extern const struct IOS_API *g_CapRep_IOSystem;
+extern const struct PI_UIAPI *g_CapRep_UI;
+extern const struct PI_SystemAPI *g_CapRep_System;
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+
+#endif   /* end of "#ifndef __CAPTUREREPLAY_MAIN_H_" */
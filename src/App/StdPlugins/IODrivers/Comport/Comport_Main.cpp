@@ -60,6 +60,7 @@ struct ComportSettingsWidgetData
 
 /*** FUNCTION PROTOTYPES      ***/
 PG_BOOL Comport_Init(void);
+void Comport_Shutdown(void);
 const struct IODriverInfo *Comport_GetDriverInfo(unsigned int *SizeOfInfo);
 const struct IODriverDetectedInfo *Comport_DetectDevices(void);
 void Comport_FreeDetectedDevices(const struct IODriverDetectedInfo *Devices);
@@ -107,6 +108,9 @@ const struct IODriverAPI g_ComportPluginAPI=
     Comport_FreeSettingsWidgets,
     Comport_StoreSettings,
     Comport_ApplySettings,
+
+    /* V4 */
+    Comport_Shutdown,
 };
 
 struct IODriverInfo m_ComportInfo=
@@ -203,9 +207,37 @@ extern "C"
  ******************************************************************************/
 PG_BOOL Comport_Init(void)
 {
+    /* Start finding the ports now so the list is ready when it's needed */
+    Comport_OS_StartDeviceMonitor();
+
     return true;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    Comport_Shutdown
+ *
+ * SYNOPSIS:
+ *    void Comport_Shutdown(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is called when WhippyTerm is shutting down.  It stops
+ *    the device monitor.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Comport_Init()
+ ******************************************************************************/
+void Comport_Shutdown(void)
+{
+    Comport_OS_StopDeviceMonitor();
+}
+
 /*******************************************************************************
  * NAME:
  *   Comport_GetDriverInfo
@@ -58,6 +58,8 @@ typedef struct OSComportHandle t_OSComportHandle;
 /***  GLOBAL VARIABLE DEFINITIONS      ***/
 
 /***  EXTERNAL FUNCTION PROTOTYPES     ***/
+void Comport_OS_StartDeviceMonitor(void);
+void Comport_OS_StopDeviceMonitor(void);
 bool Comport_OS_GetSerialPortList(t_OSComportListType &List);
 bool Comport_OS_SerialPortBusy(const std::string &DriverName);
 t_DriverIOHandleType *Comport_AllocateHandle(const char *DeviceUniqueID,
@@ -63,13 +63,18 @@ Give this some thought....
 #include <stdlib.h>
 #include <errno.h>
 #include <termios.h>
-#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
 
 //#include <stdio.h>  // Remove me
 
 using namespace std;
 
 /*** DEFINES                  ***/
+#define COMPORT_DEVMON_POLL_SECS            5
+#define COMPORT_DEVMON_RETRY_MS             250     // How long to wait before probing a new tty again
+#define COMPORT_DEVMON_RETRIES              8       // How many times to probe a new tty that failed
+#define COMPORT_UEVENT_BUFF_SIZE            4096
 
 /*** MACROS                   ***/
 
@@ -95,6 +100,12 @@ struct OpenComportInfo
 typedef list<string> t_PossibleComPortList;
 typedef t_PossibleComPortList::iterator i_PossibleComPortList;
 
+typedef map<string,bool> t_ComportProbeCacheType;   // tty name -> is a serial port
+typedef t_ComportProbeCacheType::iterator i_ComportProbeCacheType;
+
+typedef map<string,int> t_ComportProbeRetryType;    // tty name -> retries left
+typedef t_ComportProbeRetryType::iterator i_ComportProbeRetryType;
+
 /* From: #include <asm/termbits.h> but can't be used with normal termios.h so
    we defined it directly.  Not great but seems to work... */
 struct termios2
@@ -113,12 +124,136 @@ struct termios2
 static bool Comport_ProcessUEventFile(const char *Filename,const char *Tag,
         char *Value,int MaxValueLen);
 static void *Comport_OS_PollThread(void *arg);
+static void *Comport_OS_DevMonThread(void *arg);
+static void Comport_OS_UpdateDeviceCache(void);
+static bool Comport_OS_ProbePort(const char *Name);
 static bool Comport_OS_ConfigPort(struct OpenComportInfo *ComInfo,
         uint32_t BitRate,e_ComportDataBitsType DataBits,
         e_ComportParityType Parity,e_ComportStopBitsType StopBits,
         e_ComportFlowControlType FlowControl);
 
 /*** VARIABLE DEFINITIONS     ***/
+static pthread_mutex_t m_DevMonMutex=PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t m_DevMonScanDone=PTHREAD_COND_INITIALIZER;
+static bool m_DevMonStarted;
+static bool m_DevMonQuit;
+static bool m_DevMonFirstScanDone;
+static pthread_t m_DevMonThread;
+static int m_DevMonWakePipe[2]={-1,-1};    // Written to wake the thread to quit
+static t_ComportProbeCacheType m_DevMonCache;
+
+/*******************************************************************************
+ * NAME:
+ *    Comport_OS_StartDeviceMonitor
+ *
+ * SYNOPSIS:
+ *    void Comport_OS_StartDeviceMonitor(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function starts the thread that keeps the list of serial ports
+ *    up to date.  The thread does the first scan (so it's done before the
+ *    user asks for a list) and then listens for hotplug events from the
+ *    kernel.  Only new (or changed) tty's are probed.
+ *
+ *    If we can't get hotplug events (no netlink) the thread checks the
+ *    names in /sys/class/tty every few seconds instead.  This is cheap
+ *    because only new names are probed.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * NOTES:
+ *    It's safe to call this more than once.
+ *
+ * SEE ALSO:
+ *    Comport_OS_GetSerialPortList(), Comport_OS_StopDeviceMonitor()
+ ******************************************************************************/
+void Comport_OS_StartDeviceMonitor(void)
+{
+    pthread_mutex_lock(&m_DevMonMutex);
+    if(m_DevMonStarted)
+    {
+        pthread_mutex_unlock(&m_DevMonMutex);
+        return;
+    }
+
+    /* If we can't make the wake up pipe or the thread we will have to scan
+       on the main thread */
+    if(pipe2(m_DevMonWakePipe,O_CLOEXEC|O_NONBLOCK)!=0)
+    {
+        m_DevMonWakePipe[0]=-1;
+        m_DevMonWakePipe[1]=-1;
+        pthread_mutex_unlock(&m_DevMonMutex);
+        return;
+    }
+
+    m_DevMonQuit=false;
+    if(pthread_create(&m_DevMonThread,NULL,Comport_OS_DevMonThread,NULL)!=0)
+    {
+        close(m_DevMonWakePipe[0]);
+        close(m_DevMonWakePipe[1]);
+        m_DevMonWakePipe[0]=-1;
+        m_DevMonWakePipe[1]=-1;
+        pthread_mutex_unlock(&m_DevMonMutex);
+        return;
+    }
+    m_DevMonStarted=true;
+    pthread_mutex_unlock(&m_DevMonMutex);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Comport_OS_StopDeviceMonitor
+ *
+ * SYNOPSIS:
+ *    void Comport_OS_StopDeviceMonitor(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function stops the device monitor thread and waits for it to
+ *    exit.  This must be called before we exit so the thread isn't still
+ *    using 'm_DevMonCache' when it's destroyed.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Comport_OS_StartDeviceMonitor()
+ ******************************************************************************/
+void Comport_OS_StopDeviceMonitor(void)
+{
+    char Wake;
+
+    pthread_mutex_lock(&m_DevMonMutex);
+    if(!m_DevMonStarted)
+    {
+        pthread_mutex_unlock(&m_DevMonMutex);
+        return;
+    }
+    m_DevMonQuit=true;
+    pthread_mutex_unlock(&m_DevMonMutex);
+
+    Wake=0;
+    if(write(m_DevMonWakePipe[1],&Wake,1)<0)
+    {
+        /* The pipe is full so the thread is already being woken up */
+    }
+    pthread_join(m_DevMonThread,NULL);
+
+    close(m_DevMonWakePipe[0]);
+    close(m_DevMonWakePipe[1]);
+    m_DevMonWakePipe[0]=-1;
+    m_DevMonWakePipe[1]=-1;
+
+    pthread_mutex_lock(&m_DevMonMutex);
+    m_DevMonStarted=false;
+    pthread_mutex_unlock(&m_DevMonMutex);
+}
 
 /*******************************************************************************
  * NAME:
@@ -131,23 +266,165 @@ static bool Comport_OS_ConfigPort(struct OpenComportInfo *ComInfo,
  *    List [I] -- The list to populate.
  *
  * FUNCTION:
- *    This function scans the system for a list of available serial ports.
+ *    This function gets the list of available serial ports.  The ports are
+ *    found by the device monitor thread so this just copies the last
+ *    results.  The first time it's called it has to wait for the first scan
+ *    to finish.
  *
  * RETURNS:
  *    true -- Success.
  *    false -- An error was detected.
  *
  * SEE ALSO:
- *    
+ *    Comport_OS_StartDeviceMonitor()
  ******************************************************************************/
 bool Comport_OS_GetSerialPortList(t_OSComportListType &List)
+{
+    i_ComportProbeCacheType Dev;
+    struct ComportInfo NewComportInfo;
+
+    Comport_OS_StartDeviceMonitor();
+
+    pthread_mutex_lock(&m_DevMonMutex);
+    if(!m_DevMonStarted)
+    {
+        /* No thread, do the scan our self */
+        pthread_mutex_unlock(&m_DevMonMutex);
+        Comport_OS_UpdateDeviceCache();
+        pthread_mutex_lock(&m_DevMonMutex);
+    }
+
+    while(!m_DevMonFirstScanDone)
+        pthread_cond_wait(&m_DevMonScanDone,&m_DevMonMutex);
+
+    try
+    {
+        for(Dev=m_DevMonCache.begin();Dev!=m_DevMonCache.end();Dev++)
+        {
+            if(!Dev->second)
+                continue;
+
+            NewComportInfo.DriverName="/dev/";
+            NewComportInfo.DriverName+=Dev->first;
+            NewComportInfo.FullName=Dev->first;
+            NewComportInfo.ShortName=Dev->first;
+            List.push_back(NewComportInfo);
+        }
+    }
+    catch(...)
+    {
+        pthread_mutex_unlock(&m_DevMonMutex);
+        return false;
+    }
+    pthread_mutex_unlock(&m_DevMonMutex);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Comport_OS_UpdateDeviceCache
+ *
+ * SYNOPSIS:
+ *    static void Comport_OS_UpdateDeviceCache(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function reads the names in /sys/class/tty and updates the cache
+ *    of probed devices.  Names that are gone are removed and names that we
+ *    don't have a probe result for are probed.  Everything else uses the
+ *    cached result.
+ *
+ *    The probing is done without the lock held (it opens the devices which
+ *    can be slow).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Comport_OS_ProbePort()
+ ******************************************************************************/
+static void Comport_OS_UpdateDeviceCache(void)
 {
     DIR *d;
     struct dirent *dir;
     t_PossibleComPortList Possibles;
-    string filename;
     i_PossibleComPortList pcpli;
-    struct ComportInfo NewComportInfo;
+    t_ComportProbeCacheType NewCache;
+    i_ComportProbeCacheType Cached;
+
+    try
+    {
+        d=opendir("/sys/class/tty");
+        if(d)
+        {
+            while((dir = readdir(d)) != NULL)
+            {
+                if(strcmp(dir->d_name,".")!=0 && strcmp(dir->d_name,"..")!=0)
+                    Possibles.push_back(dir->d_name);
+            }
+
+            closedir(d);
+        }
+
+        /* Copy what we already know (probing is done outside the lock) */
+        pthread_mutex_lock(&m_DevMonMutex);
+        for(pcpli=Possibles.begin();pcpli!=Possibles.end();pcpli++)
+        {
+            Cached=m_DevMonCache.find(*pcpli);
+            if(Cached!=m_DevMonCache.end())
+                NewCache.insert(*Cached);
+        }
+        pthread_mutex_unlock(&m_DevMonMutex);
+
+        for(pcpli=Possibles.begin();pcpli!=Possibles.end();pcpli++)
+        {
+            if(NewCache.find(*pcpli)==NewCache.end())
+                NewCache[*pcpli]=Comport_OS_ProbePort(pcpli->c_str());
+        }
+    }
+    catch(...)
+    {
+        /* Keep the old cache, but don't leave anyone waiting */
+        pthread_mutex_lock(&m_DevMonMutex);
+        m_DevMonFirstScanDone=true;
+        pthread_cond_broadcast(&m_DevMonScanDone);
+        pthread_mutex_unlock(&m_DevMonMutex);
+        return;
+    }
+
+    pthread_mutex_lock(&m_DevMonMutex);
+    m_DevMonCache.swap(NewCache);
+    m_DevMonFirstScanDone=true;
+    pthread_cond_broadcast(&m_DevMonScanDone);
+    pthread_mutex_unlock(&m_DevMonMutex);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Comport_OS_ProbePort
+ *
+ * SYNOPSIS:
+ *    static bool Comport_OS_ProbePort(const char *Name);
+ *
+ * PARAMETERS:
+ *    Name [I] -- The name of the tty (from /sys/class/tty)
+ *
+ * FUNCTION:
+ *    This function checks if a tty is a real serial port.
+ *
+ * RETURNS:
+ *    true -- This is a serial port
+ *    false -- This isn't a serial port.
+ *
+ * SEE ALSO:
+ *    Comport_OS_UpdateDeviceCache()
+ ******************************************************************************/
+static bool Comport_OS_ProbePort(const char *Name)
+{
+    string filename;
     char driver[100];
     char devname[100];
     int fd;
@@ -181,99 +458,272 @@ bool Comport_OS_GetSerialPortList(t_OSComportListType &List)
               tcgetattr())
     */
 
-    d=opendir("/sys/class/tty");
-    if(d)
+    TryGetSerialInfo=false;
+    driver[0]=0;
+
+    filename="/sys/class/tty/";
+    filename+=Name;
+    filename+="/device/uevent";
+
+    if(!Comport_ProcessUEventFile(filename.c_str(),"DRIVER",driver,
+            sizeof(driver)))
     {
-        while((dir = readdir(d)) != NULL)
-        {
-            /* Check if it has a real driver */
-            filename="/sys/class/tty/";
-            filename+=dir->d_name;
+        TryGetSerialInfo=true;
+    }
 
-            if(strcmp(dir->d_name,".")!=0 && strcmp(dir->d_name,"..")!=0)
+    /* We need to double check if it's a 8250 or "port" */
+    if(!TryGetSerialInfo && strcmp(driver,"serial8250")!=0 &&
+            strcmp(driver,"port")!=0)
+    {
+        return true;
+    }
+
+    Valid=false;
+    filename="/sys/class/tty/";
+    filename+=Name;
+    filename+="/uevent";
+
+    if(Comport_ProcessUEventFile(filename.c_str(),"DEVNAME",devname,
+            sizeof(devname)))
+    {
+        filename="/dev/";
+        filename+=devname;
+
+        /* Check if it's real */
+        fd=open(filename.c_str(),O_RDWR | O_NONBLOCK | O_NOCTTY);
+        if(fd!=-1)
+        {
+            if(ioctl(fd,TIOCGSERIAL,&serialinfo)>=0)
             {
-                Possibles.push_back(dir->d_name);
+                /* If it supports this ioctl then we count it as serial
+                   port */
+
+                /* Ok, ttySx drivers that say they are "port" need more
+                   verifing because they reply to TIOCGSERIAL but don't
+                   let you do a tcgetattr() on them. */
+                if(strcmp(driver,"port")==0)
+                {
+                    if(tcgetattr(fd,&tio)>=0)
+                    {
+                        /* Looks like it's a real port */
+                        Valid=true;
+                    }
+                }
+                else
+                {
+                    Valid=true;
+                }
             }
+            close(fd);
         }
-
-        closedir(d);
     }
 
-    /* Ok, try to open each com port to which ones are really instead */
-    for(pcpli=Possibles.begin();pcpli!=Possibles.end();pcpli++)
+    return Valid;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Comport_OS_DevMonThread
+ *
+ * SYNOPSIS:
+ *    static void *Comport_OS_DevMonThread(void *arg);
+ *
+ * PARAMETERS:
+ *    arg [I] -- Not used
+ *
+ * FUNCTION:
+ *    This is the device monitor thread.  It does the first scan and then
+ *    waits for kernel uevents for tty's.  When a tty is added, changed, or
+ *    removed it's cached probe result is thrown away and the cache is
+ *    updated.
+ *
+ *    The kernel sends the uevent before udev has made the /dev node (or set
+ *    it's permissions) so a new tty that fails the probe is probed again
+ *    every COMPORT_DEVMON_RETRY_MS (up to COMPORT_DEVMON_RETRIES times).
+ *
+ *    The thread runs until Comport_OS_StopDeviceMonitor() wakes it with
+ *    'm_DevMonWakePipe'.
+ *
+ * RETURNS:
+ *    NULL
+ *
+ * SEE ALSO:
+ *    Comport_OS_StartDeviceMonitor()
+ ******************************************************************************/
+static void *Comport_OS_DevMonThread(void *arg)
+{
+    struct sockaddr_nl Addr;
+    int sock;
+    fd_set ReadSet;
+    struct timeval Timeout;
+    char buff[COMPORT_UEVENT_BUFF_SIZE];
+    ssize_t Bytes;
+    const char *Pos;
+    const char *End;
+    const char *Action;
+    const char *SubSystem;
+    const char *DevPath;
+    const char *Name;
+    bool Changed;
+    t_ComportProbeRetryType Retries;
+    i_ComportProbeRetryType Retry;
+    i_ComportProbeCacheType Cached;
+    int MaxFD;
+    int r;
+
+    /* Start listening before we scan so we don't miss anything */
+    sock=socket(AF_NETLINK,SOCK_DGRAM|SOCK_CLOEXEC,NETLINK_KOBJECT_UEVENT);
+    if(sock>=0)
     {
-        TryGetSerialInfo=false;
+        memset(&Addr,0x00,sizeof(Addr));
+        Addr.nl_family=AF_NETLINK;
+        Addr.nl_pid=0;
+        Addr.nl_groups=1;   // Kernel events
+        if(bind(sock,(struct sockaddr *)&Addr,sizeof(Addr))<0)
+        {
+            close(sock);
+            sock=-1;
+        }
+    }
 
-        filename="/sys/class/tty/";
-        filename+=*pcpli;
-        filename+="/device/uevent";
+    Comport_OS_UpdateDeviceCache();
 
-        if(!Comport_ProcessUEventFile(filename.c_str(),"DRIVER",driver,
-                sizeof(driver)))
+    for(;;)
+    {
+        FD_ZERO(&ReadSet);
+        FD_SET(m_DevMonWakePipe[0],&ReadSet);
+        MaxFD=m_DevMonWakePipe[0];
+        if(sock>=0)
+        {
+            FD_SET(sock,&ReadSet);
+            if(sock>MaxFD)
+                MaxFD=sock;
+        }
+        if(Retries.empty())
+        {
+            Timeout.tv_sec=COMPORT_DEVMON_POLL_SECS;
+            Timeout.tv_usec=0;
+        }
+        else
         {
-            TryGetSerialInfo=true;
+            Timeout.tv_sec=0;
+            Timeout.tv_usec=COMPORT_DEVMON_RETRY_MS*1000;
         }
+        r=select(MaxFD+1,&ReadSet,NULL,NULL,&Timeout);
 
-        Valid=false;
-        /* We need to double check if it's a 8250 or "port" */
-        if(TryGetSerialInfo || strcmp(driver,"serial8250")==0 ||
-                strcmp(driver,"port")==0)
+        pthread_mutex_lock(&m_DevMonMutex);
+        if(m_DevMonQuit)
         {
-            filename="/sys/class/tty/";
-            filename+=*pcpli;
-            filename+="/uevent";
+            pthread_mutex_unlock(&m_DevMonMutex);
+            break;
+        }
+        pthread_mutex_unlock(&m_DevMonMutex);
+
+        if(r<0)
+        {
+            if(errno!=EINTR && sock>=0)
+            {
+                close(sock);
+                sock=-1;
+            }
+            continue;
+        }
 
-            if(Comport_ProcessUEventFile(filename.c_str(),"DEVNAME",devname,
-                    sizeof(devname)))
+        Changed=false;
+        if(r==0)
+        {
+            if(sock<0)
             {
-                filename="/dev/";
-                filename+=devname;
+                /* No hotplug events, just check for new names now and
+                   again */
+                Changed=true;
+            }
 
-                /* Check if it's real */
-                fd=open(filename.c_str(),O_RDWR | O_NONBLOCK | O_NOCTTY);
-                if(fd!=-1)
+            /* Probe the new tty's that failed again */
+            pthread_mutex_lock(&m_DevMonMutex);
+            for(Retry=Retries.begin();Retry!=Retries.end();Retry++)
+                m_DevMonCache.erase(Retry->first);
+            pthread_mutex_unlock(&m_DevMonMutex);
+            if(!Retries.empty())
+                Changed=true;
+        }
+        else if(sock>=0 && FD_ISSET(sock,&ReadSet))
+        {
+            /* Read all the events that are waiting and update once */
+            while((Bytes=recv(sock,buff,sizeof(buff)-1,MSG_DONTWAIT))>0)
+            {
+                buff[Bytes]=0;
+
+                /* "ACTION@DEVPATH\0KEY=VALUE\0KEY=VALUE\0..." */
+                Action=NULL;
+                SubSystem=NULL;
+                DevPath=NULL;
+                End=buff+Bytes;
+                for(Pos=buff;Pos<End;Pos+=strlen(Pos)+1)
                 {
-                    if(ioctl(fd,TIOCGSERIAL,&serialinfo)>=0)
-                    {
-                        /* If it supports this ioctl then we count it as serial
-                           port */
+                    if(strncmp(Pos,"ACTION=",7)==0)
+                        Action=Pos+7;
+                    else if(strncmp(Pos,"SUBSYSTEM=",10)==0)
+                        SubSystem=Pos+10;
+                    else if(strncmp(Pos,"DEVPATH=",8)==0)
+                        DevPath=Pos+8;
+                }
+                if(SubSystem==NULL || DevPath==NULL ||
+                        strcmp(SubSystem,"tty")!=0)
+                {
+                    continue;
+                }
 
-                        /* Ok, ttySx drivers that say they are "port" need more
-                           verifing because they reply to TIOCGSERIAL but don't
-                           let you do a tcgetattr() on them. */
-                        if(strcmp(driver,"port")==0)
-                        {
-                            if(tcgetattr(fd,&tio)>=0)
-                            {
-                                /* Looks like it's a real port */
-                                Valid=true;
-                            }
-                        }
-                        else
-                        {
-                            Valid=true;
-                        }
-                    }
-                    close(fd);
+                Name=strrchr(DevPath,'/');
+                Name=Name==NULL?DevPath:Name+1;
+
+                /* Throw away what we knew about this device */
+                pthread_mutex_lock(&m_DevMonMutex);
+                m_DevMonCache.erase(Name);
+                pthread_mutex_unlock(&m_DevMonMutex);
+                Changed=true;
+
+                try
+                {
+                    if(Action!=NULL && strcmp(Action,"remove")==0)
+                        Retries.erase(Name);
+                    else
+                        Retries[Name]=COMPORT_DEVMON_RETRIES;
+                }
+                catch(...)
+                {
                 }
             }
         }
-        else
-        {
-            Valid=true;
-        }
 
-        if(Valid)
+        if(!Changed)
+            continue;
+
+        Comport_OS_UpdateDeviceCache();
+
+        /* Stop retrying the tty's that are now serial ports (or are gone, or
+           have run out of tries) */
+        pthread_mutex_lock(&m_DevMonMutex);
+        for(Retry=Retries.begin();Retry!=Retries.end();)
         {
-            NewComportInfo.DriverName="/dev/";
-            NewComportInfo.DriverName+=*pcpli;
-            NewComportInfo.FullName=*pcpli;
-            NewComportInfo.ShortName=*pcpli;
-            List.push_back(NewComportInfo);
+            Cached=m_DevMonCache.find(Retry->first);
+            if(Cached==m_DevMonCache.end() || Cached->second ||
+                    --Retry->second<=0)
+            {
+                Retry=Retries.erase(Retry);
+            }
+            else
+            {
+                Retry++;
+            }
         }
+        pthread_mutex_unlock(&m_DevMonMutex);
     }
 
-    return true;
+    if(sock>=0)
+        close(sock);
+
+    return NULL;
 }
 
 /*******************************************************************************
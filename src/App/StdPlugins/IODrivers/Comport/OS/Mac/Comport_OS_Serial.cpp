@@ -44,6 +44,14 @@
 
 #warning TBD
 
+void Comport_OS_StartDeviceMonitor(void)
+{
+}
+
+void Comport_OS_StopDeviceMonitor(void)
+{
+}
+
 bool Comport_OS_GetSerialPortList(t_OSComportListType &List)
 {
     return false;
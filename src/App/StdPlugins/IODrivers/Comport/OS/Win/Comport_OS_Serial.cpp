@@ -82,6 +82,55 @@ static bool Comport_OS_ConfigPort(struct OpenComportInfo *ComInfo,
 
 /*** VARIABLE DEFINITIONS     ***/
 
+/*******************************************************************************
+ * NAME:
+ *    Comport_OS_StartDeviceMonitor
+ *
+ * SYNOPSIS:
+ *    void Comport_OS_StartDeviceMonitor(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function starts watching for serial ports being added / removed.
+ *    Windows asks SetupAPI for the ports (nothing is opened) which is fast
+ *    so this does nothing.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Comport_OS_GetSerialPortList()
+ ******************************************************************************/
+void Comport_OS_StartDeviceMonitor(void)
+{
+}
+
+/*******************************************************************************
+ * NAME:
+ *    Comport_OS_StopDeviceMonitor
+ *
+ * SYNOPSIS:
+ *    void Comport_OS_StopDeviceMonitor(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function stops watching for serial ports.  There is nothing
+ *    running on Windows so this does nothing.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    Comport_OS_StartDeviceMonitor()
+ ******************************************************************************/
+void Comport_OS_StopDeviceMonitor(void)
+{
+}
+
 /*******************************************************************************
  * NAME:
  *    Comport_OS_GetSerialPortList
@@ -459,6 +459,9 @@ int TCPServer_Write(t_DriverIOHandleType *DriverIO,const uint8_t *Data,int Bytes
             {
                 case EAGAIN:
                 case ENOBUFS:
+                    /* If we sent some then say so (or they get sent again) */
+                    if(BytesSent>0)
+                        return BytesSent;
                     return RETERROR_BUSY;
                 case EBADF:
                 case EBADFD:
@@ -62,10 +62,13 @@ extern "C"
     unsigned int BasicCtrlCharsDecoder_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
     unsigned int RAWFileUpload_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
     unsigned int XModemUpload_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
+    unsigned int YModem_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
+    unsigned int ZModem_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
     unsigned int TCPClient_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
     unsigned int TCPServer_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
     unsigned int UDPClient_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
     unsigned int UDPServer_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
+    unsigned int CaptureReplay_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
 
     unsigned int WTBasic_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
 
@@ -81,6 +84,7 @@ extern "C"
 #endif
 
     unsigned int HexDumpDecoder_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
+    unsigned int RuleHighlighter_RegisterPlugin(const struct PI_SystemAPI *SysAPI,unsigned int Version);
 }
 
 /*** VARIABLE DEFINITIONS     ***/
@@ -112,6 +116,7 @@ void RegisterStdPlugins(void)
     RegisterStdPlugin(TCPServer_RegisterPlugin,"TCPServer");
     RegisterStdPlugin(UDPClient_RegisterPlugin,"UDPClient");
     RegisterStdPlugin(UDPServer_RegisterPlugin,"UDPServer");
+    RegisterStdPlugin(CaptureReplay_RegisterPlugin,"CaptureReplay");
 
     /* Term Emulation */
     RegisterStdPlugin(ANSIX3_64_RegisterPlugin,"ANSIX3_64");
@@ -123,9 +128,14 @@ void RegisterStdPlugins(void)
 
     RegisterStdPlugin(HexDumpDecoder_RegisterPlugin,"BASIC_HEX");
 
+    /* e_TextDataProcessorClass_Highlighter */
+    RegisterStdPlugin(RuleHighlighter_RegisterPlugin,"RuleHighlighter");
+
     /* File Transfer Protocols */
     RegisterStdPlugin(RAWFileUpload_RegisterPlugin,"RAWFileUpload");
     RegisterStdPlugin(XModemUpload_RegisterPlugin,"XModemUpload");
+    RegisterStdPlugin(YModem_RegisterPlugin,"YModem");
+    RegisterStdPlugin(ZModem_RegisterPlugin,"ZModem");
 
     /* Scripting languages */
     RegisterStdPlugin(WTBasic_RegisterPlugin,"WTBasic");
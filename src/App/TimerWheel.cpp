@@ -0,0 +1,661 @@
+/*******************************************************************************
+ * FILENAME: TimerWheel.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the app timer service in it.  It's a hashed timing wheel
+ *    with 1ms slots.  A timer goes in the slot for the ms it expires on
+ *    (mod the number of slots) and the wheel checks the expire time when it
+ *    passes the slot, so timers longer than 1 turn just get passed over
+ *    until their turn comes around.
+ *
+ *    The wheel is driven by a single shot UI timer that is set for the first
+ *    slot that has something in it.  Restarting a timer to later (what the
+ *    file transfer protocols do on every byte) just moves it to a new slot.
+ *    If that leaves the UI timer going off early, the wheel finds nothing
+ *    to do and sets it again, which is a lot cheaper than stopping and
+ *    starting a UI timer for every restart.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/TimerWheel.h"
+#include "OS/OSTime.h"
+#include "UI/UITimers.h"
+#include <stdlib.h>
+
+/*** DEFINES                  ***/
+#define TIMERWHEEL_SLOTS            1024    // 1 per ms (must be a power of 2)
+#define TIMERWHEEL_SLOT_MASK        (TIMERWHEEL_SLOTS-1)
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct TimerWheelLink
+{
+    struct TimerWheelLink *Next;
+    struct TimerWheelLink *Prev;
+};
+
+struct TimerWheelTimer
+{
+    struct TimerWheelLink Link;     // Must be first (the lists are of these)
+    uint64_t Expires;               // The ms (from TimerWheel_Now()) this goes off at
+    uint32_t Timeout;
+    bool Repeats;
+    bool Running;
+    void (*TimeoutCB)(uintptr_t UserData);
+    uintptr_t UserData;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+static uint64_t TimerWheel_Now(void);
+static void TimerWheel_Link(struct TimerWheelLink *List,
+        struct TimerWheelTimer *Timer);
+static void TimerWheel_Unlink(struct TimerWheelTimer *Timer);
+static void TimerWheel_Run(uint64_t Now);
+static void TimerWheel_SetDriver(uint64_t Now,uint64_t Due);
+static void TimerWheel_DriverTimeout(uintptr_t UserData);
+
+/*** VARIABLE DEFINITIONS     ***/
+static struct TimerWheelLink m_TimerWheelSlots[TIMERWHEEL_SLOTS];
+static struct TimerWheelLink m_TimerWheelRunList;   // The slot being run
+static uint64_t m_TimerWheelCurrent;        // The ms the wheel has been run up to
+static unsigned int m_TimerWheelActive;     // How many timers are running
+static struct UITimer *m_TimerWheelDriver;
+static uint64_t m_TimerWheelDriverDue;      // When 'm_TimerWheelDriver' goes off (0=stopped)
+static bool m_TimerWheelInRun;
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_Init
+ *
+ * SYNOPSIS:
+ *    bool TimerWheel_Init(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function sets up the timer wheel and allocates the UI timer that
+ *    drives it.  It has to be called before any timers are started.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.
+ *
+ * SEE ALSO:
+ *    TimerWheel_Shutdown()
+ ******************************************************************************/
+bool TimerWheel_Init(void)
+{
+    unsigned int s;
+
+    for(s=0;s<TIMERWHEEL_SLOTS;s++)
+    {
+        m_TimerWheelSlots[s].Next=&m_TimerWheelSlots[s];
+        m_TimerWheelSlots[s].Prev=&m_TimerWheelSlots[s];
+    }
+    m_TimerWheelRunList.Next=&m_TimerWheelRunList;
+    m_TimerWheelRunList.Prev=&m_TimerWheelRunList;
+
+    m_TimerWheelCurrent=TimerWheel_Now();
+    m_TimerWheelActive=0;
+    m_TimerWheelDriverDue=0;
+    m_TimerWheelInRun=false;
+
+    m_TimerWheelDriver=AllocUITimer();
+    if(m_TimerWheelDriver==NULL)
+        return false;
+
+    SetupUITimer(m_TimerWheelDriver,TimerWheel_DriverTimeout,0,false);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_Shutdown
+ *
+ * SYNOPSIS:
+ *    void TimerWheel_Shutdown(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function stops the wheel.  Any timers that are still running are
+ *    stopped (they still need to be freed by who ever allocated them).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_Init()
+ ******************************************************************************/
+void TimerWheel_Shutdown(void)
+{
+    unsigned int s;
+
+    if(m_TimerWheelDriver!=NULL)
+    {
+        UITimerStop(m_TimerWheelDriver);
+        FreeUITimer(m_TimerWheelDriver);
+        m_TimerWheelDriver=NULL;
+    }
+    m_TimerWheelDriverDue=0;
+
+    for(s=0;s<TIMERWHEEL_SLOTS;s++)
+    {
+        while(m_TimerWheelSlots[s].Next!=&m_TimerWheelSlots[s])
+        {
+            TimerWheel_Stop((struct TimerWheelTimer *)
+                    m_TimerWheelSlots[s].Next);
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_AllocTimer
+ *
+ * SYNOPSIS:
+ *    struct TimerWheelTimer *TimerWheel_AllocTimer(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function allocates a new timer.  It starts stopped and with no
+ *    call back (use TimerWheel_SetupTimer() to set it up).
+ *
+ * RETURNS:
+ *    The new timer or NULL if we are out of memory.
+ *
+ * SEE ALSO:
+ *    TimerWheel_FreeTimer(), TimerWheel_SetupTimer()
+ ******************************************************************************/
+struct TimerWheelTimer *TimerWheel_AllocTimer(void)
+{
+    struct TimerWheelTimer *NewTimer;
+
+    NewTimer=NULL;
+    try
+    {
+        NewTimer=new struct TimerWheelTimer;
+        NewTimer->Link.Next=NULL;
+        NewTimer->Link.Prev=NULL;
+        NewTimer->Expires=0;
+        NewTimer->Timeout=0;
+        NewTimer->Repeats=false;
+        NewTimer->Running=false;
+        NewTimer->TimeoutCB=NULL;
+        NewTimer->UserData=0;
+    }
+    catch(...)
+    {
+        if(NewTimer!=NULL)
+            delete NewTimer;
+        return NULL;
+    }
+    return NewTimer;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_FreeTimer
+ *
+ * SYNOPSIS:
+ *    void TimerWheel_FreeTimer(struct TimerWheelTimer *Timer);
+ *
+ * PARAMETERS:
+ *    Timer [I] -- The timer to free
+ *
+ * FUNCTION:
+ *    This function stops and frees a timer.  It is safe to free a timer
+ *    from it's own call back.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_AllocTimer()
+ ******************************************************************************/
+void TimerWheel_FreeTimer(struct TimerWheelTimer *Timer)
+{
+    TimerWheel_Stop(Timer);
+    delete Timer;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_SetupTimer
+ *
+ * SYNOPSIS:
+ *    void TimerWheel_SetupTimer(struct TimerWheelTimer *Timer,
+ *              void (*Timeout)(uintptr_t UserData),uintptr_t UserData,
+ *              bool Repeats);
+ *
+ * PARAMETERS:
+ *    Timer [I] -- The timer to setup
+ *    Timeout [I] -- The function to call when the timer goes off
+ *    UserData [I] -- What to pass to 'Timeout'
+ *    Repeats [I] -- true = keep going off every timeout until stopped,
+ *                   false = stop after it goes off once.
+ *
+ * FUNCTION:
+ *    This function sets up what a timer does when it goes off.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_SetTimeout(), TimerWheel_Start()
+ ******************************************************************************/
+void TimerWheel_SetupTimer(struct TimerWheelTimer *Timer,
+        void (*Timeout)(uintptr_t UserData),uintptr_t UserData,bool Repeats)
+{
+    Timer->TimeoutCB=Timeout;
+    Timer->UserData=UserData;
+    Timer->Repeats=Repeats;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_SetTimeout
+ *
+ * SYNOPSIS:
+ *    void TimerWheel_SetTimeout(struct TimerWheelTimer *Timer,uint32_t ms);
+ *
+ * PARAMETERS:
+ *    Timer [I] -- The timer to change
+ *    ms [I] -- How long the timer runs for (in ms)
+ *
+ * FUNCTION:
+ *    This function sets how long a timer runs for.  Like the UI timers this
+ *    takes effect the next time the timer is started.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_Start()
+ ******************************************************************************/
+void TimerWheel_SetTimeout(struct TimerWheelTimer *Timer,uint32_t ms)
+{
+    Timer->Timeout=ms;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_Start
+ *
+ * SYNOPSIS:
+ *    void TimerWheel_Start(struct TimerWheelTimer *Timer);
+ *
+ * PARAMETERS:
+ *    Timer [I] -- The timer to start
+ *
+ * FUNCTION:
+ *    This function starts a timer.  If the timer is already running it is
+ *    restarted (the full timeout starts again from now).
+ *
+ *    This is O(1).  The UI timer is only touched if this timer now goes off
+ *    before the UI timer would.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_Stop()
+ ******************************************************************************/
+void TimerWheel_Start(struct TimerWheelTimer *Timer)
+{
+    uint64_t Now;
+
+    Now=TimerWheel_Now();
+
+    /* If the wheel has been idle catch it up so the next run doesn't have
+       to look at all the empty slots */
+    if(m_TimerWheelActive==0 && !m_TimerWheelInRun)
+        m_TimerWheelCurrent=Now;
+
+    if(Timer->Running)
+        TimerWheel_Unlink(Timer);
+    else
+        m_TimerWheelActive++;
+
+    Timer->Expires=Now+(Timer->Timeout>0?Timer->Timeout:1);
+    Timer->Running=true;
+    TimerWheel_Link(&m_TimerWheelSlots[Timer->Expires&TIMERWHEEL_SLOT_MASK],
+            Timer);
+
+    /* The driver gets set when the wheel is done running */
+    if(m_TimerWheelInRun)
+        return;
+
+    if(m_TimerWheelDriverDue==0 || Timer->Expires<m_TimerWheelDriverDue)
+        TimerWheel_SetDriver(Now,Timer->Expires);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_Stop
+ *
+ * SYNOPSIS:
+ *    void TimerWheel_Stop(struct TimerWheelTimer *Timer);
+ *
+ * PARAMETERS:
+ *    Timer [I] -- The timer to stop
+ *
+ * FUNCTION:
+ *    This function stops a timer.  It's O(1).  The UI timer is left alone
+ *    (if it goes off and there's nothing to do it just isn't set again).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_Start()
+ ******************************************************************************/
+void TimerWheel_Stop(struct TimerWheelTimer *Timer)
+{
+    if(!Timer->Running)
+        return;
+
+    TimerWheel_Unlink(Timer);
+    Timer->Running=false;
+    m_TimerWheelActive--;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_Running
+ *
+ * SYNOPSIS:
+ *    bool TimerWheel_Running(struct TimerWheelTimer *Timer);
+ *
+ * PARAMETERS:
+ *    Timer [I] -- The timer to check
+ *
+ * FUNCTION:
+ *    This function checks if a timer is running.
+ *
+ * RETURNS:
+ *    true -- The timer is running
+ *    false -- The timer is stopped
+ *
+ * SEE ALSO:
+ *    TimerWheel_Start(), TimerWheel_Stop()
+ ******************************************************************************/
+bool TimerWheel_Running(struct TimerWheelTimer *Timer)
+{
+    return Timer->Running;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_Now
+ *
+ * SYNOPSIS:
+ *    static uint64_t TimerWheel_Now(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the wheel's time.  It's the monotonic clock in ms
+ *    (so changing the system clock doesn't fire or hold up timers).
+ *
+ * RETURNS:
+ *    The current time in ms.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static uint64_t TimerWheel_Now(void)
+{
+    return GetElapsedTime_ns()/1000000;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_Link
+ *
+ * SYNOPSIS:
+ *    static void TimerWheel_Link(struct TimerWheelLink *List,
+ *              struct TimerWheelTimer *Timer);
+ *
+ * PARAMETERS:
+ *    List [I] -- The list (slot) to add the timer to the end of
+ *    Timer [I] -- The timer to add
+ *
+ * FUNCTION:
+ *    This function adds a timer to a list.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_Unlink()
+ ******************************************************************************/
+static void TimerWheel_Link(struct TimerWheelLink *List,
+        struct TimerWheelTimer *Timer)
+{
+    Timer->Link.Next=List;
+    Timer->Link.Prev=List->Prev;
+    List->Prev->Next=&Timer->Link;
+    List->Prev=&Timer->Link;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_Unlink
+ *
+ * SYNOPSIS:
+ *    static void TimerWheel_Unlink(struct TimerWheelTimer *Timer);
+ *
+ * PARAMETERS:
+ *    Timer [I] -- The timer to remove
+ *
+ * FUNCTION:
+ *    This function removes a timer from what ever list it's in (a slot or
+ *    the run list).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_Link()
+ ******************************************************************************/
+static void TimerWheel_Unlink(struct TimerWheelTimer *Timer)
+{
+    Timer->Link.Prev->Next=Timer->Link.Next;
+    Timer->Link.Next->Prev=Timer->Link.Prev;
+    Timer->Link.Next=NULL;
+    Timer->Link.Prev=NULL;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_Run
+ *
+ * SYNOPSIS:
+ *    static void TimerWheel_Run(uint64_t Now);
+ *
+ * PARAMETERS:
+ *    Now [I] -- The time to run the wheel up to
+ *
+ * FUNCTION:
+ *    This function turns the wheel from where it was last run up to 'Now',
+ *    calling the call backs for timers that have expired.
+ *
+ *    Each slot is moved to a run list before it's run so the call backs can
+ *    start, stop, or free any timer (including the one that went off).
+ *    Timers in the slot that are for a later turn go back in the slot.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_DriverTimeout()
+ ******************************************************************************/
+static void TimerWheel_Run(uint64_t Now)
+{
+    struct TimerWheelLink *Slot;
+    struct TimerWheelTimer *Timer;
+    uint64_t Ticks;
+    uint64_t t;
+
+    if(Now<=m_TimerWheelCurrent)
+        return;
+
+    /* If we are more than a turn behind we only have to look at each slot
+       once */
+    Ticks=Now-m_TimerWheelCurrent;
+    if(Ticks>TIMERWHEEL_SLOTS)
+        Ticks=TIMERWHEEL_SLOTS;
+
+    m_TimerWheelInRun=true;
+    for(t=1;t<=Ticks && m_TimerWheelActive>0;t++)
+    {
+        Slot=&m_TimerWheelSlots[(m_TimerWheelCurrent+t)&TIMERWHEEL_SLOT_MASK];
+        if(Slot->Next==Slot)
+            continue;
+
+        /* Move the slot to the run list */
+        m_TimerWheelRunList.Next=Slot->Next;
+        m_TimerWheelRunList.Prev=Slot->Prev;
+        m_TimerWheelRunList.Next->Prev=&m_TimerWheelRunList;
+        m_TimerWheelRunList.Prev->Next=&m_TimerWheelRunList;
+        Slot->Next=Slot;
+        Slot->Prev=Slot;
+
+        while(m_TimerWheelRunList.Next!=&m_TimerWheelRunList)
+        {
+            Timer=(struct TimerWheelTimer *)m_TimerWheelRunList.Next;
+            TimerWheel_Unlink(Timer);
+
+            if(Timer->Expires>Now)
+            {
+                /* A later turn */
+                TimerWheel_Link(Slot,Timer);
+                continue;
+            }
+
+            if(Timer->Repeats)
+            {
+                Timer->Expires=Now+(Timer->Timeout>0?Timer->Timeout:1);
+                TimerWheel_Link(&m_TimerWheelSlots[Timer->Expires&
+                        TIMERWHEEL_SLOT_MASK],Timer);
+            }
+            else
+            {
+                Timer->Running=false;
+                m_TimerWheelActive--;
+            }
+
+            /* Don't touch 'Timer' after this (it may have been freed) */
+            if(Timer->TimeoutCB!=NULL)
+                Timer->TimeoutCB(Timer->UserData);
+        }
+    }
+    m_TimerWheelCurrent=Now;
+    m_TimerWheelInRun=false;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_SetDriver
+ *
+ * SYNOPSIS:
+ *    static void TimerWheel_SetDriver(uint64_t Now,uint64_t Due);
+ *
+ * PARAMETERS:
+ *    Now [I] -- The current time
+ *    Due [I] -- When the UI timer needs to go off
+ *
+ * FUNCTION:
+ *    This function sets the UI timer that runs the wheel.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_DriverTimeout()
+ ******************************************************************************/
+static void TimerWheel_SetDriver(uint64_t Now,uint64_t Due)
+{
+    if(m_TimerWheelDriver==NULL)
+        return;
+
+    UITimerSetTimeout(m_TimerWheelDriver,Due>Now?Due-Now:1);
+    UITimerStart(m_TimerWheelDriver);
+    m_TimerWheelDriverDue=Due;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TimerWheel_DriverTimeout
+ *
+ * SYNOPSIS:
+ *    static void TimerWheel_DriverTimeout(uintptr_t UserData);
+ *
+ * PARAMETERS:
+ *    UserData [I] -- Not used
+ *
+ * FUNCTION:
+ *    This function is called from the UI timer.  It runs the wheel and then
+ *    sets the UI timer for the next slot that has a timer in it.  That timer
+ *    may be for a later turn, in which case we just go off early and find
+ *    nothing to do (we never sleep for more than a turn).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TimerWheel_Run()
+ ******************************************************************************/
+static void TimerWheel_DriverTimeout(uintptr_t UserData)
+{
+    struct TimerWheelLink *Slot;
+    uint64_t Now;
+    uint64_t t;
+
+    m_TimerWheelDriverDue=0;
+
+    Now=TimerWheel_Now();
+    TimerWheel_Run(Now);
+
+    if(m_TimerWheelActive==0)
+        return;
+
+    for(t=1;t<TIMERWHEEL_SLOTS;t++)
+    {
+        Slot=&m_TimerWheelSlots[(m_TimerWheelCurrent+t)&TIMERWHEEL_SLOT_MASK];
+        if(Slot->Next!=Slot)
+            break;
+    }
+    TimerWheel_SetDriver(Now,m_TimerWheelCurrent+t);
+}
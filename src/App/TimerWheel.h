@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * FILENAME: TimerWheel.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This has the app timer service in it.  All the timers are kept in a
+ *    single hashed timing wheel that is driven by one UI timer, so starting,
+ *    restarting, and stopping a timer is O(1) and never touches the UI
+ *    timer.
+ *
+ *    The functions work like the UITimer ones (UI/UITimers.h) so any timer
+ *    that isn't being used to get back to the event loop can be moved over.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __TIMERWHEEL_H_
+#define __TIMERWHEEL_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include <stdint.h>
+
+/***  DEFINES                          ***/
+
+/***  MACROS                           ***/
+
+/***  TYPE DEFINITIONS                 ***/
+struct TimerWheelTimer;         // Not a real type
+
+/***  CLASS DEFINITIONS                ***/
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+bool TimerWheel_Init(void);
+void TimerWheel_Shutdown(void);
+struct TimerWheelTimer *TimerWheel_AllocTimer(void);
+void TimerWheel_FreeTimer(struct TimerWheelTimer *Timer);
+void TimerWheel_SetupTimer(struct TimerWheelTimer *Timer,
+        void (*Timeout)(uintptr_t UserData),uintptr_t UserData,bool Repeats);
+void TimerWheel_SetTimeout(struct TimerWheelTimer *Timer,uint32_t ms);
+void TimerWheel_Start(struct TimerWheelTimer *Timer);
+void TimerWheel_Stop(struct TimerWheelTimer *Timer);
+bool TimerWheel_Running(struct TimerWheelTimer *Timer);
+
+#endif
@@ -0,0 +1,705 @@
+/*******************************************************************************
+ * FILENAME: ByteSearch.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the byte pattern search used by the hex displays in it.
+ *
+ *    A pattern is a list of bytes with a mask for each byte, so a hex
+ *    pattern can have wild card bytes (??) or even wild card nibbles (A?).
+ *    Text patterns are just the bytes of the text (AscII) or the text
+ *    converted to UTF-16.
+ *
+ *    Patterns with a good sized run of fixed bytes at the end are searched
+ *    with Boyer-Moore-Horspool (wild cards just limit how far it can skip).
+ *    Short patterns (or ones where the wild cards make the skips tiny) use
+ *    memchr() to find the first fixed byte and then check the rest, which is
+ *    faster than anything we could do a byte at a time.
+ *
+ *    The hex displays keep their bytes in circular buffers so there is also
+ *    a version that searches a ring, including the matches that wrap from
+ *    the end of the memory back to the start.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/Util/ByteSearch.h"
+#include "ThirdParty/utf8.h"
+#include <iterator>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/*** DEFINES                  ***/
+#define BYTESEARCH_BMH_MIN_SHIFT            8       // Use BMH if it can skip at least this many bytes
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+static bool ByteSearch_ParseHex(const char *Str,
+        struct ByteSearchPattern *RetPattern);
+static bool ByteSearch_ParseUTF16(const char *Str,bool BigEndian,
+        struct ByteSearchPattern *RetPattern);
+static void ByteSearch_Compile(struct ByteSearchPattern *Pattern);
+static int ByteSearch_ByteCommonness(uint8_t Byte);
+static int ByteSearch_HexNib(char c);
+static inline bool ByteSearch_MatchAt(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Pos);
+
+/*** VARIABLE DEFINITIONS     ***/
+
+/*******************************************************************************
+ * NAME:
+ *    ByteSearch_ParsePattern
+ *
+ * SYNOPSIS:
+ *    bool ByteSearch_ParsePattern(const char *Str,
+ *              e_ByteSearchPatternType Type,
+ *              struct ByteSearchPattern *RetPattern);
+ *
+ * PARAMETERS:
+ *    Str [I] -- The pattern the user typed in
+ *    Type [I] -- How to read 'Str':
+ *                  e_ByteSearchPattern_Hex -- Hex bytes.  Bytes can be
+ *                      split with spaces or commas and can start with 0x.
+ *                      '?' is a wild card nibble so ?? matches any byte.
+ *                  e_ByteSearchPattern_AscII -- The bytes of 'Str'
+ *                  e_ByteSearchPattern_UTF16LE -- 'Str' (UTF-8) converted
+ *                      to UTF-16 little endian
+ *                  e_ByteSearchPattern_UTF16BE -- 'Str' (UTF-8) converted
+ *                      to UTF-16 big endian
+ *    RetPattern [O] -- The pattern ready to pass to ByteSearch_Find()
+ *
+ * FUNCTION:
+ *    This function converts a string into a search pattern and builds the
+ *    skip table for it.
+ *
+ * RETURNS:
+ *    true -- 'RetPattern' is ready to use
+ *    false -- 'Str' was not valid, empty, or more than
+ *             BYTESEARCH_MAX_PATTERN bytes
+ *
+ * SEE ALSO:
+ *    ByteSearch_ParseUserPattern(), ByteSearch_Find()
+ ******************************************************************************/
+bool ByteSearch_ParsePattern(const char *Str,e_ByteSearchPatternType Type,
+        struct ByteSearchPattern *RetPattern)
+{
+    size_t Len;
+
+    RetPattern->Type=Type;
+    RetPattern->Len=0;
+
+    switch(Type)
+    {
+        case e_ByteSearchPattern_Hex:
+            if(!ByteSearch_ParseHex(Str,RetPattern))
+                return false;
+        break;
+        case e_ByteSearchPattern_AscII:
+            Len=strlen(Str);
+            if(Len>BYTESEARCH_MAX_PATTERN)
+                return false;
+            memcpy(RetPattern->Bytes,Str,Len);
+            memset(RetPattern->Mask,0xFF,Len);
+            RetPattern->Len=Len;
+        break;
+        case e_ByteSearchPattern_UTF16LE:
+        case e_ByteSearchPattern_UTF16BE:
+            if(!ByteSearch_ParseUTF16(Str,Type==e_ByteSearchPattern_UTF16BE,
+                    RetPattern))
+            {
+                return false;
+            }
+        break;
+        case e_ByteSearchPatternMAX:
+        default:
+            return false;
+    }
+
+    if(RetPattern->Len==0)
+        return false;
+
+    ByteSearch_Compile(RetPattern);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteSearch_ParseUserPattern
+ *
+ * SYNOPSIS:
+ *    bool ByteSearch_ParseUserPattern(const char *Str,
+ *              struct ByteSearchPattern *RetPattern);
+ *
+ * PARAMETERS:
+ *    Str [I] -- The pattern the user typed in
+ *    RetPattern [O] -- The pattern ready to pass to ByteSearch_Find()
+ *
+ * FUNCTION:
+ *    This function is ByteSearch_ParsePattern() for when there is only a
+ *    text input to type the pattern into.  The type comes from how the
+ *    string starts:
+ *          "text"      -- AscII
+ *          u"text"     -- UTF-16 little endian
+ *          ube"text"   -- UTF-16 big endian
+ *          Anything else is hex bytes (AA ?? 55)
+ *
+ *    The closing quote is optional.
+ *
+ * RETURNS:
+ *    true -- 'RetPattern' is ready to use
+ *    false -- 'Str' was not a valid pattern
+ *
+ * SEE ALSO:
+ *    ByteSearch_ParsePattern()
+ ******************************************************************************/
+bool ByteSearch_ParseUserPattern(const char *Str,
+        struct ByteSearchPattern *RetPattern)
+{
+    e_ByteSearchPatternType Type;
+    string Text;
+
+    while(*Str==' ' || *Str=='\t')
+        Str++;
+
+    if(*Str=='"')
+    {
+        Type=e_ByteSearchPattern_AscII;
+        Str+=1;
+    }
+    else if(Str[0]=='u' && Str[1]=='"')
+    {
+        Type=e_ByteSearchPattern_UTF16LE;
+        Str+=2;
+    }
+    else if(strncmp(Str,"ube\"",4)==0)
+    {
+        Type=e_ByteSearchPattern_UTF16BE;
+        Str+=4;
+    }
+    else
+    {
+        return ByteSearch_ParsePattern(Str,e_ByteSearchPattern_Hex,RetPattern);
+    }
+
+    Text=Str;
+    if(!Text.empty() && Text[Text.length()-1]=='"')
+        Text.erase(Text.length()-1);
+
+    return ByteSearch_ParsePattern(Text.c_str(),Type,RetPattern);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteSearch_Find
+ *
+ * SYNOPSIS:
+ *    const uint8_t *ByteSearch_Find(const struct ByteSearchPattern *Pattern,
+ *              const uint8_t *Data,size_t Bytes);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The pattern to look for (from ByteSearch_ParsePattern())
+ *    Data [I] -- The bytes to search
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function finds the first place in 'Data' that matches 'Pattern'.
+ *
+ * RETURNS:
+ *    A pointer to the first byte of the match or NULL if there wasn't one.
+ *
+ * SEE ALSO:
+ *    ByteSearch_FindInRing()
+ ******************************************************************************/
+const uint8_t *ByteSearch_Find(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Data,size_t Bytes)
+{
+    const uint8_t *Pos;
+    const uint8_t *LastStart;
+    const uint8_t *LastAnchor;
+    const uint8_t *Hit;
+    int Last;
+
+    if(Pattern->Len<=0 || Bytes<(size_t)Pattern->Len)
+        return NULL;
+
+    Last=Pattern->Len-1;
+    LastStart=Data+(Bytes-Pattern->Len);
+
+    if(Pattern->UseBMH)
+    {
+        Pos=Data;
+        while(Pos<=LastStart)
+        {
+            if(ByteSearch_MatchAt(Pattern,Pos))
+                return Pos;
+            Pos+=Pattern->Skip[Pos[Last]];
+        }
+        return NULL;
+    }
+
+    if(Pattern->AnchorPos<0)
+    {
+        /* All wild cards, anything matches */
+        return Data;
+    }
+
+    /* Let memchr() find the anchor byte and check around it */
+    Pos=Data+Pattern->AnchorPos;
+    LastAnchor=LastStart+Pattern->AnchorPos;
+    while(Pos<=LastAnchor)
+    {
+        Hit=(const uint8_t *)memchr(Pos,Pattern->Bytes[Pattern->AnchorPos],
+                LastAnchor-Pos+1);
+        if(Hit==NULL)
+            return NULL;
+        if(ByteSearch_MatchAt(Pattern,Hit-Pattern->AnchorPos))
+            return Hit-Pattern->AnchorPos;
+        Pos=Hit+1;
+    }
+    return NULL;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteSearch_FindInRing
+ *
+ * SYNOPSIS:
+ *    int64_t ByteSearch_FindInRing(const struct ByteSearchPattern *Pattern,
+ *              const uint8_t *Ring,size_t RingSize,size_t DataStart,
+ *              size_t DataBytes,size_t From,size_t To);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The pattern to look for
+ *    Ring [I] -- The start of the memory for the circular buffer
+ *    RingSize [I] -- The number of bytes of memory in 'Ring'
+ *    DataStart [I] -- The offset into 'Ring' of the oldest byte
+ *    DataBytes [I] -- The number of valid bytes (starting at 'DataStart' and
+ *                     wrapping at 'RingSize')
+ *    From [I] -- The first offset (from 'DataStart') a match can start at
+ *    To [I] -- The offset (from 'DataStart') a match has to start before
+ *
+ * FUNCTION:
+ *    This function finds the first match that starts between 'From' and
+ *    'To' in a circular buffer.  The data is searched in place as 2 flat
+ *    blocks (before and after the wrap) and the few bytes around the wrap
+ *    are copied out and searched so matches that cross the end of the
+ *    memory are found too.
+ *
+ * RETURNS:
+ *    The offset (from 'DataStart') of the match or -1 if there wasn't one.
+ *
+ * SEE ALSO:
+ *    ByteSearch_Find(), ByteSearch_FindNextInRing()
+ ******************************************************************************/
+int64_t ByteSearch_FindInRing(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Ring,size_t RingSize,size_t DataStart,size_t DataBytes,
+        size_t From,size_t To)
+{
+    uint8_t Seam[(BYTESEARCH_MAX_PATTERN-1)*2];
+    const uint8_t *Hit;
+    size_t Len;
+    size_t RangeEnd;
+    size_t RangeLen;
+    size_t PhysStart;
+    size_t Seg1Len;
+    size_t Seg2Len;
+    size_t TailLen;
+    size_t HeadLen;
+
+    if(Pattern->Len<=0 || RingSize==0)
+        return -1;
+
+    Len=Pattern->Len;
+    if(DataBytes>RingSize)
+        DataBytes=RingSize;
+    if(To>DataBytes)
+        To=DataBytes;
+    if(From>=To)
+        return -1;
+
+    /* The bytes a match starting before 'To' could use */
+    RangeEnd=To+Len-1;
+    if(RangeEnd>DataBytes)
+        RangeEnd=DataBytes;
+    RangeLen=RangeEnd-From;
+    if(RangeLen<Len)
+        return -1;
+
+    PhysStart=(DataStart+From)%RingSize;
+    Seg1Len=RingSize-PhysStart;
+    if(Seg1Len>RangeLen)
+        Seg1Len=RangeLen;
+
+    Hit=ByteSearch_Find(Pattern,&Ring[PhysStart],Seg1Len);
+    if(Hit!=NULL)
+        return From+(Hit-&Ring[PhysStart]);
+
+    if(Seg1Len==RangeLen)
+        return -1;
+    Seg2Len=RangeLen-Seg1Len;
+
+    /* Matches that start before the wrap and end after it */
+    TailLen=Len-1;
+    if(TailLen>Seg1Len)
+        TailLen=Seg1Len;
+    HeadLen=Len-1;
+    if(HeadLen>Seg2Len)
+        HeadLen=Seg2Len;
+    memcpy(Seam,&Ring[PhysStart+Seg1Len-TailLen],TailLen);
+    memcpy(&Seam[TailLen],Ring,HeadLen);
+    Hit=ByteSearch_Find(Pattern,Seam,TailLen+HeadLen);
+    if(Hit!=NULL && (size_t)(Hit-Seam)<TailLen)
+        return From+Seg1Len-TailLen+(Hit-Seam);
+
+    Hit=ByteSearch_Find(Pattern,Ring,Seg2Len);
+    if(Hit!=NULL)
+        return From+Seg1Len+(Hit-Ring);
+
+    return -1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteSearch_FindNextInRing
+ *
+ * SYNOPSIS:
+ *    int64_t ByteSearch_FindNextInRing(
+ *              const struct ByteSearchPattern *Pattern,const uint8_t *Ring,
+ *              size_t RingSize,size_t DataStart,size_t DataBytes,size_t From);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The pattern to look for
+ *    Ring [I] -- The start of the memory for the circular buffer
+ *    RingSize [I] -- The number of bytes of memory in 'Ring'
+ *    DataStart [I] -- The offset into 'Ring' of the oldest byte
+ *    DataBytes [I] -- The number of valid bytes
+ *    From [I] -- The offset (from 'DataStart') to start looking at
+ *
+ * FUNCTION:
+ *    This function does a find next.  It looks from 'From' to the end of
+ *    the data and if it doesn't find anything it goes back to the start and
+ *    looks up to 'From'.
+ *
+ * RETURNS:
+ *    The offset (from 'DataStart') of the match or -1 if there wasn't one.
+ *
+ * SEE ALSO:
+ *    ByteSearch_FindInRing()
+ ******************************************************************************/
+int64_t ByteSearch_FindNextInRing(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Ring,size_t RingSize,size_t DataStart,size_t DataBytes,
+        size_t From)
+{
+    int64_t Match;
+
+    if(From>=DataBytes)
+        From=0;
+
+    Match=ByteSearch_FindInRing(Pattern,Ring,RingSize,DataStart,DataBytes,
+            From,DataBytes);
+    if(Match<0 && From>0)
+    {
+        Match=ByteSearch_FindInRing(Pattern,Ring,RingSize,DataStart,
+                DataBytes,0,From);
+    }
+    return Match;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteSearch_ParseHex
+ *
+ * SYNOPSIS:
+ *    static bool ByteSearch_ParseHex(const char *Str,
+ *              struct ByteSearchPattern *RetPattern);
+ *
+ * PARAMETERS:
+ *    Str [I] -- The hex string to convert
+ *    RetPattern [O] -- The pattern to fill in the bytes and mask of
+ *
+ * FUNCTION:
+ *    This function converts a string of hex bytes into a pattern.  Bytes
+ *    are 2 digits (or ?'s) and can be run together (AA55) or split with
+ *    spaces or commas.  A single digit on it's own is a byte (A = 0A).
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was something that wasn't hex in 'Str' or there where
+ *             too many bytes.
+ *
+ * SEE ALSO:
+ *    ByteSearch_ParsePattern()
+ ******************************************************************************/
+static bool ByteSearch_ParseHex(const char *Str,
+        struct ByteSearchPattern *RetPattern)
+{
+    const char *Pos;
+    int Nibs;
+    int Nib;
+    uint8_t Value;
+    uint8_t Mask;
+
+    Pos=Str;
+    while(*Pos!=0)
+    {
+        if(*Pos==' ' || *Pos==',' || *Pos=='\t' || *Pos=='\n' || *Pos=='\r')
+        {
+            Pos++;
+            continue;
+        }
+
+        if(Pos[0]=='0' && (Pos[1]=='x' || Pos[1]=='X'))
+            Pos+=2;
+
+        Value=0;
+        Mask=0;
+        for(Nibs=0;Nibs<2;Nibs++)
+        {
+            if(*Pos=='?')
+            {
+                Nib=0;
+                Value<<=4;
+                Mask<<=4;
+            }
+            else
+            {
+                Nib=ByteSearch_HexNib(*Pos);
+                if(Nib<0)
+                    break;
+                Value=(Value<<4)|Nib;
+                Mask=(Mask<<4)|0x0F;
+            }
+            Pos++;
+        }
+
+        if(Nibs==0)
+            return false;
+        if(Nibs==1)
+        {
+            /* A lone digit is a whole byte (and a lone ? any byte) */
+            if(*(Pos-1)=='?')
+                Mask=0x00;
+            else
+                Mask=0xFF;
+        }
+
+        if(RetPattern->Len>=BYTESEARCH_MAX_PATTERN)
+            return false;
+        RetPattern->Bytes[RetPattern->Len]=Value;
+        RetPattern->Mask[RetPattern->Len]=Mask;
+        RetPattern->Len++;
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteSearch_ParseUTF16
+ *
+ * SYNOPSIS:
+ *    static bool ByteSearch_ParseUTF16(const char *Str,bool BigEndian,
+ *              struct ByteSearchPattern *RetPattern);
+ *
+ * PARAMETERS:
+ *    Str [I] -- The UTF-8 string to convert
+ *    BigEndian [I] -- Make the pattern big endian (true) or little (false)
+ *    RetPattern [O] -- The pattern to fill in the bytes and mask of
+ *
+ * FUNCTION:
+ *    This function converts a UTF-8 string into the UTF-16 bytes to look
+ *    for.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- 'Str' was not valid UTF-8 or was too long
+ *
+ * SEE ALSO:
+ *    ByteSearch_ParsePattern()
+ ******************************************************************************/
+static bool ByteSearch_ParseUTF16(const char *Str,bool BigEndian,
+        struct ByteSearchPattern *RetPattern)
+{
+    vector<uint16_t> Words;
+    unsigned int r;
+    uint8_t *Out;
+
+    try
+    {
+        utf8::utf8to16(Str,Str+strlen(Str),back_inserter(Words));
+    }
+    catch(...)
+    {
+        return false;
+    }
+
+    if(Words.size()*2>BYTESEARCH_MAX_PATTERN)
+        return false;
+
+    Out=RetPattern->Bytes;
+    for(r=0;r<Words.size();r++)
+    {
+        if(BigEndian)
+        {
+            *Out++=Words[r]>>8;
+            *Out++=Words[r]&0xFF;
+        }
+        else
+        {
+            *Out++=Words[r]&0xFF;
+            *Out++=Words[r]>>8;
+        }
+    }
+    RetPattern->Len=Words.size()*2;
+    memset(RetPattern->Mask,0xFF,RetPattern->Len);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteSearch_Compile
+ *
+ * SYNOPSIS:
+ *    static void ByteSearch_Compile(struct ByteSearchPattern *Pattern);
+ *
+ * PARAMETERS:
+ *    Pattern [I/O] -- The pattern to build the search tables for.  'Bytes',
+ *                     'Mask' and 'Len' must be filled in.
+ *
+ * FUNCTION:
+ *    This function builds the Boyer-Moore-Horspool skip table and picks
+ *    how the pattern will be searched for.
+ *
+ *    A wild card (or half wild) byte can match anything so we can never
+ *    skip past it.  That means the most we can skip is the distance from
+ *    the last wild card to the end of the pattern.  BMH only wins when it
+ *    can skip a good way, otherwise memchr() (which looks at 16 or 32 bytes
+ *    at a time) on the least common looking fixed byte is a lot faster.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ByteSearch_Find()
+ ******************************************************************************/
+static void ByteSearch_Compile(struct ByteSearchPattern *Pattern)
+{
+    int Last;
+    int Default;
+    int r;
+
+    Last=Pattern->Len-1;
+
+    Default=Pattern->Len;
+    for(r=0;r<Last;r++)
+        if(Pattern->Mask[r]!=0xFF)
+            Default=Last-r;
+
+    for(r=0;r<256;r++)
+        Pattern->Skip[r]=Default;
+    for(r=0;r<Last;r++)
+    {
+        if(Pattern->Mask[r]==0xFF && Last-r<Pattern->Skip[Pattern->Bytes[r]])
+            Pattern->Skip[Pattern->Bytes[r]]=Last-r;
+    }
+
+    Pattern->AnchorPos=-1;
+    for(r=0;r<Pattern->Len;r++)
+    {
+        if(Pattern->Mask[r]!=0xFF)
+            continue;
+        if(Pattern->AnchorPos<0 ||
+                ByteSearch_ByteCommonness(Pattern->Bytes[r])<
+                ByteSearch_ByteCommonness(Pattern->Bytes[Pattern->AnchorPos]))
+        {
+            Pattern->AnchorPos=r;
+        }
+    }
+
+    Pattern->UseBMH=(Default>=BYTESEARCH_BMH_MIN_SHIFT);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteSearch_ByteCommonness
+ *
+ * SYNOPSIS:
+ *    static int ByteSearch_ByteCommonness(uint8_t Byte);
+ *
+ * PARAMETERS:
+ *    Byte [I] -- The byte to rate
+ *
+ * FUNCTION:
+ *    This function makes a guess at how often a byte turns up in the sort of
+ *    data a terminal sees.  It is used to pick the byte memchr() looks for,
+ *    every false hit costs a call so we want the rarest one.
+ *
+ * RETURNS:
+ *    0 (rare) to 3 (everywhere)
+ *
+ * SEE ALSO:
+ *    ByteSearch_Compile()
+ ******************************************************************************/
+static int ByteSearch_ByteCommonness(uint8_t Byte)
+{
+    if(Byte==0x00 || Byte==0xFF || Byte==' ' || Byte=='\n' || Byte=='\r' ||
+            (Byte>='a' && Byte<='z'))
+    {
+        return 3;
+    }
+    if(Byte>=0x20 && Byte<0x7F)
+        return 2;
+    if(Byte<0x20)
+        return 1;
+    return 0;
+}
+
+static int ByteSearch_HexNib(char c)
+{
+    if(c>='0' && c<='9')
+        return c-'0';
+    if(c>='a' && c<='f')
+        return c-'a'+10;
+    if(c>='A' && c<='F')
+        return c-'A'+10;
+    return -1;
+}
+
+static inline bool ByteSearch_MatchAt(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Pos)
+{
+    int r;
+
+    for(r=Pattern->Len-1;r>=0;r--)
+        if(((Pos[r]^Pattern->Bytes[r])&Pattern->Mask[r])!=0)
+            return false;
+    return true;
+}
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * FILENAME: ByteSearch.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the byte pattern search used by the hex displays in it.
+ *    Patterns can be hex bytes (with ?? wild cards), AscII text or UTF-16
+ *    text.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __BYTESEARCH_H_
+#define __BYTESEARCH_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include <stdint.h>
+#include <stddef.h>
+
+/***  DEFINES                          ***/
+#define BYTESEARCH_MAX_PATTERN              256     // Most bytes a pattern can have
+
+/***  MACROS                           ***/
+
+/***  TYPE DEFINITIONS                 ***/
+typedef enum
+{
+    e_ByteSearchPattern_Hex,            // "AA ?? 55", "A? 0x12"
+    e_ByteSearchPattern_AscII,          // The bytes of the string as is
+    e_ByteSearchPattern_UTF16LE,        // The string converted to UTF-16 (little endian)
+    e_ByteSearchPattern_UTF16BE,        // The string converted to UTF-16 (big endian)
+    e_ByteSearchPatternMAX
+} e_ByteSearchPatternType;
+
+struct ByteSearchPattern
+{
+    e_ByteSearchPatternType Type;
+    int Len;
+    uint8_t Bytes[BYTESEARCH_MAX_PATTERN];
+    uint8_t Mask[BYTESEARCH_MAX_PATTERN];   // The bits of 'Bytes' that have to match (0xFF=all, 0x00=wild card)
+    int Skip[256];                          // Boyer-Moore-Horspool shift for the byte under the last pos
+    bool UseBMH;                            // false=memchr() for 'Bytes[AnchorPos]'
+    int AnchorPos;                          // The fully fixed byte memchr() looks for (-1 = all wild)
+};
+
+/***  CLASS DEFINITIONS                ***/
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+bool ByteSearch_ParsePattern(const char *Str,e_ByteSearchPatternType Type,
+        struct ByteSearchPattern *RetPattern);
+bool ByteSearch_ParseUserPattern(const char *Str,
+        struct ByteSearchPattern *RetPattern);
+const uint8_t *ByteSearch_Find(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Data,size_t Bytes);
+int64_t ByteSearch_FindInRing(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Ring,size_t RingSize,size_t DataStart,size_t DataBytes,
+        size_t From,size_t To);
+int64_t ByteSearch_FindNextInRing(const struct ByteSearchPattern *Pattern,
+        const uint8_t *Ring,size_t RingSize,size_t DataStart,size_t DataBytes,
+        size_t From);
+
+#endif
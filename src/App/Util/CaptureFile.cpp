@@ -0,0 +1,1334 @@
+/*******************************************************************************
+ * FILENAME: CaptureFile.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the capture file formats in it.
+ *
+ *    The binary format looks like this:
+ *      struct CaptureFileHeader
+ *      Records (struct CaptureFileRecHeader + data + pad to 8 bytes)...
+ *      e_CaptureRec_Index record
+ *      e_CaptureRec_IndexEnd record
+ *
+ *    Records are only ever added to the end.  Appending to a capture just
+ *    adds more records after the old index (the reader skips index records
+ *    when walking) and a new index that covers the whole file.  If the
+ *    program dies before the capture is closed the index will be missing,
+ *    the reader will then rebuild it by walking the records once.
+ *
+ *    Everything is stored in the host byte order which is little endian
+ *    on all the systems we run on.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/Util/CaptureFile.h"
+#include "OS/MappedFile.h"
+#include "OS/OSTime.h"
+#include <string.h>
+#include <ctype.h>
+
+/*** DEFINES                  ***/
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+
+/*** VARIABLE DEFINITIONS     ***/
+static const uint8_t m_CaptureFilePadding[8]={0,0,0,0,0,0,0,0};
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFile_IsBinaryFilename
+ *
+ * SYNOPSIS:
+ *    bool CaptureFile_IsBinaryFilename(const char *Filename);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The filename to check
+ *
+ * FUNCTION:
+ *    This function checks if a capture filename should be saved in the
+ *    binary capture format.  This is picked by the file extension.
+ *
+ * RETURNS:
+ *    true -- Use the binary format
+ *    false -- Use the text formats
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+bool CaptureFile_IsBinaryFilename(const char *Filename)
+{
+    const char *Ext=CAPTUREFILE_EXTENSION;
+    const char *Pos;
+    size_t Len;
+    size_t ExtLen;
+    size_t r;
+
+    Len=strlen(Filename);
+    ExtLen=strlen(Ext);
+    if(Len<ExtLen)
+        return false;
+
+    Pos=&Filename[Len-ExtLen];
+    for(r=0;r<ExtLen;r++)
+    {
+        if(tolower((unsigned char)Pos[r])!=Ext[r])
+            return false;
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFile_ExportText
+ *
+ * SYNOPSIS:
+ *    bool CaptureFile_ExportText(const char *CaptureFilename,
+ *              const char *OutFilename,
+ *              const struct CaptureToFileOptions &Options,bool IncludeTX);
+ *
+ * PARAMETERS:
+ *    CaptureFilename [I] -- The binary capture to read
+ *    OutFilename [I] -- The text file to write
+ *    Options [I] -- The text format options (the same ones used when
+ *                   capturing to a text file).
+ *    IncludeTX [I] -- Include the bytes we sent as well as the ones we got.
+ *
+ * FUNCTION:
+ *    This function writes a text view (plain text or hex dump) of a binary
+ *    capture file.  The output is the same as if the capture had been done
+ *    to a text file in the first place except the timestamps come from the
+ *    records.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.
+ *
+ * SEE ALSO:
+ *    CaptureTextFormatter
+ ******************************************************************************/
+bool CaptureFile_ExportText(const char *CaptureFilename,
+        const char *OutFilename,const struct CaptureToFileOptions &Options,
+        bool IncludeTX)
+{
+    class CaptureFileReader Reader;
+    class CaptureTextFormatter Formatter;
+    struct CaptureFileRecord Rec;
+    time_t StartTime;
+    FILE *out;
+    bool RetValue;
+
+    if(!Reader.Open(CaptureFilename))
+        return false;
+
+    out=fopen(OutFilename,Options.Append?"ab":"wb");
+    if(out==NULL)
+        return false;
+
+    StartTime=Reader.GetStartTime();
+
+    Formatter.Start(out,Options,StartTime);
+    while(Reader.ReadRecord(Rec))
+    {
+        if(Rec.Type==e_CaptureRec_TX && !IncludeTX)
+            continue;
+
+        Formatter.Format(out,Rec.Data,Rec.Length,
+                StartTime+(time_t)(Rec.Timestamp/1000000000ULL));
+    }
+    Formatter.Finish(out);
+
+    RetValue=true;
+    if(ferror(out))
+        RetValue=false;
+    if(fclose(out)!=0)
+        RetValue=false;
+
+    return RetValue;
+}
+
+CaptureFileReader::CaptureFileReader()
+{
+    Map=NULL;
+    Data=NULL;
+    Size=0;
+    FirstRecord=0;
+    ValidEnd=0;
+    Pos=0;
+    StartTime=0;
+    LastTimestamp=0;
+}
+
+CaptureFileReader::~CaptureFileReader()
+{
+    Close();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::Open
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileReader::Open(const char *Filename);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The capture file to open
+ *
+ * FUNCTION:
+ *    This function maps a binary capture file into memory and gets the
+ *    index ready.  If the file was not closed correctly (no index at the
+ *    end) the index is rebuilt by walking the file.  A damaged record at
+ *    the end of the file (a half written one) is ignored.
+ *
+ *    The read position is set to the first record.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.  The file could not be opened or it is
+ *             not a capture file.
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::Close(), CaptureFileReader::SeekTime(),
+ *    CaptureFileReader::ReadRecord()
+ ******************************************************************************/
+bool CaptureFileReader::Open(const char *Filename)
+{
+    struct CaptureFileHeader Hdr;
+
+    Close();
+
+    try
+    {
+        Map=MapFile(Filename);
+        if(Map==NULL)
+            throw(0);
+
+        Data=GetMappedFileData(Map);
+        Size=GetMappedFileSize(Map);
+
+        if(Data==NULL || Size<sizeof(Hdr))
+            throw(0);
+
+        memcpy(&Hdr,Data,sizeof(Hdr));
+        if(memcmp(Hdr.Magic,CAPTUREFILE_MAGIC,sizeof(Hdr.Magic))!=0 ||
+                Hdr.Version!=CAPTUREFILE_VERSION ||
+                Hdr.HeaderSize<sizeof(Hdr) || Hdr.HeaderSize>Size ||
+                CAPTUREFILE_ALIGN(Hdr.HeaderSize)!=Hdr.HeaderSize)
+        {
+            throw(0);
+        }
+
+        StartTime=(time_t)Hdr.StartTime;
+        FirstRecord=Hdr.HeaderSize;
+
+        if(!LoadIndex())
+            BuildIndex();
+
+        Pos=FirstRecord;
+    }
+    catch(...)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::Close
+ *
+ * SYNOPSIS:
+ *    void CaptureFileReader::Close(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function closes the capture file.  Any 'Data' pointers from
+ *    ReadRecord() are no longer valid after this.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::Open()
+ ******************************************************************************/
+void CaptureFileReader::Close(void)
+{
+    if(Map!=NULL)
+        UnMapFile(Map);
+    Map=NULL;
+    Data=NULL;
+    Size=0;
+    FirstRecord=0;
+    ValidEnd=0;
+    Pos=0;
+    StartTime=0;
+    LastTimestamp=0;
+    Index.clear();
+}
+
+bool CaptureFileReader::IsOpen(void)
+{
+    return Map!=NULL;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::GetStartTime
+ *
+ * SYNOPSIS:
+ *    time_t CaptureFileReader::GetStartTime(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the wall clock time the capture was started.  All
+ *    the record timestamps are in ns from this time.
+ *
+ * RETURNS:
+ *    The time the capture file was made.
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::GetLastTimestamp()
+ ******************************************************************************/
+time_t CaptureFileReader::GetStartTime(void)
+{
+    return StartTime;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::GetLastTimestamp
+ *
+ * SYNOPSIS:
+ *    uint64_t CaptureFileReader::GetLastTimestamp(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the timestamp of the last RX/TX record in the file.
+ *    This is the length of the capture in ns.
+ *
+ * RETURNS:
+ *    The timestamp of the last record (0 if there are no records)
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::GetStartTime()
+ ******************************************************************************/
+uint64_t CaptureFileReader::GetLastTimestamp(void)
+{
+    return LastTimestamp;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::GetValidSize
+ *
+ * SYNOPSIS:
+ *    uint64_t CaptureFileReader::GetValidSize(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the number of bytes at the start of the file that
+ *    are good records.  Anything after this is a damaged record from a
+ *    capture that was not closed.
+ *
+ * RETURNS:
+ *    The offset of the end of the last good record.
+ *
+ * SEE ALSO:
+ *    CaptureFileWriter::Open()
+ ******************************************************************************/
+uint64_t CaptureFileReader::GetValidSize(void)
+{
+    return ValidEnd;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::GetFileSize
+ *
+ * SYNOPSIS:
+ *    uint64_t CaptureFileReader::GetFileSize(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the size of the file (including any damaged record
+ *    at the end).
+ *
+ * RETURNS:
+ *    The number of bytes in the file.
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::GetValidSize()
+ ******************************************************************************/
+uint64_t CaptureFileReader::GetFileSize(void)
+{
+    return Size;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::GetIndex
+ *
+ * SYNOPSIS:
+ *    const t_CaptureFileIndexType &CaptureFileReader::GetIndex(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the time/offset index for the file.
+ *
+ * RETURNS:
+ *    The index.
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::SeekTime()
+ ******************************************************************************/
+const t_CaptureFileIndexType &CaptureFileReader::GetIndex(void)
+{
+    return Index;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::Rewind
+ *
+ * SYNOPSIS:
+ *    void CaptureFileReader::Rewind(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function moves the read position back to the first record.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::SeekTime()
+ ******************************************************************************/
+void CaptureFileReader::Rewind(void)
+{
+    Pos=FirstRecord;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::SeekTime
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileReader::SeekTime(uint64_t Timestamp);
+ *
+ * PARAMETERS:
+ *    Timestamp [I] -- The time (in ns from the start of the capture) to
+ *                     seek to.
+ *
+ * FUNCTION:
+ *    This function moves the read position to the first RX/TX record with
+ *    a timestamp at or after 'Timestamp'.
+ *
+ *    This does a binary search of the index and then walks at most
+ *    CAPTUREFILE_INDEX_SPACING bytes of records so it takes the same time
+ *    no matter how big the file is.
+ *
+ * RETURNS:
+ *    true -- There is a record at or after 'Timestamp'
+ *    false -- 'Timestamp' is after the end of the capture.  The read position
+ *             is at the end.
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::ReadRecord()
+ ******************************************************************************/
+bool CaptureFileReader::SeekTime(uint64_t Timestamp)
+{
+    struct CaptureFileRecHeader Hdr;
+    size_t Low;
+    size_t High;
+    size_t Mid;
+
+    /* Find the first index entry at or after 'Timestamp' and start from the
+       one before it (records with the same timestamp can be before the
+       entry) */
+    Low=0;
+    High=Index.size();
+    while(Low<High)
+    {
+        Mid=Low+(High-Low)/2;
+        if(Index[Mid].Timestamp<Timestamp)
+            Low=Mid+1;
+        else
+            High=Mid;
+    }
+
+    if(Low>0)
+        Pos=Index[Low-1].Offset;
+    else
+        Pos=FirstRecord;
+
+    while(Pos<ValidEnd && GetRecHeader(Pos,Hdr))
+    {
+        if((Hdr.Type==e_CaptureRec_RX || Hdr.Type==e_CaptureRec_TX) &&
+                Hdr.Timestamp>=Timestamp)
+        {
+            return true;
+        }
+        Pos+=sizeof(Hdr)+CAPTUREFILE_ALIGN(Hdr.Length);
+    }
+
+    Pos=ValidEnd;
+    return false;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::ReadRecord
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileReader::ReadRecord(struct CaptureFileRecord &Rec);
+ *
+ * PARAMETERS:
+ *    Rec [O] -- The record we read.  'Rec.Data' points into the mapped
+ *               file (no copy is made).
+ *
+ * FUNCTION:
+ *    This function reads the next RX/TX record and moves the read position
+ *    past it.  Index records are skipped.
+ *
+ * RETURNS:
+ *    true -- 'Rec' has been filled in
+ *    false -- There are no more records.
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::SeekTime()
+ ******************************************************************************/
+bool CaptureFileReader::ReadRecord(struct CaptureFileRecord &Rec)
+{
+    struct CaptureFileRecHeader Hdr;
+    uint64_t RecOffset;
+
+    while(Pos<ValidEnd && GetRecHeader(Pos,Hdr))
+    {
+        RecOffset=Pos;
+        Pos+=sizeof(Hdr)+CAPTUREFILE_ALIGN(Hdr.Length);
+
+        if(Hdr.Type!=e_CaptureRec_RX && Hdr.Type!=e_CaptureRec_TX)
+            continue;
+
+        Rec.Type=(e_CaptureRecType)Hdr.Type;
+        Rec.Timestamp=Hdr.Timestamp;
+        Rec.Data=&Data[RecOffset+sizeof(Hdr)];
+        Rec.Length=Hdr.Length;
+        return true;
+    }
+    return false;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::GetRecHeader
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileReader::GetRecHeader(uint64_t Offset,
+ *              struct CaptureFileRecHeader &Hdr);
+ *
+ * PARAMETERS:
+ *    Offset [I] -- The file offset of the record
+ *    Hdr [O] -- The record header
+ *
+ * FUNCTION:
+ *    This function reads a record header and makes sure the whole record
+ *    is in the file.
+ *
+ * RETURNS:
+ *    true -- 'Hdr' is a good record
+ *    false -- There isn't a good record here (end of the file or damaged)
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+bool CaptureFileReader::GetRecHeader(uint64_t Offset,
+        struct CaptureFileRecHeader &Hdr)
+{
+    if(Offset+sizeof(Hdr)>Size)
+        return false;
+
+    memcpy(&Hdr,&Data[Offset],sizeof(Hdr));
+
+    if(Hdr.Type<e_CaptureRec_RX || Hdr.Type>=e_CaptureRecMAX)
+        return false;
+
+    if(Hdr.Type!=e_CaptureRec_Index && Hdr.Length>CAPTUREFILE_MAX_RECORD_SIZE)
+        return false;
+
+    if(CAPTUREFILE_ALIGN(Hdr.Length)>Size-Offset-sizeof(Hdr))
+        return false;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::LoadIndex
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileReader::LoadIndex(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function loads the index from the end of the file.
+ *
+ * RETURNS:
+ *    true -- The index was loaded
+ *    false -- There isn't a good index at the end of the file.
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::BuildIndex()
+ ******************************************************************************/
+bool CaptureFileReader::LoadIndex(void)
+{
+    struct CaptureFileRecHeader EndHdr;
+    struct CaptureFileRecHeader IndexHdr;
+    struct CaptureFileIndexEnd End;
+    uint64_t EndOffset;
+
+    if(Size<FirstRecord+sizeof(EndHdr)+CAPTUREFILE_ALIGN(sizeof(End)))
+        return false;
+
+    EndOffset=Size-(sizeof(EndHdr)+CAPTUREFILE_ALIGN(sizeof(End)));
+    if(!GetRecHeader(EndOffset,EndHdr) || EndHdr.Type!=e_CaptureRec_IndexEnd ||
+            EndHdr.Length!=sizeof(End))
+    {
+        return false;
+    }
+
+    memcpy(&End,&Data[EndOffset+sizeof(EndHdr)],sizeof(End));
+    if(memcmp(End.Magic,CAPTUREFILE_INDEX_MAGIC,sizeof(End.Magic))!=0)
+        return false;
+
+    if(End.IndexOffset<FirstRecord || End.IndexOffset>=EndOffset ||
+            End.Entries>(EndOffset-End.IndexOffset)/
+            sizeof(struct CaptureFileIndexEntry))
+    {
+        return false;
+    }
+
+    if(!GetRecHeader(End.IndexOffset,IndexHdr) ||
+            IndexHdr.Type!=e_CaptureRec_Index ||
+            IndexHdr.Length!=End.Entries*sizeof(struct CaptureFileIndexEntry))
+    {
+        return false;
+    }
+
+    Index.resize(End.Entries);
+    if(End.Entries>0)
+    {
+        memcpy(Index.data(),&Data[End.IndexOffset+sizeof(IndexHdr)],
+                IndexHdr.Length);
+    }
+
+    LastTimestamp=EndHdr.Timestamp;
+    ValidEnd=Size;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileReader::BuildIndex
+ *
+ * SYNOPSIS:
+ *    void CaptureFileReader::BuildIndex(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function walks all the records in the file and builds the index.
+ *    This is only needed when the capture was not closed (the program was
+ *    killed).  It also finds where the last good record ends.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureFileReader::LoadIndex()
+ ******************************************************************************/
+void CaptureFileReader::BuildIndex(void)
+{
+    struct CaptureFileRecHeader Hdr;
+    struct CaptureFileIndexEntry Entry;
+    uint64_t Offset;
+    uint64_t LastIndexedOffset;
+
+    Index.clear();
+    LastTimestamp=0;
+    LastIndexedOffset=0;
+
+    Offset=FirstRecord;
+    while(GetRecHeader(Offset,Hdr))
+    {
+        if(Hdr.Type==e_CaptureRec_RX || Hdr.Type==e_CaptureRec_TX)
+        {
+            /* This must match what CaptureFileWriter::WriteRecord() does */
+            if(Index.empty() ||
+                    Offset-LastIndexedOffset>=CAPTUREFILE_INDEX_SPACING)
+            {
+                Entry.Timestamp=Hdr.Timestamp;
+                Entry.Offset=Offset;
+                Index.push_back(Entry);
+                LastIndexedOffset=Offset;
+            }
+            LastTimestamp=Hdr.Timestamp;
+        }
+        Offset+=sizeof(Hdr)+CAPTUREFILE_ALIGN(Hdr.Length);
+    }
+    ValidEnd=Offset;
+}
+
+CaptureFileWriter::CaptureFileWriter()
+{
+    Handle=NULL;
+    FileOffset=0;
+    LastIndexedOffset=0;
+    TimeBase=0;
+    OpenTime=0;
+    LastTimestamp=0;
+}
+
+CaptureFileWriter::~CaptureFileWriter()
+{
+    Close();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileWriter::Open
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileWriter::Open(const char *Filename,bool Append);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to write
+ *    Append [I] -- Add to the end of an existing capture (true) or start a
+ *                  new one (false).  If the file doesn't exist (or is
+ *                  empty) a new one is started.  If it isn't a capture file
+ *                  this fails.
+ *
+ * FUNCTION:
+ *    This function opens a binary capture file for writing.
+ *
+ *    When appending, the time keeps going from the start of the old capture
+ *    so the records stay in time order, and the old index is kept so the
+ *    new index covers the whole file.  A damaged record at the end (from a
+ *    capture that was not closed) is cut off before we add to the file.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.
+ *
+ * SEE ALSO:
+ *    CaptureFileWriter::WriteRecord(), CaptureFileWriter::Close()
+ ******************************************************************************/
+bool CaptureFileWriter::Open(const char *Filename,bool Append)
+{
+    class CaptureFileReader Existing;
+    struct CaptureFileHeader Hdr;
+    time_t Now;
+    uint64_t ValidSize;
+    uint64_t FileSize;
+    uint64_t WallOffset;
+
+    Close();
+
+    time(&Now);
+    Index.clear();
+    LastTimestamp=0;
+    TimeBase=0;
+
+    try
+    {
+        if(Append && Existing.Open(Filename))
+        {
+            Index=Existing.GetIndex();
+            LastTimestamp=Existing.GetLastTimestamp();
+            ValidSize=Existing.GetValidSize();
+
+            /* Pick up the time from the old start time */
+            TimeBase=LastTimestamp;
+            if(Now>=Existing.GetStartTime())
+            {
+                WallOffset=(uint64_t)(Now-Existing.GetStartTime())*
+                        1000000000ULL;
+                if(WallOffset>TimeBase)
+                    TimeBase=WallOffset;
+            }
+
+            FileSize=Existing.GetFileSize();
+            Existing.Close();
+
+            /* Cut off anything that was half written */
+            if(FileSize>ValidSize)
+            {
+                if(!TruncateFile(Filename,ValidSize))
+                    throw(0);
+            }
+
+            Handle=fopen(Filename,"ab");
+            if(Handle==NULL)
+                throw(0);
+
+            FileOffset=ValidSize;
+        }
+        else
+        {
+            if(Append)
+            {
+                /* Don't write over something that isn't a capture */
+                Handle=fopen(Filename,"rb");
+                if(Handle!=NULL)
+                {
+                    if(fgetc(Handle)!=EOF)
+                        throw(0);
+                    fclose(Handle);
+                    Handle=NULL;
+                }
+            }
+
+            Handle=fopen(Filename,"wb");
+            if(Handle==NULL)
+                throw(0);
+
+            memset(&Hdr,0x00,sizeof(Hdr));
+            memcpy(Hdr.Magic,CAPTUREFILE_MAGIC,sizeof(Hdr.Magic));
+            Hdr.Version=CAPTUREFILE_VERSION;
+            Hdr.HeaderSize=sizeof(Hdr);
+            Hdr.StartTime=(uint64_t)Now;
+            if(fwrite(&Hdr,sizeof(Hdr),1,Handle)!=1)
+                throw(0);
+
+            FileOffset=sizeof(Hdr);
+        }
+
+        if(Index.empty())
+            LastIndexedOffset=0;
+        else
+            LastIndexedOffset=Index.back().Offset;
+
+        OpenTime=GetElapsedTime_ns();
+    }
+    catch(...)
+    {
+        if(Handle!=NULL)
+            fclose(Handle);
+        Handle=NULL;
+        Index.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool CaptureFileWriter::IsOpen(void)
+{
+    return Handle!=NULL;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileWriter::WriteRecord
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileWriter::WriteRecord(e_CaptureRecType Type,
+ *              const uint8_t *Data,int Bytes);
+ *
+ * PARAMETERS:
+ *    Type [I] -- The type of record (e_CaptureRec_RX or e_CaptureRec_TX)
+ *    Data [I] -- The bytes to save
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function adds a record to the end of the capture stamped with
+ *    the current time.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error writing to the file.
+ *
+ * SEE ALSO:
+ *    CaptureFileWriter::Open()
+ ******************************************************************************/
+bool CaptureFileWriter::WriteRecord(e_CaptureRecType Type,const uint8_t *Data,
+        int Bytes)
+{
+    struct CaptureFileIndexEntry Entry;
+    uint64_t Timestamp;
+    uint32_t Chunk;
+
+    if(Handle==NULL)
+        return false;
+
+    Timestamp=TimeBase+(GetElapsedTime_ns()-OpenTime);
+    if(Timestamp<LastTimestamp)
+        Timestamp=LastTimestamp;
+    LastTimestamp=Timestamp;
+
+    while(Bytes>0)
+    {
+        Chunk=Bytes;
+        if(Chunk>CAPTUREFILE_MAX_RECORD_SIZE)
+            Chunk=CAPTUREFILE_MAX_RECORD_SIZE;
+
+        if(Index.empty() || FileOffset-LastIndexedOffset>=
+                CAPTUREFILE_INDEX_SPACING)
+        {
+            Entry.Timestamp=Timestamp;
+            Entry.Offset=FileOffset;
+            try
+            {
+                Index.push_back(Entry);
+                LastIndexedOffset=FileOffset;
+            }
+            catch(...)
+            {
+                /* We just end up with a sparser index */
+            }
+        }
+
+        if(!WriteRecHeader(Type,Timestamp,Chunk))
+            return false;
+        if(fwrite(Data,Chunk,1,Handle)!=1)
+            return false;
+        if(!WritePadding(Chunk))
+            return false;
+
+        FileOffset+=sizeof(struct CaptureFileRecHeader)+
+                CAPTUREFILE_ALIGN(Chunk);
+        Data+=Chunk;
+        Bytes-=Chunk;
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileWriter::Close
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileWriter::Close(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function writes the index to the end of the file and closes it.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error writing the file.
+ *
+ * SEE ALSO:
+ *    CaptureFileWriter::Open()
+ ******************************************************************************/
+bool CaptureFileWriter::Close(void)
+{
+    struct CaptureFileIndexEnd End;
+    uint32_t IndexBytes;
+    bool RetValue;
+
+    if(Handle==NULL)
+        return true;
+
+    RetValue=true;
+
+    memset(&End,0x00,sizeof(End));
+    End.IndexOffset=FileOffset;
+    End.Entries=Index.size();
+    memcpy(End.Magic,CAPTUREFILE_INDEX_MAGIC,sizeof(End.Magic));
+
+    IndexBytes=Index.size()*sizeof(struct CaptureFileIndexEntry);
+    if(!WriteRecHeader(e_CaptureRec_Index,LastTimestamp,IndexBytes))
+        RetValue=false;
+    if(IndexBytes>0 && fwrite(Index.data(),IndexBytes,1,Handle)!=1)
+        RetValue=false;
+    if(!WritePadding(IndexBytes))
+        RetValue=false;
+
+    if(!WriteRecHeader(e_CaptureRec_IndexEnd,LastTimestamp,sizeof(End)))
+        RetValue=false;
+    if(fwrite(&End,sizeof(End),1,Handle)!=1)
+        RetValue=false;
+    if(!WritePadding(sizeof(End)))
+        RetValue=false;
+
+    if(ferror(Handle))
+        RetValue=false;
+    if(fclose(Handle)!=0)
+        RetValue=false;
+
+    Handle=NULL;
+    Index.clear();
+
+    return RetValue;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileWriter::WriteRecHeader
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileWriter::WriteRecHeader(e_CaptureRecType Type,
+ *              uint64_t Timestamp,uint32_t Length);
+ *
+ * PARAMETERS:
+ *    Type [I] -- The record type
+ *    Timestamp [I] -- The time for this record
+ *    Length [I] -- The number of data bytes that will follow
+ *
+ * FUNCTION:
+ *    This function writes a record header.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error writing the file.
+ *
+ * SEE ALSO:
+ *    CaptureFileWriter::WritePadding()
+ ******************************************************************************/
+bool CaptureFileWriter::WriteRecHeader(e_CaptureRecType Type,
+        uint64_t Timestamp,uint32_t Length)
+{
+    struct CaptureFileRecHeader Hdr;
+
+    memset(&Hdr,0x00,sizeof(Hdr));
+    Hdr.Timestamp=Timestamp;
+    Hdr.Length=Length;
+    Hdr.Type=Type;
+
+    return fwrite(&Hdr,sizeof(Hdr),1,Handle)==1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureFileWriter::WritePadding
+ *
+ * SYNOPSIS:
+ *    bool CaptureFileWriter::WritePadding(uint32_t Length);
+ *
+ * PARAMETERS:
+ *    Length [I] -- The number of data bytes that where written
+ *
+ * FUNCTION:
+ *    This function pads out the data of a record so the next record
+ *    starts 8 byte aligned.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error writing the file.
+ *
+ * SEE ALSO:
+ *    CaptureFileWriter::WriteRecHeader()
+ ******************************************************************************/
+bool CaptureFileWriter::WritePadding(uint32_t Length)
+{
+    uint32_t Pad;
+
+    Pad=CAPTUREFILE_ALIGN(Length)-Length;
+    if(Pad==0)
+        return true;
+
+    return fwrite(m_CaptureFilePadding,Pad,1,Handle)==1;
+}
+
+CaptureTextFormatter::CaptureTextFormatter()
+{
+    memset(&Opts,0x00,sizeof(Opts));
+    EscSeqSkiping=false;
+    HexDumpInsertPos=0;
+    HexDumpOffset=0;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureTextFormatter::Start
+ *
+ * SYNOPSIS:
+ *    void CaptureTextFormatter::Start(FILE *Out,
+ *              const struct CaptureToFileOptions &Options,time_t Now);
+ *
+ * PARAMETERS:
+ *    Out [I] -- The file to write to
+ *    Options [I] -- The options to format with
+ *    Now [I] -- The time to use for the first timestamp
+ *
+ * FUNCTION:
+ *    This function starts a new text capture.  It writes the start of the
+ *    first line.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureTextFormatter::Format(), CaptureTextFormatter::Finish()
+ ******************************************************************************/
+void CaptureTextFormatter::Start(FILE *Out,
+        const struct CaptureToFileOptions &Options,time_t Now)
+{
+    char buff[100];
+
+    Opts=Options;
+    EscSeqSkiping=false;
+    HexDumpInsertPos=0;
+    HexDumpOffset=0;
+
+    if(Opts.SaveAsHexDump)
+    {
+        sprintf(buff,"%08X:",0);
+        fwrite(buff,8+1,1,Out);   // 8 hex + ':'
+    }
+    else
+    {
+        if(Opts.Timestamp)
+            WriteTimestamp(Out,Now);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureTextFormatter::Format
+ *
+ * SYNOPSIS:
+ *    void CaptureTextFormatter::Format(FILE *Out,const uint8_t *Data,
+ *              int Bytes,time_t Now);
+ *
+ * PARAMETERS:
+ *    Out [I] -- The file to write to
+ *    Data [I] -- The bytes to add
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *    Now [I] -- The time these bytes came in (used for timestamps)
+ *
+ * FUNCTION:
+ *    This function adds bytes to the text capture.  It will strip things
+ *    and make adjustments based on the capture options.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureTextFormatter::Start()
+ ******************************************************************************/
+void CaptureTextFormatter::Format(FILE *Out,const uint8_t *Data,int Bytes,
+        time_t Now)
+{
+    const uint8_t *Pos;
+    const uint8_t *EndPos;
+    const uint8_t *LastStart;
+    char buff[100];
+
+    Pos=Data;
+    EndPos=Pos+Bytes;
+
+    if(Opts.SaveAsHexDump)
+    {
+        for(;Pos<EndPos;Pos++)
+        {
+            HexDumpOffset++;
+
+            sprintf(buff,"%02X ",*Pos);
+            fwrite(buff,3,1,Out);
+            HexDumpBuff[HexDumpInsertPos++]=(*Pos<32 || *Pos>126)?'.':*Pos;
+            if(HexDumpInsertPos>=CAPTURE_HEXDUMP_VALUES_PER_LINE)
+            {
+                /* Write out the AscII preview */
+                fwrite("   ",3,1,Out);
+                fwrite(HexDumpBuff,CAPTURE_HEXDUMP_VALUES_PER_LINE,1,Out);
+
+                sprintf(buff,"\n%08X:",HexDumpOffset);
+                fwrite(buff,8+1+1,1,Out); // 8 hex + \n + ':'
+
+                HexDumpInsertPos=0;
+            }
+        }
+    }
+    else
+    {
+        /* Handle options in blocks */
+        LastStart=Pos;
+        for(;Pos<EndPos;Pos++)
+        {
+            if(Opts.Timestamp)
+            {
+                if(*Pos=='\n')
+                {
+                    /* Output the block and then a timestamp */
+                    fwrite(LastStart,Pos-LastStart+1,1,Out);
+                    WriteTimestamp(Out,Now);
+                    LastStart=Pos+1;
+                    continue;
+                }
+            }
+
+            if(Opts.StripEsc)
+            {
+                if(!EscSeqSkiping)
+                {
+                    /* We are looking for esc char */
+                    if(*Pos==27)    // 27 esc
+                    {
+                        /* Output the block and skip this char */
+                        fwrite(LastStart,Pos-LastStart,1,Out);
+                        EscSeqSkiping=true;
+                        LastStart=Pos+1;
+                        continue;
+                    }
+                }
+                else
+                {
+                    /* We strip everything until we see a letter (upper or
+                       lower) or another ESC */
+                    if(*Pos==27 ||
+                            (*Pos>='a' && *Pos<='z') ||
+                            (*Pos>='A' && *Pos<='Z'))
+                    {
+                        /* Ok, exit this mode */
+                        EscSeqSkiping=false;
+
+                        /* If we hit an ESC ESC we want to output both */
+                        if(*Pos==27)
+                        {
+                            buff[0]=27;
+                            buff[1]=27;
+                            fwrite(buff,2,1,Out);
+                        }
+                    }
+                    /* Skip this char */
+                    LastStart=Pos+1;
+                    continue;
+                }
+            }
+
+            if(Opts.StripCtrl)
+            {
+                if(*Pos<32 && *Pos!='\n' && *Pos!='\r')
+                {
+                    /* Output the block and skip this char */
+                    fwrite(LastStart,Pos-LastStart,1,Out);
+                    LastStart=Pos+1;
+                    continue;
+                }
+            }
+        }
+        if(LastStart!=Pos)
+            fwrite(LastStart,Pos-LastStart,1,Out);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureTextFormatter::Finish
+ *
+ * SYNOPSIS:
+ *    void CaptureTextFormatter::Finish(FILE *Out);
+ *
+ * PARAMETERS:
+ *    Out [I] -- The file to write to
+ *
+ * FUNCTION:
+ *    This function finishes off the text capture (fills out the last line
+ *    of a hex dump).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    CaptureTextFormatter::Start()
+ ******************************************************************************/
+void CaptureTextFormatter::Finish(FILE *Out)
+{
+    int r;
+
+    if(Opts.SaveAsHexDump)
+    {
+        /* Fill in the hex part with spaces */
+        for(r=HexDumpInsertPos;r<CAPTURE_HEXDUMP_VALUES_PER_LINE;r++)
+            fwrite("   ",3,1,Out);
+
+        /* Write the AscII preview */
+        fwrite("   ",3,1,Out);
+        fwrite(HexDumpBuff,HexDumpInsertPos,1,Out);
+        fwrite("\n",1,1,Out);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CaptureTextFormatter::WriteTimestamp
+ *
+ * SYNOPSIS:
+ *    void CaptureTextFormatter::WriteTimestamp(FILE *Out,time_t Now);
+ *
+ * PARAMETERS:
+ *    Out [I] -- The file to write to
+ *    Now [I] -- The time to write
+ *
+ * FUNCTION:
+ *    This function writes a line timestamp.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+void CaptureTextFormatter::WriteTimestamp(FILE *Out,time_t Now)
+{
+    const char *TimeStr;
+    char buff[100];
+
+    TimeStr=ctime(&Now);
+    if(TimeStr!=NULL)
+    {
+        strcpy(buff,TimeStr);
+        buff[24]=':';
+        fwrite(buff,strlen(buff),1,Out);
+    }
+}
@@ -0,0 +1,209 @@
+/*******************************************************************************
+ * FILENAME: CaptureFile.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the def's for the capture file formats in it.
+ *
+ *    The binary capture format (.wtcap) is an append only list of
+ *    timestamped RX/TX records with a sparse time/offset index written at
+ *    the end when the capture is closed.  The reader maps the file into
+ *    memory so seeking is a binary search of the index and a short walk
+ *    no matter how big the file is.
+ *
+ *    The older text and hex dump formats are made by CaptureTextFormatter
+ *    which is used both for live captures and for exporting a binary
+ *    capture as a text view.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __CAPTUREFILE_H_
+#define __CAPTUREFILE_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <vector>
+
+/***  DEFINES                          ***/
+#define CAPTURE_HEXDUMP_VALUES_PER_LINE         16
+
+#define CAPTUREFILE_EXTENSION                   ".wtcap"
+#define CAPTUREFILE_MAGIC                       "WTCAPTUR"  // 8 chars, no \0
+#define CAPTUREFILE_INDEX_MAGIC                 "WTCAPIDX"  // 8 chars, no \0
+#define CAPTUREFILE_VERSION                     1
+#define CAPTUREFILE_INDEX_SPACING               (256*1024)  // Bytes of records between index entries
+#define CAPTUREFILE_MAX_RECORD_SIZE             (16*1024*1024)
+
+/***  MACROS                           ***/
+/* Records are padded so every header in the file is 8 byte aligned */
+#define CAPTUREFILE_ALIGN(x)                    (((x)+7)&~((uint64_t)7))
+
+/***  TYPE DEFINITIONS                 ***/
+typedef enum
+{
+    e_CaptureRec_RX=1,
+    e_CaptureRec_TX,
+    e_CaptureRec_Index,                 // Array of 'struct CaptureFileIndexEntry'
+    e_CaptureRec_IndexEnd,              // 'struct CaptureFileIndexEnd', always last
+    e_CaptureRecMAX
+} e_CaptureRecType;
+
+/* All of these are stored in the file in little endian */
+struct CaptureFileHeader
+{
+    char Magic[8];
+    uint32_t Version;
+    uint32_t HeaderSize;                // Offset of the first record
+    uint64_t StartTime;                 // time_t when the file was created
+    uint64_t Reserved;
+};
+
+struct CaptureFileRecHeader
+{
+    uint64_t Timestamp;                 // ns from 'StartTime'
+    uint32_t Length;                    // Bytes of data (not including padding)
+    uint8_t Type;                       // e_CaptureRecType
+    uint8_t Reserved[3];
+};
+
+struct CaptureFileIndexEntry
+{
+    uint64_t Timestamp;
+    uint64_t Offset;                    // File offset of a RX/TX record
+};
+
+struct CaptureFileIndexEnd
+{
+    uint64_t IndexOffset;               // File offset of the e_CaptureRec_Index record
+    uint64_t Entries;
+    char Magic[8];
+};
+
+struct CaptureFileRecord
+{
+    e_CaptureRecType Type;
+    uint64_t Timestamp;
+    const uint8_t *Data;                // Points into the mapped file
+    uint32_t Length;
+};
+
+typedef std::vector<struct CaptureFileIndexEntry> t_CaptureFileIndexType;
+
+struct CaptureToFileOptions
+{
+    bool Timestamp;
+    bool Append;
+    bool StripCtrl;
+    bool StripEsc;
+    bool SaveAsHexDump;
+};
+
+/***  CLASS DEFINITIONS                ***/
+class CaptureFileReader
+{
+    public:
+        CaptureFileReader();
+        ~CaptureFileReader();
+        bool Open(const char *Filename);
+        void Close(void);
+        bool IsOpen(void);
+        time_t GetStartTime(void);
+        uint64_t GetLastTimestamp(void);
+        uint64_t GetValidSize(void);
+        uint64_t GetFileSize(void);
+        const t_CaptureFileIndexType &GetIndex(void);
+        void Rewind(void);
+        bool SeekTime(uint64_t Timestamp);
+        bool ReadRecord(struct CaptureFileRecord &Rec);
+
+    private:
+        struct MappedFile *Map;
+        const uint8_t *Data;
+        uint64_t Size;
+        uint64_t FirstRecord;
+        uint64_t ValidEnd;
+        uint64_t Pos;
+        time_t StartTime;
+        uint64_t LastTimestamp;
+        t_CaptureFileIndexType Index;
+
+        bool GetRecHeader(uint64_t Offset,struct CaptureFileRecHeader &Hdr);
+        bool LoadIndex(void);
+        void BuildIndex(void);
+};
+
+class CaptureFileWriter
+{
+    public:
+        CaptureFileWriter();
+        ~CaptureFileWriter();
+        bool Open(const char *Filename,bool Append);
+        bool WriteRecord(e_CaptureRecType Type,const uint8_t *Data,int Bytes);
+        bool Close(void);
+        bool IsOpen(void);
+
+    private:
+        FILE *Handle;
+        uint64_t FileOffset;
+        uint64_t LastIndexedOffset;
+        uint64_t TimeBase;
+        uint64_t OpenTime;
+        uint64_t LastTimestamp;
+        t_CaptureFileIndexType Index;
+
+        bool WriteRecHeader(e_CaptureRecType Type,uint64_t Timestamp,
+                uint32_t Length);
+        bool WritePadding(uint32_t Length);
+};
+
+class CaptureTextFormatter
+{
+    public:
+        CaptureTextFormatter();
+        void Start(FILE *Out,const struct CaptureToFileOptions &Options,
+                time_t Now);
+        void Format(FILE *Out,const uint8_t *Data,int Bytes,time_t Now);
+        void Finish(FILE *Out);
+
+    private:
+        struct CaptureToFileOptions Opts;
+        bool EscSeqSkiping;
+        uint8_t HexDumpBuff[CAPTURE_HEXDUMP_VALUES_PER_LINE+1];
+        int HexDumpInsertPos;
+        int HexDumpOffset;
+
+        void WriteTimestamp(FILE *Out,time_t Now);
+};
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+bool CaptureFile_IsBinaryFilename(const char *Filename);
+bool CaptureFile_ExportText(const char *CaptureFilename,
+        const char *OutFilename,const struct CaptureToFileOptions &Options,
+        bool IncludeTX);
+
+#endif   /* end of "#ifndef __CAPTUREFILE_H_" */
@@ -0,0 +1,616 @@
+/*******************************************************************************
+ * FILENAME: ComTestFrames.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the com test frame builder and checker in it.
+ *
+ *    A frame looks like this (all little endian):
+ *      0   SYNC0
+ *      1   SYNC1
+ *      2   Sequence number (32 bits)
+ *      6   Send time in ns from GetElapsedTime_ns() (64 bits)
+ *      14  Fletcher-16 of bytes 0-13
+ *      16  The test pattern
+ *
+ *    The pattern is the same for every frame so the checker just walks it.
+ *    A pattern byte that is wrong is counted as an error (and how many bits
+ *    where wrong) but doesn't make us lose sync, the header check and the
+ *    sequence number take care of dropped / added bytes.
+ *
+ *    Both ends of a com test are always in the same process so the send
+ *    time can be used directly to work out the latency of every frame.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/Util/ComTestFrames.h"
+#include <string.h>
+
+/*** DEFINES                  ***/
+#define COMTEST_HDR_SEQ             2
+#define COMTEST_HDR_TIME            6
+#define COMTEST_HDR_CHECK           14
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+static uint16_t ComTest_HeaderCheck(const uint8_t *Header);
+static int ComTest_BitsSet(uint8_t Byte);
+
+/*** VARIABLE DEFINITIONS     ***/
+
+/*******************************************************************************
+ * NAME:
+ *    ComTest_FillPRBS
+ *
+ * SYNOPSIS:
+ *    void ComTest_FillPRBS(uint8_t *Buff,uint32_t Len,int Order);
+ *
+ * PARAMETERS:
+ *    Buff [O] -- The buffer to fill
+ *    Len [I] -- The number of bytes to fill in
+ *    Order [I] -- What PRBS to use.  Supported are 7 (x^7+x^6+1),
+ *                 9 (x^9+x^5+1), 15 (x^15+x^14+1), 23 (x^23+x^18+1), and
+ *                 31 (x^31+x^28+1).  Anything else uses 15.
+ *
+ * FUNCTION:
+ *    This function fills a buffer with a pseudo random bit sequence (as
+ *    used by bit error rate testers).  The bits are stored MSB first and
+ *    the generator starts with all ones.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+void ComTest_FillPRBS(uint8_t *Buff,uint32_t Len,int Order)
+{
+    uint32_t State;
+    uint32_t Mask;
+    uint32_t NewBit;
+    int Tap;
+    uint32_t r;
+    int b;
+    uint8_t Byte;
+
+    switch(Order)
+    {
+        case 7:
+            Tap=6;
+        break;
+        case 9:
+            Tap=5;
+        break;
+        case 23:
+            Tap=18;
+        break;
+        case 31:
+            Tap=28;
+        break;
+        case 15:
+        default:
+            Order=15;
+            Tap=14;
+        break;
+    }
+
+    Mask=(uint32_t)((1ULL<<Order)-1);
+    State=Mask;
+    for(r=0;r<Len;r++)
+    {
+        Byte=0;
+        for(b=0;b<8;b++)
+        {
+            NewBit=((State>>(Order-1))^(State>>(Tap-1)))&1;
+            State=((State<<1)|NewBit)&Mask;
+            Byte=(Byte<<1)|NewBit;
+        }
+        Buff[r]=Byte;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTest_AddCounters
+ *
+ * SYNOPSIS:
+ *    void ComTest_AddCounters(struct ComTestRxCounters &Total,
+ *          const struct ComTestRxCounters &Add);
+ *
+ * PARAMETERS:
+ *    Total [I/O] -- The counters to add to
+ *    Add [I] -- The counters to add
+ *
+ * FUNCTION:
+ *    This function adds one set of rx counters to another (for full duplex
+ *    tests where both sides receive).
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+void ComTest_AddCounters(struct ComTestRxCounters &Total,
+        const struct ComTestRxCounters &Add)
+{
+    int r;
+
+    if(Add.PacketsRx>0)
+    {
+        if(Total.PacketsRx==0 || Add.LatencyMin_ns<Total.LatencyMin_ns)
+            Total.LatencyMin_ns=Add.LatencyMin_ns;
+        if(Add.LatencyMax_ns>Total.LatencyMax_ns)
+            Total.LatencyMax_ns=Add.LatencyMax_ns;
+    }
+
+    Total.PacketsRx+=Add.PacketsRx;
+    Total.PacketsLost+=Add.PacketsLost;
+    Total.BadFrames+=Add.BadFrames;
+    Total.BytesRx+=Add.BytesRx;
+    Total.BytesChecked+=Add.BytesChecked;
+    Total.ByteErrors+=Add.ByteErrors;
+    Total.BitErrors+=Add.BitErrors;
+    Total.SkippedBytes+=Add.SkippedBytes;
+    Total.LatencyTotal_ns+=Add.LatencyTotal_ns;
+    for(r=0;r<COMTEST_LATENCY_BUCKETS;r++)
+        Total.LatencyHist[r]+=Add.LatencyHist[r];
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTest_HeaderCheck
+ *
+ * SYNOPSIS:
+ *    static uint16_t ComTest_HeaderCheck(const uint8_t *Header);
+ *
+ * PARAMETERS:
+ *    Header [I] -- The frame header
+ *
+ * FUNCTION:
+ *    This function works out the Fletcher-16 of the header (not including
+ *    the check itself).
+ *
+ * RETURNS:
+ *    The check value.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static uint16_t ComTest_HeaderCheck(const uint8_t *Header)
+{
+    uint16_t Sum1;
+    uint16_t Sum2;
+    int r;
+
+    Sum1=0;
+    Sum2=0;
+    for(r=0;r<COMTEST_HDR_CHECK;r++)
+    {
+        Sum1=(Sum1+Header[r])%255;
+        Sum2=(Sum2+Sum1)%255;
+    }
+    return (Sum2<<8)|Sum1;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTest_BitsSet
+ *
+ * SYNOPSIS:
+ *    static int ComTest_BitsSet(uint8_t Byte);
+ *
+ * PARAMETERS:
+ *    Byte [I] -- The byte to count the bits in
+ *
+ * FUNCTION:
+ *    This function counts the number of bits set in a byte.
+ *
+ * RETURNS:
+ *    The number of bits that are 1.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+static int ComTest_BitsSet(uint8_t Byte)
+{
+    int Count;
+
+    Count=0;
+    while(Byte!=0)
+    {
+        Byte&=Byte-1;
+        Count++;
+    }
+    return Count;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTestFramer::Setup
+ *
+ * SYNOPSIS:
+ *    bool ComTestFramer::Setup(const uint8_t *Pattern,uint32_t PatternLen);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The pattern to send in every frame
+ *    PatternLen [I] -- The number of bytes in 'Pattern'
+ *
+ * FUNCTION:
+ *    This function sets up the frame buffer with the pattern.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Out of memory
+ *
+ * SEE ALSO:
+ *    ComTestFramer::BuildFrame()
+ ******************************************************************************/
+bool ComTestFramer::Setup(const uint8_t *Pattern,uint32_t PatternLen)
+{
+    try
+    {
+        Frame.resize(COMTEST_FRAME_HEADER_SIZE+PatternLen);
+    }
+    catch(...)
+    {
+        return false;
+    }
+
+    Frame[0]=COMTEST_FRAME_SYNC0;
+    Frame[1]=COMTEST_FRAME_SYNC1;
+    if(PatternLen>0)
+        memcpy(&Frame[COMTEST_FRAME_HEADER_SIZE],Pattern,PatternLen);
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTestFramer::BuildFrame
+ *
+ * SYNOPSIS:
+ *    const uint8_t *ComTestFramer::BuildFrame(uint32_t Seq,
+ *              uint64_t Timestamp);
+ *
+ * PARAMETERS:
+ *    Seq [I] -- The sequence number for this frame
+ *    Timestamp [I] -- The send time (GetElapsedTime_ns())
+ *
+ * FUNCTION:
+ *    This function fills in the header for the next frame.  Only the header
+ *    is touched, the pattern was copied in by Setup().
+ *
+ * RETURNS:
+ *    A pointer to the frame (GetFrameLen() bytes).  This is valid until
+ *    the next call.
+ *
+ * SEE ALSO:
+ *    ComTestFramer::Setup()
+ ******************************************************************************/
+const uint8_t *ComTestFramer::BuildFrame(uint32_t Seq,uint64_t Timestamp)
+{
+    uint8_t *Hdr;
+    uint16_t Check;
+    int r;
+
+    Hdr=Frame.data();
+    for(r=0;r<4;r++)
+        Hdr[COMTEST_HDR_SEQ+r]=(Seq>>(r*8))&0xFF;
+    for(r=0;r<8;r++)
+        Hdr[COMTEST_HDR_TIME+r]=(Timestamp>>(r*8))&0xFF;
+    Check=ComTest_HeaderCheck(Hdr);
+    Hdr[COMTEST_HDR_CHECK+0]=Check&0xFF;
+    Hdr[COMTEST_HDR_CHECK+1]=Check>>8;
+
+    return Hdr;
+}
+
+uint32_t ComTestFramer::GetFrameLen(void)
+{
+    return Frame.size();
+}
+
+ComTestChecker::ComTestChecker()
+{
+    Reset();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTestChecker::Setup
+ *
+ * SYNOPSIS:
+ *    bool ComTestChecker::Setup(const uint8_t *Pattern,uint32_t PatternLen);
+ *
+ * PARAMETERS:
+ *    Pattern [I] -- The pattern we expect in every frame
+ *    PatternLen [I] -- The number of bytes in 'Pattern'
+ *
+ * FUNCTION:
+ *    This function sets up the checker for a new test (and resets it).
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Out of memory
+ *
+ * SEE ALSO:
+ *    ComTestChecker::Process()
+ ******************************************************************************/
+bool ComTestChecker::Setup(const uint8_t *Pattern,uint32_t PatternLen)
+{
+    try
+    {
+        this->Pattern.assign(Pattern,Pattern+PatternLen);
+    }
+    catch(...)
+    {
+        return false;
+    }
+    Reset();
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTestChecker::Reset
+ *
+ * SYNOPSIS:
+ *    void ComTestChecker::Reset(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function clears the counters and starts hunting for a frame.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ComTestChecker::Setup()
+ ******************************************************************************/
+void ComTestChecker::Reset(void)
+{
+    State=e_ComTestRx_Hunt;
+    Pos=0;
+    ExpectedSeq=0;
+    HaveSeq=false;
+    FrameTimestamp=0;
+    memset(&Counters,0x00,sizeof(Counters));
+}
+
+const struct ComTestRxCounters &ComTestChecker::GetCounters(void)
+{
+    return Counters;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTestChecker::Process
+ *
+ * SYNOPSIS:
+ *    void ComTestChecker::Process(const uint8_t *Data,int Bytes,
+ *              uint64_t Now);
+ *
+ * PARAMETERS:
+ *    Data [I] -- The bytes that came in
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *    Now [I] -- The time these bytes came in (GetElapsedTime_ns())
+ *
+ * FUNCTION:
+ *    This function runs incoming bytes through the checker.  This is a
+ *    fixed amount of work per byte.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ComTestChecker::GetCounters()
+ ******************************************************************************/
+void ComTestChecker::Process(const uint8_t *Data,int Bytes,uint64_t Now)
+{
+    const uint8_t *p;
+    const uint8_t *End;
+    uint32_t Chunk;
+    uint32_t r;
+    uint8_t Diff;
+
+    Counters.BytesRx+=Bytes;
+
+    p=Data;
+    End=Data+Bytes;
+    while(p<End)
+    {
+        switch(State)
+        {
+            case e_ComTestRx_Hunt:
+                if(*p==COMTEST_FRAME_SYNC0)
+                    State=e_ComTestRx_Sync1;
+                else
+                    Counters.SkippedBytes++;
+                p++;
+            break;
+            case e_ComTestRx_Sync1:
+                if(*p==COMTEST_FRAME_SYNC1)
+                {
+                    HeaderBuff[0]=COMTEST_FRAME_SYNC0;
+                    HeaderBuff[1]=COMTEST_FRAME_SYNC1;
+                    Pos=2;
+                    State=e_ComTestRx_Header;
+                }
+                else
+                {
+                    /* Throw away the SYNC0, this might be a new one */
+                    Counters.SkippedBytes++;
+                    if(*p!=COMTEST_FRAME_SYNC0)
+                    {
+                        Counters.SkippedBytes++;
+                        State=e_ComTestRx_Hunt;
+                    }
+                }
+                p++;
+            break;
+            case e_ComTestRx_Header:
+                HeaderBuff[Pos++]=*p++;
+                if(Pos>=COMTEST_FRAME_HEADER_SIZE)
+                    HeaderDone(Now);
+            break;
+            case e_ComTestRx_Payload:
+                /* Do as much of the pattern as we can in one go */
+                Chunk=Pattern.size()-Pos;
+                if(Chunk>(uint32_t)(End-p))
+                    Chunk=End-p;
+                for(r=0;r<Chunk;r++)
+                {
+                    Diff=p[r]^Pattern[Pos+r];
+                    if(Diff!=0)
+                    {
+                        Counters.ByteErrors++;
+                        Counters.BitErrors+=ComTest_BitsSet(Diff);
+                    }
+                }
+                Counters.BytesChecked+=Chunk;
+                Pos+=Chunk;
+                p+=Chunk;
+                if(Pos>=Pattern.size())
+                    FrameDone(Now);
+            break;
+            case e_ComTestRxMAX:
+            default:
+                State=e_ComTestRx_Hunt;
+            break;
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTestChecker::HeaderDone
+ *
+ * SYNOPSIS:
+ *    void ComTestChecker::HeaderDone(uint64_t Now);
+ *
+ * PARAMETERS:
+ *    Now [I] -- The current time
+ *
+ * FUNCTION:
+ *    This function is called when we have a full header.  If the check is
+ *    good we move on to the pattern, if not we go back to hunting.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ComTestChecker::Process()
+ ******************************************************************************/
+void ComTestChecker::HeaderDone(uint64_t Now)
+{
+    uint16_t Check;
+    uint32_t Seq;
+    int r;
+
+    Check=HeaderBuff[COMTEST_HDR_CHECK]|(HeaderBuff[COMTEST_HDR_CHECK+1]<<8);
+    if(Check!=ComTest_HeaderCheck(HeaderBuff))
+    {
+        Counters.BadFrames++;
+        Counters.SkippedBytes+=COMTEST_FRAME_HEADER_SIZE;
+        State=e_ComTestRx_Hunt;
+        return;
+    }
+
+    Seq=0;
+    for(r=0;r<4;r++)
+        Seq|=(uint32_t)HeaderBuff[COMTEST_HDR_SEQ+r]<<(r*8);
+    FrameTimestamp=0;
+    for(r=0;r<8;r++)
+        FrameTimestamp|=(uint64_t)HeaderBuff[COMTEST_HDR_TIME+r]<<(r*8);
+
+    /* Anything we skipped over is lost (going backwards is a restart) */
+    if(HaveSeq && Seq>ExpectedSeq)
+        Counters.PacketsLost+=Seq-ExpectedSeq;
+    else if(!HaveSeq)
+        Counters.PacketsLost+=Seq;
+    ExpectedSeq=Seq+1;
+    HaveSeq=true;
+
+    Pos=0;
+    State=e_ComTestRx_Payload;
+    if(Pattern.empty())
+        FrameDone(Now);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ComTestChecker::FrameDone
+ *
+ * SYNOPSIS:
+ *    void ComTestChecker::FrameDone(uint64_t Now);
+ *
+ * PARAMETERS:
+ *    Now [I] -- The current time
+ *
+ * FUNCTION:
+ *    This function is called when we have the full frame.  It counts it
+ *    and adds its latency to the histogram.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ComTestChecker::Process()
+ ******************************************************************************/
+void ComTestChecker::FrameDone(uint64_t Now)
+{
+    uint64_t Latency;
+    uint64_t us;
+    int Bucket;
+
+    Latency=0;
+    if(Now>FrameTimestamp)
+        Latency=Now-FrameTimestamp;
+
+    if(Counters.PacketsRx==0 || Latency<Counters.LatencyMin_ns)
+        Counters.LatencyMin_ns=Latency;
+    if(Latency>Counters.LatencyMax_ns)
+        Counters.LatencyMax_ns=Latency;
+    Counters.LatencyTotal_ns+=Latency;
+
+    us=Latency/1000;
+    Bucket=0;
+    while(us>1 && Bucket<COMTEST_LATENCY_BUCKETS-1)
+    {
+        us>>=1;
+        Bucket++;
+    }
+    Counters.LatencyHist[Bucket]++;
+
+    Counters.PacketsRx++;
+    Pos=0;
+    State=e_ComTestRx_Hunt;
+}
@@ -0,0 +1,120 @@
+/*******************************************************************************
+ * FILENAME: ComTestFrames.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the frame builder and checker used by the com test in it.
+ *
+ *    Every com test packet is a small header (sync word, sequence number,
+ *    send time and a check) followed by the test pattern.  Because the
+ *    header marks where a packet starts, the checker can get back in sync
+ *    by hunting for the next header, which is a fixed amount of work per
+ *    byte no matter how long the pattern is.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __COMTESTFRAMES_H_
+#define __COMTESTFRAMES_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include <stdint.h>
+#include <vector>
+
+/***  DEFINES                          ***/
+#define COMTEST_FRAME_SYNC0                 0xC5
+#define COMTEST_FRAME_SYNC1                 0x3A
+#define COMTEST_FRAME_HEADER_SIZE           16      // Sync(2) Seq(4) Time(8) Check(2)
+#define COMTEST_LATENCY_BUCKETS             24      // Bucket n is [2^n,2^(n+1)) us (0 is <2us)
+
+/***  MACROS                           ***/
+
+/***  TYPE DEFINITIONS                 ***/
+typedef enum
+{
+    e_ComTestRx_Hunt,                   // Looking for SYNC0
+    e_ComTestRx_Sync1,                  // Got SYNC0, need SYNC1
+    e_ComTestRx_Header,
+    e_ComTestRx_Payload,
+    e_ComTestRxMAX
+} e_ComTestRxStateType;
+
+struct ComTestRxCounters
+{
+    uint64_t PacketsRx;
+    uint64_t PacketsLost;               // Gaps in the sequence numbers
+    uint64_t BadFrames;                 // Headers that failed the check
+    uint64_t BytesRx;
+    uint64_t BytesChecked;              // Pattern bytes compared
+    uint64_t ByteErrors;
+    uint64_t BitErrors;
+    uint64_t SkippedBytes;              // Thrown away while hunting for a header
+    uint64_t LatencyMin_ns;
+    uint64_t LatencyMax_ns;
+    uint64_t LatencyTotal_ns;
+    uint64_t LatencyHist[COMTEST_LATENCY_BUCKETS];
+};
+
+/***  CLASS DEFINITIONS                ***/
+class ComTestFramer
+{
+    public:
+        bool Setup(const uint8_t *Pattern,uint32_t PatternLen);
+        const uint8_t *BuildFrame(uint32_t Seq,uint64_t Timestamp);
+        uint32_t GetFrameLen(void);
+
+    private:
+        std::vector<uint8_t> Frame;
+};
+
+class ComTestChecker
+{
+    public:
+        ComTestChecker();
+        bool Setup(const uint8_t *Pattern,uint32_t PatternLen);
+        void Reset(void);
+        void Process(const uint8_t *Data,int Bytes,uint64_t Now);
+        const struct ComTestRxCounters &GetCounters(void);
+
+    private:
+        std::vector<uint8_t> Pattern;
+        e_ComTestRxStateType State;
+        uint8_t HeaderBuff[COMTEST_FRAME_HEADER_SIZE];
+        uint32_t Pos;
+        uint32_t ExpectedSeq;
+        bool HaveSeq;
+        uint64_t FrameTimestamp;
+        struct ComTestRxCounters Counters;
+
+        void HeaderDone(uint64_t Now);
+        void FrameDone(uint64_t Now);
+};
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+void ComTest_FillPRBS(uint8_t *Buff,uint32_t Len,int Order);
+void ComTest_AddCounters(struct ComTestRxCounters &Total,
+        const struct ComTestRxCounters &Add);
+
+#endif   /* end of "#ifndef __COMTESTFRAMES_H_" */
@@ -0,0 +1,1002 @@
+/*******************************************************************************
+ * FILENAME: PieceTable.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has a piece table in it.  The bytes are never moved once
+ *    they are added, instead a tree of "pieces" (runs of bytes in the store,
+ *    or runs of a fill value) is kept in order.  The tree is a treap that
+ *    keeps the number of bytes under each node so finding an offset,
+ *    inserting, deleting, and filling are all O(log n).
+ *
+ *    Nodes are never changed once they are shared (they are ref counted)
+ *    so an undo point is just a ref to an old root.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "PieceTable.h"
+#include <string.h>
+
+/*** DEFINES                  ***/
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct PieceTableNode
+{
+    struct PieceTableNode *Left;
+    struct PieceTableNode *Right;
+    uint32_t Priority;
+    unsigned int RefCount;
+    int Bytes;                  // The bytes in this node and all it's children
+    uint32_t Start;             // Offset into 'Store' (not used for fills)
+    int Len;                    // The number of bytes in this piece
+    bool IsFill;                // This piece is 'Len' copies of 'Value'
+    uint8_t Value;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+static inline int PT_Bytes(struct PieceTableNode *Node);
+static inline struct PieceTableNode *PT_Ref(struct PieceTableNode *Node);
+static void PT_Unref(struct PieceTableNode *Node);
+
+/*** VARIABLE DEFINITIONS     ***/
+
+static inline int PT_Bytes(struct PieceTableNode *Node)
+{
+    if(Node==NULL)
+        return 0;
+    return Node->Bytes;
+}
+
+static inline struct PieceTableNode *PT_Ref(struct PieceTableNode *Node)
+{
+    if(Node!=NULL)
+        Node->RefCount++;
+    return Node;
+}
+
+static void PT_Unref(struct PieceTableNode *Node)
+{
+    if(Node==NULL)
+        return;
+
+    Node->RefCount--;
+    if(Node->RefCount>0)
+        return;
+
+    PT_Unref(Node->Left);
+    PT_Unref(Node->Right);
+    delete Node;
+}
+
+PieceTable::PieceTable()
+{
+    Root=NULL;
+    RandSeed=0x2545F491;
+}
+
+PieceTable::~PieceTable()
+{
+    Clear();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Load
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::Load(const uint8_t *Data,int Bytes);
+ *
+ * PARAMETERS:
+ *    Data [I] -- The bytes to start with
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function throws away everything (including the undo) and sets
+ *    the table to a copy of 'Data'.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Out of memory.  The table is empty.
+ *
+ * SEE ALSO:
+ *    PieceTable::Clear()
+ ******************************************************************************/
+bool PieceTable::Load(const uint8_t *Data,int Bytes)
+{
+    Clear();
+
+    if(Bytes<=0)
+        return true;
+
+    try
+    {
+        Store.assign(Data,Data+Bytes);
+        Root=AllocNode(0,Bytes,false,0,NextPriority(),NULL,NULL);
+    }
+    catch(...)
+    {
+        Clear();
+        return false;
+    }
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Clear
+ *
+ * SYNOPSIS:
+ *    void PieceTable::Clear(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function empties the table and the undo / redo lists.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PieceTable::Load()
+ ******************************************************************************/
+void PieceTable::Clear(void)
+{
+    PT_Unref(Root);
+    Root=NULL;
+    FreeUndoList(UndoList);
+    FreeUndoList(RedoList);
+    FreeUndoList(HeldRedoList);
+    Store.clear();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::GetSize
+ *
+ * SYNOPSIS:
+ *    int PieceTable::GetSize(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the number of bytes in the table.
+ *
+ * RETURNS:
+ *    The number of bytes
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+int PieceTable::GetSize(void)
+{
+    return PT_Bytes(Root);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Insert
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::Insert(int Offset,const uint8_t *Data,int Bytes);
+ *
+ * PARAMETERS:
+ *    Offset [I] -- Where to insert the bytes (0 - GetSize())
+ *    Data [I] -- The bytes to insert
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function inserts bytes into the table.  Everything after 'Offset'
+ *    moves up.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Bad offset or out of memory.  Nothing was changed.
+ *
+ * SEE ALSO:
+ *    PieceTable::InsertFill(), PieceTable::Replace()
+ ******************************************************************************/
+bool PieceTable::Insert(int Offset,const uint8_t *Data,int Bytes)
+{
+    uint32_t Start;
+
+    if(Offset<0 || Offset>PT_Bytes(Root) || Bytes<0)
+        return false;
+    if(Bytes==0)
+        return true;
+
+    try
+    {
+        Start=Store.size();
+        Store.insert(Store.end(),Data,Data+Bytes);
+    }
+    catch(...)
+    {
+        return false;
+    }
+
+    return InsertPiece(Offset,Start,Bytes,false,0);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::InsertFill
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::InsertFill(int Offset,uint8_t Value,int Bytes);
+ *
+ * PARAMETERS:
+ *    Offset [I] -- Where to insert the bytes (0 - GetSize())
+ *    Value [I] -- The value to insert
+ *    Bytes [I] -- The number of copies of 'Value' to insert
+ *
+ * FUNCTION:
+ *    This function inserts a run of the same value.  The run is kept as
+ *    one piece, so this doesn't matter how big 'Bytes' is.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Bad offset or out of memory.  Nothing was changed.
+ *
+ * SEE ALSO:
+ *    PieceTable::Insert(), PieceTable::Fill()
+ ******************************************************************************/
+bool PieceTable::InsertFill(int Offset,uint8_t Value,int Bytes)
+{
+    if(Offset<0 || Offset>PT_Bytes(Root) || Bytes<0)
+        return false;
+    if(Bytes==0)
+        return true;
+
+    return InsertPiece(Offset,0,Bytes,true,Value);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Replace
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::Replace(int Offset,const uint8_t *Data,int Bytes);
+ *
+ * PARAMETERS:
+ *    Offset [I] -- Where to start replacing bytes (0 - GetSize())
+ *    Data [I] -- The new bytes
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function writes over the bytes at 'Offset'.  If this goes past
+ *    the end then the table grows.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Bad offset or out of memory.
+ *
+ * SEE ALSO:
+ *    PieceTable::Fill()
+ ******************************************************************************/
+bool PieceTable::Replace(int Offset,const uint8_t *Data,int Bytes)
+{
+    int Overlap;
+
+    if(Offset<0 || Offset>PT_Bytes(Root) || Bytes<0)
+        return false;
+
+    Overlap=PT_Bytes(Root)-Offset;
+    if(Overlap>Bytes)
+        Overlap=Bytes;
+
+    if(!Delete(Offset,Overlap))
+        return false;
+
+    return Insert(Offset,Data,Bytes);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Fill
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::Fill(int Offset,uint8_t Value,int Bytes);
+ *
+ * PARAMETERS:
+ *    Offset [I] -- Where to start filling (0 - GetSize())
+ *    Value [I] -- The value to fill with
+ *    Bytes [I] -- The number of bytes to fill
+ *
+ * FUNCTION:
+ *    This function sets a number of bytes to the same value (it replaces
+ *    them).  If this goes past the end then the table grows.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Bad offset or out of memory.
+ *
+ * SEE ALSO:
+ *    PieceTable::Replace()
+ ******************************************************************************/
+bool PieceTable::Fill(int Offset,uint8_t Value,int Bytes)
+{
+    int Overlap;
+
+    if(Offset<0 || Offset>PT_Bytes(Root) || Bytes<0)
+        return false;
+
+    Overlap=PT_Bytes(Root)-Offset;
+    if(Overlap>Bytes)
+        Overlap=Bytes;
+
+    if(!Delete(Offset,Overlap))
+        return false;
+
+    return InsertFill(Offset,Value,Bytes);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Delete
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::Delete(int Offset,int Bytes);
+ *
+ * PARAMETERS:
+ *    Offset [I] -- The first byte to delete
+ *    Bytes [I] -- The number of bytes to delete.  This is clipped to the
+ *                 end of the table.
+ *
+ * FUNCTION:
+ *    This function removes bytes from the table.  Everything after them
+ *    moves down.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Bad offset or out of memory.  Nothing was changed.
+ *
+ * SEE ALSO:
+ *    PieceTable::Insert()
+ ******************************************************************************/
+bool PieceTable::Delete(int Offset,int Bytes)
+{
+    struct PieceTableNode *Left;
+    struct PieceTableNode *Rest;
+    struct PieceTableNode *Middle;
+    struct PieceTableNode *Right;
+    struct PieceTableNode *NewRoot;
+
+    if(Offset<0 || Offset>PT_Bytes(Root) || Bytes<0)
+        return false;
+    if(Offset+Bytes>PT_Bytes(Root))
+        Bytes=PT_Bytes(Root)-Offset;
+    if(Bytes==0)
+        return true;
+
+    try
+    {
+        Split(Root,Offset,&Left,&Rest);
+        Split(Rest,Bytes,&Middle,&Right);
+        PT_Unref(Rest);
+        PT_Unref(Middle);
+        NewRoot=Merge(Left,Right);
+    }
+    catch(...)
+    {
+        return false;
+    }
+
+    PT_Unref(Root);
+    Root=NewRoot;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Resize
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::Resize(int NewSize);
+ *
+ * PARAMETERS:
+ *    NewSize [I] -- The new number of bytes
+ *
+ * FUNCTION:
+ *    This function cuts the end off the table or adds 0's to the end to
+ *    make it 'NewSize' bytes.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Out of memory.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+bool PieceTable::Resize(int NewSize)
+{
+    int Size;
+
+    if(NewSize<0)
+        return false;
+
+    Size=PT_Bytes(Root);
+    if(NewSize<Size)
+        return Delete(NewSize,Size-NewSize);
+    return InsertFill(Size,0x00,NewSize-Size);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Read
+ *
+ * SYNOPSIS:
+ *    int PieceTable::Read(int Offset,uint8_t *Dest,int Bytes);
+ *
+ * PARAMETERS:
+ *    Offset [I] -- The first byte to read
+ *    Dest [O] -- Where to copy the bytes to
+ *    Bytes [I] -- The number of bytes to read
+ *
+ * FUNCTION:
+ *    This function copies bytes out of the table into a flat buffer.  To get
+ *    the whole thing use Read(0,Dest,GetSize()).
+ *
+ * RETURNS:
+ *    The number of bytes copied.  This is less than 'Bytes' if we hit the
+ *    end of the table.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+int PieceTable::Read(int Offset,uint8_t *Dest,int Bytes)
+{
+    if(Offset<0 || Offset>=PT_Bytes(Root) || Bytes<=0)
+        return 0;
+
+    if(Offset+Bytes>PT_Bytes(Root))
+        Bytes=PT_Bytes(Root)-Offset;
+
+    ReadNode(Root,Offset,Dest,Bytes);
+
+    return Bytes;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::CheckPoint
+ *
+ * SYNOPSIS:
+ *    void PieceTable::CheckPoint(int UserValue);
+ *
+ * PARAMETERS:
+ *    UserValue [I] -- A value to give back when we undo to this point.  This
+ *                     is normally the cursor pos.
+ *
+ * FUNCTION:
+ *    This function saves the current state as an undo point.  Call it
+ *    before making a change.  This clears the redo list.
+ *
+ *    The redo list is held until the next CheckPoint(), Undo() or Redo()
+ *    so that CancelCheckPoint() can put it back.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PieceTable::Undo(), PieceTable::CancelCheckPoint()
+ ******************************************************************************/
+void PieceTable::CheckPoint(int UserValue)
+{
+    struct PieceTableUndo Entry;
+
+    try
+    {
+        Entry.Root=PT_Ref(Root);
+        Entry.UserValue=UserValue;
+        UndoList.push_back(Entry);
+    }
+    catch(...)
+    {
+        PT_Unref(Root);
+        return;
+    }
+
+    if(UndoList.size()>PIECETABLE_MAX_UNDO)
+    {
+        PT_Unref(UndoList.front().Root);
+        UndoList.erase(UndoList.begin());
+    }
+
+    FreeUndoList(HeldRedoList);
+    HeldRedoList.swap(RedoList);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::CancelCheckPoint
+ *
+ * SYNOPSIS:
+ *    void PieceTable::CancelCheckPoint(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function puts things back to the last check point and forgets
+ *    it (it isn't added to the redo list).  This is for edits that where
+ *    started and then aborted.  The redo list from before the check point
+ *    is put back.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PieceTable::CheckPoint()
+ ******************************************************************************/
+void PieceTable::CancelCheckPoint(void)
+{
+    if(UndoList.empty())
+        return;
+
+    PT_Unref(Root);
+    Root=UndoList.back().Root;
+    UndoList.pop_back();
+
+    FreeUndoList(RedoList);
+    RedoList.swap(HeldRedoList);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Undo
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::Undo(int &UserValue);
+ *
+ * PARAMETERS:
+ *    UserValue [I/O] -- The user value for the current state.  This is
+ *                       changed to the value given to the CheckPoint() we
+ *                       are going back to.
+ *
+ * FUNCTION:
+ *    This function goes back to the last check point.
+ *
+ * RETURNS:
+ *    true -- We undid something
+ *    false -- There was nothing to undo
+ *
+ * SEE ALSO:
+ *    PieceTable::Redo(), PieceTable::CheckPoint()
+ ******************************************************************************/
+bool PieceTable::Undo(int &UserValue)
+{
+    struct PieceTableUndo Entry;
+
+    if(UndoList.empty())
+        return false;
+
+    /* The last check point can't be canceled any more */
+    FreeUndoList(HeldRedoList);
+
+    try
+    {
+        Entry.Root=Root;
+        Entry.UserValue=UserValue;
+        RedoList.push_back(Entry);
+    }
+    catch(...)
+    {
+        return false;
+    }
+
+    Root=UndoList.back().Root;
+    UserValue=UndoList.back().UserValue;
+    UndoList.pop_back();
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Redo
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::Redo(int &UserValue);
+ *
+ * PARAMETERS:
+ *    UserValue [I/O] -- The user value for the current state.  This is
+ *                       changed to the value from before the Undo().
+ *
+ * FUNCTION:
+ *    This function puts back the last thing Undo() took away.
+ *
+ * RETURNS:
+ *    true -- We redid something
+ *    false -- There was nothing to redo
+ *
+ * SEE ALSO:
+ *    PieceTable::Undo()
+ ******************************************************************************/
+bool PieceTable::Redo(int &UserValue)
+{
+    struct PieceTableUndo Entry;
+
+    if(RedoList.empty())
+        return false;
+
+    FreeUndoList(HeldRedoList);
+
+    try
+    {
+        Entry.Root=Root;
+        Entry.UserValue=UserValue;
+        UndoList.push_back(Entry);
+    }
+    catch(...)
+    {
+        return false;
+    }
+
+    Root=RedoList.back().Root;
+    UserValue=RedoList.back().UserValue;
+    RedoList.pop_back();
+
+    return true;
+}
+
+bool PieceTable::CanUndo(void)
+{
+    return !UndoList.empty();
+}
+
+bool PieceTable::CanRedo(void)
+{
+    return !RedoList.empty();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::AllocNode
+ *
+ * SYNOPSIS:
+ *    struct PieceTableNode *PieceTable::AllocNode(uint32_t Start,int Len,
+ *              bool IsFill,uint8_t Value,uint32_t Priority,
+ *              struct PieceTableNode *Left,struct PieceTableNode *Right);
+ *
+ * PARAMETERS:
+ *    Start [I] -- The offset into 'Store' for this piece
+ *    Len [I] -- The number of bytes in this piece
+ *    IsFill [I] -- Is this a run of 'Value' instead of bytes from 'Store'
+ *    Value [I] -- The fill value
+ *    Priority [I] -- The treap priority
+ *    Left [I] -- The left child.  We take over the ref.
+ *    Right [I] -- The right child.  We take over the ref.
+ *
+ * FUNCTION:
+ *    This function allocates a new node with a ref count of 1.
+ *
+ * RETURNS:
+ *    The new node.
+ *
+ * NOTES:
+ *    Throws if out of memory.
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+struct PieceTableNode *PieceTable::AllocNode(uint32_t Start,int Len,
+        bool IsFill,uint8_t Value,uint32_t Priority,
+        struct PieceTableNode *Left,struct PieceTableNode *Right)
+{
+    struct PieceTableNode *Node;
+
+    Node=new struct PieceTableNode;
+    Node->Left=Left;
+    Node->Right=Right;
+    Node->Priority=Priority;
+    Node->RefCount=1;
+    Node->Start=Start;
+    Node->Len=Len;
+    Node->IsFill=IsFill;
+    Node->Value=Value;
+    Node->Bytes=PT_Bytes(Left)+Len+PT_Bytes(Right);
+
+    return Node;
+}
+
+uint32_t PieceTable::NextPriority(void)
+{
+    /* xorshift32 */
+    RandSeed^=RandSeed<<13;
+    RandSeed^=RandSeed>>17;
+    RandSeed^=RandSeed<<5;
+    return RandSeed;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Split
+ *
+ * SYNOPSIS:
+ *    void PieceTable::Split(struct PieceTableNode *Node,int Offset,
+ *              struct PieceTableNode **Left,struct PieceTableNode **Right);
+ *
+ * PARAMETERS:
+ *    Node [I] -- The tree to split.  This is not changed (and we don't
+ *                take the ref).
+ *    Offset [I] -- The byte offset to split at
+ *    Left [O] -- The tree with bytes before 'Offset'.
+ *    Right [O] -- The tree with the bytes from 'Offset' on.
+ *
+ * FUNCTION:
+ *    This function splits a tree in 2 at a byte offset.  If the offset is
+ *    in the middle of a piece the piece is cut in 2.  Only the nodes on the
+ *    path to 'Offset' are copied, the rest are shared.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PieceTable::Merge()
+ ******************************************************************************/
+void PieceTable::Split(struct PieceTableNode *Node,int Offset,
+        struct PieceTableNode **Left,struct PieceTableNode **Right)
+{
+    struct PieceTableNode *Tmp;
+    int LeftBytes;
+    int InPiece;
+
+    if(Node==NULL)
+    {
+        *Left=NULL;
+        *Right=NULL;
+        return;
+    }
+    if(Offset<=0)
+    {
+        *Left=NULL;
+        *Right=PT_Ref(Node);
+        return;
+    }
+    if(Offset>=Node->Bytes)
+    {
+        *Left=PT_Ref(Node);
+        *Right=NULL;
+        return;
+    }
+
+    LeftBytes=PT_Bytes(Node->Left);
+    if(Offset<=LeftBytes)
+    {
+        Split(Node->Left,Offset,Left,&Tmp);
+        *Right=AllocNode(Node->Start,Node->Len,Node->IsFill,Node->Value,
+                Node->Priority,Tmp,PT_Ref(Node->Right));
+    }
+    else if(Offset>=LeftBytes+Node->Len)
+    {
+        Split(Node->Right,Offset-LeftBytes-Node->Len,&Tmp,Right);
+        *Left=AllocNode(Node->Start,Node->Len,Node->IsFill,Node->Value,
+                Node->Priority,PT_Ref(Node->Left),Tmp);
+    }
+    else
+    {
+        /* It's inside this piece, cut it in 2 */
+        InPiece=Offset-LeftBytes;
+        *Left=AllocNode(Node->Start,InPiece,Node->IsFill,Node->Value,
+                Node->Priority,PT_Ref(Node->Left),NULL);
+        *Right=AllocNode(Node->IsFill?0:Node->Start+InPiece,
+                Node->Len-InPiece,Node->IsFill,Node->Value,Node->Priority,
+                NULL,PT_Ref(Node->Right));
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::Merge
+ *
+ * SYNOPSIS:
+ *    struct PieceTableNode *PieceTable::Merge(struct PieceTableNode *Left,
+ *              struct PieceTableNode *Right);
+ *
+ * PARAMETERS:
+ *    Left [I] -- The tree that goes first.  We take over the ref.
+ *    Right [I] -- The tree that goes after 'Left'.  We take over the ref.
+ *
+ * FUNCTION:
+ *    This function joins 2 trees.  Nodes that aren't shared with anything
+ *    else (undo) are changed in place, the rest are copied.
+ *
+ * RETURNS:
+ *    The new tree.
+ *
+ * SEE ALSO:
+ *    PieceTable::Split()
+ ******************************************************************************/
+struct PieceTableNode *PieceTable::Merge(struct PieceTableNode *Left,
+        struct PieceTableNode *Right)
+{
+    struct PieceTableNode *NewNode;
+
+    if(Left==NULL)
+        return Right;
+    if(Right==NULL)
+        return Left;
+
+    if(Left->Priority>Right->Priority)
+    {
+        if(Left->RefCount==1)
+        {
+            Left->Right=Merge(Left->Right,Right);
+            Left->Bytes=PT_Bytes(Left->Left)+Left->Len+PT_Bytes(Left->Right);
+            return Left;
+        }
+        NewNode=AllocNode(Left->Start,Left->Len,Left->IsFill,Left->Value,
+                Left->Priority,PT_Ref(Left->Left),NULL);
+        NewNode->Right=Merge(PT_Ref(Left->Right),Right);
+        NewNode->Bytes+=PT_Bytes(NewNode->Right);
+        PT_Unref(Left);
+        return NewNode;
+    }
+
+    if(Right->RefCount==1)
+    {
+        Right->Left=Merge(Left,Right->Left);
+        Right->Bytes=PT_Bytes(Right->Left)+Right->Len+PT_Bytes(Right->Right);
+        return Right;
+    }
+    NewNode=AllocNode(Right->Start,Right->Len,Right->IsFill,Right->Value,
+            Right->Priority,NULL,PT_Ref(Right->Right));
+    NewNode->Left=Merge(Left,PT_Ref(Right->Left));
+    NewNode->Bytes+=PT_Bytes(NewNode->Left);
+    PT_Unref(Right);
+    return NewNode;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::ReadNode
+ *
+ * SYNOPSIS:
+ *    void PieceTable::ReadNode(struct PieceTableNode *Node,int Offset,
+ *              uint8_t *Dest,int Bytes);
+ *
+ * PARAMETERS:
+ *    Node [I] -- The tree to read from
+ *    Offset [I] -- The offset in this tree to start at
+ *    Dest [O] -- Where to copy the bytes to
+ *    Bytes [I] -- The number of bytes to copy.  This must fit in 'Node'.
+ *
+ * FUNCTION:
+ *    This is a helper for Read() that copies the bytes out of a tree.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    PieceTable::Read()
+ ******************************************************************************/
+void PieceTable::ReadNode(struct PieceTableNode *Node,int Offset,uint8_t *Dest,
+        int Bytes)
+{
+    int LeftBytes;
+    int InPiece;
+    int Chunk;
+
+    while(Node!=NULL && Bytes>0)
+    {
+        LeftBytes=PT_Bytes(Node->Left);
+        if(Offset<LeftBytes)
+        {
+            Chunk=LeftBytes-Offset;
+            if(Chunk>Bytes)
+                Chunk=Bytes;
+            ReadNode(Node->Left,Offset,Dest,Chunk);
+            Dest+=Chunk;
+            Bytes-=Chunk;
+            Offset=LeftBytes;
+        }
+        if(Bytes==0)
+            break;
+
+        if(Offset<LeftBytes+Node->Len)
+        {
+            InPiece=Offset-LeftBytes;
+            Chunk=Node->Len-InPiece;
+            if(Chunk>Bytes)
+                Chunk=Bytes;
+            if(Node->IsFill)
+                memset(Dest,Node->Value,Chunk);
+            else
+                memcpy(Dest,&Store[Node->Start+InPiece],Chunk);
+            Dest+=Chunk;
+            Bytes-=Chunk;
+            Offset+=Chunk;
+        }
+
+        /* The rest is on the right */
+        Offset-=LeftBytes+Node->Len;
+        Node=Node->Right;
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    PieceTable::InsertPiece
+ *
+ * SYNOPSIS:
+ *    bool PieceTable::InsertPiece(int Offset,uint32_t Start,int Len,
+ *              bool IsFill,uint8_t Value);
+ *
+ * PARAMETERS:
+ *    Offset [I] -- Where to insert the piece
+ *    Start [I] -- The offset in 'Store' of the bytes
+ *    Len [I] -- The number of bytes in the piece
+ *    IsFill [I] -- Is this a run of 'Value'
+ *    Value [I] -- The fill value
+ *
+ * FUNCTION:
+ *    This is a helper that splits the tree at 'Offset' and puts a new piece
+ *    in the middle.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- Out of memory.  Nothing was changed.
+ *
+ * SEE ALSO:
+ *    PieceTable::Insert(), PieceTable::InsertFill()
+ ******************************************************************************/
+bool PieceTable::InsertPiece(int Offset,uint32_t Start,int Len,bool IsFill,
+        uint8_t Value)
+{
+    struct PieceTableNode *Left;
+    struct PieceTableNode *Right;
+    struct PieceTableNode *Middle;
+    struct PieceTableNode *NewRoot;
+
+    try
+    {
+        Split(Root,Offset,&Left,&Right);
+        Middle=AllocNode(Start,Len,IsFill,Value,NextPriority(),NULL,NULL);
+        NewRoot=Merge(Merge(Left,Middle),Right);
+    }
+    catch(...)
+    {
+        return false;
+    }
+
+    PT_Unref(Root);
+    Root=NewRoot;
+
+    return true;
+}
+
+void PieceTable::FreeUndoList(t_PieceTableUndoType &List)
+{
+    t_PieceTableUndoType::iterator Entry;
+
+    for(Entry=List.begin();Entry!=List.end();Entry++)
+        PT_Unref(Entry->Root);
+    List.clear();
+}
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * FILENAME: PieceTable.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the def's for the piece table in it.  This is a byte
+ *    buffer that can have bytes inserted / deleted / filled anywhere in it
+ *    without having to move the rest of the buffer.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __PIECETABLE_H_
+#define __PIECETABLE_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include <stdint.h>
+#include <vector>
+
+/***  DEFINES                          ***/
+#define PIECETABLE_MAX_UNDO             1000
+
+/***  MACROS                           ***/
+
+/***  TYPE DEFINITIONS                 ***/
+struct PieceTableNode;
+
+struct PieceTableUndo
+{
+    struct PieceTableNode *Root;
+    int UserValue;
+};
+
+typedef std::vector<struct PieceTableUndo> t_PieceTableUndoType;
+
+/***  CLASS DEFINITIONS                ***/
+class PieceTable
+{
+    public:
+        PieceTable();
+        ~PieceTable();
+        bool Load(const uint8_t *Data,int Bytes);
+        void Clear(void);
+        int GetSize(void);
+        bool Insert(int Offset,const uint8_t *Data,int Bytes);
+        bool InsertFill(int Offset,uint8_t Value,int Bytes);
+        bool Replace(int Offset,const uint8_t *Data,int Bytes);
+        bool Fill(int Offset,uint8_t Value,int Bytes);
+        bool Delete(int Offset,int Bytes);
+        bool Resize(int NewSize);
+        int Read(int Offset,uint8_t *Dest,int Bytes);
+
+        /* Undo / Redo */
+        void CheckPoint(int UserValue);
+        void CancelCheckPoint(void);
+        bool Undo(int &UserValue);
+        bool Redo(int &UserValue);
+        bool CanUndo(void);
+        bool CanRedo(void);
+
+    private:
+        struct PieceTableNode *Root;
+        std::vector<uint8_t> Store;     // All the bytes ever added (only grows)
+        t_PieceTableUndoType UndoList;
+        t_PieceTableUndoType RedoList;
+        t_PieceTableUndoType HeldRedoList;  // Redo list from before the last CheckPoint()
+        uint32_t RandSeed;
+
+        struct PieceTableNode *AllocNode(uint32_t Start,int Len,bool IsFill,uint8_t Value,uint32_t Priority,struct PieceTableNode *Left,struct PieceTableNode *Right);
+        uint32_t NextPriority(void);
+        void Split(struct PieceTableNode *Node,int Offset,struct PieceTableNode **Left,struct PieceTableNode **Right);
+        struct PieceTableNode *Merge(struct PieceTableNode *Left,struct PieceTableNode *Right);
+        void ReadNode(struct PieceTableNode *Node,int Offset,uint8_t *Dest,int Bytes);
+        bool InsertPiece(int Offset,uint32_t Start,int Len,bool IsFill,uint8_t Value);
+        void FreeUndoList(t_PieceTableUndoType &List);
+};
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+
+#endif   /* end of "#ifndef __PIECETABLE_H_" */
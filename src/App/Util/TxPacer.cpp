@@ -0,0 +1,852 @@
+/*******************************************************************************
+ * FILENAME: TxPacer.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the transmit pacer in it.
+ *
+ *    Bytes to send are added to a ring buffer with Queue() (from the GUI
+ *    thread).  A send thread is started when there is something to send
+ *    and exits again when the ring is empty.  The thread works out when the
+ *    next byte (or line) is due as an absolute time and sleeps until then
+ *    with OS_SleepUntil_ns(), so the delays don't add up small errors and
+ *    can be much shorter than a GUI timer tick.
+ *
+ *    The thread only calls the write function, it never touches the GUI.
+ *    Everything it sent is copied into a second ring so the GUI thread can
+ *    pick it up with TakeSentBytes() and do the local echo, hex display,
+ *    capture and so on.
+ *
+ *    The rings grow when they need to and go back to their starting size
+ *    when they empty, so a long paste reuses the same memory instead of
+ *    growing the buffer until the paste is done.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "App/Util/TxPacer.h"
+#include "OS/OSTime.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*** DEFINES                  ***/
+#define TXPACER_QUIT_POLL_NS                20000000    // How often a long wait checks for quit
+#define TXPACER_BUSY_RETRY_NS               100000      // Wait before trying a busy driver again
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+
+/*** FUNCTION PROTOTYPES      ***/
+void TxPacer_SendThread(void *Arg);
+
+/*** VARIABLE DEFINITIONS     ***/
+
+/*******************************************************************************
+ * NAME:
+ *    ByteRing::ByteRing
+ *
+ * SYNOPSIS:
+ *    ByteRing::ByteRing();
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    Constructor.  The buffer isn't allocated until the first Write().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+ByteRing::ByteRing()
+{
+    Buffer=NULL;
+    Size=0;
+    Head=0;
+    Tail=0;
+}
+
+ByteRing::~ByteRing()
+{
+    free(Buffer);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteRing::Write
+ *
+ * SYNOPSIS:
+ *    bool ByteRing::Write(const uint8_t *Data,uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    Data [I] -- The bytes to add
+ *    Bytes [I] -- The number of bytes in 'Data'
+ *
+ * FUNCTION:
+ *    This function adds bytes to the end of the ring.  The ring is made
+ *    bigger if they don't fit.
+ *
+ * RETURNS:
+ *    true -- The bytes where added
+ *    false -- We couldn't make the ring big enough.  Nothing was added.
+ *
+ * SEE ALSO:
+ *    ByteRing::Read(), ByteRing::Peek()
+ ******************************************************************************/
+bool ByteRing::Write(const uint8_t *Data,uint32_t Bytes)
+{
+    uint32_t Pos;
+    uint32_t First;
+
+    if(Bytes==0)
+        return true;
+
+    if(Size-(Head-Tail)<Bytes)
+    {
+        if(!Grow(Head-Tail+Bytes))
+            return false;
+    }
+
+    Pos=Head&(Size-1);
+    First=Size-Pos;
+    if(First>Bytes)
+        First=Bytes;
+    memcpy(&Buffer[Pos],Data,First);
+    memcpy(Buffer,&Data[First],Bytes-First);
+    Head+=Bytes;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteRing::Peek
+ *
+ * SYNOPSIS:
+ *    uint32_t ByteRing::Peek(uint8_t *Buff,uint32_t MaxBytes);
+ *
+ * PARAMETERS:
+ *    Buff [O] -- Where to copy the bytes to
+ *    MaxBytes [I] -- The most bytes to copy
+ *
+ * FUNCTION:
+ *    This function copies bytes from the start of the ring without removing
+ *    them.  Use Consume() to remove them.
+ *
+ * RETURNS:
+ *    The number of bytes copied.
+ *
+ * SEE ALSO:
+ *    ByteRing::Consume(), ByteRing::Read()
+ ******************************************************************************/
+uint32_t ByteRing::Peek(uint8_t *Buff,uint32_t MaxBytes)
+{
+    uint32_t Bytes;
+    uint32_t Pos;
+    uint32_t First;
+
+    Bytes=Head-Tail;
+    if(Bytes>MaxBytes)
+        Bytes=MaxBytes;
+    if(Bytes==0)
+        return 0;
+
+    Pos=Tail&(Size-1);
+    First=Size-Pos;
+    if(First>Bytes)
+        First=Bytes;
+    memcpy(Buff,&Buffer[Pos],First);
+    memcpy(&Buff[First],Buffer,Bytes-First);
+
+    return Bytes;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteRing::Consume
+ *
+ * SYNOPSIS:
+ *    void ByteRing::Consume(uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    Bytes [I] -- The number of bytes to remove from the start of the ring
+ *
+ * FUNCTION:
+ *    This function throws away bytes from the start of the ring.  When the
+ *    ring empties it goes back to its starting size.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    ByteRing::Peek()
+ ******************************************************************************/
+void ByteRing::Consume(uint32_t Bytes)
+{
+    uint8_t *NewBuffer;
+
+    if(Bytes>Head-Tail)
+        Bytes=Head-Tail;
+    Tail+=Bytes;
+
+    if(Head==Tail)
+    {
+        Head=0;
+        Tail=0;
+        if(Size>BYTERING_MIN_SIZE)
+        {
+            NewBuffer=(uint8_t *)realloc(Buffer,BYTERING_MIN_SIZE);
+            if(NewBuffer!=NULL)
+            {
+                Buffer=NewBuffer;
+                Size=BYTERING_MIN_SIZE;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteRing::Read
+ *
+ * SYNOPSIS:
+ *    uint32_t ByteRing::Read(uint8_t *Buff,uint32_t MaxBytes);
+ *
+ * PARAMETERS:
+ *    Buff [O] -- Where to copy the bytes to
+ *    MaxBytes [I] -- The most bytes to copy
+ *
+ * FUNCTION:
+ *    This function copies bytes from the start of the ring and removes them.
+ *
+ * RETURNS:
+ *    The number of bytes copied.
+ *
+ * SEE ALSO:
+ *    ByteRing::Peek(), ByteRing::Write()
+ ******************************************************************************/
+uint32_t ByteRing::Read(uint8_t *Buff,uint32_t MaxBytes)
+{
+    uint32_t Bytes;
+
+    Bytes=Peek(Buff,MaxBytes);
+    Consume(Bytes);
+
+    return Bytes;
+}
+
+uint32_t ByteRing::Used(void)
+{
+    return Head-Tail;
+}
+
+void ByteRing::Clear(void)
+{
+    Consume(Head-Tail);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ByteRing::Grow
+ *
+ * SYNOPSIS:
+ *    bool ByteRing::Grow(uint32_t Needed);
+ *
+ * PARAMETERS:
+ *    Needed [I] -- The number of bytes the ring has to be able to hold
+ *
+ * FUNCTION:
+ *    This function makes the ring bigger (doubling it until it's big
+ *    enough).  The bytes in the ring are moved to the start of the new
+ *    buffer.
+ *
+ * RETURNS:
+ *    true -- The ring is now at least 'Needed' bytes
+ *    false -- Out of memory (the ring is unchanged)
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+bool ByteRing::Grow(uint32_t Needed)
+{
+    uint8_t *NewBuffer;
+    uint32_t NewSize;
+    uint32_t Bytes;
+
+    NewSize=Size;
+    if(NewSize<BYTERING_MIN_SIZE)
+        NewSize=BYTERING_MIN_SIZE;
+    while(NewSize<Needed)
+    {
+        if(NewSize>=0x80000000)
+            return false;
+        NewSize*=2;
+    }
+
+    NewBuffer=(uint8_t *)malloc(NewSize);
+    if(NewBuffer==NULL)
+        return false;
+
+    Bytes=Peek(NewBuffer,Head-Tail);
+    free(Buffer);
+    Buffer=NewBuffer;
+    Size=NewSize;
+    Tail=0;
+    Head=Bytes;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer_SendThread
+ *
+ * SYNOPSIS:
+ *    void TxPacer_SendThread(void *Arg);
+ *
+ * PARAMETERS:
+ *    Arg [I] -- The pacer (class TxPacer *)
+ *
+ * FUNCTION:
+ *    This is the thread entry point for the pacer.  It just calls the
+ *    SendThread() function.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TxPacer::SendThread()
+ ******************************************************************************/
+void TxPacer_SendThread(void *Arg)
+{
+    class TxPacer *Pacer=(class TxPacer *)Arg;
+
+    Pacer->SendThread();
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::TxPacer
+ *
+ * SYNOPSIS:
+ *    TxPacer::TxPacer();
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    Constructor.  You need to call Init() before using the pacer.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TxPacer::Init()
+ ******************************************************************************/
+TxPacer::TxPacer()
+{
+    Lock=NULL;
+    Thread=NULL;
+    WriteFn=NULL;
+    WriteUserData=0;
+    RequestQuit=false;
+    ThreadRunning=false;
+    ByteDelay_us=0;
+    LineDelay_us=0;
+    NextSend_ns=0;
+    Error=e_TxPacerWrite_Sent;
+}
+
+TxPacer::~TxPacer()
+{
+    Stop();
+    if(Lock!=NULL)
+        FreeMutex(Lock);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::Init
+ *
+ * SYNOPSIS:
+ *    bool TxPacer::Init(t_TxPacerWriteFn WriteFn,uintptr_t UserData);
+ *
+ * PARAMETERS:
+ *    WriteFn [I] -- The function to send bytes with.  This is called from
+ *                   the send thread.  It looks like:
+ *          e_TxPacerWriteType WriteFn(uintptr_t UserData,const uint8_t *Data,
+ *                  uint32_t Bytes,uint32_t *Written);
+ *                   It sets 'Written' to how many bytes the driver took.
+ *                   When the driver only took some of them it returns
+ *                   e_TxPacerWrite_Busy and we send the rest later.
+ *    UserData [I] -- Passed to 'WriteFn'
+ *
+ * FUNCTION:
+ *    This function sets up the pacer.
+ *
+ * RETURNS:
+ *    true -- Ready to use
+ *    false -- Out of memory
+ *
+ * SEE ALSO:
+ *    TxPacer::Queue()
+ ******************************************************************************/
+bool TxPacer::Init(t_TxPacerWriteFn WriteFn,uintptr_t UserData)
+{
+    if(Lock==NULL)
+    {
+        Lock=AllocMutex();
+        if(Lock==NULL)
+            return false;
+    }
+
+    this->WriteFn=WriteFn;
+    WriteUserData=UserData;
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::SetDelays
+ *
+ * SYNOPSIS:
+ *    void TxPacer::SetDelays(uint32_t ByteDelay_us,uint32_t LineDelay_us);
+ *
+ * PARAMETERS:
+ *    ByteDelay_us [I] -- The delay between each byte in microseconds.  If
+ *                        this is 0 then bytes are sent in blocks.
+ *    LineDelay_us [I] -- The delay after a '\n' in microseconds.  If the
+ *                        byte delay is longer it is used instead.
+ *
+ * FUNCTION:
+ *    This function changes the delays.  This can be called while bytes
+ *    are being sent.  If both are 0 then anything that is queued goes out
+ *    as fast as the driver will take it.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+void TxPacer::SetDelays(uint32_t ByteDelay_us,uint32_t LineDelay_us)
+{
+    LockMutex(Lock);
+    this->ByteDelay_us=ByteDelay_us;
+    this->LineDelay_us=LineDelay_us;
+    UnLockMutex(Lock);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::Queue
+ *
+ * SYNOPSIS:
+ *    bool TxPacer::Queue(const uint8_t *Data,uint32_t Bytes);
+ *
+ * PARAMETERS:
+ *    Data [I] -- The bytes to send
+ *    Bytes [I] -- The number of bytes to send
+ *
+ * FUNCTION:
+ *    This function adds bytes to be sent.  The send thread is started if it
+ *    isn't already running.
+ *
+ * RETURNS:
+ *    true -- The bytes are queued
+ *    false -- Out of memory or we couldn't start the thread
+ *
+ * SEE ALSO:
+ *    TxPacer::TakeSentBytes()
+ ******************************************************************************/
+bool TxPacer::Queue(const uint8_t *Data,uint32_t Bytes)
+{
+    bool StartNewThread;
+
+    LockMutex(Lock);
+    if(!Pending.Write(Data,Bytes))
+    {
+        UnLockMutex(Lock);
+        return false;
+    }
+    StartNewThread=!ThreadRunning;
+    if(StartNewThread)
+        ThreadRunning=true;
+    UnLockMutex(Lock);
+
+    if(StartNewThread)
+    {
+        /* The last thread (if any) has already said it's done, it just needs
+           to be cleaned up */
+        if(Thread!=NULL)
+            Wait4ThreadToExit(Thread);
+
+        Thread=StartThread(false,TxPacer_SendThread,this);
+        if(Thread==NULL)
+        {
+            LockMutex(Lock);
+            ThreadRunning=false;
+            Pending.Clear();
+            UnLockMutex(Lock);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::GetQueuedBytes
+ *
+ * SYNOPSIS:
+ *    uint32_t TxPacer::GetQueuedBytes(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets how many bytes are waiting to be sent.
+ *
+ * RETURNS:
+ *    The number of bytes that haven't been sent yet.
+ *
+ * SEE ALSO:
+ *    TxPacer::IsBusy()
+ ******************************************************************************/
+uint32_t TxPacer::GetQueuedBytes(void)
+{
+    uint32_t Bytes;
+
+    LockMutex(Lock);
+    Bytes=Pending.Used();
+    UnLockMutex(Lock);
+
+    return Bytes;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::TakeSentBytes
+ *
+ * SYNOPSIS:
+ *    uint32_t TxPacer::TakeSentBytes(uint8_t *Buff,uint32_t MaxBytes);
+ *
+ * PARAMETERS:
+ *    Buff [O] -- Where to copy the sent bytes to
+ *    MaxBytes [I] -- The size of 'Buff'
+ *
+ * FUNCTION:
+ *    This function gets the bytes that the send thread has sent since the
+ *    last call.  Call this until it returns 0.
+ *
+ * RETURNS:
+ *    The number of bytes copied to 'Buff'
+ *
+ * SEE ALSO:
+ *    TxPacer::Queue()
+ ******************************************************************************/
+uint32_t TxPacer::TakeSentBytes(uint8_t *Buff,uint32_t MaxBytes)
+{
+    uint32_t Bytes;
+
+    LockMutex(Lock);
+    Bytes=Sent.Read(Buff,MaxBytes);
+    UnLockMutex(Lock);
+
+    return Bytes;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::TakeError
+ *
+ * SYNOPSIS:
+ *    e_TxPacerWriteType TxPacer::TakeError(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the last error the send thread had and clears it.
+ *    When the thread has an error it throws away everything that was
+ *    queued.
+ *
+ * RETURNS:
+ *    e_TxPacerWrite_Sent -- No error
+ *    e_TxPacerWrite_Error -- The driver had an error
+ *    e_TxPacerWrite_Disconnect -- The driver has been disconnected
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+e_TxPacerWriteType TxPacer::TakeError(void)
+{
+    e_TxPacerWriteType Ret;
+
+    LockMutex(Lock);
+    Ret=Error;
+    Error=e_TxPacerWrite_Sent;
+    UnLockMutex(Lock);
+
+    return Ret;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::IsBusy
+ *
+ * SYNOPSIS:
+ *    bool TxPacer::IsBusy(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function checks if the pacer has anything left to do.  This
+ *    includes sent bytes that haven't been picked up with TakeSentBytes().
+ *
+ * RETURNS:
+ *    true -- There are bytes to send or pick up
+ *    false -- The pacer is idle
+ *
+ * SEE ALSO:
+ *    TxPacer::GetQueuedBytes()
+ ******************************************************************************/
+bool TxPacer::IsBusy(void)
+{
+    bool Busy;
+
+    if(Lock==NULL)
+        return false;
+
+    LockMutex(Lock);
+    Busy=ThreadRunning || Pending.Used()>0 || Sent.Used()>0;
+    UnLockMutex(Lock);
+
+    return Busy;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::Stop
+ *
+ * SYNOPSIS:
+ *    void TxPacer::Stop(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function stops the send thread (waiting for it to exit) and
+ *    throws away anything that hasn't been sent.  Bytes that where sent can
+ *    still be picked up with TakeSentBytes().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *
+ ******************************************************************************/
+void TxPacer::Stop(void)
+{
+    if(Thread!=NULL)
+    {
+        RequestQuit=true;
+        Wait4ThreadToExit(Thread);
+        Thread=NULL;
+        RequestQuit=false;
+    }
+
+    if(Lock!=NULL)
+    {
+        LockMutex(Lock);
+        Pending.Clear();
+        ThreadRunning=false;
+        UnLockMutex(Lock);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::WaitUntil
+ *
+ * SYNOPSIS:
+ *    bool TxPacer::WaitUntil(uint64_t When_ns);
+ *
+ * PARAMETERS:
+ *    When_ns [I] -- The time to wait for (from GetElapsedTime_ns())
+ *
+ * FUNCTION:
+ *    This function sleeps the send thread until a time.  Long waits are
+ *    broken up so we notice if we have been asked to quit.
+ *
+ * RETURNS:
+ *    true -- It's time
+ *    false -- We have been asked to quit
+ *
+ * SEE ALSO:
+ *    OS_SleepUntil_ns()
+ ******************************************************************************/
+bool TxPacer::WaitUntil(uint64_t When_ns)
+{
+    uint64_t Now;
+
+    for(;;)
+    {
+        if(RequestQuit)
+            return false;
+
+        Now=GetElapsedTime_ns();
+        if(Now>=When_ns)
+            return true;
+
+        if(When_ns-Now>TXPACER_QUIT_POLL_NS)
+            OS_SleepUntil_ns(Now+TXPACER_QUIT_POLL_NS);
+        else
+            OS_SleepUntil_ns(When_ns);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TxPacer::SendThread
+ *
+ * SYNOPSIS:
+ *    void TxPacer::SendThread(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function is the send thread.  It takes a byte (or a line, or a
+ *    block) from the pending ring, waits until it's due, sends it, and
+ *    works out when the next one is due.  The thread ends when the ring is
+ *    empty (Queue() starts a new one).
+ *
+ *    The due time is always worked out from the last due time (not from
+ *    when we actually woke up) so the timing doesn't drift.  If we fall
+ *    more than one gap behind (or the thread was idle) we start again from
+ *    now instead of sending a burst to catch up.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TxPacer::Queue()
+ ******************************************************************************/
+void TxPacer::SendThread(void)
+{
+    uint8_t Chunk[TXPACER_MAX_CHUNK];
+    e_TxPacerWriteType WriteRet;
+    uint32_t Written;
+    uint32_t Len;
+    uint32_t r;
+    uint64_t Delay_ns;
+    uint64_t Gap_ns;
+    uint64_t SendAt;
+    uint64_t Now;
+
+    Gap_ns=0;
+    for(;;)
+    {
+        LockMutex(Lock);
+        Len=Pending.Peek(Chunk,sizeof(Chunk));
+        if(Len==0 || RequestQuit)
+        {
+            ThreadRunning=false;
+            UnLockMutex(Lock);
+            break;
+        }
+
+        if(ByteDelay_us>0)
+        {
+            /* Delay between bytes, so we only send 1 byte at a time */
+            Len=1;
+        }
+        else if(LineDelay_us>0)
+        {
+            /* Send up to (and including) the next new line */
+            for(r=0;r<Len;r++)
+                if(Chunk[r]=='\n')
+                    break;
+            if(r<Len)
+                Len=r+1;
+        }
+
+        Delay_ns=(uint64_t)ByteDelay_us*1000;
+        if(Chunk[Len-1]=='\n' && LineDelay_us>ByteDelay_us)
+            Delay_ns=(uint64_t)LineDelay_us*1000;
+        UnLockMutex(Lock);
+
+        /* Wait until it's this chunk's turn */
+        SendAt=NextSend_ns;
+        Now=GetElapsedTime_ns();
+        if(Now>SendAt+Gap_ns)
+            SendAt=Now;
+        if(!WaitUntil(SendAt))
+            continue;
+
+        Written=0;
+        WriteRet=WriteFn(WriteUserData,Chunk,Len,&Written);
+        switch(WriteRet)
+        {
+            case e_TxPacerWrite_Sent:
+                LockMutex(Lock);
+                Pending.Consume(Len);
+                Sent.Write(Chunk,Len);
+                UnLockMutex(Lock);
+
+                NextSend_ns=SendAt+Delay_ns;
+                Gap_ns=Delay_ns;
+            break;
+            case e_TxPacerWrite_Busy:
+                /* Keep what the driver did take and try the rest of the
+                   chunk again in a little bit */
+                if(Written>0)
+                {
+                    LockMutex(Lock);
+                    Pending.Consume(Written);
+                    Sent.Write(Chunk,Written);
+                    UnLockMutex(Lock);
+                }
+                NextSend_ns=SendAt+TXPACER_BUSY_RETRY_NS;
+                Gap_ns=TXPACER_BUSY_RETRY_NS;
+            break;
+            case e_TxPacerWrite_Error:
+            case e_TxPacerWrite_Disconnect:
+            case e_TxPacerWriteMAX:
+            default:
+                LockMutex(Lock);
+                Error=WriteRet;
+                Pending.Clear();
+                UnLockMutex(Lock);
+            break;
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ * FILENAME: TxPacer.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This file has the transmit pacer in it.  This sends queued bytes out
+ *    with a delay between bytes and / or after new lines from its own
+ *    thread so the timing doesn't depend on how busy the GUI is.
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __TXPACER_H_
+#define __TXPACER_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include "OS/Thread.h"
+#include <stdint.h>
+
+/***  DEFINES                          ***/
+#define BYTERING_MIN_SIZE                   4096    // Must be a power of 2
+#define TXPACER_MAX_CHUNK                   1024    // Most we send in one write
+
+/***  MACROS                           ***/
+
+/***  TYPE DEFINITIONS                 ***/
+typedef enum
+{
+    e_TxPacerWrite_Sent,
+    e_TxPacerWrite_Busy,                // Driver is full, send the rest soon
+    e_TxPacerWrite_Error,               // Drop what's queued
+    e_TxPacerWrite_Disconnect,          // Drop what's queued
+    e_TxPacerWriteMAX
+} e_TxPacerWriteType;
+
+typedef e_TxPacerWriteType (*t_TxPacerWriteFn)(uintptr_t UserData,
+        const uint8_t *Data,uint32_t Bytes,uint32_t *Written);
+
+/***  CLASS DEFINITIONS                ***/
+class ByteRing
+{
+    public:
+        ByteRing();
+        ~ByteRing();
+        bool Write(const uint8_t *Data,uint32_t Bytes);
+        uint32_t Read(uint8_t *Buff,uint32_t MaxBytes);
+        uint32_t Peek(uint8_t *Buff,uint32_t MaxBytes);
+        void Consume(uint32_t Bytes);
+        uint32_t Used(void);
+        void Clear(void);
+
+    private:
+        uint8_t *Buffer;
+        uint32_t Size;                  // Always a power of 2 (or 0)
+        uint32_t Head;                  // Free running write count
+        uint32_t Tail;                  // Free running read count
+
+        bool Grow(uint32_t Needed);
+};
+
+class TxPacer
+{
+    friend void TxPacer_SendThread(void *Arg);
+
+    public:
+        TxPacer();
+        ~TxPacer();
+        bool Init(t_TxPacerWriteFn WriteFn,uintptr_t UserData);
+        void SetDelays(uint32_t ByteDelay_us,uint32_t LineDelay_us);
+        bool Queue(const uint8_t *Data,uint32_t Bytes);
+        uint32_t GetQueuedBytes(void);
+        uint32_t TakeSentBytes(uint8_t *Buff,uint32_t MaxBytes);
+        e_TxPacerWriteType TakeError(void);
+        bool IsBusy(void);
+        void Stop(void);
+
+    private:
+        struct ThreadMutex *Lock;
+        struct ThreadHandle *Thread;
+        t_TxPacerWriteFn WriteFn;
+        uintptr_t WriteUserData;
+        volatile bool RequestQuit;
+        bool ThreadRunning;             // Only changed with 'Lock' held
+        uint32_t ByteDelay_us;
+        uint32_t LineDelay_us;
+        uint64_t NextSend_ns;
+        e_TxPacerWriteType Error;
+        class ByteRing Pending;         // Waiting to go out
+        class ByteRing Sent;            // Gone out, waiting for TakeSentBytes()
+
+        void SendThread(void);
+        bool WaitUntil(uint64_t When_ns);
+};
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+
+#endif   /* end of "#ifndef __TXPACER_H_" */
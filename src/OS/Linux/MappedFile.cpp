@@ -0,0 +1,228 @@
+/*******************************************************************************
+ * FILENAME: MappedFile.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    POSIX implementation using mmap().
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "OS/MappedFile.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+/*** DEFINES                  ***/
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct MappedFile
+{
+    void *Data;
+    uint64_t Size;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+
+/*** VARIABLE DEFINITIONS     ***/
+
+/*******************************************************************************
+ * NAME:
+ *    MapFile
+ *
+ * SYNOPSIS:
+ *    struct MappedFile *MapFile(const char *Filename);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to map
+ *
+ * FUNCTION:
+ *    This function maps a whole file into memory (read only).  The pages are
+ *    only read from the disk as they are touched so this is cheap even for
+ *    very big files.
+ *
+ *    A zero length file maps fine but GetMappedFileData() will return NULL.
+ *
+ * RETURNS:
+ *    A handle to the mapped file or NULL if there was an error.
+ *
+ * SEE ALSO:
+ *    UnMapFile(), GetMappedFileData(), GetMappedFileSize()
+ ******************************************************************************/
+struct MappedFile *MapFile(const char *Filename)
+{
+    struct MappedFile *NewMap;
+    struct stat FileInfo;
+    int fd;
+
+    fd=open(Filename,O_RDONLY);
+    if(fd<0)
+        return NULL;
+
+    NewMap=NULL;
+    try
+    {
+        if(fstat(fd,&FileInfo)!=0)
+            throw(0);
+
+        NewMap=new struct MappedFile;
+        NewMap->Data=NULL;
+        NewMap->Size=FileInfo.st_size;
+
+        /* Make sure it fits in our address space (32 bit builds) */
+        if((uint64_t)(size_t)NewMap->Size!=NewMap->Size)
+            throw(0);
+
+        if(NewMap->Size>0)
+        {
+            NewMap->Data=mmap(NULL,NewMap->Size,PROT_READ,MAP_SHARED,fd,0);
+            if(NewMap->Data==MAP_FAILED)
+            {
+                NewMap->Data=NULL;
+                throw(0);
+            }
+
+            /* We normally walk these files from the front to the back */
+            madvise(NewMap->Data,NewMap->Size,MADV_SEQUENTIAL);
+        }
+    }
+    catch(...)
+    {
+        if(NewMap!=NULL)
+            delete NewMap;
+        NewMap=NULL;
+    }
+
+    /* The mapping stays valid after the file is closed */
+    close(fd);
+
+    return NewMap;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    UnMapFile
+ *
+ * SYNOPSIS:
+ *    void UnMapFile(struct MappedFile *Map);
+ *
+ * PARAMETERS:
+ *    Map [I] -- The mapped file to free
+ *
+ * FUNCTION:
+ *    This function unmaps a file mapped with MapFile().  Any pointers
+ *    returned from GetMappedFileData() are no longer valid after this.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    MapFile()
+ ******************************************************************************/
+void UnMapFile(struct MappedFile *Map)
+{
+    if(Map->Data!=NULL)
+        munmap(Map->Data,Map->Size);
+    delete Map;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    GetMappedFileData
+ *
+ * SYNOPSIS:
+ *    const uint8_t *GetMappedFileData(struct MappedFile *Map);
+ *
+ * PARAMETERS:
+ *    Map [I] -- The mapped file to work on
+ *
+ * FUNCTION:
+ *    This function gets a pointer to the start of the file in memory.
+ *
+ * RETURNS:
+ *    A pointer to the first byte of the file or NULL if the file is empty.
+ *
+ * SEE ALSO:
+ *    MapFile(), GetMappedFileSize()
+ ******************************************************************************/
+const uint8_t *GetMappedFileData(struct MappedFile *Map)
+{
+    return (const uint8_t *)Map->Data;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    GetMappedFileSize
+ *
+ * SYNOPSIS:
+ *    uint64_t GetMappedFileSize(struct MappedFile *Map);
+ *
+ * PARAMETERS:
+ *    Map [I] -- The mapped file to work on
+ *
+ * FUNCTION:
+ *    This function gets the number of bytes that are mapped.  This is the
+ *    size of the file when it was mapped.
+ *
+ * RETURNS:
+ *    The number of bytes in the mapping.
+ *
+ * SEE ALSO:
+ *    MapFile(), GetMappedFileData()
+ ******************************************************************************/
+uint64_t GetMappedFileSize(struct MappedFile *Map)
+{
+    return Map->Size;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TruncateFile
+ *
+ * SYNOPSIS:
+ *    bool TruncateFile(const char *Filename,uint64_t Size);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to cut down
+ *    Size [I] -- The new size of the file in bytes
+ *
+ * FUNCTION:
+ *    This function cuts a file down to 'Size' bytes.  This works on files
+ *    bigger than 2G.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.
+ *
+ * SEE ALSO:
+ *    MapFile()
+ ******************************************************************************/
+bool TruncateFile(const char *Filename,uint64_t Size)
+{
+    return truncate(Filename,(off_t)Size)==0;
+}
@@ -35,6 +35,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <time.h>
+#include <errno.h>
 
 /*** DEFINES                  ***/
 
@@ -83,6 +84,35 @@ uint32_t GetElapsedTime_ms(void)
     return MillSec;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    GetElapsedTime_ns
+ *
+ * SYNOPSIS:
+ *    uint64_t GetElapsedTime_ns(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the number of nanoseconds from a monotonic high
+ *    resolution clock.  This is used for timing things (performance stats).
+ *
+ * RETURNS:
+ *    A count of nanoseconds.  Like GetElapsedTime_ms() the absolute value
+ *    is not meaningful, only the difference between two calls is.
+ *
+ * SEE ALSO:
+ *    GetElapsedTime_ms()
+ ******************************************************************************/
+uint64_t GetElapsedTime_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
 /*******************************************************************************
  * NAME:
  *    OS_Sleep
@@ -109,6 +139,42 @@ void OS_Sleep(unsigned int ms)
     usleep(ms*1000);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    OS_SleepUntil_ns
+ *
+ * SYNOPSIS:
+ *    void OS_SleepUntil_ns(uint64_t Deadline_ns);
+ *
+ * PARAMETERS:
+ *    Deadline_ns [I] -- The time to wake up at.  This is in the same time
+ *                       base as GetElapsedTime_ns().
+ *
+ * FUNCTION:
+ *    This function pauses the calling thread until an absolute time.  Because
+ *    the time is absolute (not a delay) a caller that does something every
+ *    'x' ns can add 'x' to the last deadline and never drift.
+ *
+ *    If the deadline has already passed this returns right away.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    GetElapsedTime_ns(), OS_Sleep()
+ ******************************************************************************/
+void OS_SleepUntil_ns(uint64_t Deadline_ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec=Deadline_ns/1000000000ULL;
+    ts.tv_nsec=Deadline_ns%1000000000ULL;
+
+    /* Signals can wake us early, so go back to sleep until the time */
+    while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,NULL)==EINTR)
+        ;
+}
+
 /*******************************************************************************
  * NAME:
  *    OS_GetCurrentTime
@@ -32,7 +32,9 @@
 #include "OS/Sockets.h"
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <netdb.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -40,8 +42,11 @@
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <stdint.h>
+#include <string>
 
 /*** DEFINES                  ***/
+#define LOCALSERVER_MAX_ACCEPTS         8   // Most clients we serve per call to ServeLocalServerSocket()
 
 /*** MACROS                   ***/
 
@@ -51,6 +56,12 @@ struct LinuxSocket
     int fd;
 };
 
+struct LinuxLocalServer
+{
+    int fd;
+    std::string Path;
+};
+
 /*** FUNCTION PROTOTYPES      ***/
 
 /*** VARIABLE DEFINITIONS     ***/
@@ -343,3 +354,187 @@ void CloseSocket(struct OSSocket *Sock)
     delete TheSocket;
 }
 
+
+/*******************************************************************************
+ * NAME:
+ *    OpenLocalServerSocket
+ *
+ * SYNOPSIS:
+ *    struct OSLocalServer *OpenLocalServerSocket(const char *Path);
+ *
+ * PARAMETERS:
+ *    Path [I] -- The file system path to make the socket at.  If there is
+ *                a socket already there (left over from last time) it is
+ *                removed.  If there is anything else there this fails.
+ *
+ * FUNCTION:
+ *    This function opens a local (unix domain) socket that other programs
+ *    on this machine can connect to.  The socket is non-blocking, clients
+ *    are handled by calling ServeLocalServerSocket().
+ *
+ * RETURNS:
+ *    A handle to the server socket or NULL if there was an error.
+ *
+ * SEE ALSO:
+ *    ServeLocalServerSocket(), CloseLocalServerSocket()
+ ******************************************************************************/
+struct OSLocalServer *OpenLocalServerSocket(const char *Path)
+{
+    struct LinuxLocalServer *NewServer;
+    struct sockaddr_un addr;
+    struct stat st;
+    int flags;
+
+    if(strlen(Path)>=sizeof(addr.sun_path))
+        return NULL;
+
+    /* Only ever remove an old socket, never a file that was in the way */
+    if(lstat(Path,&st)==0)
+    {
+        if(!S_ISSOCK(st.st_mode))
+            return NULL;
+        if(unlink(Path)!=0)
+            return NULL;
+    }
+    else if(errno!=ENOENT)
+    {
+        return NULL;
+    }
+
+    NewServer=NULL;
+    try
+    {
+        NewServer=new struct LinuxLocalServer;
+        NewServer->fd=-1;
+        NewServer->Path=Path;
+
+        NewServer->fd=socket(AF_UNIX,SOCK_STREAM,0);
+        if(NewServer->fd==-1)
+            throw(0);
+
+        flags=fcntl(NewServer->fd,F_GETFL,0);
+        if(flags==-1)
+            throw(0);
+        fcntl(NewServer->fd,F_SETFL,flags|O_NONBLOCK);
+
+        memset(&addr,0,sizeof(addr));
+        addr.sun_family=AF_UNIX;
+        strcpy(addr.sun_path,Path);
+
+        if(bind(NewServer->fd,(struct sockaddr *)&addr,sizeof(addr))!=0)
+            throw(0);
+
+        if(listen(NewServer->fd,5)!=0)
+            throw(0);
+    }
+    catch(...)
+    {
+        if(NewServer!=NULL)
+        {
+            if(NewServer->fd>=0)
+                close(NewServer->fd);
+            delete NewServer;
+        }
+        return NULL;
+    }
+
+    return (struct OSLocalServer *)NewServer;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    ServeLocalServerSocket
+ *
+ * SYNOPSIS:
+ *    void ServeLocalServerSocket(struct OSLocalServer *Server,
+ *          const void *Buffer,unsigned int Bytes);
+ *
+ * PARAMETERS:
+ *    Server [I] -- The server socket to work on
+ *    Buffer [I] -- The data to send to each client
+ *    Bytes [I] -- The number of bytes in 'Buffer'
+ *
+ * FUNCTION:
+ *    This function accepts the clients that are waiting on the server
+ *    socket, sends them 'Buffer' and then closes them.  It never blocks (this
+ *    is called from the UI thread), so a client that isn't reading only gets
+ *    what fits in the socket buffer, and at most LOCALSERVER_MAX_ACCEPTS
+ *    clients are handled per call.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    OpenLocalServerSocket()
+ ******************************************************************************/
+void ServeLocalServerSocket(struct OSLocalServer *Server,const void *Buffer,
+        unsigned int Bytes)
+{
+    struct LinuxLocalServer *TheServer=(struct LinuxLocalServer *)Server;
+    const uint8_t *Pos;
+    unsigned int Left;
+    ssize_t Sent;
+    int Client;
+    int flags;
+    int r;
+
+    for(r=0;r<LOCALSERVER_MAX_ACCEPTS;r++)
+    {
+        Client=accept(TheServer->fd,NULL,NULL);
+        if(Client<0)
+            break;
+
+        /* Don't let a stuck client hang us, we drop it when it's full */
+        flags=fcntl(Client,F_GETFL,0);
+        if(flags==-1 || fcntl(Client,F_SETFL,flags|O_NONBLOCK)==-1)
+        {
+            close(Client);
+            continue;
+        }
+
+        Pos=(const uint8_t *)Buffer;
+        Left=Bytes;
+        while(Left>0)
+        {
+            Sent=send(Client,Pos,Left,MSG_NOSIGNAL);
+            if(Sent<=0)
+                break;
+            Pos+=Sent;
+            Left-=Sent;
+        }
+        close(Client);
+    }
+}
+
+/*******************************************************************************
+ * NAME:
+ *    CloseLocalServerSocket
+ *
+ * SYNOPSIS:
+ *    void CloseLocalServerSocket(struct OSLocalServer *Server);
+ *
+ * PARAMETERS:
+ *    Server [I] -- The server socket to close
+ *
+ * FUNCTION:
+ *    This function closes a server socket and removes it from the file
+ *    system.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    OpenLocalServerSocket()
+ ******************************************************************************/
+void CloseLocalServerSocket(struct OSLocalServer *Server)
+{
+    struct LinuxLocalServer *TheServer=(struct LinuxLocalServer *)Server;
+
+    if(TheServer->fd!=-1)
+    {
+        close(TheServer->fd);
+        unlink(TheServer->Path.c_str());
+    }
+
+    delete TheServer;
+}
@@ -44,3 +44,13 @@ uint32_t GetElapsedTime_ms(void)
 {
 #warning TBD
 }
+
+uint64_t GetElapsedTime_ns(void)
+{
+#warning TBD
+}
+
+void OS_SleepUntil_ns(uint64_t Deadline_ns)
+{
+#warning TBD
+}
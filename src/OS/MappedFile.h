@@ -0,0 +1,56 @@
+/*******************************************************************************
+ * FILENAME: MappedFile.h
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    This has the OS abstraction for mapping a whole file into memory read
+ *    only (and a couple of other large file helpers).
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * HISTORY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *       Created
+ *
+ *******************************************************************************/
+#ifndef __MAPPEDFILE_H_
+#define __MAPPEDFILE_H_
+
+/***  HEADER FILES TO INCLUDE          ***/
+#include <stdint.h>
+
+/***  DEFINES                          ***/
+
+/***  MACROS                           ***/
+
+/***  TYPE DEFINITIONS                 ***/
+struct MappedFile;
+
+/***  CLASS DEFINITIONS                ***/
+
+/***  GLOBAL VARIABLE DEFINITIONS      ***/
+
+/***  EXTERNAL FUNCTION PROTOTYPES     ***/
+struct MappedFile *MapFile(const char *Filename);
+void UnMapFile(struct MappedFile *Map);
+const uint8_t *GetMappedFileData(struct MappedFile *Map);
+uint64_t GetMappedFileSize(struct MappedFile *Map);
+bool TruncateFile(const char *Filename,uint64_t Size);
+
+#endif   /* end of "#ifndef __MAPPEDFILE_H_" */
@@ -30,7 +30,9 @@
 
 /***  EXTERNAL FUNCTION PROTOTYPES     ***/
 uint32_t GetElapsedTime_ms(void);
+uint64_t GetElapsedTime_ns(void);
 void OS_Sleep(unsigned int ms);
+void OS_SleepUntil_ns(uint64_t Deadline_ns);
 uint64_t OS_GetCurrentTime(void);
 
 #endif
@@ -33,6 +33,8 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <stdlib.h>
+#include <time.h>
+#include <errno.h>
 
 /*** DEFINES                  ***/
 
@@ -55,3 +57,22 @@ uint32_t GetElapsedTime_ms(void)
 
     return MillSec;
 }
+
+uint64_t GetElapsedTime_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+void OS_SleepUntil_ns(uint64_t Deadline_ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec=Deadline_ns/1000000000ULL;
+    ts.tv_nsec=Deadline_ns%1000000000ULL;
+
+    while(clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&ts,NULL)==EINTR)
+        ;
+}
@@ -53,5 +53,10 @@ bool SendSocket(struct OSSocket *Sock,const void *Buffer,unsigned int Bytes);
 int ReadSocket(struct OSSocket *Sock,void *Buffer,unsigned int MaxBytes);
 unsigned int AvailSocket(struct OSSocket *Sock);
 void CloseSocket(struct OSSocket *Sock);
+
+struct OSLocalServer *OpenLocalServerSocket(const char *Path);
+void ServeLocalServerSocket(struct OSLocalServer *Server,const void *Buffer,
+        unsigned int Bytes);
+void CloseLocalServerSocket(struct OSLocalServer *Server);
 
 #endif   /* end of "#ifndef __SOCKETS_H_" */
@@ -0,0 +1,252 @@
+/*******************************************************************************
+ * FILENAME: MappedFile.cpp
+ *
+ * PROJECT:
+ *    Whippy Term
+ *
+ * FILE DESCRIPTION:
+ *    Win32 implementation using CreateFileMapping() and MapViewOfFile().
+ *
+ * COPYRIGHT:
+ *    Copyright 2026 Paul Hutchinson.
+ *
+ *    This program is free software: you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation, either version 3 of the License, or (at your
+ *    option) any later version.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License along
+ *    with this program. If not, see https://www.gnu.org/licenses/.
+ *
+ * CREATED BY:
+ *    Paul Hutchinson (19 Oct 2026)
+ *
+ ******************************************************************************/
+
+/*** HEADER FILES TO INCLUDE  ***/
+#include "OS/MappedFile.h"
+#include <windows.h>
+
+/*** DEFINES                  ***/
+
+/*** MACROS                   ***/
+
+/*** TYPE DEFINITIONS         ***/
+struct MappedFile
+{
+    HANDLE MapHandle;
+    void *Data;
+    uint64_t Size;
+};
+
+/*** FUNCTION PROTOTYPES      ***/
+
+/*** VARIABLE DEFINITIONS     ***/
+
+/*******************************************************************************
+ * NAME:
+ *    MapFile
+ *
+ * SYNOPSIS:
+ *    struct MappedFile *MapFile(const char *Filename);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to map
+ *
+ * FUNCTION:
+ *    This function maps a whole file into memory (read only).  The pages are
+ *    only read from the disk as they are touched so this is cheap even for
+ *    very big files.
+ *
+ *    A zero length file maps fine but GetMappedFileData() will return NULL.
+ *
+ * RETURNS:
+ *    A handle to the mapped file or NULL if there was an error.
+ *
+ * SEE ALSO:
+ *    UnMapFile(), GetMappedFileData(), GetMappedFileSize()
+ ******************************************************************************/
+struct MappedFile *MapFile(const char *Filename)
+{
+    struct MappedFile *NewMap;
+    LARGE_INTEGER FileSize;
+    HANDLE FileHandle;
+
+    FileHandle=CreateFileA(Filename,GENERIC_READ,
+            FILE_SHARE_READ|FILE_SHARE_WRITE|FILE_SHARE_DELETE,NULL,
+            OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+    if(FileHandle==INVALID_HANDLE_VALUE)
+        return NULL;
+
+    NewMap=NULL;
+    try
+    {
+        if(!GetFileSizeEx(FileHandle,&FileSize))
+            throw(0);
+
+        NewMap=new struct MappedFile;
+        NewMap->MapHandle=NULL;
+        NewMap->Data=NULL;
+        NewMap->Size=FileSize.QuadPart;
+
+        /* Make sure it fits in our address space (32 bit builds) */
+        if((uint64_t)(size_t)NewMap->Size!=NewMap->Size)
+            throw(0);
+
+        if(NewMap->Size>0)
+        {
+            NewMap->MapHandle=CreateFileMappingA(FileHandle,NULL,PAGE_READONLY,
+                    0,0,NULL);
+            if(NewMap->MapHandle==NULL)
+                throw(0);
+
+            NewMap->Data=MapViewOfFile(NewMap->MapHandle,FILE_MAP_READ,0,0,0);
+            if(NewMap->Data==NULL)
+                throw(0);
+        }
+    }
+    catch(...)
+    {
+        if(NewMap!=NULL)
+        {
+            if(NewMap->MapHandle!=NULL)
+                CloseHandle(NewMap->MapHandle);
+            delete NewMap;
+        }
+        NewMap=NULL;
+    }
+
+    /* The mapping stays valid after the file is closed */
+    CloseHandle(FileHandle);
+
+    return NewMap;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    UnMapFile
+ *
+ * SYNOPSIS:
+ *    void UnMapFile(struct MappedFile *Map);
+ *
+ * PARAMETERS:
+ *    Map [I] -- The mapped file to free
+ *
+ * FUNCTION:
+ *    This function unmaps a file mapped with MapFile().  Any pointers
+ *    returned from GetMappedFileData() are no longer valid after this.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    MapFile()
+ ******************************************************************************/
+void UnMapFile(struct MappedFile *Map)
+{
+    if(Map->Data!=NULL)
+        UnmapViewOfFile(Map->Data);
+    if(Map->MapHandle!=NULL)
+        CloseHandle(Map->MapHandle);
+    delete Map;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    GetMappedFileData
+ *
+ * SYNOPSIS:
+ *    const uint8_t *GetMappedFileData(struct MappedFile *Map);
+ *
+ * PARAMETERS:
+ *    Map [I] -- The mapped file to work on
+ *
+ * FUNCTION:
+ *    This function gets a pointer to the start of the file in memory.
+ *
+ * RETURNS:
+ *    A pointer to the first byte of the file or NULL if the file is empty.
+ *
+ * SEE ALSO:
+ *    MapFile(), GetMappedFileSize()
+ ******************************************************************************/
+const uint8_t *GetMappedFileData(struct MappedFile *Map)
+{
+    return (const uint8_t *)Map->Data;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    GetMappedFileSize
+ *
+ * SYNOPSIS:
+ *    uint64_t GetMappedFileSize(struct MappedFile *Map);
+ *
+ * PARAMETERS:
+ *    Map [I] -- The mapped file to work on
+ *
+ * FUNCTION:
+ *    This function gets the number of bytes that are mapped.  This is the
+ *    size of the file when it was mapped.
+ *
+ * RETURNS:
+ *    The number of bytes in the mapping.
+ *
+ * SEE ALSO:
+ *    MapFile(), GetMappedFileData()
+ ******************************************************************************/
+uint64_t GetMappedFileSize(struct MappedFile *Map)
+{
+    return Map->Size;
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TruncateFile
+ *
+ * SYNOPSIS:
+ *    bool TruncateFile(const char *Filename,uint64_t Size);
+ *
+ * PARAMETERS:
+ *    Filename [I] -- The file to cut down
+ *    Size [I] -- The new size of the file in bytes
+ *
+ * FUNCTION:
+ *    This function cuts a file down to 'Size' bytes.  This works on files
+ *    bigger than 2G.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error.
+ *
+ * SEE ALSO:
+ *    MapFile()
+ ******************************************************************************/
+bool TruncateFile(const char *Filename,uint64_t Size)
+{
+    HANDLE FileHandle;
+    LARGE_INTEGER NewSize;
+    bool RetValue;
+
+    FileHandle=CreateFileA(Filename,GENERIC_WRITE,FILE_SHARE_READ,NULL,
+            OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,NULL);
+    if(FileHandle==INVALID_HANDLE_VALUE)
+        return false;
+
+    NewSize.QuadPart=Size;
+    RetValue=false;
+    if(SetFilePointerEx(FileHandle,NewSize,NULL,FILE_BEGIN) &&
+            SetEndOfFile(FileHandle))
+    {
+        RetValue=true;
+    }
+
+    CloseHandle(FileHandle);
+
+    return RetValue;
+}
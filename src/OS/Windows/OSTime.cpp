@@ -61,6 +61,41 @@ uint32_t GetElapsedTime_ms(void)
     return CurrentTime.dwLowDateTime/10000;
 }
 
+/*******************************************************************************
+ * NAME:
+ *    GetElapsedTime_ns
+ *
+ * SYNOPSIS:
+ *    uint64_t GetElapsedTime_ns(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function gets the number of nanoseconds from a monotonic high
+ *    resolution clock.  This is used for timing things (performance stats).
+ *
+ * RETURNS:
+ *    A count of nanoseconds.  Like GetElapsedTime_ms() the absolute value
+ *    is not meaningful, only the difference between two calls is.
+ *
+ * SEE ALSO:
+ *    GetElapsedTime_ms()
+ ******************************************************************************/
+uint64_t GetElapsedTime_ns(void)
+{
+    LARGE_INTEGER Count;
+    static LARGE_INTEGER Freq;
+
+    if(Freq.QuadPart==0)
+        QueryPerformanceFrequency(&Freq);
+    QueryPerformanceCounter(&Count);
+
+    /* Split so we don't overflow the multiply */
+    return (Count.QuadPart/Freq.QuadPart)*1000000000ULL+
+            (Count.QuadPart%Freq.QuadPart)*1000000000ULL/Freq.QuadPart;
+}
+
 /*******************************************************************************
  * NAME:
  *    OS_Sleep
@@ -87,6 +122,48 @@ void OS_Sleep(unsigned int ms)
     Sleep(ms);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    OS_SleepUntil_ns
+ *
+ * SYNOPSIS:
+ *    void OS_SleepUntil_ns(uint64_t Deadline_ns);
+ *
+ * PARAMETERS:
+ *    Deadline_ns [I] -- The time to wake up at.  This is in the same time
+ *                       base as GetElapsedTime_ns().
+ *
+ * FUNCTION:
+ *    This function pauses the calling thread until an absolute time.  If the
+ *    deadline has already passed this returns right away.
+ *
+ *    Sleep() only has about 1ms (or worse) resolution so we sleep until we
+ *    are close and then give up our time slice until the deadline.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    GetElapsedTime_ns(), OS_Sleep()
+ ******************************************************************************/
+void OS_SleepUntil_ns(uint64_t Deadline_ns)
+{
+    uint64_t Now;
+    uint64_t Left_ms;
+
+    for(;;)
+    {
+        Now=GetElapsedTime_ns();
+        if(Now>=Deadline_ns)
+            break;
+        Left_ms=(Deadline_ns-Now)/1000000;
+        if(Left_ms>2)
+            Sleep(Left_ms-2);
+        else
+            Sleep(0);
+    }
+}
+
 /*******************************************************************************
  * NAME:
  *    OS_GetCurrentTime
@@ -309,3 +309,18 @@ void CloseSocket(struct OSSocket *Sock)
 
     delete TheSocket;
 }
+
+/* Local (unix domain) server sockets are not supported on Windows */
+struct OSLocalServer *OpenLocalServerSocket(const char *Path)
+{
+    return NULL;
+}
+
+void ServeLocalServerSocket(struct OSLocalServer *Server,const void *Buffer,
+        unsigned int Bytes)
+{
+}
+
+void CloseLocalServerSocket(struct OSLocalServer *Server)
+{
+}
@@ -42,11 +42,21 @@
 #define DATA_PROCESSORS_API_VERSION_1       1
 #define DATA_PROCESSORS_API_VERSION_2       2
 #define DATA_PROCESSORS_API_VERSION_3       3
+#define DATA_PROCESSORS_API_VERSION_4       4
+#define DATA_PROCESSORS_API_VERSION_5       5
 
 /* Versions of struct DPS_API */
 #define DPS_API_VERSION_1                   1
 #define DPS_API_VERSION_2                   2
 #define DPS_API_VERSION_3                   3
+#define DPS_API_VERSION_4                   4
+#define DPS_API_VERSION_5                   5
+
+/* What parts of a 'struct DPS_StyleSpan' to apply (or'ed together) */
+#define DPS_STYLESPAN_SET_ATTRIBS           0x0001
+#define DPS_STYLESPAN_CLR_ATTRIBS           0x0002
+#define DPS_STYLESPAN_FGCOLOR               0x0004
+#define DPS_STYLESPAN_BGCOLOR               0x0008
 
 /***  MACROS                           ***/
 
@@ -104,6 +114,17 @@ struct DataProcessorInfo
     e_BinaryDataProcessorModeType BinMode;      // Only applies to binary processors
 };
 
+/* !!!! This is passed as an array.  Changing it will break the plugins !!!! */
+struct DPS_StyleSpan
+{
+    uint32_t Offset;        // Chars from the mark to start at
+    uint32_t Len;           // Number of chars to style (0=up to the cursor)
+    uint32_t What;          // DPS_STYLESPAN_... flags of what to apply
+    uint32_t Attribs;       // Attribs to set/clear
+    uint32_t FGColor;
+    uint32_t BGColor;
+};
+
 /* !!!! You can only add to this.  Changing it will break the plugins !!!! */
 struct DataProcessorAPI
 {
@@ -130,6 +151,15 @@ struct DataProcessorAPI
     void (*SetSettingsFromWidgets)(t_DataProSettingsWidgetsType *PrivData,t_PIKVList *Settings);
     void (*ApplySettings)(t_DataProcessorHandleType *DataHandle,t_PIKVList *Settings);
     /********* End of DATA_PROCESSORS_API_VERSION_3 *********/
+    /********* Start of DATA_PROCESSORS_API_VERSION_4 *********/
+    void (*ProcessIncomingTextBlockDone)(t_DataProcessorHandleType *DataHandle);
+    /********* End of DATA_PROCESSORS_API_VERSION_4 *********/
+    /********* Start of DATA_PROCESSORS_API_VERSION_5 *********/
+    int (*ScanIncomingTextRun)(t_DataProcessorHandleType *DataHandle,
+            const uint8_t *Run,int Bytes);
+    void (*ProcessIncomingTextRun)(t_DataProcessorHandleType *DataHandle,
+            const uint8_t *Run,int Bytes);
+    /********* End of DATA_PROCESSORS_API_VERSION_5 *********/
 };
 
 /* !!!! You can only add to this.  Changing it will break the plugins !!!! */
@@ -190,9 +220,16 @@ struct DPS_API
     /********* End of DPS_API_VERSION_2 *********/
     /********* Start of DPS_API_VERSION_3 *********/
     // DEBUG PAUL: Add a get default styling that returns a struct StyleData *SD, does:uint32_t (*GetSysDefaultColor)(uint32_t DefaultColor);
-    // DEBUG PAUL: Add a set styling, does:void (*SetFGColor)(uint32_t FGColor);
-    // DEBUG PAUL: Add a get styling, does:uint32_t (*GetFGColor)(void);
+    void (*ApplyStyleSpans2Mark)(t_DataProMark *Mark,const struct DPS_StyleSpan *Spans,uint32_t Count);
     /********* End of DPS_API_VERSION_3 *********/
+    /********* Start of DPS_API_VERSION_4 *********/
+    void (*DoSetScrollRegion)(uint32_t Top,uint32_t Bottom);
+    void (*DoSetAltScreen)(PG_BOOL On);
+    /********* End of DPS_API_VERSION_4 *********/
+    /********* Start of DPS_API_VERSION_5 *********/
+    void (*SetStyle)(const struct StyleData *SD);
+    void (*GetStyle)(struct StyleData *SD);
+    /********* End of DPS_API_VERSION_5 *********/
 };
 
 /***  CLASS DEFINITIONS                ***/
@@ -40,6 +40,7 @@
 #define IODRIVER_API_VERSION_1          1
 #define IODRIVER_API_VERSION_2          2
 #define IODRIVER_API_VERSION_3          3
+#define IODRIVER_API_VERSION_4          4
 
 #define IOS_API_VERSION_1               1
 #define IOS_API_VERSION_2               2
@@ -123,6 +124,7 @@ struct IODriverAPI
     PG_BOOL (*Open)(t_DriverIOHandleType *DriverIO,const t_PIKVList *Options);
     void (*Close)(t_DriverIOHandleType *DriverIO);
     int (*Read)(t_DriverIOHandleType *DriverIO,uint8_t *Data,int Bytes);
+    /* Write() can be called from a send thread, see IOS_RegisterDriver() */
     int (*Write)(t_DriverIOHandleType *DriverIO,const uint8_t *Data,int Bytes);
     PG_BOOL (*ChangeOptions)(t_DriverIOHandleType *DriverIO,const t_PIKVList *Options);
     int (*Transmit)(t_DriverIOHandleType *DriverIO);
@@ -139,6 +141,9 @@ struct IODriverAPI
     void (*SetSettingsFromWidgets)(t_ConnectionWidgetsType *PrivData,t_PIKVList *Settings);
     void (*ApplySettings)(t_PIKVList *Settings);
     /********* End of IODRIVER_API_VERSION_3 *********/
+    /********* Start of IODRIVER_API_VERSION_4 *********/
+    void (*Shutdown)(void);
+    /********* End of IODRIVER_API_VERSION_4 *********/
 };
 
 /* !!!! You can only add to this.  Changing it will break the plugins !!!! */
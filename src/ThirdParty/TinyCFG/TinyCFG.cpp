@@ -27,6 +27,12 @@
 #include <string>
 #include <string.h>
 #include <list>
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -441,6 +447,8 @@ void TinyCFG::ResetData(void)
     FirstBlock=NULL;
     CurrentBlock=NULL;
     XMLIndent=0;
+    fh=NULL;
+    WriteBuff=&OurWriteBuff;
 }
 
 /*******************************************************************************
@@ -1053,6 +1061,21 @@ bool TinyCFG::RegisterGeneric(class TinyCFGBaseData *Generic)
         delete NewData;
         return false;
     }
+
+    /* Add it to the blocks index so the loader can find it without walking
+       the list (if the name is already used the first one wins like it did
+       when we searched the list) */
+    try
+    {
+        CurrentBlock->DataIndex.emplace(Generic->XmlName,NewData);
+    }
+    catch(std::bad_alloc)
+    {
+        Failure=true;
+        delete NewData;
+        return false;
+    }
+
     if(CurrentBlock->FirstData==NULL)
         CurrentBlock->FirstData=NewData;
     else
@@ -1216,6 +1239,10 @@ void TinyCFG::Clear(void)
  *    an XML config file.  The XML is then saved to a file whos name was given
  *    in 'FileName'.
  *
+ *    The XML is written to 'FileName'.tmp, flushed to the disk, and then
+ *    renamed over 'FileName' (in 1 step) so the old file is never left 1/2
+ *    written or missing.
+ *
  * RETURNS:
  *    true -- Things worked out.  The file has been saved.
  *    false -- There was an error building the XML or saving the file.
@@ -1234,19 +1261,73 @@ void TinyCFG::Clear(void)
  ******************************************************************************/
 bool TinyCFG::SaveCFGFile(const char *FileName)
 {
-    fh=fopen(FileName,"w");
+    string TmpFileName;
+    bool RetValue;
+
+    /* We write to a temp file and then rename it over the real file so if
+       we die (or the disk fills up) part way though the old file is still
+       there */
+    TmpFileName=FileName;
+    TmpFileName+=".tmp";
+
+    fh=fopen(TmpFileName.c_str(),"w");
     if(fh==NULL)
         return false;
 
-    fprintf(fh,"<?xml version=\"1.0\" standalone=\"no\" ?>\n");
+    WriteBuff=&OurWriteBuff;
+    WriteBuff->clear();
+    WriteBuff->reserve(TINYCFG_WRITE_BUFF_SIZE*2);
+    WriteBuff->append("<?xml version=\"1.0\" standalone=\"no\" ?>\n");
 
-    if(!WriteXml(FirstBlock))
+    try
+    {
+        RetValue=WriteXml(FirstBlock);
+        if(!FlushWriteBuff())
+            RetValue=false;
+    }
+    catch(...)
+    {
+        RetValue=false;
+    }
+
+    /* Make sure the data is on the disk before the rename makes it the
+       real file */
+    if(fflush(fh)!=0)
+        RetValue=false;
+#ifdef _WIN32
+    if(_commit(_fileno(fh))!=0)
+        RetValue=false;
+#else
+    if(fsync(fileno(fh))!=0)
+        RetValue=false;
+#endif
+    if(ferror(fh))
+        RetValue=false;
+    if(fclose(fh)!=0)
+        RetValue=false;
+    fh=NULL;
+    OurWriteBuff.clear();
+
+    if(!RetValue)
     {
         Failure=true;
+        remove(TmpFileName.c_str());
         return false;
     }
 
-    fclose(fh);
+#ifdef _WIN32
+    /* Windows rename() will not replace a file, MoveFileEx() replaces it in
+       1 step */
+    if(!MoveFileExA(TmpFileName.c_str(),FileName,
+            MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH))
+#else
+    if(rename(TmpFileName.c_str(),FileName)!=0)
+#endif
+    {
+        Failure=true;
+        remove(TmpFileName.c_str());
+        return false;
+    }
 
     return true;
 }
@@ -1257,6 +1338,7 @@ bool TinyCFG::WriteCFGUsingParentCFG(class TinyCFG *OrgCFG)
         return false;
 
     fh=OrgCFG->fh;
+    WriteBuff=OrgCFG->WriteBuff;
     XMLIndent=OrgCFG->XMLIndent;
 
     if(!WriteXml(FirstBlock))
@@ -1356,7 +1438,10 @@ bool TinyCFG::WriteXml(struct TinyCFG_Entry *First)
  ******************************************************************************/
 void TinyCFG::WriteXMLOpenElement(const char *ElementName)
 {
-    fprintf(fh,"%*s<%s>\n",XMLIndent,"",ElementName);
+    WriteXMLIndent();
+    WriteBuff->push_back('<');
+    WriteBuff->append(ElementName);
+    WriteBuff->append(">\n");
     XMLIndent+=XMLINDEXSIZE;
 }
 
@@ -1385,7 +1470,13 @@ void TinyCFG::WriteXMLOpenElement(const char *ElementName)
 void TinyCFG::WriteXMLCloseElement(const char *ElementName)
 {
     XMLIndent-=XMLINDEXSIZE;
-    fprintf(fh,"%*s</%s>\n",XMLIndent,"",ElementName);
+    WriteXMLIndent();
+    WriteBuff->append("</");
+    WriteBuff->append(ElementName);
+    WriteBuff->append(">\n");
+
+    if(WriteBuff->size()>=TINYCFG_WRITE_BUFF_SIZE)
+        FlushWriteBuff();
 }
 
 /*******************************************************************************
@@ -1411,7 +1502,10 @@ void TinyCFG::WriteXMLCloseElement(const char *ElementName)
  ******************************************************************************/
 void TinyCFG::WriteXMLOpenDataElement(const char *ElementName)
 {
-    fprintf(fh,"%*s<%s>",XMLIndent,"",ElementName);
+    WriteXMLIndent();
+    WriteBuff->push_back('<');
+    WriteBuff->append(ElementName);
+    WriteBuff->push_back('>');
     XMLIndent+=XMLINDEXSIZE;
 }
 
@@ -1440,7 +1534,12 @@ void TinyCFG::WriteXMLOpenDataElement(const char *ElementName)
 void TinyCFG::WriteXMLCloseDataElement(const char *ElementName)
 {
     XMLIndent-=XMLINDEXSIZE;
-    fprintf(fh,"</%s>\n",ElementName);
+    WriteBuff->append("</");
+    WriteBuff->append(ElementName);
+    WriteBuff->append(">\n");
+
+    if(WriteBuff->size()>=TINYCFG_WRITE_BUFF_SIZE)
+        FlushWriteBuff();
 }
 
 /*******************************************************************************
@@ -1470,62 +1569,113 @@ void TinyCFG::WriteXMLCloseDataElement(const char *ElementName)
  ******************************************************************************/
 void TinyCFG::WriteXMLEscapedString(const char *OutString)
 {
-    char buff[100];
     char tmp[100];
-    char *InsertPoint;
-    int r;
-    int Len;
+    const char *RunStart;
+    unsigned char c;
 
-    InsertPoint=buff;
+    /* Chars that don't need escaping are copied over in runs */
+    RunStart=OutString;
     while(*OutString!=0)
     {
-        if(*OutString=='&')
+        c=*OutString;
+        if(c=='&' || c=='<' || c=='>' || c<' ' || c>=127)
         {
-            *InsertPoint++='&';
-            *InsertPoint++='a';
-            *InsertPoint++='m';
-            *InsertPoint++='p';
-            *InsertPoint++=';';
-        }
-        else if(*OutString=='<')
-        {
-            *InsertPoint++='&';
-            *InsertPoint++='l';
-            *InsertPoint++='t';
-            *InsertPoint++=';';
-        }
-        else if(*OutString=='>')
-        {
-            *InsertPoint++='&';
-            *InsertPoint++='g';
-            *InsertPoint++='t';
-            *InsertPoint++=';';
-        }
-        else if(*OutString<' ' || *OutString>=127)
-        {
-            sprintf(tmp,"&#%d;",(unsigned char)*OutString);    // 6 char max
-            Len=strlen(tmp);
-            for(r=0;r<Len;r++)
-                *InsertPoint++=tmp[r];
-        }
-        else
-        {
-            *InsertPoint++=*OutString;
-        }
-
-        if(InsertPoint>&buff[sizeof(buff)-7])   // 7 because the worst esc is ascII + \0 for end of string
-        {
-            *InsertPoint++=0;
-            fprintf(fh,"%s",buff);
-            InsertPoint=buff;
+            WriteBuff->append(RunStart,OutString-RunStart);
+            if(c=='&')
+            {
+                WriteBuff->append("&amp;");
+            }
+            else if(c=='<')
+            {
+                WriteBuff->append("&lt;");
+            }
+            else if(c=='>')
+            {
+                WriteBuff->append("&gt;");
+            }
+            else
+            {
+                sprintf(tmp,"&#%d;",c);    // 6 char max
+                WriteBuff->append(tmp);
+            }
+            RunStart=OutString+1;
         }
         OutString++;
     }
-    if(InsertPoint!=buff)
+    WriteBuff->append(RunStart,OutString-RunStart);
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TinyCFG::WriteXMLIndent
+ *
+ * SYNOPSIS:
+ *    void TinyCFG::WriteXMLIndent(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function adds the spaces for the current indent level to the
+ *    output.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    TinyCFG::WriteXMLOpenElement()
+ *******************************************************************************
+ * REVISION HISTORY:
+ *    PaulHutchinson (19 Oct 2026)
+ *       Created
+ ******************************************************************************/
+void TinyCFG::WriteXMLIndent(void)
+{
+    if(XMLIndent>0)
+        WriteBuff->append(XMLIndent,' ');
+}
+
+/*******************************************************************************
+ * NAME:
+ *    TinyCFG::FlushWriteBuff
+ *
+ * SYNOPSIS:
+ *    bool TinyCFG::FlushWriteBuff(void);
+ *
+ * PARAMETERS:
+ *    NONE
+ *
+ * FUNCTION:
+ *    This function writes what has been built up in 'WriteBuff' out to
+ *    the file and empties the buffer.  The XML is built in memory and
+ *    written in big blocks instead of 1 fprintf() per tag.
+ *
+ * RETURNS:
+ *    true -- Things worked out
+ *    false -- There was an error writing to the file.
+ *
+ * SEE ALSO:
+ *    TinyCFG::SaveCFGFile()
+ *******************************************************************************
+ * REVISION HISTORY:
+ *    PaulHutchinson (19 Oct 2026)
+ *       Created
+ ******************************************************************************/
+bool TinyCFG::FlushWriteBuff(void)
+{
+    bool RetValue;
+
+    RetValue=true;
+    if(!WriteBuff->empty())
     {
-        *InsertPoint++=0;
-        fprintf(fh,"%s",buff);
+        if(fwrite(WriteBuff->data(),WriteBuff->size(),1,fh)!=1)
+        {
+            Failure=true;
+            RetValue=false;
+        }
+        WriteBuff->clear();
     }
+    return RetValue;
 }
 
 /*******************************************************************************
@@ -1640,6 +1790,7 @@ void TinyCFG::UnEscapedString(std::string &RetStr,const char *OutString)
  *    FileName [I] -- What file to load
  *    MaxFileSize [I] -- The config file is loaded into ram.  What is the
  *                       biggest it can be (how much ram will we allocate).
+ *                       0 for no limit (the default).
  *
  * FUNCTION:
  *    This method loads a CFG File.  It sets all any registed vars that are
@@ -1667,18 +1818,18 @@ void TinyCFG::UnEscapedString(std::string &RetStr,const char *OutString)
  ******************************************************************************/
 bool TinyCFG::LoadCFGFile(const char *FileName,int MaxFileSize)
 {
-    int ReadFileSize;
+    long ReadFileSize;
 
     fh=fopen(FileName,"rb");
     if(fh==NULL)
         return false;
 
     /* NOTE:
-        I was going to do this by using a floating read buffer, but decided
-        that the XML file is unlikely to be bigger than 1M (and that's
-        a big file).  1M is small these days, so why go to the bother.
-        I know that means that there is now an edge case where it will
-        be unusable, but that's an edge case that I am ignoring. */
+        The file is read in with 1 read and then parsed in place in a
+        single pass from the start to the end (custom types are handed
+        the text of their element to walk, so it has to all be in ram).
+        Nothing is copied and each element is looked up in the
+        block's hash, so loading is linear in the size of the file. */
 
     /* Get the size of the file */
     fseek(fh,0,SEEK_END);
@@ -1691,7 +1842,7 @@ bool TinyCFG::LoadCFGFile(const char *FileName,int MaxFileSize)
         return false;
     }
 
-    if(ReadFileSize+1>MaxFileSize)
+    if(MaxFileSize>0 && ReadFileSize+1>MaxFileSize)
     {
         fclose(fh);
         return false;
@@ -1712,6 +1863,7 @@ bool TinyCFG::LoadCFGFile(const char *FileName,int MaxFileSize)
     }
 
     fclose(fh);
+    fh=NULL;
 
     ReadBuff[ReadFileSize]=0;   // It's a string
     ReadBuffEnd=ReadBuff+ReadFileSize;
@@ -1811,7 +1963,7 @@ bool TinyCFG::GetAndSetFromXml(void)
         if(InComment)
         {
             /* See if this is the end of the comment */
-            if(strncmp(ReadPoint,"-->",3)==0)
+            if(c=='-' && strncmp(ReadPoint,"-->",3)==0)
             {
                 ReadPoint+=3;
                 InComment=false;
@@ -1820,7 +1972,7 @@ bool TinyCFG::GetAndSetFromXml(void)
             ReadPoint++;
             continue;
         }
-        if(strncmp(ReadPoint,"<!--",4)==0)
+        if(c=='<' && strncmp(ReadPoint,"<!--",4)==0)
         {
             /* Start of a comment */
             InComment=true;
@@ -1961,19 +2113,18 @@ void TinyCFG::ExitElementLevel(const char *Name)
 
 struct TinyCFG_RegData *TinyCFG::FindDataEntry(const char *DataName)
 {
-    struct TinyCFG_RegData *Entry;
+    t_TinyCFGDataIndexType::iterator Found;
 
     if(CurrentReadLevel==NULL)
         return NULL;
 
-    for(Entry=CurrentReadLevel->FirstData;Entry!=NULL;Entry=Entry->Next)
-    {
-        if(Entry->Data->XmlName==DataName)
-        {
-            return Entry;
-        }
-    }
-    return NULL;
+    /* We reuse 'LookupKey' so we don't alloc a new string for every tag */
+    LookupKey.assign(DataName);
+    Found=CurrentReadLevel->DataIndex.find(LookupKey);
+    if(Found==CurrentReadLevel->DataIndex.end())
+        return NULL;
+
+    return Found->second;
 }
 
 bool TinyCFG::SkipToEndTag(const char *ElementName)
@@ -2164,7 +2315,7 @@ const char *TinyCFG::ReadNextDataElement(const char *DataElementName)
 {
     char *StartOfElementData;
     char *p;
-    static string RetStr;
+    static thread_local string RetStr;  // Files can be loaded on more than 1 thread
 
     /* Ok, we search for the next element named 'DataElementName' that is
        inside this levels data.  Start from 'LoadDataReadPoint' */
@@ -2309,7 +2460,7 @@ bool TinyCFG::ReadNextTag(const char **XmlName,const char **DataElement)
     char *Tag;
     char *Data;
     char *EndTag;
-    static string RetStr;
+    static thread_local string RetStr;
 
     if(!FindNextTagStartAndEndAtThisLevel(&Tag,&Data,&EndTag))
         return false;
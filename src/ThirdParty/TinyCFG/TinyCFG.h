@@ -26,10 +26,12 @@
 /***  HEADER FILES TO INCLUDE          ***/
 #include <string>
 #include <list>
+#include <unordered_map>
 #include <stdio.h>
 
 /***  DEFINES                          ***/
-#define XMLINDEXSIZE 4
+#define XMLINDEXSIZE 4
+#define TINYCFG_WRITE_BUFF_SIZE     (64*1024)   // Flush the output when it gets this big
 
 /***  MACROS                           ***/
 
@@ -57,6 +59,8 @@ struct TinyCFG_RegData
     struct TinyCFG_RegData *Next;
 };
 
+typedef std::unordered_map<std::string,struct TinyCFG_RegData *> t_TinyCFGDataIndexType;
+
 struct TinyCFG_Entry
 {
     std::string XmlName;
@@ -65,6 +69,7 @@ struct TinyCFG_Entry
     struct TinyCFG_Entry *ParentSubLevel;
     struct TinyCFG_RegData *FirstData;
     struct TinyCFG_RegData *CurrentData;
+    t_TinyCFGDataIndexType DataIndex;   // 'FirstData' by XmlName
     struct TinyCFG_Entry *Next;
 };
 
@@ -100,7 +105,7 @@ class TinyCFG
         bool StartBlock(const std::string &BlockName);
         void EndBlock(void);
         bool SaveCFGFile(const char *FileName);
-        bool LoadCFGFile(const char *FileName,int MaxFileSize=1000000);
+        bool LoadCFGFile(const char *FileName,int MaxFileSize=0);
         void Clear(void);
 
         /* For custom types */
@@ -122,6 +127,9 @@ class TinyCFG
         std::string SavedFirstBlockName;   // If we where constructed with a block name we need to save it incase Clear() needs it later
         FILE *fh;
         int XMLIndent;
+        std::string *WriteBuff;     // Where the XML is built before going to 'fh' (shared with child CFG's)
+        std::string OurWriteBuff;
+        std::string LookupKey;
         char *ReadBuff;
         char *ReadBuffEnd;
         char *ReadPoint;
@@ -149,6 +157,8 @@ class TinyCFG
         void WriteXMLOpenDataElement(const char *ElementName);
         void WriteXMLCloseDataElement(const char *ElementName);
         void WriteXMLEscapedString(const char *OutString);
+        void WriteXMLIndent(void);
+        bool FlushWriteBuff(void);
         void UnEscapedString(std::string &RetStr,const char *OutString);
         bool EnterElementLevel(const char *Name);
         void ExitElementLevel(const char *Name);
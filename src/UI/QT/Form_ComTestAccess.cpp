@@ -201,10 +201,18 @@ t_UITextInputCtrl *UICT_GetTextInput(e_CT_TextInput UIObj)
             return (t_UITextInputCtrl *)g_ComTest->ui->StatSendErrors_lineEdit;
         case e_CT_TextInput_Stat_SendBusyErrors:
             return (t_UITextInputCtrl *)g_ComTest->ui->StatSendBusyErrors_lineEdit;
-//        case e_CT_TextInput_Stat_BytesPerSec:
-//            return (t_UITextInputCtrl *)g_ComTest->ui->StatBytesPerSec_lineEdit;
+        case e_CT_TextInput_Stat_BytesPerSec:
+            return (t_UITextInputCtrl *)g_ComTest->ui->StatBytesPerSec_lineEdit;
         case e_CT_TextInput_Stat_RxErrors:
             return (t_UITextInputCtrl *)g_ComTest->ui->StatRxErrors_lineEdit;
+        case e_CT_TextInput_Stat_PacketsLost:
+            return (t_UITextInputCtrl *)g_ComTest->ui->StatPacketsLost_lineEdit;
+        case e_CT_TextInput_Stat_BitErrorRate:
+            return (t_UITextInputCtrl *)g_ComTest->ui->StatBitErrorRate_lineEdit;
+        case e_CT_TextInput_Stat_ByteErrorRate:
+            return (t_UITextInputCtrl *)g_ComTest->ui->StatByteErrorRate_lineEdit;
+        case e_CT_TextInput_Stat_Latency:
+            return (t_UITextInputCtrl *)g_ComTest->ui->StatLatency_lineEdit;
 
         case e_CT_TextInputMAX:
         default:
@@ -409,6 +417,8 @@ t_UILabelCtrl *UICT_GetLabelHandle(e_CT_LabelType UIObj)
     {
         case e_CT_Label_Status:
             return (t_UILabelCtrl *)g_ComTest->ui->Status_label;
+        case e_CT_Label_LatencyHistogram:
+            return (t_UILabelCtrl *)g_ComTest->ui->LatencyHistogram_label;
         case e_CT_LabelMAX:
         default:
             return NULL;
@@ -18,9 +18,11 @@ Frame_MainTextArea::Frame_MainTextArea(QWidget *parent) :
     ContextMenu->addAction(ui->actionCalculate_CRC);
     ContextMenu->addAction(ui->actionFind_CRC_Algorithm);
     ContextMenu->addAction(ui->actionCopy_To_Send_Buffer);
+    ContextMenu->addAction(ui->actionSave_Selection);
     ContextMenu->addSeparator();
     ContextMenu->addAction(ui->actionCopy);
     ContextMenu->addAction(ui->actionPaste);
+    ContextMenu->addAction(ui->actionStop_Paste);
     ContextMenu->addSeparator();
     ContextMenu->addAction(ui->actionEndian_Swap);
     ContextMenu->addAction(ui->actionClear_Screen);
@@ -182,6 +184,11 @@ void Frame_MainTextArea::on_actionPaste_triggered()
     SendContextMenuEvent(e_UITD_ContextMenu_Paste);
 }
 
+void Frame_MainTextArea::on_actionStop_Paste_triggered()
+{
+    SendContextMenuEvent(e_UITD_ContextMenu_StopPaste);
+}
+
 void Frame_MainTextArea::on_actionClear_Screen_triggered()
 {
     SendContextMenuEvent(e_UITD_ContextMenu_ClearScreen);
@@ -282,6 +289,24 @@ void Frame_MainTextArea::on_BlockSend_LineEnd_comboBox_activated(int index)
     EventHandler(&NewEvent);
 }
 
+void Frame_MainTextArea::on_TextSend_LineEnd_comboBox_activated(int index)
+{
+    struct TextDisplayEvent NewEvent;
+    uintptr_t ComboxID;   // The ID for this item
+
+    if(EventHandler==nullptr)
+        return;
+
+    NewEvent.EventType=e_TextDisplayEvent_ComboxChange;
+    NewEvent.ID=ID;
+
+    ComboxID=ui->TextSend_LineEnd_comboBox->itemData(index).toULongLong();
+    NewEvent.Info.Combox.ID=ComboxID;
+    NewEvent.Info.Combox.BoxID=e_UITC_Combox_TextSend_LineEnd;
+
+    EventHandler(&NewEvent);
+}
+
 void Frame_MainTextArea::on_actionStyleStrike_Through_triggered()
 {
     SendContextMenuEvent(e_UITD_ContextMenu_StrikeThrough);
@@ -397,6 +422,11 @@ void Frame_MainTextArea::on_actionCopy_To_Send_Buffer_triggered()
     SendContextMenuEvent(e_UITD_ContextMenu_SendToSendBuffer);
 }
 
+void Frame_MainTextArea::on_actionSave_Selection_triggered()
+{
+    SendContextMenuEvent(e_UITD_ContextMenu_SaveSelection);
+}
+
 
 void Frame_MainTextArea::on_Jump2SendBuffers_pushButton_clicked()
 {
@@ -47,6 +47,8 @@ private slots:
     
     void on_actionPaste_triggered();
     
+    void on_actionStop_Paste_triggered();
+    
     void on_actionClear_Screen_triggered();
     
     void on_actionZoom_In_triggered();
@@ -67,6 +69,8 @@ private slots:
     
     void on_BlockSend_LineEnd_comboBox_activated(int index);
     
+    void on_TextSend_LineEnd_comboBox_activated(int index);
+    
     void on_actionStyleStrike_Through_triggered();
     
     void on_actionStyleUnderline_triggered();
@@ -113,6 +117,8 @@ private slots:
     
     void on_actionCopy_To_Send_Buffer_triggered();
     
+    void on_actionSave_Selection_triggered();
+    
     void on_Jump2SendBuffers_pushButton_clicked();
     
     void on_TextSendSend_pushButton_clicked();
@@ -241,8 +241,12 @@ t_UIContextMenuCtrl *UITC_GetContextMenuHandle(t_UITextDisplayCtrl *ctrl,e_UITD_
             return (t_UIContextMenuCtrl *)TextDisplay->ui->actionCopy_To_Send_Buffer;
         case e_UITD_ContextMenu_Copy:
             return (t_UIContextMenuCtrl *)TextDisplay->ui->actionCopy;
+        case e_UITD_ContextMenu_SaveSelection:
+            return (t_UIContextMenuCtrl *)TextDisplay->ui->actionSave_Selection;
         case e_UITD_ContextMenu_Paste:
             return (t_UIContextMenuCtrl *)TextDisplay->ui->actionPaste;
+        case e_UITD_ContextMenu_StopPaste:
+            return (t_UIContextMenuCtrl *)TextDisplay->ui->actionStop_Paste;
         case e_UITD_ContextMenu_ClearScreen:
             return (t_UIContextMenuCtrl *)TextDisplay->ui->actionClear_Screen;
         case e_UITD_ContextMenu_ZoomIn:
@@ -322,7 +326,9 @@ t_UIContextMenuCtrl *UITC_GetContextMenuHandle(t_UITextDisplayCtrl *ctrl,
         case e_UITD_ContextMenu_FindCRCAlgorithm:
         case e_UITD_ContextMenu_SendToSendBuffer:
         case e_UITD_ContextMenu_Copy:
+        case e_UITD_ContextMenu_SaveSelection:
         case e_UITD_ContextMenu_Paste:
+        case e_UITD_ContextMenu_StopPaste:
         case e_UITD_ContextMenu_ClearScreen:
         case e_UITD_ContextMenu_ZoomIn:
         case e_UITD_ContextMenu_ZoomOut:
@@ -910,6 +916,42 @@ void UITC_AddFragment(t_UITextDisplayColumn *Handle,const struct TextCanvasFrag
     Column->ui->TextDisplayBox->AppendTextFrag(Column->WorkingLine,Frag);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    UITC_SetLine
+ *
+ * SYNOPSIS:
+ *    void UITC_SetLine(t_UITextDisplayColumn *Handle,int Line,
+ *          t_TextCanvasLineRef Snapshot);
+ *
+ * PARAMETERS:
+ *    Handle [I] -- What column to work on
+ *    Line [I] -- The screen line to set
+ *    Snapshot [I] -- The line snapshot to show on this line.  The canvas
+ *                    keeps a ref to this (it is never changed).
+ *
+ * FUNCTION:
+ *    This function replaces a line on the screen with a line snapshot and
+ *    redraws it.  This is used instead of UITC_Begin() / UITC_ClearLine() /
+ *    UITC_AddFragment() / UITC_End().
+ *
+ *    If the line already has a snapshot with the same generation then
+ *    nothing is done.
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    UITC_Begin()
+ ******************************************************************************/
+void UITC_SetLine(t_UITextDisplayColumn *Handle,int Line,
+        t_TextCanvasLineRef Snapshot)
+{
+    Frame_MainTextColumn *Column=(Frame_MainTextColumn *)Handle;
+
+    Column->ui->TextDisplayBox->SetLine(Line,Snapshot);
+}
+
 /*******************************************************************************
  * NAME:
  *    UITC_ClearGraphics
@@ -1415,6 +1457,36 @@ void UITC_SetMaxLines(t_UITextDisplayColumn *Handle,int MaxLines,uint32_t BGColo
     Column->ui->TextDisplayBox->SetMaxLines(MaxLines,BGColor);
 }
 
+/*******************************************************************************
+ * NAME:
+ *    UITC_ScrollLines
+ *
+ * SYNOPSIS:
+ *    void UITC_ScrollLines(t_UITextDisplayColumn *Handle,int Lines);
+ *
+ * PARAMETERS:
+ *    Handle [I] -- What column to work on
+ *    Lines [I] -- The number of lines to scroll up
+ *
+ * FUNCTION:
+ *    This function scrolls the lines on the screen up by 'Lines' (moves what
+ *    is already drawn instead of redrawing it).  The lines at the bottom that
+ *    are exposed will have junk in them and must be redrawn with
+ *    UITC_Begin() / UITC_End().
+ *
+ * RETURNS:
+ *    NONE
+ *
+ * SEE ALSO:
+ *    UITC_Begin(), UITC_SetMaxLines()
+ ******************************************************************************/
+void UITC_ScrollLines(t_UITextDisplayColumn *Handle,int Lines)
+{
+    Frame_MainTextColumn *Column=(Frame_MainTextColumn *)Handle;
+
+    Column->ui->TextDisplayBox->ScrollLines(Lines);
+}
+
 /*******************************************************************************
  * NAME:
  *    UITC_SetClippingWindow
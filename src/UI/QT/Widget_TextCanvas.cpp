@@ -12,6 +12,7 @@
 #include <QGraphicsOpacityEffect>
 #include <QPropertyAnimation>
 #include <QApplication>
+#include <algorithm>
 
 #define FOCUS_BOX_SIZE          1
 
@@ -476,6 +477,7 @@ void Widget_TextCanvas::ClearLine(unsigned int Line,uint32_t BGColor)
     struct WTCLine BlankLine;
 
     BlankLine.BGFillColor=BGColor;
+    BlankLine.Generation=0;
     if(Line>=Lines.size())
     {
         /* We need to add blank lines until we get to the correct number of
@@ -507,6 +509,50 @@ void Widget_TextCanvas::AppendTextFrag(unsigned int Line,
     AddedFrag->CursorFrag=false;
 }
 
+void Widget_TextCanvas::SetLine(unsigned int Line,t_TextCanvasLineRef Snapshot)
+{
+    struct WTCLine BlankLine;
+    struct WTCFrag NewFrag;
+    struct WTCLine *DestLine;
+    const struct TextCanvasLineRun *Run;
+    unsigned int r;
+
+    if(Snapshot==NULL)
+        return;
+
+    if(Line>=Lines.size())
+    {
+        BlankLine.BGFillColor=Snapshot->BGColor;
+        BlankLine.Generation=0;
+        while(Line>=Lines.size())
+            Lines.push_back(BlankLine);
+    }
+    DestLine=&Lines[Line];
+
+    /* If we already have this line converted then there is nothing to do */
+    if(DestLine->Generation==Snapshot->Generation)
+        return;
+
+    DestLine->BGFillColor=Snapshot->BGColor;
+    DestLine->Fragments.clear();
+    NewFrag.CursorFrag=false;
+    for(r=0;r<Snapshot->Runs.size();r++)
+    {
+        Run=&Snapshot->Runs[r];
+        NewFrag.FragType=Run->FragType;
+        NewFrag.Text=QString::fromUtf8(Snapshot->Text.data()+Run->Offset,
+                Run->Len);
+        NewFrag.Styling=Run->Styling;
+        NewFrag.Value=Run->Value;
+        NewFrag.Data=Run->Data;
+        DestLine->Fragments.push_back(NewFrag);
+    }
+    DestLine->Snapshot=Snapshot;
+    DestLine->Generation=Snapshot->Generation;
+
+    RedrawLine(Line);
+}
+
 void Widget_TextCanvas::RedrawLine(unsigned int Line)
 {
     if(Line==CursorY)
@@ -1720,9 +1766,53 @@ void Widget_TextCanvas::SetMaxLines(int MaxLines,uint32_t BGColor)
     struct WTCLine NewLine;
 
     NewLine.BGFillColor=BGColor;
+    NewLine.Generation=0;
     Lines.resize(MaxLines,NewLine);
 }
 
+void Widget_TextCanvas::ScrollLines(int Count)
+{
+    unsigned int r;
+
+    if(Count<=0 || Lines.empty())
+        return;
+
+    if((unsigned int)Count>=Lines.size())
+    {
+        /* Everything scrolled off */
+        for(r=0;r<Lines.size();r++)
+        {
+            Lines[r].Fragments.clear();
+            Lines[r].Snapshot.reset();
+            Lines[r].Generation=0;
+        }
+        RethinkCursor();
+        update();
+        return;
+    }
+
+    /* Move the lines up.  The lines that fall off the top end up on the
+       bottom, the caller will redraw them */
+    std::rotate(Lines.begin(),Lines.begin()+Count,Lines.end());
+
+    if(!GraphicsOverlay.empty())
+    {
+        /* The graphics don't move with the text so we can't blit */
+        RethinkCursor();
+        update();
+        return;
+    }
+
+    /* Blit what is already drawn, Qt will only repaint the exposed lines */
+    scroll(0,-Count*GUICharHeight,QRect(DisplayLeftEdgePx,DisplayTopEdgePx,
+            DisplayWidth,Lines.size()*GUICharHeight));
+
+    /* The cursor was moved with the pixels, fix up where it was drawn */
+    if((int)CursorY-Count>=0)
+        RedrawLine(CursorY-Count);
+    RedrawLine(CursorY);
+}
+
 void Widget_TextCanvas::SetDisplaySize(int LeftEdge,int TopEdge,int Width,
         int Height)
 {
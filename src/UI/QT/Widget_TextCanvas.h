@@ -99,6 +99,8 @@ struct WTCLine
 {
     uint32_t BGFillColor;   // Selected when we first bring a new line into existance (scroll off bottom)
     t_WTCLineFrags Fragments;
+    t_TextCanvasLineRef Snapshot;   // The snapshot 'Fragments' was converted from (if any)
+    uint32_t Generation;            // The generation of 'Snapshot' (0=none)
 };
 
 typedef std::vector<struct WTCLine> t_WTCLines;
@@ -147,6 +149,7 @@ public:
 
     void ClearLine(unsigned int Line,uint32_t BGColor);
     void AppendTextFrag(unsigned int Line,const struct TextCanvasFrag *Frag);
+    void SetLine(unsigned int Line,t_TextCanvasLineRef Snapshot);
     void RedrawLine(unsigned int Line);
     void ClearAllLines(void);
 //    int AddAtCursorAndAdvance(const char *Str);
@@ -158,6 +161,7 @@ public:
 
     void SetXOffsetPx(int XOffsetPx);
     void SetMaxLines(int MaxLines,uint32_t BGColor);
+    void ScrollLines(int Count);
     void SetDisplaySize(int LeftEdge,int TopEdge,int Width,int Height);
     void SetDisplayBackgroundColor(uint32_t BgColor,bool DrawBackground);
 
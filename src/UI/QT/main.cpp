@@ -50,7 +50,7 @@ MainApp::MainApp(int & argc, char ** argv) : QApplication(argc,argv)
     App100msTimer=new QTimer(this);
     connect(App100msTimer, SIGNAL(timeout()), this, SLOT(App100msTimer_triggered()));
 
-    App100msTimer->start(100);              // We only provide .1 sec timeouts
+    App100msTimer->start(100);
 }
 
 MainApp::~MainApp()
@@ -60,9 +60,6 @@ MainApp::~MainApp()
 void MainApp::App100msTimer_triggered()
 {
     QTScrollLockHelperTick();
-
-    /* DEBUG PAUL: May want to provide an API to speed this up when a plugin requests a timeout below 100ms */
-    AppInformOf_FileTransTimerTick();
 }
 
 void MainApp::App1SecTimerTick()
@@ -56,8 +56,12 @@ enum e_CT_TextInput
     e_CT_TextInput_Stat_Bytes,
     e_CT_TextInput_Stat_SendErrors,
     e_CT_TextInput_Stat_SendBusyErrors,
-//    e_CT_TextInput_Stat_BytesPerSec,
+    e_CT_TextInput_Stat_BytesPerSec,
     e_CT_TextInput_Stat_RxErrors,
+    e_CT_TextInput_Stat_PacketsLost,
+    e_CT_TextInput_Stat_BitErrorRate,
+    e_CT_TextInput_Stat_ByteErrorRate,
+    e_CT_TextInput_Stat_Latency,
     e_CT_TextInputMAX
 };
 
@@ -99,6 +103,7 @@ typedef enum
 typedef enum
 {
     e_CT_Label_Status,
+    e_CT_Label_LatencyHistogram,
     e_CT_LabelMAX
 } e_CT_LabelType;
 
@@ -36,6 +36,9 @@
 /***  HEADER FILES TO INCLUDE          ***/
 #include "PluginSDK/DataProcessors.h"   // Include for the TXT_ATTRIB_ defines
 #include "App/Util/TextStyleHelpers.h"
+#include <memory>
+#include <string>
+#include <vector>
 
 /***  DEFINES                          ***/
 #define MAX_BYTES_PER_CHAR  32
@@ -67,6 +70,31 @@ struct TextCanvasFrag
     void *Data;
 };
 
+/* One run of the same type / style of text in a 'TextCanvasLine' */
+struct TextCanvasLineRun
+{
+    e_TextCanvasFragType FragType;
+    unsigned int Offset;        // Byte offset into 'TextCanvasLine.Text'
+    unsigned int Len;           // Number of bytes in 'TextCanvasLine.Text'
+    struct CharStyling Styling;
+    int Value;
+    void *Data;
+};
+
+/* A snapshot of a line ready for the canvas.  This is built once by the
+   display and then shared (never changed) with the canvas.  'Generation'
+   is different for every snapshot that was built so the canvas can tell if
+   it already has this line converted. */
+struct TextCanvasLine
+{
+    uint32_t Generation;
+    uint32_t BGColor;
+    std::string Text;           // The UTF-8 text for all the runs
+    std::vector<struct TextCanvasLineRun> Runs;
+};
+
+typedef std::shared_ptr<const struct TextCanvasLine> t_TextCanvasLineRef;
+
 enum e_TextCursorStyleType
 {
     e_TextCursorStyle_Block,
@@ -63,7 +63,9 @@ typedef enum
     e_UITD_ContextMenu_FindCRCAlgorithm,
     e_UITD_ContextMenu_SendToSendBuffer,
     e_UITD_ContextMenu_Copy,
+    e_UITD_ContextMenu_SaveSelection,
     e_UITD_ContextMenu_Paste,
+    e_UITD_ContextMenu_StopPaste,
     e_UITD_ContextMenu_ClearScreen,
     e_UITD_ContextMenu_ZoomIn,
     e_UITD_ContextMenu_ZoomOut,
@@ -317,8 +319,10 @@ void UITC_Begin(t_UITextDisplayColumn *Handle,int Line);
 void UITC_End(t_UITextDisplayColumn *Handle);
 void UITC_ClearLine(t_UITextDisplayColumn *Handle,uint32_t BGColor);
 void UITC_AddFragment(t_UITextDisplayColumn *Handle,const struct TextCanvasFrag *Frag);
+void UITC_SetLine(t_UITextDisplayColumn *Handle,int Line,t_TextCanvasLineRef Snapshot);
 void UITC_SetXOffset(t_UITextDisplayColumn *Handle,int XOffsetPx);
 void UITC_SetMaxLines(t_UITextDisplayColumn *Handle,int MaxLines,uint32_t BGColor);
+void UITC_ScrollLines(t_UITextDisplayColumn *Handle,int Lines);
 void UITC_RedrawScreen(t_UITextDisplayColumn *Handle);
 void UITC_SetDrawMask(t_UITextDisplayColumn *Handle,uint16_t Mask);
 